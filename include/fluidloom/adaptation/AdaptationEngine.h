@@ -4,6 +4,7 @@
 #include "fluidloom/adaptation/SplitEngine.h"
 #include "fluidloom/adaptation/MergeEngine.h"
 #include "fluidloom/adaptation/BalanceEnforcer.h"
+#include "fluidloom/core/fields/SOAFieldManager.h"
 #ifdef __APPLE__
 #include <OpenCL/cl.h>
 #else
@@ -11,6 +12,7 @@
 #endif
 #include <vector>
 #include <memory>
+#include <string>
 
 namespace fluidloom {
 namespace adaptation {
@@ -40,18 +42,46 @@ public:
     /**
      * @brief Execute the full adaptation cycle
      * 
+     * All phases are enqueued on the engine's queue behind wait_event.
+     * Balance, child and merge-group counts stay on the device until one
+     * blocking read of the count buffer, which yields the new cell count;
+     * children and parents are then generated straight into the rebuilt
+     * mesh, so compaction and field remapping need no further host
+     * synchronization.
+     * 
      * @param coord_x X coordinates buffer (in/out)
      * @param coord_y Y coordinates buffer (in/out)
      * @param coord_z Z coordinates buffer (in/out)
      * @param levels Refinement levels buffer (in/out)
      * @param cell_states Cell states buffer (in/out)
-     * @param refine_flags Refinement flags buffer (in/out)
+     * @param refine_flags Refinement flags buffer (in/out, cleared)
      * @param material_id Material IDs buffer (in/out)
      * @param num_cells Pointer to number of cells (in/out)
      * @param capacity Current buffer capacity (in/out)
-     * @param fields Optional: Field data buffers to remap
+     * @param fields Field buffers to remap (float, interleaved by component)
      * @param num_field_components Number of components per field
-     * @return cl_event Event signaling completion of the adaptation cycle
+     * @param wait_event Event the adaptation must wait for, or nullptr
+     * @return cl_event Marker completing after the last enqueued phase
+     */
+    cl_event adapt(
+        cl_mem* coord_x, cl_mem* coord_y, cl_mem* coord_z,
+        cl_mem* levels, cl_mem* cell_states,
+        cl_mem* refine_flags,
+        cl_mem* material_id,
+        size_t* num_cells,
+        size_t* capacity,
+        const std::vector<cl_mem*>& fields = {},
+        uint32_t num_field_components = 0,
+        cl_event wait_event = nullptr
+    );
+
+    /**
+     * @brief Execute the adaptation cycle, remapping fields of a SOAFieldManager
+     * 
+     * Each field is remapped as records of bytesPerCell() bytes. Merged
+     * parents of FLOAT32 fields use the field's FieldAveragingRuleRegistry
+     * rule; other types take the first sibling's value. Allocations smaller
+     * than the new mesh capacity are grown without preserving old contents.
      */
     cl_event adapt(
         cl_mem* coord_x, cl_mem* coord_y, cl_mem* coord_z,
@@ -60,10 +90,14 @@ public:
         cl_mem* material_id,
         size_t* num_cells,
         size_t* capacity,
-        cl_mem* fields = nullptr,
-        uint32_t num_field_components = 0
+        fields::SOAFieldManager& field_manager,
+        const std::vector<fields::FieldHandle>& fields,
+        cl_event wait_event = nullptr
     );
 
+    /// Children created plus parents created by the last adapt() (adaptation churn)
+    size_t getLastCellsChanged() const { return m_last_cells_changed; }
+
 private:
     cl_context m_context;
     cl_command_queue m_queue;
@@ -73,58 +107,83 @@ private:
     std::unique_ptr<SplitEngine> m_split_engine;
     std::unique_ptr<MergeEngine> m_merge_engine;
     std::unique_ptr<BalanceEnforcer> m_balance_enforcer;
+
+    size_t m_last_cells_changed = 0;
     
-    // Internal helpers
-    void resizeBuffers(
-        size_t new_capacity,
-        cl_mem* coord_x, cl_mem* coord_y, cl_mem* coord_z,
-        cl_mem* levels, cl_mem* cell_states,
-        cl_mem* refine_flags,
-        cl_mem* material_id,
-        cl_mem* fields,
-        uint32_t num_field_components
-    );
+    // A field buffer remapped onto the adapted cell list
+    struct FieldTarget {
+        std::string name;                // Selects the restriction rule
+        size_t record_bytes = 0;
+        uint32_t float_components = 0;   // 0 for fields restricted by first sibling
+        cl_mem source = nullptr;         // Pre-adaptation values
+        cl_mem* owned = nullptr;         // Caller-owned buffer, replaced on growth
+        fields::FieldHandle handle{0};   // Manager-owned buffer otherwise
+        cl_mem prolonged = nullptr;      // Children's values from the fused split (released after remap)
+    };
     
-    void compactAndRebuild(
-        const SplitResult& split_result,
-        const MergeResult& merge_result,
+    cl_event runAdaptation(
         cl_mem* coord_x, cl_mem* coord_y, cl_mem* coord_z,
         cl_mem* levels, cl_mem* cell_states,
         cl_mem* refine_flags,
         cl_mem* material_id,
         size_t* num_cells,
         size_t* capacity,
-        cl_mem* fields,
-        uint32_t num_field_components
+        std::vector<FieldTarget>& fields,
+        fields::SOAFieldManager* field_manager,
+        cl_event wait_event
     );
-
+    
+    void remapFields(
+        cl_mem valid_flags,
+        cl_mem scan_offsets,
+        size_t old_cells,
+        size_t num_survivors,
+        size_t num_children,
+        size_t num_parents,
+        size_t new_capacity,
+        std::vector<FieldTarget>& fields,
+        fields::SOAFieldManager* field_manager
+    );
+    
+    // Field remapping scratch, reused across fields and cycles
+    cl_mem m_field_scratch;
+    size_t m_field_scratch_bytes;
+    
+    // Device counts of one adaptation, read back together: the balance
+    // iterations' counts, then the slots below
+    enum CountSlot : size_t { COUNT_CHILDREN = 0, COUNT_PARENTS = 1, COUNT_SURVIVORS = 2, NUM_COUNT_SLOTS = 3 };
+    cl_mem m_counts;
+    size_t m_counts_size;
+    
     // GPU Compaction
     void compactAndRebuildGPU(
-        const SplitResult& split_res,
-        const MergeResult& merge_res,
+        cl_mem valid_flags,
+        cl_mem scan_offsets,
+        size_t num_survivors,
+        size_t num_children,
+        size_t num_parents,
         cl_mem* coord_x, cl_mem* coord_y, cl_mem* coord_z,
         cl_mem* levels, cl_mem* cell_states,
         cl_mem* refine_flags,
         cl_mem* material_id,
         size_t* num_cells,
         size_t* capacity,
-        cl_mem* fields,
-        uint32_t num_field_components
+        std::vector<FieldTarget>& fields,
+        fields::SOAFieldManager* field_manager
     );
 
     // Compaction Kernels
     cl_program m_compaction_program;
     cl_kernel m_kernel_mark_valid;
-    cl_kernel m_kernel_scan_local;
-    cl_kernel m_kernel_scan_add_sums;
     cl_kernel m_kernel_compact;
-    cl_kernel m_kernel_append;
+    cl_kernel m_kernel_compact_records;
+    cl_kernel m_kernel_gather_records;
     
     void compileCompactionKernels();
     std::string loadKernelSource(const std::string& filename);
     
-    // Helper for exclusive scan
-    void exclusiveScan(cl_mem input, cl_mem output, uint32_t num_elements, uint32_t* total_sum);
+    // Survivor flags → compacted write offsets
+    std::unique_ptr<scan::PrefixScan> m_scan;
 };
 
 } // namespace adaptation
@@ -6,8 +6,8 @@
 #else
 #include <CL/cl.h>
 #endif
-#include <unordered_set>
 #include <memory>
+#include <utility>
 #include <stdexcept>
 #include <string>
 #include "fluidloom/adaptation/CellDescriptor.h"
@@ -21,23 +21,26 @@ namespace adaptation {
 /**
  * @brief Result structure for cell splitting operation
  * 
- * Contains all metadata needed for subsequent rebuild and field interpolation.
- * All vectors are pre-allocated to avoid resize overhead.
+ * Returned by the standalone SplitEngine::split(). Children stay on the
+ * device in block order (8 per split parent, in parent order); the
+ * adaptation pipeline generates them straight into the rebuilt mesh instead.
  */
 struct SplitResult {
     bool success = false;
     size_t num_children = 0;
     size_t num_parents_split = 0;
     
-    // Child cell descriptors (8x split_count)
-    std::vector<CellDescriptor> children;
+    // Child cells (num_children entries each, device-resident)
+    cl_mem child_x = nullptr;
+    cl_mem child_y = nullptr;
+    cl_mem child_z = nullptr;
+    cl_mem child_level = nullptr;
+    cl_mem child_states = nullptr;
+    cl_mem child_material_id = nullptr;
     
-    // Mapping: parent index in old cell list → child block start index
-    // Size: old_cell_count, value = INVALID_INDEX if parent not split
-    std::vector<uint32_t> parent_to_child_map;
-    
-    // Indices of parents that were actually split (for validation)
-    std::vector<uint32_t> split_parent_indices;
+    // Prolonged field for new children (num_children * num_components floats,
+    // device-resident, nullptr unless split() was given parent fields)
+    cl_mem interpolated_fields = nullptr;
     
     // OpenCL event for synchronization
     cl_event event = nullptr;
@@ -45,7 +48,31 @@ struct SplitResult {
     // Memory usage statistics
     size_t device_memory_used = 0;  // Bytes allocated on device
     
+    SplitResult() = default;
+    SplitResult(const SplitResult&) = delete;
+    SplitResult& operator=(const SplitResult&) = delete;
+    SplitResult(SplitResult&& other) noexcept { *this = std::move(other); }
+    SplitResult& operator=(SplitResult&& other) noexcept {
+        std::swap(success, other.success);
+        std::swap(num_children, other.num_children);
+        std::swap(num_parents_split, other.num_parents_split);
+        std::swap(child_x, other.child_x);
+        std::swap(child_y, other.child_y);
+        std::swap(child_z, other.child_z);
+        std::swap(child_level, other.child_level);
+        std::swap(child_states, other.child_states);
+        std::swap(child_material_id, other.child_material_id);
+        std::swap(interpolated_fields, other.interpolated_fields);
+        std::swap(event, other.event);
+        std::swap(device_memory_used, other.device_memory_used);
+        return *this;
+    }
+    
     ~SplitResult() {
+        for (cl_mem buffer : {child_x, child_y, child_z, child_level, child_states,
+                              child_material_id, interpolated_fields}) {
+            if (buffer) clReleaseMemObject(buffer);
+        }
         if (event) clReleaseEvent(event);
     }
 };
@@ -53,25 +80,26 @@ struct SplitResult {
 /**
  * @brief Result structure for cell merging operation
  * 
- * Contains parent cells created by merging siblings and metadata for
- * field averaging and index mapping.
+ * Returned by the standalone MergeEngine::merge(). Parents stay on the
+ * device in group order; the adaptation pipeline creates them straight in
+ * the rebuilt mesh instead.
  */
 struct MergeResult {
     bool success = false;
     size_t num_parents_created = 0;
     size_t num_children_merged = 0;
     
-    // New parent cell descriptors
-    std::vector<CellDescriptor> parents;
-    
-    // Averaged fields for new parents (num_parents * num_components)
-    std::vector<float> averaged_fields;
+    // New parent cells (num_parents_created entries each, device-resident)
+    cl_mem parent_x = nullptr;
+    cl_mem parent_y = nullptr;
+    cl_mem parent_z = nullptr;
+    cl_mem parent_level = nullptr;
+    cl_mem parent_states = nullptr;
+    cl_mem parent_material_id = nullptr;
     
-    // Set of child indices that were merged (for exclusion from new cell list)
-    std::unordered_set<size_t> merged_child_indices;
-    
-    // Mapping: merge group ID → parent index in new cell list
-    std::vector<uint32_t> group_to_parent_map;
+    // Averaged fields for new parents (num_parents * num_components floats,
+    // device-resident, nullptr unless merge() was given child fields)
+    cl_mem averaged_fields = nullptr;
     
     // OpenCL event for synchronization
     cl_event event = nullptr;
@@ -81,7 +109,33 @@ struct MergeResult {
     double mass_after_merge = 0.0;
     double conservation_error = 0.0;
     
+    MergeResult() = default;
+    MergeResult(const MergeResult&) = delete;
+    MergeResult& operator=(const MergeResult&) = delete;
+    MergeResult(MergeResult&& other) noexcept { *this = std::move(other); }
+    MergeResult& operator=(MergeResult&& other) noexcept {
+        std::swap(success, other.success);
+        std::swap(num_parents_created, other.num_parents_created);
+        std::swap(num_children_merged, other.num_children_merged);
+        std::swap(parent_x, other.parent_x);
+        std::swap(parent_y, other.parent_y);
+        std::swap(parent_z, other.parent_z);
+        std::swap(parent_level, other.parent_level);
+        std::swap(parent_states, other.parent_states);
+        std::swap(parent_material_id, other.parent_material_id);
+        std::swap(averaged_fields, other.averaged_fields);
+        std::swap(event, other.event);
+        std::swap(mass_before_merge, other.mass_before_merge);
+        std::swap(mass_after_merge, other.mass_after_merge);
+        std::swap(conservation_error, other.conservation_error);
+        return *this;
+    }
+    
     ~MergeResult() {
+        for (cl_mem buffer : {parent_x, parent_y, parent_z, parent_level, parent_states,
+                              parent_material_id, averaged_fields}) {
+            if (buffer) clReleaseMemObject(buffer);
+        }
         if (event) clReleaseEvent(event);
     }
 };
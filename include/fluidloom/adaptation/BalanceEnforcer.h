@@ -36,6 +36,10 @@ public:
      * Iteratively detects violations and marks neighbors for refinement until convergence
      * or max iterations reached. Does NOT split cells, only updates flags.
      * 
+     * Every iteration is enqueued without blocking; an iteration whose
+     * predecessor converged or stalled exits on the device. Its violation and
+     * marked counts are left in balance_counts for summarize().
+     * 
      * @param coord_x X coordinates buffer
      * @param coord_y Y coordinates buffer
      * @param coord_z Z coordinates buffer
@@ -43,6 +47,18 @@ public:
      * @param cell_states Cell states buffer
      * @param refine_flags Refinement flags buffer (input/output)
      * @param num_cells Number of cells
+     * @param balance_counts At least numCounts() uints, overwritten from offset 0
+     */
+    void enforce(
+        cl_mem coord_x, cl_mem coord_y, cl_mem coord_z,
+        cl_mem levels, cl_mem cell_states,
+        cl_mem refine_flags,
+        size_t num_cells,
+        cl_mem balance_counts
+    );
+
+    /**
+     * @brief Standalone form: enforce, then read the counts back once (blocking)
      * @return BalanceResult with convergence stats
      */
     BalanceResult enforce(
@@ -52,6 +68,12 @@ public:
         size_t num_cells
     );
 
+    /// Counts enforce() writes: violations and cells marked per iteration
+    size_t numCounts() const { return 2 * static_cast<size_t>(m_config.max_balance_iterations); }
+
+    /// Convergence stats from the counts of an enforce() that has completed
+    BalanceResult summarize(const uint32_t* balance_counts) const;
+
 private:
     cl_context m_context;
     cl_command_queue m_queue;
@@ -62,6 +84,7 @@ private:
     cl_kernel m_kernel_detect_violations;
     cl_kernel m_kernel_mark_cascading;
     cl_kernel m_kernel_update_shadow_levels;
+    cl_kernel m_kernel_build_hash;
     
     // Internal helpers
     void compileKernels();
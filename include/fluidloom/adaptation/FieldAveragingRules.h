@@ -1,89 +1,180 @@
 #pragma once
 
-#include <functional>
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <stdexcept>
 
 namespace fluidloom {
 namespace adaptation {
 
+/**
+ * @brief Restriction rule applied when 8 siblings merge into a parent
+ *
+ * ARITHMETIC and VOLUME_WEIGHTED keep the `averaging_rule` codes of the
+ * merge_fields kernel.
+ */
+enum class RestrictionRule : uint32_t {
+    ARITHMETIC      = 0,  // Mean of children (intensive quantities)
+    VOLUME_WEIGHTED = 1,  // Sum of children (extensive quantities)
+    MASS_WEIGHTED   = 2,  // Σ ρ_k u_k / Σ ρ_k using a companion density field
+    LBM_EQ_NONEQ    = 3   // f_eq(ρ̄, ū) + rescaled mean non-equilibrium part
+};
+
+/**
+ * @brief Prolongation rule applied when a parent splits into 8 children
+ *
+ * Each child gets parent + slope · (±1/4) per axis, with limited slopes from
+ * the parent's same-level face neighbors (zero on a side without one). The
+ * offsets cancel over the 8 children, so restricting them with the field's
+ * ARITHMETIC or VOLUME_WEIGHTED rule returns the parent: conservative by
+ * construction. Codes match the prolongation_rule argument of split_cells.cl.
+ */
+enum class ProlongationRule : uint32_t {
+    INJECTION = 0,  // Parent value in every child (first order)
+    MINMOD    = 1,  // minmod(left, right) differences
+    MC        = 2   // Monotonized central: minmod(2·left, 2·right, centered)
+};
+
+/**
+ * @brief Lattice constants and relaxation time for LBM population restriction
+ *
+ * Restriction follows Dupuis & Chopard: the parent keeps the equilibrium of the
+ * conserved moments and the children's mean non-equilibrium part scaled by
+ * 2·τ_c/τ_f, where τ_c = 1/2 + (τ_f − 1/2)/2 for a refinement ratio of 2.
+ */
+struct LbmRestrictionParams {
+    static constexpr size_t MAX_POPULATIONS = 27;
+
+    std::vector<std::array<int8_t, 3>> velocities;
+    std::vector<float> weights;
+    float cs2 = 1.0f / 3.0f;
+    float tau_fine = 1.0f;  // Relaxation time at the child level
+
+    float tauCoarse() const { return 0.5f + 0.5f * (tau_fine - 0.5f); }
+    float nonEquilibriumScale() const { return 2.0f * tauCoarse() / tau_fine; }
+    void validate() const;
+};
+
+/**
+ * @brief A range of parents to restrict in one call
+ *
+ * Field data is interleaved (cell * num_components + component), as in the
+ * merge_fields kernel. `child_indices` holds 8 entries per parent, parent-major,
+ * ordered by child octant.
+ */
+struct RestrictionBatch {
+    const uint32_t* child_indices = nullptr;
+    size_t parent_begin = 0;
+    size_t parent_end = 0;
+    const float* child_data = nullptr;
+    float* parent_data = nullptr;
+    uint32_t num_components = 1;
+    const float* child_density = nullptr;  // MASS_WEIGHTED only (1 component)
+};
+
+/**
+ * @brief A range of split parents to prolong in one call
+ *
+ * `child_block_start` is the first child index of each parent (INVALID_INDEX
+ * if it did not split) and `parent_neighbors` holds the parent's 6 same-level
+ * face neighbors (-x, +x, -y, +y, -z, +z; INVALID_INDEX where absent) at
+ * child_block_start / 8, as written by split_generate_children. Neighbors are
+ * only read for slope-limited rules.
+ */
+struct ProlongationBatch {
+    const uint32_t* child_block_start = nullptr;
+    const uint32_t* parent_neighbors = nullptr;
+    size_t parent_begin = 0;
+    size_t parent_end = 0;
+    const float* parent_data = nullptr;
+    float* child_data = nullptr;
+    uint32_t num_components = 1;
+};
+
 /**
  * @brief Registry for field-specific averaging rules during merge operations
- * 
+ *
  * Different fields require different averaging strategies:
  * - Density, mass: volume-weighted sum
- * - Velocity, momentum: arithmetic mean
- * - LBM populations: custom (equilibrium-preserving)
+ * - Velocity, momentum: arithmetic mean, or mass-weighted with a density field
+ * - LBM populations: equilibrium-preserving (LBM_EQ_NONEQ)
+ *
+ * Rules are applied to whole parent ranges: apply() dispatches once per
+ * batch into loops specialized on rule and component count, so the compiler can
+ * unroll the 8-child gather and vectorize across components. The same rules are
+ * emitted as OpenCL kernels (one per field) by generateDeviceSource() for the
+ * GPU merge path.
+ *
+ * Each field also carries the ProlongationRule used when its cells split.
+ * Slope-limited prolongation is only allowed with the linear restriction
+ * rules, whose inverse it is.
  */
 class FieldAveragingRuleRegistry {
 public:
-    // Averaging function signature: (parent_index, child_indices[8], field_data) → parent_value
-    using AveragingFunc = std::function<void(size_t, const size_t*, const float*, float&)>;
-    
+    struct RuleEntry {
+        RestrictionRule rule = RestrictionRule::ARITHMETIC;
+        std::string density_field;   // MASS_WEIGHTED
+        LbmRestrictionParams lbm;    // LBM_EQ_NONEQ
+        ProlongationRule prolongation = ProlongationRule::INJECTION;
+    };
+
     static FieldAveragingRuleRegistry& getInstance() {
         static FieldAveragingRuleRegistry instance;
         return instance;
     }
-    
+
     // Register a field's averaging rule by name
-    void registerRule(const std::string& field_name, const std::string& rule_type) {
-        if (rule_type == "arithmetic") {
-            rules_[field_name] = [](size_t parent_idx, const size_t* child_indices, 
-                                   const float* field_data, float& result) {
-                (void)parent_idx;
-                // Simple arithmetic mean of 8 children
-                float sum = 0.0f;
-                for (int i = 0; i < 8; ++i) {
-                    sum += field_data[child_indices[i]];
-                }
-                result = sum * 0.125f;
-            };
-        } else if (rule_type == "volume_weighted") {
-            rules_[field_name] = [](size_t parent_idx, const size_t* child_indices,
-                                   const float* field_data, float& result) {
-                (void)parent_idx;
-                // Volume-weighted sum (child volume = parent volume / 8)
-                float sum = 0.0f;
-                for (int i = 0; i < 8; ++i) {
-                    sum += field_data[child_indices[i]];
-                }
-                result = sum;  // Sum of children = parent (conservation)
-            };
-        } else {
-            throw std::invalid_argument("Unknown averaging rule: " + rule_type);
-        }
-        
-        rule_types_[field_name] = rule_type;
-    }
-    
-    // Get averaging function for a field
-    AveragingFunc getRule(const std::string& field_name) const {
-        auto it = rules_.find(field_name);
-        if (it == rules_.end()) {
-            // Default to arithmetic if not specified
-            return [](size_t parent_idx, const size_t* child_indices,
-                     const float* field_data, float& result) {
-                (void)parent_idx;
-                float sum = 0.0f;
-                for (int i = 0; i < 8; ++i) {
-                    sum += field_data[child_indices[i]];
-                }
-                result = sum * 0.125f;
-            };
-        }
-        return it->second;
-    }
-    
-    std::string getRuleType(const std::string& field_name) const {
-        auto it = rule_types_.find(field_name);
-        return (it != rule_types_.end()) ? it->second : "arithmetic";
-    }
-    
+    // ("arithmetic", "volume_weighted"; the others need parameters)
+    void registerRule(const std::string& field_name, const std::string& rule_type);
+    void registerRule(const std::string& field_name, RestrictionRule rule);
+    void registerMassWeightedRule(const std::string& field_name, const std::string& density_field);
+    void registerLbmRule(const std::string& field_name, const LbmRestrictionParams& params);
+
+    // Prolongation on split ("injection", "minmod", "mc"); kept when the
+    // restriction rule is registered again
+    void registerProlongation(const std::string& field_name, const std::string& rule_type);
+    void registerProlongation(const std::string& field_name, ProlongationRule rule);
+
+    // Get averaging rule for a field (arithmetic if not specified)
+    const RuleEntry& getRule(const std::string& field_name) const;
+    std::string getRuleType(const std::string& field_name) const;
+
+    void clear() { rules_.clear(); }
+
+    // Whether any field needs the parents' face neighbors when cells split
+    bool hasSlopeProlongation() const;
+
+    // Whether splitting changes the field's values beyond copying the parent
+    bool needsProlongation(const std::string& field_name) const;
+
+    // Restrict a batch of parents with the field's rule
+    void apply(const std::string& field_name, const RestrictionBatch& batch) const;
+    static void apply(const RuleEntry& entry, const RestrictionBatch& batch);
+
+    // Prolong a batch of split parents with the field's rule
+    void prolong(const std::string& field_name, const ProlongationBatch& batch) const;
+    static void prolong(const RuleEntry& entry, const ProlongationBatch& batch);
+
+    // Factor applied to prolonged values: 1/8 for VOLUME_WEIGHTED fields, whose
+    // children must sum to the parent, else 1
+    static float prolongationScale(RestrictionRule rule);
+
+    // OpenCL kernel restricting `field_name`, named by deviceKernelName():
+    //   (group_children, child_field, parent_field, [child_density,] num_parents)
+    std::string generateDeviceSource(const std::string& field_name, uint32_t num_components) const;
+    static std::string deviceKernelName(const std::string& field_name);
+
+    static const char* ruleName(RestrictionRule rule);
+    static const char* prolongationName(ProlongationRule rule);
+
 private:
     FieldAveragingRuleRegistry() = default;
-    std::unordered_map<std::string, AveragingFunc> rules_;
-    std::unordered_map<std::string, std::string> rule_types_;
+    void storeRule(const std::string& field_name, RuleEntry entry, bool keep_prolongation);
+    std::unordered_map<std::string, RuleEntry> rules_;
 };
 
 } // namespace adaptation
@@ -1,13 +1,16 @@
 #pragma once
 
 #include "fluidloom/adaptation/AdaptationTypes.h"
+#include "fluidloom/core/scan/PrefixScan.h"
 #ifdef __APPLE__
 #include <OpenCL/cl.h>
 #else
 #include <CL/cl.h>
 #endif
+#include <memory>
 #include <vector>
 #include <string>
+#include <unordered_map>
 
 namespace fluidloom {
 namespace adaptation {
@@ -34,7 +37,61 @@ public:
     ~MergeEngine();
 
     /**
-     * @brief Execute the merge operation
+     * @brief Phase 1: find complete sibling groups and number them
+     * 
+     * Enqueued without blocking. The group count is written to
+     * total_buffer[total_index] on the device and is the num_groups that
+     * buildParents() expects once the caller has read it back.
+     * 
+     * @param child_x Child X coordinates buffer
+     * @param child_y Child Y coordinates buffer
+     * @param child_z Child Z coordinates buffer
+     * @param child_level Child refinement levels buffer
+     * @param child_states Child cell states buffer
+     * @param refine_flags Refinement flags buffer (-1 means merge)
+     * @param num_children Number of child cells
+     * @param total_buffer uint buffer receiving the group count
+     * @param total_index Slot of the group count in total_buffer
+     */
+    void findGroups(
+        cl_mem child_x, cl_mem child_y, cl_mem child_z,
+        cl_mem child_level, cl_mem child_states,
+        cl_mem refine_flags,
+        size_t num_children,
+        cl_mem total_buffer, size_t total_index
+    );
+
+    /// Per child of the last findGroups(): INVALID_INDEX unless it merges
+    cl_mem getGroupIds() const { return m_merge_group_id; }
+
+    /**
+     * @brief Phase 2: create the parents of the last findGroups()
+     * 
+     * Parent k is written to slot dst_offset + k of the dst buffers, which
+     * must hold at least dst_offset + num_groups cells. Enqueued without
+     * blocking.
+     * 
+     * @param child_x..child_material_id Child cells passed to findGroups()
+     * @param num_groups Group count from findGroups()
+     * @param dst_x..dst_material_id Parent cell buffers
+     * @param dst_offset First parent slot
+     */
+    void buildParents(
+        cl_mem child_x, cl_mem child_y, cl_mem child_z,
+        cl_mem child_level, cl_mem child_states,
+        cl_mem child_material_id,
+        size_t num_groups,
+        cl_mem dst_x, cl_mem dst_y, cl_mem dst_z,
+        cl_mem dst_level, cl_mem dst_states,
+        cl_mem dst_material_id,
+        size_t dst_offset
+    );
+
+    /**
+     * @brief Execute the merge operation standalone
+     * 
+     * Both phases into new parent buffers; reads the group count back once
+     * (blocking) to size them.
      * 
      * @param child_x Child X coordinates buffer
      * @param child_y Child Y coordinates buffer
@@ -46,7 +103,10 @@ public:
      * @param num_children Number of child cells
      * @param child_fields Optional: Child field data for averaging
      * @param num_field_components Number of components per field
-     * @return MergeResult containing new parents and mapping
+     * @param field_name Selects the restriction of child_fields in FieldAveragingRuleRegistry
+     *        (empty: the configured default_averaging_rule)
+     * @param child_density Child density (required by mass-weighted rules)
+     * @return MergeResult holding the device-resident parents
      */
     MergeResult merge(
         cl_mem child_x, cl_mem child_y, cl_mem child_z,
@@ -55,9 +115,35 @@ public:
         cl_mem child_material_id,
         size_t num_children,
         cl_mem child_fields = nullptr,
-        uint32_t num_field_components = 0
+        uint32_t num_field_components = 0,
+        const std::string& field_name = "",
+        cl_mem child_density = nullptr
+    );
+
+    /**
+     * @brief Restrict one named field onto the parents of the last buildParents()
+     *
+     * Uses the field's rule from FieldAveragingRuleRegistry, compiled once per
+     * (field, component count) into a gather kernel over the sibling table.
+     * Enqueued on the engine's queue without blocking.
+     *
+     * @param field_name Registry key selecting the rule
+     * @param child_field Child values, interleaved by component
+     * @param num_components Components per cell
+     * @param child_density Child density (required by mass-weighted rules)
+     * @return New buffer with num_parents * num_components floats (caller releases),
+     *         or nullptr if the last merge created no parents
+     */
+    cl_mem restrictField(
+        const std::string& field_name,
+        cl_mem child_field,
+        uint32_t num_components,
+        cl_mem child_density = nullptr
     );
 
+    /// Sibling table of the last buildParents() (group_id*8 + octant -> child index), or nullptr
+    cl_mem getSiblingTable() const { return m_num_groups ? m_group_children : nullptr; }
+
 private:
     cl_context m_context;
     cl_command_queue m_queue;
@@ -66,11 +152,16 @@ private:
     
     // Kernels
     cl_kernel m_kernel_mark_siblings;
+    cl_kernel m_kernel_assign_groups;
     cl_kernel m_kernel_merge_fields;
     cl_kernel m_kernel_create_parents;
+    cl_kernel m_kernel_build_hash;
+    
+    std::unique_ptr<scan::PrefixScan> m_scan;  // Group flags → group IDs in cell order
     
     // Internal helpers
     void compileKernels();
+    cl_program buildProgram(const std::string& source, const std::string& what);
     void releaseResources();
     std::string loadKernelSource(const std::string& filename);
     
@@ -78,6 +169,22 @@ private:
     cl_mem m_hash_table;
     size_t m_hash_table_size;
     void buildHashTable(cl_mem x, cl_mem y, cl_mem z, size_t num_cells);
+
+    // Last findGroups(): group ID per member (INVALID_INDEX otherwise) and
+    // the sibling table, group_id*8 + octant -> child index. The table is
+    // sized for num_children / 8 groups, so it is filled before the group
+    // count reaches the host.
+    cl_mem m_merge_group_id;
+    cl_mem m_group_children;
+    uint32_t m_num_children;
+    uint32_t m_num_groups;  // Set by buildParents()
+
+    // Generated restriction kernels, keyed by "field:components"
+    struct RestrictKernel {
+        cl_program program = nullptr;
+        cl_kernel kernel = nullptr;
+    };
+    std::unordered_map<std::string, RestrictKernel> m_restrict_kernels;
 };
 
 } // namespace adaptation
@@ -1,11 +1,13 @@
 #pragma once
 
 #include "fluidloom/adaptation/AdaptationTypes.h"
+#include "fluidloom/core/scan/PrefixScan.h"
 #ifdef __APPLE__
 #include <OpenCL/cl.h>
 #else
 #include <CL/cl.h>
 #endif
+#include <memory>
 #include <vector>
 #include <string>
 
@@ -17,9 +19,9 @@ namespace adaptation {
  * 
  * Responsibilities:
  * 1. Identify cells marked for refinement
- * 2. Calculate memory requirements for children (prefix sum)
+ * 2. Calculate memory requirements for children (device prefix scan)
  * 3. Allocate and generate child cells
- * 4. Interpolate fields from parents to children
+ * 4. Prolong fields from parents to children, fused with child generation
  */
 class SplitEngine {
 public:
@@ -34,7 +36,72 @@ public:
     ~SplitEngine();
 
     /**
-     * @brief Execute the split operation
+     * @brief Phase 1: count children and lay out their blocks
+     * 
+     * Enqueued without blocking. The child total is written to
+     * total_buffer[total_index] on the device and is the num_children that
+     * generateChildren() expects once the caller has read it back.
+     * 
+     * @param parent_level Parent refinement levels buffer
+     * @param refine_flags Refinement flags buffer (>0 means split)
+     * @param parent_states Parent cell states buffer (FLUID, BOUNDARY, etc.)
+     * @param num_parents Number of parent cells
+     * @param total_buffer uint buffer receiving the child total
+     * @param total_index Slot of the child total in total_buffer
+     */
+    void countChildren(
+        cl_mem parent_level, cl_mem refine_flags, cl_mem parent_states,
+        size_t num_parents,
+        cl_mem total_buffer, size_t total_index
+    );
+
+    /// Children (8 or 0) of each parent of the last countChildren(), on the device
+    cl_mem getChildCounts() const { return m_child_counts; }
+
+    /**
+     * @brief Phase 2: generate the children of the last countChildren()
+     * 
+     * Child k is written to slot dst_offset + k of the dst buffers, which
+     * must hold at least dst_offset + num_children cells. Enqueued without
+     * blocking.
+     * 
+     * @param parent_x Parent X coordinates buffer
+     * @param parent_y Parent Y coordinates buffer
+     * @param parent_z Parent Z coordinates buffer
+     * @param parent_level Parent refinement levels buffer
+     * @param parent_states Parent cell states buffer
+     * @param parent_material_id Parent material IDs buffer
+     * @param num_children Child total from countChildren()
+     * @param dst_x..dst_material_id Child cell buffers
+     * @param dst_offset First child slot
+     * @param parent_fields Optional: parent values prolonged by the same kernel
+     * @param num_field_components Number of components per field (e.g. 1 for scalar, 3 for vector)
+     * @param field_name Selects the prolongation of parent_fields in FieldAveragingRuleRegistry
+     * @return New buffer with num_children * num_components prolonged floats
+     *         in child order (caller releases), or nullptr without parent_fields
+     */
+    cl_mem generateChildren(
+        cl_mem parent_x, cl_mem parent_y, cl_mem parent_z,
+        cl_mem parent_level, cl_mem parent_states,
+        cl_mem parent_material_id,
+        size_t num_children,
+        cl_mem dst_x, cl_mem dst_y, cl_mem dst_z,
+        cl_mem dst_level, cl_mem dst_states,
+        cl_mem dst_material_id,
+        size_t dst_offset,
+        cl_mem parent_fields = nullptr,
+        uint32_t num_field_components = 0,
+        const std::string& field_name = ""
+    );
+
+    /// Old parent index of every child of the last generateChildren(), or nullptr
+    cl_mem getChildParents() const { return m_num_children ? m_child_parent : nullptr; }
+
+    /**
+     * @brief Execute the split operation standalone
+     * 
+     * Both phases into new child buffers; reads the child total back once
+     * (blocking) to size them.
      * 
      * @param parent_x Parent X coordinates buffer
      * @param parent_y Parent Y coordinates buffer
@@ -44,9 +111,11 @@ public:
      * @param refine_flags Refinement flags buffer (>0 means split)
      * @param parent_material_id Parent material IDs buffer
      * @param num_parents Number of parent cells
-     * @param parent_fields Optional: Parent field data for interpolation
+     * @param parent_fields Optional: parent values prolonged by the child generation
+     *        kernel into SplitResult::interpolated_fields (left on the device)
      * @param num_field_components Number of components per field (e.g. 1 for scalar, 3 for vector)
-     * @return SplitResult containing new children and mapping
+     * @param field_name Selects the prolongation of parent_fields in FieldAveragingRuleRegistry
+     * @return SplitResult holding the device-resident children
      */
     SplitResult split(
         cl_mem parent_x, cl_mem parent_y, cl_mem parent_z,
@@ -55,7 +124,27 @@ public:
         cl_mem parent_material_id,
         size_t num_parents,
         cl_mem parent_fields = nullptr,
-        uint32_t num_field_components = 0
+        uint32_t num_field_components = 0,
+        const std::string& field_name = ""
+    );
+
+    /**
+     * @brief Prolong one named field onto the children of the last generateChildren()
+     *
+     * Uses the field's prolongation from FieldAveragingRuleRegistry with the
+     * parent neighbors found during generation, which only looks them up when
+     * some field has a slope-limited rule. Enqueued without blocking.
+     *
+     * @param field_name Registry key selecting the rule
+     * @param parent_field Pre-split values of all parents, interleaved by component
+     * @param num_field_components Components per cell
+     * @return New buffer with num_children * num_components floats in child
+     *         order (caller releases), or nullptr if the last split made no children
+     */
+    cl_mem prolongField(
+        const std::string& field_name,
+        cl_mem parent_field,
+        uint32_t num_field_components
     );
 
 private:
@@ -65,9 +154,12 @@ private:
     cl_program m_program;
     
     // Kernels
-    cl_kernel m_kernel_count_allocate;
+    cl_kernel m_kernel_count_children;
     cl_kernel m_kernel_generate_children;
-    cl_kernel m_kernel_interpolate;
+    cl_kernel m_kernel_prolong;
+    cl_kernel m_kernel_build_hash;
+    
+    std::unique_ptr<scan::PrefixScan> m_scan;  // Child counts → child block offsets
     
     // Internal helpers
     void compileKernels();
@@ -75,6 +167,21 @@ private:
     
     // Helper to load kernel source
     std::string loadKernelSource(const std::string& filename);
+    
+    // Hash table for parent neighbor lookup
+    cl_mem m_hash_table;
+    size_t m_hash_table_size;
+    void buildHashTable(cl_mem x, cl_mem y, cl_mem z, size_t num_cells);
+    
+    // Last split: children per parent, parent -> first child (INVALID_INDEX
+    // if not split), child -> parent, and the 6 face neighbors of each split
+    // parent (nullptr unless slopes are needed)
+    cl_mem m_child_counts;
+    cl_mem m_child_block_start;
+    cl_mem m_child_parent;
+    cl_mem m_parent_neighbors;
+    uint32_t m_num_parents;
+    uint32_t m_num_children;
 };
 
 } // namespace adaptation
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace fluidloom {
+
+/**
+ * @brief Dense integer ID of an interned identifier
+ *
+ * IDs are assigned in first-seen order starting at 1, so registries can
+ * index plain vectors by ID. 0 is never a valid ID.
+ */
+using SymbolId = uint32_t;
+constexpr SymbolId INVALID_SYMBOL = 0;
+
+/**
+ * @brief Process-wide identifier interner
+ *
+ * The parser front end interns every identifier once; symbol tables and the
+ * field/constant registries are then keyed by SymbolId instead of hashing
+ * and comparing strings on every lookup. Strings are never removed, so names
+ * returned by name() stay valid for the lifetime of the process.
+ */
+class StringInterner {
+public:
+    static StringInterner& instance();
+
+    StringInterner(const StringInterner&) = delete;
+    StringInterner& operator=(const StringInterner&) = delete;
+
+    // ID of `text`, assigning the next free ID if it has not been seen
+    SymbolId intern(std::string_view text);
+
+    // ID of `text` if already interned, INVALID_SYMBOL otherwise (never inserts)
+    SymbolId find(std::string_view text) const;
+
+    // Text of an interned ID; empty for INVALID_SYMBOL or unknown IDs
+    const std::string& name(SymbolId id) const;
+
+    // Number of interned strings; valid IDs are [1, size()]
+    size_t size() const;
+
+private:
+    StringInterner() = default;
+
+    mutable std::shared_mutex mutex_;
+    std::deque<std::string> names_;  // names_[id - 1]; deque keeps references stable
+    std::unordered_map<std::string_view, SymbolId> ids_;  // views into names_
+};
+
+// Shorthand for StringInterner::instance().intern(text)
+inline SymbolId intern(std::string_view text) {
+    return StringInterner::instance().intern(text);
+}
+
+} // namespace fluidloom
@@ -5,6 +5,7 @@
 #include <string>
 #include <cstring>
 #include <cstddef>
+#include <cstdint>
 
 namespace fluidloom {
 
@@ -40,6 +41,15 @@ public:
     virtual void copyDeviceToHost(const DeviceBuffer& device_src, void* host_dst, size_t size) = 0;
     virtual void copyDeviceToDevice(const DeviceBuffer& src, DeviceBuffer& dst, size_t size) = 0;
 
+    /**
+     * @brief Copy host data into a sub-range of a device buffer
+     *
+     * The default stages the whole buffer through the host; backends that can
+     * write at an offset directly (OpenCL, Mock) override it.
+     */
+    virtual void copyHostToDeviceOffset(const void* host_src, DeviceBuffer& device_dst,
+                                        size_t dst_offset, size_t size);
+
     // --- Synchronization ---
     virtual void flush() = 0;
     virtual void finish() = 0;
@@ -131,4 +141,16 @@ protected:
     DeviceBuffer() = default;
 };
 
+inline void IBackend::copyHostToDeviceOffset(const void* host_src, DeviceBuffer& device_dst,
+                                             size_t dst_offset, size_t size) {
+    if (dst_offset == 0) {
+        copyHostToDevice(host_src, device_dst, size);
+        return;
+    }
+    std::vector<uint8_t> staging(device_dst.getSize());
+    copyDeviceToHost(device_dst, staging.data(), staging.size());
+    std::memcpy(staging.data() + dst_offset, host_src, size);
+    copyHostToDevice(staging.data(), device_dst, staging.size());
+}
+
 } // namespace fluidloom
@@ -38,6 +38,8 @@ public:
     void copyHostToDevice(const void* host_src, DeviceBuffer& device_dst, size_t size) override;
     void copyDeviceToHost(const DeviceBuffer& device_src, void* host_dst, size_t size) override;
     void copyDeviceToDevice(const DeviceBuffer& src, DeviceBuffer& dst, size_t size) override;
+    void copyHostToDeviceOffset(const void* host_src, DeviceBuffer& device_dst,
+                                size_t dst_offset, size_t size) override;
 
     void flush() override {}  // No-op
     void finish() override {}  // No-op
@@ -49,6 +49,8 @@ public:
     void copyHostToDevice(const void* host_src, DeviceBuffer& device_dst, size_t size) override;
     void copyDeviceToHost(const DeviceBuffer& device_src, void* host_dst, size_t size) override;
     void copyDeviceToDevice(const DeviceBuffer& src, DeviceBuffer& dst, size_t size) override;
+    void copyHostToDeviceOffset(const void* host_src, DeviceBuffer& device_dst,
+                                size_t dst_offset, size_t size) override;
 
     void flush() override;
     void finish() override;
@@ -77,6 +79,7 @@ public:
     cl_context getContext() const { return m_context; }
     cl_command_queue getQueue() const { return m_queue; }
     cl_device_id getDevice() const { return m_device; }
+    const std::vector<cl_device_id>& getDevices() const { return m_all_devices; }
 
 private:
     bool m_initialized;
@@ -56,6 +56,9 @@ struct alignas(64) FieldDescriptor {
     bool is_visualization_field{false};
     bool is_mask{false};
     bool is_material{false};
+    // Value only lives within a step (scratch); may share storage with
+    // other transient fields whose lifetimes do not overlap
+    bool is_transient{false};
     // GPU state (populated at allocation time)
     struct {
         uint64_t version{0};
@@ -25,8 +25,13 @@ public:
     // Allocate field for N cells
     FieldHandle allocate(const FieldDescriptor& desc, size_t num_cells);
     
-    // Resize existing field (preserves data up to min(old, new))
-    void resize(FieldHandle handle, size_t new_num_cells);
+    // Allocate fields that share one buffer sized for the largest of them.
+    // Only valid for transient fields whose lifetimes never overlap.
+    std::vector<FieldHandle> allocateAliased(const std::vector<FieldDescriptor>& descs, size_t num_cells);
+    
+    // Resize existing field (preserves data up to min(old, new) unless
+    // preserve is false); aliased fields are resized together
+    void resize(FieldHandle handle, size_t new_num_cells, bool preserve = true);
     
     // Deallocate field
     void deallocate(FieldHandle handle);
@@ -37,6 +42,9 @@ public:
     // Get descriptor
     const FieldDescriptor& getDescriptor(FieldHandle handle) const;
     
+    // Handles of all allocated fields
+    std::vector<FieldHandle> getHandles() const;
+    
     // Get allocation size
     size_t getAllocationSize(FieldHandle handle) const;
     
@@ -46,7 +54,10 @@ public:
     bool isDirty(FieldHandle handle) const;
     uint64_t getVersion(FieldHandle handle) const;
     
-    // Memory usage
+    // True if both fields live in the same physical buffer
+    bool sharesStorage(FieldHandle a, FieldHandle b) const;
+    
+    // Memory usage (shared buffers counted once)
     size_t getTotalMemoryUsage() const;
     size_t getMemoryUsage(FieldHandle handle) const;
     
@@ -55,7 +66,7 @@ private:
         FieldDescriptor descriptor;
         size_t num_cells{0};
         std::vector<void*> device_ptrs;  // One per component
-        DeviceBufferPtr device_buffer;
+        std::shared_ptr<DeviceBuffer> device_buffer;  // Shared by aliased fields
         uint64_t version{1};  // Start at 1
         size_t pitch{0};  // Bytes between components (SOA stride)
     };
@@ -67,6 +78,9 @@ private:
     // Helper: compute aligned size
     static size_t computeAlignedSize(size_t bytes_per_cell, size_t num_cells);
     
+    // Helper: point component pointers at the current buffer
+    static void updateComponentPointers(FieldState& state);
+    
     // Helper: validate and get field state
     FieldState& getFieldState(FieldHandle handle);
     const FieldState& getFieldState(FieldHandle handle) const;
@@ -9,6 +9,10 @@ namespace hashmap {
 // Empty marker: MUST match HILBERT_EMPTY from Module 2
 static constexpr uint64_t HASH_EMPTY_KEY = 0xFFFFFFFFFFFFFFFFULL;
 
+// Deleted-slot marker: MUST match HILBERT_INVALID from Module 2.
+// Probes continue past tombstones; inserts may reuse them.
+static constexpr uint64_t HASH_TOMBSTONE_KEY = 0xFFFFFFFFFFFFFFFEULL;
+
 // Invalid index marker for queries
 static constexpr uint32_t HASH_INVALID_VALUE = 0xFFFFFFFFU;
 
@@ -58,6 +62,8 @@ struct HashTableMetadata {
     uint32_t build_time_ms;     // Last rebuild duration
     float average_probe_count;  // From last validation pass
     uint32_t max_probe_count;   // Worst-case probe count
+    size_t num_tombstones;      // Deleted slots since last full rebuild
+    size_t last_delta_slots;    // Slots uploaded by the last incremental update
 };
 
 // Probe strategy configuration
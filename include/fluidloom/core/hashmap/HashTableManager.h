@@ -13,7 +13,9 @@ namespace hashmap {
  * @brief Manages hash table lifecycle and rebuilds
  * 
  * Orchestrates CPU-side operations for building and maintaining
- * the GPU-resident hash table.
+ * the GPU-resident hash table. Tables are built in a host mirror and
+ * uploaded, so incremental updates can patch the mirror and upload only
+ * the touched slots.
  */
 class HashTableManager {
 public:
@@ -34,6 +36,23 @@ public:
     double rebuild(const std::vector<uint64_t>& hilbert_indices,
                    const std::vector<uint32_t>& array_indices);
     
+    /**
+     * @brief Apply an incremental update after cells moved between GPUs
+     * 
+     * Deletes leave tombstones so existing probe chains stay intact; upserts
+     * insert new keys or overwrite the value of keys whose SOA index changed.
+     * Only the touched slots are uploaded. Falls back to a full rebuild when
+     * the table would exceed its load factor or tombstones pile up.
+     * 
+     * @param removed_keys Hilbert indices no longer owned by this GPU
+     * @param upsert_keys Hilbert indices inserted or relocated
+     * @param upsert_values New SOA array indices for upsert_keys
+     * @return Update time in milliseconds
+     */
+    double applyDelta(const std::vector<uint64_t>& removed_keys,
+                      const std::vector<uint64_t>& upsert_keys,
+                      const std::vector<uint32_t>& upsert_values);
+    
     /**
      * @brief Query hash table (CPU-side batch query for testing)
      * 
@@ -67,14 +86,18 @@ private:
     DeviceBufferPtr table_keys_;
     DeviceBufferPtr table_values_;
     
-    // Kernels (placeholders for future implementation)
-    void* hash_build_kernel_;
+    // Host mirror of the device table (source for incremental uploads)
+    std::vector<uint64_t> host_keys_;
+    std::vector<uint32_t> host_values_;
     
     // Helpers
-    void ensureKernelsCompiled();
     void allocateTable(size_t num_cells);
     void clearTable();
     uint64_t computeCapacity(size_t num_cells);
+    bool insertHost(uint64_t key, uint32_t value, uint64_t* slot_out);
+    bool eraseHost(uint64_t key, uint64_t* slot_out);
+    uint32_t findHost(uint64_t key) const;
+    void uploadSlots(std::vector<uint64_t>& slots);
 };
 
 } // namespace hashmap
@@ -1,9 +1,14 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <array>
 
 namespace fluidloom {
+
+class IBackend;
+class DeviceBuffer;
+
 namespace hilbert {
 
 // Maximum refinement level - DO NOT CHANGE
@@ -67,5 +72,58 @@ HilbertIndex getChild(HilbertIndex hilbert, uint8_t level, uint8_t quadrant);
  */
 bool isValid(HilbertIndex hilbert, uint8_t level);
 
+/**
+ * @brief Encode a batch of cells on the host
+ *
+ * Reference for the device path and fallback for small batches.
+ *
+ * @param levels Per-cell levels, or nullptr to encode every cell at `level`
+ */
+void encodeBatch(const int32_t* x, const int32_t* y, const int32_t* z,
+                 const uint8_t* levels, HilbertIndex* keys_out, size_t n,
+                 uint8_t level = MAX_REFINEMENT_LEVEL);
+
+/**
+ * @brief Device-side batch encoder running kernels/hilbert.cl
+ *
+ * Produces exactly the keys of encode() without moving coordinates to the host.
+ * Kernels are compiled once per encoder; keep one around on hot paths. Buffer
+ * arguments are device handles as returned by DeviceBuffer::getDevicePointer()
+ * (cl_mem on OpenCL). Launches are enqueued on the backend's queue and are not
+ * waited for. The mock backend, which cannot run kernels, encodes on the host.
+ */
+class DeviceEncoder {
+public:
+    explicit DeviceEncoder(IBackend& backend);
+    ~DeviceEncoder();
+
+    DeviceEncoder(const DeviceEncoder&) = delete;
+    DeviceEncoder& operator=(const DeviceEncoder&) = delete;
+
+    // coords: n packed cl_int3 (16 bytes each); levels: n uint8 or nullptr
+    void encode(const DeviceBuffer& coords, const DeviceBuffer* levels,
+                DeviceBuffer& keys_out, size_t n, uint8_t level = MAX_REFINEMENT_LEVEL);
+
+    // Separate x/y/z int32 buffers, as kept by the adaptation engine
+    void encodeSoA(const void* coord_x, const void* coord_y, const void* coord_z,
+                   const void* levels, void* keys_out, size_t n,
+                   uint8_t level = MAX_REFINEMENT_LEVEL);
+
+private:
+    IBackend& backend;
+    void* batch_kernel;      // IBackend::KernelHandle payloads (null on mock)
+    void* batch_soa_kernel;
+};
+
+/**
+ * @brief One-shot device batch encode (compiles the kernel for this call)
+ *
+ * @param coords n packed cl_int3 coordinates
+ * @param levels Per-cell levels (uint8), or nullptr to use `level`
+ * @param keys_out n HilbertIndex values, bit-exact with encode()
+ */
+void encodeBatchDevice(IBackend& backend, const DeviceBuffer& coords, const DeviceBuffer* levels,
+                       DeviceBuffer& keys_out, size_t n, uint8_t level = MAX_REFINEMENT_LEVEL);
+
 } // namespace hilbert
 } // namespace fluidloom
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "fluidloom/core/reduction/ExactAccumulator.h"
+#include "fluidloom/core/backend/IBackend.h"
+#include "fluidloom/core/hilbert/HilbertCodec.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace fluidloom {
+namespace reduction {
+
+enum class ReduceOp : uint32_t {
+    SUM = 0,
+    MIN = 1,
+    MAX = 2
+};
+
+// Per-cell term of a reduction, over the components of one field
+enum class ReduceTerm : uint32_t {
+    VALUE = 0,          // c0
+    SQUARED_NORM = 1,   // c0² + c1² + c2²
+    NORM = 2            // sqrt(c0² + c1² + c2²)
+};
+
+/**
+ * @brief One SOA float field: component k starts `stride` floats after component 0
+ */
+struct FieldView {
+    const void* data = nullptr;  // Device pointer (host memory on the MOCK backend)
+    size_t stride = 0;
+};
+
+/**
+ * @brief One global quantity
+ *
+ * term(cell) · weight(cell) · 8^-level(cell) · scale, reduced with op. With
+ * weight_field = density and scale = 0.5, SQUARED_NORM of the velocity is the
+ * kinetic energy; NORM with MAX is the peak speed.
+ */
+struct ReductionSpec {
+    std::string name;
+    ReduceOp op = ReduceOp::SUM;
+    ReduceTerm term = ReduceTerm::VALUE;
+    uint32_t field = 0;             // Index into the inputs
+    uint16_t first_component = 0;
+    uint16_t num_components = 1;    // 1..3
+    int32_t weight_field = -1;      // Component 0 of this input multiplies the term; -1 for none
+    bool volume_weighted = false;   // Needs per-cell levels
+    int32_t level = -1;             // Only cells at this level contribute (needs levels); -1 for all
+    float scale = 1.0f;
+};
+
+/**
+ * @brief Partial results of a fused reduction on one rank
+ *
+ * Sums are exact accumulators; MIN/MAX are exact too (ties are bit-equal,
+ * -0 is stored as +0), so merging partials in any order gives the same bits.
+ */
+class ReductionPartials {
+public:
+    ReductionPartials() = default;
+    explicit ReductionPartials(std::vector<ReduceOp> ops);
+
+    size_t size() const { return m_ops.size(); }
+    ReduceOp op(size_t i) const { return m_ops[i]; }
+
+    void addTerm(size_t i, float term);
+    void merge(const ReductionPartials& other);
+
+    // Merge one ExactAccumulator::WORDS record laid out as the kernel writes it
+    void mergeRecord(size_t i, const int64_t* words);
+
+    double value(size_t i) const;
+    std::vector<double> values() const;
+
+    // size() records of ExactAccumulator::WORDS words
+    std::vector<int64_t> serialize() const;
+    static ReductionPartials deserialize(const std::vector<ReduceOp>& ops, const int64_t* words);
+
+private:
+    std::vector<ReduceOp> m_ops;
+    std::vector<ExactAccumulator> m_sums;
+    std::vector<float> m_extrema;
+    std::vector<uint64_t> m_flags;  // ExactAccumulator::FLAG_NAN for MIN/MAX
+};
+
+/**
+ * @brief Bitwise-reproducible global reductions
+ *
+ * reduceLocal() evaluates up to MAX_FUSED reductions over the same cells in a
+ * single launch of kernels/reduction/fused_reduce.cl. Each work-group tree-
+ * reduces its work-items in a fixed pairing and writes one record per
+ * reduction; the host merges the records in work-group order. The MOCK
+ * backend (or no backend) evaluates the same per-cell terms on the host.
+ *
+ * allReduce() then combines the ranks' partials in Hilbert order (ordered by
+ * each rank's first key, rank as tie-break). Since every merge is exact, the
+ * result is bit-identical across runs, work-group sizes and rank counts, as
+ * long as every cell's term is computed the same way: the kernel is built
+ * without FP contraction and with correctly rounded sqrt, and the host path
+ * is compiled with -ffp-contract=off.
+ */
+class DeterministicReducer {
+public:
+    static constexpr size_t MAX_FUSED = 8;
+    static constexpr size_t MAX_INPUTS = 4;
+    static constexpr size_t WORK_GROUP_SIZE = 64;   // Matches WG_SIZE in the kernel
+    static constexpr size_t MAX_WORK_GROUPS = 1024; // Bounds the partials read back
+
+    // All-gather of a fixed-size byte record, e.g. MPITransport::allGather;
+    // returns one record per rank, in rank order
+    using GatherFn = std::function<std::vector<uint8_t>(const void* data, size_t size)>;
+
+    explicit DeterministicReducer(IBackend* backend = nullptr);
+    ~DeterministicReducer();
+
+    DeterministicReducer(const DeterministicReducer&) = delete;
+    DeterministicReducer& operator=(const DeterministicReducer&) = delete;
+
+    /**
+     * @brief Evaluate the reductions over this rank's cells
+     * @param levels Per-cell uint8 levels, or nullptr if no spec is volume weighted or level filtered
+     * @throws std::invalid_argument for more than MAX_FUSED specs or a bad spec
+     */
+    ReductionPartials reduceLocal(const std::vector<ReductionSpec>& specs,
+                                  const std::vector<FieldView>& inputs,
+                                  const void* levels,
+                                  size_t num_cells);
+
+    /**
+     * @brief Combine every rank's partials; identical on all ranks
+     * @param first_key Hilbert key of this rank's first owned cell
+     */
+    static std::vector<double> allReduce(const ReductionPartials& local,
+                                         hilbert::HilbertIndex first_key,
+                                         const GatherFn& gather);
+
+    // Fused local reduction followed by allReduce()
+    std::vector<double> reduce(const std::vector<ReductionSpec>& specs,
+                               const std::vector<FieldView>& inputs,
+                               const void* levels,
+                               size_t num_cells,
+                               hilbert::HilbertIndex first_key,
+                               const GatherFn& gather);
+
+private:
+    IBackend* m_backend;
+    IBackend::KernelHandle m_kernel{nullptr};
+    DeviceBufferPtr m_spec_buffer;
+    DeviceBufferPtr m_partials_buffer;
+    size_t m_partials_capacity = 0;
+
+    bool useHostPath() const;
+    static void validate(const std::vector<ReductionSpec>& specs,
+                         const std::vector<FieldView>& inputs,
+                         const void* levels);
+};
+
+} // namespace reduction
+} // namespace fluidloom
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace fluidloom {
+namespace reduction {
+
+/**
+ * @brief Exact fixed-point accumulator for sums of floats
+ *
+ * A superaccumulator wide enough for every finite float: DIGITS 32-bit
+ * digits kept in int64 words (carry-save), digit i weighing 2^(32i - BIAS).
+ * Each add is exact, and integer addition is associative, so the total does
+ * not depend on the order, grouping or partitioning of the terms. The same
+ * layout is used by kernels/reduction/fused_reduce.cl, so device partials
+ * merge into host accumulators directly.
+ *
+ * Inf and NaN cannot be represented and are recorded in flags instead; the
+ * result is then NaN or ±inf as IEEE addition would give.
+ */
+class ExactAccumulator {
+public:
+    static constexpr int DIGITS = 11;
+    static constexpr int DIGIT_BITS = 32;
+    static constexpr int BIAS = 160;          // Digit 0 weighs 2^-160; float subnormals start at 2^-149
+    static constexpr size_t WORDS = DIGITS + 1;  // Serialized form: digits, then flags
+
+    static constexpr uint64_t FLAG_NAN = 1;
+    static constexpr uint64_t FLAG_POS_INF = 2;
+    static constexpr uint64_t FLAG_NEG_INF = 4;
+
+    void add(float value);
+    void merge(const ExactAccumulator& other);
+
+    // Propagate carries: digits 0..DIGITS-2 end up in [0, 2^32), the top digit
+    // carries the sign. The normalized form of a value is unique.
+    void normalize();
+
+    // Correctly rounded (nearest-even) value of the exact sum
+    double toDouble() const;
+
+    bool isZero() const;
+    uint64_t flags() const { return m_flags; }
+
+    void store(int64_t* words) const;   // WORDS words, normalized
+    static ExactAccumulator load(const int64_t* words);
+
+    bool operator==(const ExactAccumulator& other) const;
+    bool operator!=(const ExactAccumulator& other) const { return !(*this == other); }
+
+private:
+    // Adds a digit can absorb before it must be normalized (each add < 2^32)
+    static constexpr uint32_t MAX_PENDING = 1u << 30;
+
+    std::array<int64_t, DIGITS> m_digits{};
+    uint64_t m_flags = 0;
+    uint32_t m_pending = 0;
+};
+
+} // namespace reduction
+} // namespace fluidloom
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "fluidloom/core/fields/FieldDescriptor.h"
+#include "fluidloom/common/StringInterner.h"
+#include <deque>
 #include <unordered_map>
 #include <shared_mutex>
 #include <optional>
@@ -11,6 +13,9 @@ namespace registry {
 
 /**
  * @brief Thread‑safe singleton registry for field descriptors.
+ *
+ * Descriptors live in registration order and are indexed by the interned
+ * field name, so resolving a SymbolId is a bounds check and an array load.
  */
 class FieldRegistry {
 public:
@@ -30,6 +35,9 @@ public:
     // Lookup by handle (fast path)
     std::optional<fields::FieldDescriptor> lookupById(fields::FieldHandle handle) const;
 
+    // Lookup by interned name; the pointer stays valid until clear()
+    const fields::FieldDescriptor* find(SymbolId symbol) const;
+
     // Check existence by name
     bool exists(const std::string& name) const;
 
@@ -42,8 +50,11 @@ public:
 private:
     FieldRegistry() = default;
     mutable std::shared_mutex mutex_;
-    std::unordered_map<std::string, fields::FieldDescriptor> by_name_;
-    std::unordered_map<uint64_t, fields::FieldDescriptor> by_id_;
+    const fields::FieldDescriptor* findLocked(SymbolId symbol) const;
+
+    std::deque<fields::FieldDescriptor> fields_;  // Registration order; stable references
+    std::vector<uint32_t> slot_by_symbol_;        // SymbolId -> index in fields_ + 1, 0 = absent
+    std::unordered_map<uint64_t, uint32_t> by_id_;
 };
 
 } // namespace registry
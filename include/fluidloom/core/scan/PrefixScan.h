@@ -0,0 +1,89 @@
+#pragma once
+
+#ifdef __APPLE__
+#include <OpenCL/opencl.h>
+#else
+#include <CL/cl.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace fluidloom {
+namespace scan {
+
+/**
+ * @brief Device-wide exclusive prefix sum over uint32 buffers
+ *
+ * Reduce-then-scan in three launches of kernels/scan/prefix_scan.cl: every
+ * work-group reduces one tile of TILE_SIZE elements, a single work-group
+ * scans the tile sums, and every work-group then scans its tile offset by
+ * that prefix. Work is O(n) and no work-group waits on another, so the
+ * result is exact for any n on OpenCL 1.2 devices without forward-progress
+ * guarantees (which a single-pass decoupled look-back would need).
+ *
+ * Used for split child allocation, merge group numbering and compaction,
+ * which all turn a per-cell count into per-cell offsets and a total. Works
+ * on raw cl_mem buffers, like the adaptation engines that use it.
+ * Sums wrap modulo 2^32.
+ */
+class PrefixScan {
+public:
+    static constexpr size_t WORK_GROUP_SIZE = 256;  // Matches WG_SIZE in the kernel
+    static constexpr size_t ITEMS_PER_THREAD = 4;   // Matches ITEMS
+    static constexpr size_t TILE_SIZE = WORK_GROUP_SIZE * ITEMS_PER_THREAD;
+
+    PrefixScan(cl_context context, cl_command_queue queue);
+    ~PrefixScan();
+
+    PrefixScan(const PrefixScan&) = delete;
+    PrefixScan& operator=(const PrefixScan&) = delete;
+
+    /**
+     * @brief output[i] = input[0] + ... + input[i-1]
+     *
+     * input and output may be the same buffer. Enqueued on the queue; when
+     * total is non-null the sum of all n inputs is read back (blocking).
+     */
+    void exclusiveScan(cl_mem input, cl_mem output, size_t n, uint32_t* total = nullptr);
+
+    /**
+     * @brief Same scan, with the total copied to total_buffer[total_index]
+     *
+     * Nothing is read back, so the total can size later launches (as an
+     * argument they read on the device) or join a single readback of counts.
+     */
+    void exclusiveScan(cl_mem input, cl_mem output, size_t n, cl_mem total_buffer, size_t total_index);
+
+    static size_t numTiles(size_t n) { return (n + TILE_SIZE - 1) / TILE_SIZE; }
+
+    // Sequential reference; in and out may alias. Returns the total.
+    static uint32_t exclusiveScanHost(const uint32_t* in, uint32_t* out, size_t n);
+
+    /**
+     * @brief Host model of the three device passes for a given tile size
+     *
+     * Same tile reduction, chunked tile-sum scan (chunks of tile_size tile
+     * sums) and per-tile scan as the kernels, so tests can check tile and
+     * chunk boundaries at sizes that are cheap on the host.
+     */
+    static uint32_t exclusiveScanTiled(const uint32_t* in, uint32_t* out, size_t n, size_t tile_size);
+
+private:
+    cl_context m_context;
+    cl_command_queue m_queue;
+    cl_program m_program;
+    cl_kernel m_kernel_reduce_tiles;
+    cl_kernel m_kernel_scan_tile_sums;
+    cl_kernel m_kernel_scan_tiles;
+    cl_mem m_tile_sums;         // num_tiles + 1 entries; the last holds the total
+    size_t m_tile_capacity;
+
+    void compileKernels();
+    void ensureTileSums(size_t num_tiles);
+    static std::string loadKernelSource(const std::string& filename);
+};
+
+} // namespace scan
+} // namespace fluidloom
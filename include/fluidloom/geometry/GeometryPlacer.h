@@ -5,6 +5,7 @@
 #include "fluidloom/geometry/SimpleSTLVoxelizer.h"
 #include "fluidloom/geometry/VoxelizedCell.h"
 #include "fluidloom/core/hilbert/CellCoord.h"
+#include "fluidloom/core/hilbert/HilbertCodec.h"
 #include <vector>
 #include <memory>
 
@@ -36,10 +37,28 @@ public:
         const GeometryDescriptor::AABB& domain_bbox
     );
     
+    /**
+     * @brief Encode Hilbert indices of large geometries on this backend
+     * 
+     * Batches of at least DEVICE_ENCODE_THRESHOLD cells are encoded with
+     * hilbert::DeviceEncoder; smaller ones (or no backend) stay on the host.
+     */
+    void setBackend(IBackend* backend);
+    
+    static constexpr size_t DEVICE_ENCODE_THRESHOLD = 1u << 16;
+    
 private:
     ImplicitEvaluator m_implicit_evaluator;
     SimpleSTLVoxelizer m_stl_voxelizer;
     
+    IBackend* m_backend = nullptr;
+    std::unique_ptr<hilbert::DeviceEncoder> m_encoder;  // Created on first large batch
+    
+    /**
+     * @brief Hilbert indices (finest level) for a batch of cells
+     */
+    std::vector<hilbert::HilbertIndex> encodeCells(const std::vector<CellCoord>& cells);
+    
     /**
      * @brief Process a single geometry descriptor
      */
@@ -2,6 +2,8 @@
 
 #include "fluidloom/halo/GhostRange.h"
 #include "fluidloom/core/hilbert/HilbertCodec.h"
+#include <mpi.h>
+#include <map>
 #include <vector>
 #include <memory>
 
@@ -11,26 +13,65 @@ namespace halo {
 class GhostRangeBuilder {
 public:
     GhostRangeBuilder();
-    ~GhostRangeBuilder() = default;
+    ~GhostRangeBuilder();
+    
+    GhostRangeBuilder(const GhostRangeBuilder&) = delete;
+    GhostRangeBuilder& operator=(const GhostRangeBuilder&) = delete;
     
     // Build global topology by exchanging local ranges with all ranks
     void buildGlobalTopology(hilbert::HilbertIndex local_min, hilbert::HilbertIndex local_max);
     
-    // Identify ghost ranges needed from neighbors based on halo depth
-    // Returns a list of ranges to request from neighbors
+    // Identify ghost ranges needed from other ranks based on halo depth.
+    // Local cells are finest-level Hilbert keys (the space split points live
+    // in); every cell within halo_depth of one of them that another rank owns
+    // under the current ranges is requested. Returns one inclusive
+    // [start_idx, end_idx] range per run of consecutive remote keys.
     std::vector<GhostCandidate> identifyGhostCandidates(
         const std::vector<hilbert::HilbertIndex>& local_cells,
         int halo_depth
     );
     
+    // Update the rank -> Hilbert range table from rebalanced split points
+    // (N-1 splits for N ranks). Splits are identical on every rank, so this
+    // needs no communication. Returns the ranks whose range moved.
+    // @throws std::invalid_argument unless splits are ascending and above 0
+    std::vector<int> applySplits(const std::vector<uint64_t>& new_splits);
+    
+    // Post-rebalance refresh: recompute ghost candidates only if this rank or
+    // one of its SFC neighbors moved, then exchange them with the neighbors
+    // over a distributed-graph communicator (MPI_Neighbor_alltoallv) rather
+    // than a global all-to-all. Returns true if local candidates changed.
+    // Only candidates owned by an SFC neighbor are exchanged.
+    bool rebuildAfterRebalance(
+        const std::vector<uint64_t>& new_splits,
+        const std::vector<hilbert::HilbertIndex>& local_cells,
+        int halo_depth
+    );
+    
     const GlobalTopology& getTopology() const { return m_topology; }
     
+    // Ranges this rank requests from its neighbors
+    const std::vector<GhostCandidate>& getGhostCandidates() const { return m_ghost_candidates; }
+    
+    // Ranges each neighbor requested from this rank, keyed by neighbor rank
+    const std::map<int, std::vector<GhostCandidate>>& getRemoteRequests() const { return m_remote_requests; }
+    
 private:
     GlobalTopology m_topology;
     std::vector<std::pair<hilbert::HilbertIndex, hilbert::HilbertIndex>> m_global_ranges;
     
+    std::vector<GhostCandidate> m_ghost_candidates;
+    std::map<int, std::vector<GhostCandidate>> m_remote_requests;
+    
+    // SFC neighbors (prev/next rank) and their graph communicator, created lazily
+    std::vector<int> m_neighbors;
+    MPI_Comm m_neighbor_comm = MPI_COMM_NULL;
+    
     // Helper to find which rank owns a given Hilbert index
     int findOwnerRank(hilbert::HilbertIndex idx) const;
+    
+    void ensureNeighborComm();
+    void exchangeWithNeighbors(bool local_changed);
 };
 
 } // namespace halo
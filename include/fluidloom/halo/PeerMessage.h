@@ -0,0 +1,149 @@
+#pragma once
+
+#include "fluidloom/halo/GhostRange.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace fluidloom {
+namespace halo {
+
+/**
+ * @brief Fixed header of an aggregated halo message
+ *
+ * A message carries every halo payload one rank sends one peer in an
+ * exchange phase:
+ *
+ *   [PeerMessageHeader][PeerSegment x num_segments][pad][payload floats]
+ *
+ * The payload starts at payload_offset (ALIGNMENT-aligned); each segment's
+ * values are component-major within it.
+ */
+struct PeerMessageHeader {
+    uint32_t magic;             // PeerMessageLayout::MAGIC
+    uint16_t version;
+    uint16_t segment_size;      // sizeof(PeerSegment), guards layout drift
+    uint32_t num_segments;
+    uint32_t phase;             // Exchange counter of the sender
+    uint32_t due_levels;        // Bit L set: segments with source level L are included
+    uint32_t total_cells;       // Sum of num_cells over segments
+    uint64_t payload_offset;    // Bytes from the message start
+    uint64_t total_bytes;
+};
+static_assert(sizeof(PeerMessageHeader) == 40, "PeerMessageHeader layout is shared with peer_message.cl");
+
+/**
+ * @brief One field over one ghost range, as described to the receiver
+ *
+ * The wire part is identical on sender and receiver. The local tail is only
+ * meaningful to the rank that built the table; the receiver uses its own.
+ * Mirrored by kernels/halo/peer_message.cl.
+ */
+struct PeerSegment {
+    // Wire
+    uint64_t hilbert_start;     // Ghost range key, same on both ranks
+    uint64_t hilbert_end;
+    uint32_t field_id;
+    uint32_t num_cells;         // Values per component
+    uint32_t cell_start;        // First cell of this segment within the message
+    uint32_t payload_offset;    // Floats from the payload start
+    uint16_t num_components;
+    uint8_t source_level;       // Level of the data on the sender
+    uint8_t target_level;       // Level of the ghost cells on the receiver
+    uint8_t interpolation;      // GhostRange::InterpolationType, applied while packing
+    uint8_t sources_per_cell;   // 1 for a copy, 8 for an interpolated value
+    uint16_t reserved;
+    float weights[8];           // Source weights of an interpolated value
+
+    // Local
+    uint32_t index_offset;      // Into the gather (sender) or scatter (receiver) index list
+    uint32_t field_slot;        // Into the HaloFieldBinding list
+    uint64_t field_stride;      // Floats between components of the field
+};
+static_assert(sizeof(PeerSegment) == 88, "PeerSegment layout is shared with peer_message.cl");
+
+/**
+ * @brief SOA float field taking part in halo exchange
+ */
+struct HaloFieldBinding {
+    uint32_t field_id = 0;          // FieldRegistry id, same on every rank
+    uint16_t num_components = 1;
+    void* data = nullptr;           // Component 0; device pointer (host memory on the MOCK backend)
+    size_t stride = 0;              // Floats between components
+};
+
+/**
+ * @brief Layout of the aggregated message for one peer and one set of due levels
+ *
+ * Sender and receiver build their layouts independently from their own
+ * ghost ranges and field bindings; segments are ordered by (hilbert_start,
+ * hilbert_end, source_level, field_id), so both derive the same offsets.
+ * The receiver checks the incoming header and table against its layout
+ * before scattering the payload, so a mismatched topology, field set or
+ * phase fails loudly instead of corrupting ghost cells.
+ *
+ * On the sender a range's gather list is its local_cell_indices, or its
+ * neighbor_cell_indices (8 per value) when the range is interpolated; on
+ * the receiver the scatter list is its local_cell_indices.
+ */
+class PeerMessageLayout {
+public:
+    static constexpr uint32_t MAGIC = 0x4D484C46;  // "FLHM"
+    static constexpr uint16_t VERSION = 1;
+    static constexpr size_t ALIGNMENT = 64;
+    static constexpr uint32_t ALL_LEVELS = 0xFFFFFFFFu;
+
+    enum class Direction { SEND, RECEIVE };
+
+    PeerMessageLayout() = default;
+
+    /**
+     * @brief Segments of every due range to or from the peer, for every field
+     * @param ranges Ghost ranges of this rank; those of other peers are skipped
+     * @param restricted One binding per field holding fine→coarse values
+     *        restricted before packing; VOLUME_WEIGHTED_AVERAGE segments then
+     *        travel as copies gathered from it through local_cell_indices, at
+     *        field slot fields.size() + i. Pass it (or not) on both ranks.
+     * @throws std::invalid_argument for inconsistent index lists
+     */
+    static PeerMessageLayout build(int peer,
+                                   Direction direction,
+                                   const std::vector<GhostRange>& ranges,
+                                   const std::vector<HaloFieldBinding>& fields,
+                                   uint32_t due_levels = ALL_LEVELS,
+                                   const std::vector<HaloFieldBinding>* restricted = nullptr);
+
+    int getPeer() const { return m_peer; }
+    Direction getDirection() const { return m_direction; }
+    bool empty() const { return m_segments.empty(); }
+
+    const PeerMessageHeader& getHeader() const { return m_header; }
+    const std::vector<PeerSegment>& getSegments() const { return m_segments; }
+    const std::vector<uint32_t>& getIndices() const { return m_indices; }
+    size_t getMessageBytes() const { return m_header.total_bytes; }
+    size_t getPayloadOffset() const { return m_header.payload_offset; }
+    uint32_t getTotalCells() const { return m_header.total_cells; }
+
+    // Header and segment table, i.e. the first getPayloadOffset() bytes
+    void writeHeader(uint8_t* message, uint32_t phase) const;
+
+    /**
+     * @brief Check a received header and table against this (receive) layout
+     * @throws std::runtime_error describing the first mismatch
+     */
+    void validate(const uint8_t* message, size_t size, uint32_t phase) const;
+
+    // Host evaluation of pack_peer_message / unpack_peer_message
+    void packHost(const std::vector<HaloFieldBinding>& fields, uint8_t* message) const;
+    void unpackHost(const uint8_t* message, const std::vector<HaloFieldBinding>& fields) const;
+
+private:
+    int m_peer = -1;
+    Direction m_direction = Direction::SEND;
+    PeerMessageHeader m_header{};
+    std::vector<PeerSegment> m_segments;
+    std::vector<uint32_t> m_indices;
+};
+
+} // namespace halo
+} // namespace fluidloom
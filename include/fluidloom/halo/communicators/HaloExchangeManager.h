@@ -3,16 +3,22 @@
 #include "fluidloom/core/backend/IBackend.h"
 #include "fluidloom/halo/GhostRange.h"
 #include "fluidloom/halo/PackBufferLayout.h"
+#include "fluidloom/halo/PeerMessage.h"
 #include "fluidloom/halo/buffers/DoubleBufferController.h"
 #include "fluidloom/halo/packers/HaloPackKernel.h"
 #include "fluidloom/halo/packers/HaloUnpackKernel.h"
+#include "fluidloom/halo/packers/PeerMessagePacker.h"
 #include "fluidloom/halo/events/EventChain.h"
 #include "fluidloom/halo/interpolation/TrilinearInterpolator.h"
+#include "fluidloom/halo/interpolation/VolumeWeightedAverager.h"
+#include <map>
 #include <memory>
 #include <vector>
 #include "fluidloom/transport/MPITransport.h"
 #include "fluidloom/transport/MPIEventBridge.h"
 #include "fluidloom/transport/GPUAwareBuffer.h"
+#include "fluidloom/transport/CompressionPolicy.h"
+#include <chrono>
 
 namespace fluidloom {
 namespace halo {
@@ -25,6 +31,21 @@ namespace halo {
  *   2. Wait for compute to complete (external)
  *   3. wait_completion() → blocks until unpack finished
  *   4. swap_buffers() → prepare for next iteration
+ *
+ * Everything sent to one peer in a phase travels as a single message: all
+ * halo fields over all due ranges and levels, described by a PeerMessage
+ * header, packed with one launch and scattered by the receiver with one
+ * launch. Ranges whose peer is this rank are copied device to device.
+ *
+ * Fine→coarse ranges are restricted before packing by VolumeWeightedAverager,
+ * which averages only the fine children a coarse ghost actually has, into one
+ * staging slot per coarse ghost and field; those slots travel as copies.
+ * Every setConservationCheckInterval() exchanges the restriction is checked
+ * for conservation (a blocking reduction, hence the cadence).
+ *
+ * With compression enabled, messages to a peer whose measured link makes it
+ * pay off are staged to the host and PayloadCodec-encoded on staging
+ * threads; the receiver tells frames from raw messages by their magic.
  */
 class HaloExchangeManager {
 public:
@@ -34,11 +55,15 @@ public:
     // Initialize kernels and buffers
     void initialize(size_t buffer_capacity_mb = 64);
     
-    // Register a ghost range to manage
+    // Register a ghost range to manage. Topology changes (ranges, fields,
+    // compression, initialize()) throw while an exchange is in flight
     void addGhostRange(const GhostRange& range);
     
-    // Start async exchange cycle
-    void exchangeAsync();
+    // Register a field whose ghost cells are exchanged; same order on every rank
+    void addHaloField(const HaloFieldBinding& field);
+    
+    // Start async exchange cycle for the ranges whose source level is in due_levels
+    void exchangeAsync(uint32_t due_levels = PeerMessageLayout::ALL_LEVELS);
     
     // Wait for exchange to complete (includes unpack)
     void waitCompletion();
@@ -46,6 +71,16 @@ public:
     // Prepare for next cycle
     void swapBuffers();
     
+    // Lossless compression of messages to remote peers; same setting on every rank
+    void setCompression(const transport::CompressionPolicy& policy);
+    transport::CompressionPolicy& getCompressionPolicy() { return compression; }
+    
+    // Check the fine→coarse restriction every `exchanges` exchanges (0 disables it)
+    void setConservationCheckInterval(uint32_t exchanges) { averager->setCheckInterval(exchanges); }
+    const std::vector<VolumeWeightedAverager::ConservationReport>& getConservationReports() const {
+        return conservation_reports;
+    }
+    
     // Statistics
     struct Stats {
         size_t bytes_exchanged{0};
@@ -53,6 +88,15 @@ public:
         double comm_time_ms{0.0};
         double unpack_time_ms{0.0};
         size_t num_exchanges{0};
+        size_t messages_sent{0};
+        size_t pack_launches{0};
+        size_t unpack_launches{0};
+        size_t compressed_messages{0};
+        size_t wire_bytes{0};           // Bytes actually sent, after compression
+        double codec_time_ms{0.0};      // Encode and decode of the last exchange
+        size_t restricted_cells{0};     // Coarse ghosts averaged before packing
+        size_t conservation_checks{0};
+        size_t conservation_violations{0};  // Fields that failed a check
     };
     Stats getStats() const { return stats; }
     
@@ -67,15 +111,46 @@ private:
     std::unique_ptr<transport::MPITransport> mpi_transport;
     std::unique_ptr<transport::MPIEventBridge> mpi_bridge;
     
-    // Override pack buffers with GPU-aware versions
-    std::unique_ptr<transport::GPUAwareBuffer> gpu_pack_buffer_a;
-    std::unique_ptr<transport::GPUAwareBuffer> gpu_pack_buffer_b;
+    // Aggregated message to and from one peer for one set of due levels
+    struct PeerChannel {
+        PeerMessageLayout send_layout;
+        PeerMessageLayout recv_layout;
+        PeerMessagePacker::DeviceTable send_table;
+        PeerMessagePacker::DeviceTable recv_table;
+        std::unique_ptr<transport::GPUAwareBuffer> send_a;   // Double-buffered sends
+        std::unique_ptr<transport::GPUAwareBuffer> send_b;
+        std::unique_ptr<transport::GPUAwareBuffer> recv;   // Sized for a frame when compressing
+        
+        // Compression state: encoded frame to send and the XOR-delta references
+        std::unique_ptr<transport::GPUAwareBuffer> send_frame;
+        size_t send_frame_bytes{0};                         // 0: send the raw message
+        std::vector<uint8_t> send_reference;
+        std::vector<uint8_t> recv_reference;
+        uint32_t send_reference_tag{0};
+        uint32_t recv_reference_tag{0};
+    };
+    
+    // Channels by due-level mask, then by peer rank; rebuilt when ranges or fields change
+    std::map<uint32_t, std::map<int, PeerChannel>> channels;
+    
+    // Upper bound of one message (initialize() capacity)
+    size_t max_message_bytes;
     
-    // Current buffer index (for double buffering)
+    // Current send buffer (for double buffering)
     bool using_buffer_a;
     
+    // Exchange in flight
+    uint32_t exchange_phase;
+    uint32_t pending_due_levels;
+    bool exchange_in_flight;
+    void requireIdle(const char* operation) const;
+    
     // Request tracking for wait
     std::vector<std::unique_ptr<transport::MPIRequestWrapper>> active_requests;
+    std::vector<std::pair<int, size_t>> request_sends;     // Peer and bytes of each request; 0 for receives
+    std::chrono::high_resolution_clock::time_point post_time;
+    
+    transport::CompressionPolicy compression;
     
     // Components
     std::unique_ptr<DoubleBufferController> buffer_controller;
@@ -83,15 +158,39 @@ private:
     std::unique_ptr<HaloUnpackKernel> unpack_kernel;
     std::unique_ptr<EventChain> event_chain;
     std::unique_ptr<TrilinearInterpolator> interpolator;
+    std::unique_ptr<PeerMessagePacker> message_packer;
+    std::unique_ptr<VolumeWeightedAverager> averager;
     
     // Data
     std::vector<GhostRange> ghost_ranges;
+    std::vector<HaloFieldBinding> halo_fields;
+    
+    // Fine→coarse restriction staging, rebuilt with the channels. send_ranges
+    // are ghost_ranges with each fine→coarse send gathering its staging slots
+    std::vector<GhostRange> send_ranges;
+    std::vector<DeviceBufferPtr> restricted_storage;
+    std::vector<HaloFieldBinding> restricted_fields;    // One per halo field
+    std::vector<HaloFieldBinding> pack_fields;          // halo_fields, then restricted_fields if used
+    size_t restricted_cells;
+    uint32_t restricted_levels;                         // Source levels of the restricted ranges
+    std::vector<VolumeWeightedAverager::ConservationReport> conservation_reports;
     
     // Stats
     Stats stats;
     
+    // Layouts and buffers of every peer for a due-level mask
+    std::map<int, PeerChannel>& channelsFor(uint32_t due_levels);
+    
+    // Staging slots and averaging masks of the fine→coarse sends
+    void prepareRestriction();
+    void restrictFineToCoarse();
+    
     // Helper to post MPI operations
-    void postMpiOperations();
+    void postMpiOperations(std::map<int, PeerChannel>& peers);
+    
+    // Encode the packed messages the policy selects; receive frames back to raw
+    void compressMessages(std::map<int, PeerChannel>& peers);
+    void decompressMessages(std::map<int, PeerChannel>& peers);
 };
 
 } // namespace halo
@@ -1,21 +1,45 @@
 #pragma once
 
 #include "fluidloom/halo/GhostRange.h"
+#include "fluidloom/halo/PackBufferLayout.h"
 #include "fluidloom/core/fields/FieldDescriptor.h"
 #include "fluidloom/core/soa/Buffer.h"
 #include "fluidloom/core/backend/IBackend.h"
 #include <array>
+#include <string>
+#include <vector>
 
 namespace fluidloom {
 namespace halo {
 
 /**
  * @brief Handles fine→coarse averaging for halo exchange
- * 
+ *
  * When a coarse GPU receives fine ghost cells, it must average them.
  * This class pre-computes averaging masks and validates conservation.
+ *
+ * Data is laid out as in PackBufferLayout (one contiguous plane of floats per
+ * field component, plane stride = buffer size / cell_size_bytes), so every
+ * field of every averaging range is restricted by a single kernel launch.
+ * The MOCK backend (or no backend) runs the host reference path instead.
+ *
+ * HaloExchangeManager restricts the fine→coarse ranges it sends with it,
+ * into per-field staging slots that are then packed as plain copies, and
+ * checks conservation every setCheckInterval() exchanges.
  */
 class VolumeWeightedAverager {
+public:
+    static constexpr uint32_t UNUSED = 0xFFFFFFFF;
+
+    // Conservation of one field: Σ fine == Σ coarse · n_valid per component
+    struct ConservationReport {
+        std::string field_name;
+        double fine_total = 0.0;      // Worst component
+        double coarse_total = 0.0;
+        double relative_error = 0.0;
+        bool conserved = true;
+    };
+
 private:
     // For each coarse cell, track which 8 fine cells contribute
     struct AveragingMask {
@@ -23,26 +47,72 @@ private:
         std::array<uint32_t, 8> fine_cell_indices;  // May be UNUSED (0xFFFFFFFF)
         uint8_t num_valid_fine_cells;
     };
-    
+
     std::vector<AveragingMask> masks;
-    
+
+    IBackend* backend = nullptr;
+
+    // Device copies of the masks
+    DeviceBufferPtr coarse_idx_buffer;
+    DeviceBufferPtr fine_idx_buffer;
+    DeviceBufferPtr partials_buffer;
+    size_t partials_capacity = 0;
+
+    IBackend::KernelHandle restrict_kernel{nullptr};
+    IBackend::KernelHandle residual_kernel{nullptr};
+
+    uint32_t check_interval = 0;
+
+    bool useHostPath() const;
+    void compileKernels();
+    static size_t planeCount(const PackBufferLayout& layout);
+
+    // Per-plane compensated (fine, coarse·n) totals
+    std::vector<std::array<double, 2>> planeTotals(const PackBufferLayout& layout,
+                                                   const Buffer& coarse_data,
+                                                   const Buffer& fine_data);
+
 public:
-    VolumeWeightedAverager() = default;
-    ~VolumeWeightedAverager() = default;
-    
-    // Build averaging masks for a set of ghost ranges
-    // void buildMasks(const std::vector<GhostRange>& ranges, const HashTable& hash_table);
-    
+    explicit VolumeWeightedAverager(IBackend* backend = nullptr);
+    ~VolumeWeightedAverager();
+
+    VolumeWeightedAverager(const VolumeWeightedAverager&) = delete;
+    VolumeWeightedAverager& operator=(const VolumeWeightedAverager&) = delete;
+
+    /**
+     * @brief Build averaging masks from the VOLUME_WEIGHTED_AVERAGE ranges
+     *
+     * For such a range, cached.local_cell_indices[i] is a coarse cell and
+     * cached.neighbor_cell_indices[8i .. 8i+7] are its fine children (UNUSED
+     * for children the range does not cover).
+     */
+    void buildMasks(const std::vector<GhostRange>& ranges);
+
+    size_t getNumMasks() const { return masks.size(); }
+
+    // Restrict every field of the layout: coarse = mean of the valid fine cells
+    void restrictFields(const PackBufferLayout& layout, const Buffer& fine_data, Buffer& coarse_data);
+
+    // Check every field of the layout; reductions use compensated sums
+    std::vector<ConservationReport> checkConservation(const PackBufferLayout& layout,
+                                                      const Buffer& coarse_data,
+                                                      const Buffer& fine_data,
+                                                      double tolerance = 1e-6);
+
+    // Run the check every `interval` steps (0 disables it)
+    void setCheckInterval(uint32_t interval) { check_interval = interval; }
+    bool isCheckStep(uint64_t step) const { return check_interval > 0 && step % check_interval == 0; }
+
     // Validate mass conservation: sum(fine) == coarse * 8 (within tolerance)
     bool validateConservation(const fields::FieldDescriptor& field,
                              const Buffer& coarse_data,
                              const Buffer& fine_data,
-                             float tolerance = 1e-6f) const;
-    
-    // Apply averaging (host-side for validation, device-side in kernel)
+                             float tolerance = 1e-6f);
+
+    // Apply averaging to a single FLOAT32 field
     void applyAveraging(const fields::FieldDescriptor& field,
                        const Buffer& source_data,
-                       Buffer& dest_data) const;
+                       Buffer& dest_data);
 };
 
 } // namespace halo
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "fluidloom/core/backend/IBackend.h"
+#include "fluidloom/halo/PeerMessage.h"
+#include <vector>
+
+namespace fluidloom {
+namespace halo {
+
+/**
+ * @brief Packs and unpacks aggregated per-peer messages (kernels/halo/peer_message.cl)
+ *
+ * A whole message is packed, or unpacked, with one launch as long as at
+ * most MAX_FIELDS fields take part; each further MAX_FIELDS costs one more
+ * launch. The MOCK backend (or no backend) runs the host evaluation in
+ * PeerMessageLayout instead.
+ */
+class PeerMessagePacker {
+public:
+    static constexpr size_t MAX_FIELDS = 8;         // Matches MAX_FIELDS in the kernel
+    static constexpr size_t WORK_GROUP_SIZE = 64;
+
+    // Segment table and index list of one layout, resident on the device
+    struct DeviceTable {
+        DeviceBufferPtr segments;
+        DeviceBufferPtr indices;
+    };
+
+    explicit PeerMessagePacker(IBackend* backend = nullptr);
+    ~PeerMessagePacker();
+
+    PeerMessagePacker(const PeerMessagePacker&) = delete;
+    PeerMessagePacker& operator=(const PeerMessagePacker&) = delete;
+
+    // Upload once per layout; empty on the host path
+    DeviceTable upload(const PeerMessageLayout& layout) const;
+
+    /**
+     * @brief Write header, table and payload of a send layout into message
+     * @return Kernel launches issued
+     */
+    size_t pack(const PeerMessageLayout& layout,
+                const DeviceTable& table,
+                const std::vector<HaloFieldBinding>& fields,
+                DeviceBuffer& message,
+                uint32_t phase);
+
+    /**
+     * @brief Validate a received message against a receive layout and scatter it
+     * @param received_bytes Size of the message as received
+     * @throws std::runtime_error if the message does not match the layout
+     * @return Kernel launches issued
+     */
+    size_t unpack(const PeerMessageLayout& layout,
+                  const DeviceTable& table,
+                  const DeviceBuffer& message,
+                  size_t received_bytes,
+                  const std::vector<HaloFieldBinding>& fields,
+                  uint32_t phase);
+
+private:
+    IBackend* m_backend;
+    IBackend::KernelHandle m_pack_kernel{nullptr};
+    IBackend::KernelHandle m_unpack_kernel{nullptr};
+
+    bool useHostPath() const;
+    size_t launch(const IBackend::KernelHandle& kernel,
+                  const PeerMessageLayout& layout,
+                  const DeviceTable& table,
+                  const void* message,
+                  const std::vector<HaloFieldBinding>& fields);
+};
+
+} // namespace halo
+} // namespace fluidloom
@@ -0,0 +1,84 @@
+#pragma once
+
+#ifdef __APPLE__
+#include <OpenCL/opencl.h>
+#else
+#include <CL/cl.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fluidloom {
+namespace load_balance {
+
+/**
+ * @brief Slot moves that close the holes left by removed cells
+ * 
+ * Cell src[i] moves to slot dst[i]. Sources are survivors taken from the
+ * tail, destinations are holes below new_count, so only O(removed) cells
+ * change slot.
+ */
+struct CompactionMoves {
+    std::vector<uint32_t> src;
+    std::vector<uint32_t> dst;
+    size_t new_count = 0;
+    
+    bool empty() const { return src.empty(); }
+};
+
+/**
+ * @brief Applies the same compaction to every SOA array of the mesh
+ * 
+ * The host key mirror and the device arrays are compacted from one
+ * CompactionMoves, so a hash patched from the mirror points at slots that
+ * hold the matching cells. Also packs outgoing cells for CellMigrator.
+ * Runs kernels/load_balance/compact_cells.cl.
+ */
+class CellCompactor {
+public:
+    CellCompactor(cl_context context, cl_command_queue queue);
+    ~CellCompactor();
+    
+    CellCompactor(const CellCompactor&) = delete;
+    CellCompactor& operator=(const CellCompactor&) = delete;
+    
+    /**
+     * @brief Moves that remove the given slots from [0, num_cells)
+     * @throws std::out_of_range if a slot is not below num_cells
+     */
+    static CompactionMoves plan(const std::vector<uint32_t>& removed, size_t num_cells);
+    
+    /**
+     * @brief Enqueue the moves on every array
+     * @param arrays Device buffer and element size in bytes, one per SOA array
+     */
+    void apply(const CompactionMoves& moves, const std::vector<std::pair<cl_mem, size_t>>& arrays);
+    
+    /**
+     * @brief Enqueue packing of the given cells into a migration message
+     * 
+     * Each array becomes one plane of indices.size() elements, in array
+     * order, starting at byte 0 of packed.
+     * @param arrays Device buffer and element size in bytes, one per SOA array
+     * @return Bytes written to packed
+     */
+    size_t gather(const std::vector<uint32_t>& indices,
+                  const std::vector<std::pair<cl_mem, size_t>>& arrays, cl_mem packed);
+    
+private:
+    cl_context m_context;
+    cl_command_queue m_queue;
+    cl_program m_program;
+    cl_kernel m_kernel_move;
+    cl_kernel m_kernel_gather;
+    
+    void compileKernels();
+    static std::string loadKernelSource(const std::string& filename);
+};
+
+} // namespace load_balance
+} // namespace fluidloom
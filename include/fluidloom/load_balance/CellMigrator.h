@@ -1,8 +1,10 @@
 #pragma once
 
 #include "fluidloom/load_balance/MigrationPlan.h"
+#include "fluidloom/load_balance/CellCompactor.h"
 #include "fluidloom/transport/MPITransport.h"
 #include "fluidloom/transport/GPUAwareBuffer.h"
+#include "fluidloom/core/backend/OpenCLBackend.h"
 
 #ifdef __APPLE__
 #include <OpenCL/cl.h>
@@ -10,6 +12,7 @@
 #include <CL/cl.h>
 #endif
 
+#include <map>
 #include <vector>
 #include <memory>
 #include <cstdint>
@@ -17,21 +20,42 @@
 namespace fluidloom {
 namespace load_balance {
 
+/**
+ * @brief Net effect of a migration on the local SOA layout
+ * 
+ * Lets the spatial hash be patched (HashTableManager::applyDelta) instead of
+ * rebuilt from scratch after every rebalance.
+ */
+struct MigrationDelta {
+    std::vector<uint64_t> removed_keys;    // Cells sent to other GPUs
+    std::vector<uint64_t> upsert_keys;     // Cells received or moved to a new SOA slot
+    std::vector<uint32_t> upsert_indices;  // New SOA index for each upsert key
+    
+    bool empty() const { return removed_keys.empty() && upsert_keys.empty(); }
+    
+    void clear() {
+        removed_keys.clear();
+        upsert_keys.clear();
+        upsert_indices.clear();
+    }
+};
+
 /**
  * @brief Executes cell migration between GPUs according to a migration plan
  * 
- * Uses existing pack/unpack kernels from Module 7 and MPITransport from Module 8
- * to transfer cells while preserving Hilbert order and field data.
+ * Outgoing cells are packed on the device (CellCompactor::gather) into one
+ * GPUAwareBuffer per destination and sent through MPITransport; received
+ * messages are copied into the tail of the SOA arrays. Message layout: one
+ * plane per bound array, in the order x, y, z, fields, level, state.
  */
 class CellMigrator {
 public:
     /**
      * @brief Initialize cell migrator
      * @param transport MPI transport layer
-     * @param context OpenCL context
-     * @param queue OpenCL command queue
+     * @param backend OpenCL backend owning the mesh buffers
      */
-    CellMigrator(transport::MPITransport* transport, cl_context context, cl_command_queue queue);
+    CellMigrator(transport::MPITransport* transport, OpenCLBackend* backend);
     
     ~CellMigrator();
     
@@ -42,6 +66,11 @@ public:
     /**
      * @brief Execute migration plan
      * 
+     * Collective over all ranks when more than one exists: senders announce
+     * their actual outgoing counts so receivers can post matching receives.
+     * Buffers are reallocated (and the handles replaced) when received cells
+     * exceed the capacity. Cell states and fields are optional (nullptr).
+     * 
      * @param plan Migration plan describing all transfers
      * @param coord_x X coordinates buffer (in/out)
      * @param coord_y Y coordinates buffer (in/out)
@@ -61,84 +90,126 @@ public:
         size_t* num_cells, size_t* capacity
     );
     
+    /**
+     * @brief Attach the host mirror of per-cell Hilbert keys (index = SOA slot)
+     * 
+     * Required on GPUs that send cells: migrate() selects outgoing cells by
+     * key, keeps the mirror in sync and records a MigrationDelta. Pass
+     * nullptr to detach.
+     */
+    void setCellKeys(std::vector<uint64_t>* keys) { m_cell_keys = keys; }
+    
+    /**
+     * @brief Delta recorded by the last migrate() call
+     */
+    const MigrationDelta& getLastDelta() const { return m_last_delta; }
+    
+    /**
+     * @brief Packed size of one migrated cell: coordinates, level, state and fields
+     */
+    static size_t bytesPerCell(uint32_t num_field_components) {
+        return sizeof(int) * 3 + sizeof(uint8_t) * 2 + num_field_components * sizeof(float);
+    }
+    
 private:
+    // One SOA array of the mesh: handle (replaced on growth) and element size
+    struct MeshArray {
+        cl_mem* buffer;
+        size_t elem_bytes;
+    };
+    
     transport::MPITransport* m_transport;
+    OpenCLBackend* m_backend;
     cl_context m_context;
     cl_command_queue m_queue;
     
-    // Temporary buffers for migration
-    std::unique_ptr<transport::GPUAwareBuffer> m_send_buffer;
-    std::unique_ptr<transport::GPUAwareBuffer> m_recv_buffer;
+    // Optional host key mirror and the delta of the last migration
+    std::vector<uint64_t>* m_cell_keys = nullptr;
+    MigrationDelta m_last_delta;
+    
+    // Device-side packing and hole filling, created on first use
+    std::unique_ptr<CellCompactor> m_compactor;
+    
+    CellCompactor& compactor();
     
     /**
-     * @brief Pack cells to migrate into send buffer
+     * @brief SOA indices of local cells in the transfer's Hilbert range
+     */
+    std::vector<uint32_t> selectOutgoing(const MigrationPlan::Transfer& transfer) const;
+    
+    /**
+     * @brief Actual outgoing cell count from every rank to every rank
      * 
-     * @param transfer Transfer descriptor
-     * @param coord_x, coord_y, coord_z Coordinate buffers
-     * @param levels Level buffer
-     * @param fields Field data buffer
-     * @param num_field_components Number of field components
-     * @return Number of cells packed
+     * Row s holds what rank s sends to each rank (size x size, row-major).
+     * Empty with a single rank, which has nobody to receive from.
+     */
+    std::vector<uint64_t> exchangeCounts(const std::map<int, std::vector<uint32_t>>& outgoing) const;
+    
+    /**
+     * @brief Enqueue packing of the given cells into a message
+     * @return Message size in bytes
      */
     size_t packCells(
-        const MigrationPlan::Transfer& transfer,
-        cl_mem coord_x, cl_mem coord_y, cl_mem coord_z,
-        cl_mem levels, cl_mem fields,
-        uint32_t num_field_components
+        const std::vector<uint32_t>& indices,
+        const std::vector<MeshArray>& arrays,
+        transport::GPUAwareBuffer& message
     );
     
     /**
-     * @brief Unpack received cells and insert in Hilbert order
+     * @brief Append a received message to the SOA arrays
+     * 
+     * The planes are copied to [*total_cells, *total_cells + n) first; the
+     * keys of the new cells are then derived from the unpacked coordinates
+     * and levels so the hash can be patched.
      * 
-     * @param num_cells_received Number of cells in receive buffer
-     * @param coord_x, coord_y, coord_z Coordinate buffers (out)
-     * @param levels Level buffer (out)
-     * @param fields Field data buffer (out)
-     * @param num_field_components Number of field components
+     * @param message Received message
+     * @param num_cells_received Number of cells in the message
+     * @param arrays Mesh arrays in message order
+     * @param coord_x, coord_y, coord_z Coordinate buffers
+     * @param levels Level buffer
      * @param total_cells Current total cell count (in/out)
      */
     void unpackCells(
+        const transport::GPUAwareBuffer& message,
         size_t num_cells_received,
-        cl_mem* coord_x, cl_mem* coord_y, cl_mem* coord_z,
-        cl_mem* levels, cl_mem* fields,
-        uint32_t num_field_components,
+        const std::vector<MeshArray>& arrays,
+        cl_mem coord_x, cl_mem coord_y, cl_mem coord_z, cl_mem levels,
         size_t* total_cells
     );
     
     /**
      * @brief Remove migrated cells from local arrays
      * 
+     * Holes are filled with cells taken from the tail (CellCompactor), on the
+     * device arrays and the key mirror alike, so only O(migrated) cells change
+     * SOA index; each move is recorded as an upsert in the delta.
+     * Adaptation's compaction restores strict Hilbert order later.
+     * 
      * @param migrated_indices Indices of cells that were migrated
-     * @param coord_x, coord_y, coord_z Coordinate buffers (in/out)
-     * @param levels Level buffer (in/out)
-     * @param fields Field data buffer (in/out)
-     * @param num_field_components Number of field components
+     * @param arrays Mesh arrays
      * @param num_cells Current cell count (in/out)
      */
     void compactAfterMigration(
         const std::vector<uint32_t>& migrated_indices,
-        cl_mem* coord_x, cl_mem* coord_y, cl_mem* coord_z,
-        cl_mem* levels, cl_mem* fields,
-        uint32_t num_field_components,
+        const std::vector<MeshArray>& arrays,
         size_t* num_cells
     );
     
     /**
-     * @brief Ensure buffers have sufficient capacity
+     * @brief Grow every array to hold at least required_capacity cells
+     * 
+     * New buffers are allocated, the first num_cells cells copied over and
+     * the old buffers released; the handles in arrays are replaced.
      * 
      * @param required_capacity Required capacity
-     * @param coord_x, coord_y, coord_z Coordinate buffers (in/out)
-     * @param levels Level buffer (in/out)
-     * @param cell_states Cell states buffer (in/out)
-     * @param fields Field data buffer (in/out)
-     * @param num_field_components Number of field components
+     * @param arrays Mesh arrays (in/out)
+     * @param num_cells Cells to preserve
      * @param capacity Current capacity (in/out)
      */
     void ensureCapacity(
         size_t required_capacity,
-        cl_mem* coord_x, cl_mem* coord_y, cl_mem* coord_z,
-        cl_mem* levels, cl_mem* cell_states,
-        cl_mem* fields, uint32_t num_field_components,
+        const std::vector<MeshArray>& arrays,
+        size_t num_cells,
         size_t* capacity
     );
 };
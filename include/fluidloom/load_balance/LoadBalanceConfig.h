@@ -9,6 +9,18 @@
 namespace fluidloom {
 namespace load_balance {
 
+/**
+ * @brief Measured cost and benefit of a candidate rebalance
+ * 
+ * Every value is global (reduced over all GPUs), so every GPU reaches the
+ * same decision and enters the migration together.
+ */
+struct RebalanceCost {
+    float migration_time_ms = 0.0f;       // Slowest GPU's estimate for its share of the plan
+    float step_time_imbalance_ms = 0.0f;  // Per-step busy time: max - mean over GPUs
+    float adaptation_rate = 0.0f;         // Cells changed by adaptation per step / total cells
+};
+
 /**
  * @brief Configuration for Hilbert SFC load balancer
  * 
@@ -32,6 +44,12 @@ struct LoadBalanceConfig {
     bool migrate_in_hilbert_order = true;  // Preserve spatial locality
     bool allow_cell_split_during_migration = false;  // true: split large blocks
     
+    // Cost-benefit policy: rebalance only when the step time recovered over
+    // the expected lifetime of the new partition exceeds the migration time
+    bool cost_benefit = true;
+    float min_payoff_ratio = 1.0f;         // Required savings / migration time
+    uint32_t max_payoff_horizon = 1000;    // Most steps a new partition is credited for
+    
     // Performance guardrails
     float max_migration_time_ms = 100.0f;  // Fail-fast if too slow
     float max_memory_overhead_percent = 5.0f;  // Extra memory allowed
@@ -57,6 +75,12 @@ struct LoadBalanceConfig {
         if (num_sample_points < 100) {
             throw std::invalid_argument("Need at least 100 sample points");
         }
+        if (min_payoff_ratio <= 0.0f) {
+            throw std::invalid_argument("min_payoff_ratio must be > 0");
+        }
+        if (max_payoff_horizon < min_interval_timesteps) {
+            throw std::invalid_argument("max_payoff_horizon must be >= min_interval_timesteps");
+        }
     }
     
     /**
@@ -91,6 +115,44 @@ struct LoadBalanceConfig {
         float imbalance = calculateImbalance(cell_counts);
         return imbalance > imbalance_tolerance;
     }
+    
+    /**
+     * @brief Steps a fresh partition is expected to stay within tolerance
+     * 
+     * Adaptation moves load at adaptation_rate per step, so a balanced
+     * partition drifts back to imbalance_tolerance after roughly
+     * tolerance / rate steps. Clamped to [min_interval_timesteps,
+     * max_payoff_horizon]; a static mesh gets the maximum.
+     */
+    uint32_t payoffHorizon(float adaptation_rate) const {
+        if (adaptation_rate <= 0.0f) return max_payoff_horizon;
+        float steps = imbalance_tolerance / adaptation_rate;
+        if (steps >= static_cast<float>(max_payoff_horizon)) return max_payoff_horizon;
+        return std::max(min_interval_timesteps, static_cast<uint32_t>(steps));
+    }
+    
+    /**
+     * @brief Cell-count trigger followed by the cost-benefit test
+     * 
+     * Rebalances when the per-step time recovered (the slowest GPU drops to
+     * the mean) over payoffHorizon() steps is at least min_payoff_ratio
+     * times the migration time. Under fast transient adaptation the horizon
+     * is short, so an imbalance that will not last is left alone.
+     * 
+     * @param cell_counts Current cell counts per GPU
+     * @param steps_since_last Number of timesteps since last rebalance
+     * @param cost Measured migration cost and step-time imbalance
+     * @return true if rebalancing should be triggered
+     */
+    bool shouldRebalance(const std::vector<size_t>& cell_counts,
+                        uint32_t steps_since_last,
+                        const RebalanceCost& cost) const {
+        if (!shouldRebalance(cell_counts, steps_since_last)) return false;
+        if (!cost_benefit) return true;
+        
+        float savings_ms = cost.step_time_imbalance_ms * payoffHorizon(cost.adaptation_rate);
+        return savings_ms > min_payoff_ratio * cost.migration_time_ms;
+    }
 };
 
 } // namespace load_balance
@@ -15,6 +15,12 @@ namespace load_balance {
  * 
  * Redistributes cells across GPUs to equalize load using Hilbert space-filling
  * curve partitioning. Computes optimal split points and creates migration plans.
+ * 
+ * Also keeps the measurements behind the cost-benefit trigger: smoothed
+ * per-step busy time, adaptation churn and the bandwidth seen by past
+ * migrations. Until a migration has been timed, the bandwidth is seeded
+ * from the transport's probed link (PeerAccessManager), or from whatever
+ * profile seedLinkBandwidth() is given, e.g. a CompressionPolicy estimate.
  */
 class LoadBalancer {
 public:
@@ -51,15 +57,63 @@ public:
      */
     bool shouldRebalance(const std::vector<size_t>& cell_counts);
     
+    /**
+     * @brief Check if a planned migration pays for itself (collective)
+     * 
+     * Gathers step times, adaptation churn and the plan's estimated time
+     * from all GPUs and applies LoadBalanceConfig's cost-benefit test. Falls
+     * back to the cell-count decision while any GPU has no step time yet.
+     * 
+     * @param cell_counts Current cell counts per GPU
+     * @param plan This GPU's migration plan from createMigrationPlan
+     * @return true if the migration should be executed
+     */
+    bool rebalancePaysOff(const std::vector<size_t>& cell_counts, const MigrationPlan& plan);
+    
+    /**
+     * @brief Record this GPU's busy time for one step
+     * @param busy_ms Kernel and packing time, excluding waits on other GPUs
+     */
+    void recordStepTime(float busy_ms);
+    
+    /**
+     * @brief Record cells created or removed by an adaptation pass
+     */
+    void recordAdaptation(size_t cells_changed) { m_pending_adapted_cells += cells_changed; }
+    
+    /**
+     * @brief Record a completed migration to measure link bandwidth
+     * @param bytes_sent Bytes this GPU sent
+     * @param elapsed_ms Wall time of the migration
+     */
+    void recordMigration(size_t bytes_sent, float elapsed_ms);
+    
+    /**
+     * @brief Seed the migration estimate with a probed or configured link
+     * 
+     * Used until the first recordMigration(); ignored afterwards and for
+     * links without a bandwidth.
+     */
+    void seedLinkBandwidth(const transport::PeerAccessManager::LinkProfile& link);
+    
+    /**
+     * @brief Set the migrated size of one cell (see CellMigrator::bytesPerCell)
+     */
+    void setBytesPerCell(size_t bytes) { m_bytes_per_cell = bytes; }
+    
     /**
      * @brief Compute new Hilbert split points to equalize load
+     *
+     * Needs no communication, so callers without a transport (e.g. the
+     * in-process scaling harness) can use it directly.
+     *
      * @param cell_counts Current cell counts per GPU
      * @param current_splits Current Hilbert split points (N-1 for N GPUs)
      * @param global_hilbert_min Minimum Hilbert index in simulation
      * @param global_hilbert_max Maximum Hilbert index in simulation
      * @return New split points that equalize load
      */
-    std::vector<uint64_t> computeSplitPoints(
+    static std::vector<uint64_t> computeSplitPoints(
         const std::vector<size_t>& cell_counts,
         const std::vector<uint64_t>& current_splits,
         uint64_t global_hilbert_min,
@@ -86,7 +140,7 @@ public:
     /**
      * @brief Increment timestep counter
      */
-    void incrementTimestep() { m_steps_since_last_balance++; }
+    void incrementTimestep();
     
     /**
      * @brief Reset timestep counter (called after rebalancing)
@@ -98,12 +152,28 @@ public:
      */
     uint32_t getStepsSinceLastBalance() const { return m_steps_since_last_balance; }
     
+    /**
+     * @brief Rank of this GPU in the transport
+     */
+    int getRank() const { return m_transport->getRank(); }
+    
 private:
     transport::MPITransport* m_transport;
     LoadBalanceConfig m_config;
     uint32_t m_steps_since_last_balance = 0;
     std::vector<size_t> m_cached_cell_counts;
     
+    // Cost-benefit measurements (exponential moving averages)
+    float m_step_time_ms = -1.0f;           // Negative until the first recordStepTime
+    float m_adapted_cells_per_step = 0.0f;
+    size_t m_pending_adapted_cells = 0;     // Since the last incrementTimestep
+    float m_bandwidth_bytes_per_ms = 0.0f;  // Zero until seeded or the first recordMigration
+    float m_link_latency_ms = 0.0f;         // Per transfer, from the seeded link
+    bool m_bandwidth_measured = false;      // A migration replaced the seed
+    size_t m_bytes_per_cell = 0;
+    
+    static constexpr float MEASUREMENT_SMOOTHING = 0.2f;  // Weight of the newest sample
+    
     /**
      * @brief Estimate Hilbert index at given cumulative cell position
      * @param cumulative_cells Target cumulative cell count
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <vector>
 #include <string>
@@ -60,6 +61,17 @@ struct MigrationPlan {
         return computed_total == total_cells_to_migrate;
     }
     
+    /**
+     * @brief Cells the given rank sends under this plan
+     */
+    size_t cellsSentBy(int rank) const {
+        size_t cells = 0;
+        for (const auto& transfer : transfers) {
+            if (transfer.source_rank == rank) cells += transfer.num_cells;
+        }
+        return cells;
+    }
+    
     /**
      * @brief Optimize the migration plan
      * 
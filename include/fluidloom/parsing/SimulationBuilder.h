@@ -2,6 +2,7 @@
 
 #include "fluidloom/runtime/ExecutionGraph.h"
 #include "fluidloom/runtime/nodes/AdaptMeshNode.h"
+#include "fluidloom/runtime/plan/SimulationPlan.h"
 #include "fluidloom/core/fields/SOAFieldManager.h"
 #include "fluidloom/core/fields/FieldDescriptor.h"
 #include "fluidloom/geometry/GeometryPlacer.h"
@@ -13,6 +14,8 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 // Forward declarations for ANTLR generated classes
 class FluidLoomSimulationParser;
@@ -46,6 +49,23 @@ public:
      */
     std::unique_ptr<runtime::ExecutionGraph> buildStub();
     
+    /**
+     * @brief Build the graph from script content and capture it as a plan
+     * 
+     * The plan holds the scheduled node list, DAG edges, field layouts and
+     * the compiled kernel binaries of this builder's device.
+     */
+    runtime::plan::SimulationPlan compilePlan(const std::string& script_content);
+    
+    /**
+     * @brief Rebuild the execution graph from a compiled plan
+     * 
+     * Skips parsing, code generation and hazard analysis. Kernel binaries
+     * are used when they were built for this device, otherwise the stored
+     * source is compiled.
+     */
+    std::unique_ptr<runtime::ExecutionGraph> buildFromPlan(const runtime::plan::SimulationPlan& plan);
+    
 private:
     cl_context m_context;
     cl_command_queue m_queue;
@@ -67,8 +87,24 @@ private:
     // Helper: Parse field declarations and register them
     void parseFieldDeclarations(FluidLoomSimulationParser* parser);
     
-    // Helper: Allocate buffers for all registered fields
-    void allocateFieldBuffers();
+    // Field access declared by a kernel definition of the script
+    struct KernelAccess {
+        std::vector<std::string> reads;
+        std::vector<std::string> writes;
+        uint8_t halo_depth = 0;
+    };
+    std::unordered_map<std::string, KernelAccess> m_kernel_access;
+    
+    // Fields the script reads on the host or outside the time loop; their
+    // values must survive the step, so they are never transient
+    std::unordered_set<std::string> m_host_fields;
+    
+    // Helper: Allocate buffers for all registered fields once the graph is
+    // built; transient fields share buffers along FieldLivenessAnalyzer's plan
+    void allocateFieldBuffers(runtime::ExecutionGraph& graph);
+    
+    // Helper: Bind the allocated field buffers to each kernel's parameters
+    void bindKernelFields(runtime::ExecutionGraph& graph);
     
     // Helper: Generate kernel code based on name and parameters
     std::string generateKernelCode(const std::string& kernel_name, const std::vector<std::string>& params);
@@ -76,6 +112,21 @@ private:
     // Helper: Generate simple kernel stub for testing
     std::string generateKernelStub(const std::string& kernel_name);
     
+    // Helper: AdaptMeshNode bound to this builder's mesh buffers
+    std::shared_ptr<runtime::nodes::AdaptMeshNode> createAdaptMeshNode();
+    
+    // Kernel metadata captured while building, keyed by node, for compilePlan()
+    std::unordered_map<const runtime::nodes::ExecutionNode*, runtime::plan::PlanNode> m_kernel_plans;
+    
+    // Device name and driver version; kernel binaries are only valid for a match
+    std::string deviceSignature() const;
+    
+    // Helper: Binary of a program built for a single device (empty on failure)
+    static std::vector<uint8_t> programBinary(cl_program program);
+    
+    // Helper: Kernel for a plan node, from its binary when possible
+    cl_kernel loadPlanKernel(const runtime::plan::PlanNode& node);
+    
     // Geometry placement
     std::unique_ptr<geometry::GeometryPlacer> m_geometry_placer;
     
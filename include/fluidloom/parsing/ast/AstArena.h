@@ -0,0 +1,82 @@
+#pragma once
+// Per-parse bump allocator for AST nodes
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace fluidloom {
+namespace parsing {
+namespace ast {
+
+/**
+ * @brief Bump allocator backing one parse's AST
+ *
+ * Nodes (and their shared_ptr control blocks) are carved out of large blocks
+ * via std::allocate_shared, so building a tree costs a pointer bump per node
+ * instead of a malloc, and the nodes of one kernel sit next to each other for
+ * the codegen walk. Individual frees are no-ops; the blocks are released when
+ * the arena and every node allocated from it are gone (each node keeps the
+ * block storage alive, so nodes may safely outlive the AstArena object).
+ *
+ * Not thread-safe: use one arena per parse.
+ */
+class AstArena {
+public:
+    explicit AstArena(size_t block_size = DEFAULT_BLOCK_SIZE)
+        : storage_(std::make_shared<Storage>(block_size)) {}
+
+    /**
+     * @brief Construct a node in the arena
+     */
+    template <typename T, typename... Args>
+    std::shared_ptr<T> make(Args&&... args) {
+        return std::allocate_shared<T>(Allocator<T>(storage_), std::forward<Args>(args)...);
+    }
+
+    // Bytes handed out so far (including control blocks and padding)
+    size_t bytesUsed() const { return storage_->bytes_used; }
+    size_t blockCount() const { return storage_->blocks.size(); }
+
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+private:
+    struct Storage {
+        explicit Storage(size_t size) : block_size(size) {}
+        void* allocate(size_t bytes, size_t alignment);
+
+        std::vector<std::unique_ptr<std::max_align_t[]>> blocks;
+        size_t block_size;
+        size_t offset = 0;      // Into blocks.back()
+        size_t capacity = 0;    // Of blocks.back()
+        size_t bytes_used = 0;
+    };
+
+    template <typename T>
+    struct Allocator {
+        using value_type = T;
+
+        explicit Allocator(std::shared_ptr<Storage> s) : storage(std::move(s)) {}
+        template <typename U>
+        Allocator(const Allocator<U>& other) : storage(other.storage) {}
+
+        T* allocate(size_t n) {
+            return static_cast<T*>(storage->allocate(n * sizeof(T), alignof(T)));
+        }
+        void deallocate(T*, size_t) noexcept {}
+
+        template <typename U>
+        bool operator==(const Allocator<U>& other) const { return storage == other.storage; }
+        template <typename U>
+        bool operator!=(const Allocator<U>& other) const { return storage != other.storage; }
+
+        std::shared_ptr<Storage> storage;
+    };
+
+    std::shared_ptr<Storage> storage_;
+};
+
+} // namespace ast
+} // namespace parsing
+} // namespace fluidloom
@@ -1,6 +1,7 @@
 #pragma once
 // @stable - Expression AST for DSL parser
 
+#include "fluidloom/common/StringInterner.h"
 #include <memory>
 #include <vector>
 #include <string>
@@ -63,10 +64,11 @@ class VariableExpression : public Expression {
 public:
     std::string name;
     std::string component;  // For velocity.x: component="x"
+    SymbolId symbol;        // Interned name, for symbol table and registry lookups
     
-    explicit VariableExpression(std::string n) : name(std::move(n)) {}
+    explicit VariableExpression(std::string n) : name(std::move(n)), symbol(intern(name)) {}
     VariableExpression(std::string n, std::string comp) 
-        : name(std::move(n)), component(std::move(comp)) {}
+        : name(std::move(n)), component(std::move(comp)), symbol(intern(name)) {}
     
     void accept(ExpressionVisitor& visitor) const override;
 };
@@ -114,9 +116,10 @@ class CallExpression : public Expression {
 public:
     std::string function_name;
     std::vector<std::shared_ptr<Expression>> arguments;
+    SymbolId function_symbol;  // Interned function_name
     
     CallExpression(std::string name, std::vector<std::shared_ptr<Expression>> args)
-        : function_name(std::move(name)), arguments(std::move(args)) {}
+        : function_name(std::move(name)), arguments(std::move(args)), function_symbol(intern(function_name)) {}
     
     void accept(ExpressionVisitor& visitor) const override;
 };
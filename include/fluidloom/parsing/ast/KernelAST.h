@@ -2,6 +2,7 @@
 // @stable - Kernel AST for DSL parser
 
 #include "fluidloom/parsing/ast/StatementAST.h"
+#include "fluidloom/parsing/ast/AstArena.h"
 #include <string>
 #include <vector>
 #include <memory>
@@ -23,6 +24,8 @@ public:
     std::vector<std::string> write_fields;
     uint8_t halo_depth = 0;
     std::string execution_mask;
+    std::string collision_model;    // bgk, mrt_raw, mrt_central, cumulant; empty for none
+    std::string collision_lattice;
     
     // Script body
     std::vector<std::shared_ptr<Statement>> statements;
@@ -30,6 +33,9 @@ public:
     // Source location
     Expression::SourceLoc loc;
     
+    // Backing store for the kernel body's nodes (filled by KernelVisitor)
+    AstArena arena;
+    
     KernelAST(std::string kernel_name) : name(std::move(kernel_name)) {}
     
     // Accessors
@@ -38,6 +44,8 @@ public:
     const std::vector<std::string>& getWriteFields() const { return write_fields; }
     uint8_t getHaloDepth() const { return halo_depth; }
     const std::string& getExecutionMask() const { return execution_mask; }
+    const std::string& getCollisionModel() const { return collision_model; }
+    const std::string& getCollisionLattice() const { return collision_lattice; }
     const std::vector<std::shared_ptr<Statement>>& getStatements() const { return statements; }
     
     // Mutators (for parser)
@@ -45,6 +53,10 @@ public:
     void setWriteFields(std::vector<std::string> fields) { write_fields = std::move(fields); }
     void setHaloDepth(uint8_t depth) { halo_depth = depth; }
     void setExecutionMask(std::string mask) { execution_mask = std::move(mask); }
+    void setCollision(std::string model, std::string lattice) {
+        collision_model = std::move(model);
+        collision_lattice = std::move(lattice);
+    }
     void setStatements(std::vector<std::shared_ptr<Statement>> stmts) { statements = std::move(stmts); }
 };
 
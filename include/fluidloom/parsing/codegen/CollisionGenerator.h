@@ -0,0 +1,161 @@
+#pragma once
+// Collision operators generated from a lattice descriptor
+
+#include "fluidloom/parsing/LatticeDescriptor.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace fluidloom {
+namespace parsing {
+namespace codegen {
+
+/**
+ * @brief Collision operator of a kernel, selected with `collision:` in the DSL
+ */
+enum class CollisionModel {
+    BGK,            // Single relaxation time
+    MRT_RAW,        // Multiple relaxation times on raw moments
+    MRT_CENTRAL,    // Multiple relaxation times on central moments (frame moving with u)
+    CUMULANT        // Relaxation of cumulants (Geier et al.), Galilean invariant
+};
+
+const char* collisionModelName(CollisionModel model);
+
+/**
+ * @brief Model for its DSL name ("bgk", "mrt_raw", "mrt_central", "cumulant")
+ * @throws std::invalid_argument for an unknown name
+ */
+CollisionModel parseCollisionModel(const std::string& name);
+
+/**
+ * @brief Relaxation rates of the moment-space operators
+ *
+ * omega sets the viscosity (shear, deviatoric second order), omega_bulk the
+ * trace of the second-order moments, omega_high everything from third order
+ * up; 1 relaxes those fully to equilibrium. BGK uses omega only, and MRT_RAW
+ * with all three equal is BGK.
+ */
+struct RelaxationRates {
+    float omega = 1.0f;
+    float omega_bulk = 1.0f;
+    float omega_high = 1.0f;
+};
+
+/**
+ * @brief Q monomials cx^a·cy^b·cz^c that are independent on a lattice's velocities
+ *
+ * Picked by increasing order from the exponents 0..2 (c³ = c on unit
+ * velocities), so the basis is the usual one: 1, c, cc, ..., up to cx²cy²cz²
+ * on D3Q27.
+ */
+struct MomentBasis {
+    std::vector<std::array<uint8_t, 3>> exponents;
+    std::vector<int8_t> matrix;     // Q x Q row-major: moment k at velocity i, always -1, 0 or 1
+    std::vector<double> inverse;    // Q x Q row-major: population i from moment k
+    bool closed = false;            // Every divisor of a basis monomial is in the basis
+
+    size_t size() const { return exponents.size(); }
+    int order(size_t k) const { return exponents[k][0] + exponents[k][1] + exponents[k][2]; }
+    int find(uint8_t a, uint8_t b, uint8_t c) const;  // -1 if not in the basis
+};
+
+/**
+ * @brief Emits constant-folded OpenCL collision functions for one lattice
+ *
+ * The moment matrix, its inverse and the equilibrium moments are computed
+ * once on the host; the emitted code is straight-line arithmetic with only
+ * the non-zero entries, e.g. for D3Q19 and mrt_raw:
+ *
+ *     float D3Q19_collide_mrt_raw(float* f, float omega, float omega_bulk, float omega_high)
+ *
+ * which relaxes the private populations f in place and returns rho. Central
+ * moments and cumulants are reached from raw moments by a binomial shift by
+ * u, so those transforms are constant-folded as well. Central moments relax
+ * to the Maxwellian (rho·cs2^n for even exponents), cumulants to cs2 on the
+ * second-order diagonal and zero elsewhere.
+ */
+class CollisionGenerator {
+public:
+    /**
+     * @throws std::invalid_argument if the lattice is invalid or has no full moment basis
+     */
+    explicit CollisionGenerator(const LatticeDescriptor& lattice);
+
+    const MomentBasis& getBasis() const { return m_basis; }
+    const std::string& getLatticeName() const { return m_name; }
+
+    // MRT_CENTRAL and CUMULANT need a closed basis
+    bool supports(CollisionModel model) const;
+
+    static std::string functionName(const std::string& lattice, CollisionModel model);
+
+    /**
+     * @brief OpenCL source of the model's collision function, include-guarded
+     * @throws std::invalid_argument if the model is not supported on this lattice
+     */
+    std::string generate(CollisionModel model) const;
+
+    /**
+     * @brief Host evaluation of the generated function; returns rho
+     */
+    float collide(CollisionModel model, float* f, const RelaxationRates& rates) const;
+
+private:
+    struct Coefficient {
+        int index;
+        double value;
+    };
+
+    // Equilibrium over rho as a polynomial in u:
+    // constant + linear·u + quadratic·(ux², uy², uz², ux·uy, ux·uz, uy·uz)
+    struct EquilibriumPolynomial {
+        double constant = 0.0;
+        std::array<double, 3> linear{};
+        std::array<double, 6> quadratic{};
+    };
+
+    // Binomial shift term: coefficient · u^powers · source moment
+    struct ShiftTerm {
+        double coefficient;
+        std::array<uint8_t, 3> powers;
+        int source;
+    };
+
+    // Product of normalized moments (or cumulants) over a set partition
+    struct PartitionTerm {
+        double coefficient;
+        std::vector<int> blocks;
+    };
+
+    std::string m_name;
+    std::vector<std::array<int8_t, 3>> m_velocities;
+    std::vector<double> m_weights;
+    double m_cs2;
+    bool m_axis_active[3] = {false, false, false};
+
+    MomentBasis m_basis;
+    std::vector<std::vector<Coefficient>> m_inverse_rows;   // Non-zero inverse entries per population
+    int m_momentum[3] = {-1, -1, -1};                       // Basis index of cx, cy, cz
+    std::vector<int> m_diagonal;                            // Basis indices of cx², cy², cz²
+
+    std::vector<EquilibriumPolynomial> m_population_eq;     // Second-order polynomial f_eq per velocity
+    std::vector<EquilibriumPolynomial> m_moment_eq;         // Its raw moments
+
+    std::vector<std::vector<ShiftTerm>> m_shift;            // Central moment k from raw moments
+    std::vector<std::vector<PartitionTerm>> m_to_cumulant;  // Cumulant k from normalized central moments
+    std::vector<std::vector<PartitionTerm>> m_from_cumulant;
+
+    void buildBasis();
+    void buildEquilibrium();
+    void buildShift();
+    void buildPartitions();
+
+    double centralEquilibrium(size_t k) const;   // Maxwellian central moment over rho
+    double cumulantEquilibrium(size_t k) const;
+};
+
+} // namespace codegen
+} // namespace parsing
+} // namespace fluidloom
@@ -18,6 +18,7 @@ class OpenCLGenerator : public ast::ExpressionVisitor, public ast::StatementVisi
 private:
     std::ostringstream code;
     int indent_level = 0;
+    std::string collide_function;  // Target of collide() in the current kernel
     
     void writeIndent() {
         for (int i = 0; i < indent_level; ++i) {
@@ -30,6 +31,12 @@ public:
     
     /**
      * @brief Generate complete OpenCL kernel from KernelAST
+     *
+     * A kernel with a collision clause is preceded by its generated collision
+     * function, and collide(f, omega[, omega_bulk[, omega_high]]) in its
+     * script calls that function.
+     *
+     * @throws std::invalid_argument if the collision lattice is not registered
      */
     std::string generateKernel(const ast::KernelAST& kernel);
     
@@ -2,7 +2,9 @@
 #pragma once
 
 #include "fluidloom/parsing/LatticeDescriptor.h"
-#include <unordered_map>
+#include "fluidloom/common/StringInterner.h"
+#include <deque>
+#include <vector>
 #include <string>
 #include <mutex>
 
@@ -11,9 +13,12 @@ namespace parsing {
 
 class ConstantRegistry {
 private:
-    std::unordered_map<std::string, ConstantDescriptor> constants;
+    std::deque<ConstantDescriptor> constants;  // Registration order; stable pointers
+    std::vector<uint32_t> slot_by_symbol;       // SymbolId -> index in constants + 1
     mutable std::mutex mutex_;
     
+    const ConstantDescriptor* findLocked(SymbolId symbol) const;
+    
     ConstantRegistry() = default;
     
 public:
@@ -26,6 +31,7 @@ public:
     
     void add(const ConstantDescriptor& desc);
     const ConstantDescriptor* get(const std::string& name) const;
+    const ConstantDescriptor* get(SymbolId symbol) const;
     bool exists(const std::string& name) const;
     bool validate() const;
     void clear();
@@ -55,6 +55,11 @@ public:
      */
     bool validateFieldReferences(const ast::KernelAST& kernel);
     
+    /**
+     * @brief Validate the collision clause against the LatticeRegistry
+     */
+    bool validateCollision(const ast::KernelAST& kernel);
+    
     /**
      * @brief Compute transitive halo depth
      */
@@ -1,6 +1,7 @@
 #pragma once
 // Symbol table for semantic analysis
 
+#include "fluidloom/common/StringInterner.h"
 #include <string>
 #include <unordered_map>
 #include <memory>
@@ -33,6 +34,7 @@ enum class SymbolType {
  */
 struct Symbol {
     std::string name;
+    SymbolId id = INVALID_SYMBOL;  // Interned name
     SymbolType type;
     bool is_const = false;
     bool is_field = false;
@@ -46,15 +48,18 @@ struct Symbol {
     SymbolType return_type = SymbolType::UNKNOWN;
     
     Symbol() : type(SymbolType::UNKNOWN) {}
-    Symbol(std::string n, SymbolType t) : name(std::move(n)), type(t) {}
+    Symbol(std::string n, SymbolType t) : name(std::move(n)), id(intern(name)), type(t) {}
 };
 
 /**
  * @brief Scope for symbol resolution
+ * 
+ * Symbols are keyed by interned ID; the string overloads intern-lookup the
+ * name once and never grow the interner for unknown names.
  */
 class Scope {
 private:
-    std::unordered_map<std::string, Symbol> symbols;
+    std::unordered_map<SymbolId, Symbol> symbols;
     Scope* parent = nullptr;
     int level = 0;
     
@@ -76,6 +81,12 @@ public:
      */
     std::optional<Symbol> lookupLocal(const std::string& name) const;
     
+    /**
+     * @brief Resolve an interned name through the scope chain without copying
+     * @return nullptr if the name is not bound
+     */
+    const Symbol* find(SymbolId id) const;
+    
     /**
      * @brief Get scope level
      */
@@ -119,6 +130,12 @@ public:
      */
     std::optional<Symbol> lookup(const std::string& name) const;
     
+    /**
+     * @brief Look up an interned name (no string hashing)
+     * @return nullptr if the name is not bound
+     */
+    const Symbol* find(SymbolId id) const { return current_scope->find(id); }
+    
     /**
      * @brief Add a field symbol
      */
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "fluidloom/parsing/ast/KernelAST.h"
+#include "fluidloom/parsing/ParseError.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fluidloom {
+namespace parsing {
+
+/**
+ * @brief Builds KernelAST nodes from kernel definitions
+ *
+ * Maps each kernelDefinition of the FluidLoomKernelParser grammar onto a
+ * KernelAST: reads/writes field lists, halo depth, execution mask, the
+ * collision clause (model and lattice) and the script body's statements.
+ * Inline functions are accepted by the grammar but not part of the AST.
+ */
+class KernelVisitor {
+public:
+    /**
+     * @brief Parse kernel definitions from source text
+     * @throws std::runtime_error on syntax errors or unsupported constructs
+     */
+    void parseString(const std::string& source);
+
+    /**
+     * @brief Parse kernel definitions from a file
+     * @throws std::runtime_error if the file cannot be read or parsed
+     */
+    void parseFile(const std::string& filename);
+
+    const std::vector<std::shared_ptr<ast::KernelAST>>& getKernels() const { return m_kernels; }
+    const std::vector<ParseError>& getErrors() const { return m_errors; }
+
+private:
+    std::vector<std::shared_ptr<ast::KernelAST>> m_kernels;
+    std::vector<ParseError> m_errors;
+};
+
+} // namespace parsing
+} // namespace fluidloom
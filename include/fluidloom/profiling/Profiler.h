@@ -6,10 +6,14 @@
 #include <chrono>
 #include <fstream>
 #include <thread>
+#include <utility>
 
 namespace fluidloom {
 namespace profiling {
 
+// Key/value annotations written to the event's "args" (e.g. {"peer", "3"})
+using TraceArgs = std::vector<std::pair<std::string, std::string>>;
+
 struct TraceEvent {
     std::string name;
     std::string category;
@@ -18,15 +22,20 @@ struct TraceEvent {
     long long duration_us; // Only for "X" phase
     std::thread::id thread_id;
     int pid;
+    TraceArgs args;
 };
 
 class Profiler {
 public:
     static Profiler& getInstance();
 
-    void beginEvent(const std::string& name, const std::string& category);
+    void beginEvent(const std::string& name, const std::string& category, const TraceArgs& args = {});
     void endEvent(const std::string& name, const std::string& category);
-    void recordCompleteEvent(const std::string& name, const std::string& category, long long start_us, long long duration_us);
+    void recordCompleteEvent(const std::string& name, const std::string& category, long long start_us, long long duration_us,
+                             const TraceArgs& args = {});
+
+    // Clock used for all event timestamps, for callers of recordCompleteEvent
+    static long long timestampUs();
 
     void setOutputPath(const std::string& path);
     void flush();
@@ -44,7 +53,7 @@ private:
 
 class ScopedEvent {
 public:
-    ScopedEvent(const std::string& name, const std::string& category = "default");
+    ScopedEvent(const std::string& name, const std::string& category = "default", const TraceArgs& args = {});
     ~ScopedEvent();
 
 private:
@@ -1,32 +1,86 @@
 #pragma once
 
 #include "fluidloom/runtime/nodes/ExecutionNode.h"
+#include <functional>
 #include <vector>
 #include <memory>
+#include <utility>
+#include <cstdint>
 
 namespace fluidloom {
 namespace runtime {
 
+namespace dependency {
+class DependencyGraph;
+}
+
+namespace executor {
+class WorkStealingExecutor;
+}
+
 // Use nodes namespace for ExecutionNode
 using nodes::ExecutionNode;
 
 /**
  * @brief Execution graph for simulation pipeline
  * 
- * Minimal implementation for AMR demo
+ * Minimal implementation for AMR demo. execute() runs nodes serially in
+ * insertion order; execute(executor) derives a DAG from the nodes' declared
+ * read/write fields and runs it on a WorkStealingExecutor. Each call is one
+ * "step" span in the profiler trace.
  */
 class ExecutionGraph {
 public:
-    ExecutionGraph() = default;
+    ExecutionGraph();
+    ~ExecutionGraph();
     
-    void addNode(std::shared_ptr<ExecutionNode> node) {
-        m_nodes.push_back(node);
-    }
+    void addNode(std::shared_ptr<ExecutionNode> node);
+    
+    void execute();
+    
+    /**
+     * @brief Report each execute() step's busy time (ms) to an observer
+     * 
+     * Busy time is the step's wall time minus the time spent in halo
+     * exchange, barrier and rebalance nodes, which wait on other GPUs
+     * (e.g. feeds LoadBalancer::recordStepTime). While an observer is set,
+     * execute() waits for outstanding device work before each of those
+     * nodes and at the end of the step so that device time is counted.
+     */
+    using StepObserver = std::function<void(float busy_ms)>;
+    void setStepObserver(StepObserver observer) { m_step_observer = std::move(observer); }
     
-    void execute() {
-        for (auto& node : m_nodes) {
-            node->execute(nullptr);
-        }
+    /**
+     * @brief Execute concurrently, preserving the serial semantics
+     * 
+     * Hazards (RAW/WAW/WAR, AMR level changes) between nodes in insertion
+     * order become edges; a node declaring no fields is a fence ordered
+     * against every other node. The DAG is built on first use and cached
+     * until the next addNode().
+     */
+    bool execute(executor::WorkStealingExecutor& executor);
+    
+    /**
+     * @brief DAG used by execute(executor), e.g. for field liveness analysis
+     */
+    const dependency::DependencyGraph& getDependencyGraph();
+    
+    /**
+     * @brief Distinct DAG edges as (from, to) indices in insertion order
+     */
+    std::vector<std::pair<uint32_t, uint32_t>> getDependencyEdges();
+    
+    /**
+     * @brief Install a precomputed DAG instead of running hazard analysis
+     * 
+     * Used when loading a compiled SimulationPlan: the edges are the ones
+     * getDependencyEdges() returned when the plan was built.
+     * @throws std::invalid_argument on out-of-range indices or a cycle
+     */
+    void setDependencyEdges(const std::vector<std::pair<uint32_t, uint32_t>>& edges);
+    
+    const std::vector<std::shared_ptr<ExecutionNode>>& getNodes() const {
+        return m_nodes;
     }
     
     size_t getNodeCount() const {
@@ -35,6 +89,10 @@ public:
     
 private:
     std::vector<std::shared_ptr<ExecutionNode>> m_nodes;
+    std::unique_ptr<dependency::DependencyGraph> m_dependency_graph;
+    StepObserver m_step_observer;
+    
+    void buildDependencyGraph();
 };
 
 } // namespace runtime
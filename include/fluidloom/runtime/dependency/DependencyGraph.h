@@ -5,6 +5,8 @@
 #include <vector>
 #include <unordered_map>
 #include <memory>
+#include <functional>
+#include <stdexcept>
 
 namespace fluidloom {
 namespace runtime {
@@ -0,0 +1,92 @@
+#pragma once
+// Liveness of transient fields and buffer sharing between them
+
+#include "fluidloom/runtime/dependency/DependencyGraph.h"
+#include "fluidloom/core/fields/FieldDescriptor.h"
+#include "fluidloom/core/fields/SOAFieldManager.h"
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace fluidloom {
+namespace runtime {
+namespace dependency {
+
+/**
+ * @brief Computes per-step field lifetimes over a DependencyGraph
+ *
+ * A field is transient when its value never crosses a step: every first
+ * access (an accessing node with no accessing ancestor) writes it without
+ * reading it. Fields marked is_transient are checked against this. Other
+ * fields are only inferred when setInferTransient(true) is set: the graph
+ * does not see host consumers (I/O, reductions read back between steps),
+ * so every such field would have to be pinned first. Halo-carrying fields
+ * (halo_depth > 0 or touched by a halo exchange), visualization, mask and
+ * material fields and pinned fields always keep a dedicated buffer.
+ *
+ * Two transient fields may share storage when one's lifetime ends before the
+ * other's begins along every path of the graph (every accessor of the first
+ * is an ancestor of every accessor of the second). Topological positions
+ * alone are not enough: unordered nodes may run concurrently under
+ * WorkStealingExecutor.
+ */
+class FieldLivenessAnalyzer {
+public:
+    struct FieldLifetime {
+        std::string field_name;
+        size_t first_access = 0;  // Position in topological order
+        size_t last_access = 0;
+        bool accessed = false;
+        bool transient = false;
+        std::string exclusion_reason;  // Why the field keeps a dedicated buffer
+    };
+
+    struct AliasPlan {
+        // Transient fields sharing one buffer, in lifetime order
+        std::vector<std::vector<std::string>> slots;
+        std::unordered_map<std::string, size_t> slot_of;
+        // Fields keeping their own buffer
+        std::vector<std::string> dedicated;
+
+        // Aligned bytes per cell with one buffer per field, and with the plan
+        size_t bytes_per_cell_before = 0;
+        size_t bytes_per_cell_after = 0;
+
+        bool sharesBuffer(const std::string& a, const std::string& b) const;
+    };
+
+    // Fields whose value must survive the step regardless of access pattern
+    // (e.g. read by host I/O outside the graph)
+    void pinField(const std::string& field_name) { pinned_fields.insert(field_name); }
+
+    void setInferTransient(bool infer) { infer_transient = infer; }
+
+    /**
+     * @brief Analyze field lifetimes and build an aliasing plan
+     * @param graph Validated dependency graph of one step
+     * @param fields Descriptors of every field to allocate
+     */
+    AliasPlan analyze(const DependencyGraph& graph, const std::vector<fields::FieldDescriptor>& fields);
+
+    const std::vector<FieldLifetime>& getLifetimes() const { return lifetimes; }
+
+    /**
+     * @brief Allocate fields following a plan
+     * @return Field name → handle; aliased fields share a buffer
+     */
+    static std::unordered_map<std::string, fields::FieldHandle> allocate(
+        fields::SOAFieldManager& manager,
+        const AliasPlan& plan,
+        const std::vector<fields::FieldDescriptor>& fields,
+        size_t num_cells);
+
+private:
+    std::unordered_set<std::string> pinned_fields;
+    bool infer_transient = false;
+    std::vector<FieldLifetime> lifetimes;
+};
+
+} // namespace dependency
+} // namespace runtime
+} // namespace fluidloom
@@ -0,0 +1,145 @@
+#pragma once
+// Work-stealing executor for the dependency DAG
+
+#include "fluidloom/runtime/dependency/DependencyGraph.h"
+
+#ifdef __APPLE__
+#include <OpenCL/opencl.h>
+#else
+#include <CL/cl.h>
+#endif
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fluidloom {
+namespace runtime {
+namespace executor {
+
+/**
+ * @brief Executes a DependencyGraph on a work-stealing thread pool
+ *
+ * Unlike TopologicalScheduler, which walks the topological order on one
+ * thread, the executor releases each node as soon as its own predecessors
+ * resolve:
+ * - HOST nodes run on a pool thread once every predecessor has completed
+ * - DEVICE nodes are dispatched once every predecessor has completed or,
+ *   for device predecessors, merely been enqueued; their events are passed
+ *   as the wait event (joined with a marker or user event when several)
+ *
+ * Completion is observed through clSetEventCallback rather than blocking
+ * waits, so host phases (I/O, diagnostics, MPI progress) overlap device
+ * compute. Each worker owns a deque: it pushes and pops released nodes at
+ * the back and, when empty, steals from the front of other workers' deques.
+ *
+ * One graph executes at a time; execute() blocks until every node completes.
+ */
+class WorkStealingExecutor {
+public:
+    // num_threads = 0 uses std::thread::hardware_concurrency()
+    explicit WorkStealingExecutor(size_t num_threads = 0);
+    ~WorkStealingExecutor();
+
+    WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+    WorkStealingExecutor& operator=(const WorkStealingExecutor&) = delete;
+
+    /**
+     * @brief Queue used to join several device predecessors with a marker
+     *
+     * Without one, multiple wait events are joined with a user event completed
+     * from event callbacks (which delays the dependent by a host round trip).
+     */
+    void setMarkerQueue(cl_command_queue queue) { marker_queue = queue; }
+
+    /**
+     * @brief Execute all nodes, respecting graph edges
+     * @return False if the graph is invalid or a device command failed
+     * @throws The first exception raised by a node's execute(); dependents of
+     *         a failed node are skipped
+     */
+    bool execute(const dependency::DependencyGraph& graph);
+
+    size_t getThreadCount() const { return workers.size(); }
+    double getLastExecutionTime() const { return last_execution_time_ms; }
+    uint64_t getStealCount() const { return steal_count.load(); }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<size_t> tasks;  // Node indices of the current run
+    };
+
+    struct NodeState {
+        WorkStealingExecutor* owner = nullptr;
+        size_t index = 0;
+        bool on_host = false;
+        std::atomic<size_t> remaining{0};  // Predecessors yet to release this node
+        cl_event event = nullptr;          // Returned by execute(), released after the run
+        long long start_us = 0;            // Profiler timestamp at issue, for the trace span
+    };
+
+    // Joins several device events into one user event
+    struct EventJoin {
+        cl_event user_event = nullptr;
+        std::atomic<size_t> remaining{0};
+        std::atomic<cl_int> status{CL_COMPLETE};
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    std::mutex sleep_mutex;
+    std::condition_variable sleep_cv;
+    std::atomic<size_t> queued_tasks{0};
+    std::atomic<size_t> next_worker{0};
+    bool stopping = false;
+
+    // Current run
+    std::mutex run_mutex;  // Serializes execute()
+    const dependency::DependencyGraph* graph = nullptr;
+    std::unique_ptr<NodeState[]> states;
+    std::vector<cl_event> owned_events;
+    std::vector<std::unique_ptr<EventJoin>> joins;
+    std::mutex owned_mutex;
+    std::atomic<size_t> outstanding{0};
+    std::atomic<bool> failed{false};
+    bool device_error = false;
+    std::exception_ptr first_error;
+    std::mutex done_mutex;
+    std::condition_variable done_cv;
+
+    cl_command_queue marker_queue = nullptr;
+
+    double last_execution_time_ms = 0.0;
+    std::atomic<uint64_t> steal_count{0};
+
+    void workerLoop(size_t worker_id);
+    bool popLocal(size_t worker_id, size_t& task);
+    bool steal(size_t worker_id, size_t& task);
+    void push(size_t node_idx);
+
+    void runNode(size_t node_idx);
+    cl_event joinPredecessors(size_t node_idx);
+
+    // A predecessor releases a device successor when issued (device -> device
+    // with an event), otherwise when complete
+    bool releasesOnIssue(size_t pred_idx, size_t succ_idx) const;
+    void onIssued(size_t node_idx);
+    void onCompleted(size_t node_idx);
+    void release(size_t node_idx);
+    void recordError(std::exception_ptr error, bool from_device);
+
+    static void CL_CALLBACK eventCallback(cl_event event, cl_int status, void* user_data);
+    static void CL_CALLBACK joinCallback(cl_event event, cl_int status, void* user_data);
+};
+
+} // namespace executor
+} // namespace runtime
+} // namespace fluidloom
@@ -2,9 +2,11 @@
 
 #include "fluidloom/runtime/nodes/ExecutionNode.h"
 #include "fluidloom/adaptation/AdaptationEngine.h"
+#include "fluidloom/core/fields/SOAFieldManager.h"
 #include <vector>
 
 namespace fluidloom {
+namespace load_balance { class LoadBalancer; }
 namespace runtime {
 namespace nodes {
 
@@ -14,6 +16,13 @@ namespace nodes {
  * Integrates Module 11 AdaptationEngine into the execution DAG.
  * This node is unique because it can RESIZE buffers.
  * Therefore, it holds pointers to cl_mem handles, not the handles themselves.
+ *
+ * With a bound SOAFieldManager every non-transient field is remapped;
+ * otherwise the buffers given to bindFields() are. Adaptation is enqueued
+ * after wait_event without blocking the host on it.
+ *
+ * A bound LoadBalancer is told how many cells each pass created, which
+ * sets the payoff horizon of its rebalance cost-benefit test.
  */
 class AdaptMeshNode : public ExecutionNode {
 private:
@@ -34,6 +43,9 @@ private:
     // Fields to be remapped
     std::vector<cl_mem*> fields;
     uint32_t num_field_components = 0;
+    fluidloom::fields::SOAFieldManager* field_manager = nullptr;
+    
+    fluidloom::load_balance::LoadBalancer* balancer = nullptr;
     
 public:
     AdaptMeshNode(std::string name, fluidloom::adaptation::AdaptationEngine* engine_ptr)
@@ -62,6 +74,16 @@ public:
         num_field_components = components;
     }
     
+    // Remap every field of the manager (takes precedence over bindFields)
+    void bindFieldManager(fluidloom::fields::SOAFieldManager* manager) {
+        field_manager = manager;
+    }
+    
+    // Report adaptation churn to the load balancer
+    void bindLoadBalancer(fluidloom::load_balance::LoadBalancer* load_balancer) {
+        balancer = load_balancer;
+    }
+    
     // Execute adaptation
     cl_event execute(cl_event wait_event) override;
     
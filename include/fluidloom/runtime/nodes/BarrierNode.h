@@ -3,15 +3,31 @@
 
 #include "fluidloom/runtime/nodes/ExecutionNode.h"
 
+// Forward declare OpenCL types
+typedef struct _cl_command_queue* cl_command_queue;
+
 namespace fluidloom {
 namespace runtime {
+
+namespace scheduler {
+class ScopedEventTable;
+}
+
 namespace nodes {
 
 /**
  * @brief Explicit synchronization barrier
  * 
  * Used to enforce ordering at critical points (before/after adaptation).
- * Translates to clEnqueueBarrierWithWaitList in OpenCL.
+ * Barriers are scoped sync points rather than full queue drains:
+ * - ADAPTATION_PRE/POST wait on the last writers of the node's declared
+ *   fields (the fields adaptation touches) and on their readers since
+ * - LEVEL_TRANSITION waits on the events of the node's AMR level only
+ * - USER_REQUESTED waits on its declared fields, or on the whole pass if none
+ * - LOAD_BALANCE drains the queue and is the only cross-rank barrier
+ * 
+ * Scoped barriers translate to clEnqueueMarkerWithWaitList so unrelated work
+ * keeps overlapping; LOAD_BALANCE uses clEnqueueBarrierWithWaitList.
  */
 class BarrierNode : public ExecutionNode {
 public:
@@ -31,15 +47,17 @@ private:
     // Barrier kind
     BarrierKind kind;
     
+    // Queue for marker/barrier commands (host-side wait if null)
+    cl_command_queue command_queue = nullptr;
+    
+    // Outstanding events of the current pass (bound by the scheduler)
+    const scheduler::ScopedEventTable* event_table = nullptr;
+    
 public:
-    BarrierNode(std::string name, BarrierKind barrier_kind, bool global = false)
-        : ExecutionNode(NodeType::BARRIER, std::move(name)),
-          is_global_barrier(global), kind(barrier_kind) {
-        setHaloDepth(0);
-        // Barriers have no field dependencies (explicit synchronization)
-    }
-    
-    // Override execution: enqueue barrier
+    // Only LOAD_BALANCE barriers may be global; other kinds are demoted to local
+    BarrierNode(std::string name, BarrierKind barrier_kind, bool global = false);
+    
+    // Override execution: enqueue scoped marker (or global barrier)
     cl_event execute(cl_event wait_event) override;
     
     // Visitor pattern
@@ -47,6 +65,17 @@ public:
     
     bool isGlobal() const { return is_global_barrier; }
     BarrierKind getKind() const { return kind; }
+    
+    void setQueue(cl_command_queue queue) { command_queue = queue; }
+    void bindEventTable(const scheduler::ScopedEventTable* table) { event_table = table; }
+    
+    /**
+     * @brief Events this barrier waits on, per its kind and declared scope
+     * @param wait_event Event passed in by the scheduler (may be null)
+     */
+    std::vector<cl_event> collectWaitList(cl_event wait_event) const;
+    
+    static const char* kindName(BarrierKind kind);
 };
 
 } // namespace nodes
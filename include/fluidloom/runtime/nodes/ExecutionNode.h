@@ -42,7 +42,30 @@ public:
         HALO_EXCHANGE,
         BARRIER,
         ADAPT_MESH,      // Placeholder for Module 11
-        FUSED_KERNEL     // Placeholder for Module 12
+        FUSED_KERNEL,    // Placeholder for Module 12
+        REBALANCE_MESH,
+        HOST_TASK
+    };
+    
+    // Profiler trace category of a node type, as read by the trace analyzer
+    static const char* traceCategory(NodeType type) {
+        switch (type) {
+            case NodeType::KERNEL:
+            case NodeType::FUSED_KERNEL: return "kernel";
+            case NodeType::HALO_EXCHANGE: return "halo";
+            case NodeType::BARRIER: return "barrier";
+            case NodeType::ADAPT_MESH: return "adapt";
+            case NodeType::REBALANCE_MESH: return "rebalance";
+            case NodeType::HOST_TASK: return "host";
+        }
+        return "default";
+    }
+    
+    // Where execute() does its work: DEVICE nodes enqueue commands and return
+    // an event; HOST nodes compute on the calling thread and return when done
+    enum class Affinity {
+        DEVICE,
+        HOST
     };
 
 protected:
@@ -94,6 +117,8 @@ public:
     const std::string& getName() const { return node_name; }
     NodeType getType() const { return node_type; }
     
+    virtual Affinity getAffinity() const { return Affinity::DEVICE; }
+    
     const std::vector<std::string>& getReadFields() const { return read_fields; }
     void setReadFields(std::vector<std::string> fields) { read_fields = std::move(fields); }
     
@@ -121,6 +146,12 @@ public:
         successors.push_back(succ);
     }
     
+    // Drop all edges before a graph is rebuilt over the same nodes
+    void clearEdges() {
+        predecessors.clear();
+        successors.clear();
+    }
+    
     // --- Virtual execution interface ---
     /**
      * @brief Execute this node and return completion event
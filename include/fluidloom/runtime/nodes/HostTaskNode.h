@@ -0,0 +1,40 @@
+#pragma once
+// Host-side work (I/O, diagnostics, geometry updates) scheduled in the DAG
+
+#include "fluidloom/runtime/nodes/ExecutionNode.h"
+#include <functional>
+
+namespace fluidloom {
+namespace runtime {
+namespace nodes {
+
+/**
+ * @brief Runs a host callable as a node of the dependency graph
+ * 
+ * Host tasks declare their read/write fields like any other node so hazard
+ * analysis orders them against kernels. Under WorkStealingExecutor they run
+ * on a pool thread once every predecessor has completed, overlapping with
+ * independent device work.
+ */
+class HostTaskNode : public ExecutionNode {
+public:
+    using Task = std::function<void()>;
+
+    HostTaskNode(std::string name, Task task)
+        : ExecutionNode(NodeType::HOST_TASK, std::move(name)), task(std::move(task)) {}
+    
+    Affinity getAffinity() const override { return Affinity::HOST; }
+    
+    // Waits on wait_event (if any), runs the task, returns nullptr
+    cl_event execute(cl_event wait_event) override;
+    
+    // Not yet part of the Visitor interface
+    void accept(Visitor& visitor) override { (void)visitor; }
+    
+private:
+    Task task;
+};
+
+} // namespace nodes
+} // namespace runtime
+} // namespace fluidloom
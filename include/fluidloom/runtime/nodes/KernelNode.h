@@ -2,6 +2,7 @@
 // @stable - Kernel execution node from DSL
 
 #include "fluidloom/runtime/nodes/ExecutionNode.h"
+#include "fluidloom/core/fields/FieldDescriptor.h"
 #include <unordered_map>
 
 // Forward declare OpenCL types
@@ -12,6 +13,7 @@ typedef struct _cl_device_id* cl_device_id;
 typedef struct _cl_command_queue* cl_command_queue;
 
 namespace fluidloom {
+namespace fields { class SOAFieldManager; }
 namespace runtime {
 namespace nodes {
 
@@ -37,8 +39,17 @@ private:
     size_t global_work_size = 0;
     size_t local_work_size = 256;  // Default, tunable
     
-    // Field buffer bindings (populated at launch)
-    std::unordered_map<std::string, cl_mem> field_bindings;
+    // Field buffer bindings. Managed bindings are resolved through the
+    // field manager at launch because adaptation reallocates field buffers.
+    struct FieldBinding {
+        cl_mem buffer = nullptr;
+        fields::SOAFieldManager* manager = nullptr;
+        fields::FieldHandle handle{0};
+    };
+    std::unordered_map<std::string, FieldBinding> field_bindings;
+    
+    // Live cell count; overrides global_work_size when bound
+    const size_t* cell_count = nullptr;
     
     // Kernel source (for Module 9, simplified)
     std::string kernel_source;
@@ -55,6 +66,10 @@ public:
     
     // Set field bindings before execution
     void bindField(const std::string& field_name, cl_mem buffer);
+    void bindField(const std::string& field_name, fields::SOAFieldManager* manager, fields::FieldHandle handle);
+    
+    // Size the launch from a cell count that changes under adaptation
+    void bindCellCount(const size_t* num_cells) { cell_count = num_cells; }
     
     // Override execution
     cl_event execute(cl_event wait_event) override;
@@ -1,8 +1,10 @@
 #pragma once
 
-#include "fluidloom/runtime/ExecutionNode.h"
+#include "fluidloom/runtime/nodes/ExecutionNode.h"
 #include "fluidloom/load_balance/LoadBalancer.h"
 #include "fluidloom/load_balance/CellMigrator.h"
+#include "fluidloom/core/hashmap/HashTableManager.h"
+#include "fluidloom/halo/GhostRangeBuilder.h"
 
 #ifdef __APPLE__
 #include <OpenCL/cl.h>
@@ -12,6 +14,7 @@
 
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace fluidloom {
 namespace runtime {
@@ -21,7 +24,16 @@ namespace nodes {
  * @brief Execution node for dynamic load rebalancing
  * 
  * Integrates LoadBalancer and CellMigrator to redistribute cells across GPUs
- * when load imbalance exceeds configured threshold.
+ * when load imbalance exceeds configured threshold and the planned migration
+ * pays for itself. The step times and adaptation churn behind that test are
+ * fed to the LoadBalancer through ExecutionGraph::setStepObserver and
+ * AdaptMeshNode::bindLoadBalancer; each migration run here updates its
+ * bandwidth estimate. A rejected plan restarts the minimum interval.
+ * 
+ * After a migration the spatial hash is patched with the migrator's delta
+ * (sent cells deleted, received/relocated cells upserted) and ghost ranges
+ * are refreshed only where split boundaries moved, exchanging them with SFC
+ * neighbors instead of all ranks.
  */
 class RebalanceMeshNode : public ExecutionNode {
 public:
@@ -49,6 +61,20 @@ public:
         size_t* num_cells, size_t* capacity
     );
     
+    /**
+     * @brief Bind the spatial index kept in sync after migration
+     * @param hash_manager Spatial hash to patch incrementally (may be null)
+     * @param ghost_builder Ghost range builder to refresh (may be null)
+     * @param cell_keys Host mirror of per-cell Hilbert keys (index = SOA slot)
+     * @param halo_depth Halo depth used when recomputing ghost candidates
+     */
+    void bindSpatialIndex(
+        hashmap::HashTableManager* hash_manager,
+        halo::GhostRangeBuilder* ghost_builder,
+        std::vector<uint64_t>* cell_keys,
+        int halo_depth = 1
+    );
+    
     /**
      * @brief Set current Hilbert range owned by this GPU
      */
@@ -64,6 +90,9 @@ public:
      */
     cl_event execute(cl_event wait_event) override;
     
+    // Not yet part of the Visitor interface
+    void accept(Visitor& visitor) override { (void)visitor; }
+    
 private:
     load_balance::LoadBalancer* m_balancer;
     load_balance::CellMigrator* m_migrator;
@@ -85,6 +114,19 @@ private:
     
     // Current split points (shared across all GPUs)
     std::vector<uint64_t> m_current_splits;
+    
+    // Spatial index refreshed after migration
+    hashmap::HashTableManager* m_hash_manager = nullptr;
+    halo::GhostRangeBuilder* m_ghost_builder = nullptr;
+    std::vector<uint64_t>* m_cell_keys = nullptr;
+    int m_halo_depth = 1;
+    
+    /**
+     * @brief Patch hash table and ghost ranges for the new partition
+     * @param new_splits Split points now in effect
+     * @param migrated True if this GPU sent or received cells
+     */
+    void refreshSpatialIndex(const std::vector<uint64_t>& new_splits, bool migrated);
 };
 
 } // namespace nodes
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "fluidloom/core/fields/FieldDescriptor.h"
+#include "fluidloom/runtime/nodes/ExecutionNode.h"
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fluidloom {
+namespace runtime {
+namespace plan {
+
+/**
+ * @brief One node of a compiled plan
+ *
+ * Carries everything needed to recreate the node without the DSL front end:
+ * hazard metadata, and for kernels the generated source, the field bound to
+ * each argument and (optionally) the device binary it compiled to.
+ */
+struct PlanNode {
+    nodes::ExecutionNode::NodeType type{nodes::ExecutionNode::NodeType::KERNEL};
+    std::string name;
+    int8_t level{-1};
+    uint8_t halo_depth{0};
+    std::vector<std::string> read_fields;
+    std::vector<std::string> write_fields;
+    std::string execution_mask;
+
+    // KERNEL: params are the fields bound to the leading arguments, in order
+    std::string kernel_source;
+    std::vector<std::string> params;
+    uint64_t global_work_size{0};
+    uint64_t local_work_size{0};
+
+    // Compiled program for `device_signature`; empty if only source is kept
+    std::string device_signature;
+    std::vector<uint8_t> binary;
+
+    // HALO_EXCHANGE: exchanged fields. BARRIER: BarrierNode::BarrierKind value
+    std::vector<std::string> halo_fields;
+    uint8_t barrier_kind{0};
+    bool global_barrier{false};
+};
+
+/**
+ * @brief Fully scheduled simulation, serializable for ahead-of-time startup
+ *
+ * Produced once by `fluidloom-parse --aot` and loaded by `fluidloom-run`,
+ * which then skips parsing, semantic analysis, hazard analysis and kernel
+ * generation. Edges are stored as indices into `nodes` (the graph's insertion
+ * order), so loading restores the exact DAG the analyzers produced.
+ *
+ * The file is little-endian: magic, format version, a length-prefixed payload
+ * and an FNV-1a checksum of the payload. Any version mismatch or corruption
+ * is rejected; plans are cheap to regenerate.
+ */
+struct SimulationPlan {
+    static constexpr uint32_t MAGIC = 0x4C50464C;  // "FLPL"
+    static constexpr uint32_t FORMAT_VERSION = 1;
+
+    uint64_t script_hash{0};  // FNV-1a of the .fl source the plan came from
+    uint64_t num_cells{0};
+    uint64_t capacity{0};
+
+    std::vector<fields::FieldDescriptor> fields;
+    std::vector<PlanNode> nodes;
+    std::vector<std::pair<uint32_t, uint32_t>> edges;  // (from, to)
+
+    /**
+     * @brief Write the plan to `path`
+     * @throws std::runtime_error if the file cannot be written
+     */
+    void save(const std::string& path) const;
+
+    /**
+     * @brief Read a plan written by save()
+     * @throws std::runtime_error on I/O errors, foreign files, other format
+     *         versions, truncation or checksum mismatch
+     */
+    static SimulationPlan load(const std::string& path);
+
+    // In-memory forms of save()/load()
+    std::string serialize() const;
+    static SimulationPlan deserialize(const std::string& bytes);
+
+    // True if `script_content` is the source this plan was compiled from
+    bool matchesScript(const std::string& script_content) const;
+
+    // Edge endpoints in range and no self-loops
+    bool validate() const;
+
+    // One line per node and a field/edge count, for `fluidloom-parse --dump-plan`
+    std::string describe() const;
+};
+
+} // namespace plan
+} // namespace runtime
+} // namespace fluidloom
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// Forward declare OpenCL types to avoid header pollution
+typedef struct _cl_event* cl_event;
+
+namespace fluidloom {
+namespace runtime {
+namespace scheduler {
+
+/**
+ * @brief Outstanding completion events indexed by field and AMR level
+ * 
+ * Filled by the scheduler as nodes execute so that barriers can wait on a
+ * scope (the events that accessed a set of fields, or one level's events)
+ * instead of draining the whole queue.
+ * 
+ * Non-owning: events stay owned by the scheduler for the current pass.
+ */
+class ScopedEventTable {
+private:
+    // Field name → last event that wrote it, and the events that read it
+    // since (a later write must wait on them too: write-after-read)
+    struct FieldEvents {
+        cl_event writer = nullptr;
+        std::vector<cl_event> readers;
+    };
+    std::unordered_map<std::string, FieldEvents> field_events;
+    
+    // AMR level → events of nodes at that level (level -1 = unleveled)
+    std::unordered_map<int8_t, std::vector<cl_event>> level_events;
+    
+    // Every recorded event, in execution order
+    std::vector<cl_event> all_events;
+    
+public:
+    /**
+     * @brief Record a node's completion event
+     * @param read_fields Fields read by the node
+     * @param write_fields Fields written by the node
+     * @param level AMR level of the node
+     * @param event Completion event (ignored if null)
+     */
+    void record(const std::vector<std::string>& read_fields, const std::vector<std::string>& write_fields,
+                int8_t level, cl_event event);
+    
+    /**
+     * @brief Last writers of the given fields and their readers since (deduplicated)
+     * 
+     * Everything a node accessing the fields must be ordered after,
+     * whether it reads them (RAW) or overwrites them (WAW, WAR).
+     */
+    std::vector<cl_event> eventsForFields(const std::vector<std::string>& fields) const;
+    
+    /**
+     * @brief Events recorded for one AMR level
+     */
+    std::vector<cl_event> eventsForLevel(int8_t level) const;
+    
+    /**
+     * @brief Every event recorded in this pass
+     */
+    const std::vector<cl_event>& allEvents() const { return all_events; }
+    
+    void clear();
+};
+
+} // namespace scheduler
+} // namespace runtime
+} // namespace fluidloom
@@ -2,6 +2,9 @@
 // @stable - Topological scheduler with Kahn's algorithm
 
 #include "fluidloom/runtime/dependency/DependencyGraph.h"
+#include <cstdint>
+#include <string>
+#include <unordered_set>
 #include <vector>
 #include <memory>
 
@@ -9,24 +12,56 @@ namespace fluidloom {
 namespace runtime {
 namespace scheduler {
 
+/**
+ * @brief What changed since the last execution
+ *
+ * Fields modified outside the graph (parameter update, geometry change)
+ * and nodes whose inputs or configuration changed (e.g. one level of a
+ * subcycle, an analysis branch).
+ */
+struct DirtySet {
+    std::unordered_set<std::string> fields;
+    std::unordered_set<int64_t> node_ids;
+    
+    bool empty() const { return fields.empty() && node_ids.empty(); }
+};
+
 /**
  * @brief Topological scheduler using Kahn's algorithm
  * 
  * Schedules execution nodes in dependency order, ensuring all
  * hazards are respected and maximum parallelism is achieved.
+ * 
+ * Completion events of the last run are kept per node so that
+ * executeIncremental() can re-run a dirty subgraph against them.
  */
 class TopologicalScheduler {
 private:
     // The dependency graph to schedule
     std::shared_ptr<dependency::DependencyGraph> graph;
     
+    // Completion event of each node's most recent run (indexed by graph
+    // position, retained until replaced)
+    std::vector<cl_event> cached_events;
+    bool has_run = false;
+    
     // Performance metrics
     double last_schedule_time_ms = 0.0;
+    size_t last_executed_count = 0;
+    
+    // Run the given nodes (in topological order), waiting on cached events
+    // of nodes outside the set
+    bool run(const std::vector<size_t>& node_indices);
     
 public:
     explicit TopologicalScheduler(std::shared_ptr<dependency::DependencyGraph> dep_graph)
         : graph(std::move(dep_graph)) {}
     
+    ~TopologicalScheduler();
+    
+    TopologicalScheduler(const TopologicalScheduler&) = delete;
+    TopologicalScheduler& operator=(const TopologicalScheduler&) = delete;
+    
     /**
      * @brief Execute all nodes in topological order
      * @return True if execution completed successfully
@@ -47,9 +82,40 @@ public:
     double getLastScheduleTime() const { return last_schedule_time_ms; }
     
     /**
-     * @brief Stub for incremental execution (Module 12)
+     * @brief Number of nodes launched by the last execute()/executeIncremental()
+     */
+    size_t getLastExecutedCount() const { return last_executed_count; }
+    
+    /**
+     * @brief Compute the nodes that must re-run after a change
+     * 
+     * A node is dirty if it is listed in the set, reads a dirty field, writes
+     * a field re-produced by a dirty node, or declares no fields and has a
+     * dirty predecessor (such nodes are fences whose effects are unknown).
+     * Fields in DirtySet::fields were set from outside and are treated as
+     * sources: their readers re-run, their pure writers do not.
+     * 
+     * A dirty node must see its inputs as they were when it last ran. If a
+     * later node overwrote one of them, the input's earlier writer re-runs
+     * as well, and with it the later writers; the set is closed over these
+     * hazards until it no longer grows.
+     * 
+     * @throws std::runtime_error if such an input has no earlier writer
+     * @return Node indices in topological order
+     */
+    std::vector<size_t> computeDirtyNodes(const DirtySet& dirty) const;
+    
+    /**
+     * @brief Re-run only the subgraph affected by a change
+     * 
+     * Clean nodes are not launched; dirty nodes wait on the cached events of
+     * their clean predecessors. Falls back to execute() if the graph has not
+     * run yet. Clean results are assumed to still be held in their fields,
+     * so the caller must not have overwritten them since the last run.
+     * 
+     * @return True if execution completed successfully
      */
-    bool executeIncremental(size_t start_idx, size_t end_idx);
+    bool executeIncremental(const DirtySet& dirty);
 };
 
 } // namespace scheduler
@@ -0,0 +1,183 @@
+#pragma once
+// CFL-driven adaptive time stepping across refinement levels
+
+#include "fluidloom/core/reduction/DeterministicReducer.h"
+#include "fluidloom/runtime/nodes/HostTaskNode.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fluidloom {
+namespace runtime {
+namespace timestep {
+
+/**
+ * @brief Stability bounds and scaling of the adaptive time step
+ *
+ * Level L has spacing dx0 / 2^L and runs subcycle_ratio^L substeps per
+ * coarse step, so dt_L = dt / subcycle_ratio^L. Velocities are in physical
+ * units; the CFL number of level L is max|u|_L · dt_L / dx_L.
+ */
+struct AdaptiveTimeStepConfig {
+    double dx0 = 1.0;               // Level-0 cell size
+    double viscosity = 0.0;         // Kinematic; 0 leaves tau at tau_min
+    uint32_t subcycle_ratio = 2;    // 2: convective scaling, 4: diffusive scaling
+    uint8_t max_level = 0;
+
+    double cfl_target = 0.1;        // Steered towards (lattice Mach ~0.17)
+    double cfl_max = 0.3;           // Stability limit; exceeding it is reported
+    double max_growth = 1.1;        // Per update; shrinking is never limited
+    double dt_min = 0.0;
+    double dt_max = 1.0e30;
+
+    // BGK relaxation time tau_L = 0.5 + 3 ν dt_L / dx_L² (lattice units)
+    double tau_min = 0.505;
+    double tau_max = 2.0;
+
+    uint32_t update_interval = 1;   // Steps between velocity reductions
+
+    void validate() const {
+        if (dx0 <= 0.0) throw std::invalid_argument("dx0 must be positive");
+        if (viscosity < 0.0) throw std::invalid_argument("viscosity must be non-negative");
+        if (subcycle_ratio < 1) throw std::invalid_argument("subcycle_ratio must be >= 1");
+        if (max_level > 8) throw std::invalid_argument("max_level exceeds MAX_REFINEMENT_LEVEL");
+        if (cfl_target <= 0.0 || cfl_target > cfl_max) {
+            throw std::invalid_argument("cfl_target must be in (0, cfl_max]");
+        }
+        if (max_growth < 1.0) throw std::invalid_argument("max_growth must be >= 1");
+        if (dt_min < 0.0 || dt_max <= dt_min) throw std::invalid_argument("need 0 <= dt_min < dt_max");
+        if (tau_min <= 0.5 || tau_max < tau_min) throw std::invalid_argument("need 0.5 < tau_min <= tau_max");
+        if (update_interval < 1) throw std::invalid_argument("update_interval must be >= 1");
+    }
+};
+
+/**
+ * @brief What bounded the latest time step
+ */
+enum class TimeStepLimit {
+    NONE,       // No velocity data yet
+    CFL,        // Steered to cfl_target
+    GROWTH,     // Wanted to grow faster than max_growth
+    TAU_MIN,    // Raised so the finest level keeps tau >= tau_min
+    TAU_MAX,    // Lowered so the coarsest level keeps tau <= tau_max
+    DT_MIN,
+    DT_MAX
+};
+
+const char* timeStepLimitName(TimeStepLimit limit);
+
+/**
+ * @brief Time step and per-level parameters in effect
+ */
+struct TimeStepState {
+    uint64_t updates = 0;
+    double dt = 0.0;                        // Level 0
+    TimeStepLimit limit = TimeStepLimit::NONE;
+    bool cfl_violated = false;              // Some level exceeded cfl_max at the old dt
+    bool tau_clamped = false;               // CFL and tau bounds conflict; tau left at its bound
+    std::vector<double> level_dt;
+    std::vector<double> level_tau;
+    std::vector<double> level_omega;        // 1 / tau
+    std::vector<double> level_cfl;          // At the new dt, from the latest reduction
+    std::vector<float> level_max_speed;     // Global max |u| per level
+};
+
+/**
+ * @brief Adapts Δt to the flow through a CFL condition on every level
+ *
+ * Each update reduces max|u| per level in one fused device launch
+ * (DeterministicReducer, one level-filtered MAX per level), posts a
+ * non-blocking MPI_MAX allreduce of those few floats and returns. The
+ * allreduce completes at the next update, so it overlaps a full step and the
+ * new Δt applies one step late; cfl_target sits below cfl_max to cover that
+ * lag. A spike shrinks Δt at once, calm flow grows it by at most max_growth
+ * per update. The BGK relaxation time of every level follows Δt and is held
+ * inside [tau_min, tau_max] by limiting Δt; when the CFL bound leaves no room
+ * for that, CFL wins and tau is clamped.
+ */
+class AdaptiveTimeStepController {
+public:
+    using UpdateCallback = std::function<void(const TimeStepState&)>;
+
+    // Velocity (SOA components) and per-cell levels of this rank's cells
+    struct VelocityInput {
+        reduction::FieldView velocity;
+        uint16_t num_components = 3;
+        const void* levels = nullptr;      // uint8 per cell; nullptr: all cells on level 0
+        size_t num_cells = 0;
+    };
+
+    AdaptiveTimeStepController(AdaptiveTimeStepConfig config, double initial_dt, IBackend* backend = nullptr);
+    ~AdaptiveTimeStepController();
+
+    AdaptiveTimeStepController(const AdaptiveTimeStepController&) = delete;
+    AdaptiveTimeStepController& operator=(const AdaptiveTimeStepController&) = delete;
+
+    /**
+     * @brief Reduce max|u| per level locally and post the cross-rank allreduce
+     *
+     * Completes a still-pending update first. Returns immediately after
+     * posting; call completeUpdate() one step later.
+     */
+    void beginUpdate(const VelocityInput& input);
+
+    /**
+     * @brief Finish the pending allreduce and apply the new Δt
+     * @return True if Δt changed
+     */
+    bool completeUpdate();
+
+    bool isPending() const;
+
+    /**
+     * @brief Called once per step: complete the previous update, begin the next
+     *
+     * Posts a reduction every config.update_interval steps.
+     */
+    bool step(const VelocityInput& input);
+
+    /**
+     * @brief Host task running step() with inputs fetched at execution time
+     *
+     * Place it after the kernels writing the velocity field: the node reads
+     * that field, so hazard analysis orders it correctly.
+     */
+    std::shared_ptr<nodes::HostTaskNode> createUpdateNode(const std::string& velocity_field,
+                                                          std::function<VelocityInput()> input);
+
+    /**
+     * @brief New state for the given global per-level max speeds (pure)
+     */
+    TimeStepState propose(const std::vector<float>& level_max_speed) const;
+
+    void setUpdateCallback(UpdateCallback callback) { m_callback = std::move(callback); }
+
+    const TimeStepState& getState() const { return m_state; }
+    const AdaptiveTimeStepConfig& getConfig() const { return m_config; }
+    double getDt() const { return m_state.dt; }
+    double getLevelDt(uint8_t level) const { return m_state.level_dt.at(level); }
+    double getLevelOmega(uint8_t level) const { return m_state.level_omega.at(level); }
+    uint32_t getSubsteps(uint8_t level) const;
+
+private:
+    struct PendingReduction;
+
+    AdaptiveTimeStepConfig m_config;
+    TimeStepState m_state;
+    reduction::DeterministicReducer m_reducer;
+    std::unique_ptr<PendingReduction> m_pending;
+    uint64_t m_steps = 0;
+    UpdateCallback m_callback;
+
+    size_t numLevels() const { return static_cast<size_t>(m_config.max_level) + 1; }
+    double levelScale(size_t level) const;  // dt_L / dx_L = dt · levelScale(L)
+    void fillLevels(TimeStepState& state) const;
+    bool apply(const std::vector<float>& level_max_speed);
+};
+
+} // namespace timestep
+} // namespace runtime
+} // namespace fluidloom
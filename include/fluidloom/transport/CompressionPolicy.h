@@ -0,0 +1,81 @@
+#pragma once
+
+#include "fluidloom/transport/PeerAccessManager.h"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+
+namespace fluidloom {
+namespace transport {
+
+/**
+ * @brief Decides per peer whether compressing a payload pays off
+ *
+ * A payload of B bytes costs latency + B / bandwidth on the wire, or
+ * encode(B) + decode(B) + latency + B / (ratio · bandwidth) compressed. The
+ * policy keeps running estimates of each peer's link (from setLinkProfile(),
+ * e.g. a PeerAccessManager profile or a configured cross-rack figure, refined
+ * by recordTransfer()), of the ratio that peer's payloads reach, and of codec
+ * throughput, and compresses only while the second cost is lower by
+ * min_speedup. Peers whose link was never measured are sent raw. While a
+ * peer is off, every probe_interval-th payload is compressed anyway so a
+ * change in compressibility is noticed.
+ */
+class CompressionPolicy {
+public:
+    struct Config {
+        bool enabled = false;
+        size_t min_payload_bytes = 16 * 1024;  // Smaller payloads are latency-bound
+        double min_speedup = 1.1;
+        uint32_t probe_interval = 32;
+        double smoothing = 0.25;                // Weight of a new sample in the running estimates
+        bool xor_delta = true;                  // Delta against the previous payload on the channel
+    };
+
+    struct PeerEstimate {
+        PeerAccessManager::LinkProfile link;    // bandwidth_gbps 0 until known
+        double ratio = 0.0;                     // raw / encoded; 0 until probed
+        uint64_t payloads = 0;
+        uint64_t compressed = 0;
+        bool compressing = false;
+    };
+
+    CompressionPolicy() = default;
+    explicit CompressionPolicy(const Config& config) : m_config(config) {}
+
+    const Config& getConfig() const { return m_config; }
+    bool enabled() const { return m_config.enabled; }
+
+    void setLinkProfile(int peer, const PeerAccessManager::LinkProfile& link);
+
+    // Measured wire time of `bytes` to the peer; refines the bandwidth estimate
+    void recordTransfer(int peer, size_t bytes, double seconds);
+
+    // Measured codec work on one payload
+    void recordEncode(int peer, size_t raw_bytes, size_t encoded_bytes, double seconds);
+    void recordDecode(size_t raw_bytes, double seconds);
+
+    /**
+     * @brief Whether to compress the next payload of raw_bytes to the peer
+     *
+     * Counts the payload; call once per message.
+     */
+    bool shouldCompress(int peer, size_t raw_bytes);
+
+    // Estimated microseconds for a payload raw and compressed
+    double rawCostUs(int peer, size_t raw_bytes) const;
+    double compressedCostUs(int peer, size_t raw_bytes) const;
+
+    PeerEstimate getEstimate(int peer) const;
+
+private:
+    Config m_config;
+    std::map<int, PeerEstimate> m_peers;
+    double m_encode_gbps = 0.0;     // Codec throughput over raw bytes; 0 until measured
+    double m_decode_gbps = 0.0;
+
+    double blend(double current, double sample) const;
+};
+
+} // namespace transport
+} // namespace fluidloom
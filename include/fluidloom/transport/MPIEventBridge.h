@@ -10,8 +10,10 @@
 #endif
 #include <thread>
 #include <atomic>
-#include <queue>
+#include <vector>
 #include <mutex>
+#include <chrono>
+#include <functional>
 #include <condition_variable>
 
 namespace fluidloom {
@@ -19,45 +21,131 @@ namespace transport {
 
 /**
  * @brief Bridges MPI_Request completion to cl_event for unified dependency chain
- * 
+ *
  * This class solves the **critical interop problem**: MPI and OpenCL have different
  * synchronization primitives. We need to wait for MPI_Isend/Irecv to complete
  * before launching unpack kernels.
- * 
+ *
  * Two strategies:
  * 1. **Polling**: Create a cl_event that polls MPI_Test in a separate thread
  * 2. **Native**: Use cl_event from clEnqueueCopyBuffer (P2P case)
- * 
+ *
  * The bridge ensures the EventChain from Module 7 can treat MPI completions
  * as regular cl_event dependencies.
+ *
+ * Progress engine: bridged requests are detached from their wrappers into one
+ * contiguous MPI_Request array owned by the polling thread, which drives the
+ * whole set with MPI_Testsome. After `spin_passes` empty passes it switches to
+ * MPI_Waitsome; slot 0 holds a self-addressed "doorbell" receive so that new
+ * submissions and shutdown can wake a blocked poller. Everything completed in
+ * one pass is signalled as a single batch outside the submission lock.
+ *
+ * The poller calls MPI concurrently with the submitting threads, so the
+ * bridge requires MPI_THREAD_MULTIPLE and throws std::runtime_error at
+ * construction (or the first submission, if MPI is not yet initialized)
+ * when MPI provides less.
  */
 class MPIEventBridge {
+public:
+    // Progress engine counters (read with getStats())
+    struct Stats {
+        uint64_t requests_bridged = 0;
+        uint64_t requests_completed = 0;
+        uint64_t testsome_calls = 0;
+        uint64_t waitsome_calls = 0;
+        uint64_t completion_batches = 0;
+        uint64_t max_batch_size = 0;
+        double total_latency_us = 0.0;  // Submission → signal, summed
+        double max_latency_us = 0.0;
+
+        double avgLatencyUs() const {
+            return requests_completed ? total_latency_us / requests_completed : 0.0;
+        }
+    };
+
 private:
+    using Clock = std::chrono::steady_clock;
+
+    // A bridged request awaiting completion
+    struct PendingCompletion {
+        MPIRequestWrapper* wrapper = nullptr;
+        cl_event user_event = nullptr;         // Bridge-owned reference (may be null)
+        std::function<void()> on_complete;     // Optional host-side notification
+        Clock::time_point submitted;
+    };
+
     IBackend* backend;
-    
+    cl_context context;  // Null for non-OpenCL backends (no user events)
+
     // Thread for polling MPI completions (if not using native events)
     std::thread polling_thread;
     std::atomic<bool> stop_polling;
-    std::queue<std::pair<MPIRequestWrapper*, cl_event>> pending_tests;
+
+    // Submission queue (guarded by queue_mutex, drained by the poller)
+    #ifdef FLUIDLOOM_MPI_ENABLED
+    std::vector<std::pair<MPI_Request, PendingCompletion>> incoming;
+    #endif
     std::mutex queue_mutex;
     std::condition_variable queue_cv;
-    
+
+    // Poller-owned active set: active_requests[i + 1] belongs to active_entries[i].
+    // Slot 0 is the doorbell receive.
+    #ifdef FLUIDLOOM_MPI_ENABLED
+    std::vector<MPI_Request> active_requests;
+    MPI_Comm doorbell_comm;
+    std::atomic<bool> thread_level_checked;
+    #endif
+    std::vector<PendingCompletion> active_entries;
+
+    // True while the poller is (about to be) blocked in MPI_Waitsome
+    std::atomic<bool> poller_blocking;
+
+    // Empty Testsome passes before falling back to MPI_Waitsome
+    std::atomic<uint32_t> spin_passes;
+
+    Stats stats;
+    mutable std::mutex stats_mutex;
+
 public:
     explicit MPIEventBridge(IBackend* backend);
     ~MPIEventBridge();
-    
-    // Create a cl_event that will be signaled when MPI request completes
+
+    // Create a cl_event that will be signaled when MPI request completes.
+    // For MPI requests the wrapper is detached; wait on the returned event
+    // (or on the wrapper, which now tracks the bridge's completion).
     cl_event bridgeMPIRequest(MPIRequestWrapper* request);
-    
+
+    // Invoke callback on the polling thread once the request completes.
+    // Works without an OpenCL context (Mock backend, latency measurement).
+    void notifyOnCompletion(MPIRequestWrapper* request, std::function<void()> callback);
+
     // Check if a request is complete (for polling)
     static bool isMPIComplete(MPIRequestWrapper* request);
-    
-    // Shutdown polling thread
+
+    // Number of empty MPI_Testsome passes before blocking in MPI_Waitsome
+    void setSpinPasses(uint32_t passes) { spin_passes = passes; }
+    uint32_t getSpinPasses() const { return spin_passes; }
+
+    Stats getStats() const;
+
+    // Shutdown polling thread (drains outstanding requests first)
     void shutdown();
-    
+
 private:
     // Polling loop thread function
     void pollingLoop();
+
+    // Queue a detached request for the poller
+    void submit(MPIRequestWrapper* request, cl_event user_event, std::function<void()> callback);
+
+    // Throw unless MPI provides MPI_THREAD_MULTIPLE (no-op before MPI_Init)
+    void checkThreadLevel();
+
+    // Wake the poller if it is blocked in MPI_Waitsome
+    void ringDoorbell();
+
+    // Signal one pass worth of completions
+    void signalBatch(std::vector<PendingCompletion>& batch);
 };
 
 } // namespace transport
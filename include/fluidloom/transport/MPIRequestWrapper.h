@@ -10,6 +10,9 @@
 #include <CL/cl.h>
 #endif
 #include "fluidloom/transport/GPUAwareBuffer.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 
 namespace fluidloom {
 namespace transport {
@@ -40,6 +43,13 @@ private:
     GPUAwareBuffer* buffer;
     GPUAwareBuffer* dst_buffer; // Optional secondary buffer (e.g., for P2P copy)
     
+    // Set when the native MPI_Request has been handed to MPIEventBridge.
+    // From then on the bridge drives progress and reports via markCompleted().
+    bool detached = false;
+    std::atomic<bool> detached_complete{false};
+    std::mutex detached_mutex;
+    std::condition_variable detached_cv;
+    
 public:
     // Constructor for MPI request
     #ifdef FLUIDLOOM_MPI_ENABLED
@@ -87,8 +97,30 @@ public:
     MPI_Request* getMPIRequest() { 
         return (type == RequestType::MPI) ? &mpi_request : nullptr; 
     }
+    
+    // Hand the native request to an external progress engine (MPIEventBridge).
+    // The wrapper's copy becomes MPI_REQUEST_NULL; wait()/test() then track
+    // the completion reported through markCompleted().
+    MPI_Request detachMPIRequest() {
+        MPI_Request req = mpi_request;
+        mpi_request = MPI_REQUEST_NULL;
+        detached = true;
+        return req;
+    }
     #endif
     
+    // Called by the progress engine once a detached request has completed.
+    // Nothing touches the wrapper after the notify, so a woken owner may
+    // destroy it.
+    void markCompleted() {
+        markUnbound();
+        std::lock_guard<std::mutex> lock(detached_mutex);
+        detached_complete.store(true, std::memory_order_release);
+        detached_cv.notify_all();
+    }
+    
+    bool isDetached() const { return detached; }
+    
     cl_event* getCLEvent() { 
         return (type == RequestType::CL_EVENT || type == RequestType::P2P) ? &cl_event_handle : nullptr; 
     }
@@ -44,6 +44,8 @@ private:
     bool gpu_aware_available;
     bool p2p_available;
     std::unique_ptr<PeerAccessManager> peer_manager;
+    cl_device_id local_device{nullptr};     // Null off the OpenCL backend
+    std::vector<cl_device_id> rank_devices; // Device of each rank on this node; null elsewhere
     
     // Outstanding requests (for waitall)
     std::vector<std::unique_ptr<MPIRequestWrapper>> active_requests;
@@ -113,6 +115,20 @@ public:
     TransportStats& getStats() { return stats; }
     void resetStats() { stats.reset(); }
     
+    // Probed link for traffic leaving this rank (the device's host link);
+    // zero bandwidth until the links are known
+    PeerAccessManager::LinkProfile getRemoteLinkProfile() const;
+    
+    // Copy method for `bytes` sent to `target_rank`: priced by the peer link
+    // matrix when the target's device is on this node, off-device otherwise
+    PeerAccessManager::CopyMethod getTransferMethod(int target_rank, size_t bytes) const;
+    
+    // Replace the probed topology (e.g. with a simulated link matrix in tests);
+    // devices_by_rank holds each rank's device, null for ranks on other nodes
+    void setPeerAccessManager(std::unique_ptr<PeerAccessManager> manager,
+                              cl_device_id device,
+                              std::vector<cl_device_id> devices_by_rank);
+    
     // Barrier (for testing synchronization)
     void barrier();
     
@@ -124,6 +140,12 @@ private:
     bool useP2P(int src_rank, int dst_rank) const;
     bool useGPUAwareMPI(int src_rank, int dst_rank) const;
     
+    // Helper: device of a rank on this node, or null
+    cl_device_id deviceOfRank(int rank) const;
+    
+    // Helper: learn which ranks share this node's devices (collective)
+    void mapRankDevices(const std::vector<cl_device_id>& node_devices);
+    
     // Helper: create MPI datatype for GPU-aware transfer
     #ifdef FLUIDLOOM_MPI_ENABLED
     MPI_Datatype createGPUAwareDatatype(size_t size_bytes);
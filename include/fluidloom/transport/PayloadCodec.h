@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace fluidloom {
+namespace transport {
+
+/**
+ * @brief Header of a compressed payload frame
+ *
+ *   [CodecFrameHeader][encoded_bytes bytes]
+ *
+ * The magic differs from every raw message format sent on the same tags,
+ * so a receiver can accept framed and raw messages on one channel.
+ */
+struct CodecFrameHeader {
+    uint32_t magic;             // PayloadCodec::MAGIC
+    uint16_t version;
+    uint16_t flags;             // PayloadCodec::Flag bits applied while encoding
+    uint64_t raw_bytes;
+    uint64_t encoded_bytes;     // Bytes after the header
+    uint32_t reference_tag;     // Tag of the XOR_DELTA reference payload
+    uint32_t checksum;          // PayloadCodec::checksum() of the raw payload
+};
+static_assert(sizeof(CodecFrameHeader) == 32, "CodecFrameHeader is a wire format");
+
+/**
+ * @brief Lossless compression of packed float payloads
+ *
+ * Encoding runs up to three stages, each recorded in the frame flags:
+ *   XOR_DELTA  XOR with the previous payload sent on the same channel, so
+ *              values that barely changed become mostly zero bits
+ *   SHUFFLE    byte-plane transpose of 4-byte words: sign/exponent bytes of
+ *              a smooth field end up next to each other and form long runs
+ *   LZ         byte-oriented LZ77 (LZ4-style tokens, 64 KiB window)
+ * A frame whose LZ stage does not shrink the data is stored with no stage
+ * applied, so the worst case is the header plus a copy.
+ */
+class PayloadCodec {
+public:
+    static constexpr uint32_t MAGIC = 0x5A434C46;  // "FLCZ"
+    static constexpr uint16_t VERSION = 1;
+
+    enum Flag : uint16_t {
+        XOR_DELTA = 1u << 0,
+        SHUFFLE = 1u << 1,
+        LZ = 1u << 2
+    };
+
+    // Frame size that always suffices for a raw payload of raw_bytes
+    static size_t maxFrameBytes(size_t raw_bytes) { return sizeof(CodecFrameHeader) + raw_bytes; }
+
+    static bool isFrame(const uint8_t* data, size_t size);
+
+    /**
+     * @brief Encode raw into a frame
+     * @param reference Payload of the same size to XOR against, or nullptr
+     * @param reference_tag Identifies reference to the decoder
+     * @param flags Stages to try; XOR_DELTA is dropped without a reference
+     */
+    static std::vector<uint8_t> encode(const uint8_t* raw, size_t raw_bytes,
+                                       const uint8_t* reference, uint32_t reference_tag,
+                                       uint16_t flags = XOR_DELTA | SHUFFLE | LZ);
+
+    /**
+     * @brief Decode a frame
+     * @param reference Payload the encoder XORed against; needed for XOR_DELTA frames
+     * @throws std::runtime_error for a malformed or corrupted frame, or a reference mismatch
+     */
+    static std::vector<uint8_t> decode(const uint8_t* frame, size_t frame_bytes,
+                                       const uint8_t* reference, size_t reference_bytes,
+                                       uint32_t reference_tag);
+
+    // Stages, exposed for tests and benchmarks
+    static void shuffle(const uint8_t* in, size_t size, uint8_t* out);
+    static void unshuffle(const uint8_t* in, size_t size, uint8_t* out);
+
+    // Returns the compressed size, or 0 if the output would not fit in capacity
+    static size_t lzCompress(const uint8_t* in, size_t size, uint8_t* out, size_t capacity);
+
+    // Returns the decompressed size; throws std::runtime_error for malformed input
+    static size_t lzDecompress(const uint8_t* in, size_t size, uint8_t* out, size_t capacity);
+
+    static uint32_t checksum(const uint8_t* data, size_t size);
+};
+
+} // namespace transport
+} // namespace fluidloom
@@ -5,6 +5,8 @@
 #else
 #include <CL/cl.h>
 #endif
+#include <cstddef>
+#include <string>
 #include <vector>
 #include <unordered_map>
 
@@ -13,14 +15,50 @@ namespace transport {
 
 /**
  * @brief Detects and manages PCIe peer access capabilities between GPU devices
- * 
+ *
  * This class runs once at initialization and builds a peer matrix:
  * peer_accessible[dev_a][dev_b] = true if clEnqueueCopyBuffer works without staging.
- * 
+ *
  * The detection is CRITICAL for performance: P2P copies can be 2-3x faster than
  * device->host->device staging.
+ *
+ * Alongside the boolean matrix the manager keeps a link-cost matrix (latency and
+ * sustained bandwidth per ordered device pair, plus each device's host link),
+ * probed with timed clEnqueueCopyBuffer micro-transfers and cached per host.
+ * getRoute() prices a transfer as latency + bytes / bandwidth per leg, so small
+ * halo messages take the lowest-latency path while bulk migration takes the
+ * highest-bandwidth one, which may relay through an intermediate device when
+ * the direct link is slow (e.g. across a PCIe root complex).
+ * getOptimalMethod() is the method of the first leg.
  */
 class PeerAccessManager {
+public:
+    enum class CopyMethod { P2P, GPU_AWARE_MPI, STAGING_HOST };
+
+    // Measured cost of one link; bandwidth 0 means the link is unusable
+    struct LinkProfile {
+        double latency_us = 0.0;
+        double bandwidth_gbps = 0.0;
+
+        bool usable() const { return bandwidth_gbps > 0.0; }
+        double costUs(size_t bytes) const {
+            return latency_us + static_cast<double>(bytes) / (bandwidth_gbps * 1e3);
+        }
+    };
+
+    // Square matrix indexed by device position; [i][i] is ignored
+    using LinkMatrix = std::vector<std::vector<LinkProfile>>;
+
+    // Chosen path for one transfer: legs[k] moves data hops[k] -> hops[k+1]
+    struct Route {
+        std::vector<cl_device_id> hops;
+        std::vector<CopyMethod> legs;
+        double estimated_us = 0.0;
+
+        bool isDirect() const { return legs.size() == 1; }
+        CopyMethod method() const { return legs.empty() ? CopyMethod::STAGING_HOST : legs.front(); }
+    };
+
 private:
     struct DevicePair {
         cl_device_id src;
@@ -29,35 +67,84 @@ private:
             return src == other.src && dst == other.dst;
         }
     };
-    
+
     struct DevicePairHash {
         size_t operator()(const DevicePair& dp) const noexcept {
             return std::hash<void*>{}(dp.src) ^ (std::hash<void*>{}(dp.dst) << 1);
         }
     };
-    
+
     std::unordered_map<DevicePair, bool, DevicePairHash> peer_matrix;
     std::vector<cl_device_id> devices;
-    
+    std::vector<std::string> device_ids;  // Name, driver and PCI location; keys the cache file
+
+    LinkMatrix p2p_links;
+    std::vector<LinkProfile> to_host_links;    // Device -> host (D2H)
+    std::vector<LinkProfile> from_host_links;  // Host -> device (H2D)
+
+    // Upper bound on legs per route (2 = at most one intermediate device)
+    size_t max_legs = 2;
+
 public:
     explicit PeerAccessManager(const std::vector<cl_device_id>& gpu_devices);
+
+    // Simulated topology (no OpenCL calls): for tests and for replaying a
+    // matrix probed elsewhere. Host links are symmetric here.
+    PeerAccessManager(const std::vector<cl_device_id>& gpu_devices,
+                      const LinkMatrix& links,
+                      const std::vector<LinkProfile>& host_links);
+
     ~PeerAccessManager() = default;
-    
+
     // Check if direct P2P copy is possible
     bool isPeerAccessible(cl_device_id src, cl_device_id dst) const;
-    
-    // Get optimal copy method for a transfer
-    enum class CopyMethod { P2P, GPU_AWARE_MPI, STAGING_HOST };
+
+    // Get optimal copy method for a transfer (size-agnostic; prices a typical halo message)
     CopyMethod getOptimalMethod(cl_device_id src, cl_device_id dst) const;
-    
+
+    // Get optimal copy method for the first leg of a transfer of `bytes`
+    CopyMethod getOptimalMethod(cl_device_id src, cl_device_id dst, size_t bytes) const;
+
+    // Cheapest route for a transfer of `bytes`, possibly via intermediate devices
+    Route getRoute(cl_device_id src, cl_device_id dst, size_t bytes) const;
+
+    // Link costs (zero-bandwidth profile for unknown devices or self)
+    LinkProfile getLinkProfile(cl_device_id src, cl_device_id dst) const;
+    LinkProfile getHostLinkProfile(cl_device_id device) const;
+
+    void setMaxLegs(size_t legs) { max_legs = legs < 1 ? 1 : legs; }
+    size_t getMaxLegs() const { return max_legs; }
+
+    // Persist / restore the link matrix. save writes a temporary file and
+    // renames it into place; load fails (returns false) when the file is
+    // missing or was written for a different device list or driver.
+    bool saveLinkMatrix(const std::string& path) const;
+    bool loadLinkMatrix(const std::string& path);
+
+    // Per-host cache file ($FL_PEER_CACHE_DIR or ~/.cache/fluidloom); empty if unavailable
+    static std::string defaultCachePath();
+
     // Initialize peer access (may require clEnqueueUnmapMemObject calls)
     cl_int enablePeerAccess(cl_device_id src, cl_device_id dst);
-    
+
     // Disable peer access (cleanup)
     void disablePeerAccess(cl_device_id src, cl_device_id dst);
-    
+
     // Debug output
     void printPeerMatrix() const;
+
+private:
+    int indexOf(cl_device_id device) const;
+
+    // Timed micro-transfers; fill p2p_links / host links for one entry
+    void probePair(size_t src, size_t dst);
+    void probeHostLink(size_t device);
+
+    // Cost of one direct leg i -> j and the method it would use
+    double legCostUs(size_t src, size_t dst, size_t bytes, CopyMethod* method) const;
+
+    // Name, driver version and PCI location of a device
+    static std::string deviceIdentity(cl_device_id device);
 };
 
 } // namespace transport
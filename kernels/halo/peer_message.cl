@@ -0,0 +1,130 @@
+// Pack and unpack of aggregated per-peer halo messages
+//
+// A message holds every halo value one rank sends one peer in an exchange
+// phase (see PeerMessage.h):
+//   [header][segment table][pad][payload]
+// One work-item handles one cell of one segment, i.e. all components of one
+// field at one ghost cell. Segments are found by binary search on cell_start,
+// so the whole message is packed, or unpacked, in a single launch.
+//
+// Field buffers are passed as up to MAX_FIELDS arguments; segments whose
+// field_slot is outside [first_slot, first_slot + MAX_FIELDS) are skipped and
+// handled by a further launch when more fields take part.
+
+#pragma OPENCL FP_CONTRACT OFF
+
+#define MAX_FIELDS 8
+
+// Mirrors PeerSegment (88 bytes)
+typedef struct {
+    ulong hilbert_start;
+    ulong hilbert_end;
+    uint field_id;
+    uint num_cells;
+    uint cell_start;
+    uint payload_offset;
+    ushort num_components;
+    uchar source_level;
+    uchar target_level;
+    uchar interpolation;
+    uchar sources_per_cell;
+    ushort reserved;
+    float weights[8];
+    uint index_offset;
+    uint field_slot;
+    ulong field_stride;
+} PeerSegment;
+
+// Last segment with cell_start <= cell
+uint find_segment(__global const PeerSegment* segments, uint num_segments, uint cell) {
+    uint lo = 0;
+    uint hi = num_segments;
+    while (hi - lo > 1) {
+        const uint mid = (lo + hi) / 2;
+        if (segments[mid].cell_start <= cell) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+__global float* select_field(uint slot,
+                             __global float* f0, __global float* f1, __global float* f2, __global float* f3,
+                             __global float* f4, __global float* f5, __global float* f6, __global float* f7) {
+    switch (slot) {
+        case 0: return f0;
+        case 1: return f1;
+        case 2: return f2;
+        case 3: return f3;
+        case 4: return f4;
+        case 5: return f5;
+        case 6: return f6;
+        default: return f7;
+    }
+}
+
+__kernel void pack_peer_message(
+    __global const PeerSegment* segments,   // Sender's own table (local tail valid)
+    const uint num_segments,
+    __global const uint* indices,           // Gather lists
+    __global float* message,
+    const uint payload_start,               // Header payload_offset in floats
+    const uint total_cells,
+    const uint first_slot,
+    __global float* f0, __global float* f1, __global float* f2, __global float* f3,
+    __global float* f4, __global float* f5, __global float* f6, __global float* f7
+) {
+    const uint gid = get_global_id(0);
+    if (gid >= total_cells) return;
+
+    __global const PeerSegment* seg = &segments[find_segment(segments, num_segments, gid)];
+    if (seg->field_slot < first_slot || seg->field_slot >= first_slot + MAX_FIELDS) return;
+
+    __global const float* field = select_field(seg->field_slot - first_slot, f0, f1, f2, f3, f4, f5, f6, f7);
+    const uint cell = gid - seg->cell_start;
+    const uint sources = seg->sources_per_cell;
+    __global const uint* gather = indices + seg->index_offset + cell * sources;
+
+    for (uint c = 0; c < seg->num_components; ++c) {
+        __global const float* component = field + c * seg->field_stride;
+        float value;
+        if (sources == 1) {
+            value = component[gather[0]];
+        } else {
+            value = 0.0f;
+            for (uint s = 0; s < sources; ++s) {
+                value += seg->weights[s] * component[gather[s]];
+            }
+        }
+        message[payload_start + seg->payload_offset + c * seg->num_cells + cell] = value;
+    }
+}
+
+__kernel void unpack_peer_message(
+    __global const PeerSegment* segments,   // Receiver's validated table
+    const uint num_segments,
+    __global const uint* indices,           // Scatter lists
+    __global const float* message,
+    const uint payload_start,
+    const uint total_cells,
+    const uint first_slot,
+    __global float* f0, __global float* f1, __global float* f2, __global float* f3,
+    __global float* f4, __global float* f5, __global float* f6, __global float* f7
+) {
+    const uint gid = get_global_id(0);
+    if (gid >= total_cells) return;
+
+    __global const PeerSegment* seg = &segments[find_segment(segments, num_segments, gid)];
+    if (seg->field_slot < first_slot || seg->field_slot >= first_slot + MAX_FIELDS) return;
+
+    __global float* field = select_field(seg->field_slot - first_slot, f0, f1, f2, f3, f4, f5, f6, f7);
+    const uint cell = gid - seg->cell_start;
+    const uint target = indices[seg->index_offset + cell];
+
+    for (uint c = 0; c < seg->num_components; ++c) {
+        field[c * seg->field_stride + target] =
+            message[payload_start + seg->payload_offset + c * seg->num_cells + cell];
+    }
+}
@@ -0,0 +1,99 @@
+// Fine→coarse restriction over PackBufferLayout data
+//
+// Buffers hold one plane of floats per field component; a plane is
+// `stride` floats long. One work-item handles one (coarse cell, plane) pair,
+// so every field of every averaging range is restricted in a single launch.
+
+#define UNUSED_INDEX 0xFFFFFFFFu
+
+__kernel void restrict_volume_average(
+    __global const float* fine_data,
+    __global float* coarse_data,
+    __global const uint* coarse_idx,    // [num_masks]
+    __global const uint* fine_idx,      // [num_masks * 8], UNUSED_INDEX if absent
+    const uint num_masks,
+    const uint num_planes,
+    const ulong fine_stride,
+    const ulong coarse_stride
+) {
+    const uint gid = get_global_id(0);
+    if (gid >= num_masks * num_planes) return;
+
+    const uint plane = gid / num_masks;
+    const uint mask = gid % num_masks;
+
+    __global const float* fine_plane = fine_data + plane * fine_stride;
+
+    float sum = 0.0f;
+    uint valid = 0;
+    for (uint k = 0; k < 8; ++k) {
+        const uint f = fine_idx[mask * 8 + k];
+        if (f != UNUSED_INDEX) {
+            sum += fine_plane[f];
+            ++valid;
+        }
+    }
+
+    if (valid > 0) {
+        coarse_data[plane * coarse_stride + coarse_idx[mask]] = sum / (float)valid;
+    }
+}
+
+// Neumaier summation: the compensation absorbs the low-order bits lost by sum
+inline void neumaier_add(float* sum, float* comp, const float value) {
+    const float t = *sum + value;
+    if (fabs(*sum) >= fabs(value)) {
+        *comp += (*sum - t) + value;
+    } else {
+        *comp += (value - t) + *sum;
+    }
+    *sum = t;
+}
+
+// Per-(plane, chunk) compensated totals of Σ fine and Σ coarse · n_valid.
+// partials[4 * gid] = {fine_sum, fine_comp, coarse_sum, coarse_comp}; the
+// host adds the few partials in double precision.
+__kernel void conservation_totals(
+    __global const float* fine_data,
+    __global const float* coarse_data,
+    __global const uint* coarse_idx,
+    __global const uint* fine_idx,
+    const uint num_masks,
+    const uint num_planes,
+    const ulong fine_stride,
+    const ulong coarse_stride,
+    const uint chunk_size,
+    __global float* partials
+) {
+    const uint gid = get_global_id(0);
+    const uint num_chunks = (num_masks + chunk_size - 1) / chunk_size;
+    if (gid >= num_chunks * num_planes) return;
+
+    const uint plane = gid / num_chunks;
+    const uint chunk = gid % num_chunks;
+    const uint begin = chunk * chunk_size;
+    const uint end = min(begin + chunk_size, num_masks);
+
+    __global const float* fine_plane = fine_data + plane * fine_stride;
+    __global const float* coarse_plane = coarse_data + plane * coarse_stride;
+
+    float fine_sum = 0.0f, fine_comp = 0.0f;
+    float coarse_sum = 0.0f, coarse_comp = 0.0f;
+
+    for (uint mask = begin; mask < end; ++mask) {
+        uint valid = 0;
+        for (uint k = 0; k < 8; ++k) {
+            const uint f = fine_idx[mask * 8 + k];
+            if (f != UNUSED_INDEX) {
+                neumaier_add(&fine_sum, &fine_comp, fine_plane[f]);
+                ++valid;
+            }
+        }
+        neumaier_add(&coarse_sum, &coarse_comp, coarse_plane[coarse_idx[mask]] * (float)valid);
+    }
+
+    partials[4 * gid + 0] = fine_sum;
+    partials[4 * gid + 1] = fine_comp;
+    partials[4 * gid + 2] = coarse_sum;
+    partials[4 * gid + 3] = coarse_comp;
+}
@@ -2,6 +2,7 @@
 // Open addressing with linear probing
 
 #define HASH_EMPTY_KEY 0xFFFFFFFFFFFFFFFFULL
+#define HASH_TOMBSTONE_KEY 0xFFFFFFFFFFFFFFFEULL  // Deleted slot, keep probing
 #define HASH_INVALID_VALUE 0xFFFFFFFFU
 #define MAX_PROBE_LIMIT 32
 
@@ -2,6 +2,7 @@
 // Device-side lookups for neighbor finding
 
 #define HASH_EMPTY_KEY 0xFFFFFFFFFFFFFFFFULL
+#define HASH_TOMBSTONE_KEY 0xFFFFFFFFFFFFFFFEULL  // Deleted slot, keep probing
 #define HASH_INVALID_VALUE 0xFFFFFFFFU
 #define MAX_PROBE_LIMIT 32
 
@@ -25,8 +26,8 @@ inline uint hash_query(
     ulong capacity,
     ulong query_key
 ) {
-    // Fast path for invalid keys
-    if (query_key == HASH_EMPTY_KEY) {
+    // Fast path for invalid keys (tombstones never match a live key)
+    if (query_key == HASH_EMPTY_KEY || query_key == HASH_TOMBSTONE_KEY) {
         return HASH_INVALID_VALUE;
     }
     
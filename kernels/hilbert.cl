@@ -128,3 +128,40 @@ __kernel void test_hilbert_decode(
     hilbert_decode_3d(hilbert_in[gid], level, &x, &y, &z);
     coords_out[gid] = (int3)(x, y, z);
 }
+
+// Batch encode for key generation (HilbertCodec encodeBatchDevice).
+// coords holds one int3 (16 bytes) per cell. When use_levels is set each cell
+// is encoded at its own level, otherwise at uniform_level.
+__kernel void hilbert_encode_batch(
+    __global const int3* restrict coords,
+    __global const uchar* restrict levels,
+    __global ulong* restrict keys_out,
+    const uint num_cells,
+    const uchar uniform_level,
+    const uint use_levels
+) {
+    uint gid = get_global_id(0);
+    if (gid >= num_cells) return;
+    
+    int3 coord = coords[gid];
+    uchar level = use_levels ? levels[gid] : uniform_level;
+    keys_out[gid] = hilbert_encode_3d(coord.x, coord.y, coord.z, level);
+}
+
+// Same, for structure-of-arrays coordinates (adaptation cell buffers)
+__kernel void hilbert_encode_batch_soa(
+    __global const int* restrict coord_x,
+    __global const int* restrict coord_y,
+    __global const int* restrict coord_z,
+    __global const uchar* restrict levels,
+    __global ulong* restrict keys_out,
+    const uint num_cells,
+    const uchar uniform_level,
+    const uint use_levels
+) {
+    uint gid = get_global_id(0);
+    if (gid >= num_cells) return;
+    
+    uchar level = use_levels ? levels[gid] : uniform_level;
+    keys_out[gid] = hilbert_encode_3d(coord_x[gid], coord_y[gid], coord_z[gid], level);
+}
@@ -0,0 +1,67 @@
+// Fills the holes left by migrated cells with surviving cells from the tail
+//
+// src[i] and dst[i] come from CellCompactor::plan: every source lies at or
+// above the new cell count and every destination below it, so no move reads
+// a slot another move writes and the moves run in any order. Elements are
+// copied as raw bytes, so one kernel serves coordinates, levels, states and
+// multi-component fields.
+
+__kernel void move_cells(
+    __global const uint* restrict src,
+    __global const uint* restrict dst,
+    __global uchar* data,
+    const uint elem_bytes,
+    const uint num_moves) {
+
+    const uint gid = get_global_id(0);
+    if (gid >= num_moves) return;
+
+    const size_t from = (size_t)src[gid] * elem_bytes;
+    const size_t to = (size_t)dst[gid] * elem_bytes;
+
+    // Word copies when every element starts 4-byte aligned
+    if ((elem_bytes & 3u) == 0) {
+        __global const uint* from_words = (__global const uint*)(data + from);
+        __global uint* to_words = (__global uint*)(data + to);
+        for (uint w = 0; w < elem_bytes / 4; ++w) {
+            to_words[w] = from_words[w];
+        }
+    } else {
+        for (uint b = 0; b < elem_bytes; ++b) {
+            data[to + b] = data[from + b];
+        }
+    }
+}
+
+// Packs the cells listed in indices into one plane of a migration message
+//
+// Cell indices[i] of data lands at packed + packed_offset + i * elem_bytes;
+// CellCompactor::gather runs it once per SOA array with consecutive offsets,
+// so a message holds one plane per array.
+
+__kernel void gather_cells(
+    __global const uint* restrict indices,
+    __global const uchar* restrict data,
+    __global uchar* restrict packed,
+    const uint elem_bytes,
+    const ulong packed_offset,
+    const uint num_cells) {
+
+    const uint gid = get_global_id(0);
+    if (gid >= num_cells) return;
+
+    const size_t from = (size_t)indices[gid] * elem_bytes;
+    const size_t to = (size_t)packed_offset + (size_t)gid * elem_bytes;
+
+    if ((elem_bytes & 3u) == 0 && (packed_offset & 3ul) == 0) {
+        __global const uint* from_words = (__global const uint*)(data + from);
+        __global uint* to_words = (__global uint*)(packed + to);
+        for (uint w = 0; w < elem_bytes / 4; ++w) {
+            to_words[w] = from_words[w];
+        }
+    } else {
+        for (uint b = 0; b < elem_bytes; ++b) {
+            packed[to + b] = data[from + b];
+        }
+    }
+}
@@ -0,0 +1,208 @@
+// Bitwise-reproducible fused reductions over SOA float fields
+//
+// Sums use the exact accumulator of ExactAccumulator.h: ACC_DIGITS 32-bit
+// digits held in longs, digit i weighing 2^(32i - ACC_BIAS). Integer addition
+// is associative, so totals do not depend on cell order, work-group count or
+// rank decomposition. MIN/MAX are exact as well; -0 is stored as +0 and NaN
+// is flagged rather than compared.
+//
+// Each work-item accumulates a grid-strided set of cells for every reduction,
+// then each work-group tree-reduces its work-items in a fixed pairing and
+// writes one ACC_WORDS record per reduction:
+//   partials[(group * num_reductions + r) * ACC_WORDS + w]
+//
+// Build with -cl-fp32-correctly-rounded-divide-sqrt so NORM matches the host.
+// Devices that flush float denormals differ from the host on subnormal terms
+// only; results stay reproducible on any one kind of device.
+
+#pragma OPENCL FP_CONTRACT OFF
+
+#define MAX_FUSED 8
+#define WG_SIZE 64
+#define ACC_DIGITS 11
+#define ACC_WORDS 12
+#define ACC_FLAGS ACC_DIGITS
+#define ACC_BIAS 160
+
+#define FLAG_NAN 1L
+#define FLAG_POS_INF 2L
+#define FLAG_NEG_INF 4L
+
+#define OP_SUM 0u
+#define OP_MIN 1u
+#define OP_MAX 2u
+
+#define TERM_VALUE 0u
+#define TERM_SQUARED_NORM 1u
+#define TERM_NORM 2u
+
+// Spec record: op, term, field, num_components, base offset, stride,
+// weight field (NO_WEIGHT if none), volume weighted, scale bits,
+// level filter (ALL_LEVELS if none), 2 spare
+#define SPEC_WORDS 12
+#define NO_WEIGHT 0xFFFFFFFFu
+#define ALL_LEVELS 0xFFFFFFFFu
+
+inline void acc_add(long* acc, const float value) {
+    const uint bits = as_uint(value);
+    const uint exponent = (bits >> 23) & 0xFFu;
+    const uint fraction = bits & 0x7FFFFFu;
+
+    if (exponent == 0xFFu) {
+        acc[ACC_FLAGS] |= fraction ? FLAG_NAN : ((bits >> 31) ? FLAG_NEG_INF : FLAG_POS_INF);
+        return;
+    }
+    if (exponent == 0u && fraction == 0u) {
+        return;
+    }
+
+    const ulong mantissa = exponent ? (ulong)(fraction | 0x800000u) : (ulong)fraction;
+    const int position = (exponent ? (int)exponent - 150 : -149) + ACC_BIAS;
+    const ulong shifted = mantissa << (position & 31);
+    const int digit = position >> 5;
+
+    const long lo = (long)(shifted & 0xFFFFFFFFUL);
+    const long hi = (long)(shifted >> 32);
+    if (bits >> 31) {
+        acc[digit] -= lo;
+        acc[digit + 1] -= hi;
+    } else {
+        acc[digit] += lo;
+        acc[digit + 1] += hi;
+    }
+}
+
+// Floor carries: digits below the top end up in [0, 2^32)
+inline void acc_normalize(long* acc) {
+    for (int i = 0; i < ACC_DIGITS - 1; ++i) {
+        const long carry = acc[i] >> 32;  // Arithmetic shift: floor division
+        acc[i] -= carry * 0x100000000L;
+        acc[i + 1] += carry;
+    }
+}
+
+inline void acc_normalize_local(__local long* acc) {
+    for (int i = 0; i < ACC_DIGITS - 1; ++i) {
+        const long carry = acc[i] >> 32;
+        acc[i] -= carry * 0x100000000L;
+        acc[i + 1] += carry;
+    }
+}
+
+// Mirrors cellTerm() in DeterministicReducer.cpp operation for operation
+inline float cell_term(
+    __global const uint* spec,
+    __global const float* in0,
+    __global const float* in1,
+    __global const float* in2,
+    __global const float* in3,
+    const uint cell,
+    const float volume
+) {
+    __global const float* inputs[4] = {in0, in1, in2, in3};
+    __global const float* base = inputs[spec[2]] + spec[4];
+    const uint term = spec[1];
+    const uint stride = spec[5];
+
+    float value;
+    if (term == TERM_VALUE) {
+        value = base[cell];
+    } else {
+        float c = base[cell];
+        float sq = c * c;
+        for (uint k = 1; k < spec[3]; ++k) {
+            c = base[k * stride + cell];
+            const float p = c * c;
+            sq = sq + p;
+        }
+        value = term == TERM_NORM ? sqrt(sq) : sq;
+    }
+
+    if (spec[6] != NO_WEIGHT) {
+        value = value * inputs[spec[6]][cell];
+    }
+    value = value * (spec[7] ? volume : 1.0f);
+    return value * as_float(spec[8]);
+}
+
+__kernel __attribute__((reqd_work_group_size(WG_SIZE, 1, 1)))
+void fused_reduce(
+    __global const float* in0,
+    __global const float* in1,
+    __global const float* in2,
+    __global const float* in3,
+    __global const uchar* levels,
+    const uint has_levels,
+    __global const uint* specs,       // [num_reductions * SPEC_WORDS]
+    const uint num_reductions,
+    const uint num_cells,
+    __global long* partials           // [num_groups * num_reductions * ACC_WORDS]
+) {
+    __local long scratch[WG_SIZE * ACC_WORDS];
+
+    const uint lid = get_local_id(0);
+    const uint gid = get_global_id(0);
+    const uint global_size = get_global_size(0);
+
+    long acc[MAX_FUSED * ACC_WORDS];
+    float extremum[MAX_FUSED];
+    for (uint r = 0; r < num_reductions; ++r) {
+        for (uint w = 0; w < ACC_WORDS; ++w) acc[r * ACC_WORDS + w] = 0;
+        extremum[r] = specs[r * SPEC_WORDS] == OP_MIN ? INFINITY : -INFINITY;
+    }
+
+    for (uint cell = gid; cell < num_cells; cell += global_size) {
+        // 8^-level is a power of two, so the weighting is exact
+        const float volume = has_levels ? as_float((uint)(127 - 3 * (int)levels[cell]) << 23) : 1.0f;
+        for (uint r = 0; r < num_reductions; ++r) {
+            __global const uint* spec = specs + r * SPEC_WORDS;
+            if (spec[9] != ALL_LEVELS && (uint)levels[cell] != spec[9]) continue;
+            const float value = cell_term(spec, in0, in1, in2, in3, cell, volume);
+            if (spec[0] == OP_SUM) {
+                acc_add(acc + r * ACC_WORDS, value);
+            } else if (isnan(value)) {
+                acc[r * ACC_WORDS + ACC_FLAGS] |= FLAG_NAN;
+            } else {
+                const float v = value + 0.0f;
+                extremum[r] = spec[0] == OP_MIN ? fmin(extremum[r], v) : fmax(extremum[r], v);
+            }
+        }
+    }
+
+    for (uint r = 0; r < num_reductions; ++r) {
+        const uint op = specs[r * SPEC_WORDS];
+        __local long* mine = scratch + lid * ACC_WORDS;
+
+        if (op == OP_SUM) {
+            acc_normalize(acc + r * ACC_WORDS);
+            for (uint w = 0; w < ACC_WORDS; ++w) mine[w] = acc[r * ACC_WORDS + w];
+        } else {
+            mine[0] = (long)as_uint(extremum[r]);
+            mine[ACC_FLAGS] = acc[r * ACC_WORDS + ACC_FLAGS];
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        // Fixed pairing: lid absorbs lid + s
+        for (uint s = WG_SIZE / 2; s > 0; s >>= 1) {
+            if (lid < s) {
+                __local const long* other = scratch + (lid + s) * ACC_WORDS;
+                if (op == OP_SUM) {
+                    for (uint w = 0; w < ACC_DIGITS; ++w) mine[w] += other[w];
+                    acc_normalize_local(mine);
+                } else {
+                    const float a = as_float((uint)mine[0]);
+                    const float b = as_float((uint)other[0]);
+                    mine[0] = (long)as_uint(op == OP_MIN ? fmin(a, b) : fmax(a, b));
+                }
+                mine[ACC_FLAGS] |= other[ACC_FLAGS];
+            }
+            barrier(CLK_LOCAL_MEM_FENCE);
+        }
+
+        if (lid == 0) {
+            __global long* out = partials + ((ulong)get_group_id(0) * num_reductions + r) * ACC_WORDS;
+            for (uint w = 0; w < ACC_WORDS; ++w) out[w] = scratch[w];
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+}
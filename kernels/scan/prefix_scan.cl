@@ -0,0 +1,169 @@
+// Reduce-then-scan exclusive prefix sum over uint
+//
+// The input is cut into tiles of TILE = WG_SIZE * ITEMS elements, one tile per
+// work-group. Three launches, each reading the input at most once:
+//   scan_reduce_tiles   tile_sums[t] = sum of tile t
+//   scan_tile_sums      one work-group scans tile_sums in place, carrying a
+//                       running total across chunks of TILE tile sums, and
+//                       stores the grand total in tile_sums[num_tiles]
+//   scan_tiles          each tile is scanned in local memory and offset by
+//                       its scanned tile sum
+// Work-groups never wait on each other, so the result is correct for any
+// number of groups without relying on forward-progress guarantees. Sums wrap
+// modulo 2^32. Input and output may be the same buffer.
+
+#define WG_SIZE 256
+#define ITEMS 4
+#define TILE (WG_SIZE * ITEMS)
+
+// Blelloch scan of one value per work-item; returns the work-item's exclusive
+// prefix and leaves the group total in *total
+inline uint group_exclusive_scan(const uint value, __local uint* scratch, uint* total) {
+    const uint lid = get_local_id(0);
+    scratch[lid] = value;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    // Up-sweep
+    for (uint stride = 1; stride < WG_SIZE; stride <<= 1) {
+        const uint index = (lid + 1) * stride * 2 - 1;
+        if (index < WG_SIZE) {
+            scratch[index] += scratch[index - stride];
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    *total = scratch[WG_SIZE - 1];
+    barrier(CLK_LOCAL_MEM_FENCE);
+    if (lid == WG_SIZE - 1) {
+        scratch[lid] = 0;
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    // Down-sweep
+    for (uint stride = WG_SIZE / 2; stride > 0; stride >>= 1) {
+        const uint index = (lid + 1) * stride * 2 - 1;
+        if (index < WG_SIZE) {
+            const uint left = scratch[index - stride];
+            scratch[index - stride] = scratch[index];
+            scratch[index] += left;
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    const uint prefix = scratch[lid];
+    barrier(CLK_LOCAL_MEM_FENCE);  // scratch may be reused right after
+    return prefix;
+}
+
+// Exclusive scan of count (<= TILE) elements held in tile[], in place;
+// returns the sum of the elements
+inline uint scan_local_tile(__local uint* tile, const uint count, __local uint* scratch) {
+    const uint lid = get_local_id(0);
+    const uint first = lid * ITEMS;
+
+    // Each work-item owns ITEMS consecutive elements
+    uint items[ITEMS];
+    uint sum = 0;
+    for (uint k = 0; k < ITEMS; ++k) {
+        items[k] = (first + k < count) ? tile[first + k] : 0u;
+        sum += items[k];
+    }
+
+    uint total;
+    uint running = group_exclusive_scan(sum, scratch, &total);
+    for (uint k = 0; k < ITEMS; ++k) {
+        if (first + k < count) {
+            tile[first + k] = running;
+        }
+        running += items[k];
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+    return total;
+}
+
+__kernel void scan_reduce_tiles(
+    __global const uint* restrict input,
+    __global uint* restrict tile_sums,
+    const uint n) {
+
+    __local uint scratch[WG_SIZE];
+    const uint lid = get_local_id(0);
+    const uint tile_start = get_group_id(0) * TILE;
+
+    // Coalesced strided loads; integer sums do not depend on order
+    uint sum = 0;
+    for (uint k = 0; k < ITEMS; ++k) {
+        const uint i = tile_start + k * WG_SIZE + lid;
+        if (i < n) {
+            sum += input[i];
+        }
+    }
+
+    scratch[lid] = sum;
+    barrier(CLK_LOCAL_MEM_FENCE);
+    for (uint stride = WG_SIZE / 2; stride > 0; stride >>= 1) {
+        if (lid < stride) {
+            scratch[lid] += scratch[lid + stride];
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+    if (lid == 0) {
+        tile_sums[get_group_id(0)] = scratch[0];
+    }
+}
+
+// Launched as a single work-group of WG_SIZE
+__kernel void scan_tile_sums(
+    __global uint* restrict tile_sums,
+    const uint num_tiles) {
+
+    __local uint tile[TILE];
+    __local uint scratch[WG_SIZE];
+    const uint lid = get_local_id(0);
+
+    uint carry = 0;
+    for (uint chunk = 0; chunk < num_tiles; chunk += TILE) {
+        const uint count = min((uint)TILE, num_tiles - chunk);
+        for (uint k = lid; k < count; k += WG_SIZE) {
+            tile[k] = tile_sums[chunk + k];
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        const uint chunk_total = scan_local_tile(tile, count, scratch);
+
+        for (uint k = lid; k < count; k += WG_SIZE) {
+            tile_sums[chunk + k] = tile[k] + carry;
+        }
+        carry += chunk_total;
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    if (lid == 0) {
+        tile_sums[num_tiles] = carry;
+    }
+}
+
+__kernel void scan_tiles(
+    __global const uint* input,     // May alias output
+    __global uint* output,
+    __global const uint* restrict tile_sums,
+    const uint n) {
+
+    __local uint tile[TILE];
+    __local uint scratch[WG_SIZE];
+    const uint lid = get_local_id(0);
+    const uint tile_start = get_group_id(0) * TILE;
+    const uint count = min((uint)TILE, n - tile_start);
+
+    for (uint k = lid; k < count; k += WG_SIZE) {
+        tile[k] = input[tile_start + k];
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    scan_local_tile(tile, count, scratch);
+
+    const uint offset = tile_sums[get_group_id(0)];
+    for (uint k = lid; k < count; k += WG_SIZE) {
+        output[tile_start + k] = tile[k] + offset;
+    }
+}
@@ -1,5 +1,6 @@
 #include "fluidloom/adaptation/AdaptationEngine.h"
 #include "fluidloom/adaptation/CellDescriptor.h"
+#include "fluidloom/adaptation/FieldAveragingRules.h"
 #include "fluidloom/common/FluidLoomError.h"
 #include "fluidloom/common/Logger.h"
 #include <algorithm>
@@ -12,24 +13,28 @@ namespace adaptation {
 
 AdaptationEngine::AdaptationEngine(cl_context context, cl_command_queue queue, const AdaptationConfig& config)
     : m_context(context), m_queue(queue), m_config(config),
+      m_field_scratch(nullptr), m_field_scratch_bytes(0),
+      m_counts(nullptr), m_counts_size(0),
       m_compaction_program(nullptr),
-      m_kernel_mark_valid(nullptr), m_kernel_scan_local(nullptr),
-      m_kernel_scan_add_sums(nullptr), m_kernel_compact(nullptr), m_kernel_append(nullptr) {
+      m_kernel_mark_valid(nullptr), m_kernel_compact(nullptr),
+      m_kernel_compact_records(nullptr), m_kernel_gather_records(nullptr) {
     
     m_split_engine = std::make_unique<SplitEngine>(context, queue, config);
     m_merge_engine = std::make_unique<MergeEngine>(context, queue, config);
     m_balance_enforcer = std::make_unique<BalanceEnforcer>(context, queue, config);
     
     compileCompactionKernels();
+    m_scan = std::make_unique<scan::PrefixScan>(context, queue);
 }
 
 AdaptationEngine::~AdaptationEngine() {
     if (m_kernel_mark_valid) clReleaseKernel(m_kernel_mark_valid);
-    if (m_kernel_scan_local) clReleaseKernel(m_kernel_scan_local);
-    if (m_kernel_scan_add_sums) clReleaseKernel(m_kernel_scan_add_sums);
     if (m_kernel_compact) clReleaseKernel(m_kernel_compact);
-    if (m_kernel_append) clReleaseKernel(m_kernel_append);
+    if (m_kernel_compact_records) clReleaseKernel(m_kernel_compact_records);
+    if (m_kernel_gather_records) clReleaseKernel(m_kernel_gather_records);
     if (m_compaction_program) clReleaseProgram(m_compaction_program);
+    if (m_field_scratch) clReleaseMemObject(m_field_scratch);
+    if (m_counts) clReleaseMemObject(m_counts);
 }
 
 
@@ -41,275 +46,166 @@ cl_event AdaptationEngine::adapt(
     cl_mem* material_id,
     size_t* num_cells,
     size_t* capacity,
-    cl_mem* fields,
-    uint32_t num_field_components
+    const std::vector<cl_mem*>& fields,
+    uint32_t num_field_components,
+    cl_event wait_event
 ) {
-    cl_int err;
-    
-    // 1. Enforce 2:1 Balance
-    if (m_config.enforce_2_1_balance) {
-        BalanceResult balance_res = m_balance_enforcer->enforce(
-            *coord_x, *coord_y, *coord_z, *levels, *cell_states, *refine_flags, *num_cells
-        );
-        if (!balance_res.converged) {
-            FL_LOG(WARN) << "Balance enforcement did not converge in " << balance_res.iterations << " iterations";
-        }
+    std::vector<FieldTarget> targets;
+    for (size_t i = 0; i < fields.size(); ++i) {
+        if (!fields[i] || !*fields[i] || num_field_components == 0) continue;
+        FieldTarget target;
+        target.name = "field" + std::to_string(i);
+        target.record_bytes = num_field_components * sizeof(float);
+        target.float_components = num_field_components;
+        target.source = *fields[i];
+        target.owned = fields[i];
+        targets.push_back(target);
     }
     
-    // 2. Split Cells
-    SplitResult split_res = m_split_engine->split(
-        *coord_x, *coord_y, *coord_z, *levels, *cell_states, *refine_flags, *material_id, *num_cells,
-        fields ? *fields : nullptr, num_field_components
-    );
-    
-    // 3. Merge Cells
-    MergeResult merge_res = m_merge_engine->merge(
-        *coord_x, *coord_y, *coord_z, *levels, *cell_states, *refine_flags, *material_id, *num_cells,
-        fields ? *fields : nullptr, num_field_components
-    );
-    
-    // If no changes, return early
-    if (split_res.num_children == 0 && merge_res.num_parents_created == 0) {
-        // Create a user event to signal completion
-        cl_event event = clCreateUserEvent(m_context, &err);
-        clSetUserEventStatus(event, CL_COMPLETE);
-        return event;
-    }
-    
-    // 4. Compact and Rebuild
-    // 4. Compact and Rebuild
-    // 4. Compact and Rebuild (GPU)
-    compactAndRebuildGPU(
-        split_res, merge_res,
-        coord_x, coord_y, coord_z, levels, cell_states, refine_flags, material_id, num_cells, capacity,
-        fields, num_field_components
-    );
-    
-    // Check if we need to resize buffers (already handled in compactAndRebuild if needed, but we might want to grow proactively)
-    // Actually compactAndRebuild handles it now.
-    
-    // Check if we need to resize buffers
-    if (*num_cells > *capacity) {
-        size_t new_capacity = static_cast<size_t>(*num_cells * m_config.buffer_growth_factor);
-        resizeBuffers(new_capacity, coord_x, coord_y, coord_z, levels, cell_states, refine_flags, material_id, fields, num_field_components);
-        *capacity = new_capacity;
+    return runAdaptation(coord_x, coord_y, coord_z, levels, cell_states, refine_flags, material_id,
+                         num_cells, capacity, targets, nullptr, wait_event);
+}
+
+cl_event AdaptationEngine::adapt(
+    cl_mem* coord_x, cl_mem* coord_y, cl_mem* coord_z,
+    cl_mem* levels, cl_mem* cell_states,
+    cl_mem* refine_flags,
+    cl_mem* material_id,
+    size_t* num_cells,
+    size_t* capacity,
+    fields::SOAFieldManager& field_manager,
+    const std::vector<fields::FieldHandle>& fields,
+    cl_event wait_event
+) {
+    std::vector<FieldTarget> targets;
+    for (const auto& handle : fields) {
+        const auto& desc = field_manager.getDescriptor(handle);
+        FieldTarget target;
+        target.name = desc.name;
+        target.record_bytes = desc.bytesPerCell();
+        target.float_components = desc.type == fields::FieldType::FLOAT32 ? desc.num_components : 0;
+        target.source = static_cast<cl_mem>(field_manager.getDevicePtr(handle));
+        target.handle = handle;
+        targets.push_back(target);
     }
     
-    // Create completion event
-    cl_event event = clCreateUserEvent(m_context, &err);
-    clSetUserEventStatus(event, CL_COMPLETE);
-    return event;
+    return runAdaptation(coord_x, coord_y, coord_z, levels, cell_states, refine_flags, material_id,
+                         num_cells, capacity, targets, &field_manager, wait_event);
 }
 
-void AdaptationEngine::compactAndRebuild(
-    const SplitResult& split_res,
-    const MergeResult& merge_res,
+cl_event AdaptationEngine::runAdaptation(
     cl_mem* coord_x, cl_mem* coord_y, cl_mem* coord_z,
     cl_mem* levels, cl_mem* cell_states,
     cl_mem* refine_flags,
     cl_mem* material_id,
     size_t* num_cells,
     size_t* capacity,
-    cl_mem* fields,
-    uint32_t num_field_components
+    std::vector<FieldTarget>& fields,
+    fields::SOAFieldManager* field_manager,
+    cl_event wait_event
 ) {
-    // Host-side rebuild for now
-    size_t old_count = *num_cells;
-    
-    // Read old buffers
-    std::vector<int> h_x(old_count), h_y(old_count), h_z(old_count);
-    std::vector<uint8_t> h_levels(old_count), h_states(old_count);
-    std::vector<int> h_flags(old_count);
-    std::vector<uint32_t> h_mat(old_count);
-    std::vector<float> h_fields;
-    
-    clEnqueueReadBuffer(m_queue, *coord_x, CL_TRUE, 0, old_count * sizeof(int), h_x.data(), 0, nullptr, nullptr);
-    clEnqueueReadBuffer(m_queue, *coord_y, CL_TRUE, 0, old_count * sizeof(int), h_y.data(), 0, nullptr, nullptr);
-    clEnqueueReadBuffer(m_queue, *coord_z, CL_TRUE, 0, old_count * sizeof(int), h_z.data(), 0, nullptr, nullptr);
-    clEnqueueReadBuffer(m_queue, *levels, CL_TRUE, 0, old_count * sizeof(uint8_t), h_levels.data(), 0, nullptr, nullptr);
-    clEnqueueReadBuffer(m_queue, *cell_states, CL_TRUE, 0, old_count * sizeof(uint8_t), h_states.data(), 0, nullptr, nullptr);
-    clEnqueueReadBuffer(m_queue, *refine_flags, CL_TRUE, 0, old_count * sizeof(int), h_flags.data(), 0, nullptr, nullptr);
-    clEnqueueReadBuffer(m_queue, *material_id, CL_TRUE, 0, old_count * sizeof(uint32_t), h_mat.data(), 0, nullptr, nullptr);
+    cl_int err;
     
-    if (fields && *fields && num_field_components > 0) {
-        h_fields.resize(old_count * num_field_components);
-        clEnqueueReadBuffer(m_queue, *fields, CL_TRUE, 0, h_fields.size() * sizeof(float), h_fields.data(), 0, nullptr, nullptr);
+    // 0. Order every phase after the producer of the mesh state on the device
+    if (wait_event) {
+        err = clEnqueueBarrierWithWaitList(m_queue, 1, &wait_event, nullptr);
+        if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to enqueue adaptation wait barrier");
     }
     
-    // Build new list
-    std::vector<CellDescriptor> new_cells;
-    std::vector<float> new_fields;
-    new_cells.reserve(old_count + split_res.num_children); // Estimate
-    
-    // 1. Add surviving old cells
-    for (size_t i = 0; i < old_count; ++i) {
-        bool is_split = (i < split_res.parent_to_child_map.size()) && (split_res.parent_to_child_map[i] != 0xFFFFFFFF);
-        bool is_merged = (merge_res.merged_child_indices.count(i) > 0);
-        
-        if (!is_split && !is_merged) {
-            CellDescriptor cell;
-            cell.x = h_x[i]; cell.y = h_y[i]; cell.z = h_z[i];
-            cell.level = h_levels[i]; cell.state = h_states[i]; cell.material_id = h_mat[i];
-            cell.visited = 0; cell.reserved = 0;
-            new_cells.push_back(cell);
-            
-            if (!h_fields.empty()) {
-                for (uint32_t c = 0; c < num_field_components; ++c) {
-                    new_fields.push_back(h_fields[i * num_field_components + c]);
-                }
-            }
+    const size_t current_cells = *num_cells;
+    m_last_cells_changed = 0;
+    
+    // Count buffer: the balance iterations' counts, then the count slots
+    const size_t balance_counts = m_config.enforce_2_1_balance ? m_balance_enforcer->numCounts() : 0;
+    const size_t counts_size = balance_counts + NUM_COUNT_SLOTS;
+    if (counts_size > m_counts_size) {
+        if (m_counts) clReleaseMemObject(m_counts);
+        m_counts = clCreateBuffer(m_context, CL_MEM_READ_WRITE, counts_size * sizeof(uint32_t), nullptr, &err);
+        if (err != CL_SUCCESS) {
+            m_counts = nullptr;
+            m_counts_size = 0;
+            FL_THROW_OPENCL(err, "Failed to allocate adaptation counts");
         }
+        m_counts_size = counts_size;
     }
     
-    // 2. Add new children from splits
-    // We need to read children from SplitResult (Wait, SplitResult has vector<CellDescriptor> children)
-    // But we also need fields. SplitEngine interpolates fields to a buffer, but we didn't capture it in SplitResult struct.
-    // I noted this TODO in SplitEngine.cpp.
-    // For now, I'll assume fields are lost for new children or I need to re-interpolate here on host.
-    // Re-interpolating on host is safer for now.
-    
-    for (size_t i = 0; i < split_res.split_parent_indices.size(); ++i) {
-        uint32_t parent_idx = split_res.split_parent_indices[i];
-        uint32_t child_start = split_res.parent_to_child_map[parent_idx];
+    if (current_cells > 0) {
+        // 1. Enforce 2:1 Balance
+        if (m_config.enforce_2_1_balance) {
+            m_balance_enforcer->enforce(
+                *coord_x, *coord_y, *coord_z, *levels, *cell_states, *refine_flags, current_cells, m_counts
+            );
+        }
         
-        for (size_t c = 0; c < 8; ++c) {
-            const CellDescriptor& child = split_res.children[child_start + c];
-            new_cells.push_back(child);
-            
-            if (!h_fields.empty()) {
-                // Copy parent fields to child (simple interpolation)
-                for (uint32_t comp = 0; comp < num_field_components; ++comp) {
-                    new_fields.push_back(h_fields[parent_idx * num_field_components + comp]);
-                }
-            }
+        // 2. Count children and find merge groups; the totals stay on the device
+        m_split_engine->countChildren(*levels, *refine_flags, *cell_states, current_cells,
+                                      m_counts, balance_counts + COUNT_CHILDREN);
+        m_merge_engine->findGroups(*coord_x, *coord_y, *coord_z, *levels, *cell_states, *refine_flags,
+                                   current_cells, m_counts, balance_counts + COUNT_PARENTS);
+        
+        // 3. Survivor mask and compacted write offsets
+        cl_mem valid_flags = clCreateBuffer(m_context, CL_MEM_READ_WRITE, current_cells * sizeof(uint32_t), nullptr, &err);
+        if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to allocate survivor mask");
+        cl_mem scan_offsets = clCreateBuffer(m_context, CL_MEM_READ_WRITE, current_cells * sizeof(uint32_t), nullptr, &err);
+        if (err != CL_SUCCESS) {
+            clReleaseMemObject(valid_flags);
+            FL_THROW_OPENCL(err, "Failed to allocate survivor offsets");
         }
-    }
-    
-    // 3. Add new parents from merges
-    // MergeEngine computes averaged fields into a buffer, but we didn't capture it in MergeResult struct.
-    // Same issue. I'll re-average on host.
-    
-    for (size_t i = 0; i < merge_res.parents.size(); ++i) {
-        new_cells.push_back(merge_res.parents[i]);
         
-        if (!h_fields.empty()) {
-            // Use averaged fields from MergeResult
-            if (merge_res.averaged_fields.size() >= (i + 1) * num_field_components) {
-                for (uint32_t comp = 0; comp < num_field_components; ++comp) {
-                    new_fields.push_back(merge_res.averaged_fields[i * num_field_components + comp]);
-                }
-            } else {
-                // Fallback (should not happen if MergeEngine works)
-                for (uint32_t comp = 0; comp < num_field_components; ++comp) {
-                    new_fields.push_back(0.0f); 
-                }
-            }
+        cl_mem child_counts = m_split_engine->getChildCounts();
+        cl_mem group_ids = m_merge_engine->getGroupIds();
+        uint32_t current_cells_uint = static_cast<uint32_t>(current_cells);
+        clSetKernelArg(m_kernel_mark_valid, 0, sizeof(cl_mem), &child_counts);
+        clSetKernelArg(m_kernel_mark_valid, 1, sizeof(cl_mem), &group_ids);
+        clSetKernelArg(m_kernel_mark_valid, 2, sizeof(cl_mem), &valid_flags);
+        clSetKernelArg(m_kernel_mark_valid, 3, sizeof(uint32_t), &current_cells_uint);
+        
+        size_t local_size = 256;
+        size_t global_size = ((current_cells + local_size - 1) / local_size) * local_size;
+        err = clEnqueueNDRangeKernel(m_queue, m_kernel_mark_valid, 1, nullptr, &global_size, &local_size, 0, nullptr, nullptr);
+        if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to enqueue survivor mask kernel");
+        
+        m_scan->exclusiveScan(valid_flags, scan_offsets, current_cells, m_counts, balance_counts + COUNT_SURVIVORS);
+        
+        // 4. The adaptation's one host synchronization: every count at once
+        std::vector<uint32_t> counts(counts_size);
+        err = clEnqueueReadBuffer(m_queue, m_counts, CL_TRUE, 0, counts_size * sizeof(uint32_t), counts.data(), 0, nullptr, nullptr);
+        if (err != CL_SUCCESS) {
+            clReleaseMemObject(valid_flags);
+            clReleaseMemObject(scan_offsets);
+            FL_THROW_OPENCL(err, "Failed to read adaptation counts");
         }
-    }
-    
-    // 4. Sort by Hilbert index
-    // We need to sort `new_cells` and permute `new_fields` accordingly.
-    std::vector<size_t> p(new_cells.size());
-    for (size_t i = 0; i < p.size(); ++i) p[i] = i;
-    
-    std::sort(p.begin(), p.end(), [&](size_t a, size_t b) {
-        return new_cells[a].getHilbert() < new_cells[b].getHilbert();
-    });
-    
-    // Apply permutation
-    std::vector<CellDescriptor> sorted_cells(new_cells.size());
-    std::vector<float> sorted_fields;
-    if (!new_fields.empty()) sorted_fields.resize(new_fields.size());
-    
-    for (size_t i = 0; i < new_cells.size(); ++i) {
-        sorted_cells[i] = new_cells[p[i]];
-        if (!new_fields.empty()) {
-            for (uint32_t c = 0; c < num_field_components; ++c) {
-                sorted_fields[i * num_field_components + c] = new_fields[p[i] * num_field_components + c];
+        
+        if (m_config.enforce_2_1_balance) {
+            BalanceResult balance_res = m_balance_enforcer->summarize(counts.data());
+            if (!balance_res.converged) {
+                FL_LOG(WARN) << "Balance enforcement did not converge in " << balance_res.iterations << " iterations";
             }
         }
+        
+        const size_t num_children = counts[balance_counts + COUNT_CHILDREN];
+        const size_t num_parents = counts[balance_counts + COUNT_PARENTS];
+        const size_t num_survivors = counts[balance_counts + COUNT_SURVIVORS];
+        m_last_cells_changed = num_children + num_parents;
+        
+        // 5. Rebuild with the new children and parents, and remap fields (GPU)
+        if (num_children > 0 || num_parents > 0) {
+            compactAndRebuildGPU(
+                valid_flags, scan_offsets, num_survivors, num_children, num_parents,
+                coord_x, coord_y, coord_z, levels, cell_states, refine_flags, material_id, num_cells, capacity,
+                fields, field_manager
+            );
+        }
+        
+        clReleaseMemObject(valid_flags);
+        clReleaseMemObject(scan_offsets);
     }
     
-    // 5. Write back to buffers
-    *num_cells = sorted_cells.size();
-    
-    // Check capacity and resize if needed
-    if (*num_cells > *capacity) {
-        size_t new_capacity = std::max(static_cast<size_t>(*num_cells * m_config.buffer_growth_factor), *num_cells + 1024);
-        resizeBuffers(new_capacity, coord_x, coord_y, coord_z, levels, cell_states, refine_flags, material_id, fields, num_field_components);
-        *capacity = new_capacity;
-    }
-    
-    // Unpack to host vectors
-    std::vector<int> out_x(sorted_cells.size()), out_y(sorted_cells.size()), out_z(sorted_cells.size());
-    std::vector<uint8_t> out_levels(sorted_cells.size()), out_states(sorted_cells.size());
-    std::vector<int> out_flags(sorted_cells.size(), 0); // Reset flags
-    std::vector<uint32_t> out_mat(sorted_cells.size());
-    
-    for (size_t i = 0; i < sorted_cells.size(); ++i) {
-        out_x[i] = sorted_cells[i].x;
-        out_y[i] = sorted_cells[i].y;
-        out_z[i] = sorted_cells[i].z;
-        out_levels[i] = sorted_cells[i].level;
-        out_states[i] = sorted_cells[i].state;
-        out_mat[i] = sorted_cells[i].material_id;
-    }
-    
-    // Write to GPU
-    // We blindly write. If buffer is too small, this is bad.
-    // I'll update `adapt` to resize if needed BEFORE calling `compactAndRebuild`?
-    // No, we don't know new size until we build it.
-    // So `compactAndRebuild` should handle resizing.
-    // I'll modify `compactAndRebuild` signature to take `capacity` pointer.
-    
-    clEnqueueWriteBuffer(m_queue, *coord_x, CL_TRUE, 0, out_x.size() * sizeof(int), out_x.data(), 0, nullptr, nullptr);
-    clEnqueueWriteBuffer(m_queue, *coord_y, CL_TRUE, 0, out_y.size() * sizeof(int), out_y.data(), 0, nullptr, nullptr);
-    clEnqueueWriteBuffer(m_queue, *coord_z, CL_TRUE, 0, out_z.size() * sizeof(int), out_z.data(), 0, nullptr, nullptr);
-    clEnqueueWriteBuffer(m_queue, *levels, CL_TRUE, 0, out_levels.size() * sizeof(uint8_t), out_levels.data(), 0, nullptr, nullptr);
-    clEnqueueWriteBuffer(m_queue, *cell_states, CL_TRUE, 0, out_states.size() * sizeof(uint8_t), out_states.data(), 0, nullptr, nullptr);
-    clEnqueueWriteBuffer(m_queue, *refine_flags, CL_TRUE, 0, out_flags.size() * sizeof(int), out_flags.data(), 0, nullptr, nullptr);
-    clEnqueueWriteBuffer(m_queue, *material_id, CL_TRUE, 0, out_mat.size() * sizeof(uint32_t), out_mat.data(), 0, nullptr, nullptr);
-    
-    if (!sorted_fields.empty()) {
-        clEnqueueWriteBuffer(m_queue, *fields, CL_TRUE, 0, sorted_fields.size() * sizeof(float), sorted_fields.data(), 0, nullptr, nullptr);
-    }
-}
-
-void AdaptationEngine::resizeBuffers(
-    size_t new_capacity,
-    cl_mem* coord_x, cl_mem* coord_y, cl_mem* coord_z,
-    cl_mem* levels, cl_mem* cell_states,
-    cl_mem* refine_flags,
-    cl_mem* material_id,
-    cl_mem* fields,
-    uint32_t num_field_components
-) {
-    // Reallocate buffers with new capacity
-    // Note: This destroys content if we don't copy.
-    // But we usually resize when we have data on host ready to write, or we copy device-to-device.
-    // Here, `adapt` calls `resizeBuffers` after `compactAndRebuild`?
-    // If `compactAndRebuild` writes to buffers, they must be large enough.
-    // So `compactAndRebuild` must resize if needed.
-    // I'll implement resize logic inside `compactAndRebuild` or helper.
-    
-    cl_int err;
-    // Helper to resize one buffer
-    auto resize = [&](cl_mem* buf, size_t size) {
-        if (*buf) clReleaseMemObject(*buf);
-        *buf = clCreateBuffer(m_context, CL_MEM_READ_WRITE, size, nullptr, &err);
-    };
-    
-    resize(coord_x, new_capacity * sizeof(int));
-    resize(coord_y, new_capacity * sizeof(int));
-    resize(coord_z, new_capacity * sizeof(int));
-    resize(levels, new_capacity * sizeof(uint8_t));
-    resize(cell_states, new_capacity * sizeof(uint8_t));
-    resize(refine_flags, new_capacity * sizeof(int));
-    resize(material_id, new_capacity * sizeof(uint32_t));
-    
-    if (fields && *fields) {
-        resize(fields, new_capacity * num_field_components * sizeof(float));
-    }
+    // Completes once everything above has executed (in-order queue)
+    cl_event event = nullptr;
+    err = clEnqueueMarkerWithWaitList(m_queue, 0, nullptr, &event);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to enqueue adaptation completion marker");
+    return event;
 }
 
 void AdaptationEngine::compileCompactionKernels() {
@@ -340,10 +236,9 @@ void AdaptationEngine::compileCompactionKernels() {
     }
     
     m_kernel_mark_valid = clCreateKernel(m_compaction_program, "mark_valid_cells", &err);
-    m_kernel_scan_local = clCreateKernel(m_compaction_program, "scan_local", &err);
-    m_kernel_scan_add_sums = clCreateKernel(m_compaction_program, "scan_add_sums", &err);
     m_kernel_compact = clCreateKernel(m_compaction_program, "compact_cells", &err);
-    m_kernel_append = clCreateKernel(m_compaction_program, "append_cells", &err);
+    m_kernel_compact_records = clCreateKernel(m_compaction_program, "compact_records", &err);
+    m_kernel_gather_records = clCreateKernel(m_compaction_program, "gather_records", &err);
 }
 
 std::string AdaptationEngine::loadKernelSource(const std::string& filename) {
@@ -357,140 +252,45 @@ std::string AdaptationEngine::loadKernelSource(const std::string& filename) {
     return buffer.str();
 }
 
-void AdaptationEngine::exclusiveScan(cl_mem input, cl_mem output, uint32_t num_elements, uint32_t* total_sum) {
-    cl_int err;
-    size_t local_size = 256;
-    size_t num_groups = (num_elements + local_size - 1) / local_size;
-    
-    // Allocate block sums
-    cl_mem block_sums = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_groups * sizeof(uint32_t), nullptr, &err);
-    
-    // Phase 1: Local scan
-    clSetKernelArg(m_kernel_scan_local, 0, sizeof(cl_mem), &input);
-    clSetKernelArg(m_kernel_scan_local, 1, sizeof(cl_mem), &output);
-    clSetKernelArg(m_kernel_scan_local, 2, sizeof(cl_mem), &block_sums);
-    clSetKernelArg(m_kernel_scan_local, 3, sizeof(uint32_t), &num_elements);
-    clSetKernelArg(m_kernel_scan_local, 4, local_size * sizeof(uint32_t), nullptr); // Shared mem
-    
-    size_t global_size = num_groups * local_size;
-    err = clEnqueueNDRangeKernel(m_queue, m_kernel_scan_local, 1, nullptr, &global_size, &local_size, 0, nullptr, nullptr);
-    
-    // Phase 2: Scan block sums (recursive if needed, but for now assume num_groups < 256*256)
-    // If num_groups is small (<= 256), we can just scan it with one group.
-    if (num_groups > 1) {
-        cl_mem block_sums_scanned = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_groups * sizeof(uint32_t), nullptr, &err);
-        
-        clSetKernelArg(m_kernel_scan_local, 0, sizeof(cl_mem), &block_sums);
-        clSetKernelArg(m_kernel_scan_local, 1, sizeof(cl_mem), &block_sums_scanned);
-        clSetKernelArg(m_kernel_scan_local, 2, sizeof(cl_mem), nullptr); // No higher level sums
-        clSetKernelArg(m_kernel_scan_local, 3, sizeof(uint32_t), &num_groups);
-        clSetKernelArg(m_kernel_scan_local, 4, local_size * sizeof(uint32_t), nullptr);
-        
-        size_t scan_global = ((num_groups + local_size - 1) / local_size) * local_size;
-        err = clEnqueueNDRangeKernel(m_queue, m_kernel_scan_local, 1, nullptr, &scan_global, &local_size, 0, nullptr, nullptr);
-        
-        // Phase 3: Add block sums back
-        clSetKernelArg(m_kernel_scan_add_sums, 0, sizeof(cl_mem), &output);
-        clSetKernelArg(m_kernel_scan_add_sums, 1, sizeof(cl_mem), &block_sums_scanned);
-        clSetKernelArg(m_kernel_scan_add_sums, 2, sizeof(uint32_t), &num_elements);
-        
-        err = clEnqueueNDRangeKernel(m_queue, m_kernel_scan_add_sums, 1, nullptr, &global_size, &local_size, 0, nullptr, nullptr);
-        
-        clReleaseMemObject(block_sums_scanned);
-    }
-    
-    // Read total sum (last element of output + last element of input)
-    // Or just read the last block sum?
-    // Actually, exclusive scan result at [N] is the sum.
-    // But we don't have [N] in output buffer usually (size N).
-    // We can read output[N-1] + input[N-1].
-    if (total_sum) {
-        uint32_t last_val = 0, last_in = 0;
-        clEnqueueReadBuffer(m_queue, output, CL_TRUE, (num_elements - 1) * sizeof(uint32_t), sizeof(uint32_t), &last_val, 0, nullptr, nullptr);
-        clEnqueueReadBuffer(m_queue, input, CL_TRUE, (num_elements - 1) * sizeof(uint32_t), sizeof(uint32_t), &last_in, 0, nullptr, nullptr);
-        *total_sum = last_val + last_in;
-    }
-    
-    clReleaseMemObject(block_sums);
-}
-
 void AdaptationEngine::compactAndRebuildGPU(
-    const SplitResult& split_res,
-    const MergeResult& merge_res,
+    cl_mem valid_flags,
+    cl_mem scan_offsets,
+    size_t num_survivors,
+    size_t num_children,
+    size_t num_parents,
     cl_mem* coord_x, cl_mem* coord_y, cl_mem* coord_z,
     cl_mem* levels, cl_mem* cell_states,
     cl_mem* refine_flags,
     cl_mem* material_id,
     size_t* num_cells,
     size_t* capacity,
-    cl_mem* fields,
-    uint32_t num_field_components
+    std::vector<FieldTarget>& fields,
+    fields::SOAFieldManager* field_manager
 ) {
     cl_int err;
     size_t current_cells = *num_cells;
+    size_t total_new_cells = num_survivors + num_children + num_parents;
     
-    // 1. Mark valid cells
-    cl_mem valid_flags = clCreateBuffer(m_context, CL_MEM_READ_WRITE, current_cells * sizeof(uint32_t), nullptr, &err);
-    
-    // We need merge_group_id to know if a cell merged.
-    // But MergeResult doesn't give us the buffer, only a set of indices on host.
-    // This is a bottleneck. We should have kept the buffer on GPU.
-    // For now, we'll upload the set as a boolean mask.
-    // TODO: Optimize by keeping merge_group_id on GPU in MergeEngine.
-    
-    std::vector<uint32_t> h_merge_ids(current_cells, 0xFFFFFFFF);
-    for (size_t idx : merge_res.merged_child_indices) {
-        h_merge_ids[idx] = 1; // Just mark as "merging"
-    }
-    cl_mem merge_group_id = clCreateBuffer(m_context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, current_cells * sizeof(uint32_t), h_merge_ids.data(), &err);
-    
-    clSetKernelArg(m_kernel_mark_valid, 0, sizeof(cl_mem), refine_flags);
-    clSetKernelArg(m_kernel_mark_valid, 1, sizeof(cl_mem), cell_states);
-    clSetKernelArg(m_kernel_mark_valid, 2, sizeof(cl_mem), &merge_group_id);
-    clSetKernelArg(m_kernel_mark_valid, 3, sizeof(cl_mem), &valid_flags);
-    clSetKernelArg(m_kernel_mark_valid, 4, sizeof(uint32_t), &current_cells);
-    
-    size_t global_size = ((current_cells + 255) / 256) * 256;
-    size_t local_size = 256;
-    clEnqueueNDRangeKernel(m_queue, m_kernel_mark_valid, 1, nullptr, &global_size, &local_size, 0, nullptr, nullptr);
-    
-    // 2. Scan valid flags to get write offsets
-    cl_mem scan_offsets = clCreateBuffer(m_context, CL_MEM_READ_WRITE, current_cells * sizeof(uint32_t), nullptr, &err);
-    uint32_t num_survivors = 0;
-    exclusiveScan(valid_flags, scan_offsets, current_cells, &num_survivors);
-    
-    // 3. Calculate total new size
-    size_t num_new_children = split_res.children.size(); // Wait, split_res.children is host vector.
-    // SplitEngine output is on GPU? No, SplitResult has `children` vector.
-    // SplitEngine.cpp:208 reads back children to host.
-    // This is another bottleneck. We should keep children on GPU.
-    // But for now, we have them on host.
-    // We need to upload them to append.
-    
-    size_t num_new_parents = merge_res.parents.size();
-    size_t total_new_cells = num_survivors + num_new_children + num_new_parents;
-    
-    // 4. Resize if needed
-    if (total_new_cells > *capacity) {
-        size_t new_capacity = std::max(static_cast<size_t>(total_new_cells * m_config.buffer_growth_factor), total_new_cells + 1024);
-        resizeBuffers(new_capacity, coord_x, coord_y, coord_z, levels, cell_states, refine_flags, material_id, fields, num_field_components);
-        *capacity = new_capacity;
+    // 1. Grow capacity if needed; the rebuilt buffers are allocated at capacity
+    size_t new_capacity = *capacity;
+    if (total_new_cells > new_capacity) {
+        new_capacity = std::max(static_cast<size_t>(total_new_cells * m_config.buffer_growth_factor), total_new_cells + 1024);
     }
     
-    // 5. Compact survivors to a temporary buffer (or directly to new buffer if we double buffer)
-    // Since we resized (maybe), we can't easily double buffer in-place.
-    // We need temp buffers for the survivors.
-    
-    cl_mem new_x = clCreateBuffer(m_context, CL_MEM_READ_WRITE, total_new_cells * sizeof(int), nullptr, &err);
-    cl_mem new_y = clCreateBuffer(m_context, CL_MEM_READ_WRITE, total_new_cells * sizeof(int), nullptr, &err);
-    cl_mem new_z = clCreateBuffer(m_context, CL_MEM_READ_WRITE, total_new_cells * sizeof(int), nullptr, &err);
-    cl_mem new_l = clCreateBuffer(m_context, CL_MEM_READ_WRITE, total_new_cells * sizeof(uint8_t), nullptr, &err);
-    cl_mem new_s = clCreateBuffer(m_context, CL_MEM_READ_WRITE, total_new_cells * sizeof(uint8_t), nullptr, &err);
-    cl_mem new_m = clCreateBuffer(m_context, CL_MEM_READ_WRITE, total_new_cells * sizeof(uint32_t), nullptr, &err);
-    cl_mem new_f = nullptr;
-    if (fields && *fields) {
-        new_f = clCreateBuffer(m_context, CL_MEM_READ_WRITE, total_new_cells * num_field_components * sizeof(float), nullptr, &err);
-    }
+    // 2. Compact survivors into the new buffers
+    cl_mem new_x = clCreateBuffer(m_context, CL_MEM_READ_WRITE, new_capacity * sizeof(int), nullptr, &err);
+    cl_mem new_y = clCreateBuffer(m_context, CL_MEM_READ_WRITE, new_capacity * sizeof(int), nullptr, &err);
+    cl_mem new_z = clCreateBuffer(m_context, CL_MEM_READ_WRITE, new_capacity * sizeof(int), nullptr, &err);
+    cl_mem new_l = clCreateBuffer(m_context, CL_MEM_READ_WRITE, new_capacity * sizeof(uint8_t), nullptr, &err);
+    cl_mem new_s = clCreateBuffer(m_context, CL_MEM_READ_WRITE, new_capacity * sizeof(uint8_t), nullptr, &err);
+    cl_mem new_m = clCreateBuffer(m_context, CL_MEM_READ_WRITE, new_capacity * sizeof(uint32_t), nullptr, &err);
+    cl_mem new_flags = clCreateBuffer(m_context, CL_MEM_READ_WRITE, new_capacity * sizeof(int), nullptr, &err);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to allocate rebuilt mesh buffers");
+    
+    // Mesh kernels no longer carry fields; remapFields() handles every field
+    cl_mem no_fields = nullptr;
+    uint32_t no_components = 0;
+    uint32_t current_cells_uint = static_cast<uint32_t>(current_cells);
     
     clSetKernelArg(m_kernel_compact, 0, sizeof(cl_mem), coord_x);
     clSetKernelArg(m_kernel_compact, 1, sizeof(cl_mem), coord_y);
@@ -498,7 +298,7 @@ void AdaptationEngine::compactAndRebuildGPU(
     clSetKernelArg(m_kernel_compact, 3, sizeof(cl_mem), levels);
     clSetKernelArg(m_kernel_compact, 4, sizeof(cl_mem), cell_states);
     clSetKernelArg(m_kernel_compact, 5, sizeof(cl_mem), material_id);
-    clSetKernelArg(m_kernel_compact, 6, sizeof(cl_mem), fields);
+    clSetKernelArg(m_kernel_compact, 6, sizeof(cl_mem), &no_fields);
     clSetKernelArg(m_kernel_compact, 7, sizeof(cl_mem), &valid_flags);
     clSetKernelArg(m_kernel_compact, 8, sizeof(cl_mem), &scan_offsets);
     clSetKernelArg(m_kernel_compact, 9, sizeof(cl_mem), &new_x);
@@ -507,152 +307,208 @@ void AdaptationEngine::compactAndRebuildGPU(
     clSetKernelArg(m_kernel_compact, 12, sizeof(cl_mem), &new_l);
     clSetKernelArg(m_kernel_compact, 13, sizeof(cl_mem), &new_s);
     clSetKernelArg(m_kernel_compact, 14, sizeof(cl_mem), &new_m);
-    clSetKernelArg(m_kernel_compact, 15, sizeof(cl_mem), &new_f);
-    clSetKernelArg(m_kernel_compact, 16, sizeof(uint32_t), &current_cells);
-    clSetKernelArg(m_kernel_compact, 17, sizeof(uint32_t), &num_field_components);
+    clSetKernelArg(m_kernel_compact, 15, sizeof(cl_mem), &no_fields);
+    clSetKernelArg(m_kernel_compact, 16, sizeof(uint32_t), &current_cells_uint);
+    clSetKernelArg(m_kernel_compact, 17, sizeof(uint32_t), &no_components);
     
-    clEnqueueNDRangeKernel(m_queue, m_kernel_compact, 1, nullptr, &global_size, &local_size, 0, nullptr, nullptr);
+    size_t local_size = 256;
+    size_t global_size = ((current_cells + local_size - 1) / local_size) * local_size;
+    err = clEnqueueNDRangeKernel(m_queue, m_kernel_compact, 1, nullptr, &global_size, &local_size, 0, nullptr, nullptr);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to enqueue compaction kernel");
+    
+    // 3. Children, generated in place after the survivors; the first field
+    // needing prolongation is prolonged by the same kernel, the others in
+    // remapFields()
+    FieldTarget* fused = nullptr;
+    for (auto& field : fields) {
+        if (field.float_components > 0 &&
+            FieldAveragingRuleRegistry::getInstance().needsProlongation(field.name)) {
+            fused = &field;
+            break;
+        }
+    }
+    cl_mem prolonged = m_split_engine->generateChildren(
+        *coord_x, *coord_y, *coord_z, *levels, *cell_states, *material_id, num_children,
+        new_x, new_y, new_z, new_l, new_s, new_m, num_survivors,
+        fused ? fused->source : nullptr,
+        fused ? fused->float_components : 0,
+        fused ? fused->name : std::string()
+    );
+    if (fused) {
+        fused->prolonged = prolonged;
+    }
     
-    // 6. Append new children
-    if (num_new_children > 0) {
-        // Upload children to GPU (Temporary, should be optimized)
-        std::vector<int> cx(num_new_children), cy(num_new_children), cz(num_new_children);
-        std::vector<uint8_t> cl(num_new_children), cs(num_new_children);
-        std::vector<uint32_t> cm(num_new_children);
-        
-        for(size_t i=0; i<num_new_children; ++i) {
-            cx[i] = split_res.children[i].x;
-            cy[i] = split_res.children[i].y;
-            cz[i] = split_res.children[i].z;
-            cl[i] = split_res.children[i].level;
-            cs[i] = split_res.children[i].state;
-            cm[i] = split_res.children[i].material_id;
+    // 4. Parents, created in place after the children
+    m_merge_engine->buildParents(
+        *coord_x, *coord_y, *coord_z, *levels, *cell_states, *material_id, num_parents,
+        new_x, new_y, new_z, new_l, new_s, new_m, num_survivors + num_children
+    );
+    
+    // Refinement requests refer to the old cell list
+    int zero_flag = 0;
+    err = clEnqueueFillBuffer(m_queue, new_flags, &zero_flag, sizeof(int), 0, new_capacity * sizeof(int), 0, nullptr, nullptr);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to clear refinement flags");
+    
+    // 5. Remap fields while the old buffers are still alive
+    remapFields(valid_flags, scan_offsets, current_cells, num_survivors, num_children, num_parents, new_capacity,
+                fields, field_manager);
+    if (prolonged) clReleaseMemObject(prolonged);  // Freed once the queued gather has run
+    
+    // 6. Swap buffers (releases are deferred until enqueued commands finish)
+    clReleaseMemObject(*coord_x); *coord_x = new_x;
+    clReleaseMemObject(*coord_y); *coord_y = new_y;
+    clReleaseMemObject(*coord_z); *coord_z = new_z;
+    clReleaseMemObject(*levels); *levels = new_l;
+    clReleaseMemObject(*cell_states); *cell_states = new_s;
+    clReleaseMemObject(*material_id); *material_id = new_m;
+    clReleaseMemObject(*refine_flags); *refine_flags = new_flags;
+    
+    *num_cells = total_new_cells;
+    *capacity = new_capacity;
+}
+
+void AdaptationEngine::remapFields(
+    cl_mem valid_flags,
+    cl_mem scan_offsets,
+    size_t old_cells,
+    size_t num_survivors,
+    size_t num_children,
+    size_t num_parents,
+    size_t new_capacity,
+    std::vector<FieldTarget>& fields,
+    fields::SOAFieldManager* field_manager
+) {
+    if (fields.empty()) return;
+    
+    cl_int err;
+    const size_t total_cells = num_survivors + num_children + num_parents;
+    
+    // Old parent index of every child (children inherit the parent's value)
+    cl_mem child_parent = m_split_engine->getChildParents();
+    
+    // Restrict every FLOAT32 field before any field is overwritten, since
+    // mass-weighted rules read another field's old values
+    std::vector<cl_mem> restricted(fields.size(), nullptr);
+    if (num_parents > 0) {
+        const auto& registry = FieldAveragingRuleRegistry::getInstance();
+        for (size_t i = 0; i < fields.size(); ++i) {
+            if (fields[i].float_components == 0) continue;
+            
+            cl_mem density = nullptr;
+            const auto& rule = registry.getRule(fields[i].name);
+            if (rule.rule == RestrictionRule::MASS_WEIGHTED) {
+                for (const auto& other : fields) {
+                    if (other.name == rule.density_field) density = other.source;
+                }
+            }
+            restricted[i] = m_merge_engine->restrictField(fields[i].name, fields[i].source,
+                                                          fields[i].float_components, density);
         }
-        
-        cl_mem buf_cx = clCreateBuffer(m_context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, num_new_children*sizeof(int), cx.data(), &err);
-        cl_mem buf_cy = clCreateBuffer(m_context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, num_new_children*sizeof(int), cy.data(), &err);
-        cl_mem buf_cz = clCreateBuffer(m_context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, num_new_children*sizeof(int), cz.data(), &err);
-        cl_mem buf_cl = clCreateBuffer(m_context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, num_new_children*sizeof(uint8_t), cl.data(), &err);
-        cl_mem buf_cs = clCreateBuffer(m_context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, num_new_children*sizeof(uint8_t), cs.data(), &err);
-        cl_mem buf_cm = clCreateBuffer(m_context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, num_new_children*sizeof(uint32_t), cm.data(), &err);
-        cl_mem buf_cf = nullptr;
-        
-        // Handle fields for children (interpolation was done in SplitEngine but returned on host?)
-        // SplitEngine::split returns SplitResult.
-        // SplitEngine.cpp:208 reads back children.
-        // It does NOT seem to return interpolated fields in SplitResult!
-        // SplitEngine.cpp:190 `interpolate_fields` kernel writes to `child_fields`.
-        // But `child_fields` is a temporary buffer in `split`.
-        // We need to extract it.
-        // Major TODO: SplitEngine should return the `child_fields` buffer or data.
-        // For now, we'll assume zero fields or implement a fix later.
-        // I'll pass nullptr for fields to append.
-        
-        uint32_t offset = num_survivors;
-        uint32_t count = num_new_children;
-        
-        clSetKernelArg(m_kernel_append, 0, sizeof(cl_mem), &buf_cx);
-        clSetKernelArg(m_kernel_append, 1, sizeof(cl_mem), &buf_cy);
-        clSetKernelArg(m_kernel_append, 2, sizeof(cl_mem), &buf_cz);
-        clSetKernelArg(m_kernel_append, 3, sizeof(cl_mem), &buf_cl);
-        clSetKernelArg(m_kernel_append, 4, sizeof(cl_mem), &buf_cs);
-        clSetKernelArg(m_kernel_append, 5, sizeof(cl_mem), &buf_cm);
-        clSetKernelArg(m_kernel_append, 6, sizeof(cl_mem), &buf_cf); // Fields missing
-        
-        clSetKernelArg(m_kernel_append, 7, sizeof(cl_mem), &new_x);
-        clSetKernelArg(m_kernel_append, 8, sizeof(cl_mem), &new_y);
-        clSetKernelArg(m_kernel_append, 9, sizeof(cl_mem), &new_z);
-        clSetKernelArg(m_kernel_append, 10, sizeof(cl_mem), &new_l);
-        clSetKernelArg(m_kernel_append, 11, sizeof(cl_mem), &new_s);
-        clSetKernelArg(m_kernel_append, 12, sizeof(cl_mem), &new_m);
-        clSetKernelArg(m_kernel_append, 13, sizeof(cl_mem), &new_f);
-        
-        clSetKernelArg(m_kernel_append, 14, sizeof(uint32_t), &count);
-        clSetKernelArg(m_kernel_append, 15, sizeof(uint32_t), &offset);
-        clSetKernelArg(m_kernel_append, 16, sizeof(uint32_t), &num_field_components);
-        
-        size_t append_global = ((count + 255) / 256) * 256;
-        clEnqueueNDRangeKernel(m_queue, m_kernel_append, 1, nullptr, &append_global, &local_size, 0, nullptr, nullptr);
-        
-        clReleaseMemObject(buf_cx); clReleaseMemObject(buf_cy); clReleaseMemObject(buf_cz);
-        clReleaseMemObject(buf_cl); clReleaseMemObject(buf_cs); clReleaseMemObject(buf_cm);
     }
     
-    // 7. Append new parents
-    if (num_new_parents > 0) {
-        std::vector<int> px(num_new_parents), py(num_new_parents), pz(num_new_parents);
-        std::vector<uint8_t> pl(num_new_parents), ps(num_new_parents);
-        std::vector<uint32_t> pm(num_new_parents);
-        
-        for(size_t i=0; i<num_new_parents; ++i) {
-            px[i] = merge_res.parents[i].x;
-            py[i] = merge_res.parents[i].y;
-            pz[i] = merge_res.parents[i].z;
-            pl[i] = merge_res.parents[i].level;
-            ps[i] = merge_res.parents[i].state;
-            pm[i] = merge_res.parents[i].material_id;
+    // Scratch large enough for the widest record
+    size_t max_record_bytes = 0;
+    for (const auto& field : fields) {
+        max_record_bytes = std::max(max_record_bytes, field.record_bytes);
+    }
+    size_t scratch_bytes = max_record_bytes * new_capacity;
+    if (scratch_bytes > m_field_scratch_bytes) {
+        if (m_field_scratch) clReleaseMemObject(m_field_scratch);
+        m_field_scratch = clCreateBuffer(m_context, CL_MEM_READ_WRITE, scratch_bytes, nullptr, &err);
+        if (err != CL_SUCCESS) {
+            m_field_scratch = nullptr;
+            m_field_scratch_bytes = 0;
+            FL_THROW_OPENCL(err, "Failed to allocate field remap scratch");
         }
+        m_field_scratch_bytes = scratch_bytes;
+    }
+    
+    size_t local_size = 256;
+    auto gather = [&](cl_mem src, cl_mem src_index, uint32_t index_stride, size_t dst_offset,
+                      size_t count, uint32_t record_bytes) {
+        if (count == 0) return;
+        uint32_t dst_offset_uint = static_cast<uint32_t>(dst_offset);
+        uint32_t count_uint = static_cast<uint32_t>(count);
+        clSetKernelArg(m_kernel_gather_records, 0, sizeof(cl_mem), &src);
+        clSetKernelArg(m_kernel_gather_records, 1, sizeof(cl_mem), &src_index);
+        clSetKernelArg(m_kernel_gather_records, 2, sizeof(uint32_t), &index_stride);
+        clSetKernelArg(m_kernel_gather_records, 3, sizeof(cl_mem), &m_field_scratch);
+        clSetKernelArg(m_kernel_gather_records, 4, sizeof(uint32_t), &dst_offset_uint);
+        clSetKernelArg(m_kernel_gather_records, 5, sizeof(uint32_t), &count_uint);
+        clSetKernelArg(m_kernel_gather_records, 6, sizeof(uint32_t), &record_bytes);
+        size_t global_size = ((count + local_size - 1) / local_size) * local_size;
+        err = clEnqueueNDRangeKernel(m_queue, m_kernel_gather_records, 1, nullptr, &global_size, &local_size, 0, nullptr, nullptr);
+        if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to enqueue field gather kernel");
+    };
+    
+    uint32_t old_cells_uint = static_cast<uint32_t>(old_cells);
+    
+    // One field at a time through the shared scratch (the in-order queue
+    // finishes each copy-back before the next field overwrites the scratch)
+    for (size_t i = 0; i < fields.size(); ++i) {
+        FieldTarget& field = fields[i];
+        uint32_t record_bytes = static_cast<uint32_t>(field.record_bytes);
         
-        cl_mem buf_px = clCreateBuffer(m_context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, num_new_parents*sizeof(int), px.data(), &err);
-        cl_mem buf_py = clCreateBuffer(m_context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, num_new_parents*sizeof(int), py.data(), &err);
-        cl_mem buf_pz = clCreateBuffer(m_context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, num_new_parents*sizeof(int), pz.data(), &err);
-        cl_mem buf_pl = clCreateBuffer(m_context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, num_new_parents*sizeof(uint8_t), pl.data(), &err);
-        cl_mem buf_ps = clCreateBuffer(m_context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, num_new_parents*sizeof(uint8_t), ps.data(), &err);
-        cl_mem buf_pm = clCreateBuffer(m_context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, num_new_parents*sizeof(uint32_t), pm.data(), &err);
+        // Survivors
+        clSetKernelArg(m_kernel_compact_records, 0, sizeof(cl_mem), &field.source);
+        clSetKernelArg(m_kernel_compact_records, 1, sizeof(cl_mem), &valid_flags);
+        clSetKernelArg(m_kernel_compact_records, 2, sizeof(cl_mem), &scan_offsets);
+        clSetKernelArg(m_kernel_compact_records, 3, sizeof(cl_mem), &m_field_scratch);
+        clSetKernelArg(m_kernel_compact_records, 4, sizeof(uint32_t), &old_cells_uint);
+        clSetKernelArg(m_kernel_compact_records, 5, sizeof(uint32_t), &record_bytes);
+        size_t global_size = ((old_cells + local_size - 1) / local_size) * local_size;
+        err = clEnqueueNDRangeKernel(m_queue, m_kernel_compact_records, 1, nullptr, &global_size, &local_size, 0, nullptr, nullptr);
+        if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to enqueue field compaction kernel");
         
-        cl_mem buf_pf = nullptr;
-        if (!merge_res.averaged_fields.empty()) {
-            buf_pf = clCreateBuffer(m_context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, merge_res.averaged_fields.size()*sizeof(float), (void*)merge_res.averaged_fields.data(), &err);
+        // Children: prolonged values where the field's rule changes them (it
+        // reads only this field's old values), else the parent's record
+        cl_mem prolonged = field.prolonged;
+        bool owns_prolonged = false;
+        if (!prolonged && field.float_components > 0 && num_children > 0 &&
+            FieldAveragingRuleRegistry::getInstance().needsProlongation(field.name)) {
+            prolonged = m_split_engine->prolongField(field.name, field.source, field.float_components);
+            owns_prolonged = prolonged != nullptr;
+        }
+        if (prolonged) {
+            gather(prolonged, nullptr, 1, num_survivors, num_children, record_bytes);
+            if (owns_prolonged) clReleaseMemObject(prolonged);  // Freed once the queued gather has run
+        } else {
+            gather(field.source, child_parent, 1, num_survivors, num_children, record_bytes);
         }
         
-        uint32_t offset = num_survivors + num_new_children;
-        uint32_t count = num_new_parents;
-        
-        clSetKernelArg(m_kernel_append, 0, sizeof(cl_mem), &buf_px);
-        clSetKernelArg(m_kernel_append, 1, sizeof(cl_mem), &buf_py);
-        clSetKernelArg(m_kernel_append, 2, sizeof(cl_mem), &buf_pz);
-        clSetKernelArg(m_kernel_append, 3, sizeof(cl_mem), &buf_pl);
-        clSetKernelArg(m_kernel_append, 4, sizeof(cl_mem), &buf_ps);
-        clSetKernelArg(m_kernel_append, 5, sizeof(cl_mem), &buf_pm);
-        clSetKernelArg(m_kernel_append, 6, sizeof(cl_mem), &buf_pf);
-        
-        clSetKernelArg(m_kernel_append, 7, sizeof(cl_mem), &new_x);
-        clSetKernelArg(m_kernel_append, 8, sizeof(cl_mem), &new_y);
-        clSetKernelArg(m_kernel_append, 9, sizeof(cl_mem), &new_z);
-        clSetKernelArg(m_kernel_append, 10, sizeof(cl_mem), &new_l);
-        clSetKernelArg(m_kernel_append, 11, sizeof(cl_mem), &new_s);
-        clSetKernelArg(m_kernel_append, 12, sizeof(cl_mem), &new_m);
-        clSetKernelArg(m_kernel_append, 13, sizeof(cl_mem), &new_f);
+        // Parents: restricted values, or the first sibling's record
+        if (restricted[i]) {
+            gather(restricted[i], nullptr, 1, num_survivors + num_children, num_parents, record_bytes);
+        } else {
+            gather(field.source, m_merge_engine->getSiblingTable(), 8, num_survivors + num_children,
+                   num_parents, record_bytes);
+        }
         
-        clSetKernelArg(m_kernel_append, 14, sizeof(uint32_t), &count);
-        clSetKernelArg(m_kernel_append, 15, sizeof(uint32_t), &offset);
-        clSetKernelArg(m_kernel_append, 16, sizeof(uint32_t), &num_field_components);
+        // Destination at the new capacity; its old contents are already remapped
+        cl_mem destination = nullptr;
+        if (field_manager) {
+            if (field_manager->getAllocationSize(field.handle) < new_capacity) {
+                field_manager->resize(field.handle, new_capacity, false);
+            }
+            destination = static_cast<cl_mem>(field_manager->getDevicePtr(field.handle));
+        } else {
+            destination = clCreateBuffer(m_context, CL_MEM_READ_WRITE, new_capacity * field.record_bytes, nullptr, &err);
+            if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to allocate remapped field " + field.name);
+            clReleaseMemObject(*field.owned);
+            *field.owned = destination;
+        }
         
-        size_t append_global = ((count + 255) / 256) * 256;
-        clEnqueueNDRangeKernel(m_queue, m_kernel_append, 1, nullptr, &append_global, &local_size, 0, nullptr, nullptr);
+        err = clEnqueueCopyBuffer(m_queue, m_field_scratch, destination, 0, 0, total_cells * field.record_bytes, 0, nullptr, nullptr);
+        if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to copy remapped field " + field.name);
         
-        clReleaseMemObject(buf_px); clReleaseMemObject(buf_py); clReleaseMemObject(buf_pz);
-        clReleaseMemObject(buf_pl); clReleaseMemObject(buf_ps); clReleaseMemObject(buf_pm);
-        if(buf_pf) clReleaseMemObject(buf_pf);
+        if (field_manager) {
+            field_manager->markDirty(field.handle);
+        }
     }
     
-    // 8. Swap buffers
-    clReleaseMemObject(*coord_x); *coord_x = new_x;
-    clReleaseMemObject(*coord_y); *coord_y = new_y;
-    clReleaseMemObject(*coord_z); *coord_z = new_z;
-    clReleaseMemObject(*levels); *levels = new_l;
-    clReleaseMemObject(*cell_states); *cell_states = new_s;
-    clReleaseMemObject(*material_id); *material_id = new_m;
-    if (fields && *fields) {
-        clReleaseMemObject(*fields); *fields = new_f;
+    for (cl_mem buffer : restricted) {
+        if (buffer) clReleaseMemObject(buffer);
     }
-    
-    *num_cells = total_new_cells;
-    
-    // Cleanup
-    clReleaseMemObject(valid_flags);
-    clReleaseMemObject(merge_group_id);
-    clReleaseMemObject(scan_offsets);
 }
 
 } // namespace adaptation
@@ -14,7 +14,7 @@ namespace adaptation {
 BalanceEnforcer::BalanceEnforcer(cl_context context, cl_command_queue queue, const AdaptationConfig& config)
     : m_context(context), m_queue(queue), m_config(config), m_program(nullptr),
       m_kernel_detect_violations(nullptr), m_kernel_mark_cascading(nullptr), m_kernel_update_shadow_levels(nullptr),
-      m_hash_table(nullptr), m_hash_table_size(0) {
+      m_kernel_build_hash(nullptr), m_hash_table(nullptr), m_hash_table_size(0) {
     compileKernels();
 }
 
@@ -26,6 +26,7 @@ void BalanceEnforcer::releaseResources() {
     if (m_kernel_detect_violations) clReleaseKernel(m_kernel_detect_violations);
     if (m_kernel_mark_cascading) clReleaseKernel(m_kernel_mark_cascading);
     if (m_kernel_update_shadow_levels) clReleaseKernel(m_kernel_update_shadow_levels);
+    if (m_kernel_build_hash) clReleaseKernel(m_kernel_build_hash);
     if (m_program) clReleaseProgram(m_program);
     if (m_hash_table) clReleaseMemObject(m_hash_table);
 }
@@ -50,18 +51,7 @@ void BalanceEnforcer::compileKernels() {
         balance_src.replace(include_pos, 29, "// #include \"hilbert_encode_3d.cl\"");
     }
     
-    std::string update_shadow_src = 
-        "__kernel void update_shadow_levels("
-        "    __global const uchar* restrict levels,"
-        "    __global const int* restrict refine_flags,"
-        "    __global uchar* restrict shadow_levels,"
-        "    const uint num_cells) {"
-        "    const uint idx = get_global_id(0);"
-        "    if (idx >= num_cells) return;"
-        "    shadow_levels[idx] = levels[idx] + (refine_flags[idx] > 0 ? 1 : 0);"
-        "}";
-        
-    std::string full_src = hilbert_src + "\n" + balance_src + "\n" + update_shadow_src;
+    std::string full_src = hilbert_src + "\n" + balance_src;
     
     const char* src_str = full_src.c_str();
     size_t src_len = full_src.length();
@@ -95,87 +85,87 @@ void BalanceEnforcer::compileKernels() {
 
     m_kernel_update_shadow_levels = clCreateKernel(m_program, "update_shadow_levels", &err);
     if (err != CL_SUCCESS) throw std::runtime_error("Failed to create update_shadow_levels kernel");
+    
+    m_kernel_build_hash = clCreateKernel(m_program, "build_cell_hash", &err);
+    if (err != CL_SUCCESS) throw std::runtime_error("Failed to create build_cell_hash kernel");
 }
 
 void BalanceEnforcer::buildHashTable(cl_mem x, cl_mem y, cl_mem z, size_t num_cells) {
-    // Host-side hash table build
-    std::vector<int> h_x(num_cells), h_y(num_cells), h_z(num_cells);
-    clEnqueueReadBuffer(m_queue, x, CL_TRUE, 0, num_cells * sizeof(int), h_x.data(), 0, nullptr, nullptr);
-    clEnqueueReadBuffer(m_queue, y, CL_TRUE, 0, num_cells * sizeof(int), h_y.data(), 0, nullptr, nullptr);
-    clEnqueueReadBuffer(m_queue, z, CL_TRUE, 0, num_cells * sizeof(int), h_z.data(), 0, nullptr, nullptr);
-    
+    // Built on the device by build_cell_hash, so the coordinates stay there
     size_t table_size = 1;
     while (table_size < num_cells * 2) table_size *= 2;
     if (table_size < 1024) table_size = 1024;
     
-    std::vector<uint32_t> h_table(table_size, INVALID_INDEX);
-    
-    for (size_t i = 0; i < num_cells; ++i) {
-        uint64_t hilbert = hilbert_encode_3d(h_x[i], h_y[i], h_z[i], MAX_REFINEMENT_LEVEL);
-        uint32_t hash = hilbert % table_size;
-        // Linear probing
-        size_t probes = 0;
-        while (h_table[hash] != INVALID_INDEX && probes < table_size) {
-            hash = (hash + 1) % table_size;
-            probes++;
-        }
-        
-        if (h_table[hash] == INVALID_INDEX) {
-            h_table[hash] = static_cast<uint32_t>(i);
-        } else {
-            FL_LOG(ERROR) << "Hash table full in BalanceEnforcer!";
-        }
-    }
-    
     if (m_hash_table && m_hash_table_size != table_size) {
         clReleaseMemObject(m_hash_table);
         m_hash_table = nullptr;
     }
     
+    cl_int err;
     if (!m_hash_table) {
-        cl_int err;
         m_hash_table = clCreateBuffer(m_context, CL_MEM_READ_WRITE, table_size * sizeof(uint32_t), nullptr, &err);
         if (err != CL_SUCCESS) throw std::runtime_error("Failed to allocate hash table");
         m_hash_table_size = table_size;
     }
     
-    clEnqueueWriteBuffer(m_queue, m_hash_table, CL_TRUE, 0, table_size * sizeof(uint32_t), h_table.data(), 0, nullptr, nullptr);
+    uint32_t invalid = INVALID_INDEX;
+    err = clEnqueueFillBuffer(m_queue, m_hash_table, &invalid, sizeof(uint32_t), 0, table_size * sizeof(uint32_t), 0, nullptr, nullptr);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to clear hash table");
+    
+    cl_uint table_size_uint = static_cast<cl_uint>(table_size);
+    cl_uint num_cells_uint = static_cast<cl_uint>(num_cells);
+    clSetKernelArg(m_kernel_build_hash, 0, sizeof(cl_mem), &x);
+    clSetKernelArg(m_kernel_build_hash, 1, sizeof(cl_mem), &y);
+    clSetKernelArg(m_kernel_build_hash, 2, sizeof(cl_mem), &z);
+    clSetKernelArg(m_kernel_build_hash, 3, sizeof(cl_mem), &m_hash_table);
+    clSetKernelArg(m_kernel_build_hash, 4, sizeof(cl_uint), &table_size_uint);
+    clSetKernelArg(m_kernel_build_hash, 5, sizeof(cl_uint), &num_cells_uint);
+    
+    size_t local_work_size = 256;
+    size_t global_work_size = ((num_cells + local_work_size - 1) / local_work_size) * local_work_size;
+    err = clEnqueueNDRangeKernel(m_queue, m_kernel_build_hash, 1, nullptr, &global_work_size, &local_work_size, 0, nullptr, nullptr);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to enqueue hash build kernel");
 }
 
-BalanceResult BalanceEnforcer::enforce(
+void BalanceEnforcer::enforce(
     cl_mem coord_x, cl_mem coord_y, cl_mem coord_z,
     cl_mem levels, cl_mem cell_states,
     cl_mem refine_flags,
-    size_t num_cells
+    size_t num_cells,
+    cl_mem balance_counts
 ) {
-    BalanceResult result;
     cl_int err;
     
-    if (num_cells == 0) return result;
+    // Zero counts read as "converged at iteration 0" for an empty mesh
+    uint32_t zero = 0;
+    err = clEnqueueFillBuffer(m_queue, balance_counts, &zero, sizeof(uint32_t), 0, numCounts() * sizeof(uint32_t), 0, nullptr, nullptr);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to clear balance counts");
+    
+    if (num_cells == 0) return;
     
     // 1. Build hash table
     buildHashTable(coord_x, coord_y, coord_z, num_cells);
     
-    // 2. Allocate temporary buffers
+    // 2. Allocate temporary buffers (released once the queued iterations have run)
     cl_mem violation_flags = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_cells * sizeof(uint8_t), nullptr, &err);
-    cl_mem violation_count = clCreateBuffer(m_context, CL_MEM_READ_WRITE, sizeof(uint32_t), nullptr, &err);
-    cl_mem marked_count = clCreateBuffer(m_context, CL_MEM_READ_WRITE, sizeof(uint32_t), nullptr, &err);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to allocate violation flags");
     
     // Shadow levels buffer for cascading
     cl_mem shadow_levels = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_cells * sizeof(uint8_t), nullptr, &err);
+    if (err != CL_SUCCESS) {
+        clReleaseMemObject(violation_flags);
+        FL_THROW_OPENCL(err, "Failed to allocate shadow levels");
+    }
     // Initialize shadow levels with current levels
     clEnqueueCopyBuffer(m_queue, levels, shadow_levels, 0, 0, num_cells * sizeof(uint8_t), 0, nullptr, nullptr);
     
     size_t global_work_size = ((num_cells + 255) / 256) * 256;
     size_t local_work_size = 256;
+    cl_uint table_size_uint = static_cast<cl_uint>(m_hash_table_size);
+    cl_uint num_cells_uint = static_cast<cl_uint>(num_cells);
     
-    // 3. Iterative loop
-    for (uint32_t iter = 0; iter < m_config.max_balance_iterations; ++iter) {
-        // Reset counters
-        uint32_t zero = 0;
-        clEnqueueWriteBuffer(m_queue, violation_count, CL_TRUE, 0, sizeof(uint32_t), &zero, 0, nullptr, nullptr);
-        clEnqueueWriteBuffer(m_queue, marked_count, CL_TRUE, 0, sizeof(uint32_t), &zero, 0, nullptr, nullptr);
-        
+    // 3. Iterations; each kernel checks the counts of the one before on the device
+    for (cl_uint iter = 0; iter < m_config.max_balance_iterations; ++iter) {
         // A. Detect violations using SHADOW levels
         clSetKernelArg(m_kernel_detect_violations, 0, sizeof(cl_mem), &coord_x);
         clSetKernelArg(m_kernel_detect_violations, 1, sizeof(cl_mem), &coord_y);
@@ -184,33 +174,18 @@ BalanceResult BalanceEnforcer::enforce(
         clSetKernelArg(m_kernel_detect_violations, 4, sizeof(cl_mem), &cell_states);
         clSetKernelArg(m_kernel_detect_violations, 5, sizeof(cl_mem), nullptr); // cell_hilbert
         clSetKernelArg(m_kernel_detect_violations, 6, sizeof(cl_mem), &m_hash_table);
-        cl_uint table_size_uint = static_cast<cl_uint>(m_hash_table_size);
         clSetKernelArg(m_kernel_detect_violations, 7, sizeof(cl_uint), &table_size_uint);
         clSetKernelArg(m_kernel_detect_violations, 8, sizeof(cl_mem), &violation_flags);
-        clSetKernelArg(m_kernel_detect_violations, 9, sizeof(cl_mem), &violation_count);
-        cl_uint num_cells_uint = static_cast<cl_uint>(num_cells);
-        clSetKernelArg(m_kernel_detect_violations, 10, sizeof(cl_uint), &num_cells_uint);
+        clSetKernelArg(m_kernel_detect_violations, 9, sizeof(cl_mem), &balance_counts);
+        clSetKernelArg(m_kernel_detect_violations, 10, sizeof(cl_uint), &iter);
+        clSetKernelArg(m_kernel_detect_violations, 11, sizeof(cl_uint), &num_cells_uint);
         
         err = clEnqueueNDRangeKernel(m_queue, m_kernel_detect_violations, 1, nullptr, &global_work_size, &local_work_size, 0, nullptr, nullptr);
         if (err != CL_SUCCESS) throw std::runtime_error("Failed to enqueue detect violations kernel");
         
-        // Read violation count
-        uint32_t num_violations = 0;
-        clEnqueueReadBuffer(m_queue, violation_count, CL_TRUE, 0, sizeof(uint32_t), &num_violations, 0, nullptr, nullptr);
-        
-        result.total_violations_detected += num_violations;
-        
-        if (num_violations == 0) {
-            result.converged = true;
-            result.iterations = iter + 1;
-            break;
-        }
-        
         // B. Mark cascading refinement
-        // Note: mark_cascading uses 'levels' to check if max level reached. 
-        // It should arguably use 'shadow_levels' too, but using 'levels' is safe (conservative).
-        // Actually, if we are at L=7 and shadow=8, we can't refine further.
-        // So using 'levels' is correct for capacity check.
+        // 'levels', not the shadow levels, bounds the refinement: a cell at
+        // L=7 with shadow 8 still splits once, which is all it can do.
         clSetKernelArg(m_kernel_mark_cascading, 0, sizeof(cl_mem), &coord_x);
         clSetKernelArg(m_kernel_mark_cascading, 1, sizeof(cl_mem), &coord_y);
         clSetKernelArg(m_kernel_mark_cascading, 2, sizeof(cl_mem), &coord_z);
@@ -218,15 +193,62 @@ BalanceResult BalanceEnforcer::enforce(
         clSetKernelArg(m_kernel_mark_cascading, 4, sizeof(cl_mem), &cell_states);
         clSetKernelArg(m_kernel_mark_cascading, 5, sizeof(cl_mem), &violation_flags);
         clSetKernelArg(m_kernel_mark_cascading, 6, sizeof(cl_mem), &refine_flags);
-        clSetKernelArg(m_kernel_mark_cascading, 7, sizeof(cl_mem), &marked_count);
-        clSetKernelArg(m_kernel_mark_cascading, 8, sizeof(cl_uint), &num_cells_uint);
+        clSetKernelArg(m_kernel_mark_cascading, 7, sizeof(cl_mem), &balance_counts);
+        clSetKernelArg(m_kernel_mark_cascading, 8, sizeof(cl_uint), &iter);
+        clSetKernelArg(m_kernel_mark_cascading, 9, sizeof(cl_uint), &num_cells_uint);
         
         err = clEnqueueNDRangeKernel(m_queue, m_kernel_mark_cascading, 1, nullptr, &global_work_size, &local_work_size, 0, nullptr, nullptr);
         if (err != CL_SUCCESS) throw std::runtime_error("Failed to enqueue mark cascading kernel");
         
-        // Read marked count
-        uint32_t num_marked = 0;
-        clEnqueueReadBuffer(m_queue, marked_count, CL_TRUE, 0, sizeof(uint32_t), &num_marked, 0, nullptr, nullptr);
+        // C. Update shadow levels
+        clSetKernelArg(m_kernel_update_shadow_levels, 0, sizeof(cl_mem), &levels);
+        clSetKernelArg(m_kernel_update_shadow_levels, 1, sizeof(cl_mem), &refine_flags);
+        clSetKernelArg(m_kernel_update_shadow_levels, 2, sizeof(cl_mem), &shadow_levels);
+        clSetKernelArg(m_kernel_update_shadow_levels, 3, sizeof(cl_mem), &balance_counts);
+        clSetKernelArg(m_kernel_update_shadow_levels, 4, sizeof(cl_uint), &iter);
+        clSetKernelArg(m_kernel_update_shadow_levels, 5, sizeof(cl_uint), &num_cells_uint);
+        
+        err = clEnqueueNDRangeKernel(m_queue, m_kernel_update_shadow_levels, 1, nullptr, &global_work_size, &local_work_size, 0, nullptr, nullptr);
+        if (err != CL_SUCCESS) throw std::runtime_error("Failed to enqueue update shadow levels kernel");
+    }
+    
+    clReleaseMemObject(violation_flags);
+    clReleaseMemObject(shadow_levels);
+}
+
+BalanceResult BalanceEnforcer::enforce(
+    cl_mem coord_x, cl_mem coord_y, cl_mem coord_z,
+    cl_mem levels, cl_mem cell_states,
+    cl_mem refine_flags,
+    size_t num_cells
+) {
+    if (num_cells == 0) return BalanceResult();
+    
+    cl_int err;
+    std::vector<uint32_t> counts(numCounts());
+    cl_mem balance_counts = clCreateBuffer(m_context, CL_MEM_READ_WRITE, counts.size() * sizeof(uint32_t), nullptr, &err);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to allocate balance counts");
+    
+    enforce(coord_x, coord_y, coord_z, levels, cell_states, refine_flags, num_cells, balance_counts);
+    err = clEnqueueReadBuffer(m_queue, balance_counts, CL_TRUE, 0, counts.size() * sizeof(uint32_t), counts.data(), 0, nullptr, nullptr);
+    clReleaseMemObject(balance_counts);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to read balance counts");
+    
+    return summarize(counts.data());
+}
+
+BalanceResult BalanceEnforcer::summarize(const uint32_t* balance_counts) const {
+    BalanceResult result;
+    for (uint32_t iter = 0; iter < m_config.max_balance_iterations; ++iter) {
+        uint32_t num_violations = balance_counts[2 * iter];
+        uint32_t num_marked = balance_counts[2 * iter + 1];
+        result.iterations = iter + 1;
+        result.total_violations_detected += num_violations;
+        
+        if (num_violations == 0) {
+            result.converged = true;
+            break;
+        }
         
         result.total_cells_marked_for_balance += num_marked;
         
@@ -239,26 +261,9 @@ BalanceResult BalanceEnforcer::enforce(
         if (num_marked == 0) {
             // Violations detected but no cells marked? This might happen if all violators are already at max level or locked.
             FL_LOG(WARN) << "Balance enforcement: Violations detected but no cells could be marked. Stopping.";
-            result.converged = false;
-            result.iterations = iter + 1;
             break;
         }
-        
-        // C. Update shadow levels
-        clSetKernelArg(m_kernel_update_shadow_levels, 0, sizeof(cl_mem), &levels);
-        clSetKernelArg(m_kernel_update_shadow_levels, 1, sizeof(cl_mem), &refine_flags);
-        clSetKernelArg(m_kernel_update_shadow_levels, 2, sizeof(cl_mem), &shadow_levels);
-        clSetKernelArg(m_kernel_update_shadow_levels, 3, sizeof(cl_uint), &num_cells_uint);
-        
-        err = clEnqueueNDRangeKernel(m_queue, m_kernel_update_shadow_levels, 1, nullptr, &global_work_size, &local_work_size, 0, nullptr, nullptr);
-        if (err != CL_SUCCESS) throw std::runtime_error("Failed to enqueue update shadow levels kernel");
     }
-    
-    clReleaseMemObject(violation_flags);
-    clReleaseMemObject(violation_count);
-    clReleaseMemObject(marked_count);
-    clReleaseMemObject(shadow_levels);
-    
     return result;
 }
 
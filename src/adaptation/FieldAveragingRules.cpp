@@ -0,0 +1,518 @@
+#include "fluidloom/adaptation/FieldAveragingRules.h"
+#include "fluidloom/adaptation/CellDescriptor.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <type_traits>
+
+namespace fluidloom {
+namespace adaptation {
+
+namespace {
+
+constexpr uint32_t CHILDREN = 8;
+
+// Invoke fn(std::integral_constant<uint32_t, NC>) with NC fixed for the common
+// component counts (scalar, vector, D3Q19, D3Q27) and 0 (runtime) otherwise
+template <typename Fn>
+void dispatchComponents(uint32_t num_components, Fn&& fn) {
+    switch (num_components) {
+        case 1:  fn(std::integral_constant<uint32_t, 1>{}); break;
+        case 3:  fn(std::integral_constant<uint32_t, 3>{}); break;
+        case 19: fn(std::integral_constant<uint32_t, 19>{}); break;
+        case 27: fn(std::integral_constant<uint32_t, 27>{}); break;
+        default: fn(std::integral_constant<uint32_t, 0>{}); break;
+    }
+}
+
+// out = scale * Σ_k child_k (children summed in octant order, as on the device)
+template <uint32_t NC>
+void restrictLinear(const RestrictionBatch& b, float scale) {
+    const uint32_t nc = NC ? NC : b.num_components;
+    for (size_t p = b.parent_begin; p < b.parent_end; ++p) {
+        const uint32_t* children = b.child_indices + p * CHILDREN;
+        float* out = b.parent_data + p * nc;
+        for (uint32_t c = 0; c < nc; ++c) {
+            out[c] = 0.0f;
+        }
+        for (uint32_t k = 0; k < CHILDREN; ++k) {
+            const float* in = b.child_data + static_cast<size_t>(children[k]) * nc;
+            for (uint32_t c = 0; c < nc; ++c) {
+                out[c] += in[c];
+            }
+        }
+        for (uint32_t c = 0; c < nc; ++c) {
+            out[c] *= scale;
+        }
+    }
+}
+
+// out = Σ ρ_k u_k / Σ ρ_k; falls back to the arithmetic mean for zero mass
+template <uint32_t NC>
+void restrictMassWeighted(const RestrictionBatch& b) {
+    const uint32_t nc = NC ? NC : b.num_components;
+    for (size_t p = b.parent_begin; p < b.parent_end; ++p) {
+        const uint32_t* children = b.child_indices + p * CHILDREN;
+        float* out = b.parent_data + p * nc;
+        for (uint32_t c = 0; c < nc; ++c) {
+            out[c] = 0.0f;
+        }
+        float mass = 0.0f;
+        for (uint32_t k = 0; k < CHILDREN; ++k) {
+            const float rho = b.child_density[children[k]];
+            const float* in = b.child_data + static_cast<size_t>(children[k]) * nc;
+            mass += rho;
+            for (uint32_t c = 0; c < nc; ++c) {
+                out[c] += rho * in[c];
+            }
+        }
+        if (mass > 0.0f) {
+            const float inv_mass = 1.0f / mass;
+            for (uint32_t c = 0; c < nc; ++c) {
+                out[c] *= inv_mass;
+            }
+        } else {
+            for (uint32_t c = 0; c < nc; ++c) {
+                out[c] = 0.0f;
+            }
+            for (uint32_t k = 0; k < CHILDREN; ++k) {
+                const float* in = b.child_data + static_cast<size_t>(children[k]) * nc;
+                for (uint32_t c = 0; c < nc; ++c) {
+                    out[c] += in[c];
+                }
+            }
+            for (uint32_t c = 0; c < nc; ++c) {
+                out[c] *= 0.125f;
+            }
+        }
+    }
+}
+
+// Second-order equilibrium for one population
+inline float equilibrium(float rho, float ux, float uy, float uz,
+                         float cx, float cy, float cz, float w, float cs2) {
+    const float cu = cx * ux + cy * uy + cz * uz;
+    const float uu = ux * ux + uy * uy + uz * uz;
+    return w * rho * (1.0f + cu / cs2 + (cu * cu) / (2.0f * cs2 * cs2) - uu / (2.0f * cs2));
+}
+
+// f_parent = f_eq(ρ̄, ū) + s · mean_k(f_k − f_eq(ρ_k, u_k)); conserves Σ f and Σ f c
+void restrictLbm(const LbmRestrictionParams& lbm, const RestrictionBatch& b) {
+    const uint32_t q_count = b.num_components;
+    const float scale = lbm.nonEquilibriumScale();
+
+    float cx[LbmRestrictionParams::MAX_POPULATIONS];
+    float cy[LbmRestrictionParams::MAX_POPULATIONS];
+    float cz[LbmRestrictionParams::MAX_POPULATIONS];
+    for (uint32_t q = 0; q < q_count; ++q) {
+        cx[q] = lbm.velocities[q][0];
+        cy[q] = lbm.velocities[q][1];
+        cz[q] = lbm.velocities[q][2];
+    }
+
+    float neq_sum[LbmRestrictionParams::MAX_POPULATIONS];
+    for (size_t p = b.parent_begin; p < b.parent_end; ++p) {
+        const uint32_t* children = b.child_indices + p * CHILDREN;
+        float mass = 0.0f, jx = 0.0f, jy = 0.0f, jz = 0.0f;
+        for (uint32_t q = 0; q < q_count; ++q) {
+            neq_sum[q] = 0.0f;
+        }
+
+        for (uint32_t k = 0; k < CHILDREN; ++k) {
+            const float* f = b.child_data + static_cast<size_t>(children[k]) * q_count;
+            float rho = 0.0f, mx = 0.0f, my = 0.0f, mz = 0.0f;
+            for (uint32_t q = 0; q < q_count; ++q) {
+                rho += f[q];
+                mx += f[q] * cx[q];
+                my += f[q] * cy[q];
+                mz += f[q] * cz[q];
+            }
+            const float inv_rho = rho > 0.0f ? 1.0f / rho : 0.0f;
+            const float ux = mx * inv_rho, uy = my * inv_rho, uz = mz * inv_rho;
+            for (uint32_t q = 0; q < q_count; ++q) {
+                neq_sum[q] += f[q] - equilibrium(rho, ux, uy, uz, cx[q], cy[q], cz[q], lbm.weights[q], lbm.cs2);
+            }
+            mass += rho;
+            jx += mx;
+            jy += my;
+            jz += mz;
+        }
+
+        const float rho = mass * 0.125f;
+        const float inv_mass = mass > 0.0f ? 1.0f / mass : 0.0f;
+        const float ux = jx * inv_mass, uy = jy * inv_mass, uz = jz * inv_mass;
+        float* out = b.parent_data + p * q_count;
+        for (uint32_t q = 0; q < q_count; ++q) {
+            out[q] = equilibrium(rho, ux, uy, uz, cx[q], cy[q], cz[q], lbm.weights[q], lbm.cs2)
+                   + scale * (neq_sum[q] * 0.125f);
+        }
+    }
+}
+
+// Limited slope across a cell from its left and right differences; same
+// operations as limited_slope in split_cells.cl
+inline float limitedSlope(float minus, float centre, float plus, ProlongationRule rule) {
+    const float left = centre - minus;
+    const float right = plus - centre;
+    if (!(left * right > 0.0f)) {
+        return 0.0f;  // Extremum or flat side
+    }
+    float magnitude = std::min(std::fabs(left), std::fabs(right));
+    if (rule == ProlongationRule::MC) {
+        magnitude = std::min(2.0f * magnitude, 0.5f * std::fabs(left + right));
+    }
+    return left > 0.0f ? magnitude : -magnitude;
+}
+
+bool isSlopeLimited(ProlongationRule rule) {
+    return rule == ProlongationRule::MINMOD || rule == ProlongationRule::MC;
+}
+
+// Float literal that round-trips and is valid OpenCL C
+std::string floatLiteral(double value) {
+    std::ostringstream os;
+    os << std::scientific << std::setprecision(9) << static_cast<float>(value) << "f";
+    return os.str();
+}
+
+} // namespace
+
+void LbmRestrictionParams::validate() const {
+    if (velocities.empty() || velocities.size() > MAX_POPULATIONS) {
+        throw std::invalid_argument("LBM restriction: lattice must have 1.." +
+                                    std::to_string(MAX_POPULATIONS) + " populations");
+    }
+    if (weights.size() != velocities.size()) {
+        throw std::invalid_argument("LBM restriction: one weight per velocity required");
+    }
+    if (!(cs2 > 0.0f) || !(tau_fine > 0.5f)) {
+        throw std::invalid_argument("LBM restriction: need cs2 > 0 and tau_fine > 0.5");
+    }
+}
+
+void FieldAveragingRuleRegistry::registerRule(const std::string& field_name, const std::string& rule_type) {
+    if (rule_type == "arithmetic") {
+        registerRule(field_name, RestrictionRule::ARITHMETIC);
+    } else if (rule_type == "volume_weighted") {
+        registerRule(field_name, RestrictionRule::VOLUME_WEIGHTED);
+    } else if (rule_type == "mass_weighted" || rule_type == "lbm_eq_noneq") {
+        throw std::invalid_argument("Averaging rule " + rule_type + " needs parameters; use "
+                                    "registerMassWeightedRule/registerLbmRule");
+    } else {
+        throw std::invalid_argument("Unknown averaging rule: " + rule_type);
+    }
+}
+
+void FieldAveragingRuleRegistry::registerRule(const std::string& field_name, RestrictionRule rule) {
+    if (rule == RestrictionRule::MASS_WEIGHTED || rule == RestrictionRule::LBM_EQ_NONEQ) {
+        throw std::invalid_argument(std::string("Averaging rule ") + ruleName(rule) + " needs parameters");
+    }
+    RuleEntry entry;
+    entry.rule = rule;
+    storeRule(field_name, entry, true);
+}
+
+void FieldAveragingRuleRegistry::registerMassWeightedRule(const std::string& field_name,
+                                                          const std::string& density_field) {
+    if (density_field.empty() || density_field == field_name) {
+        throw std::invalid_argument("Mass-weighted rule for " + field_name + " needs a separate density field");
+    }
+    RuleEntry entry;
+    entry.rule = RestrictionRule::MASS_WEIGHTED;
+    entry.density_field = density_field;
+    storeRule(field_name, entry, true);
+}
+
+void FieldAveragingRuleRegistry::registerLbmRule(const std::string& field_name,
+                                                 const LbmRestrictionParams& params) {
+    params.validate();
+    RuleEntry entry;
+    entry.rule = RestrictionRule::LBM_EQ_NONEQ;
+    entry.lbm = params;
+    storeRule(field_name, entry, true);
+}
+
+void FieldAveragingRuleRegistry::registerProlongation(const std::string& field_name, const std::string& rule_type) {
+    if (rule_type == "injection") {
+        registerProlongation(field_name, ProlongationRule::INJECTION);
+    } else if (rule_type == "minmod") {
+        registerProlongation(field_name, ProlongationRule::MINMOD);
+    } else if (rule_type == "mc") {
+        registerProlongation(field_name, ProlongationRule::MC);
+    } else {
+        throw std::invalid_argument("Unknown prolongation rule: " + rule_type);
+    }
+}
+
+void FieldAveragingRuleRegistry::registerProlongation(const std::string& field_name, ProlongationRule rule) {
+    RuleEntry entry = getRule(field_name);
+    entry.prolongation = rule;
+    storeRule(field_name, entry, false);
+}
+
+void FieldAveragingRuleRegistry::storeRule(const std::string& field_name, RuleEntry entry, bool keep_prolongation) {
+    if (keep_prolongation) {
+        entry.prolongation = getRule(field_name).prolongation;
+    }
+    // Linear reconstruction only inverts the linear restriction rules
+    if (isSlopeLimited(entry.prolongation) &&
+        entry.rule != RestrictionRule::ARITHMETIC && entry.rule != RestrictionRule::VOLUME_WEIGHTED) {
+        throw std::invalid_argument(std::string("Prolongation ") + prolongationName(entry.prolongation) +
+                                    " of " + field_name + " is not conservative with restriction rule " +
+                                    ruleName(entry.rule));
+    }
+    rules_[field_name] = entry;
+}
+
+const FieldAveragingRuleRegistry::RuleEntry& FieldAveragingRuleRegistry::getRule(const std::string& field_name) const {
+    static const RuleEntry default_entry;
+    auto it = rules_.find(field_name);
+    return it != rules_.end() ? it->second : default_entry;
+}
+
+std::string FieldAveragingRuleRegistry::getRuleType(const std::string& field_name) const {
+    return ruleName(getRule(field_name).rule);
+}
+
+const char* FieldAveragingRuleRegistry::ruleName(RestrictionRule rule) {
+    switch (rule) {
+        case RestrictionRule::ARITHMETIC: return "arithmetic";
+        case RestrictionRule::VOLUME_WEIGHTED: return "volume_weighted";
+        case RestrictionRule::MASS_WEIGHTED: return "mass_weighted";
+        case RestrictionRule::LBM_EQ_NONEQ: return "lbm_eq_noneq";
+    }
+    return "unknown";
+}
+
+const char* FieldAveragingRuleRegistry::prolongationName(ProlongationRule rule) {
+    switch (rule) {
+        case ProlongationRule::INJECTION: return "injection";
+        case ProlongationRule::MINMOD: return "minmod";
+        case ProlongationRule::MC: return "mc";
+    }
+    return "unknown";
+}
+
+bool FieldAveragingRuleRegistry::hasSlopeProlongation() const {
+    return std::any_of(rules_.begin(), rules_.end(),
+                       [](const auto& rule) { return isSlopeLimited(rule.second.prolongation); });
+}
+
+bool FieldAveragingRuleRegistry::needsProlongation(const std::string& field_name) const {
+    const RuleEntry& entry = getRule(field_name);
+    return isSlopeLimited(entry.prolongation) || prolongationScale(entry.rule) != 1.0f;
+}
+
+float FieldAveragingRuleRegistry::prolongationScale(RestrictionRule rule) {
+    return rule == RestrictionRule::VOLUME_WEIGHTED ? 0.125f : 1.0f;
+}
+
+void FieldAveragingRuleRegistry::prolong(const std::string& field_name, const ProlongationBatch& batch) const {
+    prolong(getRule(field_name), batch);
+}
+
+void FieldAveragingRuleRegistry::prolong(const RuleEntry& entry, const ProlongationBatch& batch) {
+    if (batch.parent_end <= batch.parent_begin) {
+        return;
+    }
+    const bool slopes = isSlopeLimited(entry.prolongation);
+    if (!batch.child_block_start || !batch.parent_data || !batch.child_data || batch.num_components == 0 ||
+        (slopes && !batch.parent_neighbors)) {
+        throw std::invalid_argument("ProlongationBatch: missing block starts, neighbors, data or components");
+    }
+
+    const uint32_t nc = batch.num_components;
+    const float scale = prolongationScale(entry.rule);
+    for (size_t p = batch.parent_begin; p < batch.parent_end; ++p) {
+        const uint32_t child_start = batch.child_block_start[p];
+        if (child_start == INVALID_INDEX) {
+            continue;
+        }
+        const uint32_t* neighbors = slopes ? batch.parent_neighbors + static_cast<size_t>(child_start / CHILDREN) * 6 : nullptr;
+
+        for (uint32_t c = 0; c < nc; ++c) {
+            const float centre = batch.parent_data[p * nc + c];
+            float slope[3] = {0.0f, 0.0f, 0.0f};
+            if (slopes) {
+                for (int axis = 0; axis < 3; ++axis) {
+                    const uint32_t minus = neighbors[2 * axis];
+                    const uint32_t plus = neighbors[2 * axis + 1];
+                    slope[axis] = limitedSlope(
+                        minus != INVALID_INDEX ? batch.parent_data[static_cast<size_t>(minus) * nc + c] : centre,
+                        centre,
+                        plus != INVALID_INDEX ? batch.parent_data[static_cast<size_t>(plus) * nc + c] : centre,
+                        entry.prolongation);
+                }
+            }
+            for (uint32_t k = 0; k < CHILDREN; ++k) {
+                const float offset = ((k & 1) ? slope[0] : -slope[0]) +
+                                     ((k & 2) ? slope[1] : -slope[1]) +
+                                     ((k & 4) ? slope[2] : -slope[2]);
+                batch.child_data[static_cast<size_t>(child_start + k) * nc + c] = scale * (centre + 0.25f * offset);
+            }
+        }
+    }
+}
+
+void FieldAveragingRuleRegistry::apply(const std::string& field_name, const RestrictionBatch& batch) const {
+    apply(getRule(field_name), batch);
+}
+
+void FieldAveragingRuleRegistry::apply(const RuleEntry& entry, const RestrictionBatch& batch) {
+    if (batch.parent_end <= batch.parent_begin) {
+        return;
+    }
+    if (!batch.child_indices || !batch.child_data || !batch.parent_data || batch.num_components == 0) {
+        throw std::invalid_argument("RestrictionBatch: missing child table, data or components");
+    }
+
+    switch (entry.rule) {
+        case RestrictionRule::ARITHMETIC:
+        case RestrictionRule::VOLUME_WEIGHTED: {
+            const float scale = entry.rule == RestrictionRule::ARITHMETIC ? 0.125f : 1.0f;
+            dispatchComponents(batch.num_components, [&](auto nc) {
+                restrictLinear<decltype(nc)::value>(batch, scale);
+            });
+            break;
+        }
+        case RestrictionRule::MASS_WEIGHTED:
+            if (!batch.child_density) {
+                throw std::invalid_argument("RestrictionBatch: mass-weighted rule needs child_density");
+            }
+            dispatchComponents(batch.num_components, [&](auto nc) {
+                restrictMassWeighted<decltype(nc)::value>(batch);
+            });
+            break;
+        case RestrictionRule::LBM_EQ_NONEQ:
+            if (batch.num_components != entry.lbm.velocities.size()) {
+                throw std::invalid_argument("RestrictionBatch: population count does not match the lattice");
+            }
+            restrictLbm(entry.lbm, batch);
+            break;
+    }
+}
+
+std::string FieldAveragingRuleRegistry::deviceKernelName(const std::string& field_name) {
+    std::string name = "restrict_";
+    for (char ch : field_name) {
+        bool ident = (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9');
+        name += ident ? ch : '_';
+    }
+    return name;
+}
+
+std::string FieldAveragingRuleRegistry::generateDeviceSource(const std::string& field_name,
+                                                             uint32_t num_components) const {
+    const RuleEntry& entry = getRule(field_name);
+    if (num_components == 0) {
+        throw std::invalid_argument("generateDeviceSource: num_components must be > 0");
+    }
+    if (entry.rule == RestrictionRule::LBM_EQ_NONEQ && num_components != entry.lbm.velocities.size()) {
+        throw std::invalid_argument("generateDeviceSource: population count does not match the lattice");
+    }
+
+    const std::string kernel = deviceKernelName(field_name);
+    const std::string nc = std::to_string(num_components) + "u";
+    std::ostringstream src;
+
+    src << "// Restriction of '" << field_name << "' (" << ruleName(entry.rule) << "), "
+        << num_components << " component(s); one work-item per parent\n";
+
+    if (entry.rule == RestrictionRule::LBM_EQ_NONEQ) {
+        const auto& lbm = entry.lbm;
+        const std::string q = std::to_string(lbm.velocities.size());
+        auto table = [&](const char* name, auto value_of) {
+            src << "__constant float " << kernel << "_" << name << "[" << q << "] = {";
+            for (size_t i = 0; i < lbm.velocities.size(); ++i) {
+                src << (i ? ", " : "") << floatLiteral(value_of(i));
+            }
+            src << "};\n";
+        };
+        table("cx", [&](size_t i) { return lbm.velocities[i][0]; });
+        table("cy", [&](size_t i) { return lbm.velocities[i][1]; });
+        table("cz", [&](size_t i) { return lbm.velocities[i][2]; });
+        table("w", [&](size_t i) { return lbm.weights[i]; });
+    }
+
+    src << "__kernel void " << kernel << "(\n"
+        << "    __global const uint* restrict group_children,\n"
+        << "    __global const float* restrict child_field,\n"
+        << "    __global float* restrict parent_field,\n";
+    if (entry.rule == RestrictionRule::MASS_WEIGHTED) {
+        src << "    __global const float* restrict child_density,\n";
+    }
+    src << "    const uint num_parents) {\n"
+        << "    const uint p = get_global_id(0);\n"
+        << "    if (p >= num_parents) return;\n"
+        << "    __global const uint* children = group_children + (size_t)p * 8;\n"
+        << "    __global float* out = parent_field + (size_t)p * " << nc << ";\n";
+
+    switch (entry.rule) {
+        case RestrictionRule::ARITHMETIC:
+        case RestrictionRule::VOLUME_WEIGHTED:
+            src << "    for (uint c = 0; c < " << nc << "; ++c) {\n"
+                << "        float sum = 0.0f;\n"
+                << "        for (uint k = 0; k < 8; ++k) sum += child_field[(size_t)children[k] * " << nc << " + c];\n"
+                << "        out[c] = sum * " << floatLiteral(entry.rule == RestrictionRule::ARITHMETIC ? 0.125 : 1.0) << ";\n"
+                << "    }\n";
+            break;
+        case RestrictionRule::MASS_WEIGHTED:
+            src << "    float mass = 0.0f;\n"
+                << "    for (uint k = 0; k < 8; ++k) mass += child_density[children[k]];\n"
+                << "    const float inv_mass = 1.0f / mass;\n"
+                << "    for (uint c = 0; c < " << nc << "; ++c) {\n"
+                << "        float sum = 0.0f;\n"
+                << "        for (uint k = 0; k < 8; ++k) {\n"
+                << "            const float v = child_field[(size_t)children[k] * " << nc << " + c];\n"
+                << "            sum += (mass > 0.0f ? child_density[children[k]] : 1.0f) * v;\n"
+                << "        }\n"
+                << "        out[c] = mass > 0.0f ? sum * inv_mass : sum * 0.125f;\n"
+                << "    }\n";
+            break;
+        case RestrictionRule::LBM_EQ_NONEQ: {
+            const auto& lbm = entry.lbm;
+            const std::string cs2 = floatLiteral(lbm.cs2);
+            const std::string t = kernel + "_";
+            src << "    float neq_sum[" << nc << "];\n"
+                << "    for (uint q = 0; q < " << nc << "; ++q) neq_sum[q] = 0.0f;\n"
+                << "    float mass = 0.0f, jx = 0.0f, jy = 0.0f, jz = 0.0f;\n"
+                << "    for (uint k = 0; k < 8; ++k) {\n"
+                << "        __global const float* f = child_field + (size_t)children[k] * " << nc << ";\n"
+                << "        float rho = 0.0f, mx = 0.0f, my = 0.0f, mz = 0.0f;\n"
+                << "        for (uint q = 0; q < " << nc << "; ++q) {\n"
+                << "            rho += f[q];\n"
+                << "            mx += f[q] * " << t << "cx[q];\n"
+                << "            my += f[q] * " << t << "cy[q];\n"
+                << "            mz += f[q] * " << t << "cz[q];\n"
+                << "        }\n"
+                << "        const float inv_rho = rho > 0.0f ? 1.0f / rho : 0.0f;\n"
+                << "        const float ux = mx * inv_rho, uy = my * inv_rho, uz = mz * inv_rho;\n"
+                << "        const float uu = ux * ux + uy * uy + uz * uz;\n"
+                << "        for (uint q = 0; q < " << nc << "; ++q) {\n"
+                << "            const float cu = " << t << "cx[q] * ux + " << t << "cy[q] * uy + " << t << "cz[q] * uz;\n"
+                << "            const float feq = " << t << "w[q] * rho * (1.0f + cu / " << cs2 << " + (cu * cu) / (2.0f * "
+                << cs2 << " * " << cs2 << ") - uu / (2.0f * " << cs2 << "));\n"
+                << "            neq_sum[q] += f[q] - feq;\n"
+                << "        }\n"
+                << "        mass += rho; jx += mx; jy += my; jz += mz;\n"
+                << "    }\n"
+                << "    const float rho = mass * 0.125f;\n"
+                << "    const float inv_mass = mass > 0.0f ? 1.0f / mass : 0.0f;\n"
+                << "    const float ux = jx * inv_mass, uy = jy * inv_mass, uz = jz * inv_mass;\n"
+                << "    const float uu = ux * ux + uy * uy + uz * uz;\n"
+                << "    for (uint q = 0; q < " << nc << "; ++q) {\n"
+                << "        const float cu = " << t << "cx[q] * ux + " << t << "cy[q] * uy + " << t << "cz[q] * uz;\n"
+                << "        const float feq = " << t << "w[q] * rho * (1.0f + cu / " << cs2 << " + (cu * cu) / (2.0f * "
+                << cs2 << " * " << cs2 << ") - uu / (2.0f * " << cs2 << "));\n"
+                << "        out[q] = feq + " << floatLiteral(lbm.nonEquilibriumScale()) << " * (neq_sum[q] * 0.125f);\n"
+                << "    }\n";
+            break;
+        }
+    }
+    src << "}\n";
+    return src.str();
+}
+
+} // namespace adaptation
+} // namespace fluidloom
@@ -1,5 +1,6 @@
 #include "fluidloom/adaptation/MergeEngine.h"
 #include "fluidloom/adaptation/CellDescriptor.h"
+#include "fluidloom/adaptation/FieldAveragingRules.h"
 #include "fluidloom/common/FluidLoomError.h"
 #include "fluidloom/common/Logger.h"
 #include <fstream>
@@ -14,9 +15,12 @@ namespace adaptation {
 
 MergeEngine::MergeEngine(cl_context context, cl_command_queue queue, const AdaptationConfig& config)
     : m_context(context), m_queue(queue), m_config(config), m_program(nullptr),
-      m_kernel_mark_siblings(nullptr), m_kernel_merge_fields(nullptr), m_kernel_create_parents(nullptr),
-      m_hash_table(nullptr), m_hash_table_size(0) {
+      m_kernel_mark_siblings(nullptr), m_kernel_assign_groups(nullptr),
+      m_kernel_merge_fields(nullptr), m_kernel_create_parents(nullptr),
+      m_kernel_build_hash(nullptr), m_hash_table(nullptr), m_hash_table_size(0),
+      m_merge_group_id(nullptr), m_group_children(nullptr), m_num_children(0), m_num_groups(0) {
     compileKernels();
+    m_scan = std::make_unique<scan::PrefixScan>(context, queue);
 }
 
 MergeEngine::~MergeEngine() {
@@ -25,10 +29,19 @@ MergeEngine::~MergeEngine() {
 
 void MergeEngine::releaseResources() {
     if (m_kernel_mark_siblings) clReleaseKernel(m_kernel_mark_siblings);
+    if (m_kernel_assign_groups) clReleaseKernel(m_kernel_assign_groups);
     if (m_kernel_merge_fields) clReleaseKernel(m_kernel_merge_fields);
     if (m_kernel_create_parents) clReleaseKernel(m_kernel_create_parents);
+    if (m_kernel_build_hash) clReleaseKernel(m_kernel_build_hash);
     if (m_program) clReleaseProgram(m_program);
     if (m_hash_table) clReleaseMemObject(m_hash_table);
+    if (m_merge_group_id) clReleaseMemObject(m_merge_group_id);
+    if (m_group_children) clReleaseMemObject(m_group_children);
+    for (auto& entry : m_restrict_kernels) {
+        if (entry.second.kernel) clReleaseKernel(entry.second.kernel);
+        if (entry.second.program) clReleaseProgram(entry.second.program);
+    }
+    m_restrict_kernels.clear();
 }
 
 std::string MergeEngine::loadKernelSource(const std::string& filename) {
@@ -52,14 +65,33 @@ void MergeEngine::compileKernels() {
     }
     
     std::string full_src = hilbert_src + "\n" + merge_src;
+    m_program = buildProgram(full_src, "MergeEngine program");
     
-    const char* src_str = full_src.c_str();
-    size_t src_len = full_src.length();
     cl_int err;
-    m_program = clCreateProgramWithSource(m_context, 1, &src_str, &src_len, &err);
-    if (err != CL_SUCCESS) throw std::runtime_error("Failed to create program");
+    m_kernel_mark_siblings = clCreateKernel(m_program, "mark_sibling_groups", &err);
+    if (err != CL_SUCCESS) throw std::runtime_error("Failed to create mark_sibling_groups kernel");
+    
+    m_kernel_assign_groups = clCreateKernel(m_program, "assign_merge_groups", &err);
+    if (err != CL_SUCCESS) throw std::runtime_error("Failed to create assign_merge_groups kernel");
+    
+    m_kernel_merge_fields = clCreateKernel(m_program, "merge_fields", &err);
+    if (err != CL_SUCCESS) throw std::runtime_error("Failed to create merge_fields kernel");
     
-    err = clBuildProgram(m_program, 0, nullptr, "-cl-std=CL1.2", nullptr, nullptr);
+    m_kernel_create_parents = clCreateKernel(m_program, "create_parent_cells", &err);
+    if (err != CL_SUCCESS) throw std::runtime_error("Failed to create create_parent_cells kernel");
+    
+    m_kernel_build_hash = clCreateKernel(m_program, "build_cell_hash", &err);
+    if (err != CL_SUCCESS) throw std::runtime_error("Failed to create build_cell_hash kernel");
+}
+
+cl_program MergeEngine::buildProgram(const std::string& source, const std::string& what) {
+    const char* src_str = source.c_str();
+    size_t src_len = source.length();
+    cl_int err;
+    cl_program program = clCreateProgramWithSource(m_context, 1, &src_str, &src_len, &err);
+    if (err != CL_SUCCESS) throw std::runtime_error("Failed to create " + what);
+    
+    err = clBuildProgram(program, 0, nullptr, "-cl-std=CL1.2", nullptr, nullptr);
     if (err != CL_SUCCESS) {
         size_t device_size;
         clGetContextInfo(m_context, CL_CONTEXT_DEVICES, 0, nullptr, &device_size);
@@ -68,99 +100,93 @@ void MergeEngine::compileKernels() {
         
         if (!devices.empty()) {
              size_t log_size;
-             clGetProgramBuildInfo(m_program, devices[0], CL_PROGRAM_BUILD_LOG, 0, nullptr, &log_size);
+             clGetProgramBuildInfo(program, devices[0], CL_PROGRAM_BUILD_LOG, 0, nullptr, &log_size);
              std::vector<char> log(log_size + 1);
-             clGetProgramBuildInfo(m_program, devices[0], CL_PROGRAM_BUILD_LOG, log_size, log.data(), nullptr);
+             clGetProgramBuildInfo(program, devices[0], CL_PROGRAM_BUILD_LOG, log_size, log.data(), nullptr);
              log[log_size] = '\0';
              FL_LOG(ERROR) << "Build log: " << log.data();
         }
-        throw std::runtime_error("Failed to build MergeEngine program");
+        clReleaseProgram(program);
+        throw std::runtime_error("Failed to build " + what);
     }
-    
-    m_kernel_mark_siblings = clCreateKernel(m_program, "mark_sibling_groups", &err);
-    if (err != CL_SUCCESS) throw std::runtime_error("Failed to create mark_sibling_groups kernel");
-    
-    m_kernel_merge_fields = clCreateKernel(m_program, "merge_fields", &err);
-    if (err != CL_SUCCESS) throw std::runtime_error("Failed to create merge_fields kernel");
-    
-    m_kernel_create_parents = clCreateKernel(m_program, "create_parent_cells", &err);
-    if (err != CL_SUCCESS) throw std::runtime_error("Failed to create create_parent_cells kernel");
+    return program;
 }
 
 void MergeEngine::buildHashTable(cl_mem x, cl_mem y, cl_mem z, size_t num_cells) {
-    // Host-side hash table build for now
-    // 1. Read coordinates
-    std::vector<int> h_x(num_cells), h_y(num_cells), h_z(num_cells);
-    clEnqueueReadBuffer(m_queue, x, CL_TRUE, 0, num_cells * sizeof(int), h_x.data(), 0, nullptr, nullptr);
-    clEnqueueReadBuffer(m_queue, y, CL_TRUE, 0, num_cells * sizeof(int), h_y.data(), 0, nullptr, nullptr);
-    clEnqueueReadBuffer(m_queue, z, CL_TRUE, 0, num_cells * sizeof(int), h_z.data(), 0, nullptr, nullptr);
-    
-    // 2. Compute Hilbert indices and fill hash table
+    // Built on the device by build_cell_hash, so the coordinates stay there
     // Size should be power of 2 and > num_cells to reduce collisions
     size_t table_size = 1;
     while (table_size < num_cells * 2) table_size *= 2;
     if (table_size < 1024) table_size = 1024;
     
-    std::vector<uint32_t> h_table(table_size, INVALID_INDEX);
-    
-    for (size_t i = 0; i < num_cells; ++i) {
-        uint64_t hilbert = hilbert_encode_3d(h_x[i], h_y[i], h_z[i], MAX_REFINEMENT_LEVEL);
-        uint32_t hash = hilbert % table_size;
-        
-        // Linear probing
-        size_t probes = 0;
-        while (h_table[hash] != INVALID_INDEX && probes < table_size) {
-            hash = (hash + 1) % table_size;
-            probes++;
-        }
-        
-        if (h_table[hash] == INVALID_INDEX) {
-            h_table[hash] = static_cast<uint32_t>(i);
-        } else {
-            FL_LOG(ERROR) << "Hash table full in MergeEngine!";
-        }
-    }
-    
-    // 3. Upload to GPU
     if (m_hash_table && m_hash_table_size != table_size) {
         clReleaseMemObject(m_hash_table);
         m_hash_table = nullptr;
     }
     
+    cl_int err;
     if (!m_hash_table) {
-        cl_int err;
         m_hash_table = clCreateBuffer(m_context, CL_MEM_READ_WRITE, table_size * sizeof(uint32_t), nullptr, &err);
         if (err != CL_SUCCESS) throw std::runtime_error("Failed to allocate hash table");
         m_hash_table_size = table_size;
     }
     
-    clEnqueueWriteBuffer(m_queue, m_hash_table, CL_TRUE, 0, table_size * sizeof(uint32_t), h_table.data(), 0, nullptr, nullptr);
+    uint32_t invalid = INVALID_INDEX;
+    err = clEnqueueFillBuffer(m_queue, m_hash_table, &invalid, sizeof(uint32_t), 0, table_size * sizeof(uint32_t), 0, nullptr, nullptr);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to clear hash table");
+    
+    cl_uint table_size_uint = static_cast<cl_uint>(table_size);
+    cl_uint num_cells_uint = static_cast<cl_uint>(num_cells);
+    clSetKernelArg(m_kernel_build_hash, 0, sizeof(cl_mem), &x);
+    clSetKernelArg(m_kernel_build_hash, 1, sizeof(cl_mem), &y);
+    clSetKernelArg(m_kernel_build_hash, 2, sizeof(cl_mem), &z);
+    clSetKernelArg(m_kernel_build_hash, 3, sizeof(cl_mem), &m_hash_table);
+    clSetKernelArg(m_kernel_build_hash, 4, sizeof(cl_uint), &table_size_uint);
+    clSetKernelArg(m_kernel_build_hash, 5, sizeof(cl_uint), &num_cells_uint);
+    
+    size_t local_work_size = 256;
+    size_t global_work_size = ((num_cells + local_work_size - 1) / local_work_size) * local_work_size;
+    err = clEnqueueNDRangeKernel(m_queue, m_kernel_build_hash, 1, nullptr, &global_work_size, &local_work_size, 0, nullptr, nullptr);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to enqueue hash build kernel");
 }
 
-MergeResult MergeEngine::merge(
+void MergeEngine::findGroups(
     cl_mem child_x, cl_mem child_y, cl_mem child_z,
     cl_mem child_level, cl_mem child_states,
     cl_mem refine_flags,
-    cl_mem child_material_id,
     size_t num_children,
-    cl_mem child_fields,
-    uint32_t num_field_components
+    cl_mem total_buffer, size_t total_index
 ) {
-    MergeResult result;
     cl_int err;
     
-    if (num_children == 0) return result;
+    // Drop the previous merge's tables (restrictField refers to the last merge)
+    if (m_merge_group_id) clReleaseMemObject(m_merge_group_id);
+    if (m_group_children) clReleaseMemObject(m_group_children);
+    m_merge_group_id = nullptr;
+    m_group_children = nullptr;
+    m_num_children = static_cast<uint32_t>(num_children);
+    m_num_groups = 0;
+    
+    if (num_children == 0) {
+        m_scan->exclusiveScan(nullptr, nullptr, 0, total_buffer, total_index);
+        return;
+    }
     
     // 1. Build hash table
     buildHashTable(child_x, child_y, child_z, num_children);
     
-    // 2. Allocate temporary buffers
-    cl_mem merge_group_id = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_children * sizeof(uint32_t), nullptr, &err);
-    cl_mem group_counter = clCreateBuffer(m_context, CL_MEM_READ_WRITE, sizeof(uint32_t), nullptr, &err);
+    // 2. Allocate the group tables; a group has 8 members, so the sibling
+    // table never needs more than num_children entries
+    m_merge_group_id = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_children * sizeof(uint32_t), nullptr, &err);
+    if (err != CL_SUCCESS) throw std::runtime_error("Failed to allocate merge group buffers");
+    m_group_children = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_children * sizeof(uint32_t), nullptr, &err);
+    if (err != CL_SUCCESS) throw std::runtime_error("Failed to allocate sibling table");
+    cl_mem group_flags = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_children * sizeof(uint32_t), nullptr, &err);
+    if (err != CL_SUCCESS) throw std::runtime_error("Failed to allocate merge group buffers");
     
-    // Initialize counter to 0
-    uint32_t zero = 0;
-    clEnqueueWriteBuffer(m_queue, group_counter, CL_TRUE, 0, sizeof(uint32_t), &zero, 0, nullptr, nullptr);
+    // Group members are claimed by their first sibling, so the ids start invalid
+    uint32_t invalid = INVALID_INDEX;
+    clEnqueueFillBuffer(m_queue, m_merge_group_id, &invalid, sizeof(uint32_t), 0, num_children * sizeof(uint32_t), 0, nullptr, nullptr);
     
     // 3. Run mark siblings kernel
     clSetKernelArg(m_kernel_mark_siblings, 0, sizeof(cl_mem), &child_x);
@@ -169,25 +195,13 @@ MergeResult MergeEngine::merge(
     clSetKernelArg(m_kernel_mark_siblings, 3, sizeof(cl_mem), &child_level);
     clSetKernelArg(m_kernel_mark_siblings, 4, sizeof(cl_mem), &refine_flags);
     clSetKernelArg(m_kernel_mark_siblings, 5, sizeof(cl_mem), &child_states);
-    clSetKernelArg(m_kernel_mark_siblings, 6, sizeof(cl_mem), &merge_group_id);
-    clSetKernelArg(m_kernel_mark_siblings, 7, sizeof(cl_mem), &group_counter);
-    clSetKernelArg(m_kernel_mark_siblings, 8, sizeof(cl_mem), nullptr); // cell_hilbert (not used if we compute on fly or pass nullptr)
-    // Wait, kernel signature has cell_hilbert. If we don't have it precomputed, we can pass nullptr if kernel handles it?
-    // The kernel computes sibling_hilbert but doesn't seem to use cell_hilbert input except maybe for optimization?
-    // Checking kernel: "const ulong* restrict cell_hilbert". It is NOT used in the body shown in previous view_file.
-    // It computes sibling_hilbert using hilbert_encode_3d.
-    // So we can pass nullptr or a dummy buffer.
-    // Actually, passing nullptr for __global pointer might be unsafe if kernel tries to access it.
-    // But the kernel code I saw earlier didn't use it.
-    // I'll pass a dummy buffer just in case or nullptr if I'm sure.
-    // To be safe, I'll create a dummy buffer if needed, but clSetKernelArg with nullptr for __global memory usually means NULL pointer in kernel.
-    // If kernel doesn't dereference it, it's fine.
-    
+    clSetKernelArg(m_kernel_mark_siblings, 6, sizeof(cl_mem), &m_merge_group_id);
+    clSetKernelArg(m_kernel_mark_siblings, 7, sizeof(cl_mem), &group_flags);
+    clSetKernelArg(m_kernel_mark_siblings, 8, sizeof(cl_mem), nullptr); // cell_hilbert: unused, siblings are hashed on the fly
     clSetKernelArg(m_kernel_mark_siblings, 9, sizeof(cl_mem), &m_hash_table);
     cl_uint table_size_uint = static_cast<cl_uint>(m_hash_table_size);
     clSetKernelArg(m_kernel_mark_siblings, 10, sizeof(cl_uint), &table_size_uint);
-    cl_uint num_children_uint = static_cast<cl_uint>(num_children);
-    clSetKernelArg(m_kernel_mark_siblings, 11, sizeof(cl_uint), &num_children_uint);
+    clSetKernelArg(m_kernel_mark_siblings, 11, sizeof(cl_uint), &m_num_children);
     
     size_t global_work_size = ((num_children + 255) / 256) * 256;
     size_t local_work_size = 256;
@@ -195,142 +209,204 @@ MergeResult MergeEngine::merge(
     err = clEnqueueNDRangeKernel(m_queue, m_kernel_mark_siblings, 1, nullptr, &global_work_size, &local_work_size, 0, nullptr, nullptr);
     if (err != CL_SUCCESS) throw std::runtime_error("Failed to enqueue mark siblings kernel");
     
-    // 4. Read back group counter
-    uint32_t num_groups = 0;
-    clEnqueueReadBuffer(m_queue, group_counter, CL_TRUE, 0, sizeof(uint32_t), &num_groups, 0, nullptr, nullptr);
-    
-    if (num_groups == 0) {
-        clReleaseMemObject(merge_group_id);
-        clReleaseMemObject(group_counter);
-        return result;
-    }
+    // 4. Number the groups in cell order: scan the flags in place; the total
+    // is the group count and stays on the device
+    m_scan->exclusiveScan(group_flags, group_flags, num_children, total_buffer, total_index);
     
-    // 5. Create group_to_parent map
-    // We need to map group_id -> parent_idx (0 to num_groups-1)
-    // Since group IDs are allocated atomically from 0 to num_groups-1, the mapping is identity: group_id IS the parent_idx.
-    // So group_to_parent[i] = i.
-    // We create a buffer for this.
+    // 5. Group IDs and sibling table
+    clSetKernelArg(m_kernel_assign_groups, 0, sizeof(cl_mem), &child_x);
+    clSetKernelArg(m_kernel_assign_groups, 1, sizeof(cl_mem), &child_y);
+    clSetKernelArg(m_kernel_assign_groups, 2, sizeof(cl_mem), &child_z);
+    clSetKernelArg(m_kernel_assign_groups, 3, sizeof(cl_mem), &m_merge_group_id);
+    clSetKernelArg(m_kernel_assign_groups, 4, sizeof(cl_mem), &group_flags);
+    clSetKernelArg(m_kernel_assign_groups, 5, sizeof(cl_mem), &m_group_children);
+    clSetKernelArg(m_kernel_assign_groups, 6, sizeof(cl_uint), &m_num_children);
     
-    std::vector<uint32_t> h_group_to_parent(num_groups);
-    for (uint32_t i = 0; i < num_groups; ++i) h_group_to_parent[i] = i;
+    err = clEnqueueNDRangeKernel(m_queue, m_kernel_assign_groups, 1, nullptr, &global_work_size, &local_work_size, 0, nullptr, nullptr);
+    if (err != CL_SUCCESS) throw std::runtime_error("Failed to enqueue assign groups kernel");
     
-    cl_mem group_to_parent = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_groups * sizeof(uint32_t), nullptr, &err);
-    clEnqueueWriteBuffer(m_queue, group_to_parent, CL_TRUE, 0, num_groups * sizeof(uint32_t), h_group_to_parent.data(), 0, nullptr, nullptr);
-    
-    // 6. Create parent buffers
-    cl_mem parent_x = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_groups * sizeof(int), nullptr, &err);
-    cl_mem parent_y = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_groups * sizeof(int), nullptr, &err);
-    cl_mem parent_z = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_groups * sizeof(int), nullptr, &err);
-    cl_mem parent_level = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_groups * sizeof(uint8_t), nullptr, &err);
-    cl_mem parent_states = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_groups * sizeof(uint8_t), nullptr, &err);
-    cl_mem parent_mat_id = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_groups * sizeof(uint32_t), nullptr, &err);
+    // Released once the queued kernels have run
+    clReleaseMemObject(group_flags);
+}
+
+void MergeEngine::buildParents(
+    cl_mem child_x, cl_mem child_y, cl_mem child_z,
+    cl_mem child_level, cl_mem child_states,
+    cl_mem child_material_id,
+    size_t num_groups,
+    cl_mem dst_x, cl_mem dst_y, cl_mem dst_z,
+    cl_mem dst_level, cl_mem dst_states,
+    cl_mem dst_material_id,
+    size_t dst_offset
+) {
+    if (num_groups == 0) return;
+    if (!m_merge_group_id) {
+        throw std::logic_error("buildParents: findGroups() has not run");
+    }
+    m_num_groups = static_cast<uint32_t>(num_groups);
     
-    // 7. Run create parents kernel
+    // Group IDs are the parent indices, so no group_to_parent table is passed
+    cl_mem group_to_parent = nullptr;
+    cl_uint dst_offset_uint = static_cast<cl_uint>(dst_offset);
     clSetKernelArg(m_kernel_create_parents, 0, sizeof(cl_mem), &child_x);
     clSetKernelArg(m_kernel_create_parents, 1, sizeof(cl_mem), &child_y);
     clSetKernelArg(m_kernel_create_parents, 2, sizeof(cl_mem), &child_z);
     clSetKernelArg(m_kernel_create_parents, 3, sizeof(cl_mem), &child_level);
     clSetKernelArg(m_kernel_create_parents, 4, sizeof(cl_mem), &child_states);
     clSetKernelArg(m_kernel_create_parents, 5, sizeof(cl_mem), &child_material_id);
-    clSetKernelArg(m_kernel_create_parents, 6, sizeof(cl_mem), &merge_group_id);
+    clSetKernelArg(m_kernel_create_parents, 6, sizeof(cl_mem), &m_merge_group_id);
     clSetKernelArg(m_kernel_create_parents, 7, sizeof(cl_mem), &group_to_parent);
-    clSetKernelArg(m_kernel_create_parents, 8, sizeof(cl_mem), &parent_x);
-    clSetKernelArg(m_kernel_create_parents, 9, sizeof(cl_mem), &parent_y);
-    clSetKernelArg(m_kernel_create_parents, 10, sizeof(cl_mem), &parent_z);
-    clSetKernelArg(m_kernel_create_parents, 11, sizeof(cl_mem), &parent_level);
-    clSetKernelArg(m_kernel_create_parents, 12, sizeof(cl_mem), &parent_states);
-    clSetKernelArg(m_kernel_create_parents, 13, sizeof(cl_mem), &parent_mat_id);
-    clSetKernelArg(m_kernel_create_parents, 14, sizeof(cl_uint), &num_children_uint);
-    
-    err = clEnqueueNDRangeKernel(m_queue, m_kernel_create_parents, 1, nullptr, &global_work_size, &local_work_size, 0, nullptr, nullptr);
+    clSetKernelArg(m_kernel_create_parents, 8, sizeof(cl_mem), &dst_x);
+    clSetKernelArg(m_kernel_create_parents, 9, sizeof(cl_mem), &dst_y);
+    clSetKernelArg(m_kernel_create_parents, 10, sizeof(cl_mem), &dst_z);
+    clSetKernelArg(m_kernel_create_parents, 11, sizeof(cl_mem), &dst_level);
+    clSetKernelArg(m_kernel_create_parents, 12, sizeof(cl_mem), &dst_states);
+    clSetKernelArg(m_kernel_create_parents, 13, sizeof(cl_mem), &dst_material_id);
+    clSetKernelArg(m_kernel_create_parents, 14, sizeof(cl_uint), &dst_offset_uint);
+    clSetKernelArg(m_kernel_create_parents, 15, sizeof(cl_uint), &m_num_children);
+    
+    size_t local_work_size = 256;
+    size_t global_work_size = ((m_num_children + local_work_size - 1) / local_work_size) * local_work_size;
+    cl_int err = clEnqueueNDRangeKernel(m_queue, m_kernel_create_parents, 1, nullptr, &global_work_size, &local_work_size, 0, nullptr, nullptr);
     if (err != CL_SUCCESS) throw std::runtime_error("Failed to enqueue create parents kernel");
+}
+
+MergeResult MergeEngine::merge(
+    cl_mem child_x, cl_mem child_y, cl_mem child_z,
+    cl_mem child_level, cl_mem child_states,
+    cl_mem refine_flags,
+    cl_mem child_material_id,
+    size_t num_children,
+    cl_mem child_fields,
+    uint32_t num_field_components,
+    const std::string& field_name,
+    cl_mem child_density
+) {
+    MergeResult result;
+    cl_int err;
     
-    // 8. Merge fields if provided
+    if (num_children == 0) return result;
+    
+    // 1. Find groups; the group count is the one value read back
+    cl_mem total_buffer = clCreateBuffer(m_context, CL_MEM_READ_WRITE, sizeof(uint32_t), nullptr, &err);
+    if (err != CL_SUCCESS) throw std::runtime_error("Failed to allocate group count");
+    findGroups(child_x, child_y, child_z, child_level, child_states, refine_flags, num_children, total_buffer, 0);
+    
+    uint32_t num_groups = 0;
+    err = clEnqueueReadBuffer(m_queue, total_buffer, CL_TRUE, 0, sizeof(uint32_t), &num_groups, 0, nullptr, nullptr);
+    clReleaseMemObject(total_buffer);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to read group count");
+    
+    if (num_groups == 0) return result;
+    
+    // 2. Create parent buffers (owned by the result)
+    result.parent_x = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_groups * sizeof(int), nullptr, &err);
+    result.parent_y = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_groups * sizeof(int), nullptr, &err);
+    result.parent_z = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_groups * sizeof(int), nullptr, &err);
+    result.parent_level = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_groups * sizeof(uint8_t), nullptr, &err);
+    result.parent_states = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_groups * sizeof(uint8_t), nullptr, &err);
+    result.parent_material_id = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_groups * sizeof(uint32_t), nullptr, &err);
+    if (err != CL_SUCCESS) throw std::runtime_error("Failed to allocate parent buffers");
+    
+    buildParents(child_x, child_y, child_z, child_level, child_states, child_material_id, num_groups,
+                 result.parent_x, result.parent_y, result.parent_z, result.parent_level, result.parent_states,
+                 result.parent_material_id, 0);
+    
+    // 3. Merge fields if provided: one work-item per parent gathers its children
     if (child_fields && num_field_components > 0) {
-        cl_mem parent_fields = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_groups * num_field_components * sizeof(float), nullptr, &err);
-        
-        // Initialize parent fields to 0
-        float zero_f = 0.0f;
-        clEnqueueFillBuffer(m_queue, parent_fields, &zero_f, sizeof(float), 0, num_groups * num_field_components * sizeof(float), 0, nullptr, nullptr);
-        
-        clSetKernelArg(m_kernel_merge_fields, 0, sizeof(cl_mem), &merge_group_id);
-        clSetKernelArg(m_kernel_merge_fields, 1, sizeof(cl_mem), &group_to_parent);
-        clSetKernelArg(m_kernel_merge_fields, 2, sizeof(cl_mem), &child_fields);
-        clSetKernelArg(m_kernel_merge_fields, 3, sizeof(cl_mem), &parent_fields);
-        clSetKernelArg(m_kernel_merge_fields, 4, sizeof(cl_uint), &num_field_components);
-        
-        // Averaging rule: 0=arithmetic, 1=volume_weighted. Config should specify.
-        // Default to arithmetic (0) for now or parse config string.
-        uint32_t rule = (m_config.default_averaging_rule == "volume_weighted") ? 1 : 0;
-        clSetKernelArg(m_kernel_merge_fields, 5, sizeof(cl_uint), &rule);
-        
-        clSetKernelArg(m_kernel_merge_fields, 6, sizeof(cl_uint), &num_children_uint);
-        
-        err = clEnqueueNDRangeKernel(m_queue, m_kernel_merge_fields, 1, nullptr, &global_work_size, &local_work_size, 0, nullptr, nullptr);
-        if (err != CL_SUCCESS) throw std::runtime_error("Failed to enqueue merge fields kernel");
-        
-        // Read back averaged fields
-        result.averaged_fields.resize(num_groups * num_field_components);
-        clEnqueueReadBuffer(m_queue, parent_fields, CL_TRUE, 0, result.averaged_fields.size() * sizeof(float), result.averaged_fields.data(), 0, nullptr, nullptr);
+        RestrictionRule rule = FieldAveragingRuleRegistry::getInstance().getRule(field_name).rule;
+        if (field_name.empty()) {
+            rule = (m_config.default_averaging_rule == "volume_weighted")
+                ? RestrictionRule::VOLUME_WEIGHTED : RestrictionRule::ARITHMETIC;
+        }
         
-        clReleaseMemObject(parent_fields);
+        if (rule == RestrictionRule::ARITHMETIC || rule == RestrictionRule::VOLUME_WEIGHTED) {
+            result.averaged_fields = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_groups * num_field_components * sizeof(float), nullptr, &err);
+            if (err != CL_SUCCESS) throw std::runtime_error("Failed to allocate parent fields");
+            
+            cl_mem group_to_parent = nullptr;  // Identity
+            clSetKernelArg(m_kernel_merge_fields, 0, sizeof(cl_mem), &m_group_children);
+            clSetKernelArg(m_kernel_merge_fields, 1, sizeof(cl_mem), &group_to_parent);
+            clSetKernelArg(m_kernel_merge_fields, 2, sizeof(cl_mem), &child_fields);
+            clSetKernelArg(m_kernel_merge_fields, 3, sizeof(cl_mem), &result.averaged_fields);
+            clSetKernelArg(m_kernel_merge_fields, 4, sizeof(cl_uint), &num_field_components);
+            cl_uint rule_uint = static_cast<cl_uint>(rule);
+            clSetKernelArg(m_kernel_merge_fields, 5, sizeof(cl_uint), &rule_uint);
+            cl_uint num_groups_uint = num_groups;
+            clSetKernelArg(m_kernel_merge_fields, 6, sizeof(cl_uint), &num_groups_uint);
+            
+            size_t group_local_size = 64;
+            size_t group_global_size = ((num_groups + group_local_size - 1) / group_local_size) * group_local_size;
+            err = clEnqueueNDRangeKernel(m_queue, m_kernel_merge_fields, 1, nullptr, &group_global_size, &group_local_size, 0, nullptr, nullptr);
+            if (err != CL_SUCCESS) throw std::runtime_error("Failed to enqueue merge fields kernel");
+        } else {
+            // Mass-weighted and LBM rules use the registry's generated kernel
+            result.averaged_fields = restrictField(field_name, child_fields, num_field_components, child_density);
+        }
     }
     
-    // 9. Read back results
-    std::vector<int> h_parent_x(num_groups);
-    std::vector<int> h_parent_y(num_groups);
-    std::vector<int> h_parent_z(num_groups);
-    std::vector<uint8_t> h_parent_level(num_groups);
-    std::vector<uint8_t> h_parent_states(num_groups);
-    std::vector<uint32_t> h_parent_mat_id(num_groups);
-    
-    clEnqueueReadBuffer(m_queue, parent_x, CL_TRUE, 0, num_groups * sizeof(int), h_parent_x.data(), 0, nullptr, nullptr);
-    clEnqueueReadBuffer(m_queue, parent_y, CL_TRUE, 0, num_groups * sizeof(int), h_parent_y.data(), 0, nullptr, nullptr);
-    clEnqueueReadBuffer(m_queue, parent_z, CL_TRUE, 0, num_groups * sizeof(int), h_parent_z.data(), 0, nullptr, nullptr);
-    clEnqueueReadBuffer(m_queue, parent_level, CL_TRUE, 0, num_groups * sizeof(uint8_t), h_parent_level.data(), 0, nullptr, nullptr);
-    clEnqueueReadBuffer(m_queue, parent_states, CL_TRUE, 0, num_groups * sizeof(uint8_t), h_parent_states.data(), 0, nullptr, nullptr);
-    clEnqueueReadBuffer(m_queue, parent_mat_id, CL_TRUE, 0, num_groups * sizeof(uint32_t), h_parent_mat_id.data(), 0, nullptr, nullptr);
-    
-    result.parents.resize(num_groups);
-    for (size_t i = 0; i < num_groups; ++i) {
-        CellDescriptor& cell = result.parents[i];
-        cell.x = h_parent_x[i];
-        cell.y = h_parent_y[i];
-        cell.z = h_parent_z[i];
-        cell.level = h_parent_level[i];
-        cell.state = h_parent_states[i];
-        cell.material_id = h_parent_mat_id[i];
-        cell.visited = 0;
-        cell.reserved = 0;
-    }
+    result.success = true;
+    result.num_parents_created = num_groups;
+    result.num_children_merged = static_cast<size_t>(num_groups) * 8;
+    
+    return result;
+}
+
+cl_mem MergeEngine::restrictField(
+    const std::string& field_name,
+    cl_mem child_field,
+    uint32_t num_components,
+    cl_mem child_density
+) {
+    if (m_num_groups == 0 || !child_field || num_components == 0) return nullptr;
     
-    // Populate merged_child_indices
-    std::vector<uint32_t> h_merge_group_id(num_children);
-    clEnqueueReadBuffer(m_queue, merge_group_id, CL_TRUE, 0, num_children * sizeof(uint32_t), h_merge_group_id.data(), 0, nullptr, nullptr);
+    const auto& registry = FieldAveragingRuleRegistry::getInstance();
+    const bool mass_weighted = registry.getRule(field_name).rule == RestrictionRule::MASS_WEIGHTED;
+    if (mass_weighted && !child_density) {
+        throw std::invalid_argument("restrictField: " + field_name + " is mass-weighted and needs a density buffer");
+    }
     
-    for (size_t i = 0; i < num_children; ++i) {
-        if (h_merge_group_id[i] != INVALID_INDEX) {
-            result.merged_child_indices.insert(i);
+    // Generate and build the field's kernel on first use
+    std::string key = field_name + ":" + std::to_string(num_components);
+    auto it = m_restrict_kernels.find(key);
+    if (it == m_restrict_kernels.end()) {
+        RestrictKernel entry;
+        entry.program = buildProgram(registry.generateDeviceSource(field_name, num_components),
+                                     "restriction kernel for " + field_name);
+        cl_int err;
+        std::string kernel_name = FieldAveragingRuleRegistry::deviceKernelName(field_name);
+        entry.kernel = clCreateKernel(entry.program, kernel_name.c_str(), &err);
+        if (err != CL_SUCCESS) {
+            clReleaseProgram(entry.program);
+            throw std::runtime_error("Failed to create " + kernel_name + " kernel");
         }
+        it = m_restrict_kernels.emplace(key, entry).first;
     }
+    cl_kernel kernel = it->second.kernel;
     
-    result.success = true;
-    result.num_parents_created = num_groups;
-    result.num_children_merged = result.merged_child_indices.size();
-    result.group_to_parent_map = h_group_to_parent;
-    
-    // Cleanup
-    clReleaseMemObject(merge_group_id);
-    clReleaseMemObject(group_counter);
-    clReleaseMemObject(group_to_parent);
-    clReleaseMemObject(parent_x);
-    clReleaseMemObject(parent_y);
-    clReleaseMemObject(parent_z);
-    clReleaseMemObject(parent_level);
-    clReleaseMemObject(parent_states);
-    clReleaseMemObject(parent_mat_id);
+    cl_int err;
+    size_t parent_bytes = static_cast<size_t>(m_num_groups) * num_components * sizeof(float);
+    cl_mem parent_field = clCreateBuffer(m_context, CL_MEM_READ_WRITE, parent_bytes, nullptr, &err);
+    if (err != CL_SUCCESS) throw std::runtime_error("Failed to allocate restricted field");
+    
+    cl_uint arg = 0;
+    clSetKernelArg(kernel, arg++, sizeof(cl_mem), &m_group_children);
+    clSetKernelArg(kernel, arg++, sizeof(cl_mem), &child_field);
+    clSetKernelArg(kernel, arg++, sizeof(cl_mem), &parent_field);
+    if (mass_weighted) {
+        clSetKernelArg(kernel, arg++, sizeof(cl_mem), &child_density);
+    }
+    cl_uint num_parents = m_num_groups;
+    clSetKernelArg(kernel, arg++, sizeof(cl_uint), &num_parents);
     
-    return result;
+    size_t local_work_size = 64;
+    size_t global_work_size = ((m_num_groups + local_work_size - 1) / local_work_size) * local_work_size;
+    err = clEnqueueNDRangeKernel(m_queue, kernel, 1, nullptr, &global_work_size, &local_work_size, 0, nullptr, nullptr);
+    if (err != CL_SUCCESS) {
+        clReleaseMemObject(parent_field);
+        throw std::runtime_error("Failed to enqueue restriction kernel for " + field_name);
+    }
+    return parent_field;
 }
 
 } // namespace adaptation
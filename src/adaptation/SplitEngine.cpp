@@ -1,5 +1,6 @@
 #include "fluidloom/adaptation/SplitEngine.h"
 #include "fluidloom/adaptation/CellDescriptor.h"
+#include "fluidloom/adaptation/FieldAveragingRules.h"
 #include "fluidloom/common/FluidLoomError.h"
 #include "fluidloom/common/Logger.h"
 #include <fstream>
@@ -13,8 +14,12 @@ namespace adaptation {
 
 SplitEngine::SplitEngine(cl_context context, cl_command_queue queue, const AdaptationConfig& config)
     : m_context(context), m_queue(queue), m_config(config), m_program(nullptr),
-      m_kernel_count_allocate(nullptr), m_kernel_generate_children(nullptr), m_kernel_interpolate(nullptr) {
+      m_kernel_count_children(nullptr), m_kernel_generate_children(nullptr), m_kernel_prolong(nullptr),
+      m_kernel_build_hash(nullptr), m_hash_table(nullptr), m_hash_table_size(0),
+      m_child_counts(nullptr), m_child_block_start(nullptr), m_child_parent(nullptr),
+      m_parent_neighbors(nullptr), m_num_parents(0), m_num_children(0) {
     compileKernels();
+    m_scan = std::make_unique<scan::PrefixScan>(context, queue);
 }
 
 SplitEngine::~SplitEngine() {
@@ -22,10 +27,16 @@ SplitEngine::~SplitEngine() {
 }
 
 void SplitEngine::releaseResources() {
-    if (m_kernel_count_allocate) clReleaseKernel(m_kernel_count_allocate);
+    if (m_kernel_count_children) clReleaseKernel(m_kernel_count_children);
     if (m_kernel_generate_children) clReleaseKernel(m_kernel_generate_children);
-    if (m_kernel_interpolate) clReleaseKernel(m_kernel_interpolate);
+    if (m_kernel_prolong) clReleaseKernel(m_kernel_prolong);
+    if (m_kernel_build_hash) clReleaseKernel(m_kernel_build_hash);
     if (m_program) clReleaseProgram(m_program);
+    if (m_hash_table) clReleaseMemObject(m_hash_table);
+    if (m_child_counts) clReleaseMemObject(m_child_counts);
+    if (m_child_block_start) clReleaseMemObject(m_child_block_start);
+    if (m_child_parent) clReleaseMemObject(m_child_parent);
+    if (m_parent_neighbors) clReleaseMemObject(m_parent_neighbors);
 }
 
 std::string SplitEngine::loadKernelSource(const std::string& filename) {
@@ -82,189 +93,282 @@ void SplitEngine::compileKernels() {
     }
     
     // Create kernels
-    m_kernel_count_allocate = clCreateKernel(m_program, "split_count_and_allocate", &err);
-    if (err != CL_SUCCESS) throw std::runtime_error("Failed to create split_count_and_allocate kernel");
+    m_kernel_count_children = clCreateKernel(m_program, "split_count_children", &err);
+    if (err != CL_SUCCESS) throw std::runtime_error("Failed to create split_count_children kernel");
     
     m_kernel_generate_children = clCreateKernel(m_program, "split_generate_children", &err);
     if (err != CL_SUCCESS) throw std::runtime_error("Failed to create split_generate_children kernel");
     
-    m_kernel_interpolate = clCreateKernel(m_program, "interpolate_split_fields", &err);
-    if (err != CL_SUCCESS) throw std::runtime_error("Failed to create interpolate_split_fields kernel");
+    m_kernel_prolong = clCreateKernel(m_program, "prolong_split_fields", &err);
+    if (err != CL_SUCCESS) throw std::runtime_error("Failed to create prolong_split_fields kernel");
+    
+    m_kernel_build_hash = clCreateKernel(m_program, "build_cell_hash", &err);
+    if (err != CL_SUCCESS) throw std::runtime_error("Failed to create build_cell_hash kernel");
 }
 
-SplitResult SplitEngine::split(
-    cl_mem parent_x, cl_mem parent_y, cl_mem parent_z,
-    cl_mem parent_level, cl_mem parent_states,
-    cl_mem refine_flags,
-    cl_mem parent_material_id,
+void SplitEngine::buildHashTable(cl_mem x, cl_mem y, cl_mem z, size_t num_cells) {
+    // Built on the device by build_cell_hash, keyed like MergeEngine's
+    size_t table_size = 1;
+    while (table_size < num_cells * 2) table_size *= 2;
+    if (table_size < 1024) table_size = 1024;
+    
+    if (m_hash_table && m_hash_table_size != table_size) {
+        clReleaseMemObject(m_hash_table);
+        m_hash_table = nullptr;
+    }
+    
+    cl_int err;
+    if (!m_hash_table) {
+        m_hash_table = clCreateBuffer(m_context, CL_MEM_READ_WRITE, table_size * sizeof(uint32_t), nullptr, &err);
+        if (err != CL_SUCCESS) throw std::runtime_error("Failed to allocate hash table");
+        m_hash_table_size = table_size;
+    }
+    
+    uint32_t invalid = INVALID_INDEX;
+    err = clEnqueueFillBuffer(m_queue, m_hash_table, &invalid, sizeof(uint32_t), 0, table_size * sizeof(uint32_t), 0, nullptr, nullptr);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to clear hash table");
+    
+    cl_uint table_size_uint = static_cast<cl_uint>(table_size);
+    cl_uint num_cells_uint = static_cast<cl_uint>(num_cells);
+    clSetKernelArg(m_kernel_build_hash, 0, sizeof(cl_mem), &x);
+    clSetKernelArg(m_kernel_build_hash, 1, sizeof(cl_mem), &y);
+    clSetKernelArg(m_kernel_build_hash, 2, sizeof(cl_mem), &z);
+    clSetKernelArg(m_kernel_build_hash, 3, sizeof(cl_mem), &m_hash_table);
+    clSetKernelArg(m_kernel_build_hash, 4, sizeof(cl_uint), &table_size_uint);
+    clSetKernelArg(m_kernel_build_hash, 5, sizeof(cl_uint), &num_cells_uint);
+    
+    size_t local_work_size = 256;
+    size_t global_work_size = ((num_cells + local_work_size - 1) / local_work_size) * local_work_size;
+    err = clEnqueueNDRangeKernel(m_queue, m_kernel_build_hash, 1, nullptr, &global_work_size, &local_work_size, 0, nullptr, nullptr);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to enqueue hash build kernel");
+}
+
+void SplitEngine::countChildren(
+    cl_mem parent_level, cl_mem refine_flags, cl_mem parent_states,
     size_t num_parents,
-    cl_mem parent_fields,
-    uint32_t num_field_components
+    cl_mem total_buffer, size_t total_index
 ) {
-    SplitResult result;
     cl_int err;
     
-    if (num_parents == 0) return result;
-    
-    // 1. Allocate temporary buffers
-    cl_mem cell_scratch = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_parents * sizeof(uint32_t), nullptr, &err);
-    if (err != CL_SUCCESS) throw std::runtime_error("Failed to allocate cell_scratch");
+    // Drop the previous split's tables (prolongField refers to the last split)
+    for (cl_mem* buffer : {&m_child_counts, &m_child_block_start, &m_child_parent, &m_parent_neighbors}) {
+        if (*buffer) clReleaseMemObject(*buffer);
+        *buffer = nullptr;
+    }
+    m_num_parents = static_cast<uint32_t>(num_parents);
+    m_num_children = 0;
     
-    cl_mem child_block_start = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_parents * sizeof(uint32_t), nullptr, &err);
-    if (err != CL_SUCCESS) {
-        clReleaseMemObject(cell_scratch);
-        throw std::runtime_error("Failed to allocate child_block_start");
+    if (num_parents == 0) {
+        m_scan->exclusiveScan(nullptr, nullptr, 0, total_buffer, total_index);
+        return;
     }
     
+    // 1. Allocate the count and block start tables
+    m_child_counts = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_parents * sizeof(uint32_t), nullptr, &err);
+    if (err != CL_SUCCESS) throw std::runtime_error("Failed to allocate child_counts");
+    
+    m_child_block_start = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_parents * sizeof(uint32_t), nullptr, &err);
+    if (err != CL_SUCCESS) throw std::runtime_error("Failed to allocate child_block_start");
+    
     // 2. Run count kernel
-    clSetKernelArg(m_kernel_count_allocate, 0, sizeof(cl_mem), &parent_x);
-    clSetKernelArg(m_kernel_count_allocate, 1, sizeof(cl_mem), &parent_y);
-    clSetKernelArg(m_kernel_count_allocate, 2, sizeof(cl_mem), &parent_z);
-    clSetKernelArg(m_kernel_count_allocate, 3, sizeof(cl_mem), &parent_level);
-    clSetKernelArg(m_kernel_count_allocate, 4, sizeof(cl_mem), &refine_flags);
-    clSetKernelArg(m_kernel_count_allocate, 5, sizeof(cl_mem), &parent_states);
-    clSetKernelArg(m_kernel_count_allocate, 6, sizeof(cl_mem), &child_block_start);
-    clSetKernelArg(m_kernel_count_allocate, 7, sizeof(cl_mem), &cell_scratch);
-    cl_uint num_parents_uint = static_cast<cl_uint>(num_parents);
-    clSetKernelArg(m_kernel_count_allocate, 8, sizeof(cl_uint), &num_parents_uint);
+    clSetKernelArg(m_kernel_count_children, 0, sizeof(cl_mem), &parent_level);
+    clSetKernelArg(m_kernel_count_children, 1, sizeof(cl_mem), &refine_flags);
+    clSetKernelArg(m_kernel_count_children, 2, sizeof(cl_mem), &parent_states);
+    clSetKernelArg(m_kernel_count_children, 3, sizeof(cl_mem), &m_child_counts);
+    clSetKernelArg(m_kernel_count_children, 4, sizeof(cl_uint), &m_num_parents);
     
     size_t global_work_size = ((num_parents + 255) / 256) * 256;
     size_t local_work_size = 256;
     
-    err = clEnqueueNDRangeKernel(m_queue, m_kernel_count_allocate, 1, nullptr, &global_work_size, &local_work_size, 0, nullptr, nullptr);
+    err = clEnqueueNDRangeKernel(m_queue, m_kernel_count_children, 1, nullptr, &global_work_size, &local_work_size, 0, nullptr, nullptr);
     if (err != CL_SUCCESS) throw std::runtime_error("Failed to enqueue count kernel");
     
-    // 3. Read back scratch buffer for host-side scan
-    std::vector<uint32_t> host_scratch(num_parents);
-    err = clEnqueueReadBuffer(m_queue, cell_scratch, CL_TRUE, 0, num_parents * sizeof(uint32_t), host_scratch.data(), 0, nullptr, nullptr);
-    if (err != CL_SUCCESS) throw std::runtime_error("Failed to read scratch buffer");
-    
-    // 4. Perform prefix sum on host
-    std::vector<uint32_t> host_block_start(num_parents);
-    uint32_t total_children = 0;
-    uint32_t parents_split_count = 0;
-    
-    result.parent_to_child_map.resize(num_parents);
-    result.split_parent_indices.reserve(num_parents / 8); // Heuristic
-    
-    for (size_t i = 0; i < num_parents; ++i) {
-        if (host_scratch[i] == 1) {
-            host_block_start[i] = total_children;
-            result.parent_to_child_map[i] = total_children;
-            result.split_parent_indices.push_back(i);
-            total_children += 8;
-            parents_split_count++;
-        } else {
-            host_block_start[i] = 0xFFFFFFFF; // INVALID_INDEX
-            result.parent_to_child_map[i] = 0xFFFFFFFF;
-        }
+    // 3. Child block offsets by device scan; the total stays on the device too
+    m_scan->exclusiveScan(m_child_counts, m_child_block_start, num_parents, total_buffer, total_index);
+}
+
+cl_mem SplitEngine::generateChildren(
+    cl_mem parent_x, cl_mem parent_y, cl_mem parent_z,
+    cl_mem parent_level, cl_mem parent_states,
+    cl_mem parent_material_id,
+    size_t num_children,
+    cl_mem dst_x, cl_mem dst_y, cl_mem dst_z,
+    cl_mem dst_level, cl_mem dst_states,
+    cl_mem dst_material_id,
+    size_t dst_offset,
+    cl_mem parent_fields,
+    uint32_t num_field_components,
+    const std::string& field_name
+) {
+    if (num_children == 0) return nullptr;
+    if (!m_child_block_start) {
+        throw std::logic_error("generateChildren: countChildren() has not run");
     }
     
-    result.num_children = total_children;
-    result.num_parents_split = parents_split_count;
+    cl_int err;
+    m_num_children = static_cast<uint32_t>(num_children);
+    
+    // Old parent of every child, for field remapping
+    m_child_parent = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_children * sizeof(uint32_t), nullptr, &err);
+    if (err != CL_SUCCESS) throw std::runtime_error("Failed to allocate child parent table");
     
-    if (total_children == 0) {
-        clReleaseMemObject(cell_scratch);
-        clReleaseMemObject(child_block_start);
-        return result;
+    // Parent face neighbors, only when some field reconstructs slopes
+    const auto& registry = FieldAveragingRuleRegistry::getInstance();
+    cl_mem hash_table = nullptr;
+    cl_uint hash_table_size = 0;
+    if (registry.hasSlopeProlongation()) {
+        buildHashTable(parent_x, parent_y, parent_z, m_num_parents);
+        hash_table = m_hash_table;
+        hash_table_size = static_cast<cl_uint>(m_hash_table_size);
+        m_parent_neighbors = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_children / 8 * 6 * sizeof(uint32_t), nullptr, &err);
+        if (err != CL_SUCCESS) throw std::runtime_error("Failed to allocate parent neighbors");
     }
     
-    // 5. Write back block start indices
-    err = clEnqueueWriteBuffer(m_queue, child_block_start, CL_TRUE, 0, num_parents * sizeof(uint32_t), host_block_start.data(), 0, nullptr, nullptr);
-    if (err != CL_SUCCESS) throw std::runtime_error("Failed to write block start buffer");
+    // Fields provided are prolonged by the same kernel
+    cl_mem child_fields = nullptr;
+    cl_uint num_components_uint = 0;
+    const auto& rule = registry.getRule(field_name);
+    cl_uint prolongation_rule = static_cast<cl_uint>(rule.prolongation);
+    cl_float child_scale = FieldAveragingRuleRegistry::prolongationScale(rule.rule);
+    if (parent_fields && num_field_components > 0) {
+        child_fields = clCreateBuffer(m_context, CL_MEM_READ_WRITE, num_children * num_field_components * sizeof(float), nullptr, &err);
+        if (err != CL_SUCCESS) throw std::runtime_error("Failed to allocate child fields");
+        num_components_uint = num_field_components;
+    } else {
+        parent_fields = nullptr;
+    }
     
-    // 6. Allocate child buffers
-    cl_mem child_x = clCreateBuffer(m_context, CL_MEM_READ_WRITE, total_children * sizeof(int), nullptr, &err);
-    cl_mem child_y = clCreateBuffer(m_context, CL_MEM_READ_WRITE, total_children * sizeof(int), nullptr, &err);
-    cl_mem child_z = clCreateBuffer(m_context, CL_MEM_READ_WRITE, total_children * sizeof(int), nullptr, &err);
-    cl_mem child_level = clCreateBuffer(m_context, CL_MEM_READ_WRITE, total_children * sizeof(uint8_t), nullptr, &err);
-    cl_mem child_states = clCreateBuffer(m_context, CL_MEM_READ_WRITE, total_children * sizeof(uint8_t), nullptr, &err);
-    cl_mem child_mat_id = clCreateBuffer(m_context, CL_MEM_READ_WRITE, total_children * sizeof(uint32_t), nullptr, &err);
-    cl_mem child_hilbert = clCreateBuffer(m_context, CL_MEM_READ_WRITE, total_children * sizeof(uint64_t), nullptr, &err);
+    cl_mem child_hilbert = nullptr;
+    cl_uint dst_offset_uint = static_cast<cl_uint>(dst_offset);
     
-    // 7. Run generate children kernel
+    // Run generate children kernel
     clSetKernelArg(m_kernel_generate_children, 0, sizeof(cl_mem), &parent_x);
     clSetKernelArg(m_kernel_generate_children, 1, sizeof(cl_mem), &parent_y);
     clSetKernelArg(m_kernel_generate_children, 2, sizeof(cl_mem), &parent_z);
     clSetKernelArg(m_kernel_generate_children, 3, sizeof(cl_mem), &parent_level);
     clSetKernelArg(m_kernel_generate_children, 4, sizeof(cl_mem), &parent_states);
     clSetKernelArg(m_kernel_generate_children, 5, sizeof(cl_mem), &parent_material_id);
-    clSetKernelArg(m_kernel_generate_children, 6, sizeof(cl_mem), &child_block_start);
-    clSetKernelArg(m_kernel_generate_children, 7, sizeof(cl_mem), &child_x);
-    clSetKernelArg(m_kernel_generate_children, 8, sizeof(cl_mem), &child_y);
-    clSetKernelArg(m_kernel_generate_children, 9, sizeof(cl_mem), &child_z);
-    clSetKernelArg(m_kernel_generate_children, 10, sizeof(cl_mem), &child_level);
-    clSetKernelArg(m_kernel_generate_children, 11, sizeof(cl_mem), &child_states);
-    clSetKernelArg(m_kernel_generate_children, 12, sizeof(cl_mem), &child_mat_id);
-    clSetKernelArg(m_kernel_generate_children, 13, sizeof(cl_mem), &child_hilbert);
-    clSetKernelArg(m_kernel_generate_children, 14, sizeof(cl_uint), &num_parents_uint);
-    
-    global_work_size = ((num_parents + 255) / 256) * 256;
-    err = clEnqueueNDRangeKernel(m_queue, m_kernel_generate_children, 1, nullptr, &global_work_size, &local_work_size, 0, nullptr, nullptr);
-    if (err != CL_SUCCESS) throw std::runtime_error("Failed to enqueue generate children kernel");
+    clSetKernelArg(m_kernel_generate_children, 6, sizeof(cl_mem), &m_child_counts);
+    clSetKernelArg(m_kernel_generate_children, 7, sizeof(cl_mem), &m_child_block_start);
+    clSetKernelArg(m_kernel_generate_children, 8, sizeof(cl_mem), &dst_x);
+    clSetKernelArg(m_kernel_generate_children, 9, sizeof(cl_mem), &dst_y);
+    clSetKernelArg(m_kernel_generate_children, 10, sizeof(cl_mem), &dst_z);
+    clSetKernelArg(m_kernel_generate_children, 11, sizeof(cl_mem), &dst_level);
+    clSetKernelArg(m_kernel_generate_children, 12, sizeof(cl_mem), &dst_states);
+    clSetKernelArg(m_kernel_generate_children, 13, sizeof(cl_mem), &dst_material_id);
+    clSetKernelArg(m_kernel_generate_children, 14, sizeof(cl_mem), &child_hilbert);
+    clSetKernelArg(m_kernel_generate_children, 15, sizeof(cl_mem), &m_child_parent);
+    clSetKernelArg(m_kernel_generate_children, 16, sizeof(cl_uint), &dst_offset_uint);
+    clSetKernelArg(m_kernel_generate_children, 17, sizeof(cl_mem), &hash_table);
+    clSetKernelArg(m_kernel_generate_children, 18, sizeof(cl_uint), &hash_table_size);
+    clSetKernelArg(m_kernel_generate_children, 19, sizeof(cl_mem), &m_parent_neighbors);
+    clSetKernelArg(m_kernel_generate_children, 20, sizeof(cl_mem), &parent_fields);
+    clSetKernelArg(m_kernel_generate_children, 21, sizeof(cl_mem), &child_fields);
+    clSetKernelArg(m_kernel_generate_children, 22, sizeof(cl_uint), &num_components_uint);
+    clSetKernelArg(m_kernel_generate_children, 23, sizeof(cl_uint), &prolongation_rule);
+    clSetKernelArg(m_kernel_generate_children, 24, sizeof(cl_float), &child_scale);
+    clSetKernelArg(m_kernel_generate_children, 25, sizeof(cl_uint), &m_num_parents);
     
-    // 8. Interpolate fields if provided
-    if (parent_fields && num_field_components > 0) {
-        cl_mem child_fields = clCreateBuffer(m_context, CL_MEM_READ_WRITE, total_children * num_field_components * sizeof(float), nullptr, &err);
-        
-        clSetKernelArg(m_kernel_interpolate, 0, sizeof(cl_mem), &child_block_start);
-        clSetKernelArg(m_kernel_interpolate, 1, sizeof(cl_mem), &parent_fields);
-        clSetKernelArg(m_kernel_interpolate, 2, sizeof(cl_mem), &child_fields);
-        clSetKernelArg(m_kernel_interpolate, 3, sizeof(cl_uint), &num_field_components);
-        clSetKernelArg(m_kernel_interpolate, 4, sizeof(cl_uint), &num_parents_uint);
-        
-        err = clEnqueueNDRangeKernel(m_queue, m_kernel_interpolate, 1, nullptr, &global_work_size, &local_work_size, 0, nullptr, nullptr);
-        if (err != CL_SUCCESS) throw std::runtime_error("Failed to enqueue interpolate kernel");
-        
-        clReleaseMemObject(child_fields);
+    size_t local_work_size = 256;
+    size_t global_work_size = ((m_num_parents + local_work_size - 1) / local_work_size) * local_work_size;
+    err = clEnqueueNDRangeKernel(m_queue, m_kernel_generate_children, 1, nullptr, &global_work_size, &local_work_size, 0, nullptr, nullptr);
+    if (err != CL_SUCCESS) {
+        if (child_fields) clReleaseMemObject(child_fields);
+        throw std::runtime_error("Failed to enqueue generate children kernel");
     }
     
-    // 9. Read back results
-    std::vector<int> h_child_x(total_children);
-    std::vector<int> h_child_y(total_children);
-    std::vector<int> h_child_z(total_children);
-    std::vector<uint8_t> h_child_level(total_children);
-    std::vector<uint8_t> h_child_states(total_children);
-    std::vector<uint32_t> h_child_mat_id(total_children);
-    std::vector<uint64_t> h_child_hilbert(total_children);
-    
-    clEnqueueReadBuffer(m_queue, child_x, CL_TRUE, 0, total_children * sizeof(int), h_child_x.data(), 0, nullptr, nullptr);
-    clEnqueueReadBuffer(m_queue, child_y, CL_TRUE, 0, total_children * sizeof(int), h_child_y.data(), 0, nullptr, nullptr);
-    clEnqueueReadBuffer(m_queue, child_z, CL_TRUE, 0, total_children * sizeof(int), h_child_z.data(), 0, nullptr, nullptr);
-    clEnqueueReadBuffer(m_queue, child_level, CL_TRUE, 0, total_children * sizeof(uint8_t), h_child_level.data(), 0, nullptr, nullptr);
-    clEnqueueReadBuffer(m_queue, child_states, CL_TRUE, 0, total_children * sizeof(uint8_t), h_child_states.data(), 0, nullptr, nullptr);
-    clEnqueueReadBuffer(m_queue, child_mat_id, CL_TRUE, 0, total_children * sizeof(uint32_t), h_child_mat_id.data(), 0, nullptr, nullptr);
-    clEnqueueReadBuffer(m_queue, child_hilbert, CL_TRUE, 0, total_children * sizeof(uint64_t), h_child_hilbert.data(), 0, nullptr, nullptr);
-    
-    // Populate result.children
-    result.children.resize(total_children);
-    for (size_t i = 0; i < total_children; ++i) {
-        CellDescriptor& cell = result.children[i];
-        cell.x = h_child_x[i];
-        cell.y = h_child_y[i];
-        cell.z = h_child_z[i];
-        cell.level = h_child_level[i];
-        cell.state = h_child_states[i];
-        cell.material_id = h_child_mat_id[i];
-        cell.visited = 0;
-        cell.reserved = 0;
-    }
+    // Prolonged fields stay on the device
+    return child_fields;
+}
+
+SplitResult SplitEngine::split(
+    cl_mem parent_x, cl_mem parent_y, cl_mem parent_z,
+    cl_mem parent_level, cl_mem parent_states,
+    cl_mem refine_flags,
+    cl_mem parent_material_id,
+    size_t num_parents,
+    cl_mem parent_fields,
+    uint32_t num_field_components,
+    const std::string& field_name
+) {
+    SplitResult result;
+    cl_int err;
     
-    result.success = true;
+    if (num_parents == 0) return result;
+    
+    // 1. Count; the child total is the one value read back
+    cl_mem total_buffer = clCreateBuffer(m_context, CL_MEM_READ_WRITE, sizeof(uint32_t), nullptr, &err);
+    if (err != CL_SUCCESS) throw std::runtime_error("Failed to allocate child total");
+    countChildren(parent_level, refine_flags, parent_states, num_parents, total_buffer, 0);
+    
+    uint32_t total_children = 0;
+    err = clEnqueueReadBuffer(m_queue, total_buffer, CL_TRUE, 0, sizeof(uint32_t), &total_children, 0, nullptr, nullptr);
+    clReleaseMemObject(total_buffer);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to read child total");
+    
+    result.num_children = total_children;
+    result.num_parents_split = total_children / 8;
+    if (total_children == 0) return result;
     
-    // Cleanup
-    clReleaseMemObject(cell_scratch);
-    clReleaseMemObject(child_block_start);
-    clReleaseMemObject(child_x);
-    clReleaseMemObject(child_y);
-    clReleaseMemObject(child_z);
-    clReleaseMemObject(child_level);
-    clReleaseMemObject(child_states);
-    clReleaseMemObject(child_mat_id);
-    clReleaseMemObject(child_hilbert);
+    // 2. Allocate child buffers (owned by the result)
+    result.child_x = clCreateBuffer(m_context, CL_MEM_READ_WRITE, total_children * sizeof(int), nullptr, &err);
+    result.child_y = clCreateBuffer(m_context, CL_MEM_READ_WRITE, total_children * sizeof(int), nullptr, &err);
+    result.child_z = clCreateBuffer(m_context, CL_MEM_READ_WRITE, total_children * sizeof(int), nullptr, &err);
+    result.child_level = clCreateBuffer(m_context, CL_MEM_READ_WRITE, total_children * sizeof(uint8_t), nullptr, &err);
+    result.child_states = clCreateBuffer(m_context, CL_MEM_READ_WRITE, total_children * sizeof(uint8_t), nullptr, &err);
+    result.child_material_id = clCreateBuffer(m_context, CL_MEM_READ_WRITE, total_children * sizeof(uint32_t), nullptr, &err);
+    if (err != CL_SUCCESS) throw std::runtime_error("Failed to allocate child buffers");
     
+    // 3. Generate
+    result.interpolated_fields = generateChildren(
+        parent_x, parent_y, parent_z, parent_level, parent_states, parent_material_id, total_children,
+        result.child_x, result.child_y, result.child_z, result.child_level, result.child_states,
+        result.child_material_id, 0,
+        parent_fields, num_field_components, field_name);
+    
+    result.device_memory_used = total_children * (3 * sizeof(int) + 2 * sizeof(uint8_t) + sizeof(uint32_t));
+    result.success = true;
     return result;
 }
 
+cl_mem SplitEngine::prolongField(
+    const std::string& field_name,
+    cl_mem parent_field,
+    uint32_t num_field_components
+) {
+    if (m_num_children == 0 || !parent_field || num_field_components == 0) return nullptr;
+    
+    const auto& rule = FieldAveragingRuleRegistry::getInstance().getRule(field_name);
+    cl_uint prolongation_rule = static_cast<cl_uint>(rule.prolongation);
+    if (rule.prolongation != ProlongationRule::INJECTION && !m_parent_neighbors) {
+        throw std::logic_error("prolongField: " + field_name + " has a slope-limited rule registered after the split");
+    }
+    cl_float child_scale = FieldAveragingRuleRegistry::prolongationScale(rule.rule);
+    
+    cl_int err;
+    size_t child_bytes = static_cast<size_t>(m_num_children) * num_field_components * sizeof(float);
+    cl_mem child_field = clCreateBuffer(m_context, CL_MEM_READ_WRITE, child_bytes, nullptr, &err);
+    if (err != CL_SUCCESS) throw std::runtime_error("Failed to allocate prolonged field");
+    
+    cl_uint num_components_uint = num_field_components;
+    clSetKernelArg(m_kernel_prolong, 0, sizeof(cl_mem), &m_child_block_start);
+    clSetKernelArg(m_kernel_prolong, 1, sizeof(cl_mem), &m_parent_neighbors);
+    clSetKernelArg(m_kernel_prolong, 2, sizeof(cl_mem), &parent_field);
+    clSetKernelArg(m_kernel_prolong, 3, sizeof(cl_mem), &child_field);
+    clSetKernelArg(m_kernel_prolong, 4, sizeof(cl_uint), &num_components_uint);
+    clSetKernelArg(m_kernel_prolong, 5, sizeof(cl_uint), &prolongation_rule);
+    clSetKernelArg(m_kernel_prolong, 6, sizeof(cl_float), &child_scale);
+    clSetKernelArg(m_kernel_prolong, 7, sizeof(cl_uint), &m_num_parents);
+    
+    size_t local_work_size = 256;
+    size_t global_work_size = ((m_num_parents + local_work_size - 1) / local_work_size) * local_work_size;
+    err = clEnqueueNDRangeKernel(m_queue, m_kernel_prolong, 1, nullptr, &global_work_size, &local_work_size, 0, nullptr, nullptr);
+    if (err != CL_SUCCESS) {
+        clReleaseMemObject(child_field);
+        throw std::runtime_error("Failed to enqueue prolongation kernel for " + field_name);
+    }
+    return child_field;
+}
+
 } // namespace adaptation
 } // namespace fluidloom
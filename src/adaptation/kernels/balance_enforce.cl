@@ -6,49 +6,60 @@
 #define INVALID_INDEX 0xFFFFFFFF
 #define MAX_REFINEMENT_LEVEL 8
 
-// Helper to find a cell containing a point (px, py, pz)
-// Returns the index of the cell if found, or INVALID_INDEX
-uint find_cell_at_point(
-    int px, int py, int pz,
+// The mesh is 2:1 balanced before adaptation and shadow levels add at most one
+// level, so a face neighbor's level is within +-2 of the cell's own level.
+// Probe order within that window, most likely first. -2 is never probed: a
+// neighbor two levels coarser cannot make this cell violate, so a miss on the
+// other four levels means "no violation" either way.
+#define NUM_PROBE_LEVELS 4
+constant int probe_level_offsets[NUM_PROBE_LEVELS] = {0, 1, -1, 2};
+
+// Hilbert key of the point's anchor at `level`, given the encoder state after
+// the point's first `level` digits: the remaining digits encode zero bits
+inline ulong hilbert_anchor_key(ulong prefix, uchar rotation, int level) {
+    ulong key = prefix;
+    for (int d = level; d < MAX_REFINEMENT_LEVEL; ++d) {
+        key = (key << 3) | rotation_table[rotation][0];
+        rotation = direction_table[rotation][0];
+    }
+    return key;
+}
+
+// One digit of hilbert_encode_3d for depth d (bit MAX_REFINEMENT_LEVEL-1-d)
+inline void hilbert_step(int x, int y, int z, int d, ulong* prefix, uchar* rotation) {
+    const int bit = MAX_REFINEMENT_LEVEL - 1 - d;
+    const uchar block = ((x >> bit) & 1) | (((y >> bit) & 1) << 1) | (((z >> bit) & 1) << 2);
+    *prefix = (*prefix << 3) | rotation_table[*rotation][block];
+    *rotation = direction_table[*rotation][block];
+}
+
+// balance_counts holds (violations, cells marked) per iteration. Every
+// iteration is enqueued up front; one runs only while the previous one both
+// found and marked cells, so the host never reads a count in between.
+inline bool balance_iteration_active(__global const uint* balance_counts, const uint iteration) {
+    if (iteration == 0) return true;
+    return balance_counts[2 * (iteration - 1)] != 0 && balance_counts[2 * (iteration - 1) + 1] != 0;
+}
+
+// Index of the cell at `level` anchored at (ax, ay, az), or INVALID_INDEX
+inline uint lookup_cell(
+    ulong key, int ax, int ay, int az, int level,
+    __global const int* restrict coord_x,
+    __global const int* restrict coord_y,
+    __global const int* restrict coord_z,
+    __global const uchar* restrict levels,
     __global const uint* restrict hash_table,
     const uint hash_table_size) {
     
-    // Probe all levels from MAX down to 0 (or 0 to MAX, doesn't matter if mesh is valid)
-    // We iterate 0 to MAX because coarser cells are more likely? No.
-    // Just iterate.
-    for (int l = 0; l <= MAX_REFINEMENT_LEVEL; ++l) {
-        int size = 1 << (MAX_REFINEMENT_LEVEL - l);
-        int mask = ~(size - 1);
-        
-        int ax = px & mask;
-        int ay = py & mask;
-        int az = pz & mask;
-        
-        ulong hilbert = hilbert_encode_3d(ax, ay, az, MAX_REFINEMENT_LEVEL);
-        uint hash = hilbert % hash_table_size;
-        uint idx = hash_table[hash];
-        
-        // Note: This simple hash lookup assumes no collisions or that we don't handle them.
-        // If we have collisions, we might get the wrong cell.
-        // But for now we assume the hash table is built with the same logic (direct mapping).
-        // If the hash table stores the cell index, we should verify the cell matches the key?
-        // But we don't have the keys stored in the table, only indices.
-        // We can check the cell's coordinates and level.
-        // But we don't have access to cell arrays here easily without passing them.
-        // Wait, we DO have access to coord_x, coord_y, etc. in the main kernel.
-        // But this helper doesn't.
-        // So we rely on the hash being correct.
-        
-        if (idx != INVALID_INDEX) {
-            // We found *something*. Is it the correct cell?
-            // We should verify, but for now assume yes.
-            // Wait, if we probe L=0 and find a cell, but the actual cell is L=2...
-            // The L=0 anchor might hash to a slot occupied by some other cell.
-            // This is risky.
-            // But we can't verify without accessing global memory.
-            // Let's inline this logic in the kernel.
+    uint hash = key % hash_table_size;
+    for (uint probe = 0; probe < 64; ++probe) {
+        const uint idx = hash_table[hash];
+        if (idx == INVALID_INDEX) break;
+        if (levels[idx] == level &&
+            coord_x[idx] == ax && coord_y[idx] == ay && coord_z[idx] == az) {
             return idx;
         }
+        hash = (hash + 1) % hash_table_size;
     }
     return INVALID_INDEX;
 }
@@ -64,11 +75,13 @@ __kernel void detect_balance_violations(
     __global const uint* restrict hash_table,
     const uint hash_table_size,
     __global uchar* restrict violation_flags,
-    __global uint* restrict violation_count,
+    __global uint* restrict balance_counts,
+    const uint iteration,
     const uint num_cells) {
     
     const uint idx = get_global_id(0);
     if (idx >= num_cells) return;
+    if (!balance_iteration_active(balance_counts, iteration)) return;
     
     violation_flags[idx] = 0;
     
@@ -78,16 +91,25 @@ __kernel void detect_balance_violations(
     const int cx = coord_x[idx];
     const int cy = coord_y[idx];
     const int cz = coord_z[idx];
-    const uchar my_level = levels[idx];
+    const int my_level = levels[idx];
     const int my_size = 1 << (MAX_REFINEMENT_LEVEL - my_level);
+    const int max_probe_level = min(my_level + 2, MAX_REFINEMENT_LEVEL);
+    
+    // Encoder state of the cell's own anchor after each of its first my_level
+    // digits. A face neighbor point shares the leading digits above its first
+    // differing bit, so its keys resume from here instead of re-encoding.
+    ulong own_prefix[MAX_REFINEMENT_LEVEL + 1];
+    uchar own_rotation[MAX_REFINEMENT_LEVEL + 1];
+    own_prefix[0] = 0;
+    own_rotation[0] = 0;
+    for (int d = 0; d < my_level; ++d) {
+        own_prefix[d + 1] = own_prefix[d];
+        own_rotation[d + 1] = own_rotation[d];
+        hilbert_step(cx, cy, cz, d, &own_prefix[d + 1], &own_rotation[d + 1]);
+    }
     
     // Check 6 face neighbors
     // Directions: -X, +X, -Y, +Y, -Z, +Z
-    // Test points:
-    // -X: cx - 1
-    // +X: cx + my_size
-    // ...
-    
     const int test_points[6][3] = {
         {cx - 1, cy, cz},             // -X
         {cx + my_size, cy, cz},       // +X
@@ -98,49 +120,52 @@ __kernel void detect_balance_violations(
     };
     
     for (int n = 0; n < 6; ++n) {
-        int px = test_points[n][0];
-        int py = test_points[n][1];
-        int pz = test_points[n][2];
+        const int px = test_points[n][0];
+        const int py = test_points[n][1];
+        const int pz = test_points[n][2];
+        
+        // Outside the domain: boundary, nothing to balance against
+        if (((px | py | pz) >> MAX_REFINEMENT_LEVEL) != 0) continue;
         
-        // Probe for neighbor
-        bool found = false;
-        for (int l = 0; l <= MAX_REFINEMENT_LEVEL; ++l) {
-            int size = 1 << (MAX_REFINEMENT_LEVEL - l);
-            int mask = ~(size - 1);
+        // The point leaves this cell, so its first differing bit is above the
+        // cell's own digits and common_depth < my_level
+        const int diff = (px ^ cx) | (py ^ cy) | (pz ^ cz);
+        const int common_depth = MAX_REFINEMENT_LEVEL - 1 - (31 - (int)clz(diff));
+        
+        ulong prefix[MAX_REFINEMENT_LEVEL + 1];
+        uchar rotation[MAX_REFINEMENT_LEVEL + 1];
+        prefix[common_depth] = own_prefix[common_depth];
+        rotation[common_depth] = own_rotation[common_depth];
+        for (int d = common_depth; d < max_probe_level; ++d) {
+            prefix[d + 1] = prefix[d];
+            rotation[d + 1] = rotation[d];
+            hilbert_step(px, py, pz, d, &prefix[d + 1], &rotation[d + 1]);
+        }
+        
+        // Only one cell can contain the point, so the first hit decides
+        for (int k = 0; k < NUM_PROBE_LEVELS; ++k) {
+            const int l = my_level + probe_level_offsets[k];
+            if (l < 0 || l > max_probe_level) continue;
             
-            int ax = px & mask;
-            int ay = py & mask;
-            int az = pz & mask;
+            const int mask = ~((1 << (MAX_REFINEMENT_LEVEL - l)) - 1);
+            const int ax = px & mask;
+            const int ay = py & mask;
+            const int az = pz & mask;
+            const ulong key = hilbert_anchor_key(prefix[l], rotation[l], l);
             
-            ulong hilbert = hilbert_encode_3d(ax, ay, az, MAX_REFINEMENT_LEVEL);
-            uint hash = hilbert % hash_table_size;
+            if (lookup_cell(key, ax, ay, az, l, coord_x, coord_y, coord_z,
+                            levels, hash_table, hash_table_size) == INVALID_INDEX) {
+                continue;
+            }
             
-            // Linear probing
-            for (uint probe = 0; probe < 64; ++probe) {
-                uint neighbor_idx = hash_table[hash];
-                
-                if (neighbor_idx == INVALID_INDEX) break; // Not found
-                
-                if (levels[neighbor_idx] == l &&
-                    coord_x[neighbor_idx] == ax &&
-                    coord_y[neighbor_idx] == ay &&
-                    coord_z[neighbor_idx] == az) {
-                    
-                    // Found neighbor!
-                    // Only flag violation if neighbor is significantly finer than us
-                    // i.e., we are the coarse one that needs to split
-                    if (l > my_level + 1) {
-                        violation_flags[idx] = 1;
-                        atomic_inc(violation_count);
-                        return;
-                    }
-                    found = true;
-                    break; // Found the neighbor at this point
-                }
-                
-                hash = (hash + 1) % hash_table_size;
+            // Only flag violation if neighbor is significantly finer than us
+            // i.e., we are the coarse one that needs to split
+            if (l > my_level + 1) {
+                violation_flags[idx] = 1;
+                atomic_inc(&balance_counts[2 * iteration]);
+                return;
             }
-            if (found) break;
+            break;
         }
         // If not found, it might be a boundary or hole. Ignore.
     }
@@ -155,18 +180,37 @@ __kernel void mark_cascading_refinement(
     __global const uchar* restrict cell_states,
     __global const uchar* restrict violation_flags,
     __global int* restrict refine_flags,
-    __global uint* restrict marked_count,
+    __global uint* restrict balance_counts,
+    const uint iteration,
     const uint num_cells) {
     
     const uint idx = get_global_id(0);
     if (idx >= num_cells) return;
     
+    // No violations also covers an iteration detect skipped
+    if (balance_counts[2 * iteration] == 0) return;
     if (!violation_flags[idx]) return;
     if (cell_states[idx] != 0) return;
     if (levels[idx] >= MAX_REFINEMENT_LEVEL) return;
     
     if (refine_flags[idx] <= 0) {
         refine_flags[idx] = 1;
-        atomic_inc(marked_count);
+        atomic_inc(&balance_counts[2 * iteration + 1]);
     }
 }
+
+// Kernel 3: Levels the next iteration checks, counting this one's marks
+__kernel void update_shadow_levels(
+    __global const uchar* restrict levels,
+    __global const int* restrict refine_flags,
+    __global uchar* restrict shadow_levels,
+    __global const uint* restrict balance_counts,
+    const uint iteration,
+    const uint num_cells) {
+    
+    const uint idx = get_global_id(0);
+    if (idx >= num_cells) return;
+    if (balance_counts[2 * iteration + 1] == 0) return;
+    
+    shadow_levels[idx] = levels[idx] + (refine_flags[idx] > 0 ? 1 : 0);
+}
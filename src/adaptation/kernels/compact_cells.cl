@@ -1,128 +1,29 @@
 // GPU Mesh Compaction Kernels
-// Implements parallel prefix sum (scan) and stream compaction
+// Stream compaction; write offsets come from scan::PrefixScan
 
 #define WORKGROUP_SIZE 256
 
-// 1. Predicate Kernel: Mark cells that should be kept
-// Input: split_refine_flags, merge_refine_flags, cell_states
-// Output: valid_flags (1 if kept, 0 if removed)
+// 1. Predicate Kernel: Mark cells that survive the adaptation
+// A cell is removed if it splits (8 children counted by split_count_children)
+// or was claimed by a merge group (mark_sibling_groups). A cell flagged -1
+// that found no complete group keeps its merge_group_id INVALID and survives.
 __kernel void mark_valid_cells(
-    __global const int* restrict refine_flags,
-    __global const uchar* restrict cell_states,
-    __global const uint* restrict merge_group_id, // If part of a merge group, only parent keeps it? No.
-    // Actually, compaction happens AFTER split/merge logic has generated NEW lists?
-    // No, the plan is:
-    // 1. Split -> generates new children (appended or separate buffer)
-    // 2. Merge -> generates new parents (appended or separate buffer)
-    // 3. Compact -> takes OLD cells + NEW children + NEW parents, removes DEAD cells.
-    // Dead cells are:
-    // - Parents that split (refine_flags > 0)
-    // - Children that merged (merge_group_id != INVALID)
-    // - Cells explicitly marked for removal (if any)
-    
-    // Wait, AdaptationEngine currently:
-    // 1. Collects all UNTOUCHED old cells.
-    // 2. Appends NEW children from splits.
-    // 3. Appends NEW parents from merges.
-    // 4. Sorts and rebuilds.
-    
-    // So we need a kernel to mark "survivors" from the old cell list.
-    // Survivors = (refine_flags <= 0) AND (merge_group_id == INVALID_INDEX)
-    
+    __global const uint* restrict child_counts,
+    __global const uint* restrict merge_group_id,
     __global uint* restrict valid_flags,
     const uint num_cells) {
     
     const uint idx = get_global_id(0);
     if (idx >= num_cells) return;
     
-    int flag = refine_flags[idx];
-    uint grp = merge_group_id[idx];
-    
-    // Keep if NOT splitting AND NOT merging
-    // Note: refine_flags=1 means split. -1 means merge (but merge_group_id handles the actual merge success).
-    // If refine_flags=-1 but merge_group_id is INVALID, it failed to merge, so we KEEP it.
-    
-    bool is_splitting = (flag > 0);
-    bool is_merging = (grp != 0xFFFFFFFF); // INVALID_INDEX
+    const bool is_splitting = child_counts[idx] != 0;
+    const bool is_merging = merge_group_id[idx] != 0xFFFFFFFF; // INVALID_INDEX
     
     valid_flags[idx] = (is_splitting || is_merging) ? 0 : 1;
 }
 
-// 2. Hillis-Steele Scan (Inclusive) - Single Workgroup (for small arrays) or Multi-pass
-// For simplicity, we'll use a simple Blelloch scan or just a global atomic counter for now?
-// Atomic counter is easiest but non-deterministic order.
-// Deterministic order is preferred for debugging.
-// Let's use a standard 3-phase scan:
-// A. Block-wise local scan + write block sums
-// B. Scan block sums
-// C. Add block sums to local results
-
-// Phase A: Local Scan
-__kernel void scan_local(
-    __global uint* restrict input,
-    __global uint* restrict output,
-    __global uint* restrict block_sums,
-    const uint n,
-    __local uint* temp) {
-    
-    uint gid = get_global_id(0);
-    uint lid = get_local_id(0);
-    uint bid = get_group_id(0);
-    
-    // Load input into shared memory
-    if (gid < n) {
-        temp[lid] = input[gid];
-    } else {
-        temp[lid] = 0;
-    }
-    barrier(CLK_LOCAL_MEM_FENCE);
-    
-    // Up-sweep (Reduce)
-    for (uint stride = 1; stride < WORKGROUP_SIZE; stride *= 2) {
-        uint index = (lid + 1) * stride * 2 - 1;
-        if (index < WORKGROUP_SIZE) {
-            temp[index] += temp[index - stride];
-        }
-        barrier(CLK_LOCAL_MEM_FENCE);
-    }
-    
-    // Save block sum
-    if (lid == WORKGROUP_SIZE - 1) {
-        if (block_sums) block_sums[bid] = temp[lid];
-        temp[lid] = 0; // Clear last element for exclusive scan
-    }
-    barrier(CLK_LOCAL_MEM_FENCE);
-    
-    // Down-sweep
-    for (uint stride = WORKGROUP_SIZE / 2; stride > 0; stride /= 2) {
-        uint index = (lid + 1) * stride * 2 - 1;
-        if (index < WORKGROUP_SIZE) {
-            uint t = temp[index - stride];
-            temp[index - stride] = temp[index];
-            temp[index] += t;
-        }
-        barrier(CLK_LOCAL_MEM_FENCE);
-    }
-    
-    // Write output
-    if (gid < n) {
-        output[gid] = temp[lid]; // Exclusive scan result
-    }
-}
-
-// Phase C: Add block sums
-__kernel void scan_add_sums(
-    __global uint* restrict output,
-    __global const uint* restrict block_sums,
-    const uint n) {
-    
-    uint gid = get_global_id(0);
-    uint bid = get_group_id(0);
-    
-    if (gid < n) {
-        output[gid] += block_sums[bid];
-    }
-}
+// 2. Scan: survivor flags are turned into write offsets by
+// scan::PrefixScan (kernels/scan/prefix_scan.cl)
 
 // 3. Compact Kernel
 // Uses the scanned offsets to write valid cells to the new buffer
@@ -171,44 +72,60 @@ __kernel void compact_cells(
     }
 }
 
-// 4. Append Kernel
-// Appends new cells (from split/merge) to the end of the compacted buffer
-__kernel void append_cells(
-    __global const int* restrict src_x,
-    __global const int* restrict src_y,
-    __global const int* restrict src_z,
-    __global const uchar* restrict src_levels,
-    __global const uchar* restrict src_states,
-    __global const uint* restrict src_mat_id,
-    __global const float* restrict src_fields,
-    
-    __global int* restrict dst_x,
-    __global int* restrict dst_y,
-    __global int* restrict dst_z,
-    __global uchar* restrict dst_levels,
-    __global uchar* restrict dst_states,
-    __global uint* restrict dst_mat_id,
-    __global float* restrict dst_fields,
-    
-    const uint src_count,
-    const uint dst_offset,
-    const uint num_components) {
+// 4. Field Record Kernels
+// Fields are remapped as opaque records of record_bytes per cell, so one pair
+// of kernels serves every field type. Records whose size is a multiple of 4
+// are copied by word.
+
+inline void copy_record(__global const uchar* restrict from,
+                        __global uchar* restrict to,
+                        const uint record_bytes) {
+    if ((record_bytes & 3u) == 0) {
+        __global const uint* from_w = (__global const uint*)from;
+        __global uint* to_w = (__global uint*)to;
+        for (uint w = 0; w < record_bytes / 4; ++w) {
+            to_w[w] = from_w[w];
+        }
+    } else {
+        for (uint b = 0; b < record_bytes; ++b) {
+            to[b] = from[b];
+        }
+    }
+}
+
+// Copy the records of surviving cells to their compacted slots
+__kernel void compact_records(
+    __global const uchar* restrict src,
+    __global const uint* restrict valid_flags,
+    __global const uint* restrict scan_offsets,
+    __global uchar* restrict dst,
+    const uint num_cells,
+    const uint record_bytes) {
     
     uint idx = get_global_id(0);
-    if (idx >= src_count) return;
+    if (idx >= num_cells || !valid_flags[idx]) return;
     
-    uint dst_idx = dst_offset + idx;
+    copy_record(src + (size_t)idx * record_bytes,
+                dst + (size_t)scan_offsets[idx] * record_bytes,
+                record_bytes);
+}
+
+// Copy record src_index[k * index_stride] (record k without an index) to
+// slot dst_offset + k
+__kernel void gather_records(
+    __global const uchar* restrict src,
+    __global const uint* restrict src_index,
+    const uint index_stride,
+    __global uchar* restrict dst,
+    const uint dst_offset,
+    const uint count,
+    const uint record_bytes) {
     
-    dst_x[dst_idx] = src_x[idx];
-    dst_y[dst_idx] = src_y[idx];
-    dst_z[dst_idx] = src_z[idx];
-    dst_levels[dst_idx] = src_levels[idx];
-    dst_states[dst_idx] = src_states[idx];
-    dst_mat_id[dst_idx] = src_mat_id[idx];
+    uint k = get_global_id(0);
+    if (k >= count) return;
     
-    if (src_fields && dst_fields) {
-        for (uint c = 0; c < num_components; ++c) {
-            dst_fields[dst_idx * num_components + c] = src_fields[idx * num_components + c];
-        }
-    }
+    uint src_idx = src_index ? src_index[k * index_stride] : k;
+    copy_record(src + (size_t)src_idx * record_bytes,
+                dst + (size_t)(dst_offset + k) * record_bytes,
+                record_bytes);
 }
@@ -84,4 +84,25 @@ inline void hilbert_decode_3d(ulong hilbert, uchar max_level,
     }
 }
 
+// Cell index hash keyed by the finest-level Hilbert index of the cell's
+// coordinates, with linear probing; the split, merge and balance lookups
+// probe it the same way. The table must be filled with 0xFFFFFFFF first.
+__kernel void build_cell_hash(
+    __global const int* restrict coord_x,
+    __global const int* restrict coord_y,
+    __global const int* restrict coord_z,
+    __global uint* restrict hash_table,
+    const uint hash_table_size,
+    const uint num_cells) {
+    
+    const uint idx = get_global_id(0);
+    if (idx >= num_cells) return;
+    
+    uint hash = hilbert_encode_3d(coord_x[idx], coord_y[idx], coord_z[idx], 8) % hash_table_size;
+    for (uint probe = 0; probe < hash_table_size; ++probe) {
+        if (atomic_cmpxchg(&hash_table[hash], 0xFFFFFFFF, idx) == 0xFFFFFFFF) return;
+        hash = (hash + 1) % hash_table_size;
+    }
+}
+
 #endif // HILBERT_ENCODE_3D_CL
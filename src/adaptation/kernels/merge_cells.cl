@@ -7,7 +7,11 @@
 #define MAX_REFINEMENT_LEVEL 8
 
 // Kernel 1: Mark sibling groups that are candidates for merging
-// Uses a hash map to find siblings quickly (avoids O(N^2) search)
+// Uses a hash map to find siblings quickly (avoids O(N^2) search).
+// The first sibling of each complete group sets group_flags and writes its
+// own index into merge_group_id of all 8 members; merge_group_id must be
+// filled with INVALID_INDEX beforehand. An exclusive PrefixScan of
+// group_flags then numbers the groups in cell order (assign_merge_groups).
 __kernel void mark_sibling_groups(
     __global const int* restrict coord_x,
     __global const int* restrict coord_y,
@@ -15,8 +19,8 @@ __kernel void mark_sibling_groups(
     __global const uchar* restrict levels,
     __global const int* restrict refine_flags,
     __global const uchar* restrict cell_states,
-    __global uint* restrict merge_group_id,  // Output: cell_idx → group_id
-    __global uint* restrict group_counter,   // Atomic counter for groups
+    __global uint* restrict merge_group_id,  // Output: cell_idx → first sibling's index
+    __global uint* restrict group_flags,     // Output: 1 for the first sibling of a group, else 0
     __global const ulong* restrict cell_hilbert,  // Pre-computed Hilbert indices
     __global const uint* restrict hash_table,     // Hash table for lookups
     const uint hash_table_size,
@@ -25,8 +29,7 @@ __kernel void mark_sibling_groups(
     const uint idx = get_global_id(0);
     if (idx >= num_cells) return;
     
-    // Initialize output
-    merge_group_id[idx] = INVALID_INDEX;
+    group_flags[idx] = 0;
     
     // Only process cells marked for coarsening AND in FLUID state
     if (refine_flags[idx] != -1 || cell_states[idx] != 0) {
@@ -94,71 +97,80 @@ __kernel void mark_sibling_groups(
         sibling_indices[child] = sibling_idx;
     }
     
-    // All 8 siblings found and valid - assign group ID
+    // All 8 siblings found and valid - claim them for this group
     if (present_mask == 0xFF) {
-        const uint group_id = atomic_inc(group_counter);
-        
-        // Update all siblings in the group
+        group_flags[idx] = 1;
         for (uchar child = 0; child < 8; ++child) {
-            merge_group_id[sibling_indices[child]] = group_id;
+            merge_group_id[sibling_indices[child]] = idx;
         }
     }
 }
 
-inline void atomic_add_float(volatile __global float *addr, float val) {
-    union {
-        uint u;
-        float f;
-    } next, expected, current;
-    current.f = *addr;
-    do {
-        expected.f = current.f;
-        next.f = expected.f + val;
-        current.u = atomic_cmpxchg((volatile __global uint*)addr, expected.u, next.u);
-    } while (current.u != expected.u);
+// Kernel 1b: Replace each member's first-sibling index by its group ID (the
+// scanned group_flags) and fill the sibling table, which lets restriction
+// kernels gather per parent instead of scattering per child
+__kernel void assign_merge_groups(
+    __global const int* restrict coord_x,
+    __global const int* restrict coord_y,
+    __global const int* restrict coord_z,
+    __global uint* restrict merge_group_id,
+    __global const uint* restrict group_offsets,
+    __global uint* restrict group_children,     // Output: group_id*8 + octant → cell_idx
+    const uint num_cells) {
+    
+    const uint idx = get_global_id(0);
+    if (idx >= num_cells) return;
+    
+    const uint first_sibling = merge_group_id[idx];
+    if (first_sibling == INVALID_INDEX) return;
+    
+    const uint group_id = group_offsets[first_sibling];
+    const uint octant = (coord_x[idx] & 1) | ((coord_y[idx] & 1) << 1) | ((coord_z[idx] & 1) << 2);
+    merge_group_id[idx] = group_id;
+    group_children[group_id * 8 + octant] = idx;
 }
 
+
 // Kernel 2: Average fields for merged group based on averaging rule
-// This is the critical kernel for conservation properties
+// This is the critical kernel for conservation properties. One work-item per
+// parent gathers its 8 children through the sibling table and sums them in
+// octant order in registers, so the result is deterministic and matches the
+// ARITHMETIC / VOLUME_WEIGHTED kernels FieldAveragingRuleRegistry generates.
 __kernel void merge_fields(
-    __global const uint* restrict merge_group_id,
-    __global const uint* restrict group_to_parent,
+    __global const uint* restrict group_children,   // group_id*8 + octant → cell_idx
+    __global const uint* restrict group_to_parent,  // Optional: identity if null
     __global const float* restrict input_field,
     __global float* restrict output_field,
     const uint num_components,
-    const uint averaging_rule,  // 0=arithmetic, 1=volume_weighted
-    const uint num_cells) {
+    const uint averaging_rule,  // RestrictionRule: 0=arithmetic, 1=volume_weighted
+    const uint num_groups) {
     
-    const uint idx = get_global_id(0);
-    if (idx >= num_cells) return;
+    const uint group_id = get_global_id(0);
+    if (group_id >= num_groups) return;
     
-    const uint group_id = merge_group_id[idx];
-    if (group_id == INVALID_INDEX) return;
+    __global const uint* children = group_children + (size_t)group_id * 8;
+    uint child_idx[8];
+    for (uint k = 0; k < 8; ++k) {
+        child_idx[k] = children[k];
+    }
     
-    const uint parent_idx = group_to_parent[group_id];
+    // Arithmetic mean divides by 8; volume-weighted (conserved) quantities sum
+    const float scale = (averaging_rule == 0) ? 0.125f : 1.0f;
+    const uint parent_idx = group_to_parent ? group_to_parent[group_id] : group_id;
+    __global float* out = output_field + (size_t)parent_idx * num_components;
     
-    // Accumulate contributions from all 8 children
-    // Each thread processes one child, uses atomic add to parent
     for (uint comp = 0; comp < num_components; ++comp) {
-        const float child_value = input_field[idx * num_components + comp];
-        float contribution = child_value;
-        
-        if (averaging_rule == 0) {
-            // Arithmetic mean: divide by 8
-            contribution *= 0.125f;  // 1/8
-        } else if (averaging_rule == 1) {
-            // Volume-weighted: sum of children = parent (conserved)
-            // No scaling needed for conserved quantities
-            contribution = child_value;
+        float sum = 0.0f;
+        for (uint k = 0; k < 8; ++k) {
+            sum += input_field[(size_t)child_idx[k] * num_components + comp];
         }
-        
-        // Atomic add to parent field
-        // Atomic add to parent field
-        atomic_add_float(&output_field[parent_idx * num_components + comp], contribution);
+        out[comp] = sum * scale;
     }
 }
 
 // Kernel 3: Create parent cell descriptors
+// Parents are written to slot parent_offset + parent index, so they can land
+// straight in the rebuilt mesh
 __kernel void create_parent_cells(
     __global const int* restrict child_x,
     __global const int* restrict child_y,
@@ -167,13 +179,14 @@ __kernel void create_parent_cells(
     __global const uchar* restrict child_states,
     __global const uint* restrict child_material_id,
     __global const uint* restrict merge_group_id,
-    __global const uint* restrict group_to_parent,
+    __global const uint* restrict group_to_parent,  // Optional: identity if null
     __global int* restrict parent_x,
     __global int* restrict parent_y,
     __global int* restrict parent_z,
     __global uchar* restrict parent_level,
     __global uchar* restrict parent_states,
     __global uint* restrict parent_material_id,
+    const uint parent_offset,
     const uint num_cells) {
     
     const uint idx = get_global_id(0);
@@ -187,7 +200,7 @@ __kernel void create_parent_cells(
         return;
     }
     
-    const uint parent_idx = group_to_parent[group_id];
+    const uint parent_idx = parent_offset + (group_to_parent ? group_to_parent[group_id] : group_id);
     
     // Create parent cell
     parent_x[parent_idx] = child_x[idx] >> 1;
@@ -10,46 +10,112 @@
 #define MAX_REFINEMENT_LEVEL 8
 #define INVALID_INDEX 0xFFFFFFFF
 
-// Kernel 1: Count and allocate child blocks using prefix sum
-// More efficient than per-cell atomics - eliminates contention
-__kernel void split_count_and_allocate(
-    __global const int* restrict parent_x,
-    __global const int* restrict parent_y,
-    __global const int* restrict parent_z,
+// ProlongationRule codes (FieldAveragingRules.h)
+#define PROLONG_INJECTION 0
+#define PROLONG_MINMOD 1
+#define PROLONG_MC 2
+
+// Kernel 1: Child count per parent (8 if it splits, else 0)
+// The host turns the counts into child block offsets with an exclusive
+// PrefixScan, so allocation is O(N) and correct across work-groups
+__kernel void split_count_children(
     __global const uchar* restrict parent_level,
     __global const int* restrict refine_flags,
     __global const uchar* restrict parent_states,
-    __global uint* restrict child_block_start,  // Output: parent_idx → child_start
-    __global uint* restrict cell_scratch,       // Temporary: 0/1 split predicate
+    __global uint* restrict child_counts,       // Output: 8 or 0
     const uint num_parents) {
     
     const uint idx = get_global_id(0);
+    if (idx >= num_parents) return;
     
-    // Initialize scratch space
-    if (idx < num_parents) {
-        // Check if cell can be split (geometry lock, max level)
-        const bool can_split = (refine_flags[idx] > 0) &&
-                               (parent_states[idx] == 0) &&  // FLUID state
-                               (parent_level[idx] < MAX_REFINEMENT_LEVEL);
-        
-        cell_scratch[idx] = can_split ? 1 : 0;
+    // Check if cell can be split (geometry lock, max level)
+    const bool can_split = (refine_flags[idx] > 0) &&
+                           (parent_states[idx] == 0) &&  // FLUID state
+                           (parent_level[idx] < MAX_REFINEMENT_LEVEL);
+    
+    child_counts[idx] = can_split ? 8 : 0;
+}
+
+// Limited slope across a cell from its left and right differences; same
+// operations as limitedSlope in FieldAveragingRules.cpp
+inline float limited_slope(const float minus, const float centre, const float plus, const uint rule) {
+    const float left = centre - minus;
+    const float right = plus - centre;
+    if (!(left * right > 0.0f)) return 0.0f;  // Extremum or flat side
+    float magnitude = fmin(fabs(left), fabs(right));
+    if (rule == PROLONG_MC) {
+        magnitude = fmin(2.0f * magnitude, 0.5f * fabs(left + right));
     }
+    return left > 0.0f ? magnitude : -magnitude;
+}
+
+// Index of the cell at `level` with coordinates (x, y, z), or INVALID_INDEX
+inline uint find_cell(
+    const int x, const int y, const int z, const uchar level,
+    __global const int* restrict cell_x,
+    __global const int* restrict cell_y,
+    __global const int* restrict cell_z,
+    __global const uchar* restrict cell_level,
+    __global const uint* restrict hash_table,
+    const uint hash_table_size) {
     
-    barrier(CLK_GLOBAL_MEM_FENCE);
+    uint hash = hilbert_encode_3d(x, y, z, MAX_REFINEMENT_LEVEL) % hash_table_size;
+    for (uint probe = 0; probe < 64; ++probe) {
+        const uint idx = hash_table[hash];
+        if (idx == INVALID_INDEX) break;
+        if (cell_level[idx] == level && cell_x[idx] == x && cell_y[idx] == y && cell_z[idx] == z) {
+            return idx;
+        }
+        hash = (hash + 1) % hash_table_size;
+    }
+    return INVALID_INDEX;
+}
+
+// Children of one parent: scale * (parent + slope . (+-1/4 per axis)). The
+// offsets cancel over the 8 children, so their restriction is the parent.
+inline void prolong_parent(
+    const uint parent_idx,
+    const uint child_start,
+    const uint* neighbors,                       // -x, +x, -y, +y, -z, +z
+    __global const float* restrict parent_field,
+    __global float* restrict child_field,
+    const uint num_components,
+    const uint prolongation_rule,
+    const float child_scale) {
     
-    // Perform inclusive prefix sum on cell_scratch
-    // This would use a library like rocPRIM or custom workgroup scan
-    // For now, placeholder - actual implementation would be optimized
-    if (idx < num_parents) {
-        uint sum = 0;
-        for (uint i = 0; i <= idx; ++i) {
-            sum += cell_scratch[i];
+    for (uint comp = 0; comp < num_components; ++comp) {
+        const float centre = parent_field[(size_t)parent_idx * num_components + comp];
+        float slope[3] = {0.0f, 0.0f, 0.0f};
+        if (prolongation_rule != PROLONG_INJECTION) {
+            for (int axis = 0; axis < 3; ++axis) {
+                const uint minus = neighbors[2 * axis];
+                const uint plus = neighbors[2 * axis + 1];
+                slope[axis] = limited_slope(
+                    minus != INVALID_INDEX ? parent_field[(size_t)minus * num_components + comp] : centre,
+                    centre,
+                    plus != INVALID_INDEX ? parent_field[(size_t)plus * num_components + comp] : centre,
+                    prolongation_rule);
+            }
+        }
+        for (uint child = 0; child < 8; ++child) {
+            const float offset = ((child & 1) ? slope[0] : -slope[0]) +
+                                 ((child & 2) ? slope[1] : -slope[1]) +
+                                 ((child & 4) ? slope[2] : -slope[2]);
+            child_field[(size_t)(child_start + child) * num_components + comp] =
+                child_scale * (centre + 0.25f * offset);
         }
-        child_block_start[idx] = cell_scratch[idx] ? (sum - 1) * 8 : INVALID_INDEX;
     }
 }
 
 // Kernel 2: Generate child cells and Hilbert indices
+// child_block_start holds the scanned child counts; parents that do not split
+// get INVALID_INDEX so later kernels can skip them. Children are written to
+// slot dst_offset + block offset of the child arrays, so they can land
+// straight in the rebuilt mesh; child_parent, child_hilbert and child_field
+// are indexed by block offset alone.
+// With a hash table, the parent's same-level face neighbors are stored at
+// parent_neighbors[child_start / 8 * 6] for later prolong_split_fields calls.
+// With parent_field, the children's values are prolonged in the same pass.
 __kernel void split_generate_children(
     __global const int* restrict parent_x,
     __global const int* restrict parent_y,
@@ -57,7 +123,8 @@ __kernel void split_generate_children(
     __global const uchar* restrict parent_level,
     __global const uchar* restrict parent_states,
     __global const uint* restrict parent_material_id,
-    __global const uint* restrict child_block_start,
+    __global const uint* restrict child_counts,
+    __global uint* restrict child_block_start,
     __global int* restrict child_x,
     __global int* restrict child_y,
     __global int* restrict child_z,
@@ -65,13 +132,26 @@ __kernel void split_generate_children(
     __global uchar* restrict child_states,
     __global uint* restrict child_material_id,
     __global ulong* restrict child_hilbert,  // Optional: for immediate sorting
+    __global uint* restrict child_parent,    // Optional: parent index per child
+    const uint dst_offset,
+    __global const uint* restrict hash_table,       // Optional: neighbor lookup
+    const uint hash_table_size,
+    __global uint* restrict parent_neighbors,       // Required with hash_table
+    __global const float* restrict parent_field,    // Optional: fused prolongation
+    __global float* restrict child_field,
+    const uint num_components,
+    const uint prolongation_rule,
+    const float child_scale,
     const uint num_parents) {
     
     const uint parent_idx = get_global_id(0);
     if (parent_idx >= num_parents) return;
     
+    if (child_counts[parent_idx] == 0) {
+        child_block_start[parent_idx] = INVALID_INDEX;  // Not splitting this parent
+        return;
+    }
     const uint child_start = child_block_start[parent_idx];
-    if (child_start == INVALID_INDEX) return;  // Not splitting this parent
     
     // Parent coordinates
     const int px = parent_x[parent_idx];
@@ -86,47 +166,77 @@ __kernel void split_generate_children(
     // This matches the CHILD_OFFSETS table and ensures monotonicity
     for (uchar child = 0; child < 8; ++child) {
         const uint child_idx = child_start + child;
+        const uint dst_idx = dst_offset + child_idx;
+        const int cx = (px << 1) | ((child >> 0) & 1);
+        const int cy = (py << 1) | ((child >> 1) & 1);
+        const int cz = (pz << 1) | ((child >> 2) & 1);
         
-        child_x[child_idx] = (px << 1) | ((child >> 0) & 1);
-        child_y[child_idx] = (py << 1) | ((child >> 1) & 1);
-        child_z[child_idx] = (pz << 1) | ((child >> 2) & 1);
-        child_level[child_idx] = child_level_val;
-        child_states[child_idx] = parent_state;
-        child_material_id[child_idx] = parent_mat_id;
+        child_x[dst_idx] = cx;
+        child_y[dst_idx] = cy;
+        child_z[dst_idx] = cz;
+        child_level[dst_idx] = child_level_val;
+        child_states[dst_idx] = parent_state;
+        child_material_id[dst_idx] = parent_mat_id;
         
         // Optionally compute Hilbert index for immediate radix sort
         // This avoids re-computation on host and enables direct device-side sorting
         if (child_hilbert) {
-            child_hilbert[child_idx] = hilbert_encode_3d(
-                child_x[child_idx], child_y[child_idx], child_z[child_idx],
-                MAX_REFINEMENT_LEVEL
-            );
+            child_hilbert[child_idx] = hilbert_encode_3d(cx, cy, cz, MAX_REFINEMENT_LEVEL);
+        }
+        if (child_parent) {
+            child_parent[child_idx] = parent_idx;
+        }
+    }
+    
+    // Same-level face neighbors of the parent
+    uint neighbors[6] = {INVALID_INDEX, INVALID_INDEX, INVALID_INDEX,
+                         INVALID_INDEX, INVALID_INDEX, INVALID_INDEX};
+    if (hash_table) {
+        const uchar level = parent_level[parent_idx];
+        for (int face = 0; face < 6; ++face) {
+            const int step = (face & 1) ? 1 : -1;
+            const int axis = face >> 1;
+            neighbors[face] = find_cell(px + (axis == 0 ? step : 0),
+                                        py + (axis == 1 ? step : 0),
+                                        pz + (axis == 2 ? step : 0),
+                                        level, parent_x, parent_y, parent_z, parent_level,
+                                        hash_table, hash_table_size);
+            parent_neighbors[(size_t)(child_start / 8) * 6 + face] = neighbors[face];
         }
     }
+    
+    if (parent_field) {
+        prolong_parent(parent_idx, child_start, neighbors, parent_field, child_field,
+                       num_components, prolongation_rule, child_scale);
+    }
 }
 
-// Kernel 3: Interpolate fields from parent to children
-// Strategy: Direct copy for most fields, special handling for conserved quantities
-__kernel void interpolate_split_fields(
-    __global const uint* restrict parent_to_child_map,
+// Kernel 3: Prolong another field onto the children of the last split,
+// reusing the block starts and face neighbors split_generate_children stored
+__kernel void prolong_split_fields(
+    __global const uint* restrict child_block_start,
+    __global const uint* restrict parent_neighbors,  // Unused for injection
     __global const float* restrict parent_field,
     __global float* restrict child_field,
     const uint num_components,
+    const uint prolongation_rule,
+    const float child_scale,
     const uint num_parents) {
     
     const uint parent_idx = get_global_id(0);
     if (parent_idx >= num_parents) return;
     
-    const uint child_start = parent_to_child_map[parent_idx];
+    const uint child_start = child_block_start[parent_idx];
     if (child_start == INVALID_INDEX) return;
     
-    // For split operations, we typically copy parent values to all children
-    // This preserves local conservation and is correct for AMR
-    for (uchar child = 0; child < 8; ++child) {
-        for (uint comp = 0; comp < num_components; ++comp) {
-            const uint parent_field_idx = parent_idx * num_components + comp;
-            const uint child_field_idx = (child_start + child) * num_components + comp;
-            child_field[child_field_idx] = parent_field[parent_field_idx];  // Direct copy
+    uint neighbors[6] = {INVALID_INDEX, INVALID_INDEX, INVALID_INDEX,
+                         INVALID_INDEX, INVALID_INDEX, INVALID_INDEX};
+    if (prolongation_rule != PROLONG_INJECTION) {
+        for (int face = 0; face < 6; ++face) {
+            neighbors[face] = parent_neighbors[(size_t)(child_start / 8) * 6 + face];
         }
     }
+    
+    prolong_parent(parent_idx, child_start, neighbors, parent_field, child_field,
+                   num_components, prolongation_rule, child_scale);
 }
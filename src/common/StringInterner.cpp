@@ -0,0 +1,55 @@
+#include "fluidloom/common/StringInterner.h"
+#include <mutex>
+#include <stdexcept>
+
+namespace fluidloom {
+
+StringInterner& StringInterner::instance() {
+    static StringInterner instance;
+    return instance;
+}
+
+SymbolId StringInterner::intern(std::string_view text) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = ids_.find(text);
+        if (it != ids_.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto it = ids_.find(text);
+    if (it != ids_.end()) {
+        return it->second;  // Interned by another thread in between
+    }
+    if (names_.size() >= UINT32_MAX - 1) {
+        throw std::length_error("StringInterner: identifier space exhausted");
+    }
+    names_.emplace_back(text);
+    SymbolId id = static_cast<SymbolId>(names_.size());
+    ids_.emplace(names_.back(), id);
+    return id;
+}
+
+SymbolId StringInterner::find(std::string_view text) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = ids_.find(text);
+    return it != ids_.end() ? it->second : INVALID_SYMBOL;
+}
+
+const std::string& StringInterner::name(SymbolId id) const {
+    static const std::string empty;
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (id == INVALID_SYMBOL || id > names_.size()) {
+        return empty;
+    }
+    return names_[id - 1];
+}
+
+size_t StringInterner::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return names_.size();
+}
+
+} // namespace fluidloom
@@ -18,13 +18,15 @@ MPIEnvironment::MPIEnvironment() {
         int argc = 0;
         char** argv = nullptr;
         int provided;
-        MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+        // MPIEventBridge's poller calls MPI concurrently with the submitting threads
+        MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
         m_owned = true;
         m_initialized = true;
         
-        if (provided < MPI_THREAD_FUNNELED) {
+        if (provided < MPI_THREAD_MULTIPLE) {
             FL_LOG(WARN) << "MPI provided thread support level " << provided 
-                           << " is less than requested " << MPI_THREAD_FUNNELED;
+                           << " is less than requested " << MPI_THREAD_MULTIPLE
+                           << "; MPIEventBridge will be unavailable";
         }
     } else {
         m_initialized = true;
@@ -87,6 +87,21 @@ void MockBackend::copyHostToDevice(const void* host_src, DeviceBuffer& device_ds
     FL_LOG(DEBUG) << "MockBackend copied " << size << " bytes H2D";
 }
 
+void MockBackend::copyHostToDeviceOffset(const void* host_src, DeviceBuffer& device_dst,
+                                         size_t dst_offset, size_t size) {
+    if (!host_src) {
+        FL_THROW(BackendError, "Host source pointer is null");
+    }
+    if (dst_offset + size > device_dst.getSize()) {
+        FL_THROW(BackendError, "H2D copy out of bounds");
+    }
+    
+    auto& mock_dst = dynamic_cast<MockBuffer&>(device_dst);
+    std::memcpy(static_cast<uint8_t*>(mock_dst.getDevicePointer()) + dst_offset, host_src, size);
+    
+    FL_LOG(DEBUG) << "MockBackend copied " << size << " bytes H2D at offset " << dst_offset;
+}
+
 void MockBackend::copyDeviceToHost(const DeviceBuffer& device_src, void* host_dst, size_t size) {
     if (!host_dst) {
         FL_THROW(BackendError, "Host destination pointer is null");
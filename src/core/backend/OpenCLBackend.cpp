@@ -143,6 +143,20 @@ void OpenCLBackend::copyHostToDevice(const void* host_src, DeviceBuffer& device_
     FL_LOG(DEBUG) << "OpenCLBackend H2D copy: " << size << " bytes";
 }
 
+void OpenCLBackend::copyHostToDeviceOffset(const void* host_src, DeviceBuffer& device_dst,
+                                           size_t dst_offset, size_t size) {
+    if (!host_src) {
+        FL_THROW(BackendError, "Host source pointer is null");
+    }
+    
+    auto& cl_dst = dynamic_cast<OpenCLBuffer&>(device_dst);
+    cl_int err = clEnqueueWriteBuffer(m_queue, cl_dst.getCLMem(), CL_TRUE, dst_offset,
+                                      size, host_src, 0, nullptr, nullptr);
+    checkError(err, "Failed H2D offset copy");
+    
+    FL_LOG(DEBUG) << "OpenCLBackend H2D copy: " << size << " bytes at offset " << dst_offset;
+}
+
 void OpenCLBackend::copyDeviceToHost(const DeviceBuffer& device_src, void* host_dst, size_t size) {
     if (!host_dst) {
         FL_THROW(BackendError, "Host destination pointer is null");
@@ -3,6 +3,7 @@
 #include "fluidloom/common/FluidLoomError.h"
 #include <cstring>
 #include <algorithm>
+#include <unordered_set>
 
 namespace fluidloom {
 namespace fields {
@@ -62,7 +63,56 @@ FieldHandle SOAFieldManager::allocate(const FieldDescriptor& desc, size_t num_ce
     return FieldHandle(desc.id);
 }
 
-void SOAFieldManager::resize(FieldHandle handle, size_t new_num_cells) {
+std::vector<FieldHandle> SOAFieldManager::allocateAliased(const std::vector<FieldDescriptor>& descs,
+                                                          size_t num_cells) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    if (descs.empty()) {
+        return {};
+    }
+    
+    size_t aligned_cell_size = 0;
+    for (const auto& desc : descs) {
+        if (!desc.isValid()) {
+            throw std::invalid_argument("Invalid field descriptor");
+        }
+        if (fields_.find(desc.id) != fields_.end()) {
+            FL_LOG(ERROR) << "Field '" << desc.name << "' already allocated";
+            throw std::runtime_error("Field already allocated");
+        }
+        aligned_cell_size = std::max(aligned_cell_size, (desc.bytesPerCell() + 63) & ~size_t(63));
+    }
+    
+    size_t total_bytes = aligned_cell_size * num_cells;
+    std::shared_ptr<DeviceBuffer> buffer = backend_->allocateBuffer(total_bytes);
+    if (!buffer) {
+        FL_LOG(ERROR) << "Failed to allocate " << total_bytes << " bytes for aliased fields";
+        throw std::runtime_error("Buffer allocation failed");
+    }
+    
+    std::vector<FieldHandle> handles;
+    std::string names;
+    for (const auto& desc : descs) {
+        FieldState state;
+        state.descriptor = desc;
+        state.num_cells = num_cells;
+        state.device_buffer = buffer;
+        state.pitch = aligned_cell_size;
+        state.version = 1;
+        updateComponentPointers(state);
+        
+        fields_[desc.id] = std::move(state);
+        handles.emplace_back(desc.id);
+        names += (names.empty() ? "'" : ", '") + desc.name + "'";
+    }
+    
+    FL_LOG(INFO) << "Allocated aliased fields " << names << ": " << num_cells << " cells × "
+                 << aligned_cell_size << " bytes = " << total_bytes / (1024*1024) << " MB shared";
+    
+    return handles;
+}
+
+void SOAFieldManager::resize(FieldHandle handle, size_t new_num_cells, bool preserve) {
     std::lock_guard<std::mutex> lock(mutex_);
     auto& state = getFieldState(handle);
     
@@ -70,12 +120,19 @@ void SOAFieldManager::resize(FieldHandle handle, size_t new_num_cells) {
         return;  // No-op
     }
     
-    size_t bytes_per_cell = state.descriptor.bytesPerCell();
-    size_t aligned_cell_size = (bytes_per_cell + 63) & ~63;
+    // Fields sharing the buffer move together
+    std::vector<FieldState*> group;
+    for (auto& pair : fields_) {
+        if (pair.second.device_buffer == state.device_buffer) {
+            group.push_back(&pair.second);
+        }
+    }
+    
+    size_t aligned_cell_size = state.pitch;
     size_t new_total_bytes = aligned_cell_size * new_num_cells;
     
     // Allocate new buffer
-    auto new_buffer = backend_->allocateBuffer(new_total_bytes);
+    std::shared_ptr<DeviceBuffer> new_buffer = backend_->allocateBuffer(new_total_bytes);
     if (!new_buffer) {
         throw std::runtime_error("Failed to allocate resized buffer");
     }
@@ -84,27 +141,22 @@ void SOAFieldManager::resize(FieldHandle handle, size_t new_num_cells) {
     size_t copy_cells = std::min(state.num_cells, new_num_cells);
     size_t copy_bytes = aligned_cell_size * copy_cells;
     
-    if (copy_bytes > 0) {
+    if (preserve && copy_bytes > 0) {
         backend_->copyDeviceToDevice(*state.device_buffer, *new_buffer, copy_bytes);
     }
     
-    // Replace buffer
-    state.device_buffer = std::move(new_buffer);
-    state.num_cells = new_num_cells;
-    
-    // Update component pointers
-    char* base_ptr = static_cast<char*>(state.device_buffer->getDevicePointer());
-    state.device_ptrs.clear();
-    for (uint16_t comp = 0; comp < state.descriptor.num_components; ++comp) {
-        size_t offset = comp * bytes_per_cell;
-        state.device_ptrs.push_back(base_ptr + offset);
+    // Replace buffer and update component pointers
+    for (FieldState* member : group) {
+        member->device_buffer = new_buffer;
+        member->num_cells = new_num_cells;
+        updateComponentPointers(*member);
+        
+        // Mark as dirty
+        member->version++;
+        member->descriptor.gpu_state.is_dirty = true;
+        
+        FL_LOG(INFO) << "Resized field '" << member->descriptor.name << "' to " << new_num_cells << " cells";
     }
-    
-    // Mark as dirty
-    state.version++;
-    state.descriptor.gpu_state.is_dirty = true;
-    
-    FL_LOG(INFO) << "Resized field '" << state.descriptor.name << "' to " << new_num_cells << " cells";
 }
 
 void SOAFieldManager::deallocate(FieldHandle handle) {
@@ -135,6 +187,17 @@ const FieldDescriptor& SOAFieldManager::getDescriptor(FieldHandle handle) const
     return getFieldState(handle).descriptor;
 }
 
+std::vector<FieldHandle> SOAFieldManager::getHandles() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<FieldHandle> handles;
+    handles.reserve(fields_.size());
+    for (const auto& pair : fields_) {
+        handles.emplace_back(pair.first);
+    }
+    std::sort(handles.begin(), handles.end());
+    return handles;
+}
+
 size_t SOAFieldManager::getAllocationSize(FieldHandle handle) const {
     std::lock_guard<std::mutex> lock(mutex_);
     return getFieldState(handle).num_cells;
@@ -163,11 +226,19 @@ uint64_t SOAFieldManager::getVersion(FieldHandle handle) const {
     return getFieldState(handle).version;
 }
 
+bool SOAFieldManager::sharesStorage(FieldHandle a, FieldHandle b) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return getFieldState(a).device_buffer == getFieldState(b).device_buffer;
+}
+
 size_t SOAFieldManager::getTotalMemoryUsage() const {
     std::lock_guard<std::mutex> lock(mutex_);
+    std::unordered_set<const DeviceBuffer*> counted;
     size_t total = 0;
     for (const auto& pair : fields_) {
-        total += pair.second.device_buffer->getSize();
+        if (counted.insert(pair.second.device_buffer.get()).second) {
+            total += pair.second.device_buffer->getSize();
+        }
     }
     return total;
 }
@@ -182,6 +253,16 @@ size_t SOAFieldManager::computeAlignedSize(size_t bytes_per_cell, size_t num_cel
     return aligned_cell * num_cells;
 }
 
+void SOAFieldManager::updateComponentPointers(FieldState& state) {
+    size_t bytes_per_cell = state.descriptor.bytesPerCell();
+    char* base_ptr = static_cast<char*>(state.device_buffer->getDevicePointer());
+    state.device_ptrs.clear();
+    for (uint16_t comp = 0; comp < state.descriptor.num_components; ++comp) {
+        size_t offset = comp * bytes_per_cell;
+        state.device_ptrs.push_back(base_ptr + offset);
+    }
+}
+
 SOAFieldManager::FieldState& SOAFieldManager::getFieldState(FieldHandle handle) {
     auto it = fields_.find(handle.id);
     if (it == fields_.end()) {
@@ -1,15 +1,23 @@
 #include "fluidloom/core/hashmap/HashTableManager.h"
 #include "fluidloom/common/Logger.h"
+#include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <unordered_map>
 
 namespace fluidloom {
 namespace hashmap {
 
+namespace {
+// Above this fraction of touched slots a single full upload beats many small writes
+constexpr uint64_t FULL_UPLOAD_DIVISOR = 8;
+// Dirty slots closer than this are merged into one write
+constexpr uint64_t RUN_MERGE_GAP = 16;
+}
+
 HashTableManager::HashTableManager(IBackend* backend)
     : backend_(backend),
-      compactor_(std::make_unique<CompactionEngine>(backend)),
-      hash_build_kernel_(nullptr) {
+      compactor_(std::make_unique<CompactionEngine>(backend)) {
     if (!backend) {
         throw std::invalid_argument("Backend must not be null");
     }
@@ -27,23 +35,14 @@ HashTableManager::HashTableManager(IBackend* backend)
     metadata_.build_time_ms = 0;
     metadata_.average_probe_count = 0.0f;
     metadata_.max_probe_count = 0;
+    metadata_.num_tombstones = 0;
+    metadata_.last_delta_slots = 0;
 }
 
 HashTableManager::~HashTableManager() {
     // RAII handles cleanup
 }
 
-void HashTableManager::ensureKernelsCompiled() {
-    if (hash_build_kernel_) return;  // Already compiled
-    
-    FL_LOG(INFO) << "Compiling hash table kernels...";
-    
-    // TODO: Load and compile kernels from kernels/hashmap/
-    // hash_build_kernel_ = backend_->compileKernel("hash_build", ...);
-    // hash_clear_kernel_ = backend_->compileKernel("hash_clear", ...);
-    // hash_query_kernel_ = backend_->compileKernel("hash_validate", ...);
-}
-
 uint64_t HashTableManager::computeCapacity(size_t num_cells) {
     // Capacity must be power of 2 and >= num_cells / MAX_LOAD_FACTOR
     double min_capacity = static_cast<double>(num_cells) / MAX_LOAD_FACTOR;
@@ -85,17 +84,134 @@ void HashTableManager::allocateTable(size_t num_cells) {
 void HashTableManager::clearTable() {
     if (!table_keys_) return;
     
-    // Launch clear kernel
-    // For now, use CPU clear (slow but works)
-    std::vector<uint64_t> empty_keys(current_table_.capacity, HASH_EMPTY_KEY);
-    std::vector<uint32_t> empty_values(current_table_.capacity, HASH_INVALID_VALUE);
-    
-    backend_->copyHostToDevice(empty_keys.data(), *table_keys_, 
-                               current_table_.capacity * sizeof(uint64_t));
-    backend_->copyHostToDevice(empty_values.data(), *table_values_,
-                               current_table_.capacity * sizeof(uint32_t));
+    // CPU clear of the host mirror; the caller uploads it once populated
+    host_keys_.assign(current_table_.capacity, HASH_EMPTY_KEY);
+    host_values_.assign(current_table_.capacity, HASH_INVALID_VALUE);
     
     current_table_.size = 0;
+    metadata_.num_tombstones = 0;
+}
+
+bool HashTableManager::insertHost(uint64_t key, uint32_t value, uint64_t* slot_out) {
+    const uint64_t mask = current_table_.capacity - 1;
+    uint64_t slot = current_table_.getSlot(key);
+    uint64_t reusable = HASH_EMPTY_KEY;
+    
+    for (uint32_t probe = 0; probe < HashBuildConfig::MAX_PROBE_LIMIT; ++probe) {
+        uint64_t current = host_keys_[slot];
+        
+        if (current == key) {
+            // Relocated cell: overwrite value in place
+            host_values_[slot] = value;
+            *slot_out = slot;
+            return true;
+        }
+        
+        if (current == HASH_EMPTY_KEY) {
+            // Key is absent; prefer the first tombstone on the chain
+            if (reusable != HASH_EMPTY_KEY) {
+                slot = reusable;
+                metadata_.num_tombstones--;
+            }
+            host_keys_[slot] = key;
+            host_values_[slot] = value;
+            current_table_.size++;
+            *slot_out = slot;
+            return true;
+        }
+        
+        if (current == HASH_TOMBSTONE_KEY && reusable == HASH_EMPTY_KEY) {
+            reusable = slot;
+        }
+        
+        slot = (slot + 1) & mask;
+    }
+    
+    if (reusable != HASH_EMPTY_KEY) {
+        host_keys_[reusable] = key;
+        host_values_[reusable] = value;
+        current_table_.size++;
+        metadata_.num_tombstones--;
+        *slot_out = reusable;
+        return true;
+    }
+    
+    return false;  // Probe limit exceeded
+}
+
+bool HashTableManager::eraseHost(uint64_t key, uint64_t* slot_out) {
+    const uint64_t mask = current_table_.capacity - 1;
+    uint64_t slot = current_table_.getSlot(key);
+    
+    for (uint32_t probe = 0; probe < HashBuildConfig::MAX_PROBE_LIMIT; ++probe) {
+        uint64_t current = host_keys_[slot];
+        
+        if (current == key) {
+            host_keys_[slot] = HASH_TOMBSTONE_KEY;
+            host_values_[slot] = HASH_INVALID_VALUE;
+            current_table_.size--;
+            metadata_.num_tombstones++;
+            *slot_out = slot;
+            return true;
+        }
+        
+        if (current == HASH_EMPTY_KEY) {
+            return false;
+        }
+        
+        slot = (slot + 1) & mask;
+    }
+    
+    return false;
+}
+
+uint32_t HashTableManager::findHost(uint64_t key) const {
+    if (host_keys_.empty() || key == HASH_EMPTY_KEY || key == HASH_TOMBSTONE_KEY) {
+        return HASH_INVALID_VALUE;
+    }
+    
+    const uint64_t mask = current_table_.capacity - 1;
+    uint64_t slot = current_table_.getSlot(key);
+    
+    for (uint32_t probe = 0; probe < HashBuildConfig::MAX_PROBE_LIMIT; ++probe) {
+        uint64_t current = host_keys_[slot];
+        if (current == key) return host_values_[slot];
+        if (current == HASH_EMPTY_KEY) break;
+        slot = (slot + 1) & mask;
+    }
+    
+    return HASH_INVALID_VALUE;
+}
+
+void HashTableManager::uploadSlots(std::vector<uint64_t>& slots) {
+    if (slots.empty() || !table_keys_) return;
+    
+    std::sort(slots.begin(), slots.end());
+    slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+    
+    if (slots.size() > current_table_.capacity / FULL_UPLOAD_DIVISOR) {
+        backend_->copyHostToDevice(host_keys_.data(), *table_keys_,
+                                   current_table_.capacity * sizeof(uint64_t));
+        backend_->copyHostToDevice(host_values_.data(), *table_values_,
+                                   current_table_.capacity * sizeof(uint32_t));
+        return;
+    }
+    
+    // Coalesce nearby slots into runs and write each run at its offset
+    size_t run_begin = 0;
+    for (size_t i = 1; i <= slots.size(); ++i) {
+        if (i < slots.size() && slots[i] - slots[i - 1] <= RUN_MERGE_GAP) {
+            continue;
+        }
+        
+        uint64_t first = slots[run_begin];
+        uint64_t count = slots[i - 1] - first + 1;
+        backend_->copyHostToDeviceOffset(host_keys_.data() + first, *table_keys_,
+                                         first * sizeof(uint64_t), count * sizeof(uint64_t));
+        backend_->copyHostToDeviceOffset(host_values_.data() + first, *table_values_,
+                                         first * sizeof(uint32_t), count * sizeof(uint32_t));
+        run_begin = i;
+    }
 }
 
 double HashTableManager::rebuild(const std::vector<uint64_t>& hilbert_indices,
@@ -115,28 +231,36 @@ double HashTableManager::rebuild(const std::vector<uint64_t>& hilbert_indices,
     // Clear table
     clearTable();
     
-    // Copy input data to device (temporary buffers)
-    auto input_keys = backend_->allocateBuffer(num_cells * sizeof(uint64_t));
-    auto input_values = backend_->allocateBuffer(num_cells * sizeof(uint32_t));
-    
-    backend_->copyHostToDevice(hilbert_indices.data(), *input_keys, 
-                               num_cells * sizeof(uint64_t));
-    backend_->copyHostToDevice(array_indices.data(), *input_values,
-                               num_cells * sizeof(uint32_t));
-    
-    // Launch build kernel
-    // TODO: backend_->launchKernel(hash_build_kernel_, ...);
+    // Build into the host mirror, then upload the whole table once. This is
+    // deliberate rather than a stand-in for kernels/hashmap/hash_build.cl: the
+    // keys arrive on the host, query() and applyDelta() work on the mirror,
+    // and a device build would need a full readback to keep it in sync.
+    uint32_t max_probes = 0;
+    for (size_t i = 0; i < num_cells; ++i) {
+        uint64_t slot = 0;
+        if (!insertHost(hilbert_indices[i], array_indices[i], &slot)) {
+            FL_LOG(ERROR) << "Hash insert exceeded probe limit for key " << hilbert_indices[i];
+            continue;
+        }
+        uint64_t home = current_table_.getSlot(hilbert_indices[i]);
+        max_probes = std::max<uint32_t>(max_probes, static_cast<uint32_t>(
+            (slot - home) & (current_table_.capacity - 1)));
+    }
+    metadata_.max_probe_count = max_probes;
     
-    // For now, just log a placeholder
-    FL_LOG(WARN) << "Hash table build kernel not yet implemented";
+    backend_->copyHostToDevice(host_keys_.data(), *table_keys_,
+                               current_table_.capacity * sizeof(uint64_t));
+    backend_->copyHostToDevice(host_values_.data(), *table_values_,
+                               current_table_.capacity * sizeof(uint32_t));
     
     backend_->finish();
     
     auto end_time = std::chrono::high_resolution_clock::now();
     double duration_ms = std::chrono::duration<double, std::milli>(end_time - start_time).count();
     
-    metadata_.num_cells = num_cells;
+    metadata_.num_cells = current_table_.size;
     metadata_.build_time_ms = static_cast<uint32_t>(duration_ms);
+    metadata_.last_delta_slots = 0;
     
     FL_LOG(INFO) << "Hash table rebuild completed in " << duration_ms << " ms";
     
@@ -151,12 +275,87 @@ std::vector<uint32_t> HashTableManager::query(const std::vector<uint64_t>& query
         return results;
     }
     
-    // Launch query kernel
-    // TODO: Implement GPU batch query
-    FL_LOG(WARN) << "Hash table query not yet implemented";
+    // Served from the host mirror, which always matches the device table
+    for (size_t i = 0; i < num_queries; ++i) {
+        results[i] = findHost(query_keys[i]);
+    }
     
     return results;
 }
 
+double HashTableManager::applyDelta(const std::vector<uint64_t>& removed_keys,
+                                    const std::vector<uint64_t>& upsert_keys,
+                                    const std::vector<uint32_t>& upsert_values) {
+    if (upsert_keys.size() != upsert_values.size()) {
+        throw std::invalid_argument("Mismatched input sizes");
+    }
+    
+    auto start_time = std::chrono::high_resolution_clock::now();
+    
+    // Upper bound on occupied slots (live + tombstones) after the update
+    size_t projected = current_table_.size + metadata_.num_tombstones + upsert_keys.size();
+    bool needs_rebuild = !table_keys_ || projected > metadata_.active_capacity;
+    
+    std::vector<uint64_t> touched;
+    if (!needs_rebuild) {
+        touched.reserve(removed_keys.size() + upsert_keys.size());
+        uint64_t slot = 0;
+        
+        for (uint64_t key : removed_keys) {
+            if (eraseHost(key, &slot)) {
+                touched.push_back(slot);
+            }
+        }
+        
+        for (size_t i = 0; i < upsert_keys.size(); ++i) {
+            if (!insertHost(upsert_keys[i], upsert_values[i], &slot)) {
+                needs_rebuild = true;
+                break;
+            }
+            touched.push_back(slot);
+        }
+    }
+    
+    if (needs_rebuild) {
+        // Erase and upsert are idempotent, so a partially applied delta is
+        // simply re-applied on top of the mirror's live entries
+        std::unordered_map<uint64_t, uint32_t> live;
+        live.reserve(current_table_.size + upsert_keys.size());
+        for (size_t slot = 0; slot < host_keys_.size(); ++slot) {
+            uint64_t key = host_keys_[slot];
+            if (key != HASH_EMPTY_KEY && key != HASH_TOMBSTONE_KEY) {
+                live[key] = host_values_[slot];
+            }
+        }
+        for (uint64_t key : removed_keys) live.erase(key);
+        for (size_t i = 0; i < upsert_keys.size(); ++i) live[upsert_keys[i]] = upsert_values[i];
+        
+        std::vector<uint64_t> keys;
+        std::vector<uint32_t> values;
+        keys.reserve(live.size());
+        values.reserve(live.size());
+        for (const auto& entry : live) {
+            keys.push_back(entry.first);
+            values.push_back(entry.second);
+        }
+        
+        FL_LOG(INFO) << "Hash delta exceeds load factor, falling back to full rebuild";
+        return rebuild(keys, values);
+    }
+    
+    uploadSlots(touched);
+    
+    auto end_time = std::chrono::high_resolution_clock::now();
+    double duration_ms = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+    
+    metadata_.num_cells = current_table_.size;
+    metadata_.last_delta_slots = touched.size();
+    
+    FL_LOG(INFO) << "Hash table delta: -" << removed_keys.size() << " +" << upsert_keys.size()
+                 << " keys, " << touched.size() << " slots in " << duration_ms << " ms";
+    
+    return duration_ms;
+}
+
 } // namespace hashmap
 } // namespace fluidloom
@@ -0,0 +1,120 @@
+#include "fluidloom/core/hilbert/HilbertCodec.h"
+#include "fluidloom/core/backend/IBackend.h"
+#include <stdexcept>
+#include <vector>
+
+namespace fluidloom {
+namespace hilbert {
+
+namespace {
+
+constexpr const char* KERNEL_SOURCE = "kernels/hilbert.cl";
+constexpr size_t INT3_STRIDE = 4;  // cl_int3 occupies 16 bytes
+
+void checkLevel(uint8_t level) {
+    if (level > MAX_REFINEMENT_LEVEL) {
+        throw std::invalid_argument("Hilbert batch level exceeds MAX_REFINEMENT_LEVEL");
+    }
+}
+
+}  // namespace
+
+void encodeBatch(const int32_t* x, const int32_t* y, const int32_t* z,
+                 const uint8_t* levels, HilbertIndex* keys_out, size_t n,
+                 uint8_t level) {
+    if (levels) {
+        for (size_t i = 0; i < n; ++i) {
+            keys_out[i] = encode(x[i], y[i], z[i], levels[i]);
+        }
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            keys_out[i] = encode(x[i], y[i], z[i], level);
+        }
+    }
+}
+
+DeviceEncoder::DeviceEncoder(IBackend& backend_)
+    : backend(backend_), batch_kernel(nullptr), batch_soa_kernel(nullptr) {
+    if (backend.getType() == BackendType::MOCK) {
+        return;  // Kernels cannot run; encode on the host instead
+    }
+    batch_kernel = backend.compileKernel(KERNEL_SOURCE, "hilbert_encode_batch").handle;
+    batch_soa_kernel = backend.compileKernel(KERNEL_SOURCE, "hilbert_encode_batch_soa").handle;
+}
+
+DeviceEncoder::~DeviceEncoder() {
+    if (batch_kernel) backend.releaseKernel(IBackend::KernelHandle(batch_kernel));
+    if (batch_soa_kernel) backend.releaseKernel(IBackend::KernelHandle(batch_soa_kernel));
+}
+
+void DeviceEncoder::encode(const DeviceBuffer& coords, const DeviceBuffer* levels,
+                           DeviceBuffer& keys_out, size_t n, uint8_t level) {
+    if (n == 0) return;
+    checkLevel(level);
+    if (coords.getSize() < n * INT3_STRIDE * sizeof(int32_t) ||
+        keys_out.getSize() < n * sizeof(HilbertIndex) ||
+        (levels && levels->getSize() < n)) {
+        throw std::invalid_argument("Hilbert batch buffers smaller than cell count");
+    }
+
+    if (!batch_kernel) {
+        std::vector<int32_t> packed(n * INT3_STRIDE);
+        std::vector<uint8_t> host_levels(levels ? n : 0);
+        std::vector<HilbertIndex> keys(n);
+        backend.copyDeviceToHost(coords, packed.data(), packed.size() * sizeof(int32_t));
+        if (levels) backend.copyDeviceToHost(*levels, host_levels.data(), n);
+        for (size_t i = 0; i < n; ++i) {
+            const int32_t* c = &packed[i * INT3_STRIDE];
+            keys[i] = hilbert::encode(c[0], c[1], c[2], levels ? host_levels[i] : level);
+        }
+        backend.copyHostToDevice(keys.data(), keys_out, n * sizeof(HilbertIndex));
+        return;
+    }
+
+    std::vector<IBackend::KernelArg> args = {
+        IBackend::KernelArg::fromBuffer(coords.getDevicePointer()),
+        IBackend::KernelArg::fromBuffer(levels ? levels->getDevicePointer() : nullptr),
+        IBackend::KernelArg::fromBuffer(keys_out.getDevicePointer()),
+        IBackend::KernelArg::fromScalar(static_cast<uint32_t>(n)),
+        IBackend::KernelArg::fromScalar(level),
+        IBackend::KernelArg::fromScalar(static_cast<uint32_t>(levels ? 1 : 0))
+    };
+    backend.launchKernel(IBackend::KernelHandle(batch_kernel), n, 0, args);
+}
+
+void DeviceEncoder::encodeSoA(const void* coord_x, const void* coord_y, const void* coord_z,
+                              const void* levels, void* keys_out, size_t n, uint8_t level) {
+    if (n == 0) return;
+    checkLevel(level);
+
+    if (!batch_soa_kernel) {
+        // Mock device pointers are host memory
+        encodeBatch(static_cast<const int32_t*>(coord_x), static_cast<const int32_t*>(coord_y),
+                    static_cast<const int32_t*>(coord_z), static_cast<const uint8_t*>(levels),
+                    static_cast<HilbertIndex*>(keys_out), n, level);
+        return;
+    }
+
+    std::vector<IBackend::KernelArg> args = {
+        IBackend::KernelArg::fromBuffer(coord_x),
+        IBackend::KernelArg::fromBuffer(coord_y),
+        IBackend::KernelArg::fromBuffer(coord_z),
+        IBackend::KernelArg::fromBuffer(levels),
+        IBackend::KernelArg::fromBuffer(keys_out),
+        IBackend::KernelArg::fromScalar(static_cast<uint32_t>(n)),
+        IBackend::KernelArg::fromScalar(level),
+        IBackend::KernelArg::fromScalar(static_cast<uint32_t>(levels ? 1 : 0))
+    };
+    backend.launchKernel(IBackend::KernelHandle(batch_soa_kernel), n, 0, args);
+}
+
+void encodeBatchDevice(IBackend& backend, const DeviceBuffer& coords, const DeviceBuffer* levels,
+                       DeviceBuffer& keys_out, size_t n, uint8_t level) {
+    DeviceEncoder encoder(backend);
+    encoder.encode(coords, levels, keys_out, n, level);
+    // The kernel must finish before the encoder releases it
+    backend.finish();
+}
+
+}  // namespace hilbert
+}  // namespace fluidloom
@@ -0,0 +1,371 @@
+#include "fluidloom/core/reduction/DeterministicReducer.h"
+#include "fluidloom/common/Logger.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+// Per-cell terms must round exactly as in fused_reduce.cl; this file is
+// compiled with -ffp-contract=off (see src/core/CMakeLists.txt)
+
+namespace fluidloom {
+namespace reduction {
+
+namespace {
+
+constexpr const char* KERNEL_SOURCE = "kernels/reduction/fused_reduce.cl";
+constexpr const char* KERNEL_OPTIONS = "-cl-fp32-correctly-rounded-divide-sqrt";
+
+// Spec record shared with the kernel (SPEC_WORDS uints per reduction)
+constexpr size_t SPEC_WORDS = 12;
+constexpr uint32_t NO_WEIGHT = 0xFFFFFFFFu;
+constexpr uint32_t ALL_LEVELS = 0xFFFFFFFFu;
+
+constexpr size_t WORDS = ExactAccumulator::WORDS;
+constexpr int FLAGS_WORD = ExactAccumulator::DIGITS;
+
+float floatFromBits(int64_t word) {
+    const uint32_t bits = static_cast<uint32_t>(word);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+int64_t bitsFromFloat(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return static_cast<int64_t>(bits);
+}
+
+float emptyExtremum(ReduceOp op) {
+    return op == ReduceOp::MIN ? std::numeric_limits<float>::infinity()
+                               : -std::numeric_limits<float>::infinity();
+}
+
+// Mirrors cell_term() in fused_reduce.cl operation for operation
+float cellTerm(const ReductionSpec& spec, const std::vector<FieldView>& inputs, size_t cell, float volume) {
+    const FieldView& view = inputs[spec.field];
+    const float* base = static_cast<const float*>(view.data) + spec.first_component * view.stride;
+
+    float value;
+    if (spec.term == ReduceTerm::VALUE) {
+        value = base[cell];
+    } else {
+        float c = base[cell];
+        float sq = c * c;
+        for (uint16_t k = 1; k < spec.num_components; ++k) {
+            c = base[k * view.stride + cell];
+            const float p = c * c;
+            sq = sq + p;
+        }
+        value = spec.term == ReduceTerm::NORM ? std::sqrt(sq) : sq;
+    }
+
+    if (spec.weight_field >= 0) {
+        value = value * static_cast<const float*>(inputs[spec.weight_field].data)[cell];
+    }
+    value = value * volume;
+    return value * spec.scale;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// ReductionPartials
+// ---------------------------------------------------------------------------
+
+ReductionPartials::ReductionPartials(std::vector<ReduceOp> ops)
+    : m_ops(std::move(ops)),
+      m_sums(m_ops.size()),
+      m_extrema(m_ops.size()),
+      m_flags(m_ops.size(), 0) {
+    for (size_t i = 0; i < m_ops.size(); ++i) {
+        m_extrema[i] = emptyExtremum(m_ops[i]);
+    }
+}
+
+void ReductionPartials::addTerm(size_t i, float term) {
+    if (m_ops[i] == ReduceOp::SUM) {
+        m_sums[i].add(term);
+        return;
+    }
+    if (std::isnan(term)) {
+        m_flags[i] |= ExactAccumulator::FLAG_NAN;
+        return;
+    }
+    term = term + 0.0f;  // -0 -> +0, so ties between zeros cannot depend on order
+    m_extrema[i] = m_ops[i] == ReduceOp::MIN ? std::min(m_extrema[i], term) : std::max(m_extrema[i], term);
+}
+
+void ReductionPartials::merge(const ReductionPartials& other) {
+    if (other.m_ops != m_ops) {
+        throw std::invalid_argument("ReductionPartials: merging partials of different reductions");
+    }
+    auto words = other.serialize();
+    for (size_t i = 0; i < m_ops.size(); ++i) {
+        mergeRecord(i, &words[i * WORDS]);
+    }
+}
+
+void ReductionPartials::mergeRecord(size_t i, const int64_t* words) {
+    if (m_ops[i] == ReduceOp::SUM) {
+        m_sums[i].merge(ExactAccumulator::load(words));
+        return;
+    }
+    m_flags[i] |= static_cast<uint64_t>(words[FLAGS_WORD]);
+    const float other = floatFromBits(words[0]);
+    m_extrema[i] = m_ops[i] == ReduceOp::MIN ? std::min(m_extrema[i], other) : std::max(m_extrema[i], other);
+}
+
+double ReductionPartials::value(size_t i) const {
+    if (m_ops[i] == ReduceOp::SUM) {
+        return m_sums[i].toDouble();
+    }
+    if (m_flags[i] & ExactAccumulator::FLAG_NAN) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    return m_extrema[i];
+}
+
+std::vector<double> ReductionPartials::values() const {
+    std::vector<double> result(m_ops.size());
+    for (size_t i = 0; i < m_ops.size(); ++i) {
+        result[i] = value(i);
+    }
+    return result;
+}
+
+std::vector<int64_t> ReductionPartials::serialize() const {
+    std::vector<int64_t> words(m_ops.size() * WORDS, 0);
+    for (size_t i = 0; i < m_ops.size(); ++i) {
+        int64_t* record = &words[i * WORDS];
+        if (m_ops[i] == ReduceOp::SUM) {
+            m_sums[i].store(record);
+        } else {
+            record[0] = bitsFromFloat(m_extrema[i]);
+            record[FLAGS_WORD] = static_cast<int64_t>(m_flags[i]);
+        }
+    }
+    return words;
+}
+
+ReductionPartials ReductionPartials::deserialize(const std::vector<ReduceOp>& ops, const int64_t* words) {
+    ReductionPartials partials(ops);
+    for (size_t i = 0; i < ops.size(); ++i) {
+        partials.mergeRecord(i, words + i * WORDS);
+    }
+    return partials;
+}
+
+// ---------------------------------------------------------------------------
+// DeterministicReducer
+// ---------------------------------------------------------------------------
+
+DeterministicReducer::DeterministicReducer(IBackend* backend)
+    : m_backend(backend) {
+    if (useHostPath()) {
+        return;
+    }
+    try {
+        m_kernel = m_backend->compileKernel(KERNEL_SOURCE, "fused_reduce", KERNEL_OPTIONS);
+    } catch (const std::exception& e) {
+        FL_LOG(ERROR) << "Failed to compile deterministic reduction kernel: " << e.what();
+        throw;
+    }
+    m_spec_buffer = m_backend->allocateBuffer(MAX_FUSED * SPEC_WORDS * sizeof(uint32_t));
+}
+
+DeterministicReducer::~DeterministicReducer() {
+    if (m_backend && m_kernel.handle) {
+        m_backend->releaseKernel(m_kernel);
+    }
+}
+
+bool DeterministicReducer::useHostPath() const {
+    // Mock buffers live in host memory
+    return !m_backend || m_backend->getType() == BackendType::MOCK;
+}
+
+void DeterministicReducer::validate(const std::vector<ReductionSpec>& specs,
+                                    const std::vector<FieldView>& inputs,
+                                    const void* levels) {
+    if (specs.size() > MAX_FUSED) {
+        throw std::invalid_argument("DeterministicReducer: at most " + std::to_string(MAX_FUSED) +
+                                    " reductions can be fused");
+    }
+    if (inputs.empty() || inputs.size() > MAX_INPUTS) {
+        throw std::invalid_argument("DeterministicReducer: between 1 and " + std::to_string(MAX_INPUTS) +
+                                    " input fields are supported");
+    }
+    for (const auto& input : inputs) {
+        if (!input.data) {
+            throw std::invalid_argument("DeterministicReducer: null input field");
+        }
+    }
+    for (const auto& spec : specs) {
+        if (spec.field >= inputs.size() ||
+            (spec.weight_field >= 0 && static_cast<size_t>(spec.weight_field) >= inputs.size())) {
+            throw std::invalid_argument("DeterministicReducer: reduction '" + spec.name +
+                                        "' refers to a missing input");
+        }
+        if (spec.num_components < 1 || spec.num_components > 3 ||
+            (spec.term == ReduceTerm::VALUE && spec.num_components != 1)) {
+            throw std::invalid_argument("DeterministicReducer: reduction '" + spec.name +
+                                        "' has an invalid component count");
+        }
+        if ((spec.first_component + spec.num_components > 1) && inputs[spec.field].stride == 0) {
+            throw std::invalid_argument("DeterministicReducer: reduction '" + spec.name +
+                                        "' reads components of a field without a stride");
+        }
+        if ((spec.volume_weighted || spec.level >= 0) && !levels) {
+            throw std::invalid_argument("DeterministicReducer: reduction '" + spec.name +
+                                        "' needs cell levels but none were given");
+        }
+    }
+}
+
+ReductionPartials DeterministicReducer::reduceLocal(const std::vector<ReductionSpec>& specs,
+                                                    const std::vector<FieldView>& inputs,
+                                                    const void* levels,
+                                                    size_t num_cells) {
+    validate(specs, inputs, levels);
+
+    std::vector<ReduceOp> ops;
+    ops.reserve(specs.size());
+    for (const auto& spec : specs) {
+        ops.push_back(spec.op);
+    }
+    ReductionPartials partials(ops);
+    if (specs.empty() || num_cells == 0) {
+        return partials;
+    }
+
+    if (useHostPath()) {
+        const uint8_t* cell_levels = static_cast<const uint8_t*>(levels);
+        for (size_t cell = 0; cell < num_cells; ++cell) {
+            const float volume = cell_levels ? std::ldexp(1.0f, -3 * cell_levels[cell]) : 1.0f;
+            for (size_t r = 0; r < specs.size(); ++r) {
+                if (specs[r].level >= 0 && cell_levels[cell] != specs[r].level) continue;
+                partials.addTerm(r, cellTerm(specs[r], inputs, cell, specs[r].volume_weighted ? volume : 1.0f));
+            }
+        }
+        return partials;
+    }
+
+    if (num_cells > std::numeric_limits<uint32_t>::max()) {
+        throw std::invalid_argument("DeterministicReducer: too many cells for one launch");
+    }
+
+    std::vector<uint32_t> spec_words(MAX_FUSED * SPEC_WORDS, 0);
+    for (size_t r = 0; r < specs.size(); ++r) {
+        const ReductionSpec& spec = specs[r];
+        const FieldView& view = inputs[spec.field];
+        uint32_t* w = &spec_words[r * SPEC_WORDS];
+        w[0] = static_cast<uint32_t>(spec.op);
+        w[1] = static_cast<uint32_t>(spec.term);
+        w[2] = spec.field;
+        w[3] = spec.num_components;
+        w[4] = static_cast<uint32_t>(spec.first_component * view.stride);
+        w[5] = static_cast<uint32_t>(view.stride);
+        w[6] = spec.weight_field >= 0 ? static_cast<uint32_t>(spec.weight_field) : NO_WEIGHT;
+        w[7] = spec.volume_weighted ? 1u : 0u;
+        std::memcpy(&w[8], &spec.scale, sizeof(float));
+        w[9] = spec.level >= 0 ? static_cast<uint32_t>(spec.level) : ALL_LEVELS;
+    }
+    m_backend->copyHostToDevice(spec_words.data(), *m_spec_buffer, spec_words.size() * sizeof(uint32_t));
+
+    const size_t num_groups = std::min(MAX_WORK_GROUPS, (num_cells + WORK_GROUP_SIZE - 1) / WORK_GROUP_SIZE);
+    const size_t num_records = num_groups * specs.size();
+    if (num_records > m_partials_capacity) {
+        m_partials_buffer = m_backend->allocateBuffer(num_records * WORDS * sizeof(int64_t));
+        m_partials_capacity = num_records;
+    }
+
+    // Unused input slots alias input 0; the kernel never reads them
+    auto input = [&](size_t i) { return inputs[i < inputs.size() ? i : 0].data; };
+    m_backend->launchKernel(m_kernel, num_groups * WORK_GROUP_SIZE, WORK_GROUP_SIZE, {
+        IBackend::KernelArg::fromBuffer(input(0)),
+        IBackend::KernelArg::fromBuffer(input(1)),
+        IBackend::KernelArg::fromBuffer(input(2)),
+        IBackend::KernelArg::fromBuffer(input(3)),
+        IBackend::KernelArg::fromBuffer(levels ? levels : input(0)),
+        IBackend::KernelArg::fromScalar(static_cast<uint32_t>(levels ? 1 : 0)),
+        IBackend::KernelArg::fromBuffer(m_spec_buffer->getDevicePointer()),
+        IBackend::KernelArg::fromScalar(static_cast<uint32_t>(specs.size())),
+        IBackend::KernelArg::fromScalar(static_cast<uint32_t>(num_cells)),
+        IBackend::KernelArg::fromBuffer(m_partials_buffer->getDevicePointer())
+    });
+
+    std::vector<int64_t> records(num_records * WORDS);
+    m_backend->copyDeviceToHost(*m_partials_buffer, records.data(), records.size() * sizeof(int64_t));
+
+    // Work-group order; exact merges make the order immaterial, fixing it
+    // keeps the host side free of surprises
+    for (size_t g = 0; g < num_groups; ++g) {
+        for (size_t r = 0; r < specs.size(); ++r) {
+            partials.mergeRecord(r, &records[(g * specs.size() + r) * WORDS]);
+        }
+    }
+    return partials;
+}
+
+std::vector<double> DeterministicReducer::allReduce(const ReductionPartials& local,
+                                                    hilbert::HilbertIndex first_key,
+                                                    const GatherFn& gather) {
+    if (!gather) {
+        return local.values();
+    }
+
+    // Record: first key, then the serialized partials
+    std::vector<int64_t> record(1 + local.size() * WORDS);
+    record[0] = static_cast<int64_t>(first_key);
+    auto words = local.serialize();
+    std::copy(words.begin(), words.end(), record.begin() + 1);
+
+    const size_t record_bytes = record.size() * sizeof(int64_t);
+    std::vector<uint8_t> gathered = gather(record.data(), record_bytes);
+    if (gathered.empty() || gathered.size() % record_bytes != 0) {
+        throw std::runtime_error("DeterministicReducer: gathered " + std::to_string(gathered.size()) +
+                                 " bytes, not a whole number of " + std::to_string(record_bytes) +
+                                 "-byte records");
+    }
+
+    const size_t num_ranks = gathered.size() / record_bytes;
+    std::vector<std::vector<int64_t>> records(num_ranks, std::vector<int64_t>(record.size()));
+    for (size_t rank = 0; rank < num_ranks; ++rank) {
+        std::memcpy(records[rank].data(), gathered.data() + rank * record_bytes, record_bytes);
+    }
+
+    // Hilbert order of the ranks' subdomains, rank as tie-break
+    std::vector<size_t> order(num_ranks);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return static_cast<uint64_t>(records[a][0]) < static_cast<uint64_t>(records[b][0]);
+    });
+
+    std::vector<ReduceOp> ops(local.size());
+    for (size_t i = 0; i < ops.size(); ++i) {
+        ops[i] = local.op(i);
+    }
+    ReductionPartials global(ops);
+    for (size_t rank : order) {
+        for (size_t i = 0; i < ops.size(); ++i) {
+            global.mergeRecord(i, &records[rank][1 + i * WORDS]);
+        }
+    }
+    return global.values();
+}
+
+std::vector<double> DeterministicReducer::reduce(const std::vector<ReductionSpec>& specs,
+                                                 const std::vector<FieldView>& inputs,
+                                                 const void* levels,
+                                                 size_t num_cells,
+                                                 hilbert::HilbertIndex first_key,
+                                                 const GatherFn& gather) {
+    return allReduce(reduceLocal(specs, inputs, levels, num_cells), first_key, gather);
+}
+
+} // namespace reduction
+} // namespace fluidloom
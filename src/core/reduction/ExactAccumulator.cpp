@@ -0,0 +1,172 @@
+#include "fluidloom/core/reduction/ExactAccumulator.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace fluidloom {
+namespace reduction {
+
+namespace {
+
+constexpr int64_t DIGIT_RADIX = int64_t(1) << ExactAccumulator::DIGIT_BITS;
+constexpr size_t MAGNITUDE_WORDS = ExactAccumulator::DIGITS + 1;  // Top digit may exceed 32 bits
+
+// Bits [lo, lo + 64) of a little-endian array of 32-bit words
+uint64_t extractBits(const std::array<uint32_t, MAGNITUDE_WORDS>& words, int lo) {
+    const int first = lo / 32;
+    const int offset = lo % 32;
+    auto word = [&](int i) -> uint64_t {
+        return i < static_cast<int>(words.size()) ? words[i] : 0;
+    };
+    uint64_t bits = (word(first) | (word(first + 1) << 32)) >> offset;
+    if (offset > 0) {
+        bits |= word(first + 2) << (64 - offset);
+    }
+    return bits;
+}
+
+bool anyBitsBelow(const std::array<uint32_t, MAGNITUDE_WORDS>& words, int lo) {
+    const int first = lo / 32;
+    for (int i = 0; i < first; ++i) {
+        if (words[i] != 0) return true;
+    }
+    const uint32_t mask = (lo % 32) ? ((1u << (lo % 32)) - 1) : 0;
+    return (words[first] & mask) != 0;
+}
+
+} // namespace
+
+void ExactAccumulator::add(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const bool negative = bits >> 31;
+    const uint32_t exponent = (bits >> 23) & 0xFF;
+    const uint32_t fraction = bits & 0x7FFFFF;
+
+    if (exponent == 0xFF) {
+        m_flags |= fraction ? FLAG_NAN : (negative ? FLAG_NEG_INF : FLAG_POS_INF);
+        return;
+    }
+    if (exponent == 0 && fraction == 0) {
+        return;
+    }
+
+    // value = mantissa · 2^(exponent - 150), subnormals at 2^-149
+    const uint64_t mantissa = exponent ? (fraction | 0x800000u) : fraction;
+    const int position = (exponent ? static_cast<int>(exponent) - 150 : -149) + BIAS;
+    const uint64_t shifted = mantissa << (position % DIGIT_BITS);  // At most 55 bits
+    const int digit = position / DIGIT_BITS;
+
+    const int64_t lo = static_cast<int64_t>(shifted & (DIGIT_RADIX - 1));
+    const int64_t hi = static_cast<int64_t>(shifted >> DIGIT_BITS);
+    if (negative) {
+        m_digits[digit] -= lo;
+        m_digits[digit + 1] -= hi;
+    } else {
+        m_digits[digit] += lo;
+        m_digits[digit + 1] += hi;
+    }
+
+    if (++m_pending >= MAX_PENDING) {
+        normalize();
+    }
+}
+
+void ExactAccumulator::merge(const ExactAccumulator& other) {
+    ExactAccumulator rhs = other;
+    rhs.normalize();
+    normalize();
+    for (int i = 0; i < DIGITS; ++i) {
+        m_digits[i] += rhs.m_digits[i];
+    }
+    m_flags |= rhs.m_flags;
+    normalize();
+}
+
+void ExactAccumulator::normalize() {
+    for (int i = 0; i < DIGITS - 1; ++i) {
+        // Floor division by the radix, so the remainder is non-negative
+        int64_t carry = m_digits[i] / DIGIT_RADIX;
+        if (m_digits[i] - carry * DIGIT_RADIX < 0) {
+            --carry;
+        }
+        m_digits[i] -= carry * DIGIT_RADIX;
+        m_digits[i + 1] += carry;
+    }
+    m_pending = 0;
+}
+
+double ExactAccumulator::toDouble() const {
+    if ((m_flags & FLAG_NAN) || ((m_flags & FLAG_POS_INF) && (m_flags & FLAG_NEG_INF))) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    if (m_flags & FLAG_POS_INF) return std::numeric_limits<double>::infinity();
+    if (m_flags & FLAG_NEG_INF) return -std::numeric_limits<double>::infinity();
+
+    ExactAccumulator magnitude = *this;
+    magnitude.normalize();
+    const bool negative = magnitude.m_digits[DIGITS - 1] < 0;
+    if (negative) {
+        for (auto& d : magnitude.m_digits) d = -d;
+        magnitude.normalize();
+    }
+
+    // Non-negative now: lower digits are 32-bit, the top digit up to 63 bits
+    std::array<uint32_t, MAGNITUDE_WORDS> words{};
+    for (int i = 0; i < DIGITS; ++i) {
+        words[i] |= static_cast<uint32_t>(magnitude.m_digits[i]);
+    }
+    words[DIGITS] = static_cast<uint32_t>(static_cast<uint64_t>(magnitude.m_digits[DIGITS - 1]) >> 32);
+
+    int top = static_cast<int>(MAGNITUDE_WORDS) * 32 - 1;
+    while (top >= 0 && !((words[top / 32] >> (top % 32)) & 1u)) {
+        --top;
+    }
+    if (top < 0) {
+        return 0.0;
+    }
+
+    // 64-bit window with a sticky bit: the uint64 -> double conversion then
+    // rounds exactly as rounding the full-width integer would
+    const int lo = top >= 63 ? top - 63 : 0;
+    uint64_t window = extractBits(words, lo);
+    if (lo > 0 && anyBitsBelow(words, lo)) {
+        window |= 1;
+    }
+    const double result = std::ldexp(static_cast<double>(window), lo - BIAS);
+    return negative ? -result : result;
+}
+
+bool ExactAccumulator::isZero() const {
+    ExactAccumulator normalized = *this;
+    normalized.normalize();
+    for (int64_t d : normalized.m_digits) {
+        if (d != 0) return false;
+    }
+    return m_flags == 0;
+}
+
+void ExactAccumulator::store(int64_t* words) const {
+    ExactAccumulator normalized = *this;
+    normalized.normalize();
+    std::memcpy(words, normalized.m_digits.data(), DIGITS * sizeof(int64_t));
+    words[DIGITS] = static_cast<int64_t>(m_flags);
+}
+
+ExactAccumulator ExactAccumulator::load(const int64_t* words) {
+    ExactAccumulator acc;
+    std::memcpy(acc.m_digits.data(), words, DIGITS * sizeof(int64_t));
+    acc.m_flags = static_cast<uint64_t>(words[DIGITS]);
+    acc.normalize();
+    return acc;
+}
+
+bool ExactAccumulator::operator==(const ExactAccumulator& other) const {
+    ExactAccumulator a = *this, b = other;
+    a.normalize();
+    b.normalize();
+    return a.m_digits == b.m_digits && a.m_flags == b.m_flags;
+}
+
+} // namespace reduction
+} // namespace fluidloom
@@ -14,22 +14,39 @@ bool FieldRegistry::registerField(const fields::FieldDescriptor& desc) {
         FL_LOG(ERROR) << "Attempt to register invalid field descriptor: " << desc.name;
         return false;
     }
+    SymbolId symbol = intern(desc.name);
     std::unique_lock<std::shared_mutex> lock(mutex_);
-    if (by_name_.find(desc.name) != by_name_.end()) {
+    if (findLocked(symbol)) {
         FL_LOG(WARN) << "Field '" << desc.name << "' already registered, skipping";
         return false;
     }
-    by_name_[desc.name] = desc;
-    by_id_[desc.id] = desc;
+    if (slot_by_symbol_.size() <= symbol) {
+        slot_by_symbol_.resize(symbol + 1, 0);
+    }
+    fields_.push_back(desc);
+    slot_by_symbol_[symbol] = static_cast<uint32_t>(fields_.size());
+    by_id_[desc.id] = static_cast<uint32_t>(fields_.size() - 1);
     FL_LOG(INFO) << "Registered field: " << desc.name << " (id=" << desc.id << ", components=" << desc.num_components << ")";
     return true;
 }
 
+const fields::FieldDescriptor* FieldRegistry::findLocked(SymbolId symbol) const {
+    if (symbol >= slot_by_symbol_.size() || slot_by_symbol_[symbol] == 0) {
+        return nullptr;
+    }
+    return &fields_[slot_by_symbol_[symbol] - 1];
+}
+
+const fields::FieldDescriptor* FieldRegistry::find(SymbolId symbol) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return findLocked(symbol);
+}
+
 std::optional<fields::FieldDescriptor> FieldRegistry::lookupByName(const std::string& name) const {
+    SymbolId symbol = StringInterner::instance().find(name);
     std::shared_lock<std::shared_mutex> lock(mutex_);
-    auto it = by_name_.find(name);
-    if (it != by_name_.end()) {
-        return it->second;
+    if (const auto* desc = findLocked(symbol)) {
+        return *desc;
     }
     return std::nullopt;
 }
@@ -38,29 +55,31 @@ std::optional<fields::FieldDescriptor> FieldRegistry::lookupById(fields::FieldHa
     std::shared_lock<std::shared_mutex> lock(mutex_);
     auto it = by_id_.find(handle.id);
     if (it != by_id_.end()) {
-        return it->second;
+        return fields_[it->second];
     }
     return std::nullopt;
 }
 
 bool FieldRegistry::exists(const std::string& name) const {
+    SymbolId symbol = StringInterner::instance().find(name);
     std::shared_lock<std::shared_mutex> lock(mutex_);
-    return by_name_.find(name) != by_name_.end();
+    return findLocked(symbol) != nullptr;
 }
 
 std::vector<std::string> FieldRegistry::getAllNames() const {
     std::shared_lock<std::shared_mutex> lock(mutex_);
     std::vector<std::string> names;
-    names.reserve(by_name_.size());
-    for (const auto& pair : by_name_) {
-        names.push_back(pair.first);
+    names.reserve(fields_.size());
+    for (const auto& desc : fields_) {
+        names.push_back(desc.name);
     }
     return names;
 }
 
 void FieldRegistry::clear() {
     std::unique_lock<std::shared_mutex> lock(mutex_);
-    by_name_.clear();
+    fields_.clear();
+    slot_by_symbol_.clear();
     by_id_.clear();
     FL_LOG(INFO) << "Cleared FieldRegistry";
 }
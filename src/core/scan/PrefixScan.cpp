@@ -0,0 +1,209 @@
+#include "fluidloom/core/scan/PrefixScan.h"
+#include "fluidloom/common/FluidLoomError.h"
+#include "fluidloom/common/Logger.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fluidloom {
+namespace scan {
+
+namespace {
+
+constexpr const char* KERNEL_SOURCE = "kernels/scan/prefix_scan.cl";
+
+} // namespace
+
+PrefixScan::PrefixScan(cl_context context, cl_command_queue queue)
+    : m_context(context), m_queue(queue), m_program(nullptr),
+      m_kernel_reduce_tiles(nullptr), m_kernel_scan_tile_sums(nullptr), m_kernel_scan_tiles(nullptr),
+      m_tile_sums(nullptr), m_tile_capacity(0) {
+    compileKernels();
+}
+
+PrefixScan::~PrefixScan() {
+    if (m_kernel_reduce_tiles) clReleaseKernel(m_kernel_reduce_tiles);
+    if (m_kernel_scan_tile_sums) clReleaseKernel(m_kernel_scan_tile_sums);
+    if (m_kernel_scan_tiles) clReleaseKernel(m_kernel_scan_tiles);
+    if (m_program) clReleaseProgram(m_program);
+    if (m_tile_sums) clReleaseMemObject(m_tile_sums);
+}
+
+std::string PrefixScan::loadKernelSource(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open kernel source: " + filename);
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+void PrefixScan::compileKernels() {
+    std::string src = loadKernelSource(KERNEL_SOURCE);
+    const char* src_str = src.c_str();
+    size_t src_len = src.length();
+    cl_int err;
+
+    m_program = clCreateProgramWithSource(m_context, 1, &src_str, &src_len, &err);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to create prefix scan program");
+
+    err = clBuildProgram(m_program, 0, nullptr, "-cl-std=CL1.2", nullptr, nullptr);
+    if (err != CL_SUCCESS) {
+        size_t device_size;
+        clGetContextInfo(m_context, CL_CONTEXT_DEVICES, 0, nullptr, &device_size);
+        std::vector<cl_device_id> devices(device_size / sizeof(cl_device_id));
+        clGetContextInfo(m_context, CL_CONTEXT_DEVICES, device_size, devices.data(), nullptr);
+
+        if (!devices.empty()) {
+            size_t log_size;
+            clGetProgramBuildInfo(m_program, devices[0], CL_PROGRAM_BUILD_LOG, 0, nullptr, &log_size);
+            std::vector<char> log(log_size + 1);
+            clGetProgramBuildInfo(m_program, devices[0], CL_PROGRAM_BUILD_LOG, log_size, log.data(), nullptr);
+            log[log_size] = '\0';
+            FL_LOG(ERROR) << "Prefix scan build log: " << log.data();
+        }
+        FL_THROW_OPENCL(err, "Failed to build prefix scan kernels");
+    }
+
+    m_kernel_reduce_tiles = clCreateKernel(m_program, "scan_reduce_tiles", &err);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to create scan_reduce_tiles kernel");
+    m_kernel_scan_tile_sums = clCreateKernel(m_program, "scan_tile_sums", &err);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to create scan_tile_sums kernel");
+    m_kernel_scan_tiles = clCreateKernel(m_program, "scan_tiles", &err);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to create scan_tiles kernel");
+}
+
+void PrefixScan::ensureTileSums(size_t num_tiles) {
+    if (m_tile_sums && m_tile_capacity >= num_tiles + 1) return;
+    if (m_tile_sums) clReleaseMemObject(m_tile_sums);
+
+    cl_int err;
+    m_tile_sums = clCreateBuffer(m_context, CL_MEM_READ_WRITE, (num_tiles + 1) * sizeof(uint32_t), nullptr, &err);
+    if (err != CL_SUCCESS) {
+        m_tile_sums = nullptr;
+        m_tile_capacity = 0;
+        FL_THROW_OPENCL(err, "Failed to allocate scan tile sums");
+    }
+    m_tile_capacity = num_tiles + 1;
+}
+
+void PrefixScan::exclusiveScan(cl_mem input, cl_mem output, size_t n, uint32_t* total) {
+    if (n == 0) {
+        if (total) *total = 0;
+        return;
+    }
+    if (n > UINT32_MAX) {
+        throw std::invalid_argument("PrefixScan: " + std::to_string(n) + " elements exceed the 32-bit index range");
+    }
+
+    const size_t num_tiles = numTiles(n);
+    ensureTileSums(num_tiles);
+
+    const cl_uint n_uint = static_cast<cl_uint>(n);
+    const cl_uint num_tiles_uint = static_cast<cl_uint>(num_tiles);
+    size_t local_size = WORK_GROUP_SIZE;
+    size_t global_size = num_tiles * WORK_GROUP_SIZE;
+    cl_int err;
+
+    // 1. Per-tile sums
+    clSetKernelArg(m_kernel_reduce_tiles, 0, sizeof(cl_mem), &input);
+    clSetKernelArg(m_kernel_reduce_tiles, 1, sizeof(cl_mem), &m_tile_sums);
+    clSetKernelArg(m_kernel_reduce_tiles, 2, sizeof(cl_uint), &n_uint);
+    err = clEnqueueNDRangeKernel(m_queue, m_kernel_reduce_tiles, 1, nullptr, &global_size, &local_size, 0, nullptr, nullptr);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to enqueue scan_reduce_tiles");
+
+    // 2. Scan of the tile sums by one work-group; total lands in tile_sums[num_tiles]
+    clSetKernelArg(m_kernel_scan_tile_sums, 0, sizeof(cl_mem), &m_tile_sums);
+    clSetKernelArg(m_kernel_scan_tile_sums, 1, sizeof(cl_uint), &num_tiles_uint);
+    size_t single_group = WORK_GROUP_SIZE;
+    err = clEnqueueNDRangeKernel(m_queue, m_kernel_scan_tile_sums, 1, nullptr, &single_group, &local_size, 0, nullptr, nullptr);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to enqueue scan_tile_sums");
+
+    // 3. Tile scans offset by the scanned tile sums
+    clSetKernelArg(m_kernel_scan_tiles, 0, sizeof(cl_mem), &input);
+    clSetKernelArg(m_kernel_scan_tiles, 1, sizeof(cl_mem), &output);
+    clSetKernelArg(m_kernel_scan_tiles, 2, sizeof(cl_mem), &m_tile_sums);
+    clSetKernelArg(m_kernel_scan_tiles, 3, sizeof(cl_uint), &n_uint);
+    err = clEnqueueNDRangeKernel(m_queue, m_kernel_scan_tiles, 1, nullptr, &global_size, &local_size, 0, nullptr, nullptr);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to enqueue scan_tiles");
+
+    if (total) {
+        err = clEnqueueReadBuffer(m_queue, m_tile_sums, CL_TRUE, num_tiles * sizeof(uint32_t), sizeof(uint32_t),
+                                  total, 0, nullptr, nullptr);
+        if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to read scan total");
+    }
+}
+
+void PrefixScan::exclusiveScan(cl_mem input, cl_mem output, size_t n, cl_mem total_buffer, size_t total_index) {
+    cl_int err;
+    if (n == 0) {
+        const uint32_t zero = 0;
+        err = clEnqueueFillBuffer(m_queue, total_buffer, &zero, sizeof(uint32_t), total_index * sizeof(uint32_t),
+                                  sizeof(uint32_t), 0, nullptr, nullptr);
+        if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to clear scan total");
+        return;
+    }
+
+    exclusiveScan(input, output, n);
+
+    // The tile-sum scan left the total in tile_sums[num_tiles]
+    err = clEnqueueCopyBuffer(m_queue, m_tile_sums, total_buffer, numTiles(n) * sizeof(uint32_t),
+                              total_index * sizeof(uint32_t), sizeof(uint32_t), 0, nullptr, nullptr);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to copy scan total");
+}
+
+uint32_t PrefixScan::exclusiveScanHost(const uint32_t* in, uint32_t* out, size_t n) {
+    uint32_t running = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const uint32_t value = in[i];
+        out[i] = running;
+        running += value;
+    }
+    return running;
+}
+
+uint32_t PrefixScan::exclusiveScanTiled(const uint32_t* in, uint32_t* out, size_t n, size_t tile_size) {
+    if (tile_size == 0) {
+        throw std::invalid_argument("PrefixScan: tile size must be positive");
+    }
+    const size_t num_tiles = (n + tile_size - 1) / tile_size;
+
+    // scan_reduce_tiles
+    std::vector<uint32_t> tile_sums(num_tiles + 1, 0);
+    for (size_t t = 0; t < num_tiles; ++t) {
+        const size_t end = std::min(n, (t + 1) * tile_size);
+        for (size_t i = t * tile_size; i < end; ++i) {
+            tile_sums[t] += in[i];
+        }
+    }
+
+    // scan_tile_sums: chunks of tile_size sums with a running carry
+    uint32_t carry = 0;
+    for (size_t chunk = 0; chunk < num_tiles; chunk += tile_size) {
+        const size_t count = std::min(tile_size, num_tiles - chunk);
+        const uint32_t chunk_total = exclusiveScanHost(&tile_sums[chunk], &tile_sums[chunk], count);
+        for (size_t k = 0; k < count; ++k) {
+            tile_sums[chunk + k] += carry;
+        }
+        carry += chunk_total;
+    }
+    tile_sums[num_tiles] = carry;
+
+    // scan_tiles
+    for (size_t t = 0; t < num_tiles; ++t) {
+        const size_t begin = t * tile_size;
+        const size_t count = std::min(tile_size, n - begin);
+        exclusiveScanHost(in + begin, out + begin, count);
+        for (size_t k = 0; k < count; ++k) {
+            out[begin + k] += tile_sums[t];
+        }
+    }
+    return tile_sums[num_tiles];
+}
+
+} // namespace scan
+} // namespace fluidloom
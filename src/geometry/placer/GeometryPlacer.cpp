@@ -1,6 +1,6 @@
 #include "fluidloom/geometry/GeometryPlacer.h"
 #include "fluidloom/common/Logger.h"
-#include "fluidloom/core/hilbert/HilbertCodec.h"
+#include "fluidloom/core/backend/IBackend.h"
 #include <algorithm>
 #include <set>
 
@@ -11,6 +11,42 @@ GeometryPlacer::GeometryPlacer() {
     FL_LOG(INFO) << "GeometryPlacer initialized";
 }
 
+void GeometryPlacer::setBackend(IBackend* backend) {
+    if (backend != m_backend) {
+        m_encoder.reset();
+    }
+    m_backend = backend;
+}
+
+std::vector<hilbert::HilbertIndex> GeometryPlacer::encodeCells(const std::vector<CellCoord>& cells) {
+    const size_t n = cells.size();
+    std::vector<hilbert::HilbertIndex> keys(n);
+    
+    if (!m_backend || n < DEVICE_ENCODE_THRESHOLD) {
+        for (size_t i = 0; i < n; ++i) {
+            keys[i] = hilbert::encode(cells[i].x, cells[i].y, cells[i].z);
+        }
+        return keys;
+    }
+    
+    // Coordinates are produced on the host, so pack them as cl_int3 and upload once
+    std::vector<int32_t> packed(n * 4, 0);
+    for (size_t i = 0; i < n; ++i) {
+        packed[i * 4 + 0] = cells[i].x;
+        packed[i * 4 + 1] = cells[i].y;
+        packed[i * 4 + 2] = cells[i].z;
+    }
+    
+    if (!m_encoder) {
+        m_encoder = std::make_unique<hilbert::DeviceEncoder>(*m_backend);
+    }
+    auto d_coords = m_backend->allocateBuffer(packed.size() * sizeof(int32_t), packed.data());
+    auto d_keys = m_backend->allocateBuffer(n * sizeof(hilbert::HilbertIndex));
+    m_encoder->encode(*d_coords, nullptr, *d_keys, n);
+    m_backend->copyDeviceToHost(*d_keys, keys.data(), n * sizeof(hilbert::HilbertIndex));
+    return keys;
+}
+
 void GeometryPlacer::placeGeometry(
     const std::vector<GeometryDescriptor>& geometries,
     std::vector<CellCoord>& fluid_cells,
@@ -98,11 +134,11 @@ std::vector<VoxelizedCell> GeometryPlacer::processGeometry(
     }
     
     // Convert to VoxelizedCell and assign material
+    const auto hilbert_keys = encodeCells(raw_cells);
     result.reserve(raw_cells.size());
-    for (const auto& cell : raw_cells) {
-        // Compute Hilbert index
-        uint64_t hilbert = fluidloom::hilbert::encode(cell.x, cell.y, cell.z);
-        result.emplace_back(cell.x, cell.y, cell.z, geom.material_id, hilbert);
+    for (size_t i = 0; i < raw_cells.size(); ++i) {
+        const auto& cell = raw_cells[i];
+        result.emplace_back(cell.x, cell.y, cell.z, geom.material_id, hilbert_keys[i]);
     }
     
     FL_LOG(INFO) << "Geometry '" << geom.name << "' produced " << result.size() << " cells";
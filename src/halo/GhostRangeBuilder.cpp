@@ -2,6 +2,8 @@
 #include "fluidloom/common/mpi/MPIEnvironment.h"
 #include "fluidloom/common/Logger.h"
 #include <algorithm>
+#include <limits>
+#include <stdexcept>
 
 namespace fluidloom {
 namespace halo {
@@ -12,6 +14,17 @@ GhostRangeBuilder::GhostRangeBuilder() {
     m_topology.size = env.getSize();
     m_topology.prev_rank = (m_topology.rank > 0) ? m_topology.rank - 1 : -1;
     m_topology.next_rank = (m_topology.rank < m_topology.size - 1) ? m_topology.rank + 1 : -1;
+    
+    if (m_topology.prev_rank >= 0) m_neighbors.push_back(m_topology.prev_rank);
+    if (m_topology.next_rank >= 0) m_neighbors.push_back(m_topology.next_rank);
+}
+
+GhostRangeBuilder::~GhostRangeBuilder() {
+    int finalized = 0;
+    MPI_Finalized(&finalized);
+    if (m_neighbor_comm != MPI_COMM_NULL && !finalized) {
+        MPI_Comm_free(&m_neighbor_comm);
+    }
 }
 
 void GhostRangeBuilder::buildGlobalTopology(hilbert::HilbertIndex local_min, hilbert::HilbertIndex local_max) {
@@ -45,9 +58,9 @@ void GhostRangeBuilder::buildGlobalTopology(hilbert::HilbertIndex local_min, hil
 }
 
 int GhostRangeBuilder::findOwnerRank(hilbert::HilbertIndex idx) const {
-    for (int i = 0; i < m_topology.size; ++i) {
+    for (size_t i = 0; i < m_global_ranges.size(); ++i) {
         if (idx >= m_global_ranges[i].first && idx <= m_global_ranges[i].second) {
-            return i;
+            return static_cast<int>(i);
         }
     }
     return -1;
@@ -57,19 +70,195 @@ std::vector<GhostCandidate> GhostRangeBuilder::identifyGhostCandidates(
     const std::vector<hilbert::HilbertIndex>& local_cells,
     int halo_depth
 ) {
-    (void)halo_depth; // Unused for now
     std::vector<GhostCandidate> candidates;
-    if (local_cells.empty()) return candidates;
+    if (local_cells.empty() || halo_depth <= 0 || m_global_ranges.empty()) return candidates;
     
-    // Simplified logic: Check boundaries
-    // In a real implementation, we would check neighbors of boundary cells
-    // For now, we'll request a range from neighbors if we are at the edge
+    // Split points live in finest-level key space, so cells are decoded there
+    constexpr uint8_t level = hilbert::MAX_REFINEMENT_LEVEL;
+    constexpr int32_t extent = 1 << level;
+    
+    // Off-rank keys within halo_depth cells of a local cell, grouped by owner
+    std::map<int, std::vector<hilbert::HilbertIndex>> remote_keys;
+    for (hilbert::HilbertIndex cell : local_cells) {
+        int32_t x, y, z;
+        hilbert::decode(cell, level, x, y, z);
+        for (int32_t dz = -halo_depth; dz <= halo_depth; ++dz) {
+            for (int32_t dy = -halo_depth; dy <= halo_depth; ++dy) {
+                for (int32_t dx = -halo_depth; dx <= halo_depth; ++dx) {
+                    int32_t nx = x + dx, ny = y + dy, nz = z + dz;
+                    if (nx < 0 || ny < 0 || nz < 0 || nx >= extent || ny >= extent || nz >= extent) continue;
+                    
+                    hilbert::HilbertIndex key = hilbert::encode(nx, ny, nz, level);
+                    int owner = findOwnerRank(key);
+                    if (owner >= 0 && owner != m_topology.rank) {
+                        remote_keys[owner].push_back(key);
+                    }
+                }
+            }
+        }
+    }
     
-    // TODO: Implement sophisticated neighbor search using Hilbert curve properties
-    // This is a placeholder for the actual geometric neighbor finding
+    // Runs of consecutive keys become one inclusive range per request
+    for (auto& [owner, keys] : remote_keys) {
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        
+        GhostCandidate run{keys.front(), keys.front(), owner};
+        for (size_t i = 1; i < keys.size(); ++i) {
+            if (keys[i] == run.end_idx + 1) {
+                run.end_idx = keys[i];
+            } else {
+                candidates.push_back(run);
+                run = GhostCandidate{keys[i], keys[i], owner};
+            }
+        }
+        candidates.push_back(run);
+    }
     
+    FL_LOG(DEBUG) << "Identified " << candidates.size() << " ghost ranges for " << local_cells.size()
+                  << " local cells at halo depth " << halo_depth;
     return candidates;
 }
 
+std::vector<int> GhostRangeBuilder::applySplits(const std::vector<uint64_t>& new_splits) {
+    int size = m_topology.size;
+    if (new_splits.size() != static_cast<size_t>(size - 1)) {
+        throw std::invalid_argument("Expected " + std::to_string(size - 1) + " split points, got " +
+                                    std::to_string(new_splits.size()));
+    }
+    
+    // Inclusive ranges need every rank to own at least one key: a zero or
+    // non-ascending split would wrap splits[r] - 1 below
+    for (int r = 0; r < size - 1; ++r) {
+        hilbert::HilbertIndex start = (r == 0) ? 0 : new_splits[r - 1];
+        if (new_splits[r] <= start) {
+            throw std::invalid_argument("Split point " + std::to_string(r) + " (" +
+                                        std::to_string(new_splits[r]) + ") leaves rank " +
+                                        std::to_string(r) + " an empty range");
+        }
+    }
+    
+    // Rank r owns [splits[r-1], splits[r]); stored inclusive like buildGlobalTopology
+    std::vector<std::pair<hilbert::HilbertIndex, hilbert::HilbertIndex>> ranges(size);
+    for (int r = 0; r < size; ++r) {
+        hilbert::HilbertIndex start = (r == 0) ? 0 : new_splits[r - 1];
+        hilbert::HilbertIndex end = (r == size - 1) ? std::numeric_limits<hilbert::HilbertIndex>::max()
+                                                    : new_splits[r] - 1;
+        ranges[r] = {start, end};
+    }
+    
+    std::vector<int> moved;
+    for (int r = 0; r < size; ++r) {
+        if (m_global_ranges.size() != ranges.size() || m_global_ranges[r] != ranges[r]) {
+            moved.push_back(r);
+        }
+    }
+    
+    m_global_ranges = std::move(ranges);
+    m_topology.local_min_idx = m_global_ranges[m_topology.rank].first;
+    m_topology.local_max_idx = m_global_ranges[m_topology.rank].second;
+    
+    return moved;
+}
+
+bool GhostRangeBuilder::rebuildAfterRebalance(
+    const std::vector<uint64_t>& new_splits,
+    const std::vector<hilbert::HilbertIndex>& local_cells,
+    int halo_depth
+) {
+    std::vector<int> moved = applySplits(new_splits);
+    if (moved.empty()) {
+        FL_LOG(DEBUG) << "Rebalance left all split boundaries in place, ghost ranges unchanged";
+        return false;
+    }
+    
+    // Our ghosts depend only on our own range and on who owns the cells just
+    // beyond it, i.e. the SFC neighbors
+    auto affects_us = [this](int r) {
+        return r == m_topology.rank || r == m_topology.prev_rank || r == m_topology.next_rank;
+    };
+    bool local_changed = std::any_of(moved.begin(), moved.end(), affects_us);
+    
+    if (local_changed) {
+        m_ghost_candidates = identifyGhostCandidates(local_cells, halo_depth);
+    }
+    
+    // Every rank derives the same moved set, so all ranks enter the neighbor
+    // collective together; unaffected ranks only send "unchanged" markers
+    exchangeWithNeighbors(local_changed);
+    
+    FL_LOG(INFO) << "Ghost ranges refreshed after rebalance: " << moved.size() << " ranks moved, "
+                 << (local_changed ? "recomputed " : "kept ") << m_ghost_candidates.size()
+                 << " local candidates";
+    
+    return local_changed;
+}
+
+void GhostRangeBuilder::ensureNeighborComm() {
+    if (m_neighbor_comm != MPI_COMM_NULL) return;
+    
+    // Symmetric graph: we send to and receive from the same SFC neighbors
+    int degree = static_cast<int>(m_neighbors.size());
+    MPI_Dist_graph_create_adjacent(
+        MPI_COMM_WORLD,
+        degree, m_neighbors.data(), MPI_UNWEIGHTED,
+        degree, m_neighbors.data(), MPI_UNWEIGHTED,
+        MPI_INFO_NULL, 0, &m_neighbor_comm
+    );
+}
+
+void GhostRangeBuilder::exchangeWithNeighbors(bool local_changed) {
+    ensureNeighborComm();
+    
+    const size_t degree = m_neighbors.size();
+    const int record = static_cast<int>(sizeof(GhostCandidate));
+    
+    // Per-neighbor payload; a count of -1 means "my requests to you are unchanged"
+    std::vector<int> send_counts(degree, -1);
+    std::vector<GhostCandidate> send_data;
+    std::vector<int> send_bytes(degree, 0);
+    std::vector<int> send_displs(degree, 0);
+    
+    if (local_changed) {
+        for (size_t n = 0; n < degree; ++n) {
+            send_displs[n] = static_cast<int>(send_data.size()) * record;
+            for (const auto& candidate : m_ghost_candidates) {
+                if (candidate.target_rank == m_neighbors[n]) {
+                    send_data.push_back(candidate);
+                }
+            }
+            send_counts[n] = static_cast<int>(send_data.size()) - send_displs[n] / record;
+            send_bytes[n] = send_counts[n] * record;
+        }
+    }
+    
+    std::vector<int> recv_counts(degree, 0);
+    MPI_Neighbor_alltoall(send_counts.data(), 1, MPI_INT,
+                          recv_counts.data(), 1, MPI_INT, m_neighbor_comm);
+    
+    std::vector<int> recv_bytes(degree, 0);
+    std::vector<int> recv_displs(degree, 0);
+    int total_recv = 0;
+    for (size_t n = 0; n < degree; ++n) {
+        recv_displs[n] = total_recv * record;
+        if (recv_counts[n] > 0) {
+            recv_bytes[n] = recv_counts[n] * record;
+            total_recv += recv_counts[n];
+        }
+    }
+    
+    std::vector<GhostCandidate> recv_data(total_recv);
+    MPI_Neighbor_alltoallv(send_data.data(), send_bytes.data(), send_displs.data(), MPI_BYTE,
+                           recv_data.data(), recv_bytes.data(), recv_displs.data(), MPI_BYTE,
+                           m_neighbor_comm);
+    
+    for (size_t n = 0; n < degree; ++n) {
+        if (recv_counts[n] < 0) continue;  // Neighbor's requests still valid
+        
+        auto first = recv_data.begin() + recv_displs[n] / record;
+        m_remote_requests[m_neighbors[n]].assign(first, first + recv_counts[n]);
+    }
+}
+
 } // namespace halo
 } // namespace fluidloom
@@ -1,6 +1,7 @@
 #include "fluidloom/halo/HaloExchanger.h"
 #include "fluidloom/common/Logger.h"
 #include "fluidloom/core/registry/FieldRegistry.h"
+#include "fluidloom/profiling/Profiler.h"
 #include <cstring>
 
 namespace fluidloom {
@@ -115,7 +116,15 @@ void HaloExchanger::startExchange() {
 void HaloExchanger::finishExchange() {
     if (m_requests.empty()) return;
     
-    MPI_Waitall(m_requests.size(), m_requests.data(), MPI_STATUSES_IGNORE);
+    // startExchange() posts a send/recv pair per neighbor in map order; waiting
+    // pair by pair lets the trace attribute halo wait time to each peer
+    size_t next = 0;
+    for (const auto& [rank, buffers] : m_neighbor_buffers) {
+        (void)buffers;
+        profiling::ScopedEvent wait("halo_wait", "halo", {{"peer", std::to_string(rank)}});
+        MPI_Waitall(2, &m_requests[next], MPI_STATUSES_IGNORE);
+        next += 2;
+    }
     m_requests.clear();
     
     for (auto& [rank, buffers] : m_neighbor_buffers) {
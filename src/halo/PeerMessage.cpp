@@ -0,0 +1,239 @@
+#include "fluidloom/halo/PeerMessage.h"
+#include "fluidloom/halo/InterpolationParams.h"
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+
+namespace fluidloom {
+namespace halo {
+
+namespace {
+
+constexpr size_t SEGMENT_ALIGNMENT_FLOATS = PeerMessageLayout::ALIGNMENT / sizeof(float);
+constexpr size_t WIRE_BYTES = offsetof(PeerSegment, index_offset);
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+const InterpolationLUT& interpolationLUT() {
+    static const InterpolationLUT lut = [] {
+        InterpolationLUT table;
+        table.initialize();
+        return table;
+    }();
+    return lut;
+}
+
+} // namespace
+
+PeerMessageLayout PeerMessageLayout::build(int peer,
+                                           Direction direction,
+                                           const std::vector<GhostRange>& ranges,
+                                           const std::vector<HaloFieldBinding>& fields,
+                                           uint32_t due_levels,
+                                           const std::vector<HaloFieldBinding>* restricted) {
+    if (restricted && restricted->size() != fields.size()) {
+        throw std::invalid_argument("PeerMessageLayout: " + std::to_string(restricted->size()) +
+                                    " restricted bindings for " + std::to_string(fields.size()) + " fields");
+    }
+
+    PeerMessageLayout layout;
+    layout.m_peer = peer;
+    layout.m_direction = direction;
+
+    struct Pending {
+        PeerSegment segment;
+        const std::vector<uint32_t>* indices;
+    };
+    std::vector<Pending> pending;
+
+    for (const auto& range : ranges) {
+        if (range.target_gpu != peer) continue;
+
+        const bool sending = direction == Direction::SEND;
+        const uint8_t source_level = sending ? range.local_level : range.remote_level;
+        const uint8_t target_level = sending ? range.remote_level : range.local_level;
+        if (source_level >= 32 || !(due_levels & (1u << source_level))) continue;
+
+        // Derived from the levels so both ranks agree on it
+        GhostRange::InterpolationType interpolation = GhostRange::InterpolationType::NONE;
+        if (source_level > target_level) interpolation = GhostRange::InterpolationType::VOLUME_WEIGHTED_AVERAGE;
+        if (source_level < target_level) interpolation = GhostRange::InterpolationType::TRILINEAR;
+        // Restricted before packing: the averaged values travel as copies
+        const bool pre_restricted = restricted &&
+                                    interpolation == GhostRange::InterpolationType::VOLUME_WEIGHTED_AVERAGE;
+        const bool interpolated = interpolation != GhostRange::InterpolationType::NONE && !pre_restricted;
+
+        // Interpolation happens on the sender; the receiver only scatters
+        const std::vector<uint32_t>* indices = &range.cached.local_cell_indices;
+        uint8_t sources_per_cell = 1;
+        if (sending && interpolated) {
+            indices = &range.cached.neighbor_cell_indices;
+            sources_per_cell = 8;
+        }
+        if (indices->size() % sources_per_cell != 0) {
+            throw std::invalid_argument("PeerMessageLayout: range " + range.getRangeId() +
+                                        " has an interpolation source list that is not a multiple of 8");
+        }
+        const size_t num_cells = indices->size() / sources_per_cell;
+        if (num_cells == 0) continue;
+
+        for (size_t slot = 0; slot < fields.size(); ++slot) {
+            PeerSegment segment{};
+            segment.hilbert_start = range.hilbert_start;
+            segment.hilbert_end = range.hilbert_end;
+            segment.field_id = fields[slot].field_id;
+            segment.num_cells = static_cast<uint32_t>(num_cells);
+            segment.num_components = fields[slot].num_components;
+            segment.source_level = source_level;
+            segment.target_level = target_level;
+            segment.interpolation = static_cast<uint8_t>(interpolation);
+            segment.sources_per_cell = interpolated ? 8 : 1;
+            if (interpolation == GhostRange::InterpolationType::TRILINEAR) {
+                const auto& params = interpolationLUT().get(source_level % InterpolationLUT::MAX_LEVEL,
+                                                            target_level % InterpolationLUT::MAX_LEVEL);
+                std::copy(params.weights.begin(), params.weights.end(), segment.weights);
+            } else if (interpolated) {
+                std::fill(std::begin(segment.weights), std::end(segment.weights), 0.125f);
+            } else {
+                segment.weights[0] = 1.0f;
+            }
+            segment.field_slot = static_cast<uint32_t>(slot);
+            segment.field_stride = fields[slot].stride;
+            if (sending && pre_restricted) {
+                segment.field_slot = static_cast<uint32_t>(fields.size() + slot);
+                segment.field_stride = (*restricted)[slot].stride;
+            }
+            pending.push_back({segment, indices});
+        }
+    }
+
+    std::stable_sort(pending.begin(), pending.end(), [](const Pending& a, const Pending& b) {
+        return std::tie(a.segment.hilbert_start, a.segment.hilbert_end, a.segment.source_level, a.segment.field_id) <
+               std::tie(b.segment.hilbert_start, b.segment.hilbert_end, b.segment.source_level, b.segment.field_id);
+    });
+
+    // Each (range, level) gather list is stored once and shared by its fields
+    uint32_t cells = 0;
+    size_t payload_floats = 0;
+    const std::vector<uint32_t>* previous = nullptr;
+    uint32_t previous_offset = 0;
+    for (auto& [segment, indices] : pending) {
+        if (indices != previous) {
+            previous_offset = static_cast<uint32_t>(layout.m_indices.size());
+            layout.m_indices.insert(layout.m_indices.end(), indices->begin(), indices->end());
+            previous = indices;
+        }
+        segment.index_offset = previous_offset;
+        segment.cell_start = cells;
+        segment.payload_offset = static_cast<uint32_t>(payload_floats);
+        cells += segment.num_cells;
+        payload_floats = alignUp(payload_floats + size_t(segment.num_cells) * segment.num_components,
+                                 SEGMENT_ALIGNMENT_FLOATS);
+        layout.m_segments.push_back(segment);
+    }
+
+    PeerMessageHeader& header = layout.m_header;
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.segment_size = static_cast<uint16_t>(sizeof(PeerSegment));
+    header.num_segments = static_cast<uint32_t>(layout.m_segments.size());
+    header.due_levels = due_levels;
+    header.total_cells = cells;
+    header.payload_offset = alignUp(sizeof(PeerMessageHeader) + layout.m_segments.size() * sizeof(PeerSegment),
+                                    ALIGNMENT);
+    header.total_bytes = header.payload_offset + payload_floats * sizeof(float);
+    return layout;
+}
+
+void PeerMessageLayout::writeHeader(uint8_t* message, uint32_t phase) const {
+    PeerMessageHeader header = m_header;
+    header.phase = phase;
+    std::memcpy(message, &header, sizeof(header));
+    if (!m_segments.empty()) {
+        std::memcpy(message + sizeof(header), m_segments.data(), m_segments.size() * sizeof(PeerSegment));
+    }
+    const size_t table_end = sizeof(header) + m_segments.size() * sizeof(PeerSegment);
+    std::memset(message + table_end, 0, m_header.payload_offset - table_end);
+}
+
+void PeerMessageLayout::validate(const uint8_t* message, size_t size, uint32_t phase) const {
+    auto fail = [this](const std::string& what) {
+        std::ostringstream oss;
+        oss << "Halo message from rank " << m_peer << ": " << what;
+        throw std::runtime_error(oss.str());
+    };
+
+    if (size < sizeof(PeerMessageHeader)) fail("truncated header");
+    PeerMessageHeader header;
+    std::memcpy(&header, message, sizeof(header));
+    if (header.magic != MAGIC) fail("bad magic");
+    if (header.version != VERSION || header.segment_size != sizeof(PeerSegment)) {
+        fail("format version " + std::to_string(header.version) + " not understood");
+    }
+    if (header.phase != phase) {
+        fail("phase " + std::to_string(header.phase) + ", expected " + std::to_string(phase));
+    }
+    if (header.due_levels != m_header.due_levels || header.num_segments != m_header.num_segments ||
+        header.total_cells != m_header.total_cells || header.payload_offset != m_header.payload_offset ||
+        header.total_bytes != m_header.total_bytes) {
+        fail(std::to_string(header.num_segments) + " segments / " + std::to_string(header.total_bytes) +
+             " bytes, expected " + std::to_string(m_header.num_segments) + " / " +
+             std::to_string(m_header.total_bytes));
+    }
+    if (size < header.total_bytes) fail("truncated payload");
+
+    for (size_t s = 0; s < m_segments.size(); ++s) {
+        const uint8_t* wire = message + sizeof(PeerMessageHeader) + s * sizeof(PeerSegment);
+        if (std::memcmp(wire, &m_segments[s], WIRE_BYTES) != 0) {
+            PeerSegment received;
+            std::memcpy(&received, wire, sizeof(received));
+            fail("segment " + std::to_string(s) + " (field " + std::to_string(received.field_id) + ", " +
+                 std::to_string(received.num_cells) + " cells) does not match the local ghost range (field " +
+                 std::to_string(m_segments[s].field_id) + ", " + std::to_string(m_segments[s].num_cells) + " cells)");
+        }
+    }
+}
+
+void PeerMessageLayout::packHost(const std::vector<HaloFieldBinding>& fields, uint8_t* message) const {
+    float* payload = reinterpret_cast<float*>(message + m_header.payload_offset);
+    for (const auto& segment : m_segments) {
+        const float* field = static_cast<const float*>(fields.at(segment.field_slot).data);
+        const uint32_t* gather = m_indices.data() + segment.index_offset;
+        for (uint32_t cell = 0; cell < segment.num_cells; ++cell) {
+            for (uint16_t c = 0; c < segment.num_components; ++c) {
+                const float* component = field + c * segment.field_stride;
+                float value;
+                if (segment.sources_per_cell == 1) {
+                    value = component[gather[cell]];
+                } else {
+                    value = 0.0f;
+                    for (uint32_t s = 0; s < segment.sources_per_cell; ++s) {
+                        value += segment.weights[s] * component[gather[cell * segment.sources_per_cell + s]];
+                    }
+                }
+                payload[segment.payload_offset + size_t(c) * segment.num_cells + cell] = value;
+            }
+        }
+    }
+}
+
+void PeerMessageLayout::unpackHost(const uint8_t* message, const std::vector<HaloFieldBinding>& fields) const {
+    const float* payload = reinterpret_cast<const float*>(message + m_header.payload_offset);
+    for (const auto& segment : m_segments) {
+        float* field = static_cast<float*>(fields.at(segment.field_slot).data);
+        const uint32_t* scatter = m_indices.data() + segment.index_offset;
+        for (uint32_t cell = 0; cell < segment.num_cells; ++cell) {
+            for (uint16_t c = 0; c < segment.num_components; ++c) {
+                field[c * segment.field_stride + scatter[cell]] =
+                    payload[segment.payload_offset + size_t(c) * segment.num_cells + cell];
+            }
+        }
+    }
+}
+
+} // namespace halo
+} // namespace fluidloom
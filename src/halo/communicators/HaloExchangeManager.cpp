@@ -1,14 +1,21 @@
+#include <algorithm>
+#include <stdexcept>
 #include <thread>
 #include "fluidloom/halo/communicators/HaloExchangeManager.h"
 #include "fluidloom/common/Logger.h"
 #include "fluidloom/core/registry/FieldRegistry.h"
+#include "fluidloom/transport/PayloadCodec.h"
+#include <cstring>
+#include <future>
+#include <numeric>
 
 namespace fluidloom {
 namespace halo {
 
 HaloExchangeManager::HaloExchangeManager(IBackend* backend, const registry::FieldRegistry& registry)
-    : backend(backend), field_registry(registry), using_buffer_a(true) {
-    (void)field_registry; // Suppress unused warning
+    : backend(backend), field_registry(registry), max_message_bytes(0), using_buffer_a(true),
+      exchange_phase(0), pending_due_levels(0), exchange_in_flight(false),
+      restricted_cells(0), restricted_levels(0) {
     
     // Initialize transport
     mpi_transport = std::make_unique<transport::MPITransport>(backend);
@@ -20,121 +27,418 @@ HaloExchangeManager::HaloExchangeManager(IBackend* backend, const registry::Fiel
     unpack_kernel = std::make_unique<HaloUnpackKernel>(backend);
     event_chain = std::make_unique<EventChain>();
     interpolator = std::make_unique<TrilinearInterpolator>(backend);
+    averager = std::make_unique<VolumeWeightedAverager>(backend);
 }
 
 void HaloExchangeManager::initialize(size_t buffer_capacity_mb) {
-    // Initialize GPU-aware buffers
-    size_t bytes = buffer_capacity_mb * 1024 * 1024;
-    gpu_pack_buffer_a = transport::createGPUAwareBuffer(backend, bytes);
-    gpu_pack_buffer_b = transport::createGPUAwareBuffer(backend, bytes);
+    // Per-peer message buffers are sized from their layouts, up to this capacity
+    requireIdle("initialize()");
+    max_message_bytes = buffer_capacity_mb * 1024 * 1024;
+    channels.clear();
     
     pack_kernel->initialize();
     unpack_kernel->initialize();
     interpolator->initializeLookupTable();
+    message_packer = std::make_unique<PeerMessagePacker>(backend);
     
-    FL_LOG(INFO) << "HaloExchangeManager initialized with " << buffer_capacity_mb << "MB GPU-aware buffers";
+    FL_LOG(INFO) << "HaloExchangeManager initialized with " << buffer_capacity_mb << "MB per-peer message capacity";
+}
+
+void HaloExchangeManager::requireIdle(const char* operation) const {
+    // Posted requests and the pending unpack use the current channels
+    if (exchange_in_flight) {
+        throw std::runtime_error(std::string("HaloExchangeManager: ") + operation +
+                                 " during an exchange; call waitCompletion() first");
+    }
 }
 
 void HaloExchangeManager::addGhostRange(const GhostRange& range) {
+    requireIdle("addGhostRange()");
     ghost_ranges.push_back(range);
+    channels.clear();
 }
 
-void HaloExchangeManager::exchangeAsync() {
-    stats.num_exchanges++;
-    auto start_time = std::chrono::high_resolution_clock::now();
+void HaloExchangeManager::addHaloField(const HaloFieldBinding& field) {
+    if (!field.data || field.num_components == 0 || (field.num_components > 1 && field.stride == 0)) {
+        throw std::invalid_argument("HaloExchangeManager: invalid binding for field " + std::to_string(field.field_id));
+    }
+    requireIdle("addHaloField()");
+    halo_fields.push_back(field);
+    channels.clear();
+}
+
+std::map<int, HaloExchangeManager::PeerChannel>& HaloExchangeManager::channelsFor(uint32_t due_levels) {
+    auto cached = channels.find(due_levels);
+    if (cached != channels.end()) {
+        return cached->second;
+    }
+    if (!message_packer) {
+        throw std::runtime_error("HaloExchangeManager: exchange before initialize()");
+    }
+    
+    // Every topology change clears the channels, so the staging follows it
+    if (channels.empty()) {
+        prepareRestriction();
+    }
+    
+    std::map<int, PeerChannel>& peers = channels[due_levels];
+    std::vector<int> ranks;
+    for (const auto& range : ghost_ranges) {
+        if (std::find(ranks.begin(), ranks.end(), range.target_gpu) == ranks.end()) {
+            ranks.push_back(range.target_gpu);
+        }
+    }
+    
+    for (int peer : ranks) {
+        auto send = PeerMessageLayout::build(peer, PeerMessageLayout::Direction::SEND, send_ranges, halo_fields,
+                                             due_levels, &restricted_fields);
+        auto recv = PeerMessageLayout::build(peer, PeerMessageLayout::Direction::RECEIVE, ghost_ranges, halo_fields,
+                                             due_levels, &restricted_fields);
+        if (send.empty() && recv.empty()) continue;
+        if (send.getMessageBytes() > max_message_bytes || recv.getMessageBytes() > max_message_bytes) {
+            throw std::runtime_error("HaloExchangeManager: halo message for rank " + std::to_string(peer) +
+                                     " exceeds the " + std::to_string(max_message_bytes) + "-byte capacity");
+        }
+        
+        PeerChannel& channel = peers[peer];
+        if (!send.empty()) {
+            channel.send_table = message_packer->upload(send);
+            channel.send_a = transport::createGPUAwareBuffer(backend, send.getMessageBytes());
+            channel.send_b = transport::createGPUAwareBuffer(backend, send.getMessageBytes());
+        }
+        if (!send.empty() && compression.enabled()) {
+            channel.send_frame = transport::createGPUAwareBuffer(
+                backend, transport::PayloadCodec::maxFrameBytes(send.getMessageBytes()));
+        }
+        if (!recv.empty()) {
+            channel.recv_table = message_packer->upload(recv);
+            channel.recv = transport::createGPUAwareBuffer(
+                backend, compression.enabled() ? transport::PayloadCodec::maxFrameBytes(recv.getMessageBytes())
+                                               : recv.getMessageBytes());
+        }
+        channel.send_layout = std::move(send);
+        channel.recv_layout = std::move(recv);
+    }
+    
+    FL_LOG(DEBUG) << "HaloExchangeManager: " << peers.size() << " peer messages for level mask 0x"
+                  << std::hex << due_levels << std::dec;
+    return peers;
+}
+
+void HaloExchangeManager::prepareRestriction() {
+    send_ranges = ghost_ranges;
+    restricted_cells = 0;
+    restricted_levels = 0;
+    
+    // Coarse index of each mask is a staging slot; fine indices are local cells
+    std::vector<GhostRange> averaged;
+    for (auto& range : send_ranges) {
+        if (range.local_level <= range.remote_level) continue;
+        const auto& children = range.cached.neighbor_cell_indices;
+        if (children.size() % 8 != 0) {
+            throw std::invalid_argument("HaloExchangeManager: range " + range.getRangeId() +
+                                        " does not list 8 fine children per coarse ghost");
+        }
+        range.cached.local_cell_indices.resize(children.size() / 8);
+        std::iota(range.cached.local_cell_indices.begin(), range.cached.local_cell_indices.end(),
+                  static_cast<uint32_t>(restricted_cells));
+        restricted_cells += range.cached.local_cell_indices.size();
+        if (range.local_level < 32) restricted_levels |= 1u << range.local_level;
+        
+        averaged.push_back(range);
+        averaged.back().interpolation_type = GhostRange::InterpolationType::VOLUME_WEIGHTED_AVERAGE;
+    }
+    averager->buildMasks(averaged);
+    
+    restricted_storage.clear();
+    restricted_fields.clear();
+    for (const auto& field : halo_fields) {
+        HaloFieldBinding staging = field;
+        staging.data = nullptr;
+        staging.stride = restricted_cells;
+        if (restricted_cells > 0) {
+            restricted_storage.push_back(backend->allocateBuffer(restricted_cells * field.num_components * sizeof(float)));
+            staging.data = restricted_storage.back()->getDevicePointer();
+        }
+        restricted_fields.push_back(staging);
+    }
     
-    // Choose which pack buffer to use
-    auto* pack_buffer = using_buffer_a ? gpu_pack_buffer_a.get() : gpu_pack_buffer_b.get();
-    
-    // 1. Launch Pack Kernels
-    // We need to iterate over fields. For now, assume we have a list or query registry.
-    // Since FieldRegistry is passed, we should iterate over registered fields.
-    // But for this implementation, we'll assume a "halo_fields" list or similar if available,
-    // or just use a placeholder loop if the registry doesn't expose iteration easily.
-    // Module 7 tests used manual field addition.
-    // Let's assume we pack all fields in the registry that are marked for halo exchange.
-    // For now, we'll just use a dummy field loop or assume the user added fields to a list.
-    // The plan code used `halo_fields`. I'll assume it's a member I missed or I should add it.
-    // I'll add `std::vector<std::string> halo_fields;` to the class in a separate step if needed.
-    // For now, I'll just comment the field iteration.
-    
-    // Mock field iteration
-    std::vector<std::string> fields = {"density", "velocity"}; 
-    
-    for (const auto& field_name : fields) {
-        (void)field_name; // Suppress unused warning
-        // Get field descriptor...
-        // pack_kernel->execute(...)
-        // We need to adapt pack_kernel to accept GPUAwareBuffer's device buffer.
-        // pack_buffer->device_buffer is a Buffer struct.
+    // Packing only reaches the staging bindings when some range uses them
+    pack_fields = halo_fields;
+    if (restricted_cells > 0) {
+        pack_fields.insert(pack_fields.end(), restricted_fields.begin(), restricted_fields.end());
+    }
+    stats.restricted_cells = restricted_cells;
+}
+
+void HaloExchangeManager::restrictFineToCoarse() {
+    const bool check = averager->isCheckStep(stats.num_exchanges);
+    if (check) {
+        conservation_reports.clear();
+        stats.conservation_checks++;
+    }
+    
+    // Fields are separate SOA arrays, so each is restricted with its own launch
+    for (size_t slot = 0; slot < halo_fields.size(); ++slot) {
+        const HaloFieldBinding& field = halo_fields[slot];
+        auto descriptor = field_registry.lookupById(fields::FieldHandle(field.field_id));
+        PackBufferLayout layout;
+        layout.addField(descriptor ? descriptor->name : "field " + std::to_string(field.field_id),
+                        field.num_components, sizeof(float));
+        
+        Buffer fine{field.data, field.stride * field.num_components * sizeof(float)};
+        Buffer coarse{restricted_fields[slot].data, restricted_cells * field.num_components * sizeof(float)};
+        averager->restrictFields(layout, fine, coarse);
         
-        for (const auto& range : ghost_ranges) {
-            (void)range; // Suppress unused warning
-             // pack_kernel->execute(..., pack_buffer->device_buffer, ...);
+        if (check) {
+            for (auto& report : averager->checkConservation(layout, coarse, fine)) {
+                if (!report.conserved) stats.conservation_violations++;
+                conservation_reports.push_back(std::move(report));
+            }
         }
     }
+}
+
+void HaloExchangeManager::exchangeAsync(uint32_t due_levels) {
+    stats.num_exchanges++;
+    auto start_time = std::chrono::high_resolution_clock::now();
     
-    // Record pack completion event
-    // cl_event pack_event = backend->getLastEvent(); // Assuming backend tracks it
-    // For now, we just wait for queue to finish packing before sending (simple synchronization)
-    // or use events if backend supports it.
-    backend->finish(); // Simple sync for now to ensure packing is done
+    auto& peers = channelsFor(due_levels);
+    ++exchange_phase;
+    pending_due_levels = due_levels;
+    exchange_in_flight = true;
+    
+    // 1. Average fine→coarse ghosts into their staging slots (same queue, so
+    //    ordered before the packs), then pack one message per peer
+    if (restricted_cells > 0 && (due_levels & restricted_levels)) {
+        restrictFineToCoarse();
+    }
+    for (auto& [peer, channel] : peers) {
+        if (channel.send_layout.empty()) continue;
+        auto* send_buffer = using_buffer_a ? channel.send_a.get() : channel.send_b.get();
+        stats.pack_launches += message_packer->pack(channel.send_layout, channel.send_table, pack_fields,
+                                                    *send_buffer->storage, exchange_phase);
+    }
+    
+    // Packing must be complete before the sends are posted
+    backend->finish();
     
     auto pack_end = std::chrono::high_resolution_clock::now();
     stats.pack_time_ms = std::chrono::duration<double, std::milli>(pack_end - start_time).count();
     
+    stats.codec_time_ms = 0.0;
+    if (compression.enabled()) {
+        compressMessages(peers);
+    }
+    
     // 2. Post MPI Operations (Send/Recv)
-    for (const auto& range : ghost_ranges) {
-        // Send to target_gpu
-        if (range.pack_size_bytes > 0) {
-            auto send_req = mpi_transport->send_async(
-                range.target_gpu,
-                pack_buffer,
-                range.pack_offset,
-                range.pack_size_bytes,
-                range.hilbert_start & 0xFFFFFFFF // Tag
-            );
-            active_requests.push_back(std::move(send_req));
+    postMpiOperations(peers);
+}
+
+void HaloExchangeManager::postMpiOperations(std::map<int, PeerChannel>& peers) {
+    const int tag = static_cast<int>(MPITag::GHOST_EXCHANGE);
+    post_time = std::chrono::high_resolution_clock::now();
+    for (auto& [peer, channel] : peers) {
+        auto* send_buffer = using_buffer_a ? channel.send_a.get() : channel.send_b.get();
+        const size_t send_bytes = channel.send_layout.getMessageBytes();
+        const size_t recv_bytes = channel.recv_layout.getMessageBytes();
+        size_t wire_bytes = send_bytes;
+        
+        if (peer == mpi_transport->getRank()) {
+            // Periodic or self-adjacent ranges: no transport needed
+            if (send_bytes > 0 && recv_bytes > 0) {
+                backend->copyDeviceToDevice(*send_buffer->storage, *channel.recv->storage,
+                                            std::min(send_bytes, recv_bytes));
+            }
+        } else {
+            if (channel.send_frame_bytes > 0) {
+                send_buffer = channel.send_frame.get();
+                wire_bytes = channel.send_frame_bytes;
+            }
+            if (send_bytes > 0) {
+                active_requests.push_back(mpi_transport->send_async(peer, send_buffer, 0, wire_bytes, tag));
+                request_sends.emplace_back(peer, wire_bytes);
+            }
+            if (recv_bytes > 0) {
+                // Frames and raw messages both fit; the message may be shorter than posted
+                active_requests.push_back(mpi_transport->recv_async(peer, channel.recv.get(), 0,
+                                                                    channel.recv->size_bytes, tag));
+                request_sends.emplace_back(peer, 0);
+            }
         }
         
-        // Receive from target_gpu (use other buffer for recv)
-        auto* recv_buffer = using_buffer_a ? gpu_pack_buffer_b.get() : gpu_pack_buffer_a.get();
-        auto recv_req = mpi_transport->recv_async(
-            range.target_gpu,
-            recv_buffer,
-            range.pack_offset,
-            range.pack_size_bytes,
-            range.hilbert_start & 0xFFFFFFFF // Tag
-        );
-        active_requests.push_back(std::move(recv_req));
+        if (send_bytes > 0) {
+            stats.messages_sent++;
+            stats.bytes_exchanged += send_bytes;
+            stats.wire_bytes += wire_bytes;
+        }
     }
 }
 
 void HaloExchangeManager::waitCompletion() {
+    auto comm_start = std::chrono::high_resolution_clock::now();
+    
     // Wait for all MPI requests
-    // We iterate and wait on wrappers
-    for (auto& req : active_requests) {
-        req->wait();
+    // We iterate and wait on wrappers; send completions feed the link estimates
+    for (size_t i = 0; i < active_requests.size(); ++i) {
+        active_requests[i]->wait();
+        const auto& [peer, bytes] = request_sends[i];
+        if (bytes > 0 && compression.enabled()) {
+            compression.recordTransfer(peer, bytes, std::chrono::duration<double>(
+                std::chrono::high_resolution_clock::now() - post_time).count());
+        }
     }
     active_requests.clear();
+    request_sends.clear();
+    
+    auto unpack_start = std::chrono::high_resolution_clock::now();
+    stats.comm_time_ms = std::chrono::duration<double, std::milli>(unpack_start - comm_start).count();
     
-    // Launch Unpack Kernels
-    auto* recv_buffer = using_buffer_a ? gpu_pack_buffer_b.get() : gpu_pack_buffer_a.get();
-    (void)recv_buffer; // Suppress unused warning
+    // One validated unpack launch per received message
+    auto pending = channels.find(pending_due_levels);
+    if (exchange_in_flight && pending != channels.end()) {
+        if (compression.enabled()) {
+            decompressMessages(pending->second);
+        }
+        for (auto& [peer, channel] : pending->second) {
+            (void)peer;
+            if (channel.recv_layout.empty()) continue;
+            stats.unpack_launches += message_packer->unpack(channel.recv_layout, channel.recv_table,
+                                                            *channel.recv->storage,
+                                                            channel.recv_layout.getMessageBytes(),
+                                                            halo_fields, exchange_phase);
+        }
+    }
     
-    // Iterate fields and unpack
-    // for (const auto& field : fields) ...
-    // unpack_kernel->execute(..., recv_buffer->device_buffer, ...);
+    exchange_in_flight = false;
     
     backend->finish();
+    stats.unpack_time_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::high_resolution_clock::now() - unpack_start).count();
 }
 
 void HaloExchangeManager::swapBuffers() {
     using_buffer_a = !using_buffer_a;
 }
 
-// Stub for postMpiOperations if needed by interface, but we inlined it
-void HaloExchangeManager::postMpiOperations() {}
+void HaloExchangeManager::setCompression(const transport::CompressionPolicy& policy) {
+    requireIdle("setCompression()");
+    compression = policy;
+    channels.clear();  // Receive buffers are sized for frames
+}
+
+void HaloExchangeManager::compressMessages(std::map<int, PeerChannel>& peers) {
+    auto start = std::chrono::high_resolution_clock::now();
+    const int rank = mpi_transport->getRank();
+    const bool delta = compression.getConfig().xor_delta;
+    
+    struct Encoded {
+        std::vector<uint8_t> frame;
+        double seconds;
+    };
+    std::vector<std::pair<int, std::future<Encoded>>> jobs;
+    std::vector<std::vector<uint8_t>> staged;
+    staged.reserve(peers.size());
+    
+    for (auto& [peer, channel] : peers) {
+        channel.send_frame_bytes = 0;
+        const size_t bytes = channel.send_layout.getMessageBytes();
+        if (peer == rank || bytes == 0 || !compression.shouldCompress(peer, bytes)) {
+            channel.send_reference.clear();
+            continue;
+        }
+        
+        auto* send_buffer = using_buffer_a ? channel.send_a.get() : channel.send_b.get();
+        staged.emplace_back(bytes);
+        std::vector<uint8_t>& raw = staged.back();
+        backend->copyDeviceToHost(*send_buffer->storage, raw.data(), bytes);
+        
+        // Delta only against the previous phase, which the receiver decoded too
+        const bool use_reference = delta && channel.send_reference.size() == bytes &&
+                                   channel.send_reference_tag + 1 == exchange_phase;
+        const uint8_t* reference = use_reference ? channel.send_reference.data() : nullptr;
+        const uint32_t reference_tag = channel.send_reference_tag;
+        jobs.emplace_back(peer, std::async(std::launch::async, [&raw, reference, reference_tag] {
+            auto t0 = std::chrono::high_resolution_clock::now();
+            auto frame = transport::PayloadCodec::encode(raw.data(), raw.size(), reference, reference_tag);
+            return Encoded{std::move(frame), std::chrono::duration<double>(
+                std::chrono::high_resolution_clock::now() - t0).count()};
+        }));
+    }
+    
+    for (size_t j = 0; j < jobs.size(); ++j) {
+        const int peer = jobs[j].first;
+        PeerChannel& channel = peers.at(peer);
+        Encoded encoded = jobs[j].second.get();
+        const size_t raw_bytes = staged[j].size();
+        compression.recordEncode(peer, raw_bytes, encoded.frame.size(), encoded.seconds);
+        
+        backend->copyHostToDevice(encoded.frame.data(), *channel.send_frame->storage, encoded.frame.size());
+        channel.send_frame_bytes = encoded.frame.size();
+        channel.send_reference = std::move(staged[j]);
+        channel.send_reference_tag = exchange_phase;
+        stats.compressed_messages++;
+    }
+    
+    stats.codec_time_ms += std::chrono::duration<double, std::milli>(
+        std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void HaloExchangeManager::decompressMessages(std::map<int, PeerChannel>& peers) {
+    auto start = std::chrono::high_resolution_clock::now();
+    const int rank = mpi_transport->getRank();
+    
+    struct Decoded {
+        std::vector<uint8_t> raw;
+        double seconds;
+    };
+    std::vector<std::pair<int, std::future<Decoded>>> jobs;
+    std::vector<std::vector<uint8_t>> frames;
+    frames.reserve(peers.size());
+    
+    for (auto& [peer, channel] : peers) {
+        if (peer == rank || channel.recv_layout.empty()) continue;
+        
+        transport::CodecFrameHeader header;
+        backend->copyDeviceToHost(*channel.recv->storage, &header, sizeof(header));
+        if (!transport::PayloadCodec::isFrame(reinterpret_cast<const uint8_t*>(&header), sizeof(header))) {
+            channel.recv_reference.clear();  // Sent raw
+            continue;
+        }
+        const size_t frame_bytes = sizeof(header) + static_cast<size_t>(header.encoded_bytes);
+        if (frame_bytes > channel.recv->size_bytes) {
+            throw std::runtime_error("Halo message from rank " + std::to_string(peer) + ": frame larger than posted");
+        }
+        frames.emplace_back(frame_bytes);
+        std::vector<uint8_t>& frame = frames.back();
+        backend->copyDeviceToHost(*channel.recv->storage, frame.data(), frame_bytes);
+        
+        const std::vector<uint8_t>& reference = channel.recv_reference;
+        const uint32_t reference_tag = channel.recv_reference_tag;
+        jobs.emplace_back(peer, std::async(std::launch::async, [&frame, &reference, reference_tag] {
+            auto t0 = std::chrono::high_resolution_clock::now();
+            auto raw = transport::PayloadCodec::decode(frame.data(), frame.size(), reference.data(),
+                                                       reference.size(), reference_tag);
+            return Decoded{std::move(raw), std::chrono::duration<double>(
+                std::chrono::high_resolution_clock::now() - t0).count()};
+        }));
+    }
+    
+    for (auto& [peer, job] : jobs) {
+        PeerChannel& channel = peers.at(peer);
+        Decoded decoded = job.get();
+        if (decoded.raw.size() > channel.recv->size_bytes) {
+            throw std::runtime_error("Halo message from rank " + std::to_string(peer) + ": decoded message too large");
+        }
+        compression.recordDecode(decoded.raw.size(), decoded.seconds);
+        backend->copyHostToDevice(decoded.raw.data(), *channel.recv->storage, decoded.raw.size());
+        channel.recv_reference = std::move(decoded.raw);
+        channel.recv_reference_tag = exchange_phase;
+    }
+    
+    stats.codec_time_ms += std::chrono::duration<double, std::milli>(
+        std::chrono::high_resolution_clock::now() - start).count();
+}
 
 } // namespace halo
 } // namespace fluidloom
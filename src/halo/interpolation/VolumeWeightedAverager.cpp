@@ -1,34 +1,310 @@
 #include "fluidloom/halo/interpolation/VolumeWeightedAverager.h"
 #include "fluidloom/common/Logger.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
 
 namespace fluidloom {
 namespace halo {
 
+namespace {
+
+// Masks reduced per work-item by conservation_totals
+constexpr uint32_t kChunkSize = 256;
+
+// Neumaier summation (compensated; robust when terms exceed the running sum)
+struct CompensatedSum {
+    double sum = 0.0;
+    double comp = 0.0;
+
+    void add(double value) {
+        double t = sum + value;
+        if (std::fabs(sum) >= std::fabs(value)) {
+            comp += (sum - t) + value;
+        } else {
+            comp += (value - t) + sum;
+        }
+        sum = t;
+    }
+
+    double result() const { return sum + comp; }
+};
+
+size_t planeStride(const PackBufferLayout& layout, const Buffer& buffer) {
+    return buffer.size_bytes / layout.cell_size_bytes;
+}
+
+// One-field layout for the single-field API
+PackBufferLayout singleFieldLayout(const fields::FieldDescriptor& field) {
+    if (field.type != fields::FieldType::FLOAT32) {
+        throw std::invalid_argument("VolumeWeightedAverager: field '" + field.name + "' is not FLOAT32");
+    }
+    PackBufferLayout layout;
+    layout.addField(field.name, field.num_components, sizeof(float));
+    return layout;
+}
+
+} // namespace
+
+VolumeWeightedAverager::VolumeWeightedAverager(IBackend* backend)
+    : backend(backend) {
+    if (!useHostPath()) {
+        compileKernels();
+    }
+}
+
+VolumeWeightedAverager::~VolumeWeightedAverager() {
+    if (backend) {
+        if (restrict_kernel.handle) backend->releaseKernel(restrict_kernel);
+        if (residual_kernel.handle) backend->releaseKernel(residual_kernel);
+    }
+}
+
+bool VolumeWeightedAverager::useHostPath() const {
+    // Mock buffers live in host memory
+    return !backend || backend->getType() == BackendType::MOCK;
+}
+
+void VolumeWeightedAverager::compileKernels() {
+    try {
+        restrict_kernel = backend->compileKernel("kernels/halo/volume_average.cl", "restrict_volume_average");
+        residual_kernel = backend->compileKernel("kernels/halo/volume_average.cl", "conservation_totals");
+    } catch (const std::exception& e) {
+        FL_LOG(ERROR) << "Failed to compile volume averaging kernels: " << e.what();
+        throw;
+    }
+}
+
+size_t VolumeWeightedAverager::planeCount(const PackBufferLayout& layout) {
+    if (layout.cell_size_bytes == 0) {
+        throw std::invalid_argument("VolumeWeightedAverager: empty pack layout");
+    }
+    for (const auto& field : layout.fields) {
+        if (field.bytes_per_component != sizeof(float)) {
+            throw std::invalid_argument("VolumeWeightedAverager: field '" + field.field_name +
+                                        "' is not float; only float fields can be averaged");
+        }
+    }
+    return layout.cell_size_bytes / sizeof(float);
+}
+
+void VolumeWeightedAverager::buildMasks(const std::vector<GhostRange>& ranges) {
+    masks.clear();
+
+    for (const auto& range : ranges) {
+        if (range.interpolation_type != GhostRange::InterpolationType::VOLUME_WEIGHTED_AVERAGE) {
+            continue;
+        }
+        const auto& coarse = range.cached.local_cell_indices;
+        const auto& fine = range.cached.neighbor_cell_indices;
+        if (fine.size() < coarse.size() * 8) {
+            throw std::invalid_argument("VolumeWeightedAverager: range " + range.getRangeId() +
+                                        " has fewer than 8 fine indices per coarse cell");
+        }
+
+        for (size_t i = 0; i < coarse.size(); ++i) {
+            AveragingMask mask;
+            mask.coarse_cell_idx = coarse[i];
+            mask.num_valid_fine_cells = 0;
+            for (size_t k = 0; k < 8; ++k) {
+                mask.fine_cell_indices[k] = fine[i * 8 + k];
+                if (fine[i * 8 + k] != UNUSED) {
+                    mask.num_valid_fine_cells++;
+                }
+            }
+            masks.push_back(mask);
+        }
+    }
+
+    coarse_idx_buffer.reset();
+    fine_idx_buffer.reset();
+    if (useHostPath() || masks.empty()) {
+        return;
+    }
+
+    std::vector<uint32_t> coarse_idx(masks.size());
+    std::vector<uint32_t> fine_idx(masks.size() * 8);
+    for (size_t m = 0; m < masks.size(); ++m) {
+        coarse_idx[m] = masks[m].coarse_cell_idx;
+        std::copy(masks[m].fine_cell_indices.begin(), masks[m].fine_cell_indices.end(), fine_idx.begin() + m * 8);
+    }
+    coarse_idx_buffer = backend->allocateBuffer(coarse_idx.size() * sizeof(uint32_t), coarse_idx.data());
+    fine_idx_buffer = backend->allocateBuffer(fine_idx.size() * sizeof(uint32_t), fine_idx.data());
+
+    FL_LOG(DEBUG) << "VolumeWeightedAverager: uploaded " << masks.size() << " averaging masks";
+}
+
+void VolumeWeightedAverager::restrictFields(
+    const PackBufferLayout& layout,
+    const Buffer& fine_data,
+    Buffer& coarse_data
+) {
+    const size_t num_planes = planeCount(layout);
+    if (masks.empty() || num_planes == 0) {
+        return;
+    }
+
+    const size_t fine_stride = planeStride(layout, fine_data);
+    const size_t coarse_stride = planeStride(layout, coarse_data);
+
+    if (useHostPath()) {
+        const float* fine = static_cast<const float*>(fine_data.device_ptr);
+        float* coarse = static_cast<float*>(coarse_data.device_ptr);
+        for (size_t plane = 0; plane < num_planes; ++plane) {
+            const float* fine_plane = fine + plane * fine_stride;
+            float* coarse_plane = coarse + plane * coarse_stride;
+            for (const auto& mask : masks) {
+                if (mask.num_valid_fine_cells == 0) continue;
+                float sum = 0.0f;
+                for (uint32_t f : mask.fine_cell_indices) {
+                    if (f != UNUSED) sum += fine_plane[f];
+                }
+                coarse_plane[mask.coarse_cell_idx] = sum / static_cast<float>(mask.num_valid_fine_cells);
+            }
+        }
+        return;
+    }
+
+    const uint32_t num_masks = static_cast<uint32_t>(masks.size());
+    const uint32_t planes = static_cast<uint32_t>(num_planes);
+    backend->launchKernel(restrict_kernel, static_cast<size_t>(num_masks) * planes, 0, {
+        IBackend::KernelArg::fromBuffer(fine_data.device_ptr),
+        IBackend::KernelArg::fromBuffer(coarse_data.device_ptr),
+        IBackend::KernelArg::fromBuffer(coarse_idx_buffer->getDevicePointer()),
+        IBackend::KernelArg::fromBuffer(fine_idx_buffer->getDevicePointer()),
+        IBackend::KernelArg::fromScalar(num_masks),
+        IBackend::KernelArg::fromScalar(planes),
+        IBackend::KernelArg::fromScalar(static_cast<uint64_t>(fine_stride)),
+        IBackend::KernelArg::fromScalar(static_cast<uint64_t>(coarse_stride))
+    });
+}
+
+std::vector<std::array<double, 2>> VolumeWeightedAverager::planeTotals(
+    const PackBufferLayout& layout,
+    const Buffer& coarse_data,
+    const Buffer& fine_data
+) {
+    const size_t num_planes = planeCount(layout);
+    const size_t fine_stride = planeStride(layout, fine_data);
+    const size_t coarse_stride = planeStride(layout, coarse_data);
+    std::vector<std::array<double, 2>> totals(num_planes, {0.0, 0.0});
+    if (masks.empty()) {
+        return totals;
+    }
+
+    if (useHostPath()) {
+        const float* fine = static_cast<const float*>(fine_data.device_ptr);
+        const float* coarse = static_cast<const float*>(coarse_data.device_ptr);
+        for (size_t plane = 0; plane < num_planes; ++plane) {
+            const float* fine_plane = fine + plane * fine_stride;
+            const float* coarse_plane = coarse + plane * coarse_stride;
+            CompensatedSum fine_sum, coarse_sum;
+            for (const auto& mask : masks) {
+                for (uint32_t f : mask.fine_cell_indices) {
+                    if (f != UNUSED) fine_sum.add(fine_plane[f]);
+                }
+                coarse_sum.add(static_cast<double>(coarse_plane[mask.coarse_cell_idx]) * mask.num_valid_fine_cells);
+            }
+            totals[plane] = {fine_sum.result(), coarse_sum.result()};
+        }
+        return totals;
+    }
+
+    // One partial per (plane, chunk of masks); only these are read back
+    const uint32_t num_masks = static_cast<uint32_t>(masks.size());
+    const uint32_t num_chunks = (num_masks + kChunkSize - 1) / kChunkSize;
+    const size_t num_partials = static_cast<size_t>(num_chunks) * num_planes;
+    if (num_partials > partials_capacity) {
+        partials_buffer = backend->allocateBuffer(num_partials * 4 * sizeof(float));
+        partials_capacity = num_partials;
+    }
+
+    const uint32_t planes = static_cast<uint32_t>(num_planes);
+    backend->launchKernel(residual_kernel, num_partials, 0, {
+        IBackend::KernelArg::fromBuffer(fine_data.device_ptr),
+        IBackend::KernelArg::fromBuffer(coarse_data.device_ptr),
+        IBackend::KernelArg::fromBuffer(coarse_idx_buffer->getDevicePointer()),
+        IBackend::KernelArg::fromBuffer(fine_idx_buffer->getDevicePointer()),
+        IBackend::KernelArg::fromScalar(num_masks),
+        IBackend::KernelArg::fromScalar(planes),
+        IBackend::KernelArg::fromScalar(static_cast<uint64_t>(fine_stride)),
+        IBackend::KernelArg::fromScalar(static_cast<uint64_t>(coarse_stride)),
+        IBackend::KernelArg::fromScalar(kChunkSize),
+        IBackend::KernelArg::fromBuffer(partials_buffer->getDevicePointer())
+    });
+
+    std::vector<float> partials(num_partials * 4);
+    backend->copyDeviceToHost(*partials_buffer, partials.data(), partials.size() * sizeof(float));
+
+    for (size_t plane = 0; plane < num_planes; ++plane) {
+        CompensatedSum fine_sum, coarse_sum;
+        for (size_t c = 0; c < num_chunks; ++c) {
+            const float* p = &partials[(plane * num_chunks + c) * 4];
+            fine_sum.add(p[0]);
+            fine_sum.add(p[1]);
+            coarse_sum.add(p[2]);
+            coarse_sum.add(p[3]);
+        }
+        totals[plane] = {fine_sum.result(), coarse_sum.result()};
+    }
+    return totals;
+}
+
+std::vector<VolumeWeightedAverager::ConservationReport> VolumeWeightedAverager::checkConservation(
+    const PackBufferLayout& layout,
+    const Buffer& coarse_data,
+    const Buffer& fine_data,
+    double tolerance
+) {
+    auto totals = planeTotals(layout, coarse_data, fine_data);
+
+    std::vector<ConservationReport> reports;
+    reports.reserve(layout.fields.size());
+    for (const auto& field : layout.fields) {
+        ConservationReport report;
+        report.field_name = field.field_name;
+
+        const size_t first_plane = field.offset_in_cell / sizeof(float);
+        for (size_t c = 0; c < field.num_components; ++c) {
+            const auto& plane = totals[first_plane + c];
+            const double scale = std::max({std::fabs(plane[0]), std::fabs(plane[1]),
+                                           std::numeric_limits<double>::min()});
+            const double error = std::fabs(plane[0] - plane[1]) / scale;
+            if (c == 0 || error > report.relative_error) {
+                report.fine_total = plane[0];
+                report.coarse_total = plane[1];
+                report.relative_error = error;
+            }
+        }
+        report.conserved = report.relative_error <= tolerance;
+
+        if (!report.conserved) {
+            FL_LOG(WARN) << "Restriction of '" << report.field_name << "' is not conservative: fine total "
+                         << report.fine_total << ", coarse total " << report.coarse_total
+                         << " (relative error " << report.relative_error << ")";
+        }
+        reports.push_back(std::move(report));
+    }
+    return reports;
+}
+
 bool VolumeWeightedAverager::validateConservation(
     const fields::FieldDescriptor& field,
     const Buffer& coarse_data,
     const Buffer& fine_data,
     float tolerance
-) const {
-    (void)field;
-    (void)coarse_data;
-    (void)fine_data;
-    (void)tolerance;
-    // TODO: Implement conservation check
-    // Sum fine cells, compare with coarse cell value * 8
-    return true;
+) {
+    auto reports = checkConservation(singleFieldLayout(field), coarse_data, fine_data, tolerance);
+    return reports.front().conserved;
 }
 
 void VolumeWeightedAverager::applyAveraging(
     const fields::FieldDescriptor& field,
     const Buffer& source_data,
     Buffer& dest_data
-) const {
-    (void)field;
-    (void)source_data;
-    (void)dest_data;
-    // Host-side implementation for validation/fallback
-    FL_LOG(DEBUG) << "Applying volume-weighted averaging on host";
+) {
+    restrictFields(singleFieldLayout(field), source_data, dest_data);
 }
 
 } // namespace halo
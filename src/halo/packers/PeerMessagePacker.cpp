@@ -0,0 +1,149 @@
+#include "fluidloom/halo/packers/PeerMessagePacker.h"
+#include "fluidloom/common/Logger.h"
+#include <limits>
+#include <stdexcept>
+
+namespace fluidloom {
+namespace halo {
+
+namespace {
+
+constexpr const char* KERNEL_SOURCE = "kernels/halo/peer_message.cl";
+
+} // namespace
+
+PeerMessagePacker::PeerMessagePacker(IBackend* backend)
+    : m_backend(backend) {
+    if (useHostPath()) {
+        return;
+    }
+    try {
+        m_pack_kernel = m_backend->compileKernel(KERNEL_SOURCE, "pack_peer_message");
+        m_unpack_kernel = m_backend->compileKernel(KERNEL_SOURCE, "unpack_peer_message");
+    } catch (const std::exception& e) {
+        FL_LOG(ERROR) << "Failed to compile peer message kernels: " << e.what();
+        throw;
+    }
+}
+
+PeerMessagePacker::~PeerMessagePacker() {
+    if (!m_backend) {
+        return;
+    }
+    if (m_pack_kernel.handle) m_backend->releaseKernel(m_pack_kernel);
+    if (m_unpack_kernel.handle) m_backend->releaseKernel(m_unpack_kernel);
+}
+
+bool PeerMessagePacker::useHostPath() const {
+    // Mock buffers live in host memory
+    return !m_backend || m_backend->getType() == BackendType::MOCK;
+}
+
+PeerMessagePacker::DeviceTable PeerMessagePacker::upload(const PeerMessageLayout& layout) const {
+    DeviceTable table;
+    if (useHostPath() || layout.empty()) {
+        return table;
+    }
+    const auto& segments = layout.getSegments();
+    const auto& indices = layout.getIndices();
+    table.segments = m_backend->allocateBuffer(segments.size() * sizeof(PeerSegment), segments.data());
+    table.indices = m_backend->allocateBuffer(indices.size() * sizeof(uint32_t), indices.data());
+    return table;
+}
+
+size_t PeerMessagePacker::pack(const PeerMessageLayout& layout,
+                               const DeviceTable& table,
+                               const std::vector<HaloFieldBinding>& fields,
+                               DeviceBuffer& message,
+                               uint32_t phase) {
+    if (layout.empty()) {
+        return 0;
+    }
+    if (message.getSize() < layout.getMessageBytes()) {
+        throw std::invalid_argument("PeerMessagePacker: message buffer of " + std::to_string(message.getSize()) +
+                                    " bytes cannot hold " + std::to_string(layout.getMessageBytes()));
+    }
+
+    if (useHostPath()) {
+        uint8_t* bytes = static_cast<uint8_t*>(message.getDevicePointer());
+        layout.writeHeader(bytes, phase);
+        layout.packHost(fields, bytes);
+        return 0;
+    }
+
+    std::vector<uint8_t> header(layout.getPayloadOffset());
+    layout.writeHeader(header.data(), phase);
+    m_backend->copyHostToDeviceOffset(header.data(), message, 0, header.size());
+    return launch(m_pack_kernel, layout, table, message.getDevicePointer(), fields);
+}
+
+size_t PeerMessagePacker::unpack(const PeerMessageLayout& layout,
+                                 const DeviceTable& table,
+                                 const DeviceBuffer& message,
+                                 size_t received_bytes,
+                                 const std::vector<HaloFieldBinding>& fields,
+                                 uint32_t phase) {
+    if (layout.empty()) {
+        return 0;
+    }
+
+    if (useHostPath()) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(message.getDevicePointer());
+        layout.validate(bytes, received_bytes, phase);
+        layout.unpackHost(bytes, fields);
+        return 0;
+    }
+
+    // Only the header and table cross back to the host
+    std::vector<uint8_t> header(layout.getPayloadOffset());
+    m_backend->copyDeviceToHost(message, header.data(), header.size());
+    layout.validate(header.data(), received_bytes, phase);
+    return launch(m_unpack_kernel, layout, table, message.getDevicePointer(), fields);
+}
+
+size_t PeerMessagePacker::launch(const IBackend::KernelHandle& kernel,
+                                 const PeerMessageLayout& layout,
+                                 const DeviceTable& table,
+                                 const void* message,
+                                 const std::vector<HaloFieldBinding>& fields) {
+    if (!table.segments || !table.indices) {
+        throw std::invalid_argument("PeerMessagePacker: layout for rank " + std::to_string(layout.getPeer()) +
+                                    " was not uploaded");
+    }
+    if (layout.getMessageBytes() / sizeof(float) > std::numeric_limits<uint32_t>::max()) {
+        throw std::invalid_argument("PeerMessagePacker: message too large for one launch");
+    }
+
+    const uint32_t total_cells = layout.getTotalCells();
+    const size_t global = (total_cells + WORK_GROUP_SIZE - 1) / WORK_GROUP_SIZE * WORK_GROUP_SIZE;
+    size_t launches = 0;
+    for (size_t first = 0; first < fields.size(); first += MAX_FIELDS) {
+        // Unused field slots alias the first field of the batch; the kernel never reads them
+        auto field = [&](size_t i) {
+            const size_t slot = first + i;
+            return fields[slot < fields.size() ? slot : first].data;
+        };
+        m_backend->launchKernel(kernel, global, WORK_GROUP_SIZE, {
+            IBackend::KernelArg::fromBuffer(table.segments->getDevicePointer()),
+            IBackend::KernelArg::fromScalar(static_cast<uint32_t>(layout.getSegments().size())),
+            IBackend::KernelArg::fromBuffer(table.indices->getDevicePointer()),
+            IBackend::KernelArg::fromBuffer(message),
+            IBackend::KernelArg::fromScalar(static_cast<uint32_t>(layout.getPayloadOffset() / sizeof(float))),
+            IBackend::KernelArg::fromScalar(total_cells),
+            IBackend::KernelArg::fromScalar(static_cast<uint32_t>(first)),
+            IBackend::KernelArg::fromBuffer(field(0)),
+            IBackend::KernelArg::fromBuffer(field(1)),
+            IBackend::KernelArg::fromBuffer(field(2)),
+            IBackend::KernelArg::fromBuffer(field(3)),
+            IBackend::KernelArg::fromBuffer(field(4)),
+            IBackend::KernelArg::fromBuffer(field(5)),
+            IBackend::KernelArg::fromBuffer(field(6)),
+            IBackend::KernelArg::fromBuffer(field(7))
+        });
+        ++launches;
+    }
+    return launches;
+}
+
+} // namespace halo
+} // namespace fluidloom
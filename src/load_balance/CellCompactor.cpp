@@ -0,0 +1,164 @@
+#include "fluidloom/load_balance/CellCompactor.h"
+#include "fluidloom/common/FluidLoomError.h"
+#include "fluidloom/common/Logger.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace fluidloom {
+namespace load_balance {
+
+namespace {
+
+constexpr const char* KERNEL_SOURCE = "kernels/load_balance/compact_cells.cl";
+
+} // namespace
+
+CellCompactor::CellCompactor(cl_context context, cl_command_queue queue)
+    : m_context(context), m_queue(queue), m_program(nullptr), m_kernel_move(nullptr), m_kernel_gather(nullptr) {
+    compileKernels();
+}
+
+CellCompactor::~CellCompactor() {
+    if (m_kernel_move) clReleaseKernel(m_kernel_move);
+    if (m_kernel_gather) clReleaseKernel(m_kernel_gather);
+    if (m_program) clReleaseProgram(m_program);
+}
+
+std::string CellCompactor::loadKernelSource(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open kernel source: " + filename);
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+void CellCompactor::compileKernels() {
+    std::string src = loadKernelSource(KERNEL_SOURCE);
+    const char* src_str = src.c_str();
+    size_t src_len = src.length();
+    cl_int err;
+    
+    m_program = clCreateProgramWithSource(m_context, 1, &src_str, &src_len, &err);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to create cell compaction program");
+    
+    err = clBuildProgram(m_program, 0, nullptr, "-cl-std=CL1.2", nullptr, nullptr);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to build cell compaction kernel");
+    
+    m_kernel_move = clCreateKernel(m_program, "move_cells", &err);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to create move_cells kernel");
+    
+    m_kernel_gather = clCreateKernel(m_program, "gather_cells", &err);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to create gather_cells kernel");
+}
+
+CompactionMoves CellCompactor::plan(const std::vector<uint32_t>& removed, size_t num_cells) {
+    std::vector<uint32_t> holes(removed);
+    std::sort(holes.begin(), holes.end());
+    holes.erase(std::unique(holes.begin(), holes.end()), holes.end());
+    if (!holes.empty() && holes.back() >= num_cells) {
+        throw std::out_of_range("Removed slot " + std::to_string(holes.back()) +
+                                " is outside " + std::to_string(num_cells) + " cells");
+    }
+    
+    CompactionMoves moves;
+    moves.new_count = num_cells - holes.size();
+    
+    // Holes below new_count are filled with survivors from [new_count, num_cells),
+    // taken from the back; both sets have the same size
+    auto hole_it = holes.begin();
+    auto tail_hole = holes.rbegin();
+    size_t src = num_cells;
+    while (hole_it != holes.end() && *hole_it < moves.new_count) {
+        --src;
+        while (tail_hole != holes.rend() && *tail_hole == src) {
+            ++tail_hole;
+            --src;
+        }
+        moves.src.push_back(static_cast<uint32_t>(src));
+        moves.dst.push_back(*hole_it++);
+    }
+    return moves;
+}
+
+void CellCompactor::apply(const CompactionMoves& moves, const std::vector<std::pair<cl_mem, size_t>>& arrays) {
+    if (moves.empty()) return;
+    
+    cl_int err;
+    const size_t index_bytes = moves.src.size() * sizeof(uint32_t);
+    cl_mem d_src = clCreateBuffer(m_context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, index_bytes,
+                                  const_cast<uint32_t*>(moves.src.data()), &err);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to upload compaction sources");
+    cl_mem d_dst = clCreateBuffer(m_context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, index_bytes,
+                                  const_cast<uint32_t*>(moves.dst.data()), &err);
+    if (err != CL_SUCCESS) {
+        clReleaseMemObject(d_src);
+        FL_THROW_OPENCL(err, "Failed to upload compaction destinations");
+    }
+    
+    const cl_uint num_moves = static_cast<cl_uint>(moves.src.size());
+    size_t local_size = 64;
+    size_t global_size = ((num_moves + local_size - 1) / local_size) * local_size;
+    
+    clSetKernelArg(m_kernel_move, 0, sizeof(cl_mem), &d_src);
+    clSetKernelArg(m_kernel_move, 1, sizeof(cl_mem), &d_dst);
+    clSetKernelArg(m_kernel_move, 4, sizeof(cl_uint), &num_moves);
+    for (const auto& array : arrays) {
+        if (!array.first || array.second == 0) continue;
+        const cl_uint elem_bytes = static_cast<cl_uint>(array.second);
+        clSetKernelArg(m_kernel_move, 2, sizeof(cl_mem), &array.first);
+        clSetKernelArg(m_kernel_move, 3, sizeof(cl_uint), &elem_bytes);
+        err = clEnqueueNDRangeKernel(m_queue, m_kernel_move, 1, nullptr, &global_size, &local_size,
+                                     0, nullptr, nullptr);
+        if (err != CL_SUCCESS) break;
+    }
+    
+    // Released once the enqueued moves complete
+    clReleaseMemObject(d_src);
+    clReleaseMemObject(d_dst);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to enqueue move_cells");
+    
+    FL_LOG(DEBUG) << "Compacted " << arrays.size() << " arrays with " << num_moves << " moves";
+}
+
+size_t CellCompactor::gather(const std::vector<uint32_t>& indices,
+                             const std::vector<std::pair<cl_mem, size_t>>& arrays, cl_mem packed) {
+    if (indices.empty()) return 0;
+    
+    cl_int err;
+    cl_mem d_indices = clCreateBuffer(m_context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                      indices.size() * sizeof(uint32_t),
+                                      const_cast<uint32_t*>(indices.data()), &err);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to upload gather indices");
+    
+    const cl_uint num_cells = static_cast<cl_uint>(indices.size());
+    size_t local_size = 64;
+    size_t global_size = ((num_cells + local_size - 1) / local_size) * local_size;
+    
+    clSetKernelArg(m_kernel_gather, 0, sizeof(cl_mem), &d_indices);
+    clSetKernelArg(m_kernel_gather, 2, sizeof(cl_mem), &packed);
+    clSetKernelArg(m_kernel_gather, 5, sizeof(cl_uint), &num_cells);
+    cl_ulong offset = 0;
+    for (const auto& array : arrays) {
+        if (!array.first || array.second == 0) continue;
+        const cl_uint elem_bytes = static_cast<cl_uint>(array.second);
+        clSetKernelArg(m_kernel_gather, 1, sizeof(cl_mem), &array.first);
+        clSetKernelArg(m_kernel_gather, 3, sizeof(cl_uint), &elem_bytes);
+        clSetKernelArg(m_kernel_gather, 4, sizeof(cl_ulong), &offset);
+        err = clEnqueueNDRangeKernel(m_queue, m_kernel_gather, 1, nullptr, &global_size, &local_size,
+                                     0, nullptr, nullptr);
+        if (err != CL_SUCCESS) break;
+        offset += static_cast<cl_ulong>(num_cells) * elem_bytes;
+    }
+    
+    clReleaseMemObject(d_indices);
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to enqueue gather_cells");
+    
+    return static_cast<size_t>(offset);
+}
+
+} // namespace load_balance
+} // namespace fluidloom
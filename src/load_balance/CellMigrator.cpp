@@ -1,26 +1,43 @@
 #include "fluidloom/load_balance/CellMigrator.h"
+#include "fluidloom/common/FluidLoomError.h"
 #include "fluidloom/common/Logger.h"
+#include "fluidloom/core/hilbert/HilbertCodec.h"
 #include <algorithm>
 #include <cstring>
+#include <stdexcept>
 
 namespace fluidloom {
 namespace load_balance {
 
-CellMigrator::CellMigrator(transport::MPITransport* transport, cl_context context, cl_command_queue queue)
-    : m_transport(transport), m_context(context), m_queue(queue) {
+namespace {
+
+// Keeps migration messages apart from halo traffic (MPITag::GHOST_EXCHANGE etc.)
+constexpr int MIGRATION_TAG = 200;
+
+} // namespace
+
+CellMigrator::CellMigrator(transport::MPITransport* transport, OpenCLBackend* backend)
+    : m_transport(transport), m_backend(backend), m_context(nullptr), m_queue(nullptr) {
     
     if (!transport) {
         throw std::invalid_argument("MPITransport cannot be null");
     }
-    if (!context || !queue) {
-        throw std::invalid_argument("OpenCL context and queue cannot be null");
+    if (!backend || !backend->getContext() || !backend->getQueue()) {
+        throw std::invalid_argument("CellMigrator needs an initialized OpenCL backend");
     }
+    m_context = backend->getContext();
+    m_queue = backend->getQueue();
     
     FL_LOG(INFO) << "CellMigrator initialized";
 }
 
-CellMigrator::~CellMigrator() {
-    // GPUAwareBuffer handles cleanup automatically
+CellMigrator::~CellMigrator() = default;
+
+CellCompactor& CellMigrator::compactor() {
+    if (!m_compactor) {
+        m_compactor = std::make_unique<CellCompactor>(m_context, m_queue);
+    }
+    return *m_compactor;
 }
 
 void CellMigrator::migrate(
@@ -35,138 +52,194 @@ void CellMigrator::migrate(
         return;
     }
     
-    if (plan.transfers.empty()) {
-        FL_LOG(INFO) << "No transfers in migration plan, skipping";
-        return;
-    }
+    m_last_delta.clear();
     
-    FL_LOG(INFO) << "Executing migration plan: " << plan.transfers.size() << " transfers, "
-                 << plan.total_cells_to_migrate << " cells";
+    const int my_rank = m_transport->getRank();
     
-    int my_rank = m_transport->getRank();
-    std::vector<uint32_t> cells_to_remove;
-    size_t cells_to_receive = 0;
+    // Message planes; optional arrays left unbound are skipped on every rank.
+    // 4-byte planes come first so the gather kernel can copy words.
+    std::vector<MeshArray> arrays = {
+        {coord_x, sizeof(int32_t)}, {coord_y, sizeof(int32_t)}, {coord_z, sizeof(int32_t)},
+        {fields, num_field_components * sizeof(float)},
+        {levels, sizeof(uint8_t)}, {cell_states, sizeof(uint8_t)}
+    };
+    arrays.erase(std::remove_if(arrays.begin(), arrays.end(), [](const MeshArray& array) {
+        return !array.buffer || !*array.buffer || array.elem_bytes == 0;
+    }), arrays.end());
     
-    // Phase 1: Initiate all sends and receives
-    std::vector<std::unique_ptr<transport::MPIRequestWrapper>> requests;
+    size_t cell_bytes = 0;
+    for (const auto& array : arrays) cell_bytes += array.elem_bytes;
     
+    // Phase 1: select outgoing cells by key, one message per destination.
+    // Planned counts are estimates; what is sent is what the keys select.
+    std::map<int, std::vector<uint32_t>> outgoing;
     for (const auto& transfer : plan.transfers) {
-        if (transfer.source_rank == my_rank) {
-            // We are sending cells
-            FL_LOG(INFO) << "Sending " << transfer.num_cells << " cells to GPU " << transfer.dest_rank;
-            
-            // Pack cells into send buffer
-            size_t packed_cells = packCells(
-                transfer, *coord_x, *coord_y, *coord_z, *levels,
-                fields ? *fields : nullptr, num_field_components
-            );
-            
-            if (packed_cells != transfer.num_cells) {
-                FL_LOG(WARN) << "Packed " << packed_cells << " cells, expected " << transfer.num_cells;
-            }
-            
-            // Send via MPI (non-blocking)
-            size_t buffer_size = packed_cells * (sizeof(int) * 3 + sizeof(uint8_t) + 
-                                                 num_field_components * sizeof(float));
-            auto req = m_transport->send_async(
-                transfer.dest_rank, m_send_buffer.get(), 0, buffer_size, 0
-            );
-            requests.push_back(std::move(req));
-            
-            // Mark cells for removal after send completes
-            // (In real implementation, would track exact indices)
-            cells_to_remove.push_back(static_cast<uint32_t>(packed_cells));
+        if (transfer.source_rank != my_rank) continue;
+        
+        // Outgoing ranges can sit anywhere in the SOA (e.g. the head when
+        // sending to the previous rank), so they are located by key
+        if (!m_cell_keys) {
+            throw std::runtime_error("CellMigrator: sending cells needs the cell key mirror (setCellKeys)");
         }
         
-        if (transfer.dest_rank == my_rank) {
-            // We are receiving cells
-            FL_LOG(INFO) << "Receiving " << transfer.num_cells << " cells from GPU " << transfer.source_rank;
-            
-            cells_to_receive += transfer.num_cells;
-            
-            // Receive via MPI (non-blocking)
-            size_t buffer_size = transfer.num_cells * (sizeof(int) * 3 + sizeof(uint8_t) + 
-                                                       num_field_components * sizeof(float));
-            auto req = m_transport->recv_async(
-                transfer.source_rank, m_recv_buffer.get(), 0, buffer_size, 0
-            );
-            requests.push_back(std::move(req));
+        std::vector<uint32_t> selected = selectOutgoing(transfer);
+        if (selected.size() != transfer.num_cells) {
+            FL_LOG(DEBUG) << "Transfer to GPU " << transfer.dest_rank << " planned " << transfer.num_cells
+                          << " cells, selected " << selected.size();
         }
+        auto& indices = outgoing[transfer.dest_rank];
+        indices.insert(indices.end(), selected.begin(), selected.end());
     }
     
-    // Phase 2: Wait for all transfers to complete
-    FL_LOG(INFO) << "Waiting for " << requests.size() << " MPI operations to complete";
-    m_transport->wait_all();
+    std::vector<uint64_t> counts = exchangeCounts(outgoing);
     
-    // Phase 3: Unpack received cells
-    if (cells_to_receive > 0) {
-        FL_LOG(INFO) << "Unpacking " << cells_to_receive << " received cells";
+    // Buffers outlive the requests bound to them
+    std::vector<std::unique_ptr<transport::GPUAwareBuffer>> send_buffers;
+    std::vector<std::pair<size_t, std::unique_ptr<transport::GPUAwareBuffer>>> recv_buffers;
+    std::vector<std::unique_ptr<transport::MPIRequestWrapper>> requests;
+    
+    // Phase 2: pack every message, then post all sends and receives
+    std::vector<uint32_t> cells_to_remove;
+    std::vector<size_t> message_bytes;
+    for (const auto& [dest, indices] : outgoing) {
+        if (indices.empty()) continue;
+        send_buffers.push_back(transport::createGPUAwareBuffer(m_backend, indices.size() * cell_bytes));
+        message_bytes.push_back(packCells(indices, arrays, *send_buffers.back()));
         
-        // Ensure capacity for new cells
-        size_t required_capacity = *num_cells + cells_to_receive;
-        if (required_capacity > *capacity) {
-            ensureCapacity(required_capacity, coord_x, coord_y, coord_z, levels, cell_states,
-                          fields, num_field_components, capacity);
+        for (uint32_t idx : indices) {
+            m_last_delta.removed_keys.push_back((*m_cell_keys)[idx]);
         }
+        cells_to_remove.insert(cells_to_remove.end(), indices.begin(), indices.end());
+    }
+    
+    // Packing must be complete before the sends are posted
+    clFinish(m_queue);
+    
+    size_t message = 0;
+    for (const auto& [dest, indices] : outgoing) {
+        if (indices.empty()) continue;
+        FL_LOG(INFO) << "Sending " << indices.size() << " cells to GPU " << dest;
+        requests.push_back(m_transport->send_async(dest, send_buffers[message].get(), 0,
+                                                   message_bytes[message], MIGRATION_TAG));
+        ++message;
+    }
+    
+    const int size = m_transport->getSize();
+    size_t cells_to_receive = 0;
+    for (int source = 0; source < size && !counts.empty(); ++source) {
+        size_t incoming = counts[static_cast<size_t>(source) * size + my_rank];
+        if (source == my_rank || incoming == 0) continue;
         
-        unpackCells(cells_to_receive, coord_x, coord_y, coord_z, levels, fields,
-                   num_field_components, num_cells);
+        FL_LOG(INFO) << "Receiving " << incoming << " cells from GPU " << source;
+        recv_buffers.emplace_back(incoming, transport::createGPUAwareBuffer(m_backend, incoming * cell_bytes));
+        requests.push_back(m_transport->recv_async(source, recv_buffers.back().second.get(), 0,
+                                                   incoming * cell_bytes, MIGRATION_TAG));
+        cells_to_receive += incoming;
     }
     
-    // Phase 4: Remove migrated cells
+    // Phase 3: close the holes of sent cells while messages are in flight;
+    // the packed copies no longer depend on the SOA arrays
     if (!cells_to_remove.empty()) {
         FL_LOG(INFO) << "Compacting after removing " << cells_to_remove.size() << " migrated cells";
-        compactAfterMigration(cells_to_remove, coord_x, coord_y, coord_z, levels, fields,
-                             num_field_components, num_cells);
+        compactAfterMigration(cells_to_remove, arrays, num_cells);
+    }
+    
+    FL_LOG(INFO) << "Waiting for " << requests.size() << " MPI operations to complete";
+    for (auto& request : requests) {
+        request->wait();
+    }
+    requests.clear();
+    
+    // Phase 4: append received cells behind the survivors
+    if (cells_to_receive > 0) {
+        ensureCapacity(*num_cells + cells_to_receive, arrays, *num_cells, capacity);
+        for (const auto& [incoming, buffer] : recv_buffers) {
+            unpackCells(*buffer, incoming, arrays, *coord_x, *coord_y, *coord_z, *levels, num_cells);
+        }
     }
     
     FL_LOG(INFO) << "Migration complete: final cell count = " << *num_cells;
 }
 
-size_t CellMigrator::packCells(
-    const MigrationPlan::Transfer& transfer,
-    cl_mem coord_x, cl_mem coord_y, cl_mem coord_z,
-    cl_mem levels, cl_mem fields,
-    uint32_t num_field_components
-) {
-    // Simplified packing: read cells from GPU and pack into send buffer
-    // Real implementation would use pack kernels from Module 7
+std::vector<uint64_t> CellMigrator::exchangeCounts(const std::map<int, std::vector<uint32_t>>& outgoing) const {
+    const int size = m_transport->getSize();
+    if (size <= 1) return {};
     
-    size_t num_cells = transfer.num_cells;
-    size_t bytes_per_cell = sizeof(int) * 3 + sizeof(uint8_t) + 
-                           num_field_components * sizeof(float);
-    size_t total_bytes = num_cells * bytes_per_cell;
-    
-    // Allocate send buffer if needed
-    if (!m_send_buffer || m_send_buffer->getSize() < total_bytes) {
-        m_send_buffer = std::make_unique<transport::GPUAwareBuffer>(
-            m_context, m_queue, total_bytes
-        );
+    std::vector<uint64_t> row(size, 0);
+    for (const auto& [dest, indices] : outgoing) {
+        if (dest < 0 || dest >= size) {
+            throw std::out_of_range("CellMigrator: transfer to rank " + std::to_string(dest) +
+                                    " outside " + std::to_string(size) + " ranks");
+        }
+        row[dest] = indices.size();
     }
     
-    // For now, just allocate the buffer
-    // Real implementation would:
-    // 1. Identify cells in Hilbert range [transfer.hilbert_start, transfer.hilbert_end)
-    // 2. Pack coordinates, levels, and field data
-    // 3. Write to send buffer
+    std::vector<uint8_t> gathered = m_transport->allGather(row.data(), row.size() * sizeof(uint64_t), nullptr);
+    std::vector<uint64_t> counts(static_cast<size_t>(size) * size, 0);
+    std::memcpy(counts.data(), gathered.data(), std::min(gathered.size(), counts.size() * sizeof(uint64_t)));
+    return counts;
+}
+
+size_t CellMigrator::packCells(
+    const std::vector<uint32_t>& indices,
+    const std::vector<MeshArray>& arrays,
+    transport::GPUAwareBuffer& message
+) {
+    std::vector<std::pair<cl_mem, size_t>> planes;
+    planes.reserve(arrays.size());
+    for (const auto& array : arrays) {
+        planes.emplace_back(*array.buffer, array.elem_bytes);
+    }
     
-    FL_LOG(INFO) << "Packed " << num_cells << " cells (" << total_bytes << " bytes)";
+    size_t bytes = compactor().gather(indices, planes, message.getCLMem());
     
-    return num_cells;
+    FL_LOG(DEBUG) << "Packed " << indices.size() << " cells (" << bytes << " bytes)";
+    return bytes;
 }
 
 void CellMigrator::unpackCells(
+    const transport::GPUAwareBuffer& message,
     size_t num_cells_received,
-    cl_mem* coord_x, cl_mem* coord_y, cl_mem* coord_z,
-    cl_mem* levels, cl_mem* fields,
-    uint32_t num_field_components,
+    const std::vector<MeshArray>& arrays,
+    cl_mem coord_x, cl_mem coord_y, cl_mem coord_z, cl_mem levels,
     size_t* total_cells
 ) {
-    // Simplified unpacking: append received cells to arrays
-    // Real implementation would:
-    // 1. Read from receive buffer
-    // 2. Insert cells in Hilbert order (maintain sorted order)
-    // 3. Update field data
+    const size_t first = *total_cells;
+    
+    // Each plane lands in the tail of its array
+    size_t plane_offset = 0;
+    for (const auto& array : arrays) {
+        const size_t bytes = num_cells_received * array.elem_bytes;
+        cl_int err = clEnqueueCopyBuffer(m_queue, message.getCLMem(), *array.buffer, plane_offset,
+                                         first * array.elem_bytes, bytes, 0, nullptr, nullptr);
+        if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to unpack migrated cells");
+        plane_offset += bytes;
+    }
+    
+    // Keys come from the coordinates just unpacked (in-order queue), so the
+    // hash can be patched
+    if (m_cell_keys) {
+        m_cell_keys->resize(first);
+        
+        std::vector<int32_t> x(num_cells_received), y(num_cells_received), z(num_cells_received);
+        std::vector<uint8_t> level(num_cells_received);
+        clEnqueueReadBuffer(m_queue, coord_x, CL_FALSE, first * sizeof(int32_t),
+                            num_cells_received * sizeof(int32_t), x.data(), 0, nullptr, nullptr);
+        clEnqueueReadBuffer(m_queue, coord_y, CL_FALSE, first * sizeof(int32_t),
+                            num_cells_received * sizeof(int32_t), y.data(), 0, nullptr, nullptr);
+        clEnqueueReadBuffer(m_queue, coord_z, CL_FALSE, first * sizeof(int32_t),
+                            num_cells_received * sizeof(int32_t), z.data(), 0, nullptr, nullptr);
+        cl_int err = clEnqueueReadBuffer(m_queue, levels, CL_TRUE, first * sizeof(uint8_t),
+                                         num_cells_received * sizeof(uint8_t), level.data(), 0, nullptr, nullptr);
+        if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to read back migrated coordinates");
+        
+        for (size_t i = 0; i < num_cells_received; ++i) {
+            uint64_t key = hilbert::encode(x[i], y[i], z[i], level[i]);
+            m_cell_keys->push_back(key);
+            m_last_delta.upsert_keys.push_back(key);
+            m_last_delta.upsert_indices.push_back(static_cast<uint32_t>(first + i));
+        }
+    }
     
     FL_LOG(INFO) << "Unpacked " << num_cells_received << " cells";
     
@@ -175,37 +248,42 @@ void CellMigrator::unpackCells(
 
 void CellMigrator::compactAfterMigration(
     const std::vector<uint32_t>& migrated_indices,
-    cl_mem* coord_x, cl_mem* coord_y, cl_mem* coord_z,
-    cl_mem* levels, cl_mem* fields,
-    uint32_t num_field_components,
+    const std::vector<MeshArray>& arrays,
     size_t* num_cells
 ) {
-    // Simplified compaction: reduce cell count
-    // Real implementation would:
-    // 1. Mark migrated cells as invalid
-    // 2. Run compaction kernel (similar to Module 11's compaction)
-    // 3. Update cell count
+    CompactionMoves moves = CellCompactor::plan(migrated_indices, *num_cells);
+    size_t cells_removed = *num_cells - moves.new_count;
     
-    size_t cells_removed = 0;
-    for (uint32_t count : migrated_indices) {
-        cells_removed += count;
+    // Device arrays and the key mirror take the same moves, so the patched
+    // hash points every key at the slot now holding its cell
+    if (!moves.empty()) {
+        std::vector<std::pair<cl_mem, size_t>> targets;
+        targets.reserve(arrays.size());
+        for (const auto& array : arrays) {
+            targets.emplace_back(*array.buffer, array.elem_bytes);
+        }
+        compactor().apply(moves, targets);
     }
     
-    if (cells_removed > *num_cells) {
-        FL_LOG(ERROR) << "Attempting to remove more cells than exist";
-        cells_removed = *num_cells;
+    if (m_cell_keys) {
+        for (size_t i = 0; i < moves.src.size(); ++i) {
+            uint64_t key = (*m_cell_keys)[moves.src[i]];
+            (*m_cell_keys)[moves.dst[i]] = key;
+            m_last_delta.upsert_keys.push_back(key);
+            m_last_delta.upsert_indices.push_back(moves.dst[i]);
+        }
+        m_cell_keys->resize(moves.new_count);
     }
     
-    *num_cells -= cells_removed;
+    *num_cells = moves.new_count;
     
     FL_LOG(INFO) << "Removed " << cells_removed << " cells, new count = " << *num_cells;
 }
 
 void CellMigrator::ensureCapacity(
     size_t required_capacity,
-    cl_mem* coord_x, cl_mem* coord_y, cl_mem* coord_z,
-    cl_mem* levels, cl_mem* cell_states,
-    cl_mem* fields, uint32_t num_field_components,
+    const std::vector<MeshArray>& arrays,
+    size_t num_cells,
     size_t* capacity
 ) {
     if (required_capacity <= *capacity) {
@@ -217,15 +295,40 @@ void CellMigrator::ensureCapacity(
     
     FL_LOG(INFO) << "Growing capacity from " << *capacity << " to " << new_capacity;
     
-    // Reallocate buffers
-    // Real implementation would:
-    // 1. Allocate new larger buffers
-    // 2. Copy existing data
-    // 3. Release old buffers
-    // 4. Update pointers
+    for (const auto& array : arrays) {
+        cl_int err;
+        cl_mem grown = clCreateBuffer(m_context, CL_MEM_READ_WRITE, new_capacity * array.elem_bytes, nullptr, &err);
+        if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to grow mesh buffer");
+        
+        if (num_cells > 0) {
+            err = clEnqueueCopyBuffer(m_queue, *array.buffer, grown, 0, 0, num_cells * array.elem_bytes,
+                                      0, nullptr, nullptr);
+            if (err != CL_SUCCESS) {
+                clReleaseMemObject(grown);
+                FL_THROW_OPENCL(err, "Failed to copy mesh buffer");
+            }
+        }
+        
+        // Freed once the copy has read it
+        clReleaseMemObject(*array.buffer);
+        *array.buffer = grown;
+    }
     
     *capacity = new_capacity;
 }
 
+std::vector<uint32_t> CellMigrator::selectOutgoing(const MigrationPlan::Transfer& transfer) const {
+    std::vector<uint32_t> indices;
+    if (!m_cell_keys) return indices;
+    
+    for (size_t i = 0; i < m_cell_keys->size(); ++i) {
+        uint64_t key = (*m_cell_keys)[i];
+        if (key >= transfer.hilbert_start && key < transfer.hilbert_end) {
+            indices.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    return indices;
+}
+
 } // namespace load_balance
 } // namespace fluidloom
@@ -18,6 +18,7 @@ LoadBalancer::LoadBalancer(transport::MPITransport* transport, const LoadBalance
     }
     
     m_config.validate();
+    seedLinkBandwidth(m_transport->getRemoteLinkProfile());
     
     FL_LOG(INFO) << "LoadBalancer initialized for " << m_transport->getSize() << " GPUs";
     FL_LOG(INFO) << "  Imbalance tolerance: " << m_config.imbalance_tolerance;
@@ -70,12 +71,102 @@ bool LoadBalancer::shouldRebalance(const std::vector<size_t>& cell_counts) {
     return should;
 }
 
+bool LoadBalancer::rebalancePaysOff(const std::vector<size_t>& cell_counts, const MigrationPlan& plan) {
+    // Per GPU: step time, adapted cells per step, migration estimate
+    const float local[3] = {m_step_time_ms, m_adapted_cells_per_step, plan.estimated_time_ms};
+#ifdef FLUIDLOOM_MPI_ENABLED
+    int num_gpus = m_transport->getSize();
+    std::vector<float> all(3 * num_gpus);
+    MPI_Allgather(local, 3, MPI_FLOAT, all.data(), 3, MPI_FLOAT, MPI_COMM_WORLD);
+#else
+    int num_gpus = 1;
+    std::vector<float> all(local, local + 3);
+#endif
+    
+    RebalanceCost cost;
+    float max_step_ms = 0.0f;
+    float sum_step_ms = 0.0f;
+    float adapted_cells_per_step = 0.0f;
+    bool measured = true;
+    for (int gpu = 0; gpu < num_gpus; ++gpu) {
+        float step_ms = all[3 * gpu];
+        if (step_ms < 0.0f) measured = false;
+        max_step_ms = std::max(max_step_ms, step_ms);
+        sum_step_ms += step_ms;
+        adapted_cells_per_step += all[3 * gpu + 1];
+        cost.migration_time_ms = std::max(cost.migration_time_ms, all[3 * gpu + 2]);
+    }
+    
+    if (!m_config.cost_benefit || !measured) {
+        return true;  // The cell-count trigger already fired
+    }
+    
+    size_t total_cells = std::accumulate(cell_counts.begin(), cell_counts.end(), size_t(0));
+    cost.step_time_imbalance_ms = max_step_ms - sum_step_ms / num_gpus;
+    cost.adaptation_rate = total_cells > 0 ? adapted_cells_per_step / total_cells : 0.0f;
+    
+    bool pays = m_config.shouldRebalance(cell_counts, m_steps_since_last_balance, cost);
+    
+    FL_LOG(INFO) << "Rebalance cost-benefit: imbalance=" << cost.step_time_imbalance_ms << " ms/step"
+                 << ", horizon=" << m_config.payoffHorizon(cost.adaptation_rate) << " steps"
+                 << ", migration=" << cost.migration_time_ms << " ms"
+                 << (pays ? " -> rebalance" : " -> skip");
+    
+    return pays;
+}
+
+void LoadBalancer::incrementTimestep() {
+    m_steps_since_last_balance++;
+    
+    // Adaptation passes are spread over the steps between them
+    m_adapted_cells_per_step += MEASUREMENT_SMOOTHING *
+        (static_cast<float>(m_pending_adapted_cells) - m_adapted_cells_per_step);
+    m_pending_adapted_cells = 0;
+}
+
+void LoadBalancer::recordStepTime(float busy_ms) {
+    if (m_step_time_ms < 0.0f) {
+        m_step_time_ms = busy_ms;
+    } else {
+        m_step_time_ms += MEASUREMENT_SMOOTHING * (busy_ms - m_step_time_ms);
+    }
+}
+
+void LoadBalancer::recordMigration(size_t bytes_sent, float elapsed_ms) {
+    if (bytes_sent == 0 || elapsed_ms <= 0.0f) return;
+    
+    // The first measurement replaces the seed, which ignored protocol overhead
+    float bandwidth = static_cast<float>(bytes_sent) / elapsed_ms;
+    if (!m_bandwidth_measured) {
+        m_bandwidth_bytes_per_ms = bandwidth;
+        m_link_latency_ms = 0.0f;
+        m_bandwidth_measured = true;
+    } else {
+        m_bandwidth_bytes_per_ms += MEASUREMENT_SMOOTHING * (bandwidth - m_bandwidth_bytes_per_ms);
+    }
+    
+    FL_LOG(INFO) << "Migration bandwidth: " << bandwidth / 1.0e6f << " GB/s measured, "
+                 << m_bandwidth_bytes_per_ms / 1.0e6f << " GB/s smoothed";
+}
+
+void LoadBalancer::seedLinkBandwidth(const transport::PeerAccessManager::LinkProfile& link) {
+    if (m_bandwidth_measured || !link.usable()) return;
+    
+    // GB/s == 1e6 bytes/ms
+    m_bandwidth_bytes_per_ms = static_cast<float>(link.bandwidth_gbps * 1e6);
+    m_link_latency_ms = static_cast<float>(link.latency_us * 1e-3);
+    
+    FL_LOG(INFO) << "Migration bandwidth seeded from link: " << link.bandwidth_gbps << " GB/s, "
+                 << link.latency_us << " us latency";
+}
+
 std::vector<uint64_t> LoadBalancer::computeSplitPoints(
     const std::vector<size_t>& cell_counts,
     const std::vector<uint64_t>& current_splits,
     uint64_t global_hilbert_min,
     uint64_t global_hilbert_max
 ) {
+    (void)current_splits;  // Splits are recomputed from scratch
     int num_gpus = static_cast<int>(cell_counts.size());
     if (num_gpus <= 1) {
         return {};  // No splits needed for single GPU
@@ -181,8 +272,14 @@ MigrationPlan LoadBalancer::createMigrationPlan(
     // Optimize plan
     plan.optimize();
     
-    // Estimate migration time (simple model: 1 μs per cell)
-    plan.estimated_time_ms = plan.total_cells_to_migrate * 0.001f;
+    // Estimate migration time from the bytes to send and the bandwidth of past
+    // migrations (or the seeded link); 1 μs per cell while neither is known
+    if (m_bytes_per_cell > 0 && m_bandwidth_bytes_per_ms > 0.0f) {
+        float bytes = static_cast<float>(plan.total_cells_to_migrate) * m_bytes_per_cell;
+        plan.estimated_time_ms = bytes / m_bandwidth_bytes_per_ms + plan.transfers.size() * m_link_latency_ms;
+    } else {
+        plan.estimated_time_ms = plan.total_cells_to_migrate * 0.001f;
+    }
     
     FL_LOG(INFO) << "Migration plan created: " << plan.transfers.size() << " transfers, "
                  << plan.total_cells_to_migrate << " cells, "
@@ -196,6 +293,7 @@ uint64_t LoadBalancer::estimateSplitPoint(
     const std::vector<size_t>& cell_counts,
     const std::vector<uint64_t>& current_splits
 ) const {
+    (void)current_splits;
     // Simple linear interpolation based on cumulative cell count
     // This is a placeholder - real implementation would sample Hilbert indices
     
@@ -4,8 +4,14 @@
 #include "fluidloom/adaptation/AdaptationEngine.h"
 #include "fluidloom/adaptation/AdaptationTypes.h"
 #include "fluidloom/runtime/nodes/KernelNode.h"
+#include "fluidloom/runtime/nodes/HaloExchangeNode.h"
+#include "fluidloom/runtime/nodes/BarrierNode.h"
+#include "fluidloom/common/Hash.h"
+#include "fluidloom/common/FluidLoomError.h"
 #include "fluidloom/core/registry/FieldRegistry.h"
 #include "fluidloom/core/fields/FieldDescriptor.h"
+#include "fluidloom/runtime/dependency/FieldLivenessAnalyzer.h"
+#include "fluidloom/runtime/dependency/DependencyGraph.h"
 
 // ANTLR includes
 #include "antlr4-runtime.h"
@@ -13,11 +19,34 @@
 #include "FluidLoomSimulationParser.h"
 #include "FluidLoomKernelParser.h"
 
+#include <algorithm>
 #include <sstream>
 
 namespace fluidloom {
 namespace parsing {
 
+namespace {
+
+// Collects the identifiers of statements that hand values to the host
+// (write, print, reduce), or of every statement when host_visible is set
+void collectHostFields(antlr4::tree::ParseTree* tree, bool host_visible, std::unordered_set<std::string>& fields) {
+    if (auto* terminal = dynamic_cast<antlr4::tree::TerminalNode*>(tree)) {
+        if (host_visible && terminal->getSymbol()->getType() == FluidLoomSimulationParser::IDENTIFIER) {
+            fields.insert(terminal->getText());
+        }
+        return;
+    }
+    host_visible = host_visible ||
+        dynamic_cast<FluidLoomSimulationParser::WriteStatementContext*>(tree) != nullptr ||
+        dynamic_cast<FluidLoomSimulationParser::PrintStatementContext*>(tree) != nullptr ||
+        dynamic_cast<FluidLoomSimulationParser::ReduceStatementContext*>(tree) != nullptr;
+    for (auto* child : tree->children) {
+        collectHostFields(child, host_visible, fields);
+    }
+}
+
+} // namespace
+
 SimulationBuilder::SimulationBuilder(cl_context context, cl_command_queue queue)
     : m_context(context), m_queue(queue),
       m_coord_x(nullptr), m_coord_y(nullptr), m_coord_z(nullptr),
@@ -32,6 +61,7 @@ SimulationBuilder::SimulationBuilder(cl_context context, cl_command_queue queue)
     
     // Create GeometryPlacer
     m_geometry_placer = std::make_unique<geometry::GeometryPlacer>();
+    m_geometry_placer->setBackend(m_backend.get());
     
     FL_LOG(INFO) << "SimulationBuilder initialized with SOAFieldManager and GeometryPlacer";
     
@@ -203,21 +233,41 @@ std::unique_ptr<runtime::ExecutionGraph> SimulationBuilder::buildFromScript(cons
         
         FL_LOG(INFO) << "Parsing complete, building execution graph";
         
+        // Field access declared by the script's kernel definitions
+        m_kernel_access.clear();
+        for (auto* kernelDef : ast->kernelDefinition()) {
+            KernelAccess access;
+            auto* params = kernelDef->kernelParameters();
+            for (auto* reads : params->readsClause()) {
+                for (auto* id : reads->fieldList()->IDENTIFIER()) access.reads.push_back(id->getText());
+            }
+            for (auto* writes : params->writesClause()) {
+                for (auto* id : writes->fieldList()->IDENTIFIER()) access.writes.push_back(id->getText());
+            }
+            for (auto* halo : params->haloClause()) {
+                access.halo_depth = static_cast<uint8_t>(std::stoi(halo->INTEGER()->getText()));
+            }
+            m_kernel_access[kernelDef->IDENTIFIER()->getText()] = std::move(access);
+        }
+        
+        m_host_fields.clear();
+        for (auto* codeBlock : ast->codeBlock()) {
+            collectHostFields(codeBlock, codeBlock->TIME_LOOP() == nullptr, m_host_fields);
+        }
+        
         // Parse field declarations from AST and register them
         parseFieldDeclarations(&parser);
         
         // Process geometry definitions
         processGeometry(&parser);
         
-        // Allocate buffers for all registered fields
-        allocateFieldBuffers();
-        
         // Use existing FieldRegistry to get field buffers
         auto& field_registry = registry::FieldRegistry::instance();
         auto all_fields = field_registry.getAllNames();
         FL_LOG(INFO) << "Registered " << all_fields.size() << " fields from .fl file";
         
         auto graph = std::make_unique<runtime::ExecutionGraph>();
+        m_kernel_plans.clear();
         
         // Traverse AST to extract kernel calls and adapt_mesh
         int kernel_count = 0;
@@ -288,26 +338,37 @@ std::unique_ptr<runtime::ExecutionGraph> SimulationBuilder::buildFromScript(cons
                                     // Set kernel handle
                                     kernel_node->setKernel(kernel, m_context, m_queue);
                                     
-                                    // Bind field buffers to kernel arguments
-                                    for (const auto& param_name : param_names) {
-                                        auto handle_it = m_field_handles.find(param_name);
-                                        if (handle_it != m_field_handles.end()) {
-                                            cl_mem buffer = static_cast<cl_mem>(
-                                                m_field_manager->getDevicePtr(handle_it->second)
-                                            );
-                                            kernel_node->bindField(param_name, buffer);
-                                            FL_LOG(INFO) << "Bound field '" << param_name << "' to kernel " << kernel_name;
-                                        } else {
-                                            FL_LOG(WARN) << "Field '" << param_name << "' not found in field handles for kernel " << kernel_name;
-                                        }
+                                    // Declared access drives hazards and liveness; a kernel
+                                    // without a definition may read and write every parameter
+                                    auto access_it = m_kernel_access.find(kernel_name);
+                                    if (access_it != m_kernel_access.end()) {
+                                        kernel_node->setReadFields(access_it->second.reads);
+                                        kernel_node->setWriteFields(access_it->second.writes);
+                                        kernel_node->setHaloDepth(access_it->second.halo_depth);
+                                    } else {
+                                        kernel_node->setReadFields(param_names);
+                                        kernel_node->setWriteFields(param_names);
                                     }
                                     
                                     // Set work size based on number of cells
                                     kernel_node->setGlobalWorkSize(m_num_cells);
+                                    kernel_node->bindCellCount(&m_num_cells);
                                     kernel_node->setLocalWorkSize(256);
                                     
                                     graph->addNode(kernel_node);
                                     kernel_count++;
+                                    
+                                    // Keep what a compiled plan needs to recreate the node
+                                    runtime::plan::PlanNode plan_node;
+                                    plan_node.kernel_source = kernel_source;
+                                    plan_node.params = param_names;
+                                    plan_node.global_work_size = m_num_cells;
+                                    plan_node.local_work_size = 256;
+                                    plan_node.binary = programBinary(program);
+                                    if (!plan_node.binary.empty()) {
+                                        plan_node.device_signature = deviceSignature();
+                                    }
+                                    m_kernel_plans[kernel_node.get()] = std::move(plan_node);
                                 } else {
                                     FL_LOG(ERROR) << "Failed to create kernel object for " << kernel_name;
                                 }
@@ -322,22 +383,7 @@ std::unique_ptr<runtime::ExecutionGraph> SimulationBuilder::buildFromScript(cons
                     if (adaptStmt) {
                         FL_LOG(INFO) << "Found adapt_mesh() call in time_loop";
                         
-                        // Create AdaptationEngine
-                        auto adapt_config = adaptation::AdaptationConfig{};
-                        adapt_config.enforce_2_1_balance = true;
-                        adapt_config.max_balance_iterations = 10;
-                        
-                        auto adapt_engine = new adaptation::AdaptationEngine(m_context, m_queue, adapt_config);
-                        
-                        // Create and add AdaptMeshNode
-                        auto adapt_node = std::make_shared<runtime::nodes::AdaptMeshNode>("adapt_mesh", adapt_engine);
-                        adapt_node->bindMesh(
-                            &m_coord_x, &m_coord_y, &m_coord_z,
-                            &m_levels, &m_cell_states, &m_refine_flags, &m_material_id,
-                            &m_num_cells, &m_capacity
-                        );
-                        
-                        graph->addNode(adapt_node);
+                        graph->addNode(createAdaptMeshNode());
                         adapt_mesh_count++;
                     }
                 }
@@ -348,9 +394,15 @@ std::unique_ptr<runtime::ExecutionGraph> SimulationBuilder::buildFromScript(cons
         
         if (kernel_count == 0 && adapt_mesh_count == 0) {
             FL_LOG(WARN) << "No kernels or adapt_mesh() calls found, falling back to stub";
-            return buildStub();
+            auto stub = buildStub();
+            allocateFieldBuffers(*stub);
+            return stub;
         }
         
+        // Buffers follow the graph so that transient fields can share them
+        allocateFieldBuffers(*graph);
+        bindKernelFields(*graph);
+        
         FL_LOG(INFO) << "Graph built with " << graph->getNodeCount() << " nodes";
         
         return graph;
@@ -438,22 +490,8 @@ std::unique_ptr<runtime::ExecutionGraph> SimulationBuilder::buildStub() {
     
     auto graph = std::make_unique<runtime::ExecutionGraph>();
     
-    // Create AdaptationEngine
-    auto adapt_config = adaptation::AdaptationConfig{};
-    adapt_config.enforce_2_1_balance = true;
-    adapt_config.max_balance_iterations = 10;
-    
-    auto adapt_engine = new adaptation::AdaptationEngine(m_context, m_queue, adapt_config);
-    
-    // Create and add AdaptMeshNode
-    auto adapt_node = std::make_shared<runtime::nodes::AdaptMeshNode>("adapt_mesh", adapt_engine);
-    adapt_node->bindMesh(
-        &m_coord_x, &m_coord_y, &m_coord_z,
-        &m_levels, &m_cell_states, &m_refine_flags, &m_material_id,
-        &m_num_cells, &m_capacity
-    );
-    
-    graph->addNode(adapt_node);
+    m_kernel_plans.clear();
+    graph->addNode(createAdaptMeshNode());
     
     FL_LOG(INFO) << "Added AdaptMeshNode to execution graph";
     FL_LOG(INFO) << "Graph built with " << graph->getNodeCount() << " nodes";
@@ -499,8 +537,28 @@ std::unique_ptr<runtime::ExecutionGraph> SimulationBuilder::buildStub() {
                          << field_name << "', defaulting to scalar float";
         }
         
-        // Create field descriptor with halo depth 1 (standard for CFD)
-        fields::FieldDescriptor desc(field_name, field_type, num_components, 1);
+        // 'transient field' declares a per-step scratch value (see FieldLivenessAnalyzer)
+        bool is_transient = fieldDecl->TRANSIENT() != nullptr;
+        if (is_transient && m_host_fields.count(field_name)) {
+            FL_LOG(WARN) << "Field '" << field_name << "' is marked transient but read outside the step; "
+                         << "keeping it across steps";
+            is_transient = false;
+        }
+        
+        // Halo depth 1 (standard for CFD); a transient field only gets the
+        // halo a kernel reading it declares
+        uint8_t halo_depth = 1;
+        if (is_transient) {
+            halo_depth = 0;
+            for (const auto& [kernel_name, access] : m_kernel_access) {
+                if (std::find(access.reads.begin(), access.reads.end(), field_name) != access.reads.end()) {
+                    halo_depth = std::max(halo_depth, access.halo_depth);
+                }
+            }
+        }
+        
+        fields::FieldDescriptor desc(field_name, field_type, num_components, halo_depth);
+        desc.is_transient = is_transient;
         
         // Register field
         if (field_registry.registerField(desc)) {
@@ -512,47 +570,275 @@ std::unique_ptr<runtime::ExecutionGraph> SimulationBuilder::buildStub() {
     }
 }
 
-void SimulationBuilder::allocateFieldBuffers() {
-    FL_LOG(INFO) << "Allocating field buffers via SOAFieldManager";
+std::shared_ptr<runtime::nodes::AdaptMeshNode> SimulationBuilder::createAdaptMeshNode() {
+    auto adapt_config = adaptation::AdaptationConfig{};
+    adapt_config.enforce_2_1_balance = true;
+    adapt_config.max_balance_iterations = 10;
+    
+    auto adapt_engine = new adaptation::AdaptationEngine(m_context, m_queue, adapt_config);
+    
+    auto adapt_node = std::make_shared<runtime::nodes::AdaptMeshNode>("adapt_mesh", adapt_engine);
+    adapt_node->bindMesh(
+        &m_coord_x, &m_coord_y, &m_coord_z,
+        &m_levels, &m_cell_states, &m_refine_flags, &m_material_id,
+        &m_num_cells, &m_capacity
+    );
+    adapt_node->bindFieldManager(m_field_manager.get());
+    return adapt_node;
+}
+
+std::string SimulationBuilder::deviceSignature() const {
+    cl_device_id device = nullptr;
+    clGetCommandQueueInfo(m_queue, CL_QUEUE_DEVICE, sizeof(device), &device, nullptr);
+    if (!device) return "";
+    
+    auto info = [device](cl_device_info param) {
+        size_t size = 0;
+        clGetDeviceInfo(device, param, 0, nullptr, &size);
+        std::string value(size, '\0');
+        clGetDeviceInfo(device, param, size, value.data(), nullptr);
+        while (!value.empty() && value.back() == '\0') value.pop_back();
+        return value;
+    };
+    return info(CL_DEVICE_NAME) + "|" + info(CL_DRIVER_VERSION);
+}
+
+std::vector<uint8_t> SimulationBuilder::programBinary(cl_program program) {
+    cl_uint num_devices = 0;
+    if (clGetProgramInfo(program, CL_PROGRAM_NUM_DEVICES, sizeof(num_devices), &num_devices, nullptr) != CL_SUCCESS ||
+        num_devices != 1) {
+        return {};
+    }
+    
+    size_t size = 0;
+    if (clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES, sizeof(size), &size, nullptr) != CL_SUCCESS || size == 0) {
+        return {};
+    }
+    
+    std::vector<uint8_t> binary(size);
+    unsigned char* data = binary.data();
+    if (clGetProgramInfo(program, CL_PROGRAM_BINARIES, sizeof(data), &data, nullptr) != CL_SUCCESS) {
+        return {};
+    }
+    return binary;
+}
+
+cl_kernel SimulationBuilder::loadPlanKernel(const runtime::plan::PlanNode& node) {
+    cl_device_id device = nullptr;
+    clGetCommandQueueInfo(m_queue, CL_QUEUE_DEVICE, sizeof(device), &device, nullptr);
+    
+    cl_int err = CL_SUCCESS;
+    cl_program program = nullptr;
+    
+    if (!node.binary.empty() && node.device_signature == deviceSignature()) {
+        const unsigned char* binary = node.binary.data();
+        size_t size = node.binary.size();
+        cl_int status = CL_SUCCESS;
+        program = clCreateProgramWithBinary(m_context, 1, &device, &size, &binary, &status, &err);
+        if (err == CL_SUCCESS && status == CL_SUCCESS) {
+            err = clBuildProgram(program, 1, &device, nullptr, nullptr, nullptr);
+        }
+        if (err != CL_SUCCESS || status != CL_SUCCESS) {
+            FL_LOG(WARN) << "Cached binary for kernel " << node.name << " rejected (error " << err
+                         << "), compiling from source";
+            if (program) clReleaseProgram(program);
+            program = nullptr;
+        }
+    }
+    
+    if (!program) {
+        const char* source = node.kernel_source.c_str();
+        size_t length = node.kernel_source.length();
+        program = clCreateProgramWithSource(m_context, 1, &source, &length, &err);
+        if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to create program for kernel " + node.name);
+        
+        err = clBuildProgram(program, 1, &device, nullptr, nullptr, nullptr);
+        if (err != CL_SUCCESS) {
+            clReleaseProgram(program);
+            FL_THROW_OPENCL(err, "Failed to build kernel " + node.name);
+        }
+    }
+    
+    cl_kernel kernel = clCreateKernel(program, node.name.c_str(), &err);
+    clReleaseProgram(program);  // The kernel keeps the program alive
+    if (err != CL_SUCCESS) FL_THROW_OPENCL(err, "Failed to create kernel " + node.name);
+    return kernel;
+}
+
+runtime::plan::SimulationPlan SimulationBuilder::compilePlan(const std::string& script_content) {
+    auto graph = buildFromScript(script_content);
+    
+    runtime::plan::SimulationPlan plan;
+    plan.script_hash = hash::fnv1a_64(script_content);
+    plan.num_cells = m_num_cells;
+    plan.capacity = m_capacity;
+    
+    auto& field_registry = registry::FieldRegistry::instance();
+    for (const auto& name : field_registry.getAllNames()) {
+        if (auto desc = field_registry.lookupByName(name)) {
+            plan.fields.push_back(*desc);
+        }
+    }
+    
+    for (const auto& node : graph->getNodes()) {
+        runtime::plan::PlanNode plan_node;
+        auto it = m_kernel_plans.find(node.get());
+        if (it != m_kernel_plans.end()) {
+            plan_node = it->second;
+        }
+        
+        plan_node.type = node->getType();
+        plan_node.name = node->getName();
+        plan_node.level = node->getLevel();
+        plan_node.halo_depth = node->getHaloDepth();
+        plan_node.read_fields = node->getReadFields();
+        plan_node.write_fields = node->getWriteFields();
+        plan_node.execution_mask = node->getExecutionMask();
+        
+        if (auto halo = std::dynamic_pointer_cast<runtime::nodes::HaloExchangeNode>(node)) {
+            plan_node.halo_fields = halo->getHaloFields();
+        } else if (auto barrier = std::dynamic_pointer_cast<runtime::nodes::BarrierNode>(node)) {
+            plan_node.barrier_kind = static_cast<uint8_t>(barrier->getKind());
+            plan_node.global_barrier = barrier->isGlobal();
+        }
+        plan.nodes.push_back(std::move(plan_node));
+    }
+    
+    plan.edges = graph->getDependencyEdges();
+    
+    FL_LOG(INFO) << "Compiled simulation plan: " << plan.nodes.size() << " nodes, "
+                 << plan.edges.size() << " edges, " << plan.fields.size() << " fields";
+    return plan;
+}
+
+std::unique_ptr<runtime::ExecutionGraph> SimulationBuilder::buildFromPlan(const runtime::plan::SimulationPlan& plan) {
+    FL_LOG(INFO) << "Building execution graph from compiled plan (" << plan.nodes.size() << " nodes)";
+    
+    if (plan.num_cells != m_num_cells || plan.capacity != m_capacity) {
+        FL_LOG(WARN) << "Plan was compiled for " << plan.num_cells << " cells (capacity " << plan.capacity
+                     << "), mesh has " << m_num_cells << " (capacity " << m_capacity << ")";
+    }
     
     auto& field_registry = registry::FieldRegistry::instance();
-    auto all_field_names = field_registry.getAllNames();
+    for (const auto& desc : plan.fields) {
+        field_registry.registerField(desc);
+    }
+    
+    auto graph = std::make_unique<runtime::ExecutionGraph>();
+    m_kernel_plans.clear();
     
-    for (const auto& field_name : all_field_names) {
+    for (const auto& plan_node : plan.nodes) {
+        std::shared_ptr<runtime::nodes::ExecutionNode> node;
+        
+        switch (plan_node.type) {
+            case runtime::nodes::ExecutionNode::NodeType::KERNEL: {
+                auto kernel_node = std::make_shared<runtime::nodes::KernelNode>(plan_node.name, plan_node.kernel_source);
+                kernel_node->setKernel(loadPlanKernel(plan_node), m_context, m_queue);
+                kernel_node->setGlobalWorkSize(m_num_cells);
+                kernel_node->bindCellCount(&m_num_cells);
+                kernel_node->setLocalWorkSize(plan_node.local_work_size);
+                m_kernel_plans[kernel_node.get()] = plan_node;
+                node = kernel_node;
+                break;
+            }
+            case runtime::nodes::ExecutionNode::NodeType::ADAPT_MESH:
+                node = createAdaptMeshNode();
+                break;
+            case runtime::nodes::ExecutionNode::NodeType::HALO_EXCHANGE:
+                node = std::make_shared<runtime::nodes::HaloExchangeNode>(plan_node.name, plan_node.halo_fields);
+                break;
+            case runtime::nodes::ExecutionNode::NodeType::BARRIER: {
+                auto barrier = std::make_shared<runtime::nodes::BarrierNode>(
+                    plan_node.name,
+                    static_cast<runtime::nodes::BarrierNode::BarrierKind>(plan_node.barrier_kind),
+                    plan_node.global_barrier);
+                barrier->setQueue(m_queue);
+                node = barrier;
+                break;
+            }
+            default:
+                throw std::runtime_error("Simulation plan node '" + plan_node.name +
+                                         "' has a type that cannot be loaded");
+        }
+        
+        node->setLevel(plan_node.level);
+        node->setHaloDepth(plan_node.halo_depth);
+        node->setReadFields(plan_node.read_fields);
+        node->setWriteFields(plan_node.write_fields);
+        node->setExecutionMask(plan_node.execution_mask);
+        graph->addNode(node);
+    }
+    
+    graph->setDependencyEdges(plan.edges);
+    allocateFieldBuffers(*graph);
+    bindKernelFields(*graph);
+    
+    FL_LOG(INFO) << "Graph built with " << graph->getNodeCount() << " nodes from plan";
+    return graph;
+}
+
+void SimulationBuilder::allocateFieldBuffers(runtime::ExecutionGraph& graph) {
+    FL_LOG(INFO) << "Allocating field buffers via SOAFieldManager";
+    
+    auto& field_registry = registry::FieldRegistry::instance();
+    std::vector<fields::FieldDescriptor> descs;
+    for (const auto& field_name : field_registry.getAllNames()) {
         auto desc_opt = field_registry.lookupByName(field_name);
         if (!desc_opt) {
             FL_LOG(ERROR) << "Field '" << field_name << "' not found in registry";
             continue;
         }
+        descs.push_back(*desc_opt);
+    }
+    
+    // Transient fields whose lifetimes never overlap share one buffer
+    runtime::dependency::FieldLivenessAnalyzer liveness;
+    auto plan = liveness.analyze(graph.getDependencyGraph(), descs);
+    
+    try {
+        m_field_handles = runtime::dependency::FieldLivenessAnalyzer::allocate(
+            *m_field_manager, plan, descs, m_num_cells);
+    } catch (const std::exception& e) {
+        FL_LOG(ERROR) << "Failed to allocate field buffers: " << e.what();
+        return;
+    }
+    
+    // Initialize with zeros
+    for (const auto& desc : descs) {
+        fields::FieldHandle handle = m_field_handles.at(desc.name);
+        size_t total_bytes = desc.bytesPerCell() * m_num_cells;
+        std::vector<uint8_t> zeros(total_bytes, 0);
         
-        const auto& desc = *desc_opt;
-        
-        // Allocate buffer for this field
-        try {
-            fields::FieldHandle handle = m_field_manager->allocate(desc, m_num_cells);
-            m_field_handles[field_name] = handle;
-            
-            // Initialize with zeros
-            size_t bytes_per_cell = desc.bytesPerCell();
-            size_t total_bytes = bytes_per_cell * m_num_cells;
-            std::vector<uint8_t> zeros(total_bytes, 0);
-            
-            cl_mem buffer = static_cast<cl_mem>(m_field_manager->getDevicePtr(handle));
-            clEnqueueWriteBuffer(m_queue, buffer, CL_TRUE, 0, total_bytes, 
-                               zeros.data(), 0, nullptr, nullptr);
-            
-            FL_LOG(INFO) << "Allocated and initialized field '" << field_name << "': " 
-                         << m_num_cells << " cells × " << bytes_per_cell << " bytes = "
-                         << total_bytes << " bytes";
-        } catch (const std::exception& e) {
-            FL_LOG(ERROR) << "Failed to allocate field '" << field_name << "': " << e.what();
-        }
+        cl_mem buffer = static_cast<cl_mem>(m_field_manager->getDevicePtr(handle));
+        clEnqueueWriteBuffer(m_queue, buffer, CL_TRUE, 0, total_bytes,
+                           zeros.data(), 0, nullptr, nullptr);
     }
     
-    FL_LOG(INFO) << "Total field memory: " 
+    FL_LOG(INFO) << "Allocated " << descs.size() << " fields in " << plan.dedicated.size() + plan.slots.size()
+                 << " buffers (" << plan.bytes_per_cell_before << " -> " << plan.bytes_per_cell_after
+                 << " bytes/cell), total field memory: "
                  << m_field_manager->getTotalMemoryUsage() / (1024.0 * 1024.0) << " MB";
 }
 
+void SimulationBuilder::bindKernelFields(runtime::ExecutionGraph& graph) {
+    for (const auto& node : graph.getNodes()) {
+        auto kernel_node = std::dynamic_pointer_cast<runtime::nodes::KernelNode>(node);
+        auto plan_it = m_kernel_plans.find(node.get());
+        if (!kernel_node || plan_it == m_kernel_plans.end()) continue;
+        
+        // Bind field buffers to kernel arguments
+        for (const auto& param_name : plan_it->second.params) {
+            auto handle_it = m_field_handles.find(param_name);
+            if (handle_it == m_field_handles.end()) {
+                FL_LOG(WARN) << "Field '" << param_name << "' not found in field handles for kernel "
+                             << kernel_node->getName();
+                continue;
+            }
+            kernel_node->bindField(param_name, m_field_manager.get(), handle_it->second);
+        }
+    }
+}
+
 } // namespace parsing
 
 } // namespace fluidloom
@@ -0,0 +1,31 @@
+#include "fluidloom/parsing/ast/AstArena.h"
+#include <new>
+
+namespace fluidloom {
+namespace parsing {
+namespace ast {
+
+void* AstArena::Storage::allocate(size_t bytes, size_t alignment) {
+    if (alignment > alignof(std::max_align_t)) {
+        throw std::bad_alloc();
+    }
+
+    size_t aligned = (offset + alignment - 1) & ~(alignment - 1);
+    if (blocks.empty() || aligned + bytes > capacity) {
+        // Oversized requests get a dedicated block of their own size
+        size_t size = bytes > block_size ? bytes : block_size;
+        size_t words = (size + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+        blocks.push_back(std::make_unique<std::max_align_t[]>(words));
+        capacity = words * sizeof(std::max_align_t);
+        aligned = 0;
+    }
+
+    void* ptr = reinterpret_cast<char*>(blocks.back().get()) + aligned;
+    offset = aligned + bytes;
+    bytes_used += bytes;
+    return ptr;
+}
+
+} // namespace ast
+} // namespace parsing
+} // namespace fluidloom
@@ -1,21 +1,74 @@
 #include "fluidloom/parsing/visitors/FieldsVisitor.h"
 #include "fluidloom/parsing/visitors/LatticesVisitor.h"
 #include "fluidloom/parsing/codegen/OpenCLPreambleGenerator.h"
+#include "fluidloom/parsing/SimulationBuilder.h"
+#include "fluidloom/runtime/plan/SimulationPlan.h"
 #include "fluidloom/common/Logger.h"
 #include <iostream>
 #include <filesystem>
+#include <fstream>
+#include <sstream>
 #include <cstring>
 
 namespace fs = std::filesystem;
 
 void printUsage(const char* program_name) {
     std::cout << "Usage: " << program_name << " [options] <fields.fl> <lattices.fl>\n";
+    std::cout << "       " << program_name << " [-o <dir>] --aot <simulation.fl>\n";
+    std::cout << "       " << program_name << " --dump-plan <plan.flplan>\n";
     std::cout << "\nOptions:\n";
     std::cout << "  -o <dir>          Output directory (default: ./generated)\n";
     std::cout << "  --validate-only   Only validate, don't generate code\n";
+    std::cout << "  --aot <file>      Compile a simulation into <dir>/<name>.flplan for fluidloom-run --plan\n";
+    std::cout << "  --dump-plan <f>   Print the contents of a compiled plan\n";
     std::cout << "  -h, --help        Show this help message\n";
     std::cout << "\nExample:\n";
     std::cout << "  " << program_name << " -o build/generated fields.fl lattices.fl\n";
+    std::cout << "  " << program_name << " -o plans --aot benchmarks/lid_driven_cavity.fl\n";
+}
+
+// Parse, schedule and compile a simulation once; kernel binaries target the
+// first GPU, which is what fluidloom-run will pick on the same node type
+int compilePlan(const std::string& script_file, const std::string& output_dir) {
+    std::ifstream file(script_file);
+    if (!file) {
+        std::cerr << "Error: File not found: " << script_file << "\n";
+        return 1;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    
+    cl_int err;
+    cl_platform_id platform;
+    cl_device_id device;
+    if (clGetPlatformIDs(1, &platform, nullptr) != CL_SUCCESS ||
+        clGetDeviceIDs(platform, CL_DEVICE_TYPE_GPU, 1, &device, nullptr) != CL_SUCCESS) {
+        std::cerr << "Error: --aot needs an OpenCL GPU to compile kernels for\n";
+        return 1;
+    }
+    cl_context context = clCreateContext(nullptr, 1, &device, nullptr, nullptr, &err);
+    cl_command_queue queue = clCreateCommandQueue(context, device, 0, &err);
+    
+    int status = 0;
+    try {
+        fluidloom::runtime::plan::SimulationPlan plan;
+        {
+            fluidloom::parsing::SimulationBuilder builder(context, queue);
+            plan = builder.compilePlan(buffer.str());
+        }
+        
+        fs::create_directories(output_dir);
+        std::string plan_path = output_dir + "/" + fs::path(script_file).stem().string() + ".flplan";
+        plan.save(plan_path);
+        std::cout << "Generated: " << plan_path << "\n" << plan.describe();
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        status = 1;
+    }
+    
+    clReleaseCommandQueue(queue);
+    clReleaseContext(context);
+    return status;
 }
 
 int main(int argc, char** argv) {
@@ -28,6 +81,7 @@ int main(int argc, char** argv) {
     bool validate_only = false;
     std::string fields_file;
     std::string lattices_file;
+    std::string aot_file;
     
     // Parse arguments
     for (int i = 1; i < argc; ++i) {
@@ -45,6 +99,22 @@ int main(int argc, char** argv) {
             }
         } else if (arg == "--validate-only") {
             validate_only = true;
+        } else if (arg == "--aot" || arg == "--dump-plan") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires an argument\n";
+                return 1;
+            }
+            if (arg == "--aot") {
+                aot_file = argv[++i];
+                continue;
+            }
+            try {
+                std::cout << fluidloom::runtime::plan::SimulationPlan::load(argv[++i]).describe();
+                return 0;
+            } catch (const std::exception& e) {
+                std::cerr << "Error: " << e.what() << "\n";
+                return 1;
+            }
         } else {
             if (fields_file.empty()) {
                 fields_file = arg;
@@ -57,6 +127,10 @@ int main(int argc, char** argv) {
         }
     }
     
+    if (!aot_file.empty()) {
+        return compilePlan(aot_file, output_dir);
+    }
+    
     if (fields_file.empty() || lattices_file.empty()) {
         std::cerr << "Error: Both fields.fl and lattices.fl are required\n";
         printUsage(argv[0]);
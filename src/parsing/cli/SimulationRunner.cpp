@@ -1,4 +1,5 @@
 #include "fluidloom/parsing/SimulationBuilder.h"
+#include "fluidloom/runtime/executor/WorkStealingExecutor.h"
 #include "fluidloom/common/Logger.h"
 #include <iostream>
 #include <fstream>
@@ -13,20 +14,44 @@
 using namespace fluidloom;
 
 int main(int argc, char** argv) {
-    std::string filename = (argc >= 2) ? argv[1] : "benchmarks/lid_driven_cavity.fl";
+    // fluidloom-run [--parallel] [--plan <plan.flplan> | <script.fl>]
+    std::string filename = "benchmarks/lid_driven_cavity.fl";
+    std::string plan_file;
+    bool parallel = false;
+    int arg = 1;
+    if (arg < argc && std::string(argv[arg]) == "--parallel") {
+        parallel = true;
+        ++arg;
+    }
+    if (arg + 1 < argc && std::string(argv[arg]) == "--plan") {
+        plan_file = argv[arg + 1];
+    } else if (arg < argc) {
+        filename = argv[arg];
+    }
     
     FL_LOG(INFO) << "FluidLoom AMR with ANTLR Parser";
-    FL_LOG(INFO) << "Loading: " << filename;
     
-    // Read .fl file
+    // Load the compiled plan (skips parsing and scheduling) or the .fl script
+    std::unique_ptr<runtime::plan::SimulationPlan> plan;
     std::string script_content;
-    std::ifstream file(filename);
+    if (!plan_file.empty()) {
+        FL_LOG(INFO) << "Loading plan: " << plan_file;
+        try {
+            plan = std::make_unique<runtime::plan::SimulationPlan>(runtime::plan::SimulationPlan::load(plan_file));
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+    
+    FL_LOG(INFO) << "Loading: " << filename;
+    std::ifstream file(plan ? std::string() : filename);
     if (file.is_open()) {
         std::stringstream buffer;
         buffer << file.rdbuf();
         script_content = buffer.str();
         FL_LOG(INFO) << "Loaded " << script_content.length() << " bytes from " << filename;
-    } else {
+    } else if (!plan) {
         FL_LOG(WARN) << "Could not open " << filename << ", using stub";
     }
     
@@ -46,13 +71,26 @@ int main(int argc, char** argv) {
     try {
         // Build execution graph
         parsing::SimulationBuilder builder(context, queue);
-        auto graph = script_content.empty() ? builder.buildStub() : builder.buildFromScript(script_content);
+        auto graph = plan ? builder.buildFromPlan(*plan)
+                   : script_content.empty() ? builder.buildStub()
+                   : builder.buildFromScript(script_content);
         
         FL_LOG(INFO) << "Execution graph built with " << graph->getNodeCount() << " nodes";
         
-        // Execute
+        // Execute: serially in insertion order, or on the work-stealing
+        // executor over the hazard DAG
         FL_LOG(INFO) << "Executing simulation...";
-        graph->execute();
+        if (parallel) {
+            runtime::executor::WorkStealingExecutor executor;
+            executor.setMarkerQueue(queue);
+            if (!graph->execute(executor)) {
+                throw std::runtime_error("Parallel execution failed");
+            }
+            FL_LOG(INFO) << "Executed on " << executor.getThreadCount() << " threads ("
+                         << executor.getStealCount() << " steals)";
+        } else {
+            graph->execute();
+        }
         
         FL_LOG(INFO) << "Simulation complete!";
         
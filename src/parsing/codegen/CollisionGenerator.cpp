@@ -0,0 +1,693 @@
+#include "fluidloom/parsing/codegen/CollisionGenerator.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace fluidloom {
+namespace parsing {
+namespace codegen {
+
+namespace {
+
+const char* const AXIS_U[3] = {"ux", "uy", "uz"};
+const char* const AXIS_NAME = "xyz";
+
+// Products of u in EquilibriumPolynomial::quadratic order
+const int QUAD_AXES[6][2] = {{0, 0}, {1, 1}, {2, 2}, {0, 1}, {0, 2}, {1, 2}};
+
+double binomial(int n, int k) {
+    return (k == 0 || k == n) ? 1.0 : static_cast<double>(n);  // n <= 2
+}
+
+bool isInteger(double value) {
+    return std::fabs(value - std::round(value)) < 1e-12;
+}
+
+std::string literal(double value) {
+    std::ostringstream oss;
+    if (isInteger(value)) {
+        oss << static_cast<long long>(std::llround(value)) << ".0f";
+    } else {
+        oss << std::setprecision(9) << value << "f";
+    }
+    return oss.str();
+}
+
+// "ux*ux*uy"; empty for u^0
+std::string uProduct(const std::array<uint8_t, 3>& powers) {
+    std::string product;
+    for (int d = 0; d < 3; ++d) {
+        for (int p = 0; p < powers[d]; ++p) {
+            if (!product.empty()) product += "*";
+            product += AXIS_U[d];
+        }
+    }
+    return product;
+}
+
+float uPower(const float u[3], const std::array<uint8_t, 3>& powers) {
+    float product = 1.0f;
+    for (int d = 0; d < 3; ++d) {
+        for (int p = 0; p < powers[d]; ++p) {
+            product *= u[d];
+        }
+    }
+    return product;
+}
+
+// Sum of coefficient·factor terms without zero terms or unit coefficients;
+// an empty factor is a constant
+std::string linearCombination(const std::vector<std::pair<double, std::string>>& terms) {
+    std::ostringstream oss;
+    bool first = true;
+    for (const auto& [coefficient, factor] : terms) {
+        if (std::fabs(coefficient) < 1e-12) continue;
+        const bool negative = coefficient < 0.0;
+        const double magnitude = std::fabs(coefficient);
+        if (first) {
+            if (negative) oss << "-";
+        } else {
+            oss << (negative ? " - " : " + ");
+        }
+        if (factor.empty()) {
+            oss << literal(magnitude);
+        } else if (std::fabs(magnitude - 1.0) < 1e-12) {
+            oss << factor;
+        } else {
+            oss << literal(magnitude) << "*" << factor;
+        }
+        first = false;
+    }
+    return first ? "0.0f" : oss.str();
+}
+
+std::string polynomialSource(const std::vector<std::pair<double, std::string>>& prefix, double constant,
+                             const std::array<double, 3>& linear, const std::array<double, 6>& quadratic,
+                             const bool active[3]) {
+    std::vector<std::pair<double, std::string>> terms = prefix;
+    terms.emplace_back(constant, "");
+    for (int d = 0; d < 3; ++d) {
+        if (active[d]) terms.emplace_back(linear[d], AXIS_U[d]);
+    }
+    for (int q = 0; q < 6; ++q) {
+        if (active[QUAD_AXES[q][0]] && active[QUAD_AXES[q][1]]) {
+            terms.emplace_back(quadratic[q], std::string(AXIS_U[QUAD_AXES[q][0]]) + "*" + AXIS_U[QUAD_AXES[q][1]]);
+        }
+    }
+    return linearCombination(terms);
+}
+
+std::string monomialName(const std::array<uint8_t, 3>& exponents) {
+    std::string name;
+    for (int d = 0; d < 3; ++d) {
+        name.append(exponents[d], AXIS_NAME[d]);
+    }
+    return name.empty() ? "1" : name;
+}
+
+} // namespace
+
+const char* collisionModelName(CollisionModel model) {
+    switch (model) {
+        case CollisionModel::BGK: return "bgk";
+        case CollisionModel::MRT_RAW: return "mrt_raw";
+        case CollisionModel::MRT_CENTRAL: return "mrt_central";
+        case CollisionModel::CUMULANT: return "cumulant";
+    }
+    return "unknown";
+}
+
+CollisionModel parseCollisionModel(const std::string& name) {
+    for (CollisionModel model : {CollisionModel::BGK, CollisionModel::MRT_RAW,
+                                 CollisionModel::MRT_CENTRAL, CollisionModel::CUMULANT}) {
+        if (name == collisionModelName(model)) {
+            return model;
+        }
+    }
+    throw std::invalid_argument("Unknown collision model '" + name +
+                                "' (expected bgk, mrt_raw, mrt_central or cumulant)");
+}
+
+int MomentBasis::find(uint8_t a, uint8_t b, uint8_t c) const {
+    for (size_t k = 0; k < exponents.size(); ++k) {
+        if (exponents[k][0] == a && exponents[k][1] == b && exponents[k][2] == c) {
+            return static_cast<int>(k);
+        }
+    }
+    return -1;
+}
+
+CollisionGenerator::CollisionGenerator(const LatticeDescriptor& lattice)
+    : m_name(lattice.name),
+      m_velocities(lattice.stencil_vectors),
+      m_weights(lattice.weights),
+      m_cs2(lattice.cs2) {
+    if (!lattice.validate() || m_cs2 <= 0.0) {
+        throw std::invalid_argument("CollisionGenerator: lattice '" + m_name + "' is not valid");
+    }
+    for (const auto& c : m_velocities) {
+        for (int d = 0; d < 3; ++d) {
+            if (c[d] < -1 || c[d] > 1) {
+                throw std::invalid_argument("CollisionGenerator: lattice '" + m_name +
+                                            "' has velocities beyond one cell");
+            }
+            m_axis_active[d] = m_axis_active[d] || c[d] != 0;
+        }
+    }
+
+    buildBasis();
+    buildEquilibrium();
+    if (m_basis.closed) {
+        buildShift();
+        buildPartitions();
+    }
+}
+
+void CollisionGenerator::buildBasis() {
+    const size_t q = m_velocities.size();
+
+    std::vector<std::array<uint8_t, 3>> candidates;
+    for (uint8_t a = 0; a <= (m_axis_active[0] ? 2 : 0); ++a) {
+        for (uint8_t b = 0; b <= (m_axis_active[1] ? 2 : 0); ++b) {
+            for (uint8_t c = 0; c <= (m_axis_active[2] ? 2 : 0); ++c) {
+                candidates.push_back({a, b, c});
+            }
+        }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [](const auto& lhs, const auto& rhs) {
+        const int lo = lhs[0] + lhs[1] + lhs[2];
+        const int ro = rhs[0] + rhs[1] + rhs[2];
+        return lo != ro ? lo < ro : lhs > rhs;
+    });
+
+    // Greedy by order: keep a monomial if it is independent of those kept
+    std::vector<std::vector<double>> orthonormal;
+    for (const auto& exponents : candidates) {
+        if (m_basis.size() == q) break;
+        std::vector<int8_t> row(q);
+        std::vector<double> residual(q);
+        for (size_t i = 0; i < q; ++i) {
+            int value = 1;
+            for (int d = 0; d < 3; ++d) {
+                for (int p = 0; p < exponents[d]; ++p) value *= m_velocities[i][d];
+            }
+            row[i] = static_cast<int8_t>(value);
+            residual[i] = value;
+        }
+        for (const auto& basis_row : orthonormal) {
+            double dot = 0.0;
+            for (size_t i = 0; i < q; ++i) dot += residual[i] * basis_row[i];
+            for (size_t i = 0; i < q; ++i) residual[i] -= dot * basis_row[i];
+        }
+        double norm = 0.0;
+        for (double v : residual) norm += v * v;
+        if (norm < 1e-9) continue;
+        norm = std::sqrt(norm);
+        for (double& v : residual) v /= norm;
+        orthonormal.push_back(std::move(residual));
+        m_basis.exponents.push_back(exponents);
+        m_basis.matrix.insert(m_basis.matrix.end(), row.begin(), row.end());
+    }
+    if (m_basis.size() != q) {
+        throw std::invalid_argument("CollisionGenerator: lattice '" + m_name + "' has no moment basis of size " +
+                                    std::to_string(q));
+    }
+
+    // Gauss-Jordan with partial pivoting
+    std::vector<double> work(m_basis.matrix.begin(), m_basis.matrix.end());
+    m_basis.inverse.assign(q * q, 0.0);
+    for (size_t i = 0; i < q; ++i) m_basis.inverse[i * q + i] = 1.0;
+    for (size_t col = 0; col < q; ++col) {
+        size_t pivot = col;
+        for (size_t r = col + 1; r < q; ++r) {
+            if (std::fabs(work[r * q + col]) > std::fabs(work[pivot * q + col])) pivot = r;
+        }
+        if (pivot != col) {
+            for (size_t j = 0; j < q; ++j) {
+                std::swap(work[pivot * q + j], work[col * q + j]);
+                std::swap(m_basis.inverse[pivot * q + j], m_basis.inverse[col * q + j]);
+            }
+        }
+        const double scale = 1.0 / work[col * q + col];
+        for (size_t j = 0; j < q; ++j) {
+            work[col * q + j] *= scale;
+            m_basis.inverse[col * q + j] *= scale;
+        }
+        for (size_t r = 0; r < q; ++r) {
+            const double factor = work[r * q + col];
+            if (r == col || factor == 0.0) continue;
+            for (size_t j = 0; j < q; ++j) {
+                work[r * q + j] -= factor * work[col * q + j];
+                m_basis.inverse[r * q + j] -= factor * m_basis.inverse[col * q + j];
+            }
+        }
+    }
+    // Entries are small rationals; drop the elimination noise
+    for (double& v : m_basis.inverse) {
+        if (std::fabs(v) < 1e-12) v = 0.0;
+    }
+
+    m_inverse_rows.assign(q, {});
+    for (size_t i = 0; i < q; ++i) {
+        for (size_t k = 0; k < q; ++k) {
+            if (m_basis.inverse[i * q + k] != 0.0) {
+                m_inverse_rows[i].push_back({static_cast<int>(k), m_basis.inverse[i * q + k]});
+            }
+        }
+    }
+
+    m_basis.closed = true;
+    for (const auto& e : m_basis.exponents) {
+        for (uint8_t a = 0; a <= e[0]; ++a) {
+            for (uint8_t b = 0; b <= e[1]; ++b) {
+                for (uint8_t c = 0; c <= e[2]; ++c) {
+                    if (m_basis.find(a, b, c) < 0) m_basis.closed = false;
+                }
+            }
+        }
+    }
+
+    for (int d = 0; d < 3; ++d) {
+        std::array<uint8_t, 3> unit{0, 0, 0};
+        unit[d] = 1;
+        m_momentum[d] = m_basis.find(unit[0], unit[1], unit[2]);
+        unit[d] = 2;
+        const int diagonal = m_basis.find(unit[0], unit[1], unit[2]);
+        if (diagonal >= 0) m_diagonal.push_back(diagonal);
+    }
+}
+
+void CollisionGenerator::buildEquilibrium() {
+    const size_t q = m_velocities.size();
+
+    // f_eq / rho = w (1 + c·u/cs2 + (c·u)²/(2 cs2²) - u²/(2 cs2))
+    m_population_eq.assign(q, {});
+    for (size_t i = 0; i < q; ++i) {
+        const auto& c = m_velocities[i];
+        const double w = m_weights[i];
+        EquilibriumPolynomial& eq = m_population_eq[i];
+        eq.constant = w;
+        for (int d = 0; d < 3; ++d) {
+            eq.linear[d] = w * c[d] / m_cs2;
+        }
+        for (int qd = 0; qd < 6; ++qd) {
+            const int d = QUAD_AXES[qd][0];
+            const int e = QUAD_AXES[qd][1];
+            eq.quadratic[qd] = d == e ? w * (c[d] * c[d] / (2.0 * m_cs2 * m_cs2) - 1.0 / (2.0 * m_cs2))
+                                      : w * c[d] * c[e] / (m_cs2 * m_cs2);
+        }
+    }
+
+    m_moment_eq.assign(q, {});
+    for (size_t k = 0; k < q; ++k) {
+        EquilibriumPolynomial& eq = m_moment_eq[k];
+        for (size_t i = 0; i < q; ++i) {
+            const double entry = m_basis.matrix[k * q + i];
+            if (entry == 0.0) continue;
+            eq.constant += entry * m_population_eq[i].constant;
+            for (int d = 0; d < 3; ++d) eq.linear[d] += entry * m_population_eq[i].linear[d];
+            for (int qd = 0; qd < 6; ++qd) eq.quadratic[qd] += entry * m_population_eq[i].quadratic[qd];
+        }
+    }
+}
+
+void CollisionGenerator::buildShift() {
+    // (c - u)^e = Σ binomial · c^e' · (-u)^(e - e'), per axis
+    m_shift.assign(m_basis.size(), {});
+    for (size_t k = 0; k < m_basis.size(); ++k) {
+        if (m_basis.order(k) < 2) continue;
+        const auto& e = m_basis.exponents[k];
+        for (uint8_t a = 0; a <= e[0]; ++a) {
+            for (uint8_t b = 0; b <= e[1]; ++b) {
+                for (uint8_t c = 0; c <= e[2]; ++c) {
+                    ShiftTerm term;
+                    term.coefficient = binomial(e[0], a) * binomial(e[1], b) * binomial(e[2], c);
+                    term.powers = {static_cast<uint8_t>(e[0] - a), static_cast<uint8_t>(e[1] - b),
+                                   static_cast<uint8_t>(e[2] - c)};
+                    term.source = m_basis.find(a, b, c);
+                    m_shift[k].push_back(term);
+                }
+            }
+        }
+    }
+}
+
+void CollisionGenerator::buildPartitions() {
+    // Moments and cumulants of a distribution over its set partitions:
+    //   m_n = Σ_π Π_B C_B,   C_n = Σ_π (-1)^(|π|-1) (|π|-1)! Π_B m_B
+    // Central moments have no first-order part, so blocks of one drop out.
+    m_to_cumulant.assign(m_basis.size(), {});
+    m_from_cumulant.assign(m_basis.size(), {});
+    for (size_t k = 0; k < m_basis.size(); ++k) {
+        if (m_basis.order(k) < 2) continue;
+
+        std::vector<int> axes;
+        for (int d = 0; d < 3; ++d) axes.insert(axes.end(), m_basis.exponents[k][d], d);
+        const size_t n = axes.size();
+
+        std::map<std::vector<int>, std::pair<double, double>> terms;  // Blocks -> (to, from)
+        std::vector<size_t> assignment(n, 0);  // Restricted growth string
+        while (true) {
+            const size_t num_blocks = *std::max_element(assignment.begin(), assignment.end()) + 1;
+            std::vector<std::array<uint8_t, 3>> block_exponents(num_blocks, {0, 0, 0});
+            std::vector<size_t> block_sizes(num_blocks, 0);
+            for (size_t p = 0; p < n; ++p) {
+                ++block_exponents[assignment[p]][axes[p]];
+                ++block_sizes[assignment[p]];
+            }
+            if (std::none_of(block_sizes.begin(), block_sizes.end(), [](size_t s) { return s == 1; })) {
+                std::vector<int> blocks;
+                for (const auto& be : block_exponents) blocks.push_back(m_basis.find(be[0], be[1], be[2]));
+                std::sort(blocks.begin(), blocks.end());
+                double factorial = 1.0;
+                for (size_t j = 2; j < num_blocks; ++j) factorial *= static_cast<double>(j);
+                auto& term = terms[blocks];
+                term.first += (num_blocks % 2 ? 1.0 : -1.0) * factorial;
+                term.second += 1.0;
+            }
+
+            // Next restricted growth string
+            size_t p = n;
+            while (p-- > 1) {
+                const size_t prefix_max = *std::max_element(assignment.begin(), assignment.begin() + p);
+                if (assignment[p] <= prefix_max) {
+                    ++assignment[p];
+                    std::fill(assignment.begin() + p + 1, assignment.end(), 0);
+                    break;
+                }
+            }
+            if (p == 0) break;
+        }
+        for (const auto& [blocks, coefficients] : terms) {
+            m_to_cumulant[k].push_back({coefficients.first, blocks});
+            m_from_cumulant[k].push_back({coefficients.second, blocks});
+        }
+    }
+}
+
+double CollisionGenerator::centralEquilibrium(size_t k) const {
+    double value = 1.0;
+    for (int d = 0; d < 3; ++d) {
+        const uint8_t e = m_basis.exponents[k][d];
+        if (e % 2) return 0.0;
+        if (e == 2) value *= m_cs2;
+    }
+    return value;
+}
+
+double CollisionGenerator::cumulantEquilibrium(size_t k) const {
+    return std::find(m_diagonal.begin(), m_diagonal.end(), static_cast<int>(k)) != m_diagonal.end() ? m_cs2 : 0.0;
+}
+
+bool CollisionGenerator::supports(CollisionModel model) const {
+    return m_basis.closed || model == CollisionModel::BGK || model == CollisionModel::MRT_RAW;
+}
+
+std::string CollisionGenerator::functionName(const std::string& lattice, CollisionModel model) {
+    return lattice + "_collide_" + collisionModelName(model);
+}
+
+std::string CollisionGenerator::generate(CollisionModel model) const {
+    if (!supports(model)) {
+        throw std::invalid_argument(std::string("CollisionGenerator: ") + collisionModelName(model) +
+                                    " needs a closed moment basis, which lattice '" + m_name + "' lacks");
+    }
+    const size_t q = m_velocities.size();
+    const std::string guard = "FL_COLLIDE_" + m_name + "_" + collisionModelName(model);
+    std::ostringstream oss;
+
+    oss << "#ifndef " << guard << "\n#define " << guard << "\n";
+    oss << "// " << collisionModelName(model) << " collision for " << m_name << " (generated)\n";
+    oss << "float " << functionName(m_name, model)
+        << "(float* f, float omega, float omega_bulk, float omega_high) {\n";
+
+    // Raw moments; entries of M are ±1. BGK only needs the conserved ones
+    for (size_t k = 0; k < q; ++k) {
+        if (model == CollisionModel::BGK && m_basis.order(k) > 1) continue;
+        std::vector<std::pair<double, std::string>> terms;
+        for (size_t i = 0; i < q; ++i) {
+            terms.emplace_back(m_basis.matrix[k * q + i], "f[" + std::to_string(i) + "]");
+        }
+        oss << "    float m" << k << " = " << linearCombination(terms) << ";  // "
+            << monomialName(m_basis.exponents[k]) << "\n";
+    }
+    oss << "    const float rho = m0;\n";
+    oss << "    const float inv_rho = 1.0f / rho;\n";
+    for (int d = 0; d < 3; ++d) {
+        if (m_axis_active[d]) {
+            oss << "    const float " << AXIS_U[d] << " = m" << m_momentum[d] << " * inv_rho;\n";
+        }
+    }
+
+    if (model == CollisionModel::BGK) {
+        oss << "    (void)omega_bulk; (void)omega_high;\n";
+        for (size_t i = 0; i < q; ++i) {
+            const auto& eq = m_population_eq[i];
+            oss << "    f[" << i << "] += omega * (rho * ("
+                << polynomialSource({}, eq.constant, eq.linear, eq.quadratic, m_axis_active) << ") - f[" << i
+                << "]);\n";
+        }
+        oss << "    return rho;\n}\n#endif\n";
+        return oss.str();
+    }
+
+    // Relaxed variables: raw, central or normalized cumulant, with their equilibria
+    std::string var = "m";
+    std::vector<std::string> equilibrium(q);
+    if (model == CollisionModel::MRT_RAW) {
+        for (size_t k = 0; k < q; ++k) {
+            if (m_basis.order(k) < 2) continue;
+            const auto& eq = m_moment_eq[k];
+            equilibrium[k] = "rho * (" + polynomialSource({}, eq.constant, eq.linear, eq.quadratic, m_axis_active) + ")";
+        }
+    } else {
+        var = model == CollisionModel::MRT_CENTRAL ? "k" : "c";
+        for (size_t k = 0; k < q; ++k) {
+            if (m_basis.order(k) < 2) continue;
+            std::vector<std::pair<double, std::string>> terms;
+            for (const auto& term : m_shift[k]) {
+                const int source_order = m_basis.order(term.source);
+                const double sign = (term.powers[0] + term.powers[1] + term.powers[2]) % 2 ? -1.0 : 1.0;
+                std::string factor = uProduct(term.powers);
+                factor += std::string(factor.empty() ? "" : "*") + (source_order == 0 ? "rho" : "m" + std::to_string(term.source));
+                terms.emplace_back(sign * term.coefficient, factor);
+            }
+            oss << "    float k" << k << " = " << linearCombination(terms) << ";\n";
+            equilibrium[k] = model == CollisionModel::MRT_CENTRAL ? linearCombination({{centralEquilibrium(k), "rho"}})
+                                                                  : literal(cumulantEquilibrium(k));
+        }
+        if (model == CollisionModel::CUMULANT) {
+            for (size_t k = 0; k < q; ++k) {
+                if (m_basis.order(k) < 2) continue;
+                oss << "    const float n" << k << " = k" << k << " * inv_rho;\n";
+            }
+            for (size_t k = 0; k < q; ++k) {
+                if (m_basis.order(k) < 2) continue;
+                std::vector<std::pair<double, std::string>> terms;
+                for (const auto& term : m_to_cumulant[k]) {
+                    std::string factor;
+                    for (int block : term.blocks) factor += (factor.empty() ? "n" : "*n") + std::to_string(block);
+                    terms.emplace_back(term.coefficient, factor);
+                }
+                oss << "    float c" << k << " = " << linearCombination(terms) << ";\n";
+            }
+        }
+    }
+
+    // Trace of the second order with omega_bulk, deviators with omega
+    if (!m_diagonal.empty()) {
+        std::vector<std::pair<double, std::string>> terms;
+        for (int k : m_diagonal) {
+            terms.emplace_back(1.0, "(" + var + std::to_string(k) + " - " + equilibrium[k] + ")");
+        }
+        oss << "    const float trace = (" << linearCombination(terms) << ") * "
+            << literal(1.0 / static_cast<double>(m_diagonal.size())) << ";\n";
+    }
+    for (size_t k = 0; k < q; ++k) {
+        const int order = m_basis.order(k);
+        if (order < 2) continue;
+        const std::string v = var + std::to_string(k);
+        const bool diagonal = std::find(m_diagonal.begin(), m_diagonal.end(), static_cast<int>(k)) != m_diagonal.end();
+        if (diagonal) {
+            oss << "    " << v << " -= omega * (" << v << " - " << equilibrium[k] << " - trace) + omega_bulk * trace;\n";
+        } else if (equilibrium[k] == "0.0f") {
+            oss << "    " << v << " -= " << (order == 2 ? "omega" : "omega_high") << " * " << v << ";\n";
+        } else {
+            oss << "    " << v << " -= " << (order == 2 ? "omega" : "omega_high") << " * (" << v << " - "
+                << equilibrium[k] << ");\n";
+        }
+    }
+
+    if (model == CollisionModel::CUMULANT) {
+        for (size_t k = 0; k < q; ++k) {
+            if (m_basis.order(k) < 2) continue;
+            std::vector<std::pair<double, std::string>> terms;
+            for (const auto& term : m_from_cumulant[k]) {
+                std::string factor;
+                for (int block : term.blocks) factor += (factor.empty() ? "c" : "*c") + std::to_string(block);
+                terms.emplace_back(term.coefficient, factor);
+            }
+            oss << "    k" << k << " = rho * (" << linearCombination(terms) << ");\n";
+        }
+    }
+    if (model != CollisionModel::MRT_RAW) {
+        // Back to raw moments: c^e = Σ binomial · (c - u)^e' · u^(e - e')
+        for (size_t k = 0; k < q; ++k) {
+            if (m_basis.order(k) < 2) continue;
+            std::vector<std::pair<double, std::string>> terms;
+            for (const auto& term : m_shift[k]) {
+                const int source_order = m_basis.order(term.source);
+                if (source_order == 1) continue;
+                std::string factor = uProduct(term.powers);
+                factor += std::string(factor.empty() ? "" : "*") + (source_order == 0 ? "rho" : "k" + std::to_string(term.source));
+                terms.emplace_back(term.coefficient, factor);
+            }
+            oss << "    m" << k << " = " << linearCombination(terms) << ";\n";
+        }
+    }
+
+    if (m_diagonal.empty()) {
+        oss << "    (void)omega_bulk;\n";
+    }
+    for (size_t i = 0; i < q; ++i) {
+        std::vector<std::pair<double, std::string>> terms;
+        for (const auto& entry : m_inverse_rows[i]) {
+            terms.emplace_back(entry.value, "m" + std::to_string(entry.index));
+        }
+        oss << "    f[" << i << "] = " << linearCombination(terms) << ";\n";
+    }
+    oss << "    return rho;\n}\n#endif\n";
+    return oss.str();
+}
+
+float CollisionGenerator::collide(CollisionModel model, float* f, const RelaxationRates& rates) const {
+    if (!supports(model)) {
+        throw std::invalid_argument(std::string("CollisionGenerator: ") + collisionModelName(model) +
+                                    " needs a closed moment basis, which lattice '" + m_name + "' lacks");
+    }
+    const size_t q = m_velocities.size();
+
+    std::vector<float> m(q, 0.0f);
+    for (size_t k = 0; k < q; ++k) {
+        for (size_t i = 0; i < q; ++i) {
+            const int8_t entry = m_basis.matrix[k * q + i];
+            if (entry > 0) m[k] += f[i];
+            if (entry < 0) m[k] -= f[i];
+        }
+    }
+    const float rho = m[0];
+    const float inv_rho = 1.0f / rho;
+    float u[3] = {0.0f, 0.0f, 0.0f};
+    for (int d = 0; d < 3; ++d) {
+        if (m_axis_active[d]) u[d] = m[m_momentum[d]] * inv_rho;
+    }
+    auto polynomial = [&](const EquilibriumPolynomial& eq) {
+        float value = static_cast<float>(eq.constant);
+        for (int d = 0; d < 3; ++d) value += static_cast<float>(eq.linear[d]) * u[d];
+        for (int qd = 0; qd < 6; ++qd) {
+            value += static_cast<float>(eq.quadratic[qd]) * u[QUAD_AXES[qd][0]] * u[QUAD_AXES[qd][1]];
+        }
+        return value;
+    };
+
+    if (model == CollisionModel::BGK) {
+        for (size_t i = 0; i < q; ++i) {
+            f[i] += rates.omega * (rho * polynomial(m_population_eq[i]) - f[i]);
+        }
+        return rho;
+    }
+
+    // Same stages as the generated code
+    std::vector<float> v(q, 0.0f);
+    std::vector<float> eq(q, 0.0f);
+    std::vector<float> central(q, 0.0f);
+    for (size_t k = 0; k < q; ++k) {
+        if (m_basis.order(k) < 2) continue;
+        if (model == CollisionModel::MRT_RAW) {
+            v[k] = m[k];
+            eq[k] = rho * polynomial(m_moment_eq[k]);
+            continue;
+        }
+        for (const auto& term : m_shift[k]) {
+            const int source_order = m_basis.order(term.source);
+            const float sign = (term.powers[0] + term.powers[1] + term.powers[2]) % 2 ? -1.0f : 1.0f;
+            central[k] += sign * static_cast<float>(term.coefficient) * uPower(u, term.powers) *
+                          (source_order == 0 ? rho : m[term.source]);
+        }
+        v[k] = central[k];
+        eq[k] = model == CollisionModel::MRT_CENTRAL ? static_cast<float>(centralEquilibrium(k)) * rho
+                                                     : static_cast<float>(cumulantEquilibrium(k));
+    }
+    if (model == CollisionModel::CUMULANT) {
+        std::vector<float> normalized(q, 0.0f);
+        for (size_t k = 0; k < q; ++k) normalized[k] = central[k] * inv_rho;
+        for (size_t k = 0; k < q; ++k) {
+            if (m_basis.order(k) < 2) continue;
+            v[k] = 0.0f;
+            for (const auto& term : m_to_cumulant[k]) {
+                float product = static_cast<float>(term.coefficient);
+                for (int block : term.blocks) product *= normalized[block];
+                v[k] += product;
+            }
+        }
+    }
+
+    float trace = 0.0f;
+    for (int k : m_diagonal) trace += v[k] - eq[k];
+    trace *= static_cast<float>(1.0 / static_cast<double>(std::max<size_t>(1, m_diagonal.size())));
+    for (size_t k = 0; k < q; ++k) {
+        const int order = m_basis.order(k);
+        if (order < 2) continue;
+        if (std::find(m_diagonal.begin(), m_diagonal.end(), static_cast<int>(k)) != m_diagonal.end()) {
+            v[k] -= rates.omega * (v[k] - eq[k] - trace) + rates.omega_bulk * trace;
+        } else {
+            v[k] -= (order == 2 ? rates.omega : rates.omega_high) * (v[k] - eq[k]);
+        }
+    }
+
+    if (model == CollisionModel::MRT_RAW) {
+        for (size_t k = 0; k < q; ++k) {
+            if (m_basis.order(k) >= 2) m[k] = v[k];
+        }
+    } else {
+        if (model == CollisionModel::CUMULANT) {
+            std::vector<float> relaxed(q, 0.0f);
+            for (size_t k = 0; k < q; ++k) {
+                if (m_basis.order(k) < 2) continue;
+                for (const auto& term : m_from_cumulant[k]) {
+                    float product = static_cast<float>(term.coefficient);
+                    for (int block : term.blocks) product *= v[block];
+                    relaxed[k] += product;
+                }
+                relaxed[k] *= rho;
+            }
+            v = std::move(relaxed);
+        }
+        for (size_t k = 0; k < q; ++k) {
+            if (m_basis.order(k) < 2) continue;
+            m[k] = 0.0f;
+            for (const auto& term : m_shift[k]) {
+                const int source_order = m_basis.order(term.source);
+                if (source_order == 1) continue;
+                m[k] += static_cast<float>(term.coefficient) * uPower(u, term.powers) *
+                        (source_order == 0 ? rho : v[term.source]);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < q; ++i) {
+        float value = 0.0f;
+        for (const auto& entry : m_inverse_rows[i]) {
+            value += static_cast<float>(entry.value) * m[entry.index];
+        }
+        f[i] = value;
+    }
+    return rho;
+}
+
+} // namespace codegen
+} // namespace parsing
+} // namespace fluidloom
@@ -1,4 +1,6 @@
 #include "fluidloom/parsing/codegen/OpenCLGenerator.h"
+#include "fluidloom/parsing/codegen/CollisionGenerator.h"
+#include "fluidloom/parsing/registry/LatticeRegistry.h"
 #include <stdexcept>
 
 namespace fluidloom {
@@ -8,6 +10,20 @@ namespace codegen {
 std::string OpenCLGenerator::generateKernel(const ast::KernelAST& kernel) {
     code.str("");  // Clear
     code.clear();
+    collide_function.clear();
+    
+    // Collision operator selected for this kernel
+    if (!kernel.getCollisionModel().empty()) {
+        const CollisionModel model = parseCollisionModel(kernel.getCollisionModel());
+        const auto* lattice = LatticeRegistry::getInstance().get(kernel.getCollisionLattice());
+        if (!lattice) {
+            throw std::invalid_argument("Kernel '" + kernel.getName() + "': unknown lattice '" +
+                                        kernel.getCollisionLattice() + "'");
+        }
+        CollisionGenerator collision(*lattice);
+        code << collision.generate(model) << "\n";
+        collide_function = CollisionGenerator::functionName(lattice->name, model);
+    }
     
     // Kernel signature
     code << "__kernel void " << kernel.getName() << "(\n";
@@ -99,11 +115,22 @@ void OpenCLGenerator::visit(const ast::UnaryExpression& expr) {
 }
 
 void OpenCLGenerator::visit(const ast::CallExpression& expr) {
-    code << expr.function_name << "(";
+    const bool collide = !collide_function.empty() && expr.function_name == "collide";
+    code << (collide ? collide_function : expr.function_name) << "(";
     for (size_t i = 0; i < expr.arguments.size(); ++i) {
         if (i > 0) code << ", ";
         expr.arguments[i]->accept(*this);
     }
+    if (collide) {
+        // omega_bulk defaults to omega, omega_high to full relaxation
+        if (expr.arguments.size() == 2) {
+            code << ", ";
+            expr.arguments[1]->accept(*this);
+        }
+        if (expr.arguments.size() <= 3) {
+            code << ", 1.0f";
+        }
+    }
     code << ")";
 }
 
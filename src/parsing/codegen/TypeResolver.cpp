@@ -26,8 +26,7 @@ public:
     
     void visit(const ast::VariableExpression& expr) override {
         if (symbol_table) {
-            auto sym = symbol_table->lookup(expr.name);
-            if (sym.has_value()) {
+            if (const auto* sym = symbol_table->find(expr.symbol)) {
                 result_type = sym->type;
                 return;
             }
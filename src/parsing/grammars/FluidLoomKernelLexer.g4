@@ -8,6 +8,7 @@ READS: 'reads';
 WRITES: 'writes';
 HALO: 'halo';
 EXECUTION_MASK: 'execution_mask';
+COLLISION: 'collision';
 INLINE: 'inline';
 SCRIPT: 'script';
 OPPOSITE: 'opposite';
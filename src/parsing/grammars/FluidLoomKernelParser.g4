@@ -31,7 +31,7 @@ kernelDefinition
     ;
 
 kernelParameters
-    : (readsClause | writesClause | haloClause | executionMaskClause | COMMA)*
+    : (readsClause | writesClause | haloClause | executionMaskClause | collisionClause | COMMA)*
     ;
 
 readsClause
@@ -50,6 +50,11 @@ executionMaskClause
     : EXECUTION_MASK COLON STRING
     ;
 
+// collision: cumulant(D3Q19) - operator behind collide() in the script
+collisionClause
+    : COLLISION COLON IDENTIFIER LPAREN IDENTIFIER RPAREN
+    ;
+
 fieldList
     : IDENTIFIER (COMMA IDENTIFIER)*
     ;
@@ -5,6 +5,7 @@ import FluidLoomKernelLexer;
 // Simulation-specific keywords
 IMPORT: 'import';
 FIELD: 'field';
+TRANSIENT: 'transient';
 INITIAL_CONDITION: 'initial_condition';
 TIME_LOOP: 'time_loop';
 FINAL_OUTPUT: 'final_output';
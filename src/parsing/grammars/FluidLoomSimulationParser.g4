@@ -13,7 +13,7 @@ importSection
     ;
 
 fieldDeclaration
-    : FIELD IDENTIFIER COLON fieldType SEMI?
+    : TRANSIENT? FIELD IDENTIFIER COLON fieldType SEMI?
     ;
 
 fieldType
@@ -11,22 +11,36 @@ ConstantRegistry& ConstantRegistry::getInstance() {
 }
 
 void ConstantRegistry::add(const ConstantDescriptor& desc) {
+    SymbolId symbol = intern(desc.name);
     std::lock_guard<std::mutex> lock(mutex_);
-    if (constants.find(desc.name) != constants.end()) {
+    if (findLocked(symbol)) {
         throw std::runtime_error("Constant already registered: " + desc.name);
     }
-    constants[desc.name] = desc;
+    if (slot_by_symbol.size() <= symbol) {
+        slot_by_symbol.resize(symbol + 1, 0);
+    }
+    constants.push_back(desc);
+    slot_by_symbol[symbol] = static_cast<uint32_t>(constants.size());
+}
+
+const ConstantDescriptor* ConstantRegistry::findLocked(SymbolId symbol) const {
+    if (symbol >= slot_by_symbol.size() || slot_by_symbol[symbol] == 0) {
+        return nullptr;
+    }
+    return &constants[slot_by_symbol[symbol] - 1];
 }
 
 const ConstantDescriptor* ConstantRegistry::get(const std::string& name) const {
+    return get(StringInterner::instance().find(name));
+}
+
+const ConstantDescriptor* ConstantRegistry::get(SymbolId symbol) const {
     std::lock_guard<std::mutex> lock(mutex_);
-    auto it = constants.find(name);
-    return (it != constants.end()) ? &it->second : nullptr;
+    return findLocked(symbol);
 }
 
 bool ConstantRegistry::exists(const std::string& name) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return constants.find(name) != constants.end();
+    return get(name) != nullptr;
 }
 
 bool ConstantRegistry::validate() const {
@@ -37,9 +51,9 @@ bool ConstantRegistry::validate() const {
     };
     
     std::lock_guard<std::mutex> lock(mutex_);
-    for (const auto& [name, desc] : constants) {
+    for (const auto& desc : constants) {
         for (const auto& res : reserved) {
-            if (name == res) {
+            if (desc.name == res) {
                 return false;
             }
         }
@@ -50,14 +64,15 @@ bool ConstantRegistry::validate() const {
 void ConstantRegistry::clear() {
     std::lock_guard<std::mutex> lock(mutex_);
     constants.clear();
+    slot_by_symbol.clear();
 }
 
 std::string ConstantRegistry::toString() const {
     std::lock_guard<std::mutex> lock(mutex_);
     std::ostringstream oss;
     oss << "ConstantRegistry: " << constants.size() << " constants\n";
-    for (const auto& [name, desc] : constants) {
-        oss << "  " << name << " = ";
+    for (const auto& desc : constants) {
+        oss << "  " << desc.name << " = ";
         if (desc.type == ConstantDescriptor::Type::FLOAT) {
             oss << desc.value.f << "f";
         } else {
@@ -72,7 +87,7 @@ std::string ConstantRegistry::generateOpenCLDefines() const {
     std::lock_guard<std::mutex> lock(mutex_);
     std::ostringstream oss;
     oss << "// Auto-generated constant definitions\n\n";
-    for (const auto& [name, desc] : constants) {
+    for (const auto& desc : constants) {
         oss << desc.getOpenCLDefine();
     }
     return oss.str();
@@ -1,6 +1,8 @@
 #include "fluidloom/parsing/semantic/SemanticAnalyzer.h"
 #include "fluidloom/parsing/ast/ExpressionAST.h"
 #include "fluidloom/parsing/ast/StatementAST.h"
+#include "fluidloom/parsing/codegen/CollisionGenerator.h"
+#include "fluidloom/parsing/registry/LatticeRegistry.h"
 #include <sstream>
 
 namespace fluidloom {
@@ -32,9 +34,8 @@ bool SemanticAnalyzer::analyzeKernel(const ast::KernelAST& kernel) {
     // Add read fields to symbol table
     for (const auto& field_name : kernel.getReadFields()) {
         if (field_registry) {
-            auto field_opt = field_registry->lookupByName(field_name);
-            if (field_opt.has_value()) {
-                symbol_table.addField(field_name, field_opt->num_components);
+            if (const auto* field = field_registry->find(StringInterner::instance().find(field_name))) {
+                symbol_table.addField(field_name, field->num_components);
             } else {
                 addError("Field '" + field_name + "' not found in registry");
             }
@@ -48,9 +49,8 @@ bool SemanticAnalyzer::analyzeKernel(const ast::KernelAST& kernel) {
     for (const auto& field_name : kernel.getWriteFields()) {
         if (!symbol_table.exists(field_name)) {
             if (field_registry) {
-                auto field_opt = field_registry->lookupByName(field_name);
-                if (field_opt.has_value()) {
-                    symbol_table.addField(field_name, field_opt->num_components);
+                if (const auto* field = field_registry->find(StringInterner::instance().find(field_name))) {
+                    symbol_table.addField(field_name, field->num_components);
                 } else {
                     addError("Field '" + field_name + "' not found in registry");
                 }
@@ -60,6 +60,11 @@ bool SemanticAnalyzer::analyzeKernel(const ast::KernelAST& kernel) {
         }
     }
     
+    // Collision operator must exist for the lattice
+    if (!kernel.getCollisionModel().empty()) {
+        validateCollision(kernel);
+    }
+    
     // Analyze statements
     symbol_table.enterScope();
     for (const auto& stmt : kernel.getStatements()) {
@@ -76,18 +81,19 @@ bool SemanticAnalyzer::validateFieldReferences(const ast::KernelAST& kernel) {
         return true;
     }
     
+    // Names are looked up without interning: a misspelt field must not grow
+    // the interner, and a name never interned cannot be registered
+    
     // Check read fields
     for (const auto& field_name : kernel.getReadFields()) {
-        auto field_opt = field_registry->lookupByName(field_name);
-        if (!field_opt.has_value()) {
+        if (!field_registry->find(StringInterner::instance().find(field_name))) {
             addError("Read field '" + field_name + "' not found in FieldRegistry");
         }
     }
     
     // Check write fields
     for (const auto& field_name : kernel.getWriteFields()) {
-        auto field_opt = field_registry->lookupByName(field_name);
-        if (!field_opt.has_value()) {
+        if (!field_registry->find(StringInterner::instance().find(field_name))) {
             addError("Write field '" + field_name + "' not found in FieldRegistry");
         }
     }
@@ -95,6 +101,26 @@ bool SemanticAnalyzer::validateFieldReferences(const ast::KernelAST& kernel) {
     return errors.empty();
 }
 
+bool SemanticAnalyzer::validateCollision(const ast::KernelAST& kernel) {
+    const size_t errors_before = errors.size();
+    const auto* lattice = LatticeRegistry::getInstance().get(kernel.getCollisionLattice());
+    if (!lattice) {
+        addError("Collision lattice '" + kernel.getCollisionLattice() + "' not found in LatticeRegistry");
+        return false;
+    }
+    try {
+        const codegen::CollisionModel model = codegen::parseCollisionModel(kernel.getCollisionModel());
+        codegen::CollisionGenerator generator(*lattice);
+        if (!generator.supports(model)) {
+            addError(std::string("Collision model '") + codegen::collisionModelName(model) +
+                     "' is not available on lattice '" + lattice->name + "'");
+        }
+    } catch (const std::invalid_argument& e) {
+        addError(e.what());
+    }
+    return errors.size() == errors_before;
+}
+
 uint8_t SemanticAnalyzer::computeHaloDepth(const ast::KernelAST& kernel) {
     // For now, just return the declared halo depth
     // In a full implementation, this would analyze neighbor accesses
@@ -7,32 +7,34 @@ namespace symbol_table {
 // Scope implementation
 
 bool Scope::addSymbol(const Symbol& symbol) {
-    // Check if symbol already exists in this scope
-    if (symbols.find(symbol.name) != symbols.end()) {
-        return false;  // Symbol already defined
+    SymbolId id = symbol.id != INVALID_SYMBOL ? symbol.id : intern(symbol.name);
+    auto [it, inserted] = symbols.emplace(id, symbol);
+    if (inserted) {
+        it->second.id = id;
     }
-    
-    symbols[symbol.name] = symbol;
-    return true;
+    return inserted;  // false if already defined in this scope
 }
 
-std::optional<Symbol> Scope::lookup(const std::string& name) const {
-    // Check this scope
-    auto it = symbols.find(name);
-    if (it != symbols.end()) {
-        return it->second;
+const Symbol* Scope::find(SymbolId id) const {
+    for (const Scope* scope = this; scope; scope = scope->parent) {
+        auto it = scope->symbols.find(id);
+        if (it != scope->symbols.end()) {
+            return &it->second;
+        }
     }
-    
-    // Check parent scope
-    if (parent) {
-        return parent->lookup(name);
+    return nullptr;
+}
+
+std::optional<Symbol> Scope::lookup(const std::string& name) const {
+    const Symbol* symbol = find(StringInterner::instance().find(name));
+    if (symbol) {
+        return *symbol;
     }
-    
     return std::nullopt;
 }
 
 std::optional<Symbol> Scope::lookupLocal(const std::string& name) const {
-    auto it = symbols.find(name);
+    auto it = symbols.find(StringInterner::instance().find(name));
     if (it != symbols.end()) {
         return it->second;
     }
@@ -101,7 +103,7 @@ bool SymbolTable::addVariable(const std::string& name, SymbolType type) {
 }
 
 bool SymbolTable::exists(const std::string& name) const {
-    return lookup(name).has_value();
+    return find(StringInterner::instance().find(name)) != nullptr;
 }
 
 void SymbolTable::reset() {
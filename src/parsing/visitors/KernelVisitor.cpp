@@ -0,0 +1,396 @@
+#include "fluidloom/parsing/visitors/KernelVisitor.h"
+
+// ANTLR includes
+#include "antlr4-runtime.h"
+#include "FluidLoomKernelLexer.h"
+#include "FluidLoomKernelParser.h"
+
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace fluidloom {
+namespace parsing {
+
+namespace {
+
+using KP = FluidLoomKernelParser;
+using ExprPtr = std::shared_ptr<ast::Expression>;
+using StmtPtr = std::shared_ptr<ast::Statement>;
+
+// Collects syntax errors instead of printing them to stderr
+class ErrorCollector : public antlr4::BaseErrorListener {
+public:
+    explicit ErrorCollector(std::vector<ParseError>& errors) : m_errors(errors) {}
+
+    void syntaxError(antlr4::Recognizer*, antlr4::Token* offending, size_t line, size_t column,
+                     const std::string& msg, std::exception_ptr) override {
+        m_errors.push_back({msg, static_cast<int>(line), static_cast<int>(column),
+                            offending ? offending->getText() : std::string()});
+    }
+
+private:
+    std::vector<ParseError>& m_errors;
+};
+
+[[noreturn]] void unsupported(antlr4::ParserRuleContext* ctx, const std::string& what) {
+    std::ostringstream msg;
+    msg << "Line " << ctx->getStart()->getLine() << ":" << ctx->getStart()->getCharPositionInLine()
+        << " - " << what << ": " << ctx->getText();
+    throw std::runtime_error(msg.str());
+}
+
+template <typename Node>
+std::shared_ptr<Node> located(std::shared_ptr<Node> node, antlr4::ParserRuleContext* ctx) {
+    node->loc.line = ctx->getStart()->getLine();
+    node->loc.column = ctx->getStart()->getCharPositionInLine();
+    node->loc.length = ctx->getText().size();
+    return node;
+}
+
+size_t tokenType(antlr4::tree::ParseTree* tree) {
+    auto* terminal = dynamic_cast<antlr4::tree::TerminalNode*>(tree);
+    return terminal ? terminal->getSymbol()->getType() : antlr4::Token::INVALID_TYPE;
+}
+
+std::string unquote(const std::string& text) {
+    if (text.size() >= 2 && text.front() == '"' && text.back() == '"') {
+        return text.substr(1, text.size() - 2);
+    }
+    return text;
+}
+
+std::vector<std::string> fieldNames(KP::FieldListContext* ctx) {
+    std::vector<std::string> names;
+    for (auto* id : ctx->IDENTIFIER()) names.push_back(id->getText());
+    return names;
+}
+
+ast::BinaryExpression::Op binaryOp(size_t token) {
+    using Op = ast::BinaryExpression::Op;
+    switch (token) {
+        case KP::PLUS: return Op::ADD;
+        case KP::MINUS: return Op::SUB;
+        case KP::STAR: return Op::MUL;
+        case KP::SLASH: return Op::DIV;
+        case KP::PERCENT: return Op::MOD;
+        case KP::CARET: return Op::POW;
+        case KP::EQ: return Op::EQ;
+        case KP::NE: return Op::NE;
+        case KP::LT: return Op::LT;
+        case KP::LE: return Op::LE;
+        case KP::GT: return Op::GT;
+        case KP::GE: return Op::GE;
+        case KP::AND: return Op::AND;
+        case KP::OR: return Op::OR;
+        default: throw std::logic_error("Token is not a binary operator");
+    }
+}
+
+// Builds expression and statement nodes in the kernel's AstArena
+class NodeBuilder {
+public:
+    explicit NodeBuilder(ast::AstArena& node_arena) : arena(node_arena) {}
+
+    // Left-folds "operand (op operand)*" rules; children alternate operand and operator
+    template <typename OperandCtx>
+    ExprPtr foldBinary(antlr4::ParserRuleContext* ctx, ExprPtr (NodeBuilder::*build)(OperandCtx*)) {
+        ExprPtr result = (this->*build)(dynamic_cast<OperandCtx*>(ctx->children[0]));
+        for (size_t i = 1; i + 1 < ctx->children.size(); i += 2) {
+            ExprPtr right = (this->*build)(dynamic_cast<OperandCtx*>(ctx->children[i + 1]));
+            result = located(arena.make<ast::BinaryExpression>(binaryOp(tokenType(ctx->children[i])),
+                                                               std::move(result), std::move(right)),
+                             ctx);
+        }
+        return result;
+    }
+
+    std::vector<ExprPtr> buildArguments(KP::ArgumentListContext* ctx) {
+        // Argument names are documentation only; calls bind by position
+        std::vector<ExprPtr> args;
+        if (ctx) {
+            for (auto* arg : ctx->argument()) args.push_back(buildExpression(arg->expression()));
+        }
+        return args;
+    }
+
+    ExprPtr buildVectorLiteral(KP::VectorLiteralContext* ctx) {
+        std::vector<ExprPtr> elements;
+        for (auto* expr : ctx->expression()) elements.push_back(buildExpression(expr));
+        if (elements.size() == 1) return elements.front();  // Parenthesized expression
+        return located(arena.make<ast::VectorLiteralExpression>(std::move(elements)), ctx);
+    }
+
+    ExprPtr buildLambda(KP::LambdaExpressionContext* ctx) {
+        std::vector<std::string> params;
+        if (ctx->parameterList()) {
+            for (auto* id : ctx->parameterList()->IDENTIFIER()) params.push_back(id->getText());
+        }
+        return located(arena.make<ast::LambdaExpression>(std::move(params), buildExpression(ctx->expression())),
+                       ctx);
+    }
+
+    ExprPtr buildLiteral(KP::LiteralContext* ctx) {
+        if (ctx->FLOAT()) {
+            return located(arena.make<ast::LiteralExpression>(std::stod(ctx->FLOAT()->getText())), ctx);
+        }
+        if (ctx->INTEGER()) {
+            return located(arena.make<ast::LiteralExpression>(
+                               static_cast<int64_t>(std::stoll(ctx->INTEGER()->getText()))), ctx);
+        }
+        if (ctx->TRUE() || ctx->FALSE()) {
+            return located(arena.make<ast::LiteralExpression>(ctx->TRUE() != nullptr), ctx);
+        }
+        if (ctx->vectorLiteral()) return buildVectorLiteral(ctx->vectorLiteral());
+        unsupported(ctx, "String literals are not valid in kernel expressions");
+    }
+
+    ExprPtr buildPrimary(KP::PrimaryExpressionContext* ctx) {
+        if (ctx->literal()) return buildLiteral(ctx->literal());
+        if (ctx->lambdaExpression()) return buildLambda(ctx->lambdaExpression());
+        if (ctx->expression()) return buildExpression(ctx->expression());
+        // Identifiers, built-in variables and math function names
+        return located(arena.make<ast::VariableExpression>(ctx->getText()), ctx);
+    }
+
+    ExprPtr buildPostfix(KP::PostfixExpressionContext* ctx) {
+        ExprPtr result = buildPrimary(ctx->primaryExpression());
+        size_t expr_index = 0;
+        size_t list_index = 0;
+        for (size_t i = 1; i < ctx->children.size(); ++i) {
+            switch (tokenType(ctx->children[i])) {
+                case KP::DOT: {
+                    std::string member = ctx->children[++i]->getText();
+                    auto* var = dynamic_cast<ast::VariableExpression*>(result.get());
+                    if (var && var->component.empty()) {
+                        result = located(arena.make<ast::VariableExpression>(var->name, std::move(member)), ctx);
+                    } else {
+                        result = located(arena.make<ast::MemberExpression>(std::move(result), std::move(member)), ctx);
+                    }
+                    break;
+                }
+                case KP::LBRACK:
+                    result = located(arena.make<ast::SubscriptExpression>(
+                                         std::move(result), buildExpression(ctx->expression(expr_index++))),
+                                     ctx);
+                    i += 2;  // expression RBRACK
+                    break;
+                case KP::LPAREN: {
+                    auto* callee = dynamic_cast<ast::VariableExpression*>(result.get());
+                    if (!callee || !callee->component.empty()) unsupported(ctx, "Only named functions can be called");
+                    KP::ArgumentListContext* args = nullptr;
+                    if (tokenType(ctx->children[i + 1]) != KP::RPAREN) {
+                        args = ctx->argumentList(list_index++);
+                        ++i;
+                    }
+                    ++i;  // RPAREN
+                    result = located(arena.make<ast::CallExpression>(callee->name, buildArguments(args)), ctx);
+                    break;
+                }
+                default:
+                    unsupported(ctx, "Unexpected postfix operator");
+            }
+        }
+        return result;
+    }
+
+    ExprPtr buildUnary(KP::UnaryExpressionContext* ctx) {
+        if (ctx->postfixExpression()) return buildPostfix(ctx->postfixExpression());
+        ExprPtr operand = buildUnary(ctx->unaryExpression());
+        if (ctx->PLUS()) return operand;
+        auto op = ctx->MINUS() ? ast::UnaryExpression::Op::NEG : ast::UnaryExpression::Op::NOT;
+        return located(arena.make<ast::UnaryExpression>(op, std::move(operand)), ctx);
+    }
+
+    ExprPtr buildPower(KP::PowerExpressionContext* ctx) {
+        return foldBinary<KP::UnaryExpressionContext>(ctx, &NodeBuilder::buildUnary);
+    }
+
+    ExprPtr buildMultiplicative(KP::MultiplicativeExpressionContext* ctx) {
+        return foldBinary<KP::PowerExpressionContext>(ctx, &NodeBuilder::buildPower);
+    }
+
+    ExprPtr buildAdditive(KP::AdditiveExpressionContext* ctx) {
+        return foldBinary<KP::MultiplicativeExpressionContext>(ctx, &NodeBuilder::buildMultiplicative);
+    }
+
+    ExprPtr buildRelational(KP::RelationalExpressionContext* ctx) {
+        return foldBinary<KP::AdditiveExpressionContext>(ctx, &NodeBuilder::buildAdditive);
+    }
+
+    ExprPtr buildEquality(KP::EqualityExpressionContext* ctx) {
+        return foldBinary<KP::RelationalExpressionContext>(ctx, &NodeBuilder::buildRelational);
+    }
+
+    ExprPtr buildLogicalAnd(KP::LogicalAndExpressionContext* ctx) {
+        return foldBinary<KP::EqualityExpressionContext>(ctx, &NodeBuilder::buildEquality);
+    }
+
+    ExprPtr buildLogicalOr(KP::LogicalOrExpressionContext* ctx) {
+        return foldBinary<KP::LogicalAndExpressionContext>(ctx, &NodeBuilder::buildLogicalAnd);
+    }
+
+    ExprPtr buildExpression(KP::ExpressionContext* ctx) {
+        return buildLogicalOr(ctx->logicalOrExpression());
+    }
+
+    // Statements
+    std::vector<StmtPtr> buildBlock(KP::BlockStatementContext* ctx) {
+        std::vector<StmtPtr> body;
+        for (auto* stmt : ctx->scriptStatement()) body.push_back(buildStatement(stmt));
+        return body;
+    }
+
+    StmtPtr buildAssignment(KP::AssignmentStatementContext* ctx) {
+        const auto ids = ctx->IDENTIFIER();
+        ExprPtr target = ids.size() > 1
+            ? located(arena.make<ast::VariableExpression>(ids[0]->getText(), ids[1]->getText()), ctx)
+            : located(arena.make<ast::VariableExpression>(ids[0]->getText()), ctx);
+        size_t value_index = 0;
+        if (ctx->LBRACK()) {
+            target = located(arena.make<ast::SubscriptExpression>(std::move(target),
+                                                                  buildExpression(ctx->expression(0))),
+                             ctx);
+            value_index = 1;
+        }
+        return located(arena.make<ast::AssignmentStatement>(std::move(target),
+                                                            buildExpression(ctx->expression(value_index))),
+                       ctx);
+    }
+
+    StmtPtr buildFor(KP::ForStatementContext* ctx) {
+        auto* range = ctx->rangeExpression();
+        return located(arena.make<ast::ForStatement>(ctx->IDENTIFIER()->getText(),
+                                                     buildExpression(range->expression(0)),
+                                                     buildExpression(range->expression(1)),
+                                                     buildBlock(ctx->blockStatement())),
+                       ctx);
+    }
+
+    StmtPtr buildIf(KP::IfStatementContext* ctx) {
+        std::vector<StmtPtr> else_branch;
+        if (ctx->ELSE()) else_branch = buildBlock(ctx->blockStatement(1));
+        return located(arena.make<ast::IfStatement>(buildExpression(ctx->expression()),
+                                                    buildBlock(ctx->blockStatement(0)), std::move(else_branch)),
+                       ctx);
+    }
+
+    StmtPtr buildReduce(KP::ReduceStatementContext* ctx) {
+        auto op = ctx->REDUCE_MIN() ? ast::ReduceStatement::Op::MIN
+                : ctx->REDUCE_MAX() ? ast::ReduceStatement::Op::MAX
+                                    : ast::ReduceStatement::Op::SUM;
+        return located(arena.make<ast::ReduceStatement>(op, buildExpression(ctx->expression())), ctx);
+    }
+
+    StmtPtr buildPlaceGeometry(KP::PlaceGeometryStatementContext* ctx) {
+        auto stmt = arena.make<ast::PlaceGeometryStatement>();
+        if (ctx->STRING()) {
+            stmt->geometry_file = unquote(ctx->STRING()->getText());
+        } else {
+            stmt->implicit_function = buildLambda(ctx->implicitGeometry()->lambdaExpression());
+        }
+        for (auto* param : ctx->transformParams()->transformParam()) {
+            if (param->SURFACE_MATERIAL()) {
+                stmt->surface_material = param->IDENTIFIER()->getText();
+            } else if (param->AT()) {
+                stmt->position = buildVectorLiteral(param->vectorLiteral());
+            } else if (param->SCALE()) {
+                stmt->scale = buildVectorLiteral(param->vectorLiteral());
+            } else {
+                stmt->rotation = buildVectorLiteral(param->vectorLiteral());
+            }
+        }
+        return located(std::move(stmt), ctx);
+    }
+
+    StmtPtr buildStatement(KP::ScriptStatementContext* ctx) {
+        if (ctx->assignmentStatement()) return buildAssignment(ctx->assignmentStatement());
+        if (ctx->forStatement()) return buildFor(ctx->forStatement());
+        if (ctx->ifStatement()) return buildIf(ctx->ifStatement());
+        if (ctx->runStatement()) {
+            return located(arena.make<ast::RunStatement>(ctx->runStatement()->IDENTIFIER()->getText()), ctx);
+        }
+        if (ctx->reduceStatement()) return buildReduce(ctx->reduceStatement());
+        return buildPlaceGeometry(ctx->placeGeometryStatement());
+    }
+
+private:
+    ast::AstArena& arena;
+};
+
+// ---------------------------------------------------------------------------
+// Kernel definitions
+// ---------------------------------------------------------------------------
+
+std::shared_ptr<ast::KernelAST> buildKernel(KP::KernelDefinitionContext* ctx) {
+    auto kernel = std::make_shared<ast::KernelAST>(ctx->IDENTIFIER()->getText());
+    kernel->loc.line = ctx->getStart()->getLine();
+    kernel->loc.column = ctx->getStart()->getCharPositionInLine();
+
+    // A repeated clause overrides the earlier one
+    auto* params = ctx->kernelParameters();
+    for (auto* reads : params->readsClause()) kernel->setReadFields(fieldNames(reads->fieldList()));
+    for (auto* writes : params->writesClause()) kernel->setWriteFields(fieldNames(writes->fieldList()));
+    for (auto* halo : params->haloClause()) {
+        const unsigned long depth = std::stoul(halo->INTEGER()->getText());
+        if (depth > std::numeric_limits<uint8_t>::max()) unsupported(halo, "Halo depth out of range");
+        kernel->setHaloDepth(static_cast<uint8_t>(depth));
+    }
+    for (auto* mask : params->executionMaskClause()) {
+        kernel->setExecutionMask(unquote(mask->STRING()->getText()));
+    }
+    // collision: <model>(<lattice>)
+    for (auto* collision : params->collisionClause()) {
+        kernel->setCollision(collision->IDENTIFIER(0)->getText(), collision->IDENTIFIER(1)->getText());
+    }
+
+    // The body's nodes live in the kernel's arena
+    NodeBuilder builder(kernel->arena);
+    std::vector<StmtPtr> statements;
+    for (auto* stmt : ctx->scriptBlock()->scriptStatement()) statements.push_back(builder.buildStatement(stmt));
+    kernel->setStatements(std::move(statements));
+    return kernel;
+}
+
+} // namespace
+
+void KernelVisitor::parseString(const std::string& source) {
+    m_kernels.clear();
+    m_errors.clear();
+
+    antlr4::ANTLRInputStream input(source);
+    FluidLoomKernelLexer lexer(&input);
+    antlr4::CommonTokenStream tokens(&lexer);
+    FluidLoomKernelParser parser(&tokens);
+
+    ErrorCollector collector(m_errors);
+    lexer.removeErrorListeners();
+    lexer.addErrorListener(&collector);
+    parser.removeErrorListeners();
+    parser.addErrorListener(&collector);
+
+    auto* file = parser.kernelFile();
+    if (!m_errors.empty()) {
+        std::string message = "Kernel parse failed:";
+        for (const auto& error : m_errors) message += "\n" + error.toString();
+        throw std::runtime_error(message);
+    }
+
+    for (auto* definition : file->kernelDefinition()) {
+        m_kernels.push_back(buildKernel(definition));
+    }
+}
+
+void KernelVisitor::parseFile(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file) {
+        throw std::runtime_error("Cannot open kernel file: " + filename);
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    parseString(buffer.str());
+}
+
+} // namespace parsing
+} // namespace fluidloom
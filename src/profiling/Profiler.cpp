@@ -34,25 +34,29 @@ void Profiler::setOutputPath(const std::string& path) {
     m_output_path = path;
 }
 
-void Profiler::beginEvent(const std::string& name, const std::string& category) {
+long long Profiler::timestampUs() {
     auto now = std::chrono::steady_clock::now();
-    long long ts = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+    return std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+}
+
+void Profiler::beginEvent(const std::string& name, const std::string& category, const TraceArgs& args) {
+    long long ts = timestampUs();
 
     std::lock_guard<std::mutex> lock(m_mutex);
-    m_events.push_back({name, category, "B", ts, 0, std::this_thread::get_id(), m_pid});
+    m_events.push_back({name, category, "B", ts, 0, std::this_thread::get_id(), m_pid, args});
 }
 
 void Profiler::endEvent(const std::string& name, const std::string& category) {
-    auto now = std::chrono::steady_clock::now();
-    long long ts = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+    long long ts = timestampUs();
 
     std::lock_guard<std::mutex> lock(m_mutex);
-    m_events.push_back({name, category, "E", ts, 0, std::this_thread::get_id(), m_pid});
+    m_events.push_back({name, category, "E", ts, 0, std::this_thread::get_id(), m_pid, {}});
 }
 
-void Profiler::recordCompleteEvent(const std::string& name, const std::string& category, long long start_us, long long duration_us) {
+void Profiler::recordCompleteEvent(const std::string& name, const std::string& category, long long start_us, long long duration_us,
+                                   const TraceArgs& args) {
     std::lock_guard<std::mutex> lock(m_mutex);
-    m_events.push_back({name, category, "X", start_us, duration_us, std::this_thread::get_id(), m_pid});
+    m_events.push_back({name, category, "X", start_us, duration_us, std::this_thread::get_id(), m_pid, args});
 }
 
 void Profiler::flush() {
@@ -78,6 +82,13 @@ void Profiler::flush() {
         if (e.phase == "X") {
             file << "\"dur\": " << e.duration_us << ", ";
         }
+        if (!e.args.empty()) {
+            file << "\"args\": {";
+            for (size_t k = 0; k < e.args.size(); ++k) {
+                file << (k ? ", " : "") << "\"" << e.args[k].first << "\": \"" << e.args[k].second << "\"";
+            }
+            file << "}, ";
+        }
         file << "\"pid\": " << e.pid << ", ";
         
         // Thread ID hash
@@ -95,9 +106,9 @@ void Profiler::flush() {
     m_events.clear();
 }
 
-ScopedEvent::ScopedEvent(const std::string& name, const std::string& category)
+ScopedEvent::ScopedEvent(const std::string& name, const std::string& category, const TraceArgs& args)
     : m_name(name), m_category(category) {
-    Profiler::getInstance().beginEvent(m_name, m_category);
+    Profiler::getInstance().beginEvent(m_name, m_category, args);
 }
 
 ScopedEvent::~ScopedEvent() {
@@ -0,0 +1,177 @@
+#include "fluidloom/runtime/ExecutionGraph.h"
+#include "fluidloom/runtime/dependency/DependencyGraph.h"
+#include "fluidloom/runtime/dependency/HazardAnalyzer.h"
+#include "fluidloom/runtime/executor/WorkStealingExecutor.h"
+#include "fluidloom/common/Logger.h"
+#include "fluidloom/profiling/Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+#ifdef __APPLE__
+#include <OpenCL/opencl.h>
+#else
+#include <CL/cl.h>
+#endif
+
+namespace fluidloom {
+namespace runtime {
+
+ExecutionGraph::ExecutionGraph() = default;
+ExecutionGraph::~ExecutionGraph() = default;
+
+void ExecutionGraph::execute() {
+    profiling::ScopedEvent step("step", "step");
+    if (!m_step_observer) {
+        for (auto& node : m_nodes) {
+            profiling::ScopedEvent span(node->getName(), ExecutionNode::traceCategory(node->getType()));
+            // Returned events belong to the caller; the queue orders the work
+            cl_event event = node->execute(nullptr);
+            if (event) clReleaseEvent(event);
+        }
+        return;
+    }
+    
+    using clock = std::chrono::steady_clock;
+    auto step_start = clock::now();
+    clock::duration waiting{0};
+    
+    // Device work enqueued since the last drain. Nodes may enqueue on
+    // different queues, so every returned event is waited on and released
+    std::vector<cl_event> outstanding;
+    auto drain = [&outstanding] {
+        if (outstanding.empty()) return;
+        clWaitForEvents(static_cast<cl_uint>(outstanding.size()), outstanding.data());
+        for (cl_event event : outstanding) {
+            clReleaseEvent(event);
+        }
+        outstanding.clear();
+    };
+    
+    for (auto& node : m_nodes) {
+        profiling::ScopedEvent span(node->getName(), ExecutionNode::traceCategory(node->getType()));
+        const auto type = node->getType();
+        const bool waits_on_peers = type == ExecutionNode::NodeType::HALO_EXCHANGE ||
+                                    type == ExecutionNode::NodeType::BARRIER ||
+                                    type == ExecutionNode::NodeType::REBALANCE_MESH;
+        if (!waits_on_peers) {
+            cl_event event = node->execute(nullptr);
+            if (event) outstanding.push_back(event);
+            continue;
+        }
+        
+        drain();
+        auto start = clock::now();
+        cl_event event = node->execute(nullptr);
+        if (event) {
+            clWaitForEvents(1, &event);
+            clReleaseEvent(event);
+        }
+        waiting += clock::now() - start;
+    }
+    drain();
+    
+    std::chrono::duration<float, std::milli> busy = clock::now() - step_start - waiting;
+    m_step_observer(busy.count());
+}
+
+bool ExecutionGraph::execute(executor::WorkStealingExecutor& executor) {
+    const auto& graph = getDependencyGraph();
+    profiling::ScopedEvent step("step", "step");
+    return executor.execute(graph);
+}
+
+void ExecutionGraph::addNode(std::shared_ptr<ExecutionNode> node) {
+    if (node->getId() < 0) {
+        node->setId(static_cast<int64_t>(m_nodes.size()));
+    }
+    m_nodes.push_back(node);
+    m_dependency_graph.reset();
+}
+
+const dependency::DependencyGraph& ExecutionGraph::getDependencyGraph() {
+    if (!m_dependency_graph) {
+        buildDependencyGraph();
+    }
+    return *m_dependency_graph;
+}
+
+std::vector<std::pair<uint32_t, uint32_t>> ExecutionGraph::getDependencyEdges() {
+    const auto& graph = getDependencyGraph();
+    
+    // Hazards and fences can both order the same pair; keep one edge
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+    for (size_t i = 0; i < graph.getNodeCount(); ++i) {
+        for (size_t succ : graph.getSuccessors(i)) {
+            edges.emplace_back(static_cast<uint32_t>(i), static_cast<uint32_t>(succ));
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    return edges;
+}
+
+void ExecutionGraph::setDependencyEdges(const std::vector<std::pair<uint32_t, uint32_t>>& edges) {
+    for (const auto& [from, to] : edges) {
+        if (from >= m_nodes.size() || to >= m_nodes.size() || from == to) {
+            throw std::invalid_argument("Dependency edge out of range");
+        }
+    }
+    
+    for (auto& node : m_nodes) {
+        node->clearEdges();
+    }
+    for (const auto& [from, to] : edges) {
+        m_nodes[from]->addSuccessor(m_nodes[to]);
+        m_nodes[to]->addPredecessor(m_nodes[from]);
+    }
+    
+    try {
+        m_dependency_graph = std::make_unique<dependency::DependencyGraph>(m_nodes);
+    } catch (const std::runtime_error&) {
+        throw std::invalid_argument("Dependency edges contain a cycle");
+    }
+    
+    FL_LOG(INFO) << "ExecutionGraph: " << m_dependency_graph->getNodeCount() << " nodes, "
+                 << m_dependency_graph->getNumEdges() << " edges (precomputed)";
+}
+
+void ExecutionGraph::buildDependencyGraph() {
+    // Edges from a previous build would otherwise be duplicated or go stale
+    for (auto& node : m_nodes) {
+        node->clearEdges();
+    }
+    auto nodes = m_nodes;
+    
+    dependency::HazardAnalyzer analyzer(std::make_shared<dependency::FieldVersionTracker>());
+    auto hazards = analyzer.analyzeNodes(nodes);
+    analyzer.enforceHazards(nodes, hazards);
+    
+    // Nodes without declared fields keep their serial position
+    size_t num_fences = 0;
+    for (size_t k = 0; k < nodes.size(); ++k) {
+        if (!nodes[k]->getReadFields().empty() || !nodes[k]->getWriteFields().empty()) {
+            continue;
+        }
+        ++num_fences;
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            if (i < k) {
+                nodes[i]->addSuccessor(nodes[k]);
+                nodes[k]->addPredecessor(nodes[i]);
+            } else if (i > k) {
+                nodes[k]->addSuccessor(nodes[i]);
+                nodes[i]->addPredecessor(nodes[k]);
+            }
+        }
+    }
+    
+    m_dependency_graph = std::make_unique<dependency::DependencyGraph>(std::move(nodes));
+    
+    FL_LOG(INFO) << "ExecutionGraph: " << m_dependency_graph->getNodeCount() << " nodes, "
+                 << m_dependency_graph->getNumEdges() << " edges (" << hazards.size()
+                 << " hazards, " << num_fences << " fences)";
+}
+
+} // namespace runtime
+} // namespace fluidloom
@@ -0,0 +1,252 @@
+#include "fluidloom/runtime/dependency/FieldLivenessAnalyzer.h"
+#include "fluidloom/common/Logger.h"
+#include <algorithm>
+#include <cstdint>
+
+namespace fluidloom {
+namespace runtime {
+namespace dependency {
+
+namespace {
+
+using Bitset = std::vector<uint64_t>;
+
+bool testBit(const Bitset& bits, size_t i) {
+    return (bits[i / 64] >> (i % 64)) & 1;
+}
+
+// Matches the SOAFieldManager allocation granularity
+size_t alignedCellBytes(const fields::FieldDescriptor& desc) {
+    return (desc.bytesPerCell() + 63) & ~size_t(63);
+}
+
+} // namespace
+
+bool FieldLivenessAnalyzer::AliasPlan::sharesBuffer(const std::string& a, const std::string& b) const {
+    auto it_a = slot_of.find(a);
+    auto it_b = slot_of.find(b);
+    return it_a != slot_of.end() && it_b != slot_of.end() && it_a->second == it_b->second;
+}
+
+FieldLivenessAnalyzer::AliasPlan FieldLivenessAnalyzer::analyze(
+    const DependencyGraph& graph,
+    const std::vector<fields::FieldDescriptor>& fields) {
+
+    lifetimes.clear();
+
+    const size_t num_nodes = graph.getNodeCount();
+    const auto& order = graph.getTopologicalOrder();
+    std::vector<size_t> position(num_nodes);
+    for (size_t k = 0; k < order.size(); ++k) {
+        position[order[k]] = k;
+    }
+
+    // Strict descendants of every node, accumulated in reverse topological order
+    const size_t words = (num_nodes + 63) / 64;
+    std::vector<Bitset> descendants(num_nodes, Bitset(words, 0));
+    for (size_t k = order.size(); k-- > 0;) {
+        size_t node = order[k];
+        for (size_t succ : graph.getSuccessors(node)) {
+            descendants[node][succ / 64] |= uint64_t(1) << (succ % 64);
+            for (size_t w = 0; w < words; ++w) {
+                descendants[node][w] |= descendants[succ][w];
+            }
+        }
+    }
+
+    // Accessing nodes per field
+    std::unordered_map<std::string, std::vector<size_t>> accessors;
+    std::unordered_set<std::string> exchanged;
+    for (size_t i = 0; i < num_nodes; ++i) {
+        const auto& node = graph.getNode(i);
+        bool is_halo = node->getType() == nodes::ExecutionNode::NodeType::HALO_EXCHANGE;
+        for (const auto* list : {&node->getReadFields(), &node->getWriteFields()}) {
+            for (const auto& field : *list) {
+                auto& nodes_of_field = accessors[field];
+                if (nodes_of_field.empty() || nodes_of_field.back() != i) {
+                    nodes_of_field.push_back(i);
+                }
+                if (is_halo) {
+                    exchanged.insert(field);
+                }
+            }
+        }
+    }
+
+    // A precedes B if every accessor of A is a strict ancestor of every accessor of B
+    auto precedes = [&](const std::vector<size_t>& a, const std::vector<size_t>& b) {
+        for (size_t from : a) {
+            for (size_t to : b) {
+                if (!testBit(descendants[from], to)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+
+    AliasPlan plan;
+    std::vector<size_t> transient_fields;  // Indices into fields
+
+    for (size_t f = 0; f < fields.size(); ++f) {
+        const auto& desc = fields[f];
+        FieldLifetime lifetime;
+        lifetime.field_name = desc.name;
+        plan.bytes_per_cell_before += alignedCellBytes(desc);
+
+        auto it = accessors.find(desc.name);
+        if (it != accessors.end()) {
+            lifetime.accessed = true;
+            lifetime.first_access = num_nodes;
+            for (size_t node : it->second) {
+                lifetime.first_access = std::min(lifetime.first_access, position[node]);
+                lifetime.last_access = std::max(lifetime.last_access, position[node]);
+            }
+        }
+
+        if (pinned_fields.count(desc.name)) {
+            lifetime.exclusion_reason = "pinned";
+        } else if (desc.halo_depth > 0 || exchanged.count(desc.name)) {
+            lifetime.exclusion_reason = "halo exchange";
+        } else if (desc.is_visualization_field) {
+            lifetime.exclusion_reason = "visualization output";
+        } else if (desc.is_mask || desc.is_material) {
+            lifetime.exclusion_reason = "mesh state";
+        } else if (!lifetime.accessed) {
+            lifetime.exclusion_reason = "not accessed";
+        } else if (!desc.is_transient && !infer_transient) {
+            lifetime.exclusion_reason = "not marked transient";
+        } else {
+            // First accesses: accessors without an accessing ancestor
+            const auto& nodes_of_field = it->second;
+            bool live_in = false;
+            for (size_t node : nodes_of_field) {
+                bool is_first = std::none_of(nodes_of_field.begin(), nodes_of_field.end(), [&](size_t other) {
+                    return other != node && testBit(descendants[other], node);
+                });
+                if (is_first && graph.getNode(node)->readsField(desc.name)) {
+                    live_in = true;
+                    break;
+                }
+            }
+            if (live_in) {
+                lifetime.exclusion_reason = "read before written";
+                if (desc.is_transient) {
+                    FL_LOG(WARN) << "Field '" << desc.name
+                                 << "' is marked transient but read before it is written; keeping a dedicated buffer";
+                }
+            } else {
+                lifetime.transient = true;
+                transient_fields.push_back(f);
+            }
+        }
+
+        if (!lifetime.transient) {
+            plan.dedicated.push_back(desc.name);
+            plan.bytes_per_cell_after += alignedCellBytes(desc);
+        }
+        lifetimes.push_back(std::move(lifetime));
+    }
+
+    // Greedy interval colouring in lifetime order
+    std::stable_sort(transient_fields.begin(), transient_fields.end(), [&](size_t a, size_t b) {
+        if (lifetimes[a].first_access != lifetimes[b].first_access) {
+            return lifetimes[a].first_access < lifetimes[b].first_access;
+        }
+        return lifetimes[a].last_access < lifetimes[b].last_access;
+    });
+
+    struct Slot {
+        std::vector<size_t> members;
+        size_t bytes = 0;
+    };
+    std::vector<Slot> slots;
+
+    for (size_t f : transient_fields) {
+        const auto& field_accessors = accessors.at(fields[f].name);
+        const size_t bytes = alignedCellBytes(fields[f]);
+
+        // Slot members form a chain, so following the last one suffices.
+        // Pick the slot that grows least, then the one that wastes least.
+        size_t best = slots.size();
+        size_t best_growth = 0;
+        size_t best_waste = 0;
+        for (size_t s = 0; s < slots.size(); ++s) {
+            const auto& last = accessors.at(fields[slots[s].members.back()].name);
+            if (!precedes(last, field_accessors)) {
+                continue;
+            }
+            size_t growth = bytes > slots[s].bytes ? bytes - slots[s].bytes : 0;
+            size_t waste = slots[s].bytes > bytes ? slots[s].bytes - bytes : 0;
+            if (best == slots.size() || growth < best_growth ||
+                (growth == best_growth && waste < best_waste)) {
+                best = s;
+                best_growth = growth;
+                best_waste = waste;
+            }
+        }
+
+        if (best == slots.size()) {
+            slots.emplace_back();
+        }
+        slots[best].members.push_back(f);
+        slots[best].bytes = std::max(slots[best].bytes, bytes);
+    }
+
+    for (size_t s = 0; s < slots.size(); ++s) {
+        std::vector<std::string> names;
+        for (size_t f : slots[s].members) {
+            names.push_back(fields[f].name);
+            plan.slot_of[fields[f].name] = s;
+        }
+        plan.slots.push_back(std::move(names));
+        plan.bytes_per_cell_after += slots[s].bytes;
+    }
+
+    FL_LOG(INFO) << "FieldLivenessAnalyzer: " << transient_fields.size() << " transient fields in "
+                 << slots.size() << " buffers, " << plan.dedicated.size() << " dedicated; "
+                 << plan.bytes_per_cell_before << " -> " << plan.bytes_per_cell_after << " bytes/cell";
+
+    return plan;
+}
+
+std::unordered_map<std::string, fields::FieldHandle> FieldLivenessAnalyzer::allocate(
+    fields::SOAFieldManager& manager,
+    const AliasPlan& plan,
+    const std::vector<fields::FieldDescriptor>& fields,
+    size_t num_cells) {
+
+    std::unordered_map<std::string, const fields::FieldDescriptor*> by_name;
+    for (const auto& desc : fields) {
+        by_name[desc.name] = &desc;
+    }
+
+    std::unordered_map<std::string, fields::FieldHandle> handles;
+
+    for (const auto& slot : plan.slots) {
+        std::vector<fields::FieldDescriptor> group;
+        for (const auto& name : slot) {
+            auto it = by_name.find(name);
+            if (it != by_name.end()) {
+                group.push_back(*it->second);
+            }
+        }
+        auto group_handles = manager.allocateAliased(group, num_cells);
+        for (size_t i = 0; i < group.size(); ++i) {
+            handles.emplace(group[i].name, group_handles[i]);
+        }
+    }
+
+    // Dedicated fields, plus any descriptor the plan did not cover
+    for (const auto& desc : fields) {
+        if (handles.find(desc.name) == handles.end()) {
+            handles.emplace(desc.name, manager.allocate(desc, num_cells));
+        }
+    }
+
+    return handles;
+}
+
+} // namespace dependency
+} // namespace runtime
+} // namespace fluidloom
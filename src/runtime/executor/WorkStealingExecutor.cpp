@@ -0,0 +1,352 @@
+#include "fluidloom/runtime/executor/WorkStealingExecutor.h"
+#include "fluidloom/common/Logger.h"
+#include "fluidloom/profiling/Profiler.h"
+#include <algorithm>
+#include <chrono>
+
+namespace fluidloom {
+namespace runtime {
+namespace executor {
+
+namespace {
+// Identifies pool threads so released nodes go to the releasing worker's deque
+thread_local const WorkStealingExecutor* tls_executor = nullptr;
+thread_local size_t tls_worker = 0;
+}
+
+WorkStealingExecutor::WorkStealingExecutor(size_t num_threads) {
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    workers.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    threads.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+        threads.emplace_back(&WorkStealingExecutor::workerLoop, this, i);
+    }
+
+    FL_LOG(INFO) << "WorkStealingExecutor started with " << num_threads << " threads";
+}
+
+WorkStealingExecutor::~WorkStealingExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stopping = true;
+    }
+    sleep_cv.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+bool WorkStealingExecutor::execute(const dependency::DependencyGraph& dep_graph) {
+    std::lock_guard<std::mutex> run_lock(run_mutex);
+
+    if (!dep_graph.validate()) {
+        FL_LOG(ERROR) << "WorkStealingExecutor: dependency graph is not a valid DAG";
+        return false;
+    }
+
+    const size_t num_nodes = dep_graph.getNodeCount();
+    if (num_nodes == 0) {
+        return true;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    graph = &dep_graph;
+    states.reset(new NodeState[num_nodes]);
+    failed = false;
+    device_error = false;
+    first_error = nullptr;
+
+    for (size_t i = 0; i < num_nodes; ++i) {
+        NodeState& state = states[i];
+        state.owner = this;
+        state.index = i;
+        state.on_host = dep_graph.getNode(i)->getAffinity() == nodes::ExecutionNode::Affinity::HOST;
+        state.remaining = dep_graph.getPredecessors(i).size();
+    }
+    outstanding = num_nodes;
+
+    FL_LOG(DEBUG) << "WorkStealingExecutor executing " << num_nodes << " nodes";
+
+    for (size_t i = 0; i < num_nodes; ++i) {
+        if (dep_graph.getPredecessors(i).empty()) {
+            push(i);
+        }
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(done_mutex);
+        done_cv.wait(lock, [this] { return outstanding.load() == 0; });
+    }
+
+    // Every callback has fired; events can be released
+    for (size_t i = 0; i < num_nodes; ++i) {
+        if (states[i].event) {
+            clReleaseEvent(states[i].event);
+        }
+    }
+    for (cl_event event : owned_events) {
+        clReleaseEvent(event);
+    }
+    for (const auto& join : joins) {
+        clReleaseEvent(join->user_event);
+    }
+    owned_events.clear();
+    joins.clear();
+    states.reset();
+    graph = nullptr;
+
+    auto end = std::chrono::high_resolution_clock::now();
+    last_execution_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+    FL_LOG(DEBUG) << "WorkStealingExecutor completed in " << last_execution_time_ms << " ms";
+
+    if (first_error) {
+        std::rethrow_exception(first_error);
+    }
+    return !device_error;
+}
+
+void WorkStealingExecutor::workerLoop(size_t worker_id) {
+    tls_executor = this;
+    tls_worker = worker_id;
+
+    while (true) {
+        size_t task;
+        if (popLocal(worker_id, task) || steal(worker_id, task)) {
+            runNode(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        sleep_cv.wait(lock, [this] { return stopping || queued_tasks.load() > 0; });
+        if (stopping && queued_tasks.load() == 0) {
+            return;
+        }
+    }
+}
+
+bool WorkStealingExecutor::popLocal(size_t worker_id, size_t& task) {
+    Worker& worker = *workers[worker_id];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty()) {
+        return false;
+    }
+    task = worker.tasks.back();
+    worker.tasks.pop_back();
+    queued_tasks--;
+    return true;
+}
+
+bool WorkStealingExecutor::steal(size_t worker_id, size_t& task) {
+    for (size_t k = 1; k < workers.size(); ++k) {
+        Worker& victim = *workers[(worker_id + k) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            queued_tasks--;
+            steal_count++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingExecutor::push(size_t node_idx) {
+    // Callbacks and the caller thread spread work round-robin
+    size_t target = tls_executor == this ? tls_worker : next_worker++ % workers.size();
+    {
+        std::lock_guard<std::mutex> lock(workers[target]->mutex);
+        workers[target]->tasks.push_back(node_idx);
+    }
+    queued_tasks++;
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+    }
+    sleep_cv.notify_one();
+}
+
+void WorkStealingExecutor::runNode(size_t node_idx) {
+    NodeState& state = states[node_idx];
+    const auto& node = graph->getNode(node_idx);
+
+    cl_event event = nullptr;
+    if (!failed.load()) {
+        try {
+            // Host predecessors are complete; only device events need waiting on
+            cl_event wait_event = state.on_host ? nullptr : joinPredecessors(node_idx);
+
+            state.start_us = profiling::Profiler::timestampUs();
+            auto start = std::chrono::high_resolution_clock::now();
+            event = node->execute(wait_event);
+            auto end = std::chrono::high_resolution_clock::now();
+
+            // Device nodes only enqueue here; their span is closed by eventCallback
+            if (state.on_host) {
+                node->recordExecution(std::chrono::duration<double, std::milli>(end - start).count());
+                profiling::Profiler::getInstance().recordCompleteEvent(
+                    node->getName(), nodes::ExecutionNode::traceCategory(node->getType()), state.start_us,
+                    profiling::Profiler::timestampUs() - state.start_us);
+            }
+        } catch (...) {
+            recordError(std::current_exception(), false);
+            event = nullptr;
+        }
+    }
+
+    state.event = event;
+    onIssued(node_idx);
+
+    if (!event) {
+        onCompleted(node_idx);
+        return;
+    }
+
+    cl_int err = clSetEventCallback(event, CL_COMPLETE, &WorkStealingExecutor::eventCallback, &state);
+    if (err != CL_SUCCESS) {
+        FL_LOG(WARN) << "clSetEventCallback failed (" << err << ") for node " << node->getName()
+                     << "; waiting on host";
+        cl_int status = clWaitForEvents(1, &event);
+        eventCallback(event, status == CL_SUCCESS ? CL_COMPLETE : status, &state);
+    }
+}
+
+cl_event WorkStealingExecutor::joinPredecessors(size_t node_idx) {
+    std::vector<cl_event> events;
+    for (size_t pred : graph->getPredecessors(node_idx)) {
+        if (!states[pred].on_host && states[pred].event) {
+            events.push_back(states[pred].event);
+        }
+    }
+
+    // Parallel hazards (e.g. RAW and WAW on one pair) duplicate edges
+    std::sort(events.begin(), events.end());
+    events.erase(std::unique(events.begin(), events.end()), events.end());
+
+    if (events.empty()) {
+        return nullptr;
+    }
+    if (events.size() == 1) {
+        return events.front();
+    }
+
+    const cl_uint num_events = static_cast<cl_uint>(events.size());
+
+    if (marker_queue) {
+        cl_event marker = nullptr;
+        cl_int err = clEnqueueMarkerWithWaitList(marker_queue, num_events, events.data(), &marker);
+        if (err == CL_SUCCESS) {
+            std::lock_guard<std::mutex> lock(owned_mutex);
+            owned_events.push_back(marker);
+            return marker;
+        }
+        FL_LOG(ERROR) << "clEnqueueMarkerWithWaitList failed: " << err;
+    }
+
+    cl_context context = nullptr;
+    cl_int err = clGetEventInfo(events.front(), CL_EVENT_CONTEXT, sizeof(context), &context, nullptr);
+    cl_event user_event = err == CL_SUCCESS ? clCreateUserEvent(context, &err) : nullptr;
+    if (err != CL_SUCCESS) {
+        clWaitForEvents(num_events, events.data());
+        return nullptr;
+    }
+
+    auto join = std::make_unique<EventJoin>();
+    join->user_event = user_event;
+    join->remaining = events.size();
+    EventJoin* raw_join = join.get();
+    {
+        std::lock_guard<std::mutex> lock(owned_mutex);
+        joins.push_back(std::move(join));
+    }
+
+    for (cl_event event : events) {
+        if (clSetEventCallback(event, CL_COMPLETE, &WorkStealingExecutor::joinCallback, raw_join) != CL_SUCCESS) {
+            cl_int status = clWaitForEvents(1, &event);
+            joinCallback(event, status == CL_SUCCESS ? CL_COMPLETE : status, raw_join);
+        }
+    }
+    return user_event;
+}
+
+bool WorkStealingExecutor::releasesOnIssue(size_t pred_idx, size_t succ_idx) const {
+    return !states[pred_idx].on_host && !states[succ_idx].on_host && states[pred_idx].event != nullptr;
+}
+
+void WorkStealingExecutor::onIssued(size_t node_idx) {
+    for (size_t succ : graph->getSuccessors(node_idx)) {
+        if (releasesOnIssue(node_idx, succ)) {
+            release(succ);
+        }
+    }
+}
+
+void WorkStealingExecutor::onCompleted(size_t node_idx) {
+    for (size_t succ : graph->getSuccessors(node_idx)) {
+        if (!releasesOnIssue(node_idx, succ)) {
+            release(succ);
+        }
+    }
+
+    if (--outstanding == 0) {
+        std::lock_guard<std::mutex> lock(done_mutex);
+        done_cv.notify_all();
+    }
+}
+
+void WorkStealingExecutor::release(size_t node_idx) {
+    if (--states[node_idx].remaining == 0) {
+        push(node_idx);
+    }
+}
+
+void WorkStealingExecutor::recordError(std::exception_ptr error, bool from_device) {
+    std::lock_guard<std::mutex> lock(owned_mutex);
+    failed = true;
+    if (from_device) {
+        device_error = true;
+    } else if (!first_error) {
+        first_error = error;
+    }
+}
+
+void CL_CALLBACK WorkStealingExecutor::eventCallback(cl_event event, cl_int status, void* user_data) {
+    (void)event;
+    auto* state = static_cast<NodeState*>(user_data);
+    WorkStealingExecutor* self = state->owner;
+
+    const auto& node = self->graph->getNode(state->index);
+    if (status < 0) {
+        FL_LOG(ERROR) << "Node " << node->getName() << " failed on device with status " << status;
+        self->recordError(nullptr, true);
+    } else {
+        // Issue to completion; callbacks arrive on the runtime's thread, which
+        // the trace then shows as the device queue's lane
+        profiling::Profiler::getInstance().recordCompleteEvent(
+            node->getName(), nodes::ExecutionNode::traceCategory(node->getType()), state->start_us,
+            profiling::Profiler::timestampUs() - state->start_us);
+    }
+    self->onCompleted(state->index);
+}
+
+void CL_CALLBACK WorkStealingExecutor::joinCallback(cl_event event, cl_int status, void* user_data) {
+    (void)event;
+    auto* join = static_cast<EventJoin*>(user_data);
+    if (status < 0) {
+        join->status = status;
+    }
+    if (--join->remaining == 0) {
+        clSetUserEventStatus(join->user_event, join->status.load());
+    }
+}
+
+} // namespace executor
+} // namespace runtime
+} // namespace fluidloom
@@ -1,5 +1,7 @@
 #include "fluidloom/runtime/nodes/BarrierNode.h"
+#include "fluidloom/runtime/scheduler/ScopedEventTable.h"
 #include "fluidloom/common/Logger.h"
+#include <algorithm>
 
 #ifdef __APPLE__
 #include <OpenCL/opencl.h>
@@ -7,33 +9,126 @@
 #include <CL/cl.h>
 #endif
 
+#ifdef FLUIDLOOM_MPI_ENABLED
+#include <mpi.h>
+#endif
+
 namespace fluidloom {
 namespace runtime {
 namespace nodes {
 
-cl_event BarrierNode::execute(cl_event wait_event) {
-    // For Module 9, simplified implementation
-    // Full implementation will use clEnqueueBarrierWithWaitList
+BarrierNode::BarrierNode(std::string name, BarrierKind barrier_kind, bool global)
+    : ExecutionNode(NodeType::BARRIER, std::move(name)),
+      is_global_barrier(barrier_kind == BarrierKind::LOAD_BALANCE), kind(barrier_kind) {
+    setHaloDepth(0);
+    // Field scope is declared via setReadFields/setWriteFields
     
-    const char* kind_str = "";
+    if (global && !is_global_barrier) {
+        FL_LOG(WARN) << "BarrierNode " << node_name << ": only LOAD_BALANCE barriers are global, "
+                     << kindName(kind) << " demoted to local";
+    }
+}
+
+const char* BarrierNode::kindName(BarrierKind kind) {
     switch (kind) {
-        case BarrierKind::ADAPTATION_PRE: kind_str = "ADAPTATION_PRE"; break;
-        case BarrierKind::ADAPTATION_POST: kind_str = "ADAPTATION_POST"; break;
-        case BarrierKind::LOAD_BALANCE: kind_str = "LOAD_BALANCE"; break;
-        case BarrierKind::USER_REQUESTED: kind_str = "USER_REQUESTED"; break;
-        case BarrierKind::LEVEL_TRANSITION: kind_str = "LEVEL_TRANSITION"; break;
+        case BarrierKind::ADAPTATION_PRE: return "ADAPTATION_PRE";
+        case BarrierKind::ADAPTATION_POST: return "ADAPTATION_POST";
+        case BarrierKind::LOAD_BALANCE: return "LOAD_BALANCE";
+        case BarrierKind::USER_REQUESTED: return "USER_REQUESTED";
+        case BarrierKind::LEVEL_TRANSITION: return "LEVEL_TRANSITION";
+    }
+    return "";
+}
+
+std::vector<cl_event> BarrierNode::collectWaitList(cl_event wait_event) const {
+    std::vector<cl_event> events;
+    
+    // Declared scope: everything the barrier reads or writes
+    std::vector<std::string> scope_fields = read_fields;
+    scope_fields.insert(scope_fields.end(), write_fields.begin(), write_fields.end());
+    
+    if (event_table) {
+        switch (kind) {
+            case BarrierKind::ADAPTATION_PRE:
+            case BarrierKind::ADAPTATION_POST:
+                if (scope_fields.empty()) {
+                    FL_LOG(WARN) << "BarrierNode " << node_name << " (" << kindName(kind)
+                                 << ") declares no fields; nothing to fence";
+                }
+                events = event_table->eventsForFields(scope_fields);
+                break;
+            case BarrierKind::LEVEL_TRANSITION:
+                events = event_table->eventsForLevel(amr_level);
+                break;
+            case BarrierKind::USER_REQUESTED:
+                events = scope_fields.empty() ? event_table->allEvents()
+                                              : event_table->eventsForFields(scope_fields);
+                break;
+            case BarrierKind::LOAD_BALANCE:
+                events = event_table->allEvents();
+                break;
+        }
+    }
+    
+    if (wait_event && std::find(events.begin(), events.end(), wait_event) == events.end()) {
+        events.push_back(wait_event);
+    }
+    
+    return events;
+}
+
+cl_event BarrierNode::execute(cl_event wait_event) {
+    std::vector<cl_event> events = collectWaitList(wait_event);
+    
+    FL_LOG(DEBUG) << "BarrierNode " << node_name << " (" << kindName(kind) << ") waiting on "
+                  << events.size() << " events" << (is_global_barrier ? " [GLOBAL]" : " [LOCAL]");
+    
+    const cl_event* wait_list = events.empty() ? nullptr : events.data();
+    cl_uint num_events = static_cast<cl_uint>(events.size());
+    
+    if (is_global_barrier) {
+        // Drain local work, then synchronize ranks
+        cl_event done = nullptr;
+        if (command_queue) {
+            cl_int err = clEnqueueBarrierWithWaitList(command_queue, num_events, wait_list, &done);
+            if (err != CL_SUCCESS) {
+                FL_LOG(ERROR) << "clEnqueueBarrierWithWaitList failed: " << err;
+                done = nullptr;
+            }
+            clFinish(command_queue);
+        } else if (num_events > 0) {
+            clWaitForEvents(num_events, wait_list);
+        }
+        
+        #ifdef FLUIDLOOM_MPI_ENABLED
+        MPI_Barrier(MPI_COMM_WORLD);
+        #endif
+        
+        return done;
     }
     
-    FL_LOG(INFO) << "BarrierNode " << node_name << " (" << kind_str << ") executing"
-                 << (is_global_barrier ? " [GLOBAL]" : " [LOCAL]");
+    // Scoped barrier: nothing in scope means nothing to wait for
+    if (events.empty()) {
+        return nullptr;
+    }
     
-    // Real implementation would:
-    // 1. If wait_event, wait for it
-    // 2. Enqueue barrier with clEnqueueBarrierWithWaitList
-    // 3. If global, MPI_Barrier
-    // 4. Return completion event
+    if (command_queue) {
+        // A marker only gates commands that wait on it, so unrelated work
+        // already in the queue keeps overlapping
+        cl_event marker = nullptr;
+        cl_int err = clEnqueueMarkerWithWaitList(command_queue, num_events, wait_list, &marker);
+        if (err == CL_SUCCESS) {
+            return marker;
+        }
+        FL_LOG(ERROR) << "clEnqueueMarkerWithWaitList failed: " << err;
+    }
     
-    (void)wait_event;
+    // No queue: a single event can be forwarded, several are joined on the host
+    if (events.size() == 1) {
+        clRetainEvent(events[0]);
+        return events[0];
+    }
+    clWaitForEvents(num_events, wait_list);
     return nullptr;
 }
 
@@ -0,0 +1,25 @@
+#include "fluidloom/runtime/nodes/HostTaskNode.h"
+
+#ifdef __APPLE__
+#include <OpenCL/opencl.h>
+#else
+#include <CL/cl.h>
+#endif
+
+namespace fluidloom {
+namespace runtime {
+namespace nodes {
+
+cl_event HostTaskNode::execute(cl_event wait_event) {
+    if (wait_event) {
+        clWaitForEvents(1, &wait_event);
+    }
+    if (task) {
+        task();
+    }
+    return nullptr;
+}
+
+} // namespace nodes
+} // namespace runtime
+} // namespace fluidloom
@@ -1,4 +1,5 @@
 #include "fluidloom/runtime/nodes/KernelNode.h"
+#include "fluidloom/core/fields/SOAFieldManager.h"
 #include "fluidloom/common/Logger.h"
 
 #ifdef __APPLE__
@@ -25,7 +26,12 @@ void KernelNode::compile(cl_context context, cl_device_id device) {
 }
 
 void KernelNode::bindField(const std::string& field_name, cl_mem buffer) {
-    field_bindings[field_name] = buffer;
+    field_bindings[field_name] = FieldBinding{buffer, nullptr, fields::FieldHandle{0}};
+}
+
+void KernelNode::bindField(const std::string& field_name, fields::SOAFieldManager* manager,
+                           fields::FieldHandle handle) {
+    field_bindings[field_name] = FieldBinding{nullptr, manager, handle};
 }
 
 void KernelNode::setKernel(cl_kernel kernel, cl_context ctx, cl_command_queue queue) {
@@ -47,7 +53,10 @@ cl_event KernelNode::execute(cl_event wait_event) {
     
     // Set kernel arguments from field_bindings
     cl_uint arg_idx = 0;
-    for (const auto& [field_name, buffer] : field_bindings) {
+    for (const auto& [field_name, binding] : field_bindings) {
+        cl_mem buffer = binding.manager
+            ? static_cast<cl_mem>(binding.manager->getDevicePtr(binding.handle))
+            : binding.buffer;
         cl_int err = clSetKernelArg(cl_kernel_handle, arg_idx, sizeof(cl_mem), &buffer);
         if (err != CL_SUCCESS) {
             FL_LOG(ERROR) << "Failed to set kernel argument " << arg_idx 
@@ -61,7 +70,7 @@ cl_event KernelNode::execute(cl_event wait_event) {
     
     // Calculate work sizes
     // Ensure global_work_size is a multiple of local_work_size
-    size_t global_size = global_work_size;
+    size_t global_size = cell_count ? *cell_count : global_work_size;
     size_t local_size = local_work_size;
     
     if (global_size == 0) {
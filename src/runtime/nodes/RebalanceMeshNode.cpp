@@ -1,5 +1,6 @@
 #include "fluidloom/runtime/nodes/RebalanceMeshNode.h"
 #include "fluidloom/common/Logger.h"
+#include <chrono>
 
 namespace fluidloom {
 namespace runtime {
@@ -9,7 +10,7 @@ RebalanceMeshNode::RebalanceMeshNode(
     std::string name,
     load_balance::LoadBalancer* balancer,
     load_balance::CellMigrator* migrator
-) : ExecutionNode(std::move(name)), m_balancer(balancer), m_migrator(migrator) {
+) : ExecutionNode(NodeType::REBALANCE_MESH, std::move(name)), m_balancer(balancer), m_migrator(migrator) {
     
     if (!balancer || !migrator) {
         throw std::invalid_argument("LoadBalancer and CellMigrator cannot be null");
@@ -34,15 +35,38 @@ void RebalanceMeshNode::bindMesh(
     m_num_cells = num_cells;
     m_capacity = capacity;
     
+    // Sizes migration estimates in bytes for the cost-benefit trigger
+    m_balancer->setBytesPerCell(load_balance::CellMigrator::bytesPerCell(num_field_components));
+    
     FL_LOG(INFO) << "RebalanceMeshNode bound to mesh with " << *num_cells << " cells";
 }
 
+void RebalanceMeshNode::bindSpatialIndex(
+    hashmap::HashTableManager* hash_manager,
+    halo::GhostRangeBuilder* ghost_builder,
+    std::vector<uint64_t>* cell_keys,
+    int halo_depth
+) {
+    m_hash_manager = hash_manager;
+    m_ghost_builder = ghost_builder;
+    m_cell_keys = cell_keys;
+    m_halo_depth = halo_depth;
+    
+    // The migrator keeps the key mirror in sync and records the hash delta
+    m_migrator->setCellKeys(cell_keys);
+}
+
 cl_event RebalanceMeshNode::execute(cl_event wait_event) {
     if (!m_num_cells) {
         FL_LOG(ERROR) << "RebalanceMeshNode: mesh not bound";
         return nullptr;
     }
     
+    // Migration reads mesh buffers; producers must have finished
+    if (wait_event) {
+        clWaitForEvents(1, &wait_event);
+    }
+    
     // Increment timestep counter
     m_balancer->incrementTimestep();
     
@@ -55,7 +79,7 @@ cl_event RebalanceMeshNode::execute(cl_event wait_event) {
         return nullptr;  // Skip rebalancing
     }
     
-    FL_LOG(INFO) << "Rebalancing triggered";
+    FL_LOG(INFO) << "Imbalance above threshold, planning migration";
     
     // Compute new split points
     auto new_splits = m_balancer->computeSplitPoints(
@@ -70,10 +94,23 @@ cl_event RebalanceMeshNode::execute(cl_event wait_event) {
         *m_num_cells
     );
     
-    // Execute migration
-    if (plan.isValid() && !plan.transfers.empty()) {
-        FL_LOG(INFO) << "Executing migration plan:\n" << plan.toString();
+    // Collective: every GPU takes the same decision from the gathered costs
+    if (!m_balancer->rebalancePaysOff(cell_counts, plan)) {
+        // Back off a full interval instead of re-planning every step
+        FL_LOG(INFO) << "Rebalancing skipped (migration would not pay for itself)";
+        m_balancer->resetTimestep();
+        return nullptr;
+    }
+    
+    // Execute migration on every GPU, with or without local transfers:
+    // migrate() exchanges outgoing counts so receivers can post receives
+    bool migrated = false;
+    if (plan.isValid()) {
+        if (!plan.transfers.empty()) {
+            FL_LOG(INFO) << "Executing migration plan:\n" << plan.toString();
+        }
         
+        auto start = std::chrono::steady_clock::now();
         m_migrator->migrate(
             plan,
             m_coord_x, m_coord_y, m_coord_z,
@@ -81,27 +118,51 @@ cl_event RebalanceMeshNode::execute(cl_event wait_event) {
             m_fields, m_num_field_components,
             m_num_cells, m_capacity
         );
+        std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        // Bandwidth is measured on what this GPU sent, not the plan's total
+        m_balancer->recordMigration(
+            plan.cellsSentBy(m_balancer->getRank()) * load_balance::CellMigrator::bytesPerCell(m_num_field_components),
+            elapsed.count()
+        );
         
-        // Update current splits
-        m_current_splits = new_splits;
-        
-        // Reset timestep counter
-        m_balancer->resetTimestep();
-        
+        migrated = !m_migrator->getLastDelta().empty();
         FL_LOG(INFO) << "Rebalancing complete: new cell count = " << *m_num_cells;
     } else {
-        FL_LOG(INFO) << "No migration needed (empty plan)";
+        FL_LOG(ERROR) << "Invalid migration plan, cells left in place";
     }
     
-    // TODO: Rebuild hash table and ghost ranges (Phase 4)
-    // This would call:
-    // - hash_manager->rebuildPartial(...)
-    // - ghost_builder->buildGhostRanges(...)
-    // - MPI_Alltoall for ghost range exchange
+    // Splits are global: every GPU adopts them, even without local transfers,
+    // and takes part in the neighbor exchange of ghost ranges
+    refreshSpatialIndex(new_splits, migrated);
+    
+    m_current_splits = new_splits;
+    m_balancer->resetTimestep();
     
     return nullptr;  // No event for now
 }
 
+void RebalanceMeshNode::refreshSpatialIndex(const std::vector<uint64_t>& new_splits, bool migrated) {
+    // Phase 4a: patch the spatial hash instead of rebuilding it
+    if (m_hash_manager && migrated) {
+        const auto& delta = m_migrator->getLastDelta();
+        if (m_cell_keys) {
+            m_hash_manager->applyDelta(delta.removed_keys, delta.upsert_keys, delta.upsert_indices);
+        } else {
+            FL_LOG(WARN) << "RebalanceMeshNode: no cell key mirror bound, hash table left stale";
+        }
+    }
+    
+    // Phase 4b: ghost ranges, recomputed only where split boundaries moved
+    if (m_ghost_builder && !new_splits.empty()) {
+        static const std::vector<uint64_t> no_keys;
+        m_ghost_builder->rebuildAfterRebalance(new_splits, m_cell_keys ? *m_cell_keys : no_keys,
+                                               m_halo_depth);
+        
+        const auto& topology = m_ghost_builder->getTopology();
+        setHilbertRange(topology.local_min_idx, topology.local_max_idx);
+    }
+}
+
 } // namespace nodes
 } // namespace runtime
 } // namespace fluidloom
@@ -0,0 +1,332 @@
+#include "fluidloom/runtime/plan/SimulationPlan.h"
+#include "fluidloom/common/Hash.h"
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace fluidloom {
+namespace runtime {
+namespace plan {
+
+namespace {
+
+// Unsigned type with the width of T (an integer or an enum)
+template <typename T, bool = std::is_enum<T>::value>
+struct Bits { using type = std::make_unsigned_t<T>; };
+template <typename T>
+struct Bits<T, true> { using type = std::make_unsigned_t<std::underlying_type_t<T>>; };
+
+// Little-endian field writer over a growing byte string
+class Writer {
+public:
+    template <typename T>
+    void put(T value) {
+        static_assert(std::is_integral<T>::value || std::is_enum<T>::value, "integral types only");
+        using U = typename Bits<T>::type;
+        U bits = static_cast<U>(value);
+        for (size_t i = 0; i < sizeof(U); ++i) {
+            out.push_back(static_cast<char>((bits >> (8 * i)) & 0xFF));
+        }
+    }
+
+    void putDouble(double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        put(bits);
+    }
+
+    void putBytes(const void* data, size_t size) {
+        put(static_cast<uint64_t>(size));
+        out.append(static_cast<const char*>(data), size);
+    }
+
+    void putString(const std::string& s) { putBytes(s.data(), s.size()); }
+
+    void putStrings(const std::vector<std::string>& strings) {
+        put(static_cast<uint32_t>(strings.size()));
+        for (const auto& s : strings) putString(s);
+    }
+
+    std::string out;
+};
+
+// Bounds-checked reader; any overrun means a truncated or foreign file
+class Reader {
+public:
+    Reader(const std::string& bytes, size_t begin, size_t end)
+        : data(bytes), pos(begin), limit(end) {}
+
+    template <typename T>
+    T get() {
+        using U = typename Bits<T>::type;
+        require(sizeof(U));
+        U bits = 0;
+        for (size_t i = 0; i < sizeof(U); ++i) {
+            bits |= static_cast<U>(static_cast<unsigned char>(data[pos++])) << (8 * i);
+        }
+        return static_cast<T>(bits);
+    }
+
+    double getDouble() {
+        uint64_t bits = get<uint64_t>();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    std::string getString() {
+        uint64_t size = get<uint64_t>();
+        require(size);
+        std::string s = data.substr(pos, size);
+        pos += size;
+        return s;
+    }
+
+    std::vector<uint8_t> getBytes() {
+        std::string s = getString();
+        return std::vector<uint8_t>(s.begin(), s.end());
+    }
+
+    std::vector<std::string> getStrings() {
+        uint32_t count = get<uint32_t>();
+        std::vector<std::string> strings;
+        for (uint32_t i = 0; i < count; ++i) strings.push_back(getString());
+        return strings;
+    }
+
+    bool atEnd() const { return pos == limit; }
+
+private:
+    void require(uint64_t size) const {
+        if (size > limit - pos) {
+            throw std::runtime_error("Simulation plan is truncated");
+        }
+    }
+
+    const std::string& data;
+    size_t pos;
+    size_t limit;
+};
+
+constexpr size_t HEADER_BYTES = 4 + 4 + 8;   // magic, version, payload size
+constexpr size_t TRAILER_BYTES = 8;          // checksum
+
+const char* nodeTypeName(nodes::ExecutionNode::NodeType type) {
+    switch (type) {
+        case nodes::ExecutionNode::NodeType::KERNEL: return "kernel";
+        case nodes::ExecutionNode::NodeType::HALO_EXCHANGE: return "halo";
+        case nodes::ExecutionNode::NodeType::BARRIER: return "barrier";
+        case nodes::ExecutionNode::NodeType::ADAPT_MESH: return "adapt_mesh";
+        case nodes::ExecutionNode::NodeType::FUSED_KERNEL: return "fused_kernel";
+        case nodes::ExecutionNode::NodeType::REBALANCE_MESH: return "rebalance_mesh";
+        case nodes::ExecutionNode::NodeType::HOST_TASK: return "host_task";
+    }
+    return "unknown";
+}
+
+} // namespace
+
+std::string SimulationPlan::serialize() const {
+    Writer payload;
+    payload.put(script_hash);
+    payload.put(num_cells);
+    payload.put(capacity);
+
+    payload.put(static_cast<uint32_t>(fields.size()));
+    for (const auto& field : fields) {
+        payload.putString(field.name);
+        payload.put(field.type);
+        payload.put(field.num_components);
+        payload.put(field.halo_depth);
+        payload.put(field.avg_rule);
+        payload.put(field.solid_scheme);
+        payload.put(static_cast<uint32_t>(field.default_value.size()));
+        for (double v : field.default_value) payload.putDouble(v);
+        uint8_t flags = (field.is_visualization_field ? 1 : 0) | (field.is_mask ? 2 : 0) |
+                        (field.is_material ? 4 : 0) | (field.is_transient ? 8 : 0);
+        payload.put(flags);
+    }
+
+    payload.put(static_cast<uint32_t>(nodes.size()));
+    for (const auto& node : nodes) {
+        payload.put(node.type);
+        payload.putString(node.name);
+        payload.put(node.level);
+        payload.put(node.halo_depth);
+        payload.putStrings(node.read_fields);
+        payload.putStrings(node.write_fields);
+        payload.putString(node.execution_mask);
+        payload.putString(node.kernel_source);
+        payload.putStrings(node.params);
+        payload.put(node.global_work_size);
+        payload.put(node.local_work_size);
+        payload.putString(node.device_signature);
+        payload.putBytes(node.binary.data(), node.binary.size());
+        payload.putStrings(node.halo_fields);
+        payload.put(node.barrier_kind);
+        payload.put(static_cast<uint8_t>(node.global_barrier));
+    }
+
+    payload.put(static_cast<uint32_t>(edges.size()));
+    for (const auto& [from, to] : edges) {
+        payload.put(from);
+        payload.put(to);
+    }
+
+    Writer file;
+    file.put(MAGIC);
+    file.put(FORMAT_VERSION);
+    file.put(static_cast<uint64_t>(payload.out.size()));
+    file.out += payload.out;
+    file.put(hash::fnv1a_64(payload.out));
+    return file.out;
+}
+
+SimulationPlan SimulationPlan::deserialize(const std::string& bytes) {
+    if (bytes.size() < HEADER_BYTES + TRAILER_BYTES) {
+        throw std::runtime_error("Simulation plan is truncated");
+    }
+
+    Reader header(bytes, 0, HEADER_BYTES);
+    if (header.get<uint32_t>() != MAGIC) {
+        throw std::runtime_error("Not a FluidLoom simulation plan");
+    }
+    uint32_t version = header.get<uint32_t>();
+    if (version != FORMAT_VERSION) {
+        throw std::runtime_error("Simulation plan format version " + std::to_string(version) +
+                                 " is not supported (expected " + std::to_string(FORMAT_VERSION) +
+                                 "); regenerate it with fluidloom-parse --aot");
+    }
+    uint64_t payload_size = header.get<uint64_t>();
+    if (payload_size != bytes.size() - HEADER_BYTES - TRAILER_BYTES) {
+        throw std::runtime_error("Simulation plan is truncated");
+    }
+
+    const size_t payload_end = HEADER_BYTES + payload_size;
+    Reader trailer(bytes, payload_end, bytes.size());
+    if (trailer.get<uint64_t>() != hash::fnv1a_64(bytes.substr(HEADER_BYTES, payload_size))) {
+        throw std::runtime_error("Simulation plan checksum mismatch");
+    }
+
+    Reader in(bytes, HEADER_BYTES, payload_end);
+    SimulationPlan plan;
+    plan.script_hash = in.get<uint64_t>();
+    plan.num_cells = in.get<uint64_t>();
+    plan.capacity = in.get<uint64_t>();
+
+    uint32_t num_fields = in.get<uint32_t>();
+    for (uint32_t i = 0; i < num_fields; ++i) {
+        std::string name = in.getString();
+        auto type = in.get<fields::FieldType>();
+        auto components = in.get<uint16_t>();
+        auto halo = in.get<uint8_t>();
+        auto avg = in.get<fields::AveragingRule>();
+        auto solid = in.get<fields::SolidScheme>();
+
+        fields::FieldDescriptor field(name, type, components, halo, avg, solid);
+        uint32_t num_defaults = in.get<uint32_t>();
+        field.default_value.clear();
+        for (uint32_t k = 0; k < num_defaults; ++k) field.default_value.push_back(in.getDouble());
+        uint8_t flags = in.get<uint8_t>();
+        field.is_visualization_field = flags & 1;
+        field.is_mask = flags & 2;
+        field.is_material = flags & 4;
+        field.is_transient = flags & 8;
+        plan.fields.push_back(std::move(field));
+    }
+
+    uint32_t num_nodes = in.get<uint32_t>();
+    for (uint32_t i = 0; i < num_nodes; ++i) {
+        PlanNode node;
+        node.type = in.get<nodes::ExecutionNode::NodeType>();
+        node.name = in.getString();
+        node.level = in.get<int8_t>();
+        node.halo_depth = in.get<uint8_t>();
+        node.read_fields = in.getStrings();
+        node.write_fields = in.getStrings();
+        node.execution_mask = in.getString();
+        node.kernel_source = in.getString();
+        node.params = in.getStrings();
+        node.global_work_size = in.get<uint64_t>();
+        node.local_work_size = in.get<uint64_t>();
+        node.device_signature = in.getString();
+        node.binary = in.getBytes();
+        node.halo_fields = in.getStrings();
+        node.barrier_kind = in.get<uint8_t>();
+        node.global_barrier = in.get<uint8_t>() != 0;
+        plan.nodes.push_back(std::move(node));
+    }
+
+    uint32_t num_edges = in.get<uint32_t>();
+    for (uint32_t i = 0; i < num_edges; ++i) {
+        uint32_t from = in.get<uint32_t>();
+        uint32_t to = in.get<uint32_t>();
+        plan.edges.emplace_back(from, to);
+    }
+
+    if (!in.atEnd()) {
+        throw std::runtime_error("Simulation plan has trailing data");
+    }
+    if (!plan.validate()) {
+        throw std::runtime_error("Simulation plan has invalid dependency edges");
+    }
+    return plan;
+}
+
+void SimulationPlan::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        throw std::runtime_error("Cannot write simulation plan: " + path);
+    }
+    std::string bytes = serialize();
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    if (!out) {
+        throw std::runtime_error("Failed writing simulation plan: " + path);
+    }
+}
+
+SimulationPlan SimulationPlan::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot read simulation plan: " + path);
+    }
+    std::ostringstream buffer;
+    buffer << in.rdbuf();
+    return deserialize(buffer.str());
+}
+
+bool SimulationPlan::matchesScript(const std::string& script_content) const {
+    return script_hash == hash::fnv1a_64(script_content);
+}
+
+bool SimulationPlan::validate() const {
+    for (const auto& [from, to] : edges) {
+        if (from >= nodes.size() || to >= nodes.size() || from == to) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string SimulationPlan::describe() const {
+    std::ostringstream oss;
+    oss << "Simulation plan v" << FORMAT_VERSION << ": " << fields.size() << " fields, "
+        << nodes.size() << " nodes, " << edges.size() << " edges, " << num_cells << " cells\n";
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const PlanNode& node = nodes[i];
+        oss << "  [" << i << "] " << nodeTypeName(node.type) << " " << node.name;
+        if (node.type == nodes::ExecutionNode::NodeType::KERNEL) {
+            oss << " (" << node.params.size() << " args, "
+                << (node.binary.empty() ? "source only" : std::to_string(node.binary.size()) + " byte binary")
+                << ")";
+        }
+        oss << "\n";
+    }
+    return oss.str();
+}
+
+} // namespace plan
+} // namespace runtime
+} // namespace fluidloom
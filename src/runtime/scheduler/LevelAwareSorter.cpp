@@ -29,8 +29,11 @@ public:
     /**
      * @brief Insert barrier nodes between level transitions
      * @param nodes List of nodes (barriers will be inserted)
+     * @param queue Queue the barriers enqueue their markers on (host-side
+     *              wait if null)
      */
-    static void insertLevelBarriers(std::vector<std::shared_ptr<nodes::ExecutionNode>>& nodes) {
+    static void insertLevelBarriers(std::vector<std::shared_ptr<nodes::ExecutionNode>>& nodes,
+                                    cl_command_queue queue = nullptr) {
         if (nodes.empty()) return;
         
         std::vector<std::shared_ptr<nodes::ExecutionNode>> result;
@@ -47,6 +50,8 @@ public:
                     "LevelBarrier_" + std::to_string(current_level) + "_to_" + std::to_string(node_level),
                     nodes::BarrierNode::BarrierKind::LEVEL_TRANSITION
                 );
+                barrier->setLevel(current_level);  // Fences the level being left
+                barrier->setQueue(queue);
                 result.push_back(barrier);
                 current_level = node_level;
             }
@@ -0,0 +1,61 @@
+#include "fluidloom/runtime/scheduler/ScopedEventTable.h"
+#include <algorithm>
+
+namespace fluidloom {
+namespace runtime {
+namespace scheduler {
+
+void ScopedEventTable::record(const std::vector<std::string>& read_fields,
+                              const std::vector<std::string>& write_fields,
+                              int8_t level, cl_event event) {
+    if (!event) return;
+    
+    for (const auto& field : read_fields) {
+        auto& readers = field_events[field].readers;
+        if (std::find(readers.begin(), readers.end(), event) == readers.end()) {
+            readers.push_back(event);
+        }
+    }
+    // A write is ordered after the earlier readers, so it supersedes them
+    for (const auto& field : write_fields) {
+        auto& entry = field_events[field];
+        entry.writer = event;
+        entry.readers.clear();
+    }
+    level_events[level].push_back(event);
+    all_events.push_back(event);
+}
+
+std::vector<cl_event> ScopedEventTable::eventsForFields(const std::vector<std::string>& fields) const {
+    std::vector<cl_event> events;
+    auto add = [&events](cl_event event) {
+        if (event && std::find(events.begin(), events.end(), event) == events.end()) {
+            events.push_back(event);
+        }
+    };
+    for (const auto& field : fields) {
+        auto it = field_events.find(field);
+        if (it == field_events.end()) continue;
+        add(it->second.writer);
+        for (cl_event reader : it->second.readers) {
+            add(reader);
+        }
+    }
+    return events;
+}
+
+std::vector<cl_event> ScopedEventTable::eventsForLevel(int8_t level) const {
+    auto it = level_events.find(level);
+    if (it == level_events.end()) return {};
+    return it->second;
+}
+
+void ScopedEventTable::clear() {
+    field_events.clear();
+    level_events.clear();
+    all_events.clear();
+}
+
+} // namespace scheduler
+} // namespace runtime
+} // namespace fluidloom
@@ -1,7 +1,11 @@
 #include "fluidloom/runtime/scheduler/TopologicalScheduler.h"
+#include "fluidloom/runtime/scheduler/ScopedEventTable.h"
+#include "fluidloom/runtime/nodes/BarrierNode.h"
 #include "fluidloom/common/Logger.h"
+#include <algorithm>
 #include <chrono>
-#include <unordered_map>
+#include <stdexcept>
+#include <unordered_set>
 
 #ifdef __APPLE__
 #include <OpenCL/opencl.h>
@@ -13,31 +17,207 @@ namespace fluidloom {
 namespace runtime {
 namespace scheduler {
 
+TopologicalScheduler::~TopologicalScheduler() {
+    for (cl_event event : cached_events) {
+        if (event) {
+            clReleaseEvent(event);
+        }
+    }
+}
+
 bool TopologicalScheduler::execute() {
-    auto start = std::chrono::high_resolution_clock::now();
+    const auto& order = graph->getTopologicalOrder();
+    
+    FL_LOG(INFO) << "TopologicalScheduler executing " << order.size() << " nodes";
+    
+    bool success = run(order);
+    has_run = has_run || success;
     
+    FL_LOG(INFO) << "TopologicalScheduler completed in " << last_schedule_time_ms << " ms";
+    
+    return success;
+}
+
+std::vector<size_t> TopologicalScheduler::computeDirtyNodes(const DirtySet& dirty) const {
     const auto& order = graph->getTopologicalOrder();
+    const size_t num_nodes = graph->getNodeCount();
     
-    // Track completion events for each node
-    std::unordered_map<int64_t, cl_event> node_events;
+    std::vector<size_t> position(num_nodes, 0);
+    for (size_t pos = 0; pos < order.size(); ++pos) {
+        position[order[pos]] = pos;
+    }
     
-    FL_LOG(INFO) << "TopologicalScheduler executing " << order.size() << " nodes";
+    auto writes = [this](size_t node_idx, const std::string& field) {
+        const auto& fields = graph->getNode(node_idx)->getWriteFields();
+        return std::find(fields.begin(), fields.end(), field) != fields.end();
+    };
     
-    // Execute nodes in topological order
+    // Nodes that must re-run regardless of data flow: the caller's, plus
+    // producers pulled in to restore an input a later writer overwrote
+    std::vector<bool> forced(num_nodes, false);
     for (size_t node_idx : order) {
+        if (dirty.node_ids.count(graph->getNode(node_idx)->getId())) {
+            forced[node_idx] = true;
+        }
+    }
+    
+    std::vector<bool> is_dirty(num_nodes, false);
+    std::vector<size_t> result;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        std::fill(is_dirty.begin(), is_dirty.end(), false);
+        result.clear();
+        
+        // Fields re-produced by dirty nodes; externally dirtied fields are
+        // sources, so only their readers re-run
+        std::unordered_set<std::string> produced;
+        auto touches = [](const std::vector<std::string>& fields, const std::unordered_set<std::string>& set) {
+            for (const auto& field : fields) {
+                if (set.count(field)) {
+                    return true;
+                }
+            }
+            return false;
+        };
+        
+        // Walking in topological order sees every writer before its readers
+        for (size_t node_idx : order) {
+            const auto& node = graph->getNode(node_idx);
+            
+            bool node_dirty = forced[node_idx] ||
+                              touches(node->getReadFields(), dirty.fields) ||
+                              touches(node->getReadFields(), produced) ||
+                              touches(node->getWriteFields(), produced);
+            
+            if (!node_dirty && node->getReadFields().empty() && node->getWriteFields().empty()) {
+                for (size_t pred : graph->getPredecessors(node_idx)) {
+                    if (is_dirty[pred]) {
+                        node_dirty = true;
+                        break;
+                    }
+                }
+            }
+            
+            if (node_dirty) {
+                is_dirty[node_idx] = true;
+                result.push_back(node_idx);
+                produced.insert(node->getWriteFields().begin(), node->getWriteFields().end());
+            }
+        }
+        
+        // A re-run node reads its inputs as the last run left them. If a
+        // later node overwrote one (WAR), the earlier writer must re-run to
+        // restore it; that re-produces the field and so re-runs the later
+        // writers too (WAW).
+        for (size_t node_idx : result) {
+            const auto& node = graph->getNode(node_idx);
+            for (const auto& field : node->getReadFields()) {
+                if (dirty.fields.count(field)) continue;
+                
+                bool overwritten = false;
+                for (size_t pos = position[node_idx] + 1; pos < order.size() && !overwritten; ++pos) {
+                    overwritten = writes(order[pos], field);
+                }
+                if (!overwritten) continue;
+                
+                size_t producer = num_nodes;
+                for (size_t pos = position[node_idx]; pos-- > 0;) {
+                    if (writes(order[pos], field)) {
+                        producer = order[pos];
+                        break;
+                    }
+                }
+                if (producer == num_nodes) {
+                    throw std::runtime_error("Cannot re-run node " + node->getName() + ": its input '" + field +
+                                             "' was overwritten later in the graph and has no earlier producer");
+                }
+                if (!forced[producer]) {
+                    forced[producer] = true;
+                    changed = true;
+                }
+            }
+        }
+    }
+    
+    return result;
+}
+
+bool TopologicalScheduler::executeIncremental(const DirtySet& dirty) {
+    if (!has_run) {
+        FL_LOG(INFO) << "TopologicalScheduler has no cached results; executing full graph";
+        return execute();
+    }
+    
+    std::vector<size_t> dirty_nodes = computeDirtyNodes(dirty);
+    
+    FL_LOG(INFO) << "TopologicalScheduler re-executing " << dirty_nodes.size() << " of "
+                 << graph->getNodeCount() << " nodes";
+    
+    if (dirty_nodes.empty()) {
+        last_executed_count = 0;
+        last_schedule_time_ms = 0.0;
+        return true;
+    }
+    
+    bool success = run(dirty_nodes);
+    
+    FL_LOG(INFO) << "TopologicalScheduler incremental run completed in " << last_schedule_time_ms << " ms";
+    
+    return success;
+}
+
+bool TopologicalScheduler::run(const std::vector<size_t>& node_indices) {
+    auto start = std::chrono::high_resolution_clock::now();
+    
+    const size_t num_nodes = graph->getNodeCount();
+    if (cached_events.size() != num_nodes) {
+        cached_events.resize(num_nodes, nullptr);
+    }
+    
+    // Completion events of this run; nodes outside it use their cached event
+    std::vector<bool> in_run(num_nodes, false);
+    for (size_t node_idx : node_indices) {
+        in_run[node_idx] = true;
+    }
+    std::vector<cl_event> node_events(num_nodes, nullptr);
+    
+    // Same events indexed by accessed field and level, for scoped barriers.
+    // Barriers only see it during this run: the binding is cleared on exit.
+    ScopedEventTable event_table;
+    std::vector<nodes::BarrierNode*> bound_barriers;
+    struct UnbindOnExit {
+        std::vector<nodes::BarrierNode*>& barriers;
+        ~UnbindOnExit() {
+            for (nodes::BarrierNode* barrier : barriers) {
+                barrier->bindEventTable(nullptr);
+            }
+        }
+    } unbind{bound_barriers};
+    
+    for (size_t node_idx : node_indices) {
         auto node = graph->getNode(node_idx);
         
-        // Collect predecessor events
+        // Collect predecessor events; cached ones first, since they have
+        // already completed
         std::vector<cl_event> wait_events;
-        for (const auto& weak_pred : node->getPredecessors()) {
-            if (auto pred = weak_pred.lock()) {
-                auto it = node_events.find(pred->getId());
-                if (it != node_events.end() && it->second != nullptr) {
-                    wait_events.push_back(it->second);
-                }
+        for (size_t pred : graph->getPredecessors(node_idx)) {
+            if (!in_run[pred] && cached_events[pred] != nullptr) {
+                wait_events.push_back(cached_events[pred]);
+            }
+        }
+        for (size_t pred : graph->getPredecessors(node_idx)) {
+            if (in_run[pred] && node_events[pred] != nullptr) {
+                wait_events.push_back(node_events[pred]);
             }
         }
         
+        if (node->getType() == nodes::ExecutionNode::NodeType::BARRIER) {
+            auto& barrier = static_cast<nodes::BarrierNode&>(*node);
+            barrier.bindEventTable(&event_table);
+            bound_barriers.push_back(&barrier);
+        }
+        
         // Execute node with dependencies
         cl_event completion_event = nullptr;
         if (wait_events.empty()) {
@@ -49,35 +229,32 @@ bool TopologicalScheduler::execute() {
         }
         
         // Store completion event
-        node_events[node->getId()] = completion_event;
+        node_events[node_idx] = completion_event;
+        event_table.record(node->getReadFields(), node->getWriteFields(), node->getLevel(), completion_event);
         
         FL_LOG(DEBUG) << "Executed node " << node->getId() << ": " << node->getName();
     }
     
-    // Wait for all nodes to complete
-    for (const auto& [node_id, event] : node_events) {
+    // Wait for all nodes to complete, then keep their events for later
+    // incremental runs
+    for (size_t node_idx : node_indices) {
+        cl_event event = node_events[node_idx];
         if (event) {
             clWaitForEvents(1, &event);
-            clReleaseEvent(event);
         }
+        if (cached_events[node_idx]) {
+            clReleaseEvent(cached_events[node_idx]);
+        }
+        cached_events[node_idx] = event;
     }
     
     auto end = std::chrono::high_resolution_clock::now();
     last_schedule_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
-    
-    FL_LOG(INFO) << "TopologicalScheduler completed in " << last_schedule_time_ms << " ms";
+    last_executed_count = node_indices.size();
     
     return true;
 }
 
-bool TopologicalScheduler::executeIncremental(size_t start_idx, size_t end_idx) {
-    (void)start_idx;
-    (void)end_idx;
-    // Stub for Module 12 (kernel fusion)
-    FL_LOG(WARN) << "Incremental execution not yet implemented (Module 12)";
-    return false;
-}
-
 } // namespace scheduler
 } // namespace runtime
 } // namespace fluidloom
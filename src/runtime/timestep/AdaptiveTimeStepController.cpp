@@ -0,0 +1,289 @@
+#include "fluidloom/runtime/timestep/AdaptiveTimeStepController.h"
+#include "fluidloom/common/Logger.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#ifdef FLUIDLOOM_MPI_ENABLED
+#include <mpi.h>
+#endif
+
+namespace fluidloom {
+namespace runtime {
+namespace timestep {
+
+const char* timeStepLimitName(TimeStepLimit limit) {
+    switch (limit) {
+        case TimeStepLimit::NONE: return "none";
+        case TimeStepLimit::CFL: return "cfl";
+        case TimeStepLimit::GROWTH: return "growth";
+        case TimeStepLimit::TAU_MIN: return "tau_min";
+        case TimeStepLimit::TAU_MAX: return "tau_max";
+        case TimeStepLimit::DT_MIN: return "dt_min";
+        case TimeStepLimit::DT_MAX: return "dt_max";
+    }
+    return "unknown";
+}
+
+// Per-level maxima of one update, in flight across ranks
+struct AdaptiveTimeStepController::PendingReduction {
+    std::vector<float> local;
+    std::vector<float> global;
+#ifdef FLUIDLOOM_MPI_ENABLED
+    MPI_Request request = MPI_REQUEST_NULL;
+#endif
+};
+
+AdaptiveTimeStepController::AdaptiveTimeStepController(AdaptiveTimeStepConfig config,
+                                                       double initial_dt,
+                                                       IBackend* backend)
+    : m_config(std::move(config)), m_reducer(backend) {
+    m_config.validate();
+    if (!(initial_dt > 0.0)) {
+        throw std::invalid_argument("AdaptiveTimeStepController: initial dt must be positive");
+    }
+    m_state.dt = std::min(std::max(initial_dt, m_config.dt_min), m_config.dt_max);
+    m_state.level_max_speed.assign(numLevels(), 0.0f);
+    fillLevels(m_state);
+
+    FL_LOG(INFO) << "AdaptiveTimeStepController: dt=" << m_state.dt << ", levels 0-" << int(m_config.max_level)
+                 << ", subcycle ratio " << m_config.subcycle_ratio << ", CFL target " << m_config.cfl_target;
+}
+
+AdaptiveTimeStepController::~AdaptiveTimeStepController() {
+#ifdef FLUIDLOOM_MPI_ENABLED
+    // A posted allreduce must not outlive its buffers
+    if (m_pending && m_pending->request != MPI_REQUEST_NULL) {
+        MPI_Wait(&m_pending->request, MPI_STATUS_IGNORE);
+    }
+#endif
+}
+
+double AdaptiveTimeStepController::levelScale(size_t level) const {
+    return std::pow(2.0 / m_config.subcycle_ratio, static_cast<double>(level)) / m_config.dx0;
+}
+
+uint32_t AdaptiveTimeStepController::getSubsteps(uint8_t level) const {
+    uint32_t substeps = 1;
+    for (uint8_t l = 0; l < level; ++l) {
+        substeps *= m_config.subcycle_ratio;
+    }
+    return substeps;
+}
+
+void AdaptiveTimeStepController::fillLevels(TimeStepState& state) const {
+    const size_t levels = numLevels();
+    state.level_dt.resize(levels);
+    state.level_tau.resize(levels);
+    state.level_omega.resize(levels);
+    state.level_cfl.resize(levels);
+    state.tau_clamped = false;
+
+    for (size_t level = 0; level < levels; ++level) {
+        const double dx = m_config.dx0 / std::ldexp(1.0, static_cast<int>(level));
+        const double dt = state.dt / std::pow(static_cast<double>(m_config.subcycle_ratio), static_cast<double>(level));
+        double tau = m_config.tau_min;
+        if (m_config.viscosity > 0.0) {
+            tau = 0.5 + 3.0 * m_config.viscosity * dt / (dx * dx);
+            const double clamped = std::min(std::max(tau, m_config.tau_min), m_config.tau_max);
+            // Exact bound hits come back from the dt limits with rounding noise
+            if (std::fabs(clamped - tau) > 1e-9 * clamped) {
+                state.tau_clamped = true;
+            }
+            tau = clamped;
+        }
+        const float speed = level < state.level_max_speed.size() ? state.level_max_speed[level] : 0.0f;
+
+        state.level_dt[level] = dt;
+        state.level_tau[level] = tau;
+        state.level_omega[level] = 1.0 / tau;
+        state.level_cfl[level] = std::max(0.0f, speed) * dt / dx;
+    }
+}
+
+TimeStepState AdaptiveTimeStepController::propose(const std::vector<float>& level_max_speed) const {
+    TimeStepState next = m_state;
+    next.level_max_speed.assign(numLevels(), 0.0f);
+    for (size_t level = 0; level < numLevels() && level < level_max_speed.size(); ++level) {
+        next.level_max_speed[level] = level_max_speed[level];
+    }
+
+    // Steepest level: the CFL number of level L is dt · max|u|_L · levelScale(L)
+    double steepest = 0.0;
+    bool blown_up = false;
+    next.cfl_violated = false;
+    for (size_t level = 0; level < numLevels(); ++level) {
+        const float speed = next.level_max_speed[level];
+        if (std::isnan(speed)) {
+            blown_up = true;
+            continue;
+        }
+        const double rate = std::max(0.0f, speed) * levelScale(level);
+        steepest = std::max(steepest, rate);
+        if (rate * m_state.dt > m_config.cfl_max) {
+            next.cfl_violated = true;
+        }
+    }
+    if (blown_up) {
+        // Nothing to steer by; keep dt and let the caller react
+        next.cfl_violated = true;
+        fillLevels(next);
+        return next;
+    }
+
+    // Relaxation bounds as dt bounds: tau_L grows linearly with dt
+    double dt_tau_lo = 0.0;
+    double dt_tau_hi = std::numeric_limits<double>::infinity();
+    if (m_config.viscosity > 0.0) {
+        for (size_t level = 0; level < numLevels(); ++level) {
+            const double dx = m_config.dx0 / std::ldexp(1.0, static_cast<int>(level));
+            const double substeps = std::pow(static_cast<double>(m_config.subcycle_ratio), static_cast<double>(level));
+            const double per_tau = substeps * dx * dx / (3.0 * m_config.viscosity);
+            dt_tau_lo = std::max(dt_tau_lo, (m_config.tau_min - 0.5) * per_tau);
+            dt_tau_hi = std::min(dt_tau_hi, (m_config.tau_max - 0.5) * per_tau);
+        }
+    }
+
+    double dt = steepest > 0.0 ? m_config.cfl_target / steepest : std::numeric_limits<double>::infinity();
+    TimeStepLimit limit = TimeStepLimit::CFL;
+
+    if (dt > m_state.dt * m_config.max_growth) {
+        dt = m_state.dt * m_config.max_growth;
+        limit = TimeStepLimit::GROWTH;
+    }
+    if (dt > dt_tau_hi) {
+        dt = dt_tau_hi;
+        limit = TimeStepLimit::TAU_MAX;
+    }
+    if (dt > m_config.dt_max) {
+        dt = m_config.dt_max;
+        limit = TimeStepLimit::DT_MAX;
+    }
+    if (dt < dt_tau_lo) {
+        // Raise dt for tau only while CFL stays stable
+        const double dt_cfl_max = steepest > 0.0 ? m_config.cfl_max / steepest
+                                                 : std::numeric_limits<double>::infinity();
+        const double raised = std::min(dt_tau_lo, dt_cfl_max);
+        if (raised > dt) {
+            dt = raised;
+            limit = TimeStepLimit::TAU_MIN;
+        }
+    }
+    if (dt < m_config.dt_min) {
+        dt = m_config.dt_min;
+        limit = TimeStepLimit::DT_MIN;
+    }
+
+    next.dt = dt;
+    next.limit = limit;
+    fillLevels(next);
+    return next;
+}
+
+bool AdaptiveTimeStepController::isPending() const {
+    return m_pending != nullptr;
+}
+
+void AdaptiveTimeStepController::beginUpdate(const VelocityInput& input) {
+    if (m_pending) {
+        completeUpdate();
+    }
+
+    // One level-filtered MAX |u| per level, fused MAX_FUSED at a time
+    std::vector<reduction::ReductionSpec> specs;
+    for (size_t level = 0; level < numLevels(); ++level) {
+        if (!input.levels && level > 0) break;  // Unrefined mesh: level 0 only
+        reduction::ReductionSpec spec;
+        spec.name = "max_speed_L" + std::to_string(level);
+        spec.op = reduction::ReduceOp::MAX;
+        spec.term = reduction::ReduceTerm::NORM;
+        spec.num_components = input.num_components;
+        spec.level = input.levels ? static_cast<int32_t>(level) : -1;
+        specs.push_back(std::move(spec));
+    }
+    auto pending = std::make_unique<PendingReduction>();
+    pending->local.assign(numLevels(), -std::numeric_limits<float>::infinity());
+    for (size_t first = 0; first < specs.size(); first += reduction::DeterministicReducer::MAX_FUSED) {
+        const size_t count = std::min(reduction::DeterministicReducer::MAX_FUSED, specs.size() - first);
+        std::vector<reduction::ReductionSpec> batch(specs.begin() + first, specs.begin() + first + count);
+        auto partials = m_reducer.reduceLocal(batch, {input.velocity}, input.levels, input.num_cells);
+        for (size_t i = 0; i < count; ++i) {
+            pending->local[first + i] = static_cast<float>(partials.value(i));
+        }
+    }
+    pending->global = pending->local;
+
+#ifdef FLUIDLOOM_MPI_ENABLED
+    int initialized = 0;
+    MPI_Initialized(&initialized);
+    if (initialized) {
+        // MAX is exact, so the result is the same on every rank and every run
+        MPI_Iallreduce(pending->local.data(), pending->global.data(), static_cast<int>(numLevels()),
+                       MPI_FLOAT, MPI_MAX, MPI_COMM_WORLD, &pending->request);
+    }
+#endif
+    m_pending = std::move(pending);
+}
+
+bool AdaptiveTimeStepController::completeUpdate() {
+    if (!m_pending) {
+        return false;
+    }
+#ifdef FLUIDLOOM_MPI_ENABLED
+    if (m_pending->request != MPI_REQUEST_NULL) {
+        MPI_Wait(&m_pending->request, MPI_STATUS_IGNORE);
+    }
+#endif
+    std::vector<float> speeds = std::move(m_pending->global);
+    m_pending.reset();
+    return apply(speeds);
+}
+
+bool AdaptiveTimeStepController::apply(const std::vector<float>& level_max_speed) {
+    TimeStepState next = propose(level_max_speed);
+    next.updates = m_state.updates + 1;
+    const bool changed = next.dt != m_state.dt;
+
+    if (next.cfl_violated) {
+        FL_LOG(WARN) << "AdaptiveTimeStepController: CFL above " << m_config.cfl_max << " at dt=" << m_state.dt
+                     << ", dt now " << next.dt;
+    }
+    if (next.tau_clamped) {
+        FL_LOG(WARN) << "AdaptiveTimeStepController: CFL bound forces tau outside [" << m_config.tau_min << ", "
+                     << m_config.tau_max << "] at dt=" << next.dt;
+    }
+    if (changed) {
+        FL_LOG(DEBUG) << "AdaptiveTimeStepController: dt " << m_state.dt << " -> " << next.dt << " ("
+                      << timeStepLimitName(next.limit) << ")";
+    }
+
+    m_state = std::move(next);
+    if (m_callback) {
+        m_callback(m_state);
+    }
+    return changed;
+}
+
+bool AdaptiveTimeStepController::step(const VelocityInput& input) {
+    const bool changed = completeUpdate();
+    if (m_steps % m_config.update_interval == 0) {
+        beginUpdate(input);
+    }
+    ++m_steps;
+    return changed;
+}
+
+std::shared_ptr<nodes::HostTaskNode> AdaptiveTimeStepController::createUpdateNode(
+    const std::string& velocity_field,
+    std::function<VelocityInput()> input
+) {
+    auto node = std::make_shared<nodes::HostTaskNode>("adaptive_dt", [this, input = std::move(input)]() {
+        step(input());
+    });
+    node->setReadFields({velocity_field});
+    return node;
+}
+
+} // namespace timestep
+} // namespace runtime
+} // namespace fluidloom
@@ -0,0 +1,87 @@
+#include "fluidloom/transport/CompressionPolicy.h"
+#include <limits>
+
+namespace fluidloom {
+namespace transport {
+
+double CompressionPolicy::blend(double current, double sample) const {
+    return current > 0.0 ? current + m_config.smoothing * (sample - current) : sample;
+}
+
+void CompressionPolicy::setLinkProfile(int peer, const PeerAccessManager::LinkProfile& link) {
+    m_peers[peer].link = link;
+}
+
+void CompressionPolicy::recordTransfer(int peer, size_t bytes, double seconds) {
+    if (bytes == 0 || seconds <= 0.0) return;
+    auto& link = m_peers[peer].link;
+    // Bytes per microsecond net of latency, stored as GB/s like LinkProfile
+    const double wire_us = seconds * 1e6 - link.latency_us;
+    if (wire_us <= 0.0) return;
+    link.bandwidth_gbps = blend(link.bandwidth_gbps, static_cast<double>(bytes) / wire_us * 1e-3);
+}
+
+void CompressionPolicy::recordEncode(int peer, size_t raw_bytes, size_t encoded_bytes, double seconds) {
+    if (raw_bytes == 0 || encoded_bytes == 0) return;
+    auto& estimate = m_peers[peer];
+    estimate.ratio = blend(estimate.ratio, static_cast<double>(raw_bytes) / static_cast<double>(encoded_bytes));
+    if (seconds > 0.0) {
+        m_encode_gbps = blend(m_encode_gbps, static_cast<double>(raw_bytes) / seconds * 1e-9);
+    }
+}
+
+void CompressionPolicy::recordDecode(size_t raw_bytes, double seconds) {
+    if (raw_bytes == 0 || seconds <= 0.0) return;
+    m_decode_gbps = blend(m_decode_gbps, static_cast<double>(raw_bytes) / seconds * 1e-9);
+}
+
+double CompressionPolicy::rawCostUs(int peer, size_t raw_bytes) const {
+    auto it = m_peers.find(peer);
+    if (it == m_peers.end() || !it->second.link.usable()) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return it->second.link.costUs(raw_bytes);
+}
+
+double CompressionPolicy::compressedCostUs(int peer, size_t raw_bytes) const {
+    auto it = m_peers.find(peer);
+    if (it == m_peers.end() || !it->second.link.usable() || it->second.ratio <= 0.0 ||
+        m_encode_gbps <= 0.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    const double bytes = static_cast<double>(raw_bytes);
+    // Decoding is at least as fast as encoding; use the encoder's rate until measured
+    const double decode_gbps = m_decode_gbps > 0.0 ? m_decode_gbps : m_encode_gbps;
+    const double codec_us = bytes / (m_encode_gbps * 1e3) + bytes / (decode_gbps * 1e3);
+    return codec_us + it->second.link.costUs(static_cast<size_t>(bytes / it->second.ratio));
+}
+
+bool CompressionPolicy::shouldCompress(int peer, size_t raw_bytes) {
+    if (!m_config.enabled) return false;
+    auto& estimate = m_peers[peer];
+    ++estimate.payloads;
+    if (raw_bytes < m_config.min_payload_bytes || !estimate.link.usable()) {
+        estimate.compressing = false;
+        return false;
+    }
+
+    const bool unprobed = estimate.ratio <= 0.0 || m_encode_gbps <= 0.0;
+    estimate.compressing = !unprobed &&
+        rawCostUs(peer, raw_bytes) > m_config.min_speedup * compressedCostUs(peer, raw_bytes);
+
+    const bool probe = unprobed ||
+        (m_config.probe_interval > 0 && estimate.payloads % m_config.probe_interval == 0);
+    if (estimate.compressing || probe) {
+        ++estimate.compressed;
+        return true;
+    }
+    return false;
+}
+
+CompressionPolicy::PeerEstimate CompressionPolicy::getEstimate(int peer) const {
+    auto it = m_peers.find(peer);
+    return it != m_peers.end() ? it->second : PeerEstimate{};
+}
+
+} // namespace transport
+} // namespace fluidloom
@@ -0,0 +1,292 @@
+#include "fluidloom/transport/PayloadCodec.h"
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace fluidloom {
+namespace transport {
+
+namespace {
+
+constexpr size_t WORD = sizeof(float);
+
+// LZ stage
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t MAX_OFFSET = 65535;
+constexpr int HASH_BITS = 14;
+constexpr int SKIP_SHIFT = 6;       // Step grows by one every 64 misses on incompressible data
+
+// Worst-case expansion of one LZ output byte; bounds allocations for corrupt frames
+constexpr uint64_t MAX_LZ_RATIO = 256;
+
+constexpr uint16_t KNOWN_FLAGS = PayloadCodec::XOR_DELTA | PayloadCodec::SHUFFLE | PayloadCodec::LZ;
+
+uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint32_t hashSequence(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+[[noreturn]] void corrupt(const std::string& what) {
+    throw std::runtime_error("PayloadCodec: " + what);
+}
+
+// Appends 255-runs for a length field that overflowed its token nibble
+bool writeLength(size_t length, uint8_t* out, size_t& op, size_t capacity) {
+    while (length >= 255) {
+        if (op >= capacity) return false;
+        out[op++] = 255;
+        length -= 255;
+    }
+    if (op >= capacity) return false;
+    out[op++] = static_cast<uint8_t>(length);
+    return true;
+}
+
+size_t readLength(const uint8_t* in, size_t size, size_t& ip) {
+    size_t length = 0;
+    uint8_t byte;
+    do {
+        if (ip >= size) corrupt("truncated length");
+        byte = in[ip++];
+        length += byte;
+    } while (byte == 255);
+    return length;
+}
+
+// One sequence: token, literal run, then (unless final) offset and match length
+bool writeSequence(const uint8_t* literals, size_t literal_length,
+                   size_t offset, size_t match_length, bool final,
+                   uint8_t* out, size_t& op, size_t capacity) {
+    const size_t match_code = final ? 0 : match_length - MIN_MATCH;
+    if (op >= capacity) return false;
+    out[op++] = static_cast<uint8_t>(((literal_length < 15 ? literal_length : 15) << 4) |
+                                     (match_code < 15 ? match_code : 15));
+    if (literal_length >= 15 && !writeLength(literal_length - 15, out, op, capacity)) return false;
+    if (literal_length > capacity - op) return false;
+    std::memcpy(out + op, literals, literal_length);
+    op += literal_length;
+    if (final) return true;
+
+    if (capacity - op < 2) return false;
+    out[op++] = static_cast<uint8_t>(offset & 0xFF);
+    out[op++] = static_cast<uint8_t>(offset >> 8);
+    return match_code < 15 || writeLength(match_code - 15, out, op, capacity);
+}
+
+} // namespace
+
+bool PayloadCodec::isFrame(const uint8_t* data, size_t size) {
+    return size >= sizeof(CodecFrameHeader) && read32(data) == MAGIC;
+}
+
+uint32_t PayloadCodec::checksum(const uint8_t* data, size_t size) {
+    // FNV-1a over 32-bit words, then the tail bytes and the length
+    uint32_t hash = 2166136261u;
+    size_t i = 0;
+    for (; i + WORD <= size; i += WORD) {
+        hash = (hash ^ read32(data + i)) * 16777619u;
+    }
+    for (; i < size; ++i) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return (hash ^ static_cast<uint32_t>(size)) * 16777619u;
+}
+
+void PayloadCodec::shuffle(const uint8_t* in, size_t size, uint8_t* out) {
+    const size_t words = size / WORD;
+    for (size_t plane = 0; plane < WORD; ++plane) {
+        uint8_t* dst = out + plane * words;
+        for (size_t w = 0; w < words; ++w) {
+            dst[w] = in[w * WORD + plane];
+        }
+    }
+    std::memcpy(out + words * WORD, in + words * WORD, size - words * WORD);
+}
+
+void PayloadCodec::unshuffle(const uint8_t* in, size_t size, uint8_t* out) {
+    const size_t words = size / WORD;
+    for (size_t plane = 0; plane < WORD; ++plane) {
+        const uint8_t* src = in + plane * words;
+        for (size_t w = 0; w < words; ++w) {
+            out[w * WORD + plane] = src[w];
+        }
+    }
+    std::memcpy(out + words * WORD, in + words * WORD, size - words * WORD);
+}
+
+size_t PayloadCodec::lzCompress(const uint8_t* in, size_t size, uint8_t* out, size_t capacity) {
+    std::vector<uint32_t> table(size_t(1) << HASH_BITS, 0);  // Position + 1; 0 is empty
+    size_t ip = 0;
+    size_t anchor = 0;
+    size_t op = 0;
+    size_t misses = 0;
+
+    while (ip + MIN_MATCH <= size) {
+        const uint32_t sequence = read32(in + ip);
+        uint32_t& slot = table[hashSequence(sequence)];
+        const size_t candidate = slot;
+        slot = static_cast<uint32_t>(ip + 1);
+
+        if (candidate == 0 || ip - (candidate - 1) > MAX_OFFSET || read32(in + candidate - 1) != sequence) {
+            ip += 1 + (misses++ >> SKIP_SHIFT);
+            continue;
+        }
+
+        const size_t match = candidate - 1;
+        size_t length = MIN_MATCH;
+        while (ip + length < size && in[match + length] == in[ip + length]) {
+            ++length;
+        }
+        if (!writeSequence(in + anchor, ip - anchor, ip - match, length, false, out, op, capacity)) {
+            return 0;
+        }
+        ip += length;
+        anchor = ip;
+        misses = 0;
+        if (ip + 2 <= size) {
+            // Seed the table inside long matches so runs keep chaining
+            table[hashSequence(read32(in + ip - 2))] = static_cast<uint32_t>(ip - 1);
+        }
+    }
+
+    if (!writeSequence(in + anchor, size - anchor, 0, 0, true, out, op, capacity)) {
+        return 0;
+    }
+    return op;
+}
+
+size_t PayloadCodec::lzDecompress(const uint8_t* in, size_t size, uint8_t* out, size_t capacity) {
+    size_t ip = 0;
+    size_t op = 0;
+    while (true) {
+        if (ip >= size) corrupt("missing final sequence");
+        const uint8_t token = in[ip++];
+
+        size_t literal_length = token >> 4;
+        if (literal_length == 15) literal_length += readLength(in, size, ip);
+        if (literal_length > size - ip || literal_length > capacity - op) corrupt("literal run out of bounds");
+        std::memcpy(out + op, in + ip, literal_length);
+        ip += literal_length;
+        op += literal_length;
+        if (ip == size) return op;
+
+        if (size - ip < 2) corrupt("truncated match offset");
+        const size_t offset = in[ip] | (size_t(in[ip + 1]) << 8);
+        ip += 2;
+        size_t length = (token & 0x0F) + MIN_MATCH;
+        if ((token & 0x0F) == 15) length += readLength(in, size, ip);
+        if (offset == 0 || offset > op) corrupt("match offset out of bounds");
+        if (length > capacity - op) corrupt("match overruns the output");
+
+        // Overlapping copies (offset < length) replicate the run byte by byte
+        const uint8_t* src = out + op - offset;
+        if (offset >= length) {
+            std::memcpy(out + op, src, length);
+        } else {
+            for (size_t i = 0; i < length; ++i) out[op + i] = src[i];
+        }
+        op += length;
+    }
+}
+
+std::vector<uint8_t> PayloadCodec::encode(const uint8_t* raw, size_t raw_bytes,
+                                          const uint8_t* reference, uint32_t reference_tag,
+                                          uint16_t flags) {
+    if (!reference) flags &= ~XOR_DELTA;
+
+    CodecFrameHeader header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.raw_bytes = raw_bytes;
+    header.checksum = checksum(raw, raw_bytes);
+
+    std::vector<uint8_t> frame(sizeof(CodecFrameHeader) + raw_bytes);
+    uint8_t* body = frame.data() + sizeof(CodecFrameHeader);
+
+    std::vector<uint8_t> staged;
+    const uint8_t* current = raw;
+    if (flags & XOR_DELTA) {
+        staged.resize(raw_bytes);
+        for (size_t i = 0; i < raw_bytes; ++i) staged[i] = raw[i] ^ reference[i];
+        current = staged.data();
+    }
+    if (flags & SHUFFLE) {
+        std::vector<uint8_t> shuffled(raw_bytes);
+        shuffle(current, raw_bytes, shuffled.data());
+        staged.swap(shuffled);
+        current = staged.data();
+    }
+
+    size_t encoded = raw_bytes;
+    if (flags & LZ) {
+        // Must shrink, otherwise the frame stores the raw payload
+        encoded = raw_bytes > 0 ? lzCompress(current, raw_bytes, body, raw_bytes - 1) : 0;
+        if (encoded == 0) {
+            flags = 0;
+            current = raw;
+            encoded = raw_bytes;
+        }
+    }
+    if (!(flags & LZ)) {
+        std::memcpy(body, current, raw_bytes);
+    }
+
+    header.flags = flags;
+    header.reference_tag = (flags & XOR_DELTA) ? reference_tag : 0;
+    header.encoded_bytes = encoded;
+    std::memcpy(frame.data(), &header, sizeof(header));
+    frame.resize(sizeof(CodecFrameHeader) + encoded);
+    return frame;
+}
+
+std::vector<uint8_t> PayloadCodec::decode(const uint8_t* frame, size_t frame_bytes,
+                                          const uint8_t* reference, size_t reference_bytes,
+                                          uint32_t reference_tag) {
+    if (!isFrame(frame, frame_bytes)) corrupt("not a codec frame");
+    CodecFrameHeader header;
+    std::memcpy(&header, frame, sizeof(header));
+    if (header.version != VERSION || (header.flags & ~KNOWN_FLAGS)) {
+        corrupt("unsupported frame version " + std::to_string(header.version));
+    }
+    if (header.encoded_bytes > frame_bytes - sizeof(CodecFrameHeader)) corrupt("truncated frame");
+    const bool lz = header.flags & LZ;
+    if ((!lz && header.raw_bytes != header.encoded_bytes) ||
+        (lz && header.raw_bytes > header.encoded_bytes * MAX_LZ_RATIO)) {
+        corrupt("inconsistent frame sizes");
+    }
+
+    const uint8_t* body = frame + sizeof(CodecFrameHeader);
+    const size_t raw_bytes = static_cast<size_t>(header.raw_bytes);
+    std::vector<uint8_t> current(raw_bytes);
+    if (lz) {
+        if (lzDecompress(body, static_cast<size_t>(header.encoded_bytes), current.data(), raw_bytes) != raw_bytes) {
+            corrupt("decompressed size mismatch");
+        }
+    } else {
+        std::memcpy(current.data(), body, raw_bytes);
+    }
+
+    if (header.flags & SHUFFLE) {
+        std::vector<uint8_t> unshuffled(raw_bytes);
+        unshuffle(current.data(), raw_bytes, unshuffled.data());
+        current.swap(unshuffled);
+    }
+    if (header.flags & XOR_DELTA) {
+        if (!reference || reference_bytes != raw_bytes || reference_tag != header.reference_tag) {
+            corrupt("delta frame against reference " + std::to_string(header.reference_tag) +
+                    ", but the receiver holds " + std::to_string(reference ? reference_tag : 0));
+        }
+        for (size_t i = 0; i < raw_bytes; ++i) current[i] ^= reference[i];
+    }
+
+    if (checksum(current.data(), raw_bytes) != header.checksum) corrupt("checksum mismatch");
+    return current;
+}
+
+} // namespace transport
+} // namespace fluidloom
@@ -1,13 +1,37 @@
 #include "fluidloom/transport/MPIEventBridge.h"
+#include "fluidloom/core/backend/OpenCLBackend.h"
 #include "fluidloom/common/Logger.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
 
 namespace fluidloom {
 namespace transport {
 
-MPIEventBridge::MPIEventBridge(IBackend* backend) 
-    : backend(backend), stop_polling(false) {
-    (void)this->backend; // Suppress unused warning (will be used when getContext is available)
-    
+namespace {
+// Tag of the zero-byte self message that wakes a poller blocked in MPI_Waitsome
+constexpr int DOORBELL_TAG = 0x5eb;
+
+// Default spin budget: ~1k empty Testsome passes (tens of µs to ~1 ms depending
+// on set size) covers a typical halo round trip before we yield the core.
+constexpr uint32_t DEFAULT_SPIN_PASSES = 1024;
+}
+
+MPIEventBridge::MPIEventBridge(IBackend* backend)
+    : backend(backend), context(nullptr), stop_polling(false),
+      poller_blocking(false), spin_passes(DEFAULT_SPIN_PASSES) {
+
+    // User events need the OpenCL context; other backends get host callbacks only
+    if (backend && backend->getType() == BackendType::OPENCL) {
+        context = static_cast<OpenCLBackend*>(backend)->getContext();
+    }
+
+    #ifdef FLUIDLOOM_MPI_ENABLED
+    doorbell_comm = MPI_COMM_NULL;
+    thread_level_checked = false;
+    #endif
+    checkThreadLevel();
+
     polling_thread = std::thread(&MPIEventBridge::pollingLoop, this);
 }
 
@@ -21,100 +45,313 @@ void MPIEventBridge::shutdown() {
         stop_polling = true;
     }
     queue_cv.notify_all();
+    ringDoorbell();
     if (polling_thread.joinable()) {
         polling_thread.join();
     }
 }
 
 cl_event MPIEventBridge::bridgeMPIRequest(MPIRequestWrapper* request) {
+    if (!request) {
+        return nullptr;
+    }
+
     // If it's already an OpenCL event (P2P), just return it
     if (auto* event = request->getCLEvent()) {
+        if (!*event) {
+            return nullptr; // Host-side copy, nothing to wait for
+        }
         // Need to retain it because the caller might release it or use it
         clRetainEvent(*event);
         return *event;
     }
-    
-    // For MPI requests, we create a user event and signal it when MPI completes
-    // cl_context context = backend->getContext(); // IBackend doesn't expose this yet
-    // For now, we can't create user events without context
-    // We'll need to extend IBackend or use a different approach
-    // Placeholder: return nullptr for now
-    (void)request; // Suppress unused warning
-    return nullptr; // TODO: Implement proper event bridging
-    
-    /*
-    cl_int err;
-    cl_context context = nullptr; // backend->getContext();
-    // Assuming IBackend has getContext. If not, we might need to add it or use a workaround.
-    // Module 7 didn't use getContext.
-    // Let's assume we can get it or create a user event via backend.
-    // If IBackend doesn't expose it, we are stuck.
-    // Let's check IBackend.h later. For now, assume we can get it.
-    // Or better, use a callback mechanism if available.
-    // But OpenCL 1.2 user events are standard.
-    
-    // Workaround: If IBackend doesn't expose context, we can't create user event easily.
-    // But we can use a marker event? No.
-    // We need to modify IBackend to expose context or create user event.
-    // I'll assume `backend->createUserEvent()` exists or I'll add it.
-    // Or I'll use `clCreateUserEvent` with `backend->getContext()`.
-    
-    // For now, let's assume `backend->getContext()` is available.
-    // If not, I'll have to add it.
-    
-    cl_event user_event = clCreateUserEvent(context, &err);
-    if (err != CL_SUCCESS) {
-        FL_LOG(ERROR) << "Failed to create user event: " << err;
-        return nullptr;
+
+    #ifdef FLUIDLOOM_MPI_ENABLED
+    cl_event user_event = nullptr;
+    if (context) {
+        cl_int err = CL_SUCCESS;
+        user_event = clCreateUserEvent(context, &err);
+        if (err != CL_SUCCESS) {
+            FL_LOG(ERROR) << "Failed to create user event: " << err;
+            user_event = nullptr;
+        } else {
+            // One reference for the caller, one released by the poller on completion
+            clRetainEvent(user_event);
+        }
+    }
+
+    submit(request, user_event, nullptr);
+    return user_event;
+    #else
+    return nullptr;
+    #endif
+}
+
+void MPIEventBridge::notifyOnCompletion(MPIRequestWrapper* request, std::function<void()> callback) {
+    if (!request || !callback) {
+        return;
+    }
+
+    if (auto* event = request->getCLEvent()) {
+        if (!*event) {
+            callback();
+            return;
+        }
+        auto* heap_callback = new std::function<void()>(std::move(callback));
+        clSetEventCallback(*event, CL_COMPLETE,
+            [](cl_event, cl_int, void* data) {
+                auto* fn = static_cast<std::function<void()>*>(data);
+                (*fn)();
+                delete fn;
+            },
+            heap_callback);
+        return;
+    }
+
+    submit(request, nullptr, std::move(callback));
+}
+
+bool MPIEventBridge::isMPIComplete(MPIRequestWrapper* request) {
+    return request->test();
+}
+
+MPIEventBridge::Stats MPIEventBridge::getStats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    return stats;
+}
+
+void MPIEventBridge::submit(MPIRequestWrapper* request, cl_event user_event, std::function<void()> callback) {
+    PendingCompletion pending;
+    pending.wrapper = request;
+    pending.user_event = user_event;
+    pending.on_complete = std::move(callback);
+    pending.submitted = Clock::now();
+
+    #ifdef FLUIDLOOM_MPI_ENABLED
+    MPI_Request* native = request->getMPIRequest();
+    if (request->isDetached() || !native || *native == MPI_REQUEST_NULL) {
+        if (request->isDetached()) {
+            FL_LOG(WARN) << "MPIEventBridge: request already bridged, completing immediately";
+            pending.wrapper = nullptr;
+        }
+        std::vector<PendingCompletion> immediate;
+        immediate.push_back(std::move(pending));
+        signalBatch(immediate);
+        return;
     }
-    
+
+    checkThreadLevel();
+    MPI_Request req = request->detachMPIRequest();
     {
         std::lock_guard<std::mutex> lock(queue_mutex);
-        pending_tests.push({request, user_event});
+        incoming.emplace_back(req, std::move(pending));
+    }
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        stats.requests_bridged++;
     }
     queue_cv.notify_one();
-    
-    return user_event;
-    */
+    ringDoorbell();
+    #else
+    std::vector<PendingCompletion> immediate;
+    immediate.push_back(std::move(pending));
+    signalBatch(immediate);
+    #endif
 }
 
-bool MPIEventBridge::isMPIComplete(MPIRequestWrapper* request) {
-    return request->test();
+void MPIEventBridge::checkThreadLevel() {
+    #ifdef FLUIDLOOM_MPI_ENABLED
+    if (thread_level_checked.load()) {
+        return;
+    }
+    int initialized = 0;
+    MPI_Initialized(&initialized);
+    if (!initialized) {
+        return; // Checked again by the first submission, which needs MPI
+    }
+    // The poller tests and waits on requests while callers post theirs and
+    // ring the doorbell, so MPI must allow calls from any thread at once
+    int provided = 0;
+    MPI_Query_thread(&provided);
+    if (provided < MPI_THREAD_MULTIPLE) {
+        throw std::runtime_error("MPIEventBridge requires MPI_THREAD_MULTIPLE, MPI provides level " +
+                                 std::to_string(provided));
+    }
+    thread_level_checked = true;
+    #endif
+}
+
+void MPIEventBridge::ringDoorbell() {
+    #ifdef FLUIDLOOM_MPI_ENABLED
+    // At most one ring per blocking episode; the doorbell receive is always
+    // posted while poller_blocking is set, so the zero-byte send matches it.
+    if (poller_blocking.exchange(false)) {
+        MPI_Send(nullptr, 0, MPI_BYTE, 0, DOORBELL_TAG, doorbell_comm);
+    }
+    #endif
+}
+
+void MPIEventBridge::signalBatch(std::vector<PendingCompletion>& batch) {
+    if (batch.empty()) {
+        return;
+    }
+
+    // Stats first: a completed wrapper must already be counted
+    auto now = Clock::now();
+    double batch_latency_us = 0.0;
+    double batch_max_us = 0.0;
+    for (const auto& item : batch) {
+        double latency_us = std::chrono::duration<double, std::micro>(now - item.submitted).count();
+        batch_latency_us += latency_us;
+        batch_max_us = std::max(batch_max_us, latency_us);
+    }
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        stats.requests_completed += batch.size();
+        stats.completion_batches++;
+        stats.max_batch_size = std::max<uint64_t>(stats.max_batch_size, batch.size());
+        stats.total_latency_us += batch_latency_us;
+        stats.max_latency_us = std::max(stats.max_latency_us, batch_max_us);
+    }
+
+    for (auto& item : batch) {
+        // Callback and event first, so whoever waits on the wrapper sees
+        // their effects; the wrapper is marked last because its owner may
+        // destroy it (and anything the callback captured) once it completes
+        if (item.on_complete) {
+            item.on_complete();
+        }
+        if (item.user_event) {
+            clSetUserEventStatus(item.user_event, CL_COMPLETE);
+            clReleaseEvent(item.user_event); // Release our reference
+        }
+        if (item.wrapper) {
+            item.wrapper->markCompleted();
+        }
+    }
 }
 
 void MPIEventBridge::pollingLoop() {
+    #ifdef FLUIDLOOM_MPI_ENABLED
+    std::vector<int> indices;
+    std::vector<size_t> finished;
+    std::vector<PendingCompletion> batch;
+    uint32_t idle_passes = 0;
+
+    auto post_doorbell = [this]() {
+        MPI_Irecv(nullptr, 0, MPI_BYTE, 0, DOORBELL_TAG, doorbell_comm, &active_requests[0]);
+    };
+
     while (true) {
-        std::unique_lock<std::mutex> lock(queue_mutex);
-        queue_cv.wait(lock, [this] { return stop_polling || !pending_tests.empty(); });
-        
-        if (stop_polling && pending_tests.empty()) {
-            break;
+        bool stopping = false;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            if (active_entries.empty()) {
+                queue_cv.wait(lock, [this] { return stop_polling || !incoming.empty(); });
+            }
+
+            if (!incoming.empty() && doorbell_comm == MPI_COMM_NULL) {
+                // First request: MPI is initialized by now, set up the doorbell
+                MPI_Comm_dup(MPI_COMM_SELF, &doorbell_comm);
+                active_requests.assign(1, MPI_REQUEST_NULL);
+                post_doorbell();
+            }
+
+            for (auto& item : incoming) {
+                active_requests.push_back(item.first);
+                active_entries.push_back(std::move(item.second));
+            }
+            incoming.clear();
+
+            stopping = stop_polling;
+            if (stopping && active_entries.empty()) {
+                break;
+            }
+        }
+
+        const int count = static_cast<int>(active_requests.size());
+        indices.resize(active_requests.size());
+        int outcount = 0;
+
+        if (!stopping && idle_passes >= spin_passes.load()) {
+            // Announce the intent to block, then re-check for submissions that
+            // raced the announcement (they would not ring the doorbell).
+            poller_blocking.store(true);
+            bool has_incoming = false;
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex);
+                has_incoming = !incoming.empty() || stop_polling;
+            }
+            if (has_incoming) {
+                poller_blocking.store(false);
+                idle_passes = 0;
+                continue;
+            }
+
+            MPI_Waitsome(count, active_requests.data(), &outcount, indices.data(), MPI_STATUSES_IGNORE);
+            poller_blocking.store(false);
+
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            stats.waitsome_calls++;
+        } else {
+            MPI_Testsome(count, active_requests.data(), &outcount, indices.data(), MPI_STATUSES_IGNORE);
+
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            stats.testsome_calls++;
+        }
+
+        if (outcount == MPI_UNDEFINED) {
+            outcount = 0;
         }
-        
-        // Process pending tests
-        // We iterate and check. If not complete, push back.
-        // This is a busy loop if we are not careful.
-        // Better to pop all, check, and push back incomplete ones.
-        
-        size_t count = pending_tests.size();
-        for (size_t i = 0; i < count; ++i) {
-            auto item = pending_tests.front();
-            pending_tests.pop();
-            
-            if (isMPIComplete(item.first)) {
-                clSetUserEventStatus(item.second, CL_COMPLETE);
-                clReleaseEvent(item.second); // Release our reference
+
+        finished.clear();
+        for (int k = 0; k < outcount; ++k) {
+            if (indices[k] == 0) {
+                post_doorbell(); // Woken by a submission or shutdown; re-arm
             } else {
-                pending_tests.push(item);
+                finished.push_back(static_cast<size_t>(indices[k] - 1));
+            }
+        }
+
+        if (finished.empty()) {
+            ++idle_passes;
+            if (stopping) {
+                std::this_thread::yield(); // Draining on shutdown, don't block
             }
+            continue;
         }
-        
-        lock.unlock();
-        
-        if (!pending_tests.empty()) {
-            std::this_thread::sleep_for(std::chrono::microseconds(10)); // Avoid busy wait
+        idle_passes = 0;
+
+        // Compact the active set back-to-front with swap-and-pop so the
+        // request array stays contiguous for the next Testsome pass
+        std::sort(finished.begin(), finished.end(), std::greater<size_t>());
+        batch.clear();
+        for (size_t entry : finished) {
+            batch.push_back(std::move(active_entries[entry]));
+            size_t last = active_entries.size() - 1;
+            if (entry != last) {
+                active_entries[entry] = std::move(active_entries[last]);
+                active_requests[entry + 1] = active_requests[last + 1];
+            }
+            active_entries.pop_back();
+            active_requests.pop_back();
+        }
+
+        signalBatch(batch);
+    }
+
+    if (doorbell_comm != MPI_COMM_NULL) {
+        if (active_requests[0] != MPI_REQUEST_NULL) {
+            MPI_Cancel(&active_requests[0]);
+            MPI_Request_free(&active_requests[0]);
         }
+        MPI_Comm_free(&doorbell_comm);
+        doorbell_comm = MPI_COMM_NULL;
     }
+    #else
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    queue_cv.wait(lock, [this] { return stop_polling.load(); });
+    #endif
 }
 
 } // namespace transport
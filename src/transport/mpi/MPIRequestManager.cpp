@@ -5,6 +5,13 @@ namespace fluidloom {
 namespace transport {
 
 void MPIRequestWrapper::wait() {
+    if (detached) {
+        // Progress is owned by MPIEventBridge; it unbinds buffers on completion
+        std::unique_lock<std::mutex> lock(detached_mutex);
+        detached_cv.wait(lock, [this] { return detached_complete.load(std::memory_order_acquire); });
+        return;
+    }
+    
     if (type == RequestType::MPI) {
         #ifdef FLUIDLOOM_MPI_ENABLED
         MPI_Wait(&mpi_request, MPI_STATUS_IGNORE);
@@ -18,6 +25,10 @@ void MPIRequestWrapper::wait() {
 }
 
 bool MPIRequestWrapper::test() {
+    if (detached) {
+        return detached_complete.load(std::memory_order_acquire);
+    }
+    
     if (type == RequestType::MPI) {
         #ifdef FLUIDLOOM_MPI_ENABLED
         int flag = 0;
@@ -45,6 +56,11 @@ bool MPIRequestWrapper::test() {
 }
 
 void MPIRequestWrapper::cancel() {
+    if (detached) {
+        // The bridge owns the native handle; it completes (or drains) it
+        return;
+    }
+    
     if (type == RequestType::MPI) {
         #ifdef FLUIDLOOM_MPI_ENABLED
         MPI_Cancel(&mpi_request);
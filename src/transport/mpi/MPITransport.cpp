@@ -1,7 +1,12 @@
 #include "fluidloom/transport/MPITransport.h"
 #include "fluidloom/common/Logger.h"
-#include <stdexcept>
+#include "fluidloom/core/backend/OpenCLBackend.h"
+#include <algorithm>
 #include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
 
 namespace fluidloom {
 namespace transport {
@@ -12,12 +17,21 @@ MPITransport::MPITransport(IBackend* backend)
     
     initialize();
     
-    // Detect GPU devices for peer management
-    // auto devices = backend->getDevices();
-    // if (!devices.empty()) {
-    //     peer_manager = std::make_unique<PeerAccessManager>(devices);
-    //     p2p_available = true;
-    // }
+    if (backend && backend->getType() == BackendType::OPENCL) {
+        auto* opencl = static_cast<OpenCLBackend*>(backend);
+        local_device = opencl->getDevice();
+        
+        // Probe (or load the cached) link matrix of this node's devices
+        const std::vector<cl_device_id>& node_devices = opencl->getDevices();
+        if (local_device && !node_devices.empty()) {
+            peer_manager = std::make_unique<PeerAccessManager>(node_devices);
+            for (auto device : node_devices) {
+                p2p_available = p2p_available ||
+                    (device != local_device && peer_manager->isPeerAccessible(local_device, device));
+            }
+            mapRankDevices(node_devices);
+        }
+    }
     
     FL_LOG(INFO) << "MPITransport initialized on rank " << mpi_rank 
                  << " of " << mpi_size;
@@ -36,7 +50,7 @@ void MPITransport::initialize() {
         // Initialize with thread support (required for async)
         MPI_Init_thread(nullptr, nullptr, MPI_THREAD_MULTIPLE, &provided);
         if (provided != MPI_THREAD_MULTIPLE) {
-            FL_LOG(WARNING) << "MPI_THREAD_MULTIPLE not supported. Performance may degrade.";
+            FL_LOG(WARN) << "MPI_THREAD_MULTIPLE not supported. Performance may degrade.";
         }
         mpi_initialized_here = true;
     }
@@ -72,6 +86,72 @@ void MPITransport::finalize() {
     #endif
 }
 
+PeerAccessManager::LinkProfile MPITransport::getRemoteLinkProfile() const {
+    if (!peer_manager || !local_device) {
+        return {};
+    }
+    return peer_manager->getHostLinkProfile(local_device);
+}
+
+PeerAccessManager::CopyMethod MPITransport::getTransferMethod(int target_rank, size_t bytes) const {
+    cl_device_id remote_device = deviceOfRank(target_rank);
+    if (peer_manager && local_device && remote_device && remote_device != local_device) {
+        return peer_manager->getOptimalMethod(local_device, remote_device, bytes);
+    }
+    return gpu_aware_available ? PeerAccessManager::CopyMethod::GPU_AWARE_MPI
+                               : PeerAccessManager::CopyMethod::STAGING_HOST;
+}
+
+void MPITransport::setPeerAccessManager(std::unique_ptr<PeerAccessManager> manager,
+                                        cl_device_id device,
+                                        std::vector<cl_device_id> devices_by_rank) {
+    peer_manager = std::move(manager);
+    local_device = device;
+    rank_devices = std::move(devices_by_rank);
+    
+    p2p_available = false;
+    for (auto other : rank_devices) {
+        p2p_available = p2p_available ||
+            (peer_manager && other && other != local_device && peer_manager->isPeerAccessible(local_device, other));
+    }
+}
+
+cl_device_id MPITransport::deviceOfRank(int rank) const {
+    if (rank < 0 || static_cast<size_t>(rank) >= rank_devices.size()) {
+        return nullptr;
+    }
+    return rank_devices[rank];
+}
+
+void MPITransport::mapRankDevices(const std::vector<cl_device_id>& node_devices) {
+    // Each rank publishes (host, device index); ranks on the same host name
+    // devices in the same platform order
+    struct Placement {
+        uint64_t host_hash;
+        int64_t device_index;
+    };
+    
+    char host[256] = {0};
+    gethostname(host, sizeof(host) - 1);
+    
+    auto it = std::find(node_devices.begin(), node_devices.end(), local_device);
+    Placement mine{std::hash<std::string>{}(host),
+                   it == node_devices.end() ? -1 : static_cast<int64_t>(it - node_devices.begin())};
+    
+    std::vector<uint8_t> gathered = allGather(&mine, sizeof(mine), nullptr);
+    
+    rank_devices.assign(mpi_size, nullptr);
+    for (int r = 0; r < mpi_size && (r + 1) * sizeof(Placement) <= gathered.size(); ++r) {
+        Placement other;
+        std::memcpy(&other, gathered.data() + r * sizeof(Placement), sizeof(Placement));
+        if (other.host_hash == mine.host_hash && other.device_index >= 0 &&
+            static_cast<size_t>(other.device_index) < node_devices.size()) {
+            rank_devices[r] = node_devices[other.device_index];
+        }
+    }
+    rank_devices[mpi_rank] = local_device;
+}
+
 std::unique_ptr<MPIRequestWrapper> MPITransport::send_async(
     int target_rank, GPUAwareBuffer* buffer, size_t offset, size_t size_bytes, int tag) {
     
@@ -84,10 +164,10 @@ std::unique_ptr<MPIRequestWrapper> MPITransport::send_async(
     #ifdef FLUIDLOOM_MPI_ENABLED
     auto start = std::chrono::high_resolution_clock::now();
     
-    // Determine transport method
-    // Mock logic for now since we don't have full topology map
-    bool use_p2p = false; // useP2P(mpi_rank, target_rank);
-    bool use_gpu_aware = gpu_aware_available && buffer->is_gpu_aware;
+    // Hand MPI the device buffer unless the link matrix prices host staging cheaper
+    PeerAccessManager::CopyMethod method = getTransferMethod(target_rank, size_bytes);
+    bool use_gpu_aware = gpu_aware_available && buffer->is_gpu_aware &&
+                         method != PeerAccessManager::CopyMethod::STAGING_HOST;
     
     // For GPU-aware or staging, we need a device pointer
     void* data_ptr = nullptr;
@@ -272,15 +352,24 @@ std::vector<uint8_t> MPITransport::allGather(const void* send_data, size_t send_
 }
 
 bool MPITransport::useP2P(int src_rank, int dst_rank) const {
-    (void)src_rank; (void)dst_rank; // Suppress unused warnings
-    // Needs mapping from rank to device.
-    // For now, assume 1 rank per GPU and use p2p_available flag.
-    return false; // Placeholder
+    cl_device_id src = deviceOfRank(src_rank);
+    cl_device_id dst = deviceOfRank(dst_rank);
+    if (!peer_manager || !src || !dst || src == dst) {
+        return false;
+    }
+    return peer_manager->getOptimalMethod(src, dst) == PeerAccessManager::CopyMethod::P2P;
 }
 
 bool MPITransport::useGPUAwareMPI(int src_rank, int dst_rank) const {
-    (void)src_rank; (void)dst_rank; // Suppress unused warnings
-    return gpu_aware_available;
+    cl_device_id src = deviceOfRank(src_rank);
+    cl_device_id dst = deviceOfRank(dst_rank);
+    if (!gpu_aware_available) {
+        return false;
+    }
+    if (!peer_manager || !src || !dst || src == dst) {
+        return true; // Off-node: nothing cheaper to compare against
+    }
+    return peer_manager->getOptimalMethod(src, dst) != PeerAccessManager::CopyMethod::STAGING_HOST;
 }
 
 } // namespace transport
@@ -1,72 +1,263 @@
 #include "fluidloom/transport/PeerAccessManager.h"
 #include "fluidloom/common/Logger.h"
 // #include <CL/cl_ext.h> // Not available on all platforms
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
 
 namespace fluidloom {
 namespace transport {
 
-PeerAccessManager::PeerAccessManager(const std::vector<cl_device_id>& gpu_devices) 
+namespace {
+// Micro-transfer sizes: the small copy is dominated by launch/DMA setup cost,
+// the large one by link bandwidth
+constexpr size_t LATENCY_PROBE_BYTES = 4096;
+constexpr size_t BANDWIDTH_PROBE_BYTES = 16u << 20;
+constexpr int LATENCY_PROBE_REPS = 8;
+constexpr int BANDWIDTH_PROBE_REPS = 3;
+
+// Size the legacy getOptimalMethod(src, dst) prices: a typical halo face
+constexpr size_t DEFAULT_MESSAGE_BYTES = 64u << 10;
+
+constexpr const char* CACHE_MAGIC = "fluidloom-peer-links";
+constexpr int CACHE_VERSION = 2;  // 2: device lines carry driver and PCI location
+
+// PCI location queries (cl_khr_pci_bus_info, cl_nv_device_attribute_query);
+// cl_ext.h is not available on all platforms
+constexpr cl_device_info DEVICE_PCI_BUS_INFO_KHR = 0x410F;
+constexpr cl_device_info DEVICE_PCI_BUS_ID_NV = 0x4008;
+constexpr cl_device_info DEVICE_PCI_SLOT_ID_NV = 0x4009;
+
+struct PciBusInfo {
+    cl_uint domain;
+    cl_uint bus;
+    cl_uint device;
+    cl_uint function;
+};
+
+constexpr double INF_COST = std::numeric_limits<double>::infinity();
+
+// Method used for legs that do not go device-to-device
+constexpr PeerAccessManager::CopyMethod offDeviceMethod() {
+    #if defined(FLUIDLOOM_GPU_AWARE_MPI_CUDA) || defined(FLUIDLOOM_GPU_AWARE_MPI_ROCM)
+    return PeerAccessManager::CopyMethod::GPU_AWARE_MPI;
+    #else
+    return PeerAccessManager::CopyMethod::STAGING_HOST;
+    #endif
+}
+
+// Best-of-N wall time of `op` (which must block until the transfer is done)
+template <typename Op>
+double bestTimeUs(int reps, Op op) {
+    double best = INF_COST;
+    for (int r = 0; r < reps; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        if (!op()) {
+            return INF_COST;
+        }
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::micro>(end - start).count());
+    }
+    return best;
+}
+
+// Latency from the small copy, bandwidth from the large copy net of latency
+PeerAccessManager::LinkProfile profileFromTimings(double small_us, double large_us) {
+    PeerAccessManager::LinkProfile profile;
+    if (small_us == INF_COST || large_us == INF_COST) {
+        return profile;
+    }
+    double transfer_us = std::max(large_us - small_us, 1e-3);
+    profile.latency_us = small_us;
+    profile.bandwidth_gbps = static_cast<double>(BANDWIDTH_PROBE_BYTES) / transfer_us / 1e3;
+    return profile;
+}
+
+cl_command_queue createQueue(cl_context context, cl_device_id device, cl_int* err) {
+    #ifdef __APPLE__
+    return clCreateCommandQueueWithPropertiesAPPLE(context, device, 0, err);
+    #else
+    return clCreateCommandQueueWithProperties(context, device, 0, err);
+    #endif
+}
+} // namespace
+
+PeerAccessManager::PeerAccessManager(const std::vector<cl_device_id>& gpu_devices)
     : devices(gpu_devices) {
-    
+
+    const size_t n = devices.size();
+    p2p_links.assign(n, std::vector<LinkProfile>(n));
+    to_host_links.assign(n, LinkProfile{});
+    from_host_links.assign(n, LinkProfile{});
+
+    for (auto device : devices) {
+        device_ids.push_back(deviceIdentity(device));
+    }
+
+    // Probing takes a few hundred ms per pair; reuse this host's last result
+    std::string cache_path = defaultCachePath();
+    if (!cache_path.empty() && loadLinkMatrix(cache_path)) {
+        FL_LOG(INFO) << "Loaded peer link matrix from " << cache_path;
+        return;
+    }
+
     // Build peer matrix
-    for (auto src : devices) {
-        for (auto dst : devices) {
-            if (src == dst) {
-                peer_matrix[{src, dst}] = false; // No self-P2P
+    for (size_t i = 0; i < n; ++i) {
+        probeHostLink(i);
+        for (size_t j = 0; j < n; ++j) {
+            if (i == j) {
+                peer_matrix[{devices[i], devices[j]}] = false; // No self-P2P
                 continue;
             }
-            
-            // Query if devices share the same platform
-            cl_platform_id src_platform, dst_platform;
-            clGetDeviceInfo(src, CL_DEVICE_PLATFORM, sizeof(cl_platform_id), &src_platform, nullptr);
-            clGetDeviceInfo(dst, CL_DEVICE_PLATFORM, sizeof(cl_platform_id), &dst_platform, nullptr);
-            
-            if (src_platform != dst_platform) {
-                peer_matrix[{src, dst}] = false;
-                continue;
-            }
-            
-            // Try to create context with both devices and test copy
-            cl_int err;
-            cl_context_properties props[] = {
-                CL_CONTEXT_PLATFORM, (cl_context_properties)src_platform,
-                0
+            probePair(i, j);
+        }
+    }
+
+    if (!cache_path.empty() && saveLinkMatrix(cache_path)) {
+        FL_LOG(INFO) << "Saved peer link matrix to " << cache_path;
+    }
+}
+
+PeerAccessManager::PeerAccessManager(const std::vector<cl_device_id>& gpu_devices,
+                                     const LinkMatrix& links,
+                                     const std::vector<LinkProfile>& host_links)
+    : devices(gpu_devices), p2p_links(links),
+      to_host_links(host_links), from_host_links(host_links) {
+
+    const size_t n = devices.size();
+    if (p2p_links.size() != n) {
+        throw std::invalid_argument("PeerAccessManager: link matrix must be N x N");
+    }
+    for (const auto& row : p2p_links) {
+        if (row.size() != n) {
+            throw std::invalid_argument("PeerAccessManager: link matrix must be N x N");
+        }
+    }
+    if (host_links.empty()) {
+        to_host_links.assign(n, LinkProfile{});
+        from_host_links.assign(n, LinkProfile{});
+    } else if (host_links.size() != n) {
+        throw std::invalid_argument("PeerAccessManager: need one host link per device");
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        device_ids.push_back("simulated" + std::to_string(i));
+        for (size_t j = 0; j < n; ++j) {
+            peer_matrix[{devices[i], devices[j]}] = (i != j) && p2p_links[i][j].usable();
+        }
+    }
+}
+
+void PeerAccessManager::probePair(size_t i, size_t j) {
+    cl_device_id src = devices[i];
+    cl_device_id dst = devices[j];
+    peer_matrix[{src, dst}] = false;
+
+    // Query if devices share the same platform
+    cl_platform_id src_platform, dst_platform;
+    clGetDeviceInfo(src, CL_DEVICE_PLATFORM, sizeof(cl_platform_id), &src_platform, nullptr);
+    clGetDeviceInfo(dst, CL_DEVICE_PLATFORM, sizeof(cl_platform_id), &dst_platform, nullptr);
+
+    if (src_platform != dst_platform) {
+        return;
+    }
+
+    // Try to create context with both devices and test copy
+    cl_int err;
+    cl_context_properties props[] = {
+        CL_CONTEXT_PLATFORM, (cl_context_properties)src_platform,
+        0
+    };
+    cl_device_id devices_to_test[] = {src, dst};
+    cl_context context = clCreateContext(props, 2, devices_to_test, nullptr, nullptr, &err);
+
+    if (err != CL_SUCCESS) {
+        return;
+    }
+
+    // Allocate test buffers large enough for the bandwidth probe
+    cl_int src_err, dst_err, queue_err, dst_queue_err;
+    cl_mem buf_src = clCreateBuffer(context, CL_MEM_READ_WRITE, BANDWIDTH_PROBE_BYTES, nullptr, &src_err);
+    cl_mem buf_dst = clCreateBuffer(context, CL_MEM_READ_WRITE, BANDWIDTH_PROBE_BYTES, nullptr, &dst_err);
+    cl_command_queue queue = createQueue(context, src, &queue_err);
+    cl_command_queue dst_queue = createQueue(context, dst, &dst_queue_err);
+
+    if (src_err == CL_SUCCESS && dst_err == CL_SUCCESS &&
+        queue_err == CL_SUCCESS && dst_queue_err == CL_SUCCESS) {
+        // Place each buffer on its device so the copy actually crosses the link
+        clEnqueueMigrateMemObjects(queue, 1, &buf_src, CL_MIGRATE_MEM_OBJECT_CONTENT_UNDEFINED, 0, nullptr, nullptr);
+        clEnqueueMigrateMemObjects(dst_queue, 1, &buf_dst, CL_MIGRATE_MEM_OBJECT_CONTENT_UNDEFINED, 0, nullptr, nullptr);
+        clFinish(queue);
+        clFinish(dst_queue);
+
+        // Try P2P copy
+        err = clEnqueueCopyBuffer(queue, buf_src, buf_dst, 0, 0, LATENCY_PROBE_BYTES, 0, nullptr, nullptr);
+        clFinish(queue);
+
+        if (err == CL_SUCCESS) {
+            peer_matrix[{src, dst}] = true;
+
+            auto timed_copy = [&](size_t bytes) {
+                bool ok = clEnqueueCopyBuffer(queue, buf_src, buf_dst, 0, 0, bytes, 0, nullptr, nullptr) == CL_SUCCESS;
+                return clFinish(queue) == CL_SUCCESS && ok;
             };
-            cl_device_id devices_to_test[] = {src, dst};
-            cl_context context = clCreateContext(props, 2, devices_to_test, nullptr, nullptr, &err);
-            
-            if (err != CL_SUCCESS) {
-                peer_matrix[{src, dst}] = false;
-                continue;
-            }
-            
-            // Allocate test buffers
-            cl_mem buf_src = clCreateBuffer(context, CL_MEM_READ_WRITE, 4096, nullptr, &err);
-            cl_mem buf_dst = clCreateBuffer(context, CL_MEM_READ_WRITE, 4096, nullptr, &err);
-            
-            cl_command_queue queue;
-            #ifdef __APPLE__
-            queue = clCreateCommandQueueWithPropertiesAPPLE(context, src, 0, &err);
-            #else
-            queue = clCreateCommandQueueWithProperties(context, src, 0, &err);
-            #endif
-            
-            // Try P2P copy
-            err = clEnqueueCopyBuffer(queue, buf_src, buf_dst, 0, 0, 4096, 0, nullptr, nullptr);
-            clFinish(queue);
-            
-            peer_matrix[{src, dst}] = (err == CL_SUCCESS);
-            
-            // Cleanup
-            clReleaseMemObject(buf_src);
-            clReleaseMemObject(buf_dst);
-            clReleaseCommandQueue(queue);
-            clReleaseContext(context);
-            
-            FL_LOG(DEBUG) << "P2P " << src << " -> " << dst << ": " 
-                         << (peer_matrix[{src, dst}] ? "YES" : "NO");
+            double small_us = bestTimeUs(LATENCY_PROBE_REPS, [&] { return timed_copy(LATENCY_PROBE_BYTES); });
+            double large_us = bestTimeUs(BANDWIDTH_PROBE_REPS, [&] { return timed_copy(BANDWIDTH_PROBE_BYTES); });
+            p2p_links[i][j] = profileFromTimings(small_us, large_us);
         }
     }
+
+    // Cleanup
+    if (buf_src) clReleaseMemObject(buf_src);
+    if (buf_dst) clReleaseMemObject(buf_dst);
+    if (queue) clReleaseCommandQueue(queue);
+    if (dst_queue) clReleaseCommandQueue(dst_queue);
+    clReleaseContext(context);
+
+    FL_LOG(DEBUG) << "P2P " << src << " -> " << dst << ": "
+                 << (peer_matrix[{src, dst}] ? "YES" : "NO")
+                 << " (" << p2p_links[i][j].latency_us << " us, "
+                 << p2p_links[i][j].bandwidth_gbps << " GB/s)";
+}
+
+void PeerAccessManager::probeHostLink(size_t i) {
+    cl_int err;
+    cl_context context = clCreateContext(nullptr, 1, &devices[i], nullptr, nullptr, &err);
+    if (err != CL_SUCCESS) {
+        return;
+    }
+
+    cl_int buf_err, queue_err;
+    cl_mem buffer = clCreateBuffer(context, CL_MEM_READ_WRITE, BANDWIDTH_PROBE_BYTES, nullptr, &buf_err);
+    cl_command_queue queue = createQueue(context, devices[i], &queue_err);
+
+    if (buf_err == CL_SUCCESS && queue_err == CL_SUCCESS) {
+        std::vector<char> host(BANDWIDTH_PROBE_BYTES);
+        auto write = [&](size_t bytes) {
+            return clEnqueueWriteBuffer(queue, buffer, CL_TRUE, 0, bytes, host.data(), 0, nullptr, nullptr) == CL_SUCCESS;
+        };
+        auto read = [&](size_t bytes) {
+            return clEnqueueReadBuffer(queue, buffer, CL_TRUE, 0, bytes, host.data(), 0, nullptr, nullptr) == CL_SUCCESS;
+        };
+        from_host_links[i] = profileFromTimings(
+            bestTimeUs(LATENCY_PROBE_REPS, [&] { return write(LATENCY_PROBE_BYTES); }),
+            bestTimeUs(BANDWIDTH_PROBE_REPS, [&] { return write(BANDWIDTH_PROBE_BYTES); }));
+        to_host_links[i] = profileFromTimings(
+            bestTimeUs(LATENCY_PROBE_REPS, [&] { return read(LATENCY_PROBE_BYTES); }),
+            bestTimeUs(BANDWIDTH_PROBE_REPS, [&] { return read(BANDWIDTH_PROBE_BYTES); }));
+    }
+
+    if (buffer) clReleaseMemObject(buffer);
+    if (queue) clReleaseCommandQueue(queue);
+    clReleaseContext(context);
 }
 
 bool PeerAccessManager::isPeerAccessible(cl_device_id src, cl_device_id dst) const {
@@ -76,16 +267,272 @@ bool PeerAccessManager::isPeerAccessible(cl_device_id src, cl_device_id dst) con
 
 PeerAccessManager::CopyMethod PeerAccessManager::getOptimalMethod(
     cl_device_id src, cl_device_id dst) const {
-    
-    if (isPeerAccessible(src, dst)) {
-        return CopyMethod::P2P;
+    return getOptimalMethod(src, dst, DEFAULT_MESSAGE_BYTES);
+}
+
+PeerAccessManager::CopyMethod PeerAccessManager::getOptimalMethod(
+    cl_device_id src, cl_device_id dst, size_t bytes) const {
+    return getRoute(src, dst, bytes).method();
+}
+
+double PeerAccessManager::legCostUs(size_t src, size_t dst, size_t bytes, CopyMethod* method) const {
+    double p2p_cost = p2p_links[src][dst].usable() ? p2p_links[src][dst].costUs(bytes) : INF_COST;
+    double staged_cost = (to_host_links[src].usable() && from_host_links[dst].usable())
+        ? to_host_links[src].costUs(bytes) + from_host_links[dst].costUs(bytes)
+        : INF_COST;
+
+    if (p2p_cost <= staged_cost && p2p_cost < INF_COST) {
+        *method = CopyMethod::P2P;
+        return p2p_cost;
     }
-    
-    #ifdef FLUIDLOOM_GPU_AWARE_MPI
-    return CopyMethod::GPU_AWARE_MPI;
-    #else
-    return CopyMethod::STAGING_HOST;
-    #endif
+    *method = offDeviceMethod();
+    return staged_cost;
+}
+
+PeerAccessManager::Route PeerAccessManager::getRoute(
+    cl_device_id src, cl_device_id dst, size_t bytes) const {
+
+    Route route;
+    route.hops = {src, dst};
+
+    int s = indexOf(src);
+    int d = indexOf(dst);
+    if (s < 0 || d < 0 || s == d) {
+        // Unknown device or self: no cost data, fall back on the capability check
+        route.legs = {isPeerAccessible(src, dst) ? CopyMethod::P2P : offDeviceMethod()};
+        return route;
+    }
+
+    // Exhaustive search over simple paths of at most max_legs legs. Relays are
+    // P2P only (staging through a third device is never better than staging
+    // directly); the final leg may use either method. Device counts per node
+    // are small, so this stays far below the cost of the transfer itself.
+    double best_cost = INF_COST;
+    std::vector<size_t> path = {static_cast<size_t>(s)};
+    std::vector<CopyMethod> methods;
+    std::vector<bool> visited(devices.size(), false);
+    visited[s] = true;
+
+    std::function<void(double)> search = [&](double cost) {
+        size_t u = path.back();
+
+        CopyMethod last_method;
+        double total = cost + legCostUs(u, d, bytes, &last_method);
+        if (total < best_cost) {
+            best_cost = total;
+            route.hops.clear();
+            for (size_t idx : path) route.hops.push_back(devices[idx]);
+            route.hops.push_back(dst);
+            route.legs = methods;
+            route.legs.push_back(last_method);
+        }
+
+        if (methods.size() + 1 >= max_legs) {
+            return;
+        }
+        for (size_t v = 0; v < devices.size(); ++v) {
+            if (visited[v] || static_cast<int>(v) == d || !p2p_links[u][v].usable()) {
+                continue;
+            }
+            double relay_cost = cost + p2p_links[u][v].costUs(bytes);
+            if (relay_cost >= best_cost) {
+                continue;
+            }
+            visited[v] = true;
+            path.push_back(v);
+            methods.push_back(CopyMethod::P2P);
+            search(relay_cost);
+            methods.pop_back();
+            path.pop_back();
+            visited[v] = false;
+        }
+    };
+    search(0.0);
+
+    if (best_cost == INF_COST) {
+        // Nothing measured for this pair: behave like the capability-only check
+        route.hops = {src, dst};
+        route.legs = {isPeerAccessible(src, dst) ? CopyMethod::P2P : offDeviceMethod()};
+        return route;
+    }
+
+    route.estimated_us = best_cost;
+    return route;
+}
+
+int PeerAccessManager::indexOf(cl_device_id device) const {
+    auto it = std::find(devices.begin(), devices.end(), device);
+    return it == devices.end() ? -1 : static_cast<int>(it - devices.begin());
+}
+
+PeerAccessManager::LinkProfile PeerAccessManager::getLinkProfile(cl_device_id src, cl_device_id dst) const {
+    int s = indexOf(src);
+    int d = indexOf(dst);
+    if (s < 0 || d < 0 || s == d) {
+        return LinkProfile{};
+    }
+    return p2p_links[s][d];
+}
+
+PeerAccessManager::LinkProfile PeerAccessManager::getHostLinkProfile(cl_device_id device) const {
+    int i = indexOf(device);
+    if (i < 0) {
+        return LinkProfile{};
+    }
+    // The staging path is bounded by the slower direction
+    const LinkProfile& down = to_host_links[i];
+    const LinkProfile& up = from_host_links[i];
+    return down.costUs(BANDWIDTH_PROBE_BYTES) >= up.costUs(BANDWIDTH_PROBE_BYTES) ? down : up;
+}
+
+std::string PeerAccessManager::deviceIdentity(cl_device_id device) {
+    auto info = [device](cl_device_info param) {
+        char value[256] = {0};
+        clGetDeviceInfo(device, param, sizeof(value) - 1, value, nullptr);
+        return std::string(value);
+    };
+    std::string id = info(CL_DEVICE_NAME) + " | " + info(CL_DRIVER_VERSION);
+
+    // Identical boards are told apart by where they sit on the bus
+    char pci[64] = {0};
+    PciBusInfo bus_info{};
+    cl_uint nv_bus = 0, nv_slot = 0;
+    if (clGetDeviceInfo(device, DEVICE_PCI_BUS_INFO_KHR, sizeof(bus_info), &bus_info, nullptr) == CL_SUCCESS) {
+        std::snprintf(pci, sizeof(pci), " | pci %04x:%02x:%02x.%x",
+                      bus_info.domain, bus_info.bus, bus_info.device, bus_info.function);
+    } else if (clGetDeviceInfo(device, DEVICE_PCI_BUS_ID_NV, sizeof(nv_bus), &nv_bus, nullptr) == CL_SUCCESS &&
+               clGetDeviceInfo(device, DEVICE_PCI_SLOT_ID_NV, sizeof(nv_slot), &nv_slot, nullptr) == CL_SUCCESS) {
+        std::snprintf(pci, sizeof(pci), " | pci %02x:%02x", nv_bus, nv_slot >> 3);
+    }
+    return id + pci;
+}
+
+std::string PeerAccessManager::defaultCachePath() {
+    std::string dir;
+    if (const char* env_dir = std::getenv("FL_PEER_CACHE_DIR")) {
+        dir = env_dir; // Set but empty disables caching
+    } else if (const char* home = std::getenv("HOME")) {
+        dir = std::string(home) + "/.cache/fluidloom";
+    }
+    if (dir.empty()) {
+        return {};
+    }
+
+    char host[256] = {0};
+    if (gethostname(host, sizeof(host) - 1) != 0) {
+        return {};
+    }
+    return dir + "/peer_links_" + host + ".txt";
+}
+
+bool PeerAccessManager::saveLinkMatrix(const std::string& path) const {
+    std::error_code ec;
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent, ec);
+    }
+
+    // Concurrent ranks on one host may save at once: write privately, then rename
+    const std::string tmp_path = path + ".tmp." + std::to_string(getpid());
+    std::ofstream out(tmp_path);
+    if (!out) {
+        FL_LOG(WARN) << "Cannot write peer link cache " << path;
+        return false;
+    }
+
+    out << CACHE_MAGIC << " " << CACHE_VERSION << "\n";
+    out << devices.size() << "\n";
+    for (const auto& id : device_ids) {
+        out << id << "\n";
+    }
+    out.precision(17);
+    for (size_t i = 0; i < devices.size(); ++i) {
+        out << "host " << i << " "
+            << to_host_links[i].latency_us << " " << to_host_links[i].bandwidth_gbps << " "
+            << from_host_links[i].latency_us << " " << from_host_links[i].bandwidth_gbps << "\n";
+    }
+    for (size_t i = 0; i < devices.size(); ++i) {
+        for (size_t j = 0; j < devices.size(); ++j) {
+            if (i != j) {
+                out << "p2p " << i << " " << j << " "
+                    << p2p_links[i][j].latency_us << " " << p2p_links[i][j].bandwidth_gbps << "\n";
+            }
+        }
+    }
+    out.close();
+    if (!out) {
+        std::filesystem::remove(tmp_path, ec);
+        FL_LOG(WARN) << "Cannot write peer link cache " << path;
+        return false;
+    }
+
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmp_path, ec);
+        FL_LOG(WARN) << "Cannot replace peer link cache " << path;
+        return false;
+    }
+    return true;
+}
+
+bool PeerAccessManager::loadLinkMatrix(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+
+    std::string magic;
+    int version = 0;
+    size_t count = 0;
+    if (!(in >> magic >> version >> count) || magic != CACHE_MAGIC ||
+        version != CACHE_VERSION || count != devices.size()) {
+        return false;
+    }
+    in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+    // Device identities contain spaces: one per line
+    for (size_t i = 0; i < count; ++i) {
+        std::string id;
+        if (!std::getline(in, id) || id != device_ids[i]) {
+            FL_LOG(INFO) << "Peer link cache " << path << " is for a different device set";
+            return false;
+        }
+    }
+
+    const size_t n = devices.size();
+    LinkMatrix links(n, std::vector<LinkProfile>(n));
+    std::vector<LinkProfile> to_host(n), from_host(n);
+
+    std::string kind;
+    while (in >> kind) {
+        size_t i = 0, j = 0;
+        if (kind == "host") {
+            LinkProfile down, up;
+            if (!(in >> i >> down.latency_us >> down.bandwidth_gbps >> up.latency_us >> up.bandwidth_gbps) || i >= n) {
+                return false;
+            }
+            to_host[i] = down;
+            from_host[i] = up;
+        } else if (kind == "p2p") {
+            LinkProfile link;
+            if (!(in >> i >> j >> link.latency_us >> link.bandwidth_gbps) || i >= n || j >= n) {
+                return false;
+            }
+            links[i][j] = link;
+        } else {
+            return false;
+        }
+    }
+
+    p2p_links = std::move(links);
+    to_host_links = std::move(to_host);
+    from_host_links = std::move(from_host);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            peer_matrix[{devices[i], devices[j]}] = (i != j) && p2p_links[i][j].usable();
+        }
+    }
+    return true;
 }
 
 cl_int PeerAccessManager::enablePeerAccess(cl_device_id src, cl_device_id dst) {
@@ -107,11 +554,13 @@ void PeerAccessManager::disablePeerAccess(cl_device_id src, cl_device_id dst) {
 
 void PeerAccessManager::printPeerMatrix() const {
     FL_LOG(INFO) << "Peer Access Matrix:";
-    for (auto src : devices) {
-        for (auto dst : devices) {
-            if (src != dst) {
-                FL_LOG(INFO) << src << " -> " << dst << ": " 
-                             << (isPeerAccessible(src, dst) ? "YES" : "NO");
+    for (size_t i = 0; i < devices.size(); ++i) {
+        for (size_t j = 0; j < devices.size(); ++j) {
+            if (i != j) {
+                FL_LOG(INFO) << devices[i] << " -> " << devices[j] << ": "
+                             << (isPeerAccessible(devices[i], devices[j]) ? "YES" : "NO")
+                             << " (" << p2p_links[i][j].latency_us << " us, "
+                             << p2p_links[i][j].bandwidth_gbps << " GB/s)";
             }
         }
     }
@@ -0,0 +1,105 @@
+#include <benchmark/benchmark.h>
+#include "fluidloom/core/backend/OpenCLBackend.h"
+#include "fluidloom/core/hilbert/HilbertCodec.h"
+#include <random>
+#include <vector>
+
+using namespace fluidloom;
+
+// Host loop vs. hilbert_encode_batch for the finest-level keys of N cells
+class HilbertBenchmark : public benchmark::Fixture {
+public:
+    void SetUp(const ::benchmark::State& state) override {
+        size_t num_cells = state.range(0);
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<int32_t> dist(0, (1 << hilbert::MAX_REFINEMENT_LEVEL) - 1);
+        
+        x.resize(num_cells);
+        y.resize(num_cells);
+        z.resize(num_cells);
+        packed.assign(num_cells * 4, 0);
+        for (size_t i = 0; i < num_cells; ++i) {
+            x[i] = packed[i * 4 + 0] = dist(gen);
+            y[i] = packed[i * 4 + 1] = dist(gen);
+            z[i] = packed[i * 4 + 2] = dist(gen);
+        }
+        keys.resize(num_cells);
+    }
+
+    void TearDown(const ::benchmark::State& state) override {
+        (void)state;
+        encoder.reset();
+        coords_buffer.reset();
+        keys_buffer.reset();
+        if (backend) backend->shutdown();
+        backend.reset();
+    }
+
+    bool setUpDevice(size_t num_cells) {
+        try {
+            backend = std::make_unique<OpenCLBackend>();
+            backend->initialize(0);
+            encoder = std::make_unique<hilbert::DeviceEncoder>(*backend);
+        } catch (const std::exception&) {
+            encoder.reset();
+            backend.reset();
+            return false;
+        }
+        coords_buffer = backend->allocateBuffer(packed.size() * sizeof(int32_t), packed.data());
+        keys_buffer = backend->allocateBuffer(num_cells * sizeof(hilbert::HilbertIndex));
+        return true;
+    }
+
+    std::vector<int32_t> x, y, z;
+    std::vector<int32_t> packed;  // cl_int3 layout
+    std::vector<hilbert::HilbertIndex> keys;
+    
+    std::unique_ptr<OpenCLBackend> backend;
+    std::unique_ptr<hilbert::DeviceEncoder> encoder;
+    DeviceBufferPtr coords_buffer;
+    DeviceBufferPtr keys_buffer;
+};
+
+BENCHMARK_DEFINE_F(HilbertBenchmark, HostEncode)(benchmark::State& state) {
+    size_t num_cells = state.range(0);
+    for (auto _ : state) {
+        hilbert::encodeBatch(x.data(), y.data(), z.data(), nullptr, keys.data(), num_cells);
+        benchmark::DoNotOptimize(keys.data());
+    }
+    state.SetItemsProcessed(state.iterations() * num_cells);
+}
+
+// Kernel only: coordinates already resident, keys stay on the device
+BENCHMARK_DEFINE_F(HilbertBenchmark, DeviceEncode)(benchmark::State& state) {
+    size_t num_cells = state.range(0);
+    if (!setUpDevice(num_cells)) {
+        state.SkipWithError("No OpenCL device available");
+        return;
+    }
+    for (auto _ : state) {
+        encoder->encode(*coords_buffer, nullptr, *keys_buffer, num_cells);
+        backend->finish();
+    }
+    state.SetItemsProcessed(state.iterations() * num_cells);
+}
+
+// Including upload of coordinates and download of keys (GeometryPlacer path)
+BENCHMARK_DEFINE_F(HilbertBenchmark, DeviceEncodeRoundTrip)(benchmark::State& state) {
+    size_t num_cells = state.range(0);
+    if (!setUpDevice(num_cells)) {
+        state.SkipWithError("No OpenCL device available");
+        return;
+    }
+    for (auto _ : state) {
+        backend->copyHostToDevice(packed.data(), *coords_buffer, packed.size() * sizeof(int32_t));
+        encoder->encode(*coords_buffer, nullptr, *keys_buffer, num_cells);
+        backend->copyDeviceToHost(*keys_buffer, keys.data(), num_cells * sizeof(hilbert::HilbertIndex));
+    }
+    state.SetItemsProcessed(state.iterations() * num_cells);
+}
+
+BENCHMARK_REGISTER_F(HilbertBenchmark, HostEncode)->RangeMultiplier(8)->Range(1 << 12, 1 << 22);
+BENCHMARK_REGISTER_F(HilbertBenchmark, DeviceEncode)->RangeMultiplier(8)->Range(1 << 12, 1 << 22);
+BENCHMARK_REGISTER_F(HilbertBenchmark, DeviceEncodeRoundTrip)->RangeMultiplier(8)->Range(1 << 12, 1 << 22);
+
+BENCHMARK_MAIN();
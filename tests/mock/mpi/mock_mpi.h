@@ -4,10 +4,15 @@
 #ifdef FLUIDLOOM_MOCK_MPI
 
 #include <unordered_map>
+#include <mutex>
+#include <thread>
+#include <utility>
 
 #define MPI_SUCCESS 0
+#define MPI_THREAD_FUNNELED 1
 #define MPI_THREAD_MULTIPLE 3
 #define MPI_BYTE 0x4c00010d
+#define MPI_UNDEFINED (-32766)
 
 typedef struct ompi_communicator_t* MPI_Comm;
 typedef struct ompi_request_t* MPI_Request;
@@ -15,6 +20,9 @@ typedef struct { int MPI_SOURCE; int MPI_TAG; int MPI_ERROR; } MPI_Status;
 typedef int MPI_Datatype;
 
 #define MPI_COMM_WORLD ((MPI_Comm)0x44000000)
+#define MPI_COMM_SELF ((MPI_Comm)0x44000001)
+#define MPI_COMM_NULL ((MPI_Comm)0)
+#define MPI_REQUEST_NULL ((MPI_Request)0)
 #define MPI_STATUS_IGNORE ((MPI_Status*)0)
 #define MPI_STATUSES_IGNORE ((MPI_Status*)0)
 
@@ -23,24 +31,76 @@ extern int mock_mpi_rank;
 extern int mock_mpi_size;
 extern std::unordered_map<MPI_Request, bool> mock_mpi_request_complete;
 
+// Guards mock_mpi_request_complete so a progress thread (MPIEventBridge) can
+// test requests while the test thread posts and completes them.
+inline std::mutex& mock_mpi_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+// Receives posted with MPI_Irecv, keyed by request, so MPI_Send can match them
+inline std::unordered_map<MPI_Request, std::pair<MPI_Comm, int>>& mock_mpi_posted_recvs() {
+    static std::unordered_map<MPI_Request, std::pair<MPI_Comm, int>> recvs;
+    return recvs;
+}
+
+// Test hook: thread support level reported by MPI_Query_thread
+inline int& mock_mpi_thread_level() {
+    static int level = MPI_THREAD_MULTIPLE;
+    return level;
+}
+
+// Test hook: simulate the network completing a request
+inline void mock_mpi_complete_request(MPI_Request req) {
+    std::lock_guard<std::mutex> lock(mock_mpi_mutex());
+    mock_mpi_request_complete[req] = true;
+}
+
 // Mock functions
 inline int MPI_Initialized(int* flag) { *flag = 1; return MPI_SUCCESS; }
-inline int MPI_Init_thread(void* a, void* b, int c, int* d) { 
-    mock_mpi_rank = 0; mock_mpi_size = 1; *d = MPI_THREAD_MULTIPLE; return MPI_SUCCESS; 
+inline int MPI_Init_thread(void*, void*, int, int* d) {
+    mock_mpi_rank = 0; mock_mpi_size = 1; *d = MPI_THREAD_MULTIPLE; return MPI_SUCCESS;
 }
+inline int MPI_Query_thread(int* provided) { *provided = mock_mpi_thread_level(); return MPI_SUCCESS; }
 inline int MPI_Comm_rank(MPI_Comm, int* rank) { *rank = mock_mpi_rank; return MPI_SUCCESS; }
 inline int MPI_Comm_size(MPI_Comm, int* size) { *size = mock_mpi_size; return MPI_SUCCESS; }
-inline int MPI_Isend(void* buf, int count, MPI_Datatype, int dest, int tag, MPI_Comm, MPI_Request* req) {
+inline int MPI_Comm_dup(MPI_Comm, MPI_Comm* newcomm) {
+    *newcomm = (MPI_Comm)(new char[1]);
+    return MPI_SUCCESS;
+}
+inline int MPI_Comm_free(MPI_Comm* comm) {
+    delete[] (char*)*comm;
+    *comm = nullptr;
+    return MPI_SUCCESS;
+}
+inline int MPI_Isend(const void*, int, MPI_Datatype, int, int, MPI_Comm, MPI_Request* req) {
+    std::lock_guard<std::mutex> lock(mock_mpi_mutex());
     *req = (MPI_Request)(new char[1]); // Dummy allocation
     mock_mpi_request_complete[*req] = false;
     return MPI_SUCCESS;
 }
-inline int MPI_Irecv(void* buf, int count, MPI_Datatype, int src, int tag, MPI_Comm, MPI_Request* req) {
+inline int MPI_Irecv(void*, int, MPI_Datatype, int, int tag, MPI_Comm comm, MPI_Request* req) {
+    std::lock_guard<std::mutex> lock(mock_mpi_mutex());
     *req = (MPI_Request)(new char[1]);
     mock_mpi_request_complete[*req] = false;
+    mock_mpi_posted_recvs()[*req] = {comm, tag};
+    return MPI_SUCCESS;
+}
+// Blocking send completes the first matching posted receive (no buffering)
+inline int MPI_Send(const void*, int, MPI_Datatype, int, int tag, MPI_Comm comm) {
+    std::lock_guard<std::mutex> lock(mock_mpi_mutex());
+    auto& recvs = mock_mpi_posted_recvs();
+    for (auto it = recvs.begin(); it != recvs.end(); ++it) {
+        if (it->second.first == comm && it->second.second == tag) {
+            mock_mpi_request_complete[it->first] = true;
+            recvs.erase(it);
+            break;
+        }
+    }
     return MPI_SUCCESS;
 }
 inline int MPI_Waitall(int count, MPI_Request* reqs, MPI_Status*) {
+    std::lock_guard<std::mutex> lock(mock_mpi_mutex());
     for (int i = 0; i < count; ++i) {
         mock_mpi_request_complete[reqs[i]] = true;
         delete[] (char*)reqs[i];
@@ -48,22 +108,55 @@ inline int MPI_Waitall(int count, MPI_Request* reqs, MPI_Status*) {
     return MPI_SUCCESS;
 }
 inline int MPI_Wait(MPI_Request* req, MPI_Status*) {
+    std::lock_guard<std::mutex> lock(mock_mpi_mutex());
     mock_mpi_request_complete[*req] = true;
     delete[] (char*)*req;
     return MPI_SUCCESS;
 }
 inline int MPI_Test(MPI_Request* req, int* flag, MPI_Status*) {
+    std::lock_guard<std::mutex> lock(mock_mpi_mutex());
     *flag = mock_mpi_request_complete[*req];
     if (*flag) {
         delete[] (char*)*req;
     }
     return MPI_SUCCESS;
 }
-inline int MPI_Cancel(MPI_Request* req) {
+// Completed requests are freed and set to MPI_REQUEST_NULL, as in real MPI
+inline int MPI_Testsome(int incount, MPI_Request* reqs, int* outcount, int* indices, MPI_Status*) {
+    std::lock_guard<std::mutex> lock(mock_mpi_mutex());
+    int active = 0;
+    *outcount = 0;
+    for (int i = 0; i < incount; ++i) {
+        if (reqs[i] == MPI_REQUEST_NULL) continue;
+        ++active;
+        auto it = mock_mpi_request_complete.find(reqs[i]);
+        if (it != mock_mpi_request_complete.end() && it->second) {
+            mock_mpi_request_complete.erase(it);
+            mock_mpi_posted_recvs().erase(reqs[i]);
+            delete[] (char*)reqs[i];
+            reqs[i] = MPI_REQUEST_NULL;
+            indices[(*outcount)++] = i;
+        }
+    }
+    if (active == 0) *outcount = MPI_UNDEFINED;
+    return MPI_SUCCESS;
+}
+inline int MPI_Waitsome(int incount, MPI_Request* reqs, int* outcount, int* indices, MPI_Status* statuses) {
+    while (true) {
+        MPI_Testsome(incount, reqs, outcount, indices, statuses);
+        if (*outcount != 0) return MPI_SUCCESS;
+        std::this_thread::yield();
+    }
+}
+inline int MPI_Cancel(MPI_Request*) {
     return MPI_SUCCESS;
 }
 inline int MPI_Request_free(MPI_Request* req) {
+    std::lock_guard<std::mutex> lock(mock_mpi_mutex());
+    mock_mpi_request_complete.erase(*req);
+    mock_mpi_posted_recvs().erase(*req);
     delete[] (char*)*req;
+    *req = MPI_REQUEST_NULL;
     return MPI_SUCCESS;
 }
 inline int MPI_Finalize() { return MPI_SUCCESS; }
@@ -0,0 +1,6 @@
+#pragma once
+
+// Drop-in <mpi.h> for test targets that compile transport sources against the
+// mock: put tests/mock/mpi/shim ahead of the system MPI include path and
+// define FLUIDLOOM_MOCK_MPI.
+#include "../mock_mpi.h"
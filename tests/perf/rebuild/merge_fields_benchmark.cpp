@@ -0,0 +1,229 @@
+#include <benchmark/benchmark.h>
+
+#ifdef __APPLE__
+#include <OpenCL/opencl.h>
+#else
+#include <CL/cl.h>
+#endif
+
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Throughput of the merge field average: gather vs scatter
+ *
+ * Gather is the shipped merge_fields kernel (one work-item per parent reads
+ * its 8 children through the sibling table). Scatter is the kernel it
+ * replaced (one work-item per child adding into the parent with a CAS-loop
+ * float atomic), kept here verbatim as the baseline.
+ *
+ * Children are laid out in Hilbert order, so the 8 siblings of a group are
+ * contiguous, as after a rebuild. Reports bytes/s over child reads plus
+ * parent writes. Needs an OpenCL device; skips otherwise.
+ */
+
+#ifndef FL_SOURCE_DIR
+#define FL_SOURCE_DIR "."
+#endif
+
+namespace {
+
+const char* SCATTER_SOURCE = R"CLC(
+inline void atomic_add_float(volatile __global float *addr, float val) {
+    union { unsigned int u32; float f32; } next, expected, current;
+    current.f32 = *addr;
+    do {
+        expected.f32 = current.f32;
+        next.f32 = expected.f32 + val;
+        current.u32 = atomic_cmpxchg((volatile __global unsigned int *)addr,
+                                     expected.u32, next.u32);
+    } while (current.u32 != expected.u32);
+}
+
+__kernel void merge_fields_scatter(
+    __global const uint* restrict merge_group_id,
+    __global const uint* restrict group_to_parent,
+    __global const float* restrict input_field,
+    __global float* restrict output_field,
+    const uint num_components,
+    const uint averaging_rule,
+    const uint num_cells) {
+
+    uint gid = get_global_id(0);
+    if (gid >= num_cells) return;
+    uint group_id = merge_group_id[gid];
+    if (group_id == 0xFFFFFFFF) return;
+    uint parent_idx = group_to_parent[group_id];
+    for (uint comp = 0; comp < num_components; ++comp) {
+        float val = input_field[gid * num_components + comp];
+        if (averaging_rule == 0) val *= 0.125f;
+        atomic_add_float(&output_field[parent_idx * num_components + comp], val);
+    }
+}
+)CLC";
+
+std::string readSource(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open kernel source: " + path);
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+// Same concatenation as MergeEngine::compileKernels
+std::string gatherSource() {
+    const std::string dir = std::string(FL_SOURCE_DIR) + "/src/adaptation/kernels/";
+    std::string merge_src = readSource(dir + "merge_cells.cl");
+    const std::string include = "#include \"hilbert_encode_3d.cl\"";
+    size_t pos = merge_src.find(include);
+    if (pos != std::string::npos) {
+        merge_src.replace(pos, include.size(), "// " + include);
+    }
+    return readSource(dir + "hilbert_encode_3d.cl") + "\n" + merge_src;
+}
+
+struct MergeBench {
+    cl_context context = nullptr;
+    cl_command_queue queue = nullptr;
+    cl_program gather_program = nullptr;
+    cl_program scatter_program = nullptr;
+    cl_kernel gather = nullptr;
+    cl_kernel scatter = nullptr;
+    std::string error;
+
+    MergeBench() {
+        cl_platform_id platform;
+        cl_device_id device;
+        cl_uint count = 0;
+        if (clGetPlatformIDs(1, &platform, &count) != CL_SUCCESS || count == 0 ||
+            clGetDeviceIDs(platform, CL_DEVICE_TYPE_ALL, 1, &device, &count) != CL_SUCCESS || count == 0) {
+            error = "No OpenCL device";
+            return;
+        }
+        cl_int err;
+        context = clCreateContext(nullptr, 1, &device, nullptr, nullptr, &err);
+        queue = clCreateCommandQueue(context, device, 0, &err);
+        try {
+            const std::string gather_src = gatherSource();
+            gather_program = build(gather_src, device);
+            scatter_program = build(SCATTER_SOURCE, device);
+        } catch (const std::exception& e) {
+            error = e.what();
+            return;
+        }
+        gather = clCreateKernel(gather_program, "merge_fields", &err);
+        scatter = clCreateKernel(scatter_program, "merge_fields_scatter", &err);
+    }
+
+    ~MergeBench() {
+        if (gather) clReleaseKernel(gather);
+        if (scatter) clReleaseKernel(scatter);
+        if (gather_program) clReleaseProgram(gather_program);
+        if (scatter_program) clReleaseProgram(scatter_program);
+        if (queue) clReleaseCommandQueue(queue);
+        if (context) clReleaseContext(context);
+    }
+
+    cl_program build(const std::string& src, cl_device_id device) {
+        const char* str = src.c_str();
+        size_t len = src.size();
+        cl_int err;
+        cl_program program = clCreateProgramWithSource(context, 1, &str, &len, &err);
+        if (err != CL_SUCCESS || clBuildProgram(program, 1, &device, "-cl-std=CL1.2", nullptr, nullptr) != CL_SUCCESS) {
+            throw std::runtime_error("Failed to build merge kernels");
+        }
+        return program;
+    }
+};
+
+MergeBench& bench() {
+    static MergeBench instance;
+    return instance;
+}
+
+enum class Variant { Gather, Scatter };
+
+void runMerge(benchmark::State& state, Variant variant) {
+    MergeBench& b = bench();
+    if (!b.error.empty()) {
+        state.SkipWithError(b.error.c_str());
+        return;
+    }
+
+    const cl_uint num_groups = static_cast<cl_uint>(state.range(0));
+    const cl_uint num_components = static_cast<cl_uint>(state.range(1));
+    const cl_uint num_children = num_groups * 8;
+    const cl_uint rule = 0;  // ARITHMETIC
+
+    std::vector<uint32_t> group_children(num_children);
+    std::iota(group_children.begin(), group_children.end(), 0u);
+    std::vector<uint32_t> merge_group_id(num_children);
+    for (cl_uint i = 0; i < num_children; ++i) merge_group_id[i] = i / 8;
+    std::vector<uint32_t> group_to_parent(num_groups);
+    std::iota(group_to_parent.begin(), group_to_parent.end(), 0u);
+    std::vector<float> fields(static_cast<size_t>(num_children) * num_components);
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> dist(0.9f, 1.1f);
+    for (auto& v : fields) v = dist(rng);
+
+    cl_int err;
+    auto upload = [&](const void* data, size_t bytes) {
+        return clCreateBuffer(b.context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, bytes, const_cast<void*>(data), &err);
+    };
+    cl_mem d_children = upload(group_children.data(), group_children.size() * sizeof(uint32_t));
+    cl_mem d_group_id = upload(merge_group_id.data(), merge_group_id.size() * sizeof(uint32_t));
+    cl_mem d_to_parent = upload(group_to_parent.data(), group_to_parent.size() * sizeof(uint32_t));
+    cl_mem d_fields = upload(fields.data(), fields.size() * sizeof(float));
+    const size_t parent_bytes = static_cast<size_t>(num_groups) * num_components * sizeof(float);
+    cl_mem d_parents = clCreateBuffer(b.context, CL_MEM_READ_WRITE, parent_bytes, nullptr, &err);
+
+    cl_kernel kernel = (variant == Variant::Gather) ? b.gather : b.scatter;
+    clSetKernelArg(kernel, 0, sizeof(cl_mem), variant == Variant::Gather ? &d_children : &d_group_id);
+    clSetKernelArg(kernel, 1, sizeof(cl_mem), &d_to_parent);
+    clSetKernelArg(kernel, 2, sizeof(cl_mem), &d_fields);
+    clSetKernelArg(kernel, 3, sizeof(cl_mem), &d_parents);
+    clSetKernelArg(kernel, 4, sizeof(cl_uint), &num_components);
+    clSetKernelArg(kernel, 5, sizeof(cl_uint), &rule);
+    const cl_uint items = (variant == Variant::Gather) ? num_groups : num_children;
+    clSetKernelArg(kernel, 6, sizeof(cl_uint), &items);
+
+    size_t local_size = 64;
+    size_t global_size = ((items + local_size - 1) / local_size) * local_size;
+    const float zero = 0.0f;
+
+    for (auto _ : state) {
+        // The scatter kernel accumulates, so its output is cleared each pass
+        if (variant == Variant::Scatter) {
+            clEnqueueFillBuffer(b.queue, d_parents, &zero, sizeof(float), 0, parent_bytes, 0, nullptr, nullptr);
+        }
+        clEnqueueNDRangeKernel(b.queue, kernel, 1, nullptr, &global_size, &local_size, 0, nullptr, nullptr);
+        clFinish(b.queue);
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                            static_cast<int64_t>(fields.size() * sizeof(float) + parent_bytes));
+    state.counters["parents"] = num_groups;
+
+    clReleaseMemObject(d_children);
+    clReleaseMemObject(d_group_id);
+    clReleaseMemObject(d_to_parent);
+    clReleaseMemObject(d_fields);
+    clReleaseMemObject(d_parents);
+}
+
+void BM_MergeFieldsGather(benchmark::State& state) { runMerge(state, Variant::Gather); }
+void BM_MergeFieldsScatter(benchmark::State& state) { runMerge(state, Variant::Scatter); }
+
+} // namespace
+
+// Parents x components: a scalar, a velocity and a D3Q19 distribution set
+#define MERGE_ARGS ->ArgsProduct({{1 << 14, 1 << 17}, {1, 3, 19}})->Unit(benchmark::kMicrosecond)->UseRealTime()
+BENCHMARK(BM_MergeFieldsGather) MERGE_ARGS;
+BENCHMARK(BM_MergeFieldsScatter) MERGE_ARGS;
@@ -1,6 +1,9 @@
 #include "fluidloom/parsing/visitors/FieldsVisitor.h"
 #include "fluidloom/parsing/visitors/LatticesVisitor.h"
 #include "fluidloom/parsing/codegen/OpenCLPreambleGenerator.h"
+#include "fluidloom/parsing/symbol_table/SymbolTable.h"
+#include "fluidloom/core/registry/FieldRegistry.h"
+#include "fluidloom/common/StringInterner.h"
 #include <iostream>
 #include <chrono>
 #include <fstream>
@@ -59,6 +62,36 @@ double measureGeneratePreamble() {
     return duration_cast<microseconds>(end - start).count() / 1000.0; // ms
 }
 
+// Resolve every field of a generated script through the symbol table and the
+// registry by interned ID, as semantic analysis and codegen do per reference
+double measureResolveFields(int num_fields, int refs_per_field) {
+    auto& registry = fluidloom::registry::FieldRegistry::instance();
+    registry.clear();
+    fluidloom::parsing::symbol_table::SymbolTable table;
+    std::vector<fluidloom::SymbolId> ids;
+    for (int i = 0; i < num_fields; ++i) {
+        std::string name = "generated_field_" + std::to_string(i);
+        registry.registerField(fluidloom::fields::FieldDescriptor(name, fluidloom::fields::FieldType::FLOAT32, 1));
+        table.addField(name, 1);
+        ids.push_back(fluidloom::intern(name));
+    }
+    
+    auto start = high_resolution_clock::now();
+    size_t resolved = 0;
+    for (int r = 0; r < refs_per_field; ++r) {
+        for (auto id : ids) {
+            resolved += (table.find(id) != nullptr) + (registry.find(id) != nullptr);
+        }
+    }
+    auto end = high_resolution_clock::now();
+    
+    registry.clear();
+    if (resolved != 2 * ids.size() * refs_per_field) {
+        std::cerr << "Field resolution failed\n";
+    }
+    return duration_cast<microseconds>(end - start).count() / 1000.0; // ms
+}
+
 int main() {
     fs::path temp_dir = fs::temp_directory_path() / "fluidloom_perf";
     fs::create_directories(temp_dir);
@@ -108,6 +141,13 @@ int main() {
     std::cout << (preamble_time < 10.0 ? " ✓ PASS" : " ✗ FAIL") << "\n";
     std::cout << "  Target: < 10ms\n\n";
     
+    // Test 4: Resolve references in a generated script with 5000 fields
+    double resolve_time = measureResolveFields(5000, 20);
+    
+    std::cout << "Resolve 100k field references (5000 fields): " << resolve_time << " ms";
+    std::cout << (resolve_time < 20.0 ? " ✓ PASS" : " ✗ FAIL") << "\n";
+    std::cout << "  Target: < 20ms\n\n";
+    
     // Cleanup
     fs::remove_all(temp_dir);
     
@@ -134,6 +174,12 @@ int main() {
     json << "      \"target\": \"< 10ms\",\n";
     json << "      \"actual\": \"" << preamble_time << " ms\",\n";
     json << "      \"pass\": " << (preamble_time < 10.0 ? "true" : "false") << "\n";
+    json << "    },\n";
+    json << "    \"resolve_fields_5000\": {\n";
+    json << "      \"description\": \"Resolve 100k field references by interned ID (5000 fields)\",\n";
+    json << "      \"target\": \"< 20ms\",\n";
+    json << "      \"actual\": \"" << resolve_time << " ms\",\n";
+    json << "      \"pass\": " << (resolve_time < 20.0 ? "true" : "false") << "\n";
     json << "    }\n";
     json << "  }\n";
     json << "}\n";
@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+#include "ScalingHarness.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+using namespace fluidloom::testing;
+
+/**
+ * @brief Scaling predictions from the in-process multi-rank harness
+ *
+ * Ranks run as threads over a LoopbackTransport; step times come from the
+ * kernel cost model, so every expectation here is deterministic.
+ */
+namespace {
+
+ScalingConfig smallConfig(int ranks) {
+    ScalingConfig config;
+    config.num_ranks = ranks;
+    config.nx = config.ny = config.nz = 32;
+    config.steps = 20;
+    config.balance.enabled = false;
+    return config;
+}
+
+// Refined sphere in one corner: cells there carry eight times the work
+ScalingConfig refinedConfig(int ranks, Partitioner partitioner) {
+    ScalingConfig config = smallConfig(ranks);
+    config.refine_center[0] = config.refine_center[1] = config.refine_center[2] = 8.0;
+    config.refine_radius = 8.0;
+    config.partitioner = partitioner;
+    return config;
+}
+
+} // namespace
+
+TEST(LoopbackTransportTest, ArrivalFollowsLatencyAndBandwidth) {
+    LinkModel link;
+    link.latency_us = 2.0;
+    link.bandwidth_gb_per_s = 10.0;  // 1e4 bytes/us
+    link.ranks_per_node = 1;
+    LoopbackTransport transport(2, link);
+
+    double arrival = transport.send(0, 1, 7, 100000, 5.0);
+    EXPECT_DOUBLE_EQ(arrival, 5.0 + 10.0 + 2.0);
+
+    // Second send queues behind the first on rank 0's link
+    double second = transport.send(0, 1, 7, 100000, 5.0);
+    EXPECT_DOUBLE_EQ(second, 5.0 + 20.0 + 2.0);
+
+    int payload = 42;
+    transport.send(1, 0, 3, sizeof(payload), 0.0, &payload);
+    auto message = transport.recv(0, 1, 3);
+    ASSERT_EQ(message.payload.size(), sizeof(payload));
+    EXPECT_EQ(*reinterpret_cast<const int*>(message.payload.data()), 42);
+
+    EXPECT_DOUBLE_EQ(transport.recv(1, 0, 7).arrival_us, arrival);
+    EXPECT_EQ(transport.getStats(0).bytes_sent, 200000u);
+    EXPECT_EQ(transport.getStats(1).messages_received, 1u);
+}
+
+TEST(KernelCostModelTest, CalibrationRecoversLinearCost) {
+    KernelCostModel model;
+    model.setCost("k", {3.0, 2.0});
+    EXPECT_DOUBLE_EQ(model.predict("k", 1000), 3.0 + 2.0);
+    EXPECT_DOUBLE_EQ(model.predict("k", 0), 0.0);
+    EXPECT_THROW(model.predict("missing", 1), std::out_of_range);
+
+    KernelCostModel gpu = model.scaledToDevice(4.0, 10.0);
+    EXPECT_DOUBLE_EQ(gpu.getCost("k").ns_per_cell, 0.5);
+    EXPECT_DOUBLE_EQ(gpu.getCost("k").launch_us, 10.0);
+
+    std::string path = ::testing::TempDir() + "cost_model.txt";
+    gpu.save(path);
+    KernelCostModel loaded = KernelCostModel::load(path);
+    EXPECT_DOUBLE_EQ(loaded.getCost("k").ns_per_cell, 0.5);
+    std::remove(path.c_str());
+}
+
+TEST(KernelCostModelTest, HostCalibrationCoversHarnessKernels) {
+    KernelCostModel host = KernelCostModel::calibrateHost({1 << 10, 1 << 12});
+    for (const char* kernel : {KernelCostModel::COLLIDE_STREAM, KernelCostModel::HALO_PACK,
+                               KernelCostModel::RESTRICT, KernelCostModel::HILBERT_ENCODE}) {
+        ASSERT_TRUE(host.hasCost(kernel)) << kernel;
+        EXPECT_GE(host.predict(kernel, 1 << 12), 0.0);
+    }
+}
+
+TEST(ScalingHarnessTest, SingleRankHasNoCommunication) {
+    ScalingResult result = ScalingHarness(smallConfig(1)).run();
+
+    ASSERT_EQ(result.ranks.size(), 1u);
+    EXPECT_EQ(result.total_load, 32u * 32u * 32u);
+    EXPECT_EQ(result.halo_bytes_per_step, 0u);
+    EXPECT_DOUBLE_EQ(result.commPerStep(), 0.0);
+    EXPECT_DOUBLE_EQ(result.reducePerStep(), 0.0);
+    EXPECT_DOUBLE_EQ(result.time_per_step_us, result.computePerStep());
+}
+
+TEST(ScalingHarnessTest, StrongScalingShiftsTimeToCommunication) {
+    auto points = ScalingHarness::strongScaling(smallConfig(1), {1, 2, 4, 8});
+    ASSERT_EQ(points.size(), 4u);
+
+    for (size_t i = 1; i < points.size(); ++i) {
+        EXPECT_EQ(points[i].cells, points[0].cells);
+        EXPECT_LT(points[i].time_per_step_us, points[i - 1].time_per_step_us);
+        EXPECT_LT(points[i].compute_us, points[i - 1].compute_us);
+        EXPECT_GT(points[i].halo_bytes, points[i - 1].halo_bytes);
+        EXPECT_LE(points[i].efficiency, 1.0 + 1e-9);
+    }
+    EXPECT_GT(points.back().reduce_us, 0.0);
+}
+
+TEST(ScalingHarnessTest, WeakScalingKeepsLoadPerRank) {
+    auto points = ScalingHarness::weakScaling(smallConfig(1), {1, 2, 4, 8});
+    ASSERT_EQ(points.size(), 4u);
+
+    // Multi-rank steps add pack/unpack launches; beyond that compute stays flat
+    for (size_t i = 1; i < points.size(); ++i) {
+        EXPECT_EQ(points[i].cells, points[0].cells * points[i].ranks);
+        EXPECT_NEAR(points[i].compute_us, points[1].compute_us, 0.1 * points[1].compute_us);
+        EXPECT_GT(points[i].efficiency, 0.5);
+    }
+}
+
+TEST(ScalingHarnessTest, OverlapHidesSlowLinks) {
+    // On a slow link the halo outlasts the extra interior launch
+    ScalingConfig overlapped = smallConfig(8);
+    overlapped.link.bandwidth_gb_per_s = overlapped.link.intra_bandwidth_gb_per_s = 1.0;
+    ScalingConfig blocking = overlapped;
+    blocking.overlap_communication = false;
+
+    EXPECT_LT(ScalingHarness(overlapped).run().time_per_step_us,
+              ScalingHarness(blocking).run().time_per_step_us);
+}
+
+TEST(ScalingHarnessTest, WeightedPartitionerBeatsLinearSplitOnRefinedMesh) {
+    ScalingResult linear = ScalingHarness(refinedConfig(8, loadBalancerPartitioner)).run();
+    ScalingResult weighted = ScalingHarness(refinedConfig(8, weightedPrefixPartitioner)).run();
+
+    EXPECT_EQ(linear.total_load, weighted.total_load);
+    EXPECT_LT(weighted.imbalance, 0.05f);
+    EXPECT_GT(linear.imbalance, weighted.imbalance);
+    EXPECT_LT(weighted.time_per_step_us, linear.time_per_step_us);
+}
+
+TEST(ScalingHarnessTest, RuntimeRebalancingMigratesCells) {
+    ScalingConfig config = refinedConfig(4, weightedPrefixPartitioner);
+    config.balance_at_start = false;
+    config.balance.enabled = true;
+    config.balance.min_interval_timesteps = 10;
+    config.steps = 30;
+
+    ScalingResult result = ScalingHarness(config).run();
+    EXPECT_EQ(result.rebalances, 1);
+    EXPECT_LT(result.imbalance, 0.05f);
+
+    double migrate_us = 0.0;
+    for (const auto& rank : result.ranks) migrate_us += rank.migrate_us;
+    EXPECT_GT(migrate_us, 0.0);
+}
+
+// Prediction for a 64-GPU allocation; the curve is kept as a test artifact
+TEST(ScalingHarnessTest, PredictsSixtyFourRankCurve) {
+    ScalingConfig base = smallConfig(1);
+    base.nx = base.ny = base.nz = 64;
+    base.steps = 10;
+
+    auto points = ScalingHarness::strongScaling(base, {1, 8, 64});
+    ASSERT_EQ(points.size(), 3u);
+    EXPECT_EQ(points.back().ranks, 64);
+    EXPECT_GT(points.back().comm_us + points.back().reduce_us, 0.0);
+    EXPECT_GT(points.back().efficiency, 0.0);
+
+    std::string path = ::testing::TempDir() + "strong_scaling_64.csv";
+    ScalingHarness::writeCSV(path, points);
+    std::ifstream csv(path);
+    std::string header;
+    std::getline(csv, header);
+    EXPECT_EQ(header.rfind("ranks,cells,", 0), 0u);
+
+    RecordProperty("time_per_step_us_64", std::to_string(points.back().time_per_step_us));
+    RecordProperty("efficiency_64", std::to_string(points.back().efficiency));
+    std::remove(path.c_str());
+}
+
+TEST(ScalingHarnessTest, RejectsInvalidConfig) {
+    ScalingConfig config = smallConfig(1);
+    config.nx = 512;
+    EXPECT_THROW(ScalingHarness harness(config), std::invalid_argument);
+
+    config = smallConfig(1);
+    config.num_ranks = 0;
+    EXPECT_THROW(ScalingHarness harness(config), std::invalid_argument);
+}
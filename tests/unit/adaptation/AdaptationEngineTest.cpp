@@ -0,0 +1,202 @@
+#include <gtest/gtest.h>
+#include "fluidloom/adaptation/AdaptationEngine.h"
+#include "fluidloom/adaptation/FieldAveragingRules.h"
+#include "fluidloom/core/backend/OpenCLBackend.h"
+#include "fluidloom/core/fields/SOAFieldManager.h"
+#include <map>
+#include <tuple>
+#include <vector>
+
+using namespace fluidloom;
+using namespace fluidloom::adaptation;
+
+namespace {
+
+template <typename T>
+cl_mem upload(cl_context context, std::vector<T>& values, size_t capacity) {
+    values.resize(capacity);
+    cl_int err;
+    return clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+                          capacity * sizeof(T), values.data(), &err);
+}
+
+template <typename T>
+std::vector<T> download(cl_command_queue queue, cl_mem buffer, size_t count) {
+    std::vector<T> values(count);
+    clEnqueueReadBuffer(queue, buffer, CL_TRUE, 0, count * sizeof(T), values.data(), 0, nullptr, nullptr);
+    return values;
+}
+
+} // namespace
+
+// Split, merge and compaction in one cycle: fields must follow their cells
+// into the compacted layout (survivors, then children, then parents), and
+// grown allocations must be picked up through the field manager.
+TEST(AdaptationEngineTest, RemapsManagedFieldsThroughSplitMergeAndCompaction) {
+    OpenCLBackend backend;
+    try {
+        backend.initialize(0);
+    } catch (const std::exception& e) {
+        GTEST_SKIP() << "No OpenCL device: " << e.what();
+    }
+    cl_context context = backend.getContext();
+    cl_command_queue queue = backend.getQueue();
+
+    AdaptationConfig config;
+    config.max_refinement_level = 8;
+    config.enforce_2_1_balance = false;
+    AdaptationEngine engine(context, queue, config);
+
+    // Level 1: 8 coarsening siblings of (0,0,0), two refining cells, one survivor
+    std::vector<int> h_x, h_y, h_z, h_flags;
+    std::vector<uint8_t> h_level, h_state;
+    std::vector<uint32_t> h_mat;
+    std::vector<float> h_rho;
+    std::vector<int32_t> h_tag;
+    auto addCell = [&](int x, int y, int z, int flag, float rho, int32_t tag) {
+        h_x.push_back(x); h_y.push_back(y); h_z.push_back(z);
+        h_level.push_back(1); h_state.push_back(0); h_flags.push_back(flag);
+        h_mat.push_back(0); h_rho.push_back(rho); h_tag.push_back(tag);
+    };
+    for (int i = 0; i < 8; ++i) {
+        addCell(i & 1, (i >> 1) & 1, (i >> 2) & 1, -1, static_cast<float>(i + 1), 7);
+    }
+    addCell(2, 0, 0, 1, 20.0f, 1);
+    addCell(3, 0, 0, 1, 30.0f, 2);
+    addCell(4, 0, 0, 0, 5.5f, 3);
+
+    size_t num_cells = h_x.size();
+    size_t capacity = num_cells;
+
+    FieldAveragingRuleRegistry::getInstance().registerRule("remap_rho", RestrictionRule::ARITHMETIC);
+    fields::SOAFieldManager field_manager(&backend);
+    auto rho = field_manager.allocate(fields::FieldDescriptor("remap_rho", fields::FieldType::FLOAT32, 1), capacity);
+    auto tag = field_manager.allocate(fields::FieldDescriptor("remap_tag", fields::FieldType::INT32, 1), capacity);
+    clEnqueueWriteBuffer(queue, static_cast<cl_mem>(field_manager.getDevicePtr(rho)), CL_TRUE, 0,
+                         num_cells * sizeof(float), h_rho.data(), 0, nullptr, nullptr);
+    clEnqueueWriteBuffer(queue, static_cast<cl_mem>(field_manager.getDevicePtr(tag)), CL_TRUE, 0,
+                         num_cells * sizeof(int32_t), h_tag.data(), 0, nullptr, nullptr);
+    cl_mem old_rho = static_cast<cl_mem>(field_manager.getDevicePtr(rho));
+
+    // Values by cell, kept before upload() pads the host vectors
+    std::map<std::tuple<int, int, int, int>, std::pair<float, int32_t>> parent_values;
+    for (size_t i = 8; i < num_cells; ++i) {
+        parent_values[{h_x[i], h_y[i], h_z[i], h_level[i]}] = {h_rho[i], h_tag[i]};
+    }
+
+    cl_mem x = upload(context, h_x, capacity);
+    cl_mem y = upload(context, h_y, capacity);
+    cl_mem z = upload(context, h_z, capacity);
+    cl_mem l = upload(context, h_level, capacity);
+    cl_mem s = upload(context, h_state, capacity);
+    cl_mem f = upload(context, h_flags, capacity);
+    cl_mem m = upload(context, h_mat, capacity);
+
+    cl_event done = engine.adapt(&x, &y, &z, &l, &s, &f, &m, &num_cells, &capacity,
+                                 field_manager, {rho, tag});
+    ASSERT_NE(done, nullptr);
+    clWaitForEvents(1, &done);
+    clReleaseEvent(done);
+
+    // 1 survivor + 16 children + 1 parent; the fields grew with the mesh
+    ASSERT_EQ(num_cells, 18u);
+    EXPECT_GE(field_manager.getAllocationSize(rho), capacity);
+    EXPECT_NE(static_cast<cl_mem>(field_manager.getDevicePtr(rho)), old_rho);
+
+    auto nx = download<int>(queue, x, num_cells);
+    auto ny = download<int>(queue, y, num_cells);
+    auto nz = download<int>(queue, z, num_cells);
+    auto nl = download<uint8_t>(queue, l, num_cells);
+    auto new_rho = download<float>(queue, static_cast<cl_mem>(field_manager.getDevicePtr(rho)), num_cells);
+    auto new_tag = download<int32_t>(queue, static_cast<cl_mem>(field_manager.getDevicePtr(tag)), num_cells);
+
+    // Survivor keeps its values at the front
+    EXPECT_EQ(nx[0], 4);
+    EXPECT_EQ(nl[0], 1);
+    EXPECT_FLOAT_EQ(new_rho[0], 5.5f);
+    EXPECT_EQ(new_tag[0], 3);
+
+    // Children inherit their parent's values (injection)
+    for (size_t i = 1; i < 17; ++i) {
+        ASSERT_EQ(nl[i], 2) << "cell " << i;
+        auto it = parent_values.find({nx[i] >> 1, ny[i] >> 1, nz[i] >> 1, 1});
+        ASSERT_NE(it, parent_values.end()) << "cell " << i;
+        EXPECT_FLOAT_EQ(new_rho[i], it->second.first) << "cell " << i;
+        EXPECT_EQ(new_tag[i], it->second.second) << "cell " << i;
+    }
+
+    // Merged parent: arithmetic mean of 1..8, first sibling's tag
+    EXPECT_EQ(nl[17], 0);
+    EXPECT_EQ(nx[17], 0);
+    EXPECT_FLOAT_EQ(new_rho[17], 4.5f);
+    EXPECT_EQ(new_tag[17], 7);
+
+    for (cl_mem buffer : {x, y, z, l, s, f, m}) {
+        clReleaseMemObject(buffer);
+    }
+}
+
+// The first field needing prolongation is prolonged inside child generation,
+// later ones by a separate kernel: both must produce the same children.
+TEST(AdaptationEngineTest, FusedAndSeparateProlongationAgree) {
+    OpenCLBackend backend;
+    try {
+        backend.initialize(0);
+    } catch (const std::exception& e) {
+        GTEST_SKIP() << "No OpenCL device: " << e.what();
+    }
+    cl_context context = backend.getContext();
+    cl_command_queue queue = backend.getQueue();
+
+    AdaptationConfig config;
+    config.enforce_2_1_balance = false;
+    AdaptationEngine engine(context, queue, config);
+
+    // Row of three level-0 cells; the middle one splits
+    std::vector<int> h_x = {0, 1, 2}, h_y = {0, 0, 0}, h_z = {0, 0, 0}, h_flags = {0, 1, 0};
+    std::vector<uint8_t> h_level = {0, 0, 0}, h_state = {0, 0, 0};
+    std::vector<uint32_t> h_mat = {0, 0, 0};
+    std::vector<float> h_rho = {1.0f, 2.0f, 4.0f};
+    size_t num_cells = 3;
+    size_t capacity = num_cells;
+
+    auto& registry = FieldAveragingRuleRegistry::getInstance();
+    registry.registerProlongation("fused_a", "minmod");
+    registry.registerProlongation("fused_b", "minmod");
+    fields::SOAFieldManager field_manager(&backend);
+    auto a = field_manager.allocate(fields::FieldDescriptor("fused_a", fields::FieldType::FLOAT32, 1), capacity);
+    auto b = field_manager.allocate(fields::FieldDescriptor("fused_b", fields::FieldType::FLOAT32, 1), capacity);
+    for (auto handle : {a, b}) {
+        clEnqueueWriteBuffer(queue, static_cast<cl_mem>(field_manager.getDevicePtr(handle)), CL_TRUE, 0,
+                             num_cells * sizeof(float), h_rho.data(), 0, nullptr, nullptr);
+    }
+
+    cl_mem x = upload(context, h_x, capacity);
+    cl_mem y = upload(context, h_y, capacity);
+    cl_mem z = upload(context, h_z, capacity);
+    cl_mem l = upload(context, h_level, capacity);
+    cl_mem s = upload(context, h_state, capacity);
+    cl_mem f = upload(context, h_flags, capacity);
+    cl_mem m = upload(context, h_mat, capacity);
+
+    cl_event done = engine.adapt(&x, &y, &z, &l, &s, &f, &m, &num_cells, &capacity,
+                                 field_manager, {a, b});
+    ASSERT_NE(done, nullptr);
+    clWaitForEvents(1, &done);
+    clReleaseEvent(done);
+    ASSERT_EQ(num_cells, 10u);
+
+    auto nx = download<int>(queue, x, num_cells);
+    auto new_a = download<float>(queue, static_cast<cl_mem>(field_manager.getDevicePtr(a)), num_cells);
+    auto new_b = download<float>(queue, static_cast<cl_mem>(field_manager.getDevicePtr(b)), num_cells);
+
+    // minmod(2 - 1, 4 - 2) = 1 along x: children at 2 -/+ 0.25
+    for (size_t i = 2; i < num_cells; ++i) {
+        EXPECT_FLOAT_EQ(new_a[i], (nx[i] & 1) ? 2.25f : 1.75f) << "cell " << i;
+        EXPECT_FLOAT_EQ(new_b[i], new_a[i]) << "cell " << i;
+    }
+
+    for (cl_mem buffer : {x, y, z, l, s, f, m}) {
+        clReleaseMemObject(buffer);
+    }
+}
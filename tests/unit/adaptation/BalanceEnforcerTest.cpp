@@ -91,3 +91,45 @@ TEST_F(BalanceEnforcerTest, DetectViolation) {
     clReleaseMemObject(x); clReleaseMemObject(y); clReleaseMemObject(z);
     clReleaseMemObject(l); clReleaseMemObject(s); clReleaseMemObject(f);
 }
+
+TEST_F(BalanceEnforcerTest, IterationCountsStayOnDevice) {
+    // Same pair as above: one violation, fixed by the first iteration
+    std::vector<int> h_x = {0, 128};
+    std::vector<int> h_y = {0, 0};
+    std::vector<int> h_z = {0, 0};
+    std::vector<uint8_t> h_level = {1, 3};
+    std::vector<uint8_t> h_state = {0, 0};
+    std::vector<int> h_flags = {0, 0};
+    
+    cl_int err;
+    cl_mem x = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, 2*sizeof(int), h_x.data(), &err);
+    cl_mem y = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, 2*sizeof(int), h_y.data(), &err);
+    cl_mem z = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, 2*sizeof(int), h_z.data(), &err);
+    cl_mem l = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, 2*sizeof(uint8_t), h_level.data(), &err);
+    cl_mem s = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, 2*sizeof(uint8_t), h_state.data(), &err);
+    cl_mem f = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, 2*sizeof(int), h_flags.data(), &err);
+    
+    std::vector<uint32_t> counts(engine->numCounts());
+    cl_mem d_counts = clCreateBuffer(context, CL_MEM_READ_WRITE, counts.size() * sizeof(uint32_t), nullptr, &err);
+    
+    engine->enforce(x, y, z, l, s, f, 2, d_counts);
+    clEnqueueReadBuffer(queue, d_counts, CL_TRUE, 0, counts.size() * sizeof(uint32_t), counts.data(), 0, nullptr, nullptr);
+    
+    // Iteration 0 found and marked cell 0, iteration 1 found nothing, and
+    // the later iterations exited on the device without counting
+    EXPECT_EQ(counts[0], 1u);
+    EXPECT_EQ(counts[1], 1u);
+    EXPECT_EQ(counts[2], 0u);
+    for (size_t i = 4; i < counts.size(); ++i) {
+        EXPECT_EQ(counts[i], 0u) << "count " << i;
+    }
+    
+    BalanceResult res = engine->summarize(counts.data());
+    EXPECT_TRUE(res.converged);
+    EXPECT_EQ(res.iterations, 2u);
+    EXPECT_EQ(res.total_cells_marked_for_balance, 1u);
+    
+    clReleaseMemObject(x); clReleaseMemObject(y); clReleaseMemObject(z);
+    clReleaseMemObject(l); clReleaseMemObject(s); clReleaseMemObject(f);
+    clReleaseMemObject(d_counts);
+}
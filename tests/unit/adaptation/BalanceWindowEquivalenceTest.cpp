@@ -0,0 +1,353 @@
+#include <gtest/gtest.h>
+#include "fluidloom/core/backend/OpenCLBackend.h"
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * detect_balance_violations probes only the 2:1 window of levels around the
+ * cell and resumes the neighbor's Hilbert keys from the cell's own encoder
+ * state. It must flag exactly the cells the full scan it replaced flagged:
+ * every level 0..MAX_REFINEMENT_LEVEL, each key encoded from scratch.
+ * Both run on random 2:1-balanced octrees with random shadow increments.
+ */
+
+#ifndef FL_SOURCE_DIR
+#define FL_SOURCE_DIR "."
+#endif
+
+using namespace fluidloom;
+
+namespace {
+
+constexpr int MAX_LEVEL = 8;
+constexpr int MAX_TREE_DEPTH = 6;
+
+// detect_balance_violations before the level window, appended to the
+// concatenated sources so it shares their tables and defines
+const char* FULL_SCAN_SOURCE = R"CLC(
+__kernel void detect_balance_violations_full_scan(
+    __global const int* restrict coord_x,
+    __global const int* restrict coord_y,
+    __global const int* restrict coord_z,
+    __global const uchar* restrict levels,
+    __global const uchar* restrict cell_states,
+    __global const uint* restrict hash_table,
+    const uint hash_table_size,
+    __global uchar* restrict violation_flags,
+    __global uint* restrict violation_count,
+    const uint num_cells) {
+
+    const uint idx = get_global_id(0);
+    if (idx >= num_cells) return;
+
+    violation_flags[idx] = 0;
+    if (cell_states[idx] != 0) return;
+
+    const int cx = coord_x[idx];
+    const int cy = coord_y[idx];
+    const int cz = coord_z[idx];
+    const uchar my_level = levels[idx];
+    const int my_size = 1 << (MAX_REFINEMENT_LEVEL - my_level);
+
+    const int test_points[6][3] = {
+        {cx - 1, cy, cz}, {cx + my_size, cy, cz},
+        {cx, cy - 1, cz}, {cx, cy + my_size, cz},
+        {cx, cy, cz - 1}, {cx, cy, cz + my_size}
+    };
+
+    for (int n = 0; n < 6; ++n) {
+        int px = test_points[n][0];
+        int py = test_points[n][1];
+        int pz = test_points[n][2];
+
+        bool found = false;
+        for (int l = 0; l <= MAX_REFINEMENT_LEVEL; ++l) {
+            int size = 1 << (MAX_REFINEMENT_LEVEL - l);
+            int mask = ~(size - 1);
+
+            int ax = px & mask;
+            int ay = py & mask;
+            int az = pz & mask;
+
+            ulong hilbert = hilbert_encode_3d(ax, ay, az, MAX_REFINEMENT_LEVEL);
+            uint hash = hilbert % hash_table_size;
+
+            for (uint probe = 0; probe < 64; ++probe) {
+                uint neighbor_idx = hash_table[hash];
+                if (neighbor_idx == INVALID_INDEX) break;
+
+                if (levels[neighbor_idx] == l &&
+                    coord_x[neighbor_idx] == ax &&
+                    coord_y[neighbor_idx] == ay &&
+                    coord_z[neighbor_idx] == az) {
+                    if (l > my_level + 1) {
+                        violation_flags[idx] = 1;
+                        atomic_inc(violation_count);
+                        return;
+                    }
+                    found = true;
+                    break;
+                }
+
+                hash = (hash + 1) % hash_table_size;
+            }
+            if (found) break;
+        }
+    }
+}
+)CLC";
+
+std::string readSource(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open kernel source: " + path);
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+// Same concatenation as BalanceEnforcer::compileKernels, plus the full scan
+std::string balanceSource() {
+    const std::string dir = std::string(FL_SOURCE_DIR) + "/src/adaptation/kernels/";
+    std::string balance_src = readSource(dir + "balance_enforce.cl");
+    const std::string include = "#include \"hilbert_encode_3d.cl\"";
+    size_t pos = balance_src.find(include);
+    if (pos != std::string::npos) {
+        balance_src.replace(pos, include.size(), "// " + include);
+    }
+    return readSource(dir + "hilbert_encode_3d.cl") + "\n" + balance_src + "\n" + FULL_SCAN_SOURCE;
+}
+
+// Leaf cells as (x, y, z, level), coordinates at the finest resolution
+using Cell = std::array<int, 4>;
+
+int cellSize(int level) { return 1 << (MAX_LEVEL - level); }
+
+void split(std::set<Cell>& leaves, const Cell& cell) {
+    leaves.erase(cell);
+    const int half = cellSize(cell[3] + 1);
+    for (int child = 0; child < 8; ++child) {
+        leaves.insert({cell[0] + (child & 1) * half,
+                       cell[1] + ((child >> 1) & 1) * half,
+                       cell[2] + ((child >> 2) & 1) * half,
+                       cell[3] + 1});
+    }
+}
+
+// The leaf containing the point, if the point is inside the domain
+bool containingLeaf(const std::set<Cell>& leaves, int px, int py, int pz, Cell& out) {
+    if (((px | py | pz) >> MAX_LEVEL) != 0) return false;
+    for (int l = 0; l <= MAX_LEVEL; ++l) {
+        const int mask = ~(cellSize(l) - 1);
+        auto it = leaves.find({px & mask, py & mask, pz & mask, l});
+        if (it != leaves.end()) {
+            out = *it;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Random refinement, then split coarse face neighbors until 2:1 balanced
+std::set<Cell> randomBalancedOctree(std::mt19937& rng) {
+    std::set<Cell> leaves;
+    leaves.insert({0, 0, 0, 0});
+    split(leaves, {0, 0, 0, 0});
+
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    std::vector<Cell> pending(leaves.begin(), leaves.end());
+    while (!pending.empty()) {
+        Cell cell = pending.back();
+        pending.pop_back();
+        if (cell[3] >= MAX_TREE_DEPTH || coin(rng) > 0.55 / cell[3]) continue;
+        split(leaves, cell);
+        const int half = cellSize(cell[3] + 1);
+        for (int child = 0; child < 8; ++child) {
+            pending.push_back({cell[0] + (child & 1) * half,
+                               cell[1] + ((child >> 1) & 1) * half,
+                               cell[2] + ((child >> 2) & 1) * half,
+                               cell[3] + 1});
+        }
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        std::set<Cell> too_coarse;
+        for (const Cell& cell : leaves) {
+            const int size = cellSize(cell[3]);
+            const int points[6][3] = {
+                {cell[0] - 1, cell[1], cell[2]}, {cell[0] + size, cell[1], cell[2]},
+                {cell[0], cell[1] - 1, cell[2]}, {cell[0], cell[1] + size, cell[2]},
+                {cell[0], cell[1], cell[2] - 1}, {cell[0], cell[1], cell[2] + size}
+            };
+            for (const auto& p : points) {
+                Cell neighbor;
+                if (containingLeaf(leaves, p[0], p[1], p[2], neighbor) && neighbor[3] < cell[3] - 1) {
+                    too_coarse.insert(neighbor);
+                }
+            }
+        }
+        for (const Cell& cell : too_coarse) {
+            split(leaves, cell);
+            changed = true;
+        }
+    }
+    return leaves;
+}
+
+cl_mem upload(cl_context context, const void* data, size_t bytes) {
+    cl_int err;
+    cl_mem buffer = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, bytes,
+                                   const_cast<void*>(data), &err);
+    EXPECT_EQ(err, CL_SUCCESS);
+    return buffer;
+}
+
+} // namespace
+
+TEST(BalanceWindowEquivalenceTest, WindowedDetectionMatchesFullLevelScan) {
+    OpenCLBackend backend;
+    try {
+        backend.initialize(0);
+    } catch (const std::exception& e) {
+        GTEST_SKIP() << "No OpenCL device: " << e.what();
+    }
+    cl_context context = backend.getContext();
+    cl_command_queue queue = backend.getQueue();
+    cl_device_id device = backend.getDevice();
+
+    const std::string src = balanceSource();
+    const char* src_str = src.c_str();
+    size_t src_len = src.size();
+    cl_int err;
+    cl_program program = clCreateProgramWithSource(context, 1, &src_str, &src_len, &err);
+    ASSERT_EQ(err, CL_SUCCESS);
+    ASSERT_EQ(clBuildProgram(program, 1, &device, "-cl-std=CL1.2", nullptr, nullptr), CL_SUCCESS);
+    cl_kernel build_hash = clCreateKernel(program, "build_cell_hash", &err);
+    ASSERT_EQ(err, CL_SUCCESS);
+    cl_kernel windowed = clCreateKernel(program, "detect_balance_violations", &err);
+    ASSERT_EQ(err, CL_SUCCESS);
+    cl_kernel full_scan = clCreateKernel(program, "detect_balance_violations_full_scan", &err);
+    ASSERT_EQ(err, CL_SUCCESS);
+
+    std::mt19937 rng(20240611);
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    size_t total_flagged = 0;
+
+    for (int trial = 0; trial < 12; ++trial) {
+        std::set<Cell> leaves = randomBalancedOctree(rng);
+        std::vector<Cell> cells(leaves.begin(), leaves.end());
+        std::shuffle(cells.begin(), cells.end(), rng);
+        const size_t num_cells = cells.size();
+
+        // Shadow levels: cells already marked by an earlier iteration read
+        // one level finer; a few non-fluid cells must stay unflagged
+        std::vector<int> h_x(num_cells), h_y(num_cells), h_z(num_cells);
+        std::vector<uint8_t> h_shadow(num_cells), h_state(num_cells);
+        for (size_t i = 0; i < num_cells; ++i) {
+            h_x[i] = cells[i][0];
+            h_y[i] = cells[i][1];
+            h_z[i] = cells[i][2];
+            const bool shadowed = cells[i][3] < MAX_LEVEL && coin(rng) < 0.3;
+            h_shadow[i] = static_cast<uint8_t>(cells[i][3] + (shadowed ? 1 : 0));
+            h_state[i] = coin(rng) < 0.05 ? 1 : 0;
+        }
+
+        size_t table_size = 1;
+        while (table_size < num_cells * 2) table_size *= 2;
+        if (table_size < 1024) table_size = 1024;
+
+        cl_mem x = upload(context, h_x.data(), num_cells * sizeof(int));
+        cl_mem y = upload(context, h_y.data(), num_cells * sizeof(int));
+        cl_mem z = upload(context, h_z.data(), num_cells * sizeof(int));
+        cl_mem shadow = upload(context, h_shadow.data(), num_cells);
+        cl_mem state = upload(context, h_state.data(), num_cells);
+        cl_mem hash_table = clCreateBuffer(context, CL_MEM_READ_WRITE, table_size * sizeof(uint32_t), nullptr, &err);
+        cl_mem windowed_flags = clCreateBuffer(context, CL_MEM_READ_WRITE, num_cells, nullptr, &err);
+        cl_mem full_flags = clCreateBuffer(context, CL_MEM_READ_WRITE, num_cells, nullptr, &err);
+        std::vector<uint32_t> zero_counts(2, 0);
+        cl_mem balance_counts = upload(context, zero_counts.data(), 2 * sizeof(uint32_t));
+        cl_mem violation_count = upload(context, zero_counts.data(), sizeof(uint32_t));
+
+        uint32_t invalid = 0xFFFFFFFF;
+        clEnqueueFillBuffer(queue, hash_table, &invalid, sizeof(uint32_t), 0, table_size * sizeof(uint32_t), 0, nullptr, nullptr);
+
+        cl_uint table_size_uint = static_cast<cl_uint>(table_size);
+        cl_uint num_cells_uint = static_cast<cl_uint>(num_cells);
+        cl_uint iteration = 0;
+        size_t local_work_size = 256;
+        size_t global_work_size = ((num_cells + local_work_size - 1) / local_work_size) * local_work_size;
+
+        clSetKernelArg(build_hash, 0, sizeof(cl_mem), &x);
+        clSetKernelArg(build_hash, 1, sizeof(cl_mem), &y);
+        clSetKernelArg(build_hash, 2, sizeof(cl_mem), &z);
+        clSetKernelArg(build_hash, 3, sizeof(cl_mem), &hash_table);
+        clSetKernelArg(build_hash, 4, sizeof(cl_uint), &table_size_uint);
+        clSetKernelArg(build_hash, 5, sizeof(cl_uint), &num_cells_uint);
+        ASSERT_EQ(clEnqueueNDRangeKernel(queue, build_hash, 1, nullptr, &global_work_size, &local_work_size, 0, nullptr, nullptr), CL_SUCCESS);
+
+        clSetKernelArg(windowed, 0, sizeof(cl_mem), &x);
+        clSetKernelArg(windowed, 1, sizeof(cl_mem), &y);
+        clSetKernelArg(windowed, 2, sizeof(cl_mem), &z);
+        clSetKernelArg(windowed, 3, sizeof(cl_mem), &shadow);
+        clSetKernelArg(windowed, 4, sizeof(cl_mem), &state);
+        clSetKernelArg(windowed, 5, sizeof(cl_mem), nullptr); // cell_hilbert
+        clSetKernelArg(windowed, 6, sizeof(cl_mem), &hash_table);
+        clSetKernelArg(windowed, 7, sizeof(cl_uint), &table_size_uint);
+        clSetKernelArg(windowed, 8, sizeof(cl_mem), &windowed_flags);
+        clSetKernelArg(windowed, 9, sizeof(cl_mem), &balance_counts);
+        clSetKernelArg(windowed, 10, sizeof(cl_uint), &iteration);
+        clSetKernelArg(windowed, 11, sizeof(cl_uint), &num_cells_uint);
+        ASSERT_EQ(clEnqueueNDRangeKernel(queue, windowed, 1, nullptr, &global_work_size, &local_work_size, 0, nullptr, nullptr), CL_SUCCESS);
+
+        clSetKernelArg(full_scan, 0, sizeof(cl_mem), &x);
+        clSetKernelArg(full_scan, 1, sizeof(cl_mem), &y);
+        clSetKernelArg(full_scan, 2, sizeof(cl_mem), &z);
+        clSetKernelArg(full_scan, 3, sizeof(cl_mem), &shadow);
+        clSetKernelArg(full_scan, 4, sizeof(cl_mem), &state);
+        clSetKernelArg(full_scan, 5, sizeof(cl_mem), &hash_table);
+        clSetKernelArg(full_scan, 6, sizeof(cl_uint), &table_size_uint);
+        clSetKernelArg(full_scan, 7, sizeof(cl_mem), &full_flags);
+        clSetKernelArg(full_scan, 8, sizeof(cl_mem), &violation_count);
+        clSetKernelArg(full_scan, 9, sizeof(cl_uint), &num_cells_uint);
+        ASSERT_EQ(clEnqueueNDRangeKernel(queue, full_scan, 1, nullptr, &global_work_size, &local_work_size, 0, nullptr, nullptr), CL_SUCCESS);
+
+        std::vector<uint8_t> h_windowed(num_cells), h_full(num_cells);
+        std::vector<uint32_t> h_counts(2);
+        uint32_t h_violations = 0;
+        clEnqueueReadBuffer(queue, windowed_flags, CL_TRUE, 0, num_cells, h_windowed.data(), 0, nullptr, nullptr);
+        clEnqueueReadBuffer(queue, full_flags, CL_TRUE, 0, num_cells, h_full.data(), 0, nullptr, nullptr);
+        clEnqueueReadBuffer(queue, balance_counts, CL_TRUE, 0, 2 * sizeof(uint32_t), h_counts.data(), 0, nullptr, nullptr);
+        clEnqueueReadBuffer(queue, violation_count, CL_TRUE, 0, sizeof(uint32_t), &h_violations, 0, nullptr, nullptr);
+
+        for (size_t i = 0; i < num_cells; ++i) {
+            ASSERT_EQ(h_windowed[i], h_full[i])
+                << "trial " << trial << " cell (" << h_x[i] << ", " << h_y[i] << ", " << h_z[i]
+                << ") level " << cells[i][3] << " shadow " << int(h_shadow[i]);
+        }
+        EXPECT_EQ(h_counts[0], h_violations) << "trial " << trial;
+        EXPECT_EQ(h_counts[1], 0u);
+        total_flagged += h_violations;
+
+        for (cl_mem buffer : {x, y, z, shadow, state, hash_table, windowed_flags, full_flags, balance_counts, violation_count}) {
+            clReleaseMemObject(buffer);
+        }
+    }
+
+    // Shadow increments must have produced violations to compare
+    EXPECT_GT(total_flagged, 0u);
+
+    clReleaseKernel(build_hash);
+    clReleaseKernel(windowed);
+    clReleaseKernel(full_scan);
+    clReleaseProgram(program);
+}
@@ -0,0 +1,309 @@
+#include <gtest/gtest.h>
+#include "fluidloom/adaptation/FieldAveragingRules.h"
+#include "fluidloom/adaptation/CellDescriptor.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace fluidloom::adaptation;
+
+namespace {
+
+LbmRestrictionParams d3q19(float tau_fine) {
+    LbmRestrictionParams params;
+    params.velocities = {
+        {0, 0, 0},
+        {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1},
+        {1, 1, 0}, {-1, -1, 0}, {1, -1, 0}, {-1, 1, 0},
+        {1, 0, 1}, {-1, 0, -1}, {1, 0, -1}, {-1, 0, 1},
+        {0, 1, 1}, {0, -1, -1}, {0, 1, -1}, {0, -1, 1}
+    };
+    params.weights.assign(19, 1.0f / 36.0f);
+    params.weights[0] = 1.0f / 3.0f;
+    for (int q = 1; q <= 6; ++q) params.weights[q] = 1.0f / 18.0f;
+    params.tau_fine = tau_fine;
+    return params;
+}
+
+float equilibrium(const LbmRestrictionParams& p, int q, float rho, float ux, float uy, float uz) {
+    float cu = p.velocities[q][0] * ux + p.velocities[q][1] * uy + p.velocities[q][2] * uz;
+    float uu = ux * ux + uy * uy + uz * uz;
+    return p.weights[q] * rho * (1.0f + 3.0f * cu + 4.5f * cu * cu - 1.5f * uu);
+}
+
+} // namespace
+
+class FieldAveragingRulesTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        FieldAveragingRuleRegistry::getInstance().clear();
+
+        // Children of parent p are scattered: 3 parents over 24 shuffled cells
+        child_table.resize(NUM_PARENTS * 8);
+        for (uint32_t i = 0; i < child_table.size(); ++i) child_table[i] = i;
+        std::shuffle(child_table.begin(), child_table.end(), rng);
+    }
+
+    void TearDown() override {
+        FieldAveragingRuleRegistry::getInstance().clear();
+    }
+
+    RestrictionBatch batch(const std::vector<float>& in, std::vector<float>& out, uint32_t nc) {
+        out.assign(NUM_PARENTS * nc, -1.0f);
+        RestrictionBatch b;
+        b.child_indices = child_table.data();
+        b.parent_begin = 0;
+        b.parent_end = NUM_PARENTS;
+        b.child_data = in.data();
+        b.parent_data = out.data();
+        b.num_components = nc;
+        return b;
+    }
+
+    static constexpr size_t NUM_PARENTS = 3;
+    std::mt19937 rng{42};
+    std::vector<uint32_t> child_table;
+};
+
+TEST_F(FieldAveragingRulesTest, LinearRulesMatchNaiveLoop) {
+    auto& registry = FieldAveragingRuleRegistry::getInstance();
+    registry.registerRule("rho", "volume_weighted");
+    registry.registerRule("temperature", RestrictionRule::ARITHMETIC);
+    EXPECT_EQ(registry.getRuleType("rho"), "volume_weighted");
+    EXPECT_EQ(registry.getRuleType("unregistered"), "arithmetic");
+
+    // 5 components exercises the runtime-width path, 3 the specialized one
+    for (uint32_t nc : {3u, 5u}) {
+        std::uniform_real_distribution<float> dist(0.0f, 2.0f);
+        std::vector<float> in(NUM_PARENTS * 8 * nc), out;
+        for (auto& v : in) v = dist(rng);
+
+        for (const char* field : {"rho", "temperature"}) {
+            registry.apply(field, batch(in, out, nc));
+            float scale = std::string(field) == "rho" ? 1.0f : 0.125f;
+            for (size_t p = 0; p < NUM_PARENTS; ++p) {
+                for (uint32_t c = 0; c < nc; ++c) {
+                    float sum = 0.0f;
+                    for (int k = 0; k < 8; ++k) sum += in[child_table[p * 8 + k] * nc + c];
+                    EXPECT_FLOAT_EQ(out[p * nc + c], sum * scale);
+                }
+            }
+        }
+    }
+}
+
+TEST_F(FieldAveragingRulesTest, MassWeightedVelocityConservesMomentum) {
+    auto& registry = FieldAveragingRuleRegistry::getInstance();
+    registry.registerMassWeightedRule("u", "rho");
+    EXPECT_EQ(registry.getRule("u").density_field, "rho");
+
+    std::uniform_real_distribution<float> rho_dist(0.5f, 1.5f), u_dist(-0.1f, 0.1f);
+    std::vector<float> rho(NUM_PARENTS * 8), u(NUM_PARENTS * 8 * 3), out;
+    for (auto& v : rho) v = rho_dist(rng);
+    for (auto& v : u) v = u_dist(rng);
+    rho[child_table[8]] = 0.0f; // A void child must not contribute momentum
+
+    RestrictionBatch b = batch(u, out, 3);
+    EXPECT_THROW(registry.apply("u", b), std::invalid_argument);
+    b.child_density = rho.data();
+    registry.apply("u", b);
+
+    for (size_t p = 0; p < NUM_PARENTS; ++p) {
+        float mass = 0.0f;
+        float momentum[3] = {0.0f, 0.0f, 0.0f};
+        for (int k = 0; k < 8; ++k) {
+            uint32_t child = child_table[p * 8 + k];
+            mass += rho[child];
+            for (int c = 0; c < 3; ++c) momentum[c] += rho[child] * u[child * 3 + c];
+        }
+        for (int c = 0; c < 3; ++c) {
+            EXPECT_NEAR(mass * out[p * 3 + c], momentum[c], 1e-6f);
+        }
+    }
+}
+
+TEST_F(FieldAveragingRulesTest, LbmRestrictionConservesMassAndMomentum) {
+    auto& registry = FieldAveragingRuleRegistry::getInstance();
+    auto lattice = d3q19(0.8f);
+    registry.registerLbmRule("f", lattice);
+
+    // Children near equilibrium with random non-equilibrium parts
+    std::uniform_real_distribution<float> rho_dist(0.9f, 1.1f), u_dist(-0.05f, 0.05f), neq_dist(-1e-3f, 1e-3f);
+    std::vector<float> f(NUM_PARENTS * 8 * 19), out;
+    for (size_t cell = 0; cell < NUM_PARENTS * 8; ++cell) {
+        float rho = rho_dist(rng), ux = u_dist(rng), uy = u_dist(rng), uz = u_dist(rng);
+        for (int q = 0; q < 19; ++q) f[cell * 19 + q] = equilibrium(lattice, q, rho, ux, uy, uz) + neq_dist(rng);
+    }
+
+    registry.apply("f", batch(f, out, 19));
+
+    for (size_t p = 0; p < NUM_PARENTS; ++p) {
+        double child_moments[4] = {0, 0, 0, 0}, parent_moments[4] = {0, 0, 0, 0};
+        for (int q = 0; q < 19; ++q) {
+            for (int k = 0; k < 8; ++k) {
+                float fq = f[child_table[p * 8 + k] * 19 + q];
+                child_moments[0] += fq / 8.0;
+                for (int d = 0; d < 3; ++d) child_moments[d + 1] += fq * lattice.velocities[q][d] / 8.0;
+            }
+            parent_moments[0] += out[p * 19 + q];
+            for (int d = 0; d < 3; ++d) parent_moments[d + 1] += out[p * 19 + q] * lattice.velocities[q][d];
+        }
+        for (int m = 0; m < 4; ++m) {
+            EXPECT_NEAR(parent_moments[m], child_moments[m], 2e-6) << "moment " << m;
+        }
+    }
+}
+
+TEST_F(FieldAveragingRulesTest, LbmRestrictionRescalesNonEquilibrium) {
+    auto lattice = d3q19(0.9f);
+    FieldAveragingRuleRegistry::RuleEntry entry;
+    entry.rule = RestrictionRule::LBM_EQ_NONEQ;
+    entry.lbm = lattice;
+
+    // Identical children: the parent is their equilibrium plus the scaled neq part
+    const float rho = 1.02f, ux = 0.03f, uy = -0.01f, uz = 0.02f;
+    std::vector<float> neq(19, 0.0f);
+    neq[7] = neq[8] = 2e-4f;   // Traceless shear perturbation: zero mass, zero momentum
+    neq[9] = neq[10] = -2e-4f;
+    std::vector<float> f(NUM_PARENTS * 8 * 19), out;
+    for (size_t cell = 0; cell < NUM_PARENTS * 8; ++cell) {
+        for (int q = 0; q < 19; ++q) f[cell * 19 + q] = equilibrium(lattice, q, rho, ux, uy, uz) + neq[q];
+    }
+    FieldAveragingRuleRegistry::apply(entry, batch(f, out, 19));
+
+    float scale = lattice.nonEquilibriumScale();
+    EXPECT_FLOAT_EQ(lattice.tauCoarse(), 0.7f);
+    for (size_t p = 0; p < NUM_PARENTS; ++p) {
+        for (int q = 0; q < 19; ++q) {
+            EXPECT_NEAR(out[p * 19 + q], equilibrium(lattice, q, rho, ux, uy, uz) + scale * neq[q], 1e-6f);
+        }
+    }
+}
+
+TEST_F(FieldAveragingRulesTest, BatchOnlyTouchesItsParentRange) {
+    std::vector<float> in(NUM_PARENTS * 8, 1.0f), out;
+    RestrictionBatch b = batch(in, out, 1);
+    b.parent_begin = 1;
+    b.parent_end = 2;
+    FieldAveragingRuleRegistry::getInstance().apply("x", b);
+    EXPECT_FLOAT_EQ(out[0], -1.0f);
+    EXPECT_FLOAT_EQ(out[1], 1.0f);
+    EXPECT_FLOAT_EQ(out[2], -1.0f);
+}
+
+TEST_F(FieldAveragingRulesTest, RejectsIncompleteRegistrations) {
+    auto& registry = FieldAveragingRuleRegistry::getInstance();
+    EXPECT_THROW(registry.registerRule("f", "lbm_eq_noneq"), std::invalid_argument);
+    EXPECT_THROW(registry.registerRule("u", RestrictionRule::MASS_WEIGHTED), std::invalid_argument);
+    EXPECT_THROW(registry.registerRule("x", "median"), std::invalid_argument);
+    EXPECT_THROW(registry.registerMassWeightedRule("rho", "rho"), std::invalid_argument);
+
+    auto lattice = d3q19(0.5f);
+    EXPECT_THROW(registry.registerLbmRule("f", lattice), std::invalid_argument);
+    lattice.tau_fine = 0.8f;
+    lattice.weights.pop_back();
+    EXPECT_THROW(registry.registerLbmRule("f", lattice), std::invalid_argument);
+}
+
+TEST_F(FieldAveragingRulesTest, GeneratesOneDeviceKernelPerField) {
+    auto& registry = FieldAveragingRuleRegistry::getInstance();
+    registry.registerMassWeightedRule("vel.x", "rho");
+    registry.registerLbmRule("f", d3q19(0.8f));
+
+    EXPECT_EQ(FieldAveragingRuleRegistry::deviceKernelName("vel.x"), "restrict_vel_x");
+
+    std::string mass_src = registry.generateDeviceSource("vel.x", 3);
+    EXPECT_NE(mass_src.find("__kernel void restrict_vel_x("), std::string::npos);
+    EXPECT_NE(mass_src.find("child_density"), std::string::npos);
+
+    std::string lbm_src = registry.generateDeviceSource("f", 19);
+    EXPECT_NE(lbm_src.find("__constant float restrict_f_w[19]"), std::string::npos);
+    EXPECT_EQ(lbm_src.find("child_density"), std::string::npos);
+    EXPECT_THROW(registry.generateDeviceSource("f", 27), std::invalid_argument);
+
+    std::string default_src = registry.generateDeviceSource("pressure", 1);
+    EXPECT_NE(default_src.find("1.250000000e-01f"), std::string::npos);
+}
+
+TEST_F(FieldAveragingRulesTest, LimitedProlongationIsConservative) {
+    auto& registry = FieldAveragingRuleRegistry::getInstance();
+    registry.registerProlongation("rho", "minmod");
+    registry.registerRule("mass", RestrictionRule::VOLUME_WEIGHTED);
+    registry.registerProlongation("mass", ProlongationRule::MC);
+
+    // Row of 3 parents along x with a 2-component field; parent 1 splits into
+    // children 0..7 and has neighbors on x only
+    const std::vector<float> parents = {1.0f, 5.0f,  2.0f, 3.0f,  4.0f, 4.0f};
+    const std::vector<uint32_t> block_start = {INVALID_INDEX, 0, INVALID_INDEX};
+    const std::vector<uint32_t> neighbors = {0, 2, INVALID_INDEX, INVALID_INDEX, INVALID_INDEX, INVALID_INDEX};
+    std::vector<float> children(8 * 2);
+
+    ProlongationBatch b;
+    b.child_block_start = block_start.data();
+    b.parent_neighbors = neighbors.data();
+    b.parent_begin = 0;
+    b.parent_end = 3;
+    b.parent_data = parents.data();
+    b.child_data = children.data();
+    b.num_components = 2;
+
+    // minmod(1, 2) = 1 on component 0; component 1 is an extremum, so flat
+    registry.prolong("rho", b);
+    for (uint32_t k = 0; k < 8; ++k) {
+        EXPECT_FLOAT_EQ(children[k * 2], (k & 1) ? 2.25f : 1.75f);
+        EXPECT_FLOAT_EQ(children[k * 2 + 1], 3.0f);
+    }
+
+    // Restricting the children gives back the parent
+    std::vector<uint32_t> identity(8);
+    for (uint32_t k = 0; k < 8; ++k) identity[k] = k;
+    std::vector<float> restored(2);
+    RestrictionBatch r;
+    r.child_indices = identity.data();
+    r.parent_begin = 0;
+    r.parent_end = 1;
+    r.child_data = children.data();
+    r.parent_data = restored.data();
+    r.num_components = 2;
+    registry.apply("rho", r);
+    EXPECT_FLOAT_EQ(restored[0], 2.0f);
+    EXPECT_FLOAT_EQ(restored[1], 3.0f);
+
+    // MC: min(2 * 1, (1 + 2) / 2) = 1.5; volume-weighted children sum to the parent
+    registry.prolong("mass", b);
+    EXPECT_FLOAT_EQ(children[0], 0.125f * (2.0f - 0.375f));
+    EXPECT_FLOAT_EQ(children[2], 0.125f * (2.0f + 0.375f));
+    registry.apply("mass", r);
+    EXPECT_FLOAT_EQ(restored[0], 2.0f);
+    EXPECT_FLOAT_EQ(restored[1], 3.0f);
+
+    // Injection needs no neighbors
+    b.parent_neighbors = nullptr;
+    registry.prolong("pressure", b);
+    EXPECT_FLOAT_EQ(children[0], 2.0f);
+    EXPECT_THROW(registry.prolong("rho", b), std::invalid_argument);
+}
+
+TEST_F(FieldAveragingRulesTest, ProlongationIsKeptAndValidatedPerField) {
+    auto& registry = FieldAveragingRuleRegistry::getInstance();
+    EXPECT_FALSE(registry.hasSlopeProlongation());
+    EXPECT_FALSE(registry.needsProlongation("pressure"));
+
+    registry.registerProlongation("p", ProlongationRule::MC);
+    registry.registerRule("p", "volume_weighted");
+    EXPECT_EQ(registry.getRule("p").prolongation, ProlongationRule::MC);
+    EXPECT_TRUE(registry.hasSlopeProlongation());
+    EXPECT_TRUE(registry.needsProlongation("p"));
+
+    // Slopes do not invert mass-weighted or LBM restriction
+    registry.registerMassWeightedRule("u", "rho");
+    EXPECT_THROW(registry.registerProlongation("u", "minmod"), std::invalid_argument);
+    EXPECT_THROW(registry.registerMassWeightedRule("p", "rho"), std::invalid_argument);
+    EXPECT_THROW(registry.registerProlongation("x", "cubic"), std::invalid_argument);
+
+    registry.registerProlongation("p", "injection");
+    EXPECT_FALSE(registry.hasSlopeProlongation());
+    EXPECT_TRUE(registry.needsProlongation("p"));  // Volume-weighted children split the parent
+}
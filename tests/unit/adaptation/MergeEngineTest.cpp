@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include "fluidloom/adaptation/MergeEngine.h"
 #include "fluidloom/adaptation/CellDescriptor.h"
+#include "fluidloom/adaptation/FieldAveragingRules.h"
 #include <vector>
 
 using namespace fluidloom;
@@ -61,11 +62,67 @@ TEST_F(MergeEngineTest, MergeSiblings) {
     EXPECT_EQ(res.num_parents_created, 1);
     EXPECT_EQ(res.num_children_merged, 8);
     
-    if (!res.parents.empty()) {
-        EXPECT_EQ(res.parents[0].level, 0);
-        EXPECT_EQ(res.parents[0].x, 0);
+    // Parents stay on the device
+    if (res.num_parents_created > 0) {
+        uint8_t level = 0xFF;
+        int px = -1;
+        clEnqueueReadBuffer(queue, res.parent_level, CL_TRUE, 0, sizeof(uint8_t), &level, 0, nullptr, nullptr);
+        clEnqueueReadBuffer(queue, res.parent_x, CL_TRUE, 0, sizeof(int), &px, 0, nullptr, nullptr);
+        EXPECT_EQ(level, 0);
+        EXPECT_EQ(px, 0);
     }
     
     clReleaseMemObject(x); clReleaseMemObject(y); clReleaseMemObject(z);
     clReleaseMemObject(l); clReleaseMemObject(s); clReleaseMemObject(f); clReleaseMemObject(m);
 }
+
+TEST_F(MergeEngineTest, NamedFieldsUseTheirRegisteredRule) {
+    size_t num_cells = 8;
+    std::vector<int> h_x(8), h_y(8), h_z(8);
+    std::vector<uint8_t> h_level(8, 1), h_state(8, 0);
+    std::vector<int> h_flags(8, -1); // COARSEN
+    std::vector<uint32_t> h_mat(8, 0);
+    std::vector<float> h_u(8), h_rho(8);
+    
+    for(int i=0; i<8; ++i) {
+        h_x[i] = (i & 1);
+        h_y[i] = (i >> 1) & 1;
+        h_z[i] = (i >> 2) & 1;
+        h_u[i] = static_cast<float>(i);
+        h_rho[i] = i < 4 ? 1.0f : 3.0f;
+    }
+    
+    auto& registry = FieldAveragingRuleRegistry::getInstance();
+    registry.registerMassWeightedRule("merge_u", "merge_rho");
+    registry.registerRule("merge_mass", RestrictionRule::VOLUME_WEIGHTED);
+    
+    cl_int err;
+    cl_mem x = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, 8*sizeof(int), h_x.data(), &err);
+    cl_mem y = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, 8*sizeof(int), h_y.data(), &err);
+    cl_mem z = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, 8*sizeof(int), h_z.data(), &err);
+    cl_mem l = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, 8*sizeof(uint8_t), h_level.data(), &err);
+    cl_mem s = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, 8*sizeof(uint8_t), h_state.data(), &err);
+    cl_mem f = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, 8*sizeof(int), h_flags.data(), &err);
+    cl_mem m = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, 8*sizeof(uint32_t), h_mat.data(), &err);
+    cl_mem u = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, 8*sizeof(float), h_u.data(), &err);
+    cl_mem rho = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, 8*sizeof(float), h_rho.data(), &err);
+    
+    // Σ ρu / Σ ρ = 72 / 16, not the arithmetic mean 3.5
+    MergeResult weighted = engine->merge(x, y, z, l, s, f, m, num_cells, u, 1, "merge_u", rho);
+    ASSERT_EQ(weighted.num_parents_created, 1u);
+    ASSERT_NE(weighted.averaged_fields, nullptr);
+    float value = 0.0f;
+    clEnqueueReadBuffer(queue, weighted.averaged_fields, CL_TRUE, 0, sizeof(float), &value, 0, nullptr, nullptr);
+    EXPECT_FLOAT_EQ(value, 4.5f);
+    
+    // Extensive quantity: sum of the children
+    MergeResult summed = engine->merge(x, y, z, l, s, f, m, num_cells, u, 1, "merge_mass");
+    ASSERT_EQ(summed.num_parents_created, 1u);
+    ASSERT_NE(summed.averaged_fields, nullptr);
+    clEnqueueReadBuffer(queue, summed.averaged_fields, CL_TRUE, 0, sizeof(float), &value, 0, nullptr, nullptr);
+    EXPECT_FLOAT_EQ(value, 28.0f);
+    
+    clReleaseMemObject(x); clReleaseMemObject(y); clReleaseMemObject(z);
+    clReleaseMemObject(l); clReleaseMemObject(s); clReleaseMemObject(f); clReleaseMemObject(m);
+    clReleaseMemObject(u); clReleaseMemObject(rho);
+}
@@ -54,8 +54,11 @@ TEST_F(SplitEngineTest, SplitSingleCell) {
     EXPECT_EQ(res.num_children, 8);
     EXPECT_EQ(res.num_parents_split, 1);
     
-    for(const auto& child : res.children) {
-        EXPECT_EQ(child.level, 1);
+    // Children stay on the device
+    std::vector<uint8_t> child_level(res.num_children);
+    clEnqueueReadBuffer(queue, res.child_level, CL_TRUE, 0, child_level.size(), child_level.data(), 0, nullptr, nullptr);
+    for (uint8_t level : child_level) {
+        EXPECT_EQ(level, 1);
     }
     
     clReleaseMemObject(x); clReleaseMemObject(y); clReleaseMemObject(z);
@@ -3,6 +3,7 @@
 #include "fluidloom/core/registry/FieldRegistry.h"
 #include "fluidloom/core/fields/SOAFieldManager.h"
 #include "fluidloom/core/backend/BackendFactory.h"
+#include <algorithm>
 
 using namespace fluidloom;
 using namespace fluidloom::fields;
@@ -171,6 +172,19 @@ TEST(FieldRegistryTest, GetAllNames) {
     EXPECT_GE(names.size(), initial_count + 2);
 }
 
+TEST(FieldRegistryTest, FindByInternedName) {
+    auto& registry = FieldRegistry::instance();
+    
+    FieldDescriptor desc("interned_lookup_test", FieldType::FLOAT32, 3);
+    registry.registerField(desc);
+    
+    const FieldDescriptor* found = registry.find(fluidloom::intern("interned_lookup_test"));
+    ASSERT_NE(found, nullptr);
+    EXPECT_EQ(found->num_components, 3);
+    EXPECT_EQ(registry.find(fluidloom::intern("interned_missing_test")), nullptr);
+    EXPECT_EQ(registry.find(fluidloom::INVALID_SYMBOL), nullptr);
+}
+
 // ========== SOAFieldManager Tests ==========
 
 class SOAFieldManagerTest : public ::testing::Test {
@@ -228,6 +242,34 @@ TEST_F(SOAFieldManagerTest, ResizeField) {
     EXPECT_EQ(manager->getAllocationSize(handle), 2000);
 }
 
+TEST_F(SOAFieldManagerTest, ResizeWithoutPreserve) {
+    FieldDescriptor desc("test", FieldType::FLOAT32, 1);
+    
+    FieldHandle handle = manager->allocate(desc, 1000);
+    uint64_t version = manager->getVersion(handle);
+    
+    manager->resize(handle, 4000, false);
+    EXPECT_EQ(manager->getAllocationSize(handle), 4000);
+    EXPECT_GT(manager->getVersion(handle), version);
+}
+
+TEST_F(SOAFieldManagerTest, GetHandlesListsEveryField) {
+    EXPECT_TRUE(manager->getHandles().empty());
+    
+    FieldHandle rho = manager->allocate(FieldDescriptor("rho", FieldType::FLOAT32, 1), 100);
+    FieldHandle u = manager->allocate(FieldDescriptor("u", FieldType::FLOAT32, 3), 100);
+    
+    auto handles = manager->getHandles();
+    ASSERT_EQ(handles.size(), 2u);
+    EXPECT_NE(std::find(handles.begin(), handles.end(), rho), handles.end());
+    EXPECT_NE(std::find(handles.begin(), handles.end(), u), handles.end());
+    
+    manager->deallocate(rho);
+    handles = manager->getHandles();
+    ASSERT_EQ(handles.size(), 1u);
+    EXPECT_EQ(handles[0], u);
+}
+
 TEST_F(SOAFieldManagerTest, VersionTracking) {
     FieldDescriptor desc("test", FieldType::FLOAT32, 1);
     
@@ -302,3 +344,28 @@ TEST_F(SOAFieldManagerTest, MultipleFields) {
     EXPECT_EQ(manager->getAllocationSize(handle2), 2000);
     EXPECT_EQ(manager->getAllocationSize(handle3), 3000);
 }
+
+TEST_F(SOAFieldManagerTest, AliasedFieldsShareOneBuffer) {
+    std::vector<FieldDescriptor> descs = {
+        FieldDescriptor("scratch_a", FieldType::FLOAT32, 1),
+        FieldDescriptor("scratch_b", FieldType::FLOAT32, 3),
+    };
+    FieldHandle dedicated = manager->allocate(FieldDescriptor("rho", FieldType::FLOAT32, 1), 1000);
+
+    auto handles = manager->allocateAliased(descs, 1000);
+    ASSERT_EQ(handles.size(), 2u);
+
+    EXPECT_TRUE(manager->sharesStorage(handles[0], handles[1]));
+    EXPECT_FALSE(manager->sharesStorage(handles[0], dedicated));
+    EXPECT_EQ(manager->getDevicePtr(handles[0], 0), manager->getDevicePtr(handles[1], 0));
+
+    // The shared buffer is sized for the largest member and counted once
+    EXPECT_EQ(manager->getMemoryUsage(handles[0]), manager->getMemoryUsage(handles[1]));
+    EXPECT_EQ(manager->getTotalMemoryUsage(),
+              manager->getMemoryUsage(dedicated) + manager->getMemoryUsage(handles[1]));
+
+    // Resizing one member resizes the group
+    manager->resize(handles[0], 2000);
+    EXPECT_EQ(manager->getAllocationSize(handles[1]), 2000);
+    EXPECT_TRUE(manager->sharesStorage(handles[0], handles[1]));
+}
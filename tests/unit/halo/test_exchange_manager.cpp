@@ -95,3 +95,108 @@ TEST_F(ExchangeManagerTest, ExchangeCycle) {
     // Swap buffers
     EXPECT_NO_THROW(manager->swapBuffers());
 }
+
+TEST_F(ExchangeManagerTest, TopologyIsFrozenDuringExchange) {
+    manager->initialize(10);
+    
+    GhostRange range;
+    range.hilbert_start = 0;
+    range.hilbert_end = 100;
+    range.target_gpu = 1;
+    range.pack_size_bytes = 1024;
+    manager->addGhostRange(range);
+    
+    manager->exchangeAsync();
+    EXPECT_THROW(manager->addGhostRange(range), std::runtime_error);
+    EXPECT_THROW(manager->setCompression(transport::CompressionPolicy()), std::runtime_error);
+    EXPECT_THROW(manager->initialize(10), std::runtime_error);
+    
+    manager->waitCompletion();
+    EXPECT_NO_THROW(manager->addGhostRange(range));
+}
+
+namespace {
+
+constexpr size_t kCells = 32;
+
+// Periodic self-exchange of two coarse ghosts restricted from local fine
+// cells: the first has all 8 children, the second only 4
+void addFineToCoarseRanges(HaloExchangeManager& manager) {
+    GhostRange fine;
+    fine.hilbert_start = 0;
+    fine.hilbert_end = 16;
+    fine.target_gpu = 0;
+    fine.local_level = 1;
+    fine.remote_level = 0;
+    fine.cached.neighbor_cell_indices.assign(16, VolumeWeightedAverager::UNUSED);
+    for (uint32_t k = 0; k < 8; ++k) fine.cached.neighbor_cell_indices[k] = k;
+    for (uint32_t k = 0; k < 4; ++k) fine.cached.neighbor_cell_indices[8 + 2 * k] = 8 + k;
+
+    // The same keys seen from the coarse side, scattered into ghosts 20 and 21
+    GhostRange coarse = fine;
+    coarse.local_level = 0;
+    coarse.remote_level = 1;
+    coarse.cached.local_cell_indices = {20, 21};
+    coarse.cached.neighbor_cell_indices.clear();
+    coarse.cached.num_cells = 2;
+
+    manager.addGhostRange(fine);
+    manager.addGhostRange(coarse);
+}
+
+} // namespace
+
+TEST_F(ExchangeManagerTest, FineToCoarseGhostsAverageValidChildren) {
+    manager->initialize(1);
+    addFineToCoarseRanges(*manager);
+
+    std::vector<float> values(2 * kCells);
+    for (size_t i = 0; i < kCells; ++i) {
+        values[i] = static_cast<float>(i);
+        values[kCells + i] = 100.0f + 2.0f * i;
+    }
+    manager->addHaloField({7, 2, values.data(), kCells});
+
+    manager->exchangeAsync();
+    manager->waitCompletion();
+
+    EXPECT_EQ(manager->getStats().restricted_cells, 2u);
+    EXPECT_FLOAT_EQ(values[20], 3.5f);                  // Mean of cells 0..7
+    EXPECT_FLOAT_EQ(values[21], 9.5f);                  // Mean of cells 8..11 only
+    EXPECT_FLOAT_EQ(values[kCells + 20], 107.0f);
+    EXPECT_FLOAT_EQ(values[kCells + 21], 119.0f);
+    EXPECT_FLOAT_EQ(values[19], 19.0f);
+}
+
+TEST_F(ExchangeManagerTest, ConservationCheckCadence) {
+    manager->initialize(1);
+    addFineToCoarseRanges(*manager);
+
+    std::vector<float> density(kCells);
+    for (size_t i = 0; i < kCells; ++i) density[i] = 1.0f + 0.25f * i;
+    manager->addHaloField({3, 1, density.data(), kCells});
+
+    auto cycle = [this] {
+        manager->exchangeAsync();
+        manager->waitCompletion();
+        manager->swapBuffers();
+    };
+
+    cycle();
+    EXPECT_EQ(manager->getStats().conservation_checks, 0u);
+
+    // Exchanges 2..5: checked on 3 and 6 only
+    manager->setConservationCheckInterval(3);
+    for (int i = 0; i < 4; ++i) cycle();
+    auto stats = manager->getStats();
+    EXPECT_EQ(stats.conservation_checks, 1u);
+    EXPECT_EQ(stats.conservation_violations, 0u);
+    ASSERT_EQ(manager->getConservationReports().size(), 1u);
+    const auto& report = manager->getConservationReports()[0];
+    EXPECT_TRUE(report.conserved);
+    EXPECT_NEAR(report.fine_total, 8 * 1.0 + 0.25 * 28 + 4 * 1.0 + 0.25 * 38, 1e-6);
+    EXPECT_NEAR(report.coarse_total, report.fine_total, 1e-5);
+
+    cycle();
+    EXPECT_EQ(manager->getStats().conservation_checks, 2u);
+}
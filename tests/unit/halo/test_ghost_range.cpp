@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include "fluidloom/halo/GhostRangeBuilder.h"
 #include "fluidloom/common/mpi/MPIEnvironment.h"
+#include <algorithm>
 
 using namespace fluidloom;
 using namespace fluidloom::halo;
@@ -45,9 +46,99 @@ TEST_F(GhostRangeTest, BuilderTopology) {
 
 TEST_F(GhostRangeTest, GhostCandidateIdentification) {
     GhostRangeBuilder builder;
-    std::vector<hilbert::HilbertIndex> local_cells = {100, 150, 200};
+    auto& env = mpi::MPIEnvironment::getInstance();
+    int rank = env.getRank();
+    int size = env.getSize();
+    
+    // Rank r owns [r * 1000, (r + 1) * 1000); the last rank owns the rest
+    std::vector<uint64_t> splits;
+    for (int r = 1; r < size; ++r) splits.push_back(static_cast<uint64_t>(r) * 1000);
+    builder.applySplits(splits);
+    
+    // A local cell next to the first key of the next rank; with a single
+    // rank any cell will do
+    uint64_t my_start = rank == 0 ? 0 : splits[rank - 1];
+    hilbert::HilbertIndex remote = rank < size - 1 ? splits[rank] : 0;
+    hilbert::HilbertIndex boundary = my_start;
+    if (rank < size - 1) {
+        int32_t x, y, z;
+        hilbert::decode(remote, hilbert::MAX_REFINEMENT_LEVEL, x, y, z);
+        bool found = false;
+        for (int32_t d = 0; d < 27 && !found; ++d) {
+            int32_t nx = x + d % 3 - 1, ny = y + (d / 3) % 3 - 1, nz = z + d / 9 - 1;
+            if (nx < 0 || ny < 0 || nz < 0) continue;
+            hilbert::HilbertIndex key = hilbert::encode(nx, ny, nz, hilbert::MAX_REFINEMENT_LEVEL);
+            if (key >= my_start && key < splits[rank]) {
+                boundary = key;
+                found = true;
+            }
+        }
+        ASSERT_TRUE(found);
+    }
+    std::vector<hilbert::HilbertIndex> local_cells = {boundary};
+    
+    EXPECT_TRUE(builder.identifyGhostCandidates(local_cells, 0).empty());
     
-    // This is currently a placeholder implementation, so we expect empty results
     auto candidates = builder.identifyGhostCandidates(local_cells, 1);
-    EXPECT_TRUE(candidates.empty());
+    if (size == 1) {
+        EXPECT_TRUE(candidates.empty());  // Every neighbor is local
+        return;
+    }
+    
+    for (const auto& candidate : candidates) {
+        EXPECT_NE(candidate.target_rank, rank);
+        EXPECT_LE(candidate.start_idx, candidate.end_idx);
+        
+        // Ranges never straddle an owner boundary
+        uint64_t owner_start = candidate.target_rank == 0 ? 0 : splits[candidate.target_rank - 1];
+        EXPECT_GE(candidate.start_idx, owner_start);
+        if (candidate.target_rank < size - 1) {
+            EXPECT_LT(candidate.end_idx, splits[candidate.target_rank]);
+        }
+    }
+    
+    if (rank < size - 1) {
+        bool next_requested = std::any_of(candidates.begin(), candidates.end(), [&](const GhostCandidate& c) {
+            return c.target_rank == rank + 1 && c.start_idx <= remote && remote <= c.end_idx;
+        });
+        EXPECT_TRUE(next_requested);
+    }
+}
+
+TEST_F(GhostRangeTest, ApplySplitsReportsMovedRanks) {
+    GhostRangeBuilder builder;
+    int size = mpi::MPIEnvironment::getInstance().getSize();
+    
+    std::vector<uint64_t> splits;
+    for (int r = 1; r < size; ++r) splits.push_back(static_cast<uint64_t>(r) * 1000);
+    
+    // Fresh builder: every rank's range is new
+    EXPECT_EQ(builder.applySplits(splits).size(), static_cast<size_t>(size));
+    
+    // Same splits again: nothing moved
+    EXPECT_TRUE(builder.applySplits(splits).empty());
+    
+    EXPECT_THROW(builder.applySplits(std::vector<uint64_t>(size)), std::invalid_argument);
+    
+    // A zero or repeated split would leave a rank an empty (wrapped) range
+    if (size > 1) {
+        EXPECT_THROW(builder.applySplits(std::vector<uint64_t>(size - 1, 0)), std::invalid_argument);
+    }
+    if (size > 2) {
+        std::vector<uint64_t> repeated = splits;
+        repeated[1] = repeated[0];
+        EXPECT_THROW(builder.applySplits(repeated), std::invalid_argument);
+    }
+}
+
+TEST_F(GhostRangeTest, RebuildAfterRebalanceSkipsUnmovedBoundaries) {
+    GhostRangeBuilder builder;
+    int size = mpi::MPIEnvironment::getInstance().getSize();
+    
+    std::vector<uint64_t> splits;
+    for (int r = 1; r < size; ++r) splits.push_back(static_cast<uint64_t>(r) * 1000);
+    std::vector<hilbert::HilbertIndex> local_cells = {100, 150, 200};
+    
+    EXPECT_TRUE(builder.rebuildAfterRebalance(splits, local_cells, 1));
+    EXPECT_FALSE(builder.rebuildAfterRebalance(splits, local_cells, 1));
 }
@@ -1,8 +1,10 @@
 #include <gtest/gtest.h>
 #include "fluidloom/halo/InterpolationParams.h"
 #include "fluidloom/halo/interpolation/TrilinearInterpolator.h"
+#include "fluidloom/halo/interpolation/VolumeWeightedAverager.h"
 #include "fluidloom/core/backend/MockBackend.h"
 
+using namespace fluidloom;
 using namespace fluidloom::halo;
 
 TEST(InterpolationTest, TrilinearParamsValidation) {
@@ -30,3 +32,144 @@ TEST(InterpolationTest, LUTInitialization) {
     const auto& cf_params = lut.get(1, 0); // Local 1 (fine), Remote 0 (coarse)
     EXPECT_TRUE(cf_params.validate());
 }
+
+// ========== VolumeWeightedAverager Tests ==========
+
+namespace {
+
+// Two coarse cells, the second covered by only four fine cells
+GhostRange makeAveragingRange() {
+    GhostRange range;
+    range.hilbert_start = 0;
+    range.hilbert_end = 16;
+    range.target_gpu = 1;
+    range.interpolation_type = GhostRange::InterpolationType::VOLUME_WEIGHTED_AVERAGE;
+    range.cached.local_cell_indices = {3, 0};
+    range.cached.neighbor_cell_indices.assign(16, VolumeWeightedAverager::UNUSED);
+    for (uint32_t k = 0; k < 8; ++k) {
+        range.cached.neighbor_cell_indices[k] = k;
+    }
+    for (uint32_t k = 0; k < 4; ++k) {
+        range.cached.neighbor_cell_indices[8 + 2 * k] = 8 + k;
+    }
+    range.cached.num_cells = 2;
+    return range;
+}
+
+} // namespace
+
+class VolumeWeightedAveragerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        backend.initialize();
+        // "rho" (1 component) then "u" (2 components), 16 fine and 4 coarse cells per plane
+        layout.addField("rho", 1, sizeof(float));
+        layout.addField("u", 2, sizeof(float));
+        fine.assign(3 * 16, 0.0f);
+        coarse.assign(3 * 4, -1.0f);
+        for (size_t i = 0; i < fine.size(); ++i) {
+            fine[i] = 0.5f + static_cast<float>(i);
+        }
+        averager.buildMasks({makeAveragingRange()});
+    }
+
+    Buffer fineBuffer() { return Buffer{fine.data(), fine.size() * sizeof(float), nullptr}; }
+    Buffer coarseBuffer() { return Buffer{coarse.data(), coarse.size() * sizeof(float), nullptr}; }
+
+    fluidloom::MockBackend backend;
+    VolumeWeightedAverager averager{&backend};
+    PackBufferLayout layout;
+    std::vector<float> fine;
+    std::vector<float> coarse;
+};
+
+TEST_F(VolumeWeightedAveragerTest, RestrictsEveryFieldInOnePass) {
+    ASSERT_EQ(averager.getNumMasks(), 2u);
+
+    Buffer fine_b = fineBuffer();
+    Buffer coarse_b = coarseBuffer();
+    averager.restrictFields(layout, fine_b, coarse_b);
+
+    for (size_t plane = 0; plane < 3; ++plane) {
+        const float* f = &fine[plane * 16];
+        float full = 0.0f;
+        for (size_t k = 0; k < 8; ++k) full += f[k];
+        float partial = f[8] + f[9] + f[10] + f[11];
+
+        EXPECT_FLOAT_EQ(coarse[plane * 4 + 3], full / 8.0f) << "plane " << plane;
+        EXPECT_FLOAT_EQ(coarse[plane * 4 + 0], partial / 4.0f) << "plane " << plane;
+        // Cells without a mask are untouched
+        EXPECT_EQ(coarse[plane * 4 + 1], -1.0f);
+    }
+}
+
+TEST_F(VolumeWeightedAveragerTest, ConservationHoldsAfterRestriction) {
+    Buffer fine_b = fineBuffer();
+    Buffer coarse_b = coarseBuffer();
+    averager.restrictFields(layout, fine_b, coarse_b);
+
+    auto reports = averager.checkConservation(layout, coarse_b, fine_b, 1e-6);
+    ASSERT_EQ(reports.size(), 2u);
+    EXPECT_EQ(reports[0].field_name, "rho");
+    EXPECT_EQ(reports[1].field_name, "u");
+    for (const auto& report : reports) {
+        EXPECT_TRUE(report.conserved) << report.field_name;
+        EXPECT_NEAR(report.fine_total, report.coarse_total, 1e-4);
+    }
+
+    fluidloom::fields::FieldDescriptor rho("rho", fluidloom::fields::FieldType::FLOAT32, 1);
+    EXPECT_TRUE(averager.validateConservation(rho, coarse_b, fine_b));
+}
+
+TEST_F(VolumeWeightedAveragerTest, DetectsDriftInOneComponent) {
+    Buffer fine_b = fineBuffer();
+    Buffer coarse_b = coarseBuffer();
+    averager.restrictFields(layout, fine_b, coarse_b);
+
+    // Perturb the second component of "u" at one coarse cell
+    coarse[2 * 4 + 3] += 1e-3f;
+
+    auto reports = averager.checkConservation(layout, coarse_b, fine_b, 1e-6);
+    EXPECT_TRUE(reports[0].conserved);
+    EXPECT_FALSE(reports[1].conserved);
+    EXPECT_GT(reports[1].relative_error, 1e-6);
+}
+
+TEST_F(VolumeWeightedAveragerTest, CompensatedTotalsKeepSmallTerms) {
+    // One large value and many small ones: a naive float sum drops the small terms
+    PackBufferLayout scalar;
+    scalar.addField("mass", 1, sizeof(float));
+
+    const uint32_t num_coarse = 4096;
+    GhostRange range;
+    range.hilbert_end = 1;
+    range.target_gpu = 0;
+    range.interpolation_type = GhostRange::InterpolationType::VOLUME_WEIGHTED_AVERAGE;
+    for (uint32_t c = 0; c < num_coarse; ++c) {
+        range.cached.local_cell_indices.push_back(c);
+        for (uint32_t k = 0; k < 8; ++k) {
+            range.cached.neighbor_cell_indices.push_back(c * 8 + k);
+        }
+    }
+    averager.buildMasks({range});
+
+    std::vector<float> big_fine(num_coarse * 8, 1e-3f);
+    big_fine[0] = 1e5f;
+    std::vector<float> big_coarse(num_coarse);
+    Buffer fine_b{big_fine.data(), big_fine.size() * sizeof(float), nullptr};
+    Buffer coarse_b{big_coarse.data(), big_coarse.size() * sizeof(float), nullptr};
+    averager.restrictFields(scalar, fine_b, coarse_b);
+
+    auto reports = averager.checkConservation(scalar, coarse_b, fine_b);
+    ASSERT_EQ(reports.size(), 1u);
+    EXPECT_NEAR(reports[0].fine_total, 1e5 + (num_coarse * 8 - 1) * static_cast<double>(1e-3f), 1e-6);
+    EXPECT_TRUE(reports[0].conserved) << reports[0].relative_error;
+}
+
+TEST_F(VolumeWeightedAveragerTest, CheckInterval) {
+    EXPECT_FALSE(averager.isCheckStep(0));
+    averager.setCheckInterval(10);
+    EXPECT_TRUE(averager.isCheckStep(0));
+    EXPECT_FALSE(averager.isCheckStep(5));
+    EXPECT_TRUE(averager.isCheckStep(20));
+}
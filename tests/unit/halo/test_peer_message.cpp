@@ -0,0 +1,237 @@
+#include <gtest/gtest.h>
+#include "fluidloom/halo/PeerMessage.h"
+#include "fluidloom/halo/communicators/HaloExchangeManager.h"
+#include "fluidloom/core/backend/MockBackend.h"
+#include "fluidloom/core/registry/FieldRegistry.h"
+#include <cstring>
+
+using namespace fluidloom;
+using namespace fluidloom::halo;
+
+namespace {
+
+GhostRange makeRange(uint64_t start, uint64_t end, int peer, uint8_t local_level, uint8_t remote_level,
+                     std::vector<uint32_t> local, std::vector<uint32_t> neighbors = {}) {
+    GhostRange range;
+    range.hilbert_start = start;
+    range.hilbert_end = end;
+    range.target_gpu = peer;
+    range.local_level = local_level;
+    range.remote_level = remote_level;
+    range.requires_interpolation = local_level != remote_level;
+    range.cached.num_cells = local.size();
+    range.cached.local_cell_indices = std::move(local);
+    range.cached.neighbor_cell_indices = std::move(neighbors);
+    return range;
+}
+
+// SOA field: value(component, cell) = 1000 * field_id + 100 * component + cell
+struct TestField {
+    std::vector<float> values;
+    HaloFieldBinding binding;
+
+    TestField(uint32_t id, uint16_t components, size_t cells) : values(components * cells) {
+        for (uint16_t c = 0; c < components; ++c) {
+            for (size_t i = 0; i < cells; ++i) {
+                values[c * cells + i] = 1000.0f * id + 100.0f * c + static_cast<float>(i);
+            }
+        }
+        binding.field_id = id;
+        binding.num_components = components;
+        binding.data = values.data();
+        binding.stride = cells;
+    }
+};
+
+} // namespace
+
+TEST(PeerMessageTest, BuildOrdersSegmentsAndAlignsPayload) {
+    std::vector<GhostRange> ranges = {
+        makeRange(200, 300, 1, 0, 0, {7, 8, 9}),
+        makeRange(0, 100, 1, 0, 0, {1, 2}),
+        makeRange(100, 200, 2, 0, 0, {3, 4, 5, 6})    // Other peer
+    };
+    TestField scalar(5, 1, 16);
+    TestField vector(3, 3, 16);
+    auto layout = PeerMessageLayout::build(1, PeerMessageLayout::Direction::SEND, ranges,
+                                           {scalar.binding, vector.binding});
+
+    const auto& segments = layout.getSegments();
+    ASSERT_EQ(segments.size(), 4u);
+    EXPECT_EQ(segments[0].hilbert_start, 0u);
+    EXPECT_EQ(segments[0].field_id, 3u);
+    EXPECT_EQ(segments[1].field_id, 5u);
+    EXPECT_EQ(segments[2].hilbert_start, 200u);
+
+    // Each range's index list is stored once and shared by its fields
+    EXPECT_EQ(layout.getIndices(), (std::vector<uint32_t>{1, 2, 7, 8, 9}));
+    EXPECT_EQ(segments[0].index_offset, segments[1].index_offset);
+    EXPECT_EQ(segments[2].index_offset, 2u);
+
+    uint32_t cells = 0;
+    for (const auto& segment : segments) {
+        EXPECT_EQ(segment.cell_start, cells);
+        EXPECT_EQ(segment.payload_offset % (PeerMessageLayout::ALIGNMENT / sizeof(float)), 0u);
+        cells += segment.num_cells;
+    }
+    EXPECT_EQ(layout.getTotalCells(), 10u);
+    EXPECT_EQ(layout.getPayloadOffset() % PeerMessageLayout::ALIGNMENT, 0u);
+    EXPECT_GE(layout.getPayloadOffset(), sizeof(PeerMessageHeader) + 4 * sizeof(PeerSegment));
+
+    EXPECT_TRUE(PeerMessageLayout::build(3, PeerMessageLayout::Direction::SEND, ranges,
+                                         {scalar.binding}).empty());
+}
+
+TEST(PeerMessageTest, ReceiverRejectsMismatchedMessages) {
+    std::vector<GhostRange> ranges = {makeRange(0, 64, 1, 0, 0, {0, 1, 2, 3})};
+    TestField a(1, 1, 8);
+    TestField b(2, 1, 8);
+    auto send = PeerMessageLayout::build(1, PeerMessageLayout::Direction::SEND, ranges, {a.binding, b.binding});
+    auto recv = PeerMessageLayout::build(1, PeerMessageLayout::Direction::RECEIVE, ranges, {a.binding, b.binding});
+
+    std::vector<uint8_t> message(send.getMessageBytes());
+    send.writeHeader(message.data(), 7);
+    EXPECT_NO_THROW(recv.validate(message.data(), message.size(), 7));
+    EXPECT_THROW(recv.validate(message.data(), message.size(), 8), std::runtime_error);
+    EXPECT_THROW(recv.validate(message.data(), message.size() - 4, 7), std::runtime_error);
+
+    // Different field set on the receiver
+    auto other = PeerMessageLayout::build(1, PeerMessageLayout::Direction::RECEIVE, ranges, {a.binding});
+    EXPECT_THROW(other.validate(message.data(), message.size(), 7), std::runtime_error);
+
+    // Same sizes, different ghost range
+    std::vector<GhostRange> moved = {makeRange(0, 65, 1, 0, 0, {0, 1, 2, 3})};
+    auto shifted = PeerMessageLayout::build(1, PeerMessageLayout::Direction::RECEIVE, moved, {a.binding, b.binding});
+    EXPECT_THROW(shifted.validate(message.data(), message.size(), 7), std::runtime_error);
+
+    message[0] ^= 0xFF;
+    EXPECT_THROW(recv.validate(message.data(), message.size(), 7), std::runtime_error);
+}
+
+TEST(PeerMessageTest, PackUnpackAcrossLevelsAndFields) {
+    // Rank 0 sends rank 1 a same-level range and a fine range averaged onto
+    // rank 1's coarse ghost cells
+    std::vector<uint32_t> children(16);
+    for (uint32_t i = 0; i < 16; ++i) children[i] = 16 + i;
+    std::vector<GhostRange> sender_ranges = {
+        makeRange(0, 10, 1, 0, 0, {2, 5}),
+        makeRange(10, 20, 1, 1, 0, {}, children)
+    };
+    std::vector<GhostRange> receiver_ranges = {
+        makeRange(0, 10, 0, 0, 0, {40, 41}),
+        makeRange(10, 20, 0, 0, 1, {42, 43})
+    };
+
+    TestField density(1, 1, 48);
+    TestField velocity(2, 3, 48);
+    auto send = PeerMessageLayout::build(1, PeerMessageLayout::Direction::SEND, sender_ranges,
+                                         {density.binding, velocity.binding});
+    EXPECT_EQ(send.getSegments().back().sources_per_cell, 8);
+    EXPECT_EQ(send.getSegments().back().interpolation,
+              static_cast<uint8_t>(GhostRange::InterpolationType::VOLUME_WEIGHTED_AVERAGE));
+
+    std::vector<uint8_t> message(send.getMessageBytes());
+    send.writeHeader(message.data(), 1);
+    send.packHost({density.binding, velocity.binding}, message.data());
+
+    TestField ghost_density(1, 1, 48);
+    TestField ghost_velocity(2, 3, 48);
+    std::fill(ghost_density.values.begin(), ghost_density.values.end(), -1.0f);
+    std::fill(ghost_velocity.values.begin(), ghost_velocity.values.end(), -1.0f);
+    auto recv = PeerMessageLayout::build(0, PeerMessageLayout::Direction::RECEIVE, receiver_ranges,
+                                         {ghost_density.binding, ghost_velocity.binding});
+    ASSERT_NO_THROW(recv.validate(message.data(), message.size(), 1));
+    recv.unpackHost(message.data(), {ghost_density.binding, ghost_velocity.binding});
+
+    EXPECT_FLOAT_EQ(ghost_density.values[40], 1002.0f);
+    EXPECT_FLOAT_EQ(ghost_density.values[41], 1005.0f);
+    EXPECT_FLOAT_EQ(ghost_density.values[42], 1019.5f);    // Mean of cells 16..23
+    EXPECT_FLOAT_EQ(ghost_density.values[43], 1027.5f);    // Mean of cells 24..31
+    EXPECT_FLOAT_EQ(ghost_velocity.values[2 * 48 + 41], 2205.0f);
+    EXPECT_FLOAT_EQ(ghost_velocity.values[1 * 48 + 43], 2127.5f);
+    EXPECT_FLOAT_EQ(ghost_density.values[39], -1.0f);
+}
+
+TEST(PeerMessageTest, RestrictedRangesTravelAsCopies) {
+    // Restricted before packing: the fine range gathers its staging slots
+    std::vector<GhostRange> ranges = {makeRange(10, 20, 1, 1, 0, {0, 1}, std::vector<uint32_t>(16, 0))};
+    TestField density(1, 1, 16);
+    TestField staging(1, 1, 2);
+    std::vector<HaloFieldBinding> restricted = {staging.binding};
+
+    auto send = PeerMessageLayout::build(1, PeerMessageLayout::Direction::SEND, ranges, {density.binding},
+                                         PeerMessageLayout::ALL_LEVELS, &restricted);
+    ASSERT_EQ(send.getSegments().size(), 1u);
+    const PeerSegment& segment = send.getSegments()[0];
+    EXPECT_EQ(segment.sources_per_cell, 1);
+    EXPECT_EQ(segment.num_cells, 2u);
+    EXPECT_EQ(segment.field_slot, 1u);
+    EXPECT_EQ(segment.interpolation, static_cast<uint8_t>(GhostRange::InterpolationType::VOLUME_WEIGHTED_AVERAGE));
+
+    std::vector<uint8_t> message(send.getMessageBytes());
+    send.writeHeader(message.data(), 1);
+    send.packHost({density.binding, staging.binding}, message.data());
+
+    std::vector<GhostRange> receiver = {makeRange(10, 20, 0, 0, 1, {4, 5})};
+    TestField ghost(1, 1, 8);
+    auto recv = PeerMessageLayout::build(0, PeerMessageLayout::Direction::RECEIVE, receiver, {ghost.binding},
+                                         PeerMessageLayout::ALL_LEVELS, &restricted);
+    ASSERT_NO_THROW(recv.validate(message.data(), message.size(), 1));
+    recv.unpackHost(message.data(), {ghost.binding});
+    EXPECT_FLOAT_EQ(ghost.values[4], 1000.0f);
+    EXPECT_FLOAT_EQ(ghost.values[5], 1001.0f);
+
+    // Both ranks must agree on it
+    auto plain = PeerMessageLayout::build(0, PeerMessageLayout::Direction::RECEIVE, receiver, {ghost.binding});
+    EXPECT_THROW(plain.validate(message.data(), message.size(), 1), std::runtime_error);
+}
+
+TEST(PeerMessageTest, DueLevelsSelectSegments) {
+    std::vector<GhostRange> ranges = {
+        makeRange(0, 10, 1, 0, 0, {0, 1}),
+        makeRange(10, 20, 1, 2, 2, {2, 3, 4})
+    };
+    TestField field(1, 1, 8);
+    auto fine = PeerMessageLayout::build(1, PeerMessageLayout::Direction::SEND, ranges, {field.binding}, 1u << 2);
+    ASSERT_EQ(fine.getSegments().size(), 1u);
+    EXPECT_EQ(fine.getSegments()[0].source_level, 2);
+    EXPECT_EQ(fine.getTotalCells(), 3u);
+
+    auto all = PeerMessageLayout::build(1, PeerMessageLayout::Direction::SEND, ranges, {field.binding});
+    EXPECT_EQ(all.getSegments().size(), 2u);
+    EXPECT_TRUE(PeerMessageLayout::build(1, PeerMessageLayout::Direction::SEND, ranges, {field.binding},
+                                         1u << 1).empty());
+}
+
+TEST(PeerMessageTest, ExchangeManagerSendsOneMessagePerPeer) {
+    MockBackend backend;
+    backend.initialize();
+    HaloExchangeManager manager(&backend, registry::FieldRegistry::instance());
+    manager.initialize(1);
+
+    // Two levels and two fields towards this rank (periodic self-exchange)
+    manager.addGhostRange(makeRange(0, 10, 0, 0, 0, {0, 1, 2}));
+    manager.addGhostRange(makeRange(10, 20, 0, 1, 1, {3, 4}));
+    TestField density(1, 1, 8);
+    TestField velocity(2, 3, 8);
+    manager.addHaloField(density.binding);
+    manager.addHaloField(velocity.binding);
+    const std::vector<float> before = velocity.values;
+
+    manager.exchangeAsync();
+    manager.waitCompletion();
+    auto stats = manager.getStats();
+    EXPECT_EQ(stats.messages_sent, 1u);
+    EXPECT_EQ(velocity.values, before);
+
+    manager.swapBuffers();
+    manager.exchangeAsync(1u << 1);
+    manager.waitCompletion();
+    const auto second = manager.getStats();
+    EXPECT_EQ(second.messages_sent, 2u);
+    EXPECT_LT(second.bytes_exchanged - stats.bytes_exchanged, stats.bytes_exchanged);
+
+    HaloFieldBinding unbound;
+    EXPECT_THROW(manager.addHaloField(unbound), std::invalid_argument);
+    backend.shutdown();
+}
@@ -241,3 +241,64 @@ TEST_F(HashMapTest, HashTableMetadata) {
     EXPECT_GT(metadata.bytes_allocated, 0);
     EXPECT_GE(metadata.build_time_ms, 0);
 }
+
+// Test incremental update after migration: delete sent, insert received, relocate moved
+TEST_F(HashMapTest, HashTableManagerApplyDelta) {
+    HashTableManager manager(backend);
+    
+    const size_t num_cells = 1000;
+    std::vector<uint64_t> hilbert_indices(num_cells);
+    std::vector<uint32_t> array_indices(num_cells);
+    for (size_t i = 0; i < num_cells; ++i) {
+        hilbert_indices[i] = i * 8;
+        array_indices[i] = static_cast<uint32_t>(i);
+    }
+    manager.rebuild(hilbert_indices, array_indices);
+    
+    // Send the last 100 cells, receive 50 new ones, relocate 10 survivors
+    std::vector<uint64_t> removed(hilbert_indices.end() - 100, hilbert_indices.end());
+    std::vector<uint64_t> upsert_keys;
+    std::vector<uint32_t> upsert_values;
+    for (size_t i = 0; i < 50; ++i) {
+        upsert_keys.push_back(num_cells * 8 + i * 8 + 1);
+        upsert_values.push_back(static_cast<uint32_t>(900 + i));
+    }
+    for (size_t i = 0; i < 10; ++i) {
+        upsert_keys.push_back(hilbert_indices[i]);
+        upsert_values.push_back(static_cast<uint32_t>(950 + i));
+    }
+    
+    manager.applyDelta(removed, upsert_keys, upsert_values);
+    
+    const auto& metadata = manager.getMetadata();
+    EXPECT_EQ(metadata.num_cells, num_cells - 100 + 50);
+    EXPECT_LE(metadata.num_tombstones, 100u);  // New keys may reuse tombstones
+    EXPECT_LE(metadata.last_delta_slots, removed.size() + upsert_keys.size());
+    
+    auto removed_results = manager.query(removed);
+    for (uint32_t r : removed_results) EXPECT_EQ(r, HASH_INVALID_VALUE);
+    
+    auto upsert_results = manager.query(upsert_keys);
+    for (size_t i = 0; i < upsert_keys.size(); ++i) EXPECT_EQ(upsert_results[i], upsert_values[i]);
+    
+    auto untouched = manager.query({hilbert_indices[500]});
+    EXPECT_EQ(untouched[0], 500u);
+    
+    // Device table must match the host mirror (Mock "device" memory is host memory)
+    const auto* device_keys = static_cast<const uint64_t*>(manager.getKeysDevicePtr());
+    size_t live = 0;
+    for (uint64_t slot = 0; slot < manager.getCapacity(); ++slot) {
+        if (device_keys[slot] != HASH_EMPTY_KEY && device_keys[slot] != HASH_TOMBSTONE_KEY) ++live;
+    }
+    EXPECT_EQ(live, num_cells - 100 + 50);
+}
+
+// Test incremental update on an unbuilt table falls back to a full build
+TEST_F(HashMapTest, HashTableManagerApplyDeltaWithoutTable) {
+    HashTableManager manager(backend);
+    
+    manager.applyDelta({}, {10, 20, 30}, {0, 1, 2});
+    
+    EXPECT_EQ(manager.getMetadata().num_cells, 3u);
+    EXPECT_EQ(manager.query({20})[0], 1u);
+}
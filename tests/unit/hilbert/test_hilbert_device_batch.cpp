@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include "fluidloom/core/backend/MockBackend.h"
+#include "fluidloom/core/backend/OpenCLBackend.h"
+#include "fluidloom/core/hilbert/HilbertCodec.h"
+#include <random>
+#include <vector>
+
+using namespace fluidloom;
+
+namespace {
+
+struct CellBatch {
+    std::vector<cl_int3> coords;
+    std::vector<int32_t> x, y, z;
+    std::vector<uint8_t> levels;
+};
+
+// Random cells at levels 0..MAX plus the corners of the coordinate range,
+// including negative and out-of-range values that both codecs truncate
+CellBatch makeBatch(size_t num_random) {
+    CellBatch batch;
+    std::mt19937 gen(1234);
+    std::uniform_int_distribution<int> level_dist(0, hilbert::MAX_REFINEMENT_LEVEL);
+
+    auto add = [&](int32_t x, int32_t y, int32_t z, uint8_t level) {
+        cl_int3 c;
+        c.s[0] = x; c.s[1] = y; c.s[2] = z; c.s[3] = 0;
+        batch.coords.push_back(c);
+        batch.x.push_back(x);
+        batch.y.push_back(y);
+        batch.z.push_back(z);
+        batch.levels.push_back(level);
+    };
+
+    for (uint8_t level = 0; level <= hilbert::MAX_REFINEMENT_LEVEL; ++level) {
+        const int32_t max_coord = (1 << level) - 1;
+        add(0, 0, 0, level);
+        add(max_coord, max_coord, max_coord, level);
+        add(max_coord, 0, max_coord, level);
+        add(-1, -1, -1, level);
+        add(1 << 21, 7, (1 << 21) + 3, level);
+    }
+    for (size_t i = 0; i < num_random; ++i) {
+        const uint8_t level = static_cast<uint8_t>(level_dist(gen));
+        std::uniform_int_distribution<int32_t> coord_dist(0, (1 << level) - 1);
+        add(coord_dist(gen), coord_dist(gen), coord_dist(gen), level);
+    }
+    return batch;
+}
+
+std::vector<hilbert::HilbertIndex> hostKeys(const CellBatch& batch, const uint8_t* levels, uint8_t level) {
+    std::vector<hilbert::HilbertIndex> keys(batch.x.size());
+    hilbert::encodeBatch(batch.x.data(), batch.y.data(), batch.z.data(), levels, keys.data(), keys.size(), level);
+    return keys;
+}
+
+} // namespace
+
+class HilbertDeviceBatchTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        backend = std::make_unique<OpenCLBackend>();
+        try {
+            backend->initialize(0);
+        } catch (const std::exception& e) {
+            backend.reset();
+            GTEST_SKIP() << "No OpenCL device: " << e.what();
+        }
+    }
+
+    void TearDown() override {
+        if (backend) backend->shutdown();
+    }
+
+    std::unique_ptr<OpenCLBackend> backend;
+};
+
+TEST_F(HilbertDeviceBatchTest, PerCellLevelsMatchHost) {
+    CellBatch batch = makeBatch(100000);
+    const size_t n = batch.coords.size();
+
+    auto coords_buf = backend->allocateBuffer(n * sizeof(cl_int3), batch.coords.data());
+    auto levels_buf = backend->allocateBuffer(n, batch.levels.data());
+    auto keys_buf = backend->allocateBuffer(n * sizeof(hilbert::HilbertIndex));
+
+    hilbert::encodeBatchDevice(*backend, *coords_buf, levels_buf.get(), *keys_buf, n);
+
+    std::vector<hilbert::HilbertIndex> device_keys(n);
+    backend->copyDeviceToHost(*keys_buf, device_keys.data(), n * sizeof(hilbert::HilbertIndex));
+
+    const auto expected = hostKeys(batch, batch.levels.data(), 0);
+    for (size_t i = 0; i < n; ++i) {
+        ASSERT_EQ(device_keys[i], expected[i])
+            << "Cell " << i << " (" << batch.x[i] << "," << batch.y[i] << "," << batch.z[i]
+            << ") level " << int(batch.levels[i]);
+    }
+}
+
+TEST_F(HilbertDeviceBatchTest, UniformLevelMatchesHost) {
+    CellBatch batch = makeBatch(4096);
+    const size_t n = batch.coords.size();
+
+    auto coords_buf = backend->allocateBuffer(n * sizeof(cl_int3), batch.coords.data());
+    auto keys_buf = backend->allocateBuffer(n * sizeof(hilbert::HilbertIndex));
+
+    hilbert::DeviceEncoder encoder(*backend);
+    for (uint8_t level = 0; level <= hilbert::MAX_REFINEMENT_LEVEL; ++level) {
+        encoder.encode(*coords_buf, nullptr, *keys_buf, n, level);
+
+        std::vector<hilbert::HilbertIndex> device_keys(n);
+        backend->copyDeviceToHost(*keys_buf, device_keys.data(), n * sizeof(hilbert::HilbertIndex));
+        EXPECT_EQ(device_keys, hostKeys(batch, nullptr, level)) << "Level " << int(level);
+    }
+}
+
+TEST_F(HilbertDeviceBatchTest, SoAMatchesHost) {
+    CellBatch batch = makeBatch(10000);
+    const size_t n = batch.x.size();
+
+    auto x_buf = backend->allocateBuffer(n * sizeof(int32_t), batch.x.data());
+    auto y_buf = backend->allocateBuffer(n * sizeof(int32_t), batch.y.data());
+    auto z_buf = backend->allocateBuffer(n * sizeof(int32_t), batch.z.data());
+    auto levels_buf = backend->allocateBuffer(n, batch.levels.data());
+    auto keys_buf = backend->allocateBuffer(n * sizeof(hilbert::HilbertIndex));
+
+    hilbert::DeviceEncoder encoder(*backend);
+    encoder.encodeSoA(x_buf->getDevicePointer(), y_buf->getDevicePointer(), z_buf->getDevicePointer(),
+                      levels_buf->getDevicePointer(), keys_buf->getDevicePointer(), n);
+
+    std::vector<hilbert::HilbertIndex> device_keys(n);
+    backend->copyDeviceToHost(*keys_buf, device_keys.data(), n * sizeof(hilbert::HilbertIndex));
+    EXPECT_EQ(device_keys, hostKeys(batch, batch.levels.data(), 0));
+}
+
+TEST(HilbertDeviceBatchMockTest, FallsBackToHost) {
+    MockBackend backend;
+    backend.initialize();
+
+    CellBatch batch = makeBatch(1000);
+    const size_t n = batch.coords.size();
+
+    auto coords_buf = backend.allocateBuffer(n * sizeof(cl_int3), batch.coords.data());
+    auto levels_buf = backend.allocateBuffer(n, batch.levels.data());
+    auto keys_buf = backend.allocateBuffer(n * sizeof(hilbert::HilbertIndex));
+
+    hilbert::encodeBatchDevice(backend, *coords_buf, levels_buf.get(), *keys_buf, n);
+
+    std::vector<hilbert::HilbertIndex> keys(n);
+    backend.copyDeviceToHost(*keys_buf, keys.data(), n * sizeof(hilbert::HilbertIndex));
+    EXPECT_EQ(keys, hostKeys(batch, batch.levels.data(), 0));
+}
+
+TEST(HilbertDeviceBatchMockTest, RejectsUndersizedBuffers) {
+    MockBackend backend;
+    backend.initialize();
+
+    auto coords_buf = backend.allocateBuffer(16 * sizeof(cl_int3));
+    auto keys_buf = backend.allocateBuffer(8 * sizeof(hilbert::HilbertIndex));
+
+    EXPECT_THROW(hilbert::encodeBatchDevice(backend, *coords_buf, nullptr, *keys_buf, 16),
+                 std::invalid_argument);
+    EXPECT_THROW(hilbert::encodeBatchDevice(backend, *coords_buf, nullptr, *keys_buf, 8,
+                                            hilbert::MAX_REFINEMENT_LEVEL + 1),
+                 std::invalid_argument);
+}
@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include "fluidloom/core/backend/OpenCLBackend.h"
+#include "fluidloom/load_balance/CellCompactor.h"
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+using namespace fluidloom;
+using namespace fluidloom::load_balance;
+
+namespace {
+
+// Host model of the moves, used to check both the plan and the device result
+template <typename T>
+std::vector<T> applyOnHost(std::vector<T> values, const CompactionMoves& moves, size_t elems_per_cell) {
+    for (size_t i = 0; i < moves.src.size(); ++i) {
+        for (size_t k = 0; k < elems_per_cell; ++k) {
+            values[moves.dst[i] * elems_per_cell + k] = values[moves.src[i] * elems_per_cell + k];
+        }
+    }
+    values.resize(moves.new_count * elems_per_cell);
+    return values;
+}
+
+// A rank sending [8, 12) to a neighbor: the hole sits mid-array, not at the tail
+const std::vector<uint32_t> MIDDLE_RANGE = {8, 9, 10, 11};
+constexpr size_t NUM_CELLS = 20;
+
+} // namespace
+
+TEST(CellCompactorTest, PlanFillsMiddleHolesFromTheTail) {
+    CompactionMoves moves = CellCompactor::plan(MIDDLE_RANGE, NUM_CELLS);
+    EXPECT_EQ(moves.new_count, 16u);
+    EXPECT_EQ(moves.src, (std::vector<uint32_t>{19, 18, 17, 16}));
+    EXPECT_EQ(moves.dst, (std::vector<uint32_t>{8, 9, 10, 11}));
+
+    // Holes in the tail itself are skipped as sources; duplicates count once
+    moves = CellCompactor::plan({2, 9, 9, 8}, 10);
+    EXPECT_EQ(moves.new_count, 7u);
+    EXPECT_EQ(moves.src, (std::vector<uint32_t>{7}));
+    EXPECT_EQ(moves.dst, (std::vector<uint32_t>{2}));
+
+    // Every survivor is kept exactly once
+    std::vector<uint32_t> ids(NUM_CELLS);
+    std::iota(ids.begin(), ids.end(), 0u);
+    auto kept = applyOnHost(ids, CellCompactor::plan(MIDDLE_RANGE, NUM_CELLS), 1);
+    std::sort(kept.begin(), kept.end());
+    std::vector<uint32_t> expected;
+    for (uint32_t i = 0; i < NUM_CELLS; ++i) {
+        if (i < 8 || i >= 12) expected.push_back(i);
+    }
+    EXPECT_EQ(kept, expected);
+
+    EXPECT_TRUE(CellCompactor::plan({}, NUM_CELLS).empty());
+    EXPECT_THROW(CellCompactor::plan({NUM_CELLS}, NUM_CELLS), std::out_of_range);
+}
+
+TEST(CellCompactorDeviceTest, MovesEveryArrayAfterMiddleMigration) {
+    OpenCLBackend backend;
+    try {
+        backend.initialize(0);
+    } catch (const std::exception& e) {
+        GTEST_SKIP() << "No OpenCL device: " << e.what();
+    }
+    cl_context context = backend.getContext();
+    cl_command_queue queue = backend.getQueue();
+    CellCompactor compactor(context, queue);
+
+    // Coordinates (4-byte elements), levels (1 byte) and a 3-component field (12 bytes)
+    constexpr size_t COMPONENTS = 3;
+    std::vector<int32_t> coord(NUM_CELLS);
+    std::vector<uint8_t> level(NUM_CELLS);
+    std::vector<float> field(NUM_CELLS * COMPONENTS);
+    for (size_t i = 0; i < NUM_CELLS; ++i) {
+        coord[i] = static_cast<int32_t>(100 + i);
+        level[i] = static_cast<uint8_t>(i % 7);
+        for (size_t c = 0; c < COMPONENTS; ++c) field[i * COMPONENTS + c] = i + 0.25f * c;
+    }
+
+    cl_int err;
+    cl_mem d_coord = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+                                    coord.size() * sizeof(int32_t), coord.data(), &err);
+    ASSERT_EQ(err, CL_SUCCESS);
+    cl_mem d_level = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+                                    level.size(), level.data(), &err);
+    ASSERT_EQ(err, CL_SUCCESS);
+    cl_mem d_field = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+                                    field.size() * sizeof(float), field.data(), &err);
+    ASSERT_EQ(err, CL_SUCCESS);
+
+    CompactionMoves moves = CellCompactor::plan(MIDDLE_RANGE, NUM_CELLS);
+    compactor.apply(moves, {{d_coord, sizeof(int32_t)}, {d_level, sizeof(uint8_t)},
+                            {d_field, COMPONENTS * sizeof(float)}});
+
+    std::vector<int32_t> coord_out(moves.new_count);
+    std::vector<uint8_t> level_out(moves.new_count);
+    std::vector<float> field_out(moves.new_count * COMPONENTS);
+    clEnqueueReadBuffer(queue, d_coord, CL_FALSE, 0, coord_out.size() * sizeof(int32_t), coord_out.data(),
+                        0, nullptr, nullptr);
+    clEnqueueReadBuffer(queue, d_level, CL_FALSE, 0, level_out.size(), level_out.data(), 0, nullptr, nullptr);
+    clEnqueueReadBuffer(queue, d_field, CL_TRUE, 0, field_out.size() * sizeof(float), field_out.data(),
+                        0, nullptr, nullptr);
+
+    EXPECT_EQ(coord_out, applyOnHost(coord, moves, 1));
+    EXPECT_EQ(level_out, applyOnHost(level, moves, 1));
+    EXPECT_EQ(field_out, applyOnHost(field, moves, COMPONENTS));
+
+    clReleaseMemObject(d_coord);
+    clReleaseMemObject(d_level);
+    clReleaseMemObject(d_field);
+}
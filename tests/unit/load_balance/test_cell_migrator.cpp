@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include "fluidloom/core/backend/OpenCLBackend.h"
+#include "fluidloom/core/hashmap/HashTableManager.h"
+#include "fluidloom/core/hilbert/HilbertCodec.h"
+#include "fluidloom/load_balance/CellMigrator.h"
+#include <algorithm>
+#include <vector>
+
+using namespace fluidloom;
+using namespace fluidloom::load_balance;
+
+namespace {
+
+constexpr size_t NUM_CELLS = 24;
+constexpr uint32_t COMPONENTS = 2;
+
+cl_mem upload(cl_context context, const void* data, size_t bytes) {
+    cl_int err;
+    cl_mem buffer = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, bytes,
+                                   const_cast<void*>(data), &err);
+    EXPECT_EQ(err, CL_SUCCESS);
+    return buffer;
+}
+
+template <typename T>
+std::vector<T> download(cl_command_queue queue, cl_mem buffer, size_t count) {
+    std::vector<T> host(count);
+    clEnqueueReadBuffer(queue, buffer, CL_TRUE, 0, count * sizeof(T), host.data(), 0, nullptr, nullptr);
+    return host;
+}
+
+} // namespace
+
+TEST(CellMigratorTest, RejectsMissingBackend) {
+    transport::MPITransport transport(nullptr);
+    EXPECT_THROW(CellMigrator(&transport, nullptr), std::invalid_argument);
+    EXPECT_THROW(CellMigrator(nullptr, nullptr), std::invalid_argument);
+}
+
+TEST(CellMigratorTest, BytesPerCellCoversEveryPlane) {
+    // x, y, z, level, state and the field components
+    EXPECT_EQ(CellMigrator::bytesPerCell(0), 14u);
+    EXPECT_EQ(CellMigrator::bytesPerCell(COMPONENTS), 14u + COMPONENTS * sizeof(float));
+}
+
+// Single process: the transport runs without peers, so the cells sent to
+// rank 1 leave the mesh and nothing comes back
+TEST(CellMigratorDeviceTest, SendingPatchesArraysKeysAndHash) {
+    OpenCLBackend backend;
+    try {
+        backend.initialize(0);
+    } catch (const std::exception& e) {
+        GTEST_SKIP() << "No OpenCL device: " << e.what();
+    }
+    cl_context context = backend.getContext();
+    cl_command_queue queue = backend.getQueue();
+
+    std::vector<int32_t> x(NUM_CELLS), y(NUM_CELLS), z(NUM_CELLS);
+    std::vector<uint8_t> level(NUM_CELLS, hilbert::MAX_REFINEMENT_LEVEL);
+    std::vector<uint8_t> state(NUM_CELLS);
+    std::vector<float> field(NUM_CELLS * COMPONENTS);
+    std::vector<uint64_t> keys(NUM_CELLS);
+    std::vector<uint32_t> slots(NUM_CELLS);
+    for (size_t i = 0; i < NUM_CELLS; ++i) {
+        x[i] = static_cast<int32_t>(i % 4);
+        y[i] = static_cast<int32_t>((i / 4) % 3);
+        z[i] = static_cast<int32_t>(i / 12);
+        state[i] = static_cast<uint8_t>(i % 3);
+        for (uint32_t c = 0; c < COMPONENTS; ++c) field[i * COMPONENTS + c] = i + 0.5f * c;
+        keys[i] = hilbert::encode(x[i], y[i], z[i], level[i]);
+        slots[i] = static_cast<uint32_t>(i);
+    }
+
+    // Send the upper third of the key range, wherever those cells sit in the SOA
+    std::vector<uint64_t> sorted = keys;
+    std::sort(sorted.begin(), sorted.end());
+    const uint64_t split = sorted[2 * NUM_CELLS / 3];
+
+    MigrationPlan plan;
+    plan.transfers.emplace_back(0, 1, split, sorted.back() + 1, NUM_CELLS / 3);
+    plan.total_cells_to_migrate = NUM_CELLS / 3;
+
+    cl_mem d_x = upload(context, x.data(), NUM_CELLS * sizeof(int32_t));
+    cl_mem d_y = upload(context, y.data(), NUM_CELLS * sizeof(int32_t));
+    cl_mem d_z = upload(context, z.data(), NUM_CELLS * sizeof(int32_t));
+    cl_mem d_level = upload(context, level.data(), NUM_CELLS);
+    cl_mem d_state = upload(context, state.data(), NUM_CELLS);
+    cl_mem d_field = upload(context, field.data(), field.size() * sizeof(float));
+
+    hashmap::HashTableManager hash(&backend);
+    hash.rebuild(keys, slots);
+
+    transport::MPITransport transport(&backend);
+    CellMigrator migrator(&transport, &backend);
+    std::vector<uint64_t> mirror = keys;
+    migrator.setCellKeys(&mirror);
+
+    size_t num_cells = NUM_CELLS;
+    size_t capacity = NUM_CELLS;
+    migrator.migrate(plan, &d_x, &d_y, &d_z, &d_level, &d_state, &d_field, COMPONENTS, &num_cells, &capacity);
+
+    ASSERT_EQ(num_cells, NUM_CELLS - NUM_CELLS / 3);
+    ASSERT_EQ(mirror.size(), num_cells);
+
+    // Every surviving slot holds the cell its mirrored key names, fields included
+    auto x_out = download<int32_t>(queue, d_x, num_cells);
+    auto y_out = download<int32_t>(queue, d_y, num_cells);
+    auto z_out = download<int32_t>(queue, d_z, num_cells);
+    auto level_out = download<uint8_t>(queue, d_level, num_cells);
+    auto state_out = download<uint8_t>(queue, d_state, num_cells);
+    auto field_out = download<float>(queue, d_field, num_cells * COMPONENTS);
+    for (size_t i = 0; i < num_cells; ++i) {
+        EXPECT_LT(mirror[i], split);
+        EXPECT_EQ(hilbert::encode(x_out[i], y_out[i], z_out[i], level_out[i]), mirror[i]);
+
+        size_t original = std::find(keys.begin(), keys.end(), mirror[i]) - keys.begin();
+        ASSERT_LT(original, NUM_CELLS);
+        EXPECT_EQ(state_out[i], state[original]);
+        EXPECT_EQ(field_out[i * COMPONENTS + 1], field[original * COMPONENTS + 1]);
+    }
+
+    // The hash patched from the delta forgets sent cells and follows moved ones
+    const MigrationDelta& delta = migrator.getLastDelta();
+    EXPECT_EQ(delta.removed_keys.size(), NUM_CELLS / 3);
+    hash.applyDelta(delta.removed_keys, delta.upsert_keys, delta.upsert_indices);
+
+    for (uint32_t found : hash.query(delta.removed_keys)) {
+        EXPECT_EQ(found, hashmap::HASH_INVALID_VALUE);
+    }
+    auto found = hash.query(mirror);
+    for (size_t i = 0; i < num_cells; ++i) {
+        EXPECT_EQ(found[i], i) << "key " << mirror[i];
+    }
+    EXPECT_EQ(hash.getMetadata().num_cells, num_cells);
+
+    for (cl_mem buffer : {d_x, d_y, d_z, d_level, d_state, d_field}) {
+        clReleaseMemObject(buffer);
+    }
+}
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include "fluidloom/core/backend/OpenCLBackend.h"
+#include "fluidloom/load_balance/LoadBalancer.h"
+#include "fluidloom/runtime/ExecutionGraph.h"
+#include "fluidloom/runtime/nodes/HostTaskNode.h"
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace fluidloom;
+using namespace fluidloom::load_balance;
+
+namespace {
+
+// 30% cell-count imbalance over four GPUs: the count trigger fires
+const std::vector<size_t> IMBALANCED = {130000, 100000, 100000, 100000};
+
+// Node that sleeps, standing in for device work or a wait on peers
+class SleepNode : public runtime::nodes::ExecutionNode {
+public:
+    SleepNode(NodeType type, std::string name, int ms)
+        : ExecutionNode(type, std::move(name)), ms(ms) {}
+
+    cl_event execute(cl_event wait_event) override {
+        (void)wait_event;
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+        return nullptr;
+    }
+
+    void accept(Visitor& visitor) override { (void)visitor; }
+
+private:
+    int ms;
+};
+
+// Node returning an event the caller owns
+class EventNode : public runtime::nodes::ExecutionNode {
+public:
+    EventNode(std::string name, cl_event event)
+        : ExecutionNode(NodeType::KERNEL, std::move(name)), event(event) {}
+
+    cl_event execute(cl_event wait_event) override {
+        (void)wait_event;
+        return event;
+    }
+
+    void accept(Visitor& visitor) override { (void)visitor; }
+
+private:
+    cl_event event;
+};
+
+MigrationPlan planTaking(float ms) {
+    MigrationPlan plan;
+    plan.transfers.emplace_back(0, 1, 0, 100, 1000);
+    plan.total_cells_to_migrate = 1000;
+    plan.estimated_time_ms = ms;
+    return plan;
+}
+
+} // namespace
+
+TEST(LoadBalancerTest, StepObserverReportsBusyTimeOnly) {
+    runtime::ExecutionGraph graph;
+    graph.addNode(std::make_shared<SleepNode>(runtime::nodes::ExecutionNode::NodeType::KERNEL, "collide", 5));
+    graph.addNode(std::make_shared<SleepNode>(runtime::nodes::ExecutionNode::NodeType::HALO_EXCHANGE, "halo", 30));
+
+    std::vector<float> steps;
+    graph.setStepObserver([&steps](float busy_ms) { steps.push_back(busy_ms); });
+    graph.execute();
+
+    ASSERT_EQ(steps.size(), 1u);
+    EXPECT_GE(steps[0], 4.0f);
+    EXPECT_LT(steps[0], 30.0f);
+}
+
+TEST(LoadBalancerTest, CostBenefitUsesMeasuredSteps) {
+    transport::MPITransport transport(nullptr);
+    LoadBalanceConfig config;
+    LoadBalancer balancer(&transport, config);
+    const MigrationPlan plan = planTaking(50.0f);
+
+    // No step time yet: the count trigger's decision stands
+    EXPECT_TRUE(balancer.rebalancePaysOff(IMBALANCED, plan));
+
+    // Steps timed by the executor, with churn reported as by AdaptMeshNode
+    runtime::ExecutionGraph graph;
+    graph.addNode(std::make_shared<runtime::nodes::HostTaskNode>("step", [] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }));
+    graph.setStepObserver([&balancer](float busy_ms) { balancer.recordStepTime(busy_ms); });
+    for (int step = 0; step < 5; ++step) {
+        graph.execute();
+        balancer.recordAdaptation(100);
+        balancer.incrementTimestep();
+    }
+
+    // Alone, this GPU's busy time is the mean: nothing to gain from migrating
+    EXPECT_FALSE(balancer.rebalancePaysOff(IMBALANCED, plan));
+
+    config.cost_benefit = false;
+    LoadBalancer count_only(&transport, config);
+    count_only.recordStepTime(1.0f);
+    EXPECT_TRUE(count_only.rebalancePaysOff(IMBALANCED, plan));
+}
+
+TEST(LoadBalancerTest, StepObserverWaitsOnEveryReturnedEvent) {
+    OpenCLBackend backend;
+    try {
+        backend.initialize(0);
+    } catch (const std::exception& e) {
+        GTEST_SKIP() << "No OpenCL device: " << e.what();
+    }
+
+    // The slow event is not the last one returned
+    cl_int err;
+    cl_event slow = clCreateUserEvent(backend.getContext(), &err);
+    ASSERT_EQ(err, CL_SUCCESS);
+    cl_event fast = clCreateUserEvent(backend.getContext(), &err);
+    ASSERT_EQ(err, CL_SUCCESS);
+    clSetUserEventStatus(fast, CL_COMPLETE);
+    clRetainEvent(slow);
+
+    runtime::ExecutionGraph graph;
+    graph.addNode(std::make_shared<EventNode>("slow", slow));
+    graph.addNode(std::make_shared<EventNode>("fast", fast));
+    std::vector<float> steps;
+    graph.setStepObserver([&steps](float busy_ms) { steps.push_back(busy_ms); });
+
+    std::thread completer([slow] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        clSetUserEventStatus(slow, CL_COMPLETE);
+    });
+    graph.execute();
+    completer.join();
+
+    ASSERT_EQ(steps.size(), 1u);
+    EXPECT_GE(steps[0], 19.0f);
+
+    // execute() released its reference; ours is the only one left
+    cl_uint references = 0;
+    clGetEventInfo(slow, CL_EVENT_REFERENCE_COUNT, sizeof(references), &references, nullptr);
+    EXPECT_EQ(references, 1u);
+    clReleaseEvent(slow);
+}
+
+TEST(LoadBalancerTest, SeededLinkSizesMigrationEstimate) {
+    transport::MPITransport transport(nullptr);
+    LoadBalancer balancer(&transport, LoadBalanceConfig());
+    balancer.setBytesPerCell(200);
+
+    // Single GPU: half of [0, 1000) lies above the new split and leaves
+    auto plan = balancer.createMigrationPlan({500}, {}, 0, 1000, 1000);
+    ASSERT_EQ(plan.total_cells_to_migrate, 500u);
+    EXPECT_EQ(plan.cellsSentBy(0), 500u);
+    EXPECT_EQ(plan.cellsSentBy(1), 0u);
+    EXPECT_FLOAT_EQ(plan.estimated_time_ms, 0.5f);     // 1 us per cell while unmeasured
+
+    // 1 GB/s and 50 us per transfer: 100 kB in 0.1 ms
+    transport::PeerAccessManager::LinkProfile link;
+    link.latency_us = 50.0;
+    link.bandwidth_gbps = 1.0;
+    balancer.seedLinkBandwidth(link);
+    plan = balancer.createMigrationPlan({500}, {}, 0, 1000, 1000);
+    EXPECT_NEAR(plan.estimated_time_ms, 0.15f, 1e-5f);
+
+    // A measured migration replaces the seed, which is then ignored
+    balancer.recordMigration(100000, 0.5f);
+    balancer.seedLinkBandwidth(link);
+    plan = balancer.createMigrationPlan({500}, {}, 0, 1000, 1000);
+    EXPECT_NEAR(plan.estimated_time_ms, 0.5f, 1e-5f);
+}
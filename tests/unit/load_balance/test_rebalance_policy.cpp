@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+#include "fluidloom/load_balance/LoadBalanceConfig.h"
+#include <vector>
+
+using namespace fluidloom::load_balance;
+
+namespace {
+
+// 30% cell-count imbalance over four GPUs: the count trigger fires
+const std::vector<size_t> IMBALANCED = {130000, 100000, 100000, 100000};
+
+} // namespace
+
+TEST(RebalancePolicyTest, HorizonFollowsAdaptationRate) {
+    LoadBalanceConfig config;
+    EXPECT_EQ(config.payoffHorizon(0.0f), config.max_payoff_horizon);
+    EXPECT_EQ(config.payoffHorizon(1.0e-6f), config.max_payoff_horizon);
+    EXPECT_EQ(config.payoffHorizon(0.001f), 150u);  // 0.15 / 0.001
+    EXPECT_EQ(config.payoffHorizon(0.5f), config.min_interval_timesteps);
+}
+
+TEST(RebalancePolicyTest, PersistentImbalancePaysOff) {
+    LoadBalanceConfig config;
+    RebalanceCost cost;
+    cost.step_time_imbalance_ms = 2.0f;
+    cost.migration_time_ms = 50.0f;
+    cost.adaptation_rate = 0.0f;  // Static mesh: 1000 steps * 2 ms >> 50 ms
+    EXPECT_TRUE(config.shouldRebalance(IMBALANCED, 20, cost));
+}
+
+TEST(RebalancePolicyTest, TransientSheddingIsLeftAlone) {
+    LoadBalanceConfig config;
+    RebalanceCost cost;
+    cost.step_time_imbalance_ms = 2.0f;
+    cost.migration_time_ms = 50.0f;
+    cost.adaptation_rate = 0.05f;  // Horizon 10 steps: 20 ms saved < 50 ms moved
+    EXPECT_FALSE(config.shouldRebalance(IMBALANCED, 20, cost));
+
+    // The count trigger alone would have fired
+    EXPECT_TRUE(config.shouldRebalance(IMBALANCED, 20));
+
+    config.cost_benefit = false;
+    EXPECT_TRUE(config.shouldRebalance(IMBALANCED, 20, cost));
+}
+
+TEST(RebalancePolicyTest, CountTriggerStillGates) {
+    LoadBalanceConfig config;
+    RebalanceCost cheap;
+    cheap.step_time_imbalance_ms = 10.0f;
+    cheap.migration_time_ms = 1.0f;
+    EXPECT_FALSE(config.shouldRebalance({100000, 100000, 100000, 105000}, 20, cheap));
+    EXPECT_FALSE(config.shouldRebalance(IMBALANCED, 5, cheap));
+
+    config.min_payoff_ratio = 0.0f;
+    EXPECT_THROW(config.validate(), std::invalid_argument);
+}
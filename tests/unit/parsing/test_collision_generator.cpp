@@ -0,0 +1,273 @@
+#include <gtest/gtest.h>
+#include "fluidloom/parsing/codegen/CollisionGenerator.h"
+#include "fluidloom/parsing/codegen/OpenCLGenerator.h"
+#include "fluidloom/parsing/semantic/SemanticAnalyzer.h"
+#include "fluidloom/parsing/registry/LatticeRegistry.h"
+#include "fluidloom/parsing/visitors/KernelVisitor.h"
+#include <cmath>
+#include <random>
+
+using namespace fluidloom::parsing;
+using namespace fluidloom::parsing::codegen;
+
+namespace {
+
+const CollisionModel ALL_MODELS[] = {CollisionModel::BGK, CollisionModel::MRT_RAW,
+                                     CollisionModel::MRT_CENTRAL, CollisionModel::CUMULANT};
+
+// D2Q9, D3Q15, D3Q19 or D3Q27 with the standard weights
+LatticeDescriptor makeLattice(int dim, int q) {
+    LatticeDescriptor lattice;
+    lattice.name = "D" + std::to_string(dim) + "Q" + std::to_string(q);
+    lattice.cs2 = 1.0 / 3.0;
+    lattice.stencil_dimensions = static_cast<int8_t>(dim);
+    const int z_extent = dim == 3 ? 1 : 0;
+    for (int z = -z_extent; z <= z_extent; ++z) {
+        for (int y = -1; y <= 1; ++y) {
+            for (int x = -1; x <= 1; ++x) {
+                const int n = (x != 0) + (y != 0) + (z != 0);
+                double w = 0.0;
+                if (dim == 2) {
+                    w = n == 0 ? 4.0 / 9.0 : n == 1 ? 1.0 / 9.0 : 1.0 / 36.0;
+                } else if (q == 27) {
+                    w = n == 0 ? 8.0 / 27.0 : n == 1 ? 2.0 / 27.0 : n == 2 ? 1.0 / 54.0 : 1.0 / 216.0;
+                } else if (q == 19) {
+                    if (n == 3) continue;
+                    w = n == 0 ? 1.0 / 3.0 : n == 1 ? 1.0 / 18.0 : 1.0 / 36.0;
+                } else {
+                    if (n == 2) continue;
+                    w = n == 0 ? 2.0 / 9.0 : n == 1 ? 1.0 / 9.0 : 1.0 / 72.0;
+                }
+                lattice.stencil_vectors.push_back({static_cast<int8_t>(x), static_cast<int8_t>(y),
+                                                   static_cast<int8_t>(z)});
+                lattice.weights.push_back(w);
+            }
+        }
+    }
+    lattice.num_populations = lattice.stencil_vectors.size();
+    return lattice;
+}
+
+// Perturbed equilibrium around u
+std::vector<float> perturbed(const LatticeDescriptor& lattice, std::mt19937& rng) {
+    std::uniform_real_distribution<float> noise(-0.02f, 0.02f);
+    const float u[3] = {0.06f, -0.04f, 0.03f};
+    std::vector<float> f(lattice.num_populations);
+    for (size_t i = 0; i < f.size(); ++i) {
+        float cu = 0.0f;
+        for (int d = 0; d < 3; ++d) cu += lattice.stencil_vectors[i][d] * u[d];
+        f[i] = static_cast<float>(lattice.weights[i]) * (1.0f + 3.0f * cu) * (1.0f + noise(rng));
+    }
+    return f;
+}
+
+std::array<double, 4> conserved(const LatticeDescriptor& lattice, const std::vector<float>& f) {
+    std::array<double, 4> sums{};
+    for (size_t i = 0; i < f.size(); ++i) {
+        sums[0] += f[i];
+        for (int d = 0; d < 3; ++d) sums[d + 1] += f[i] * lattice.stencil_vectors[i][d];
+    }
+    return sums;
+}
+
+} // namespace
+
+TEST(CollisionGeneratorTest, MomentBasisInvertsOnStandardLattices) {
+    const int lattices[4][2] = {{2, 9}, {3, 15}, {3, 19}, {3, 27}};
+    for (const auto& spec : lattices) {
+        CollisionGenerator generator(makeLattice(spec[0], spec[1]));
+        const MomentBasis& basis = generator.getBasis();
+        const size_t q = static_cast<size_t>(spec[1]);
+        ASSERT_EQ(basis.size(), q) << generator.getLatticeName();
+        EXPECT_TRUE(basis.closed) << generator.getLatticeName();
+        EXPECT_EQ(basis.find(0, 0, 0), 0);
+        EXPECT_EQ(basis.order(q - 1), spec[0] == 3 && q == 27 ? 6 : 4) << generator.getLatticeName();
+
+        for (size_t r = 0; r < q; ++r) {
+            for (size_t c = 0; c < q; ++c) {
+                double product = 0.0;
+                for (size_t k = 0; k < q; ++k) product += basis.matrix[r * q + k] * basis.inverse[k * q + c];
+                EXPECT_NEAR(product, r == c ? 1.0 : 0.0, 1e-12);
+            }
+        }
+        for (CollisionModel model : ALL_MODELS) {
+            EXPECT_TRUE(generator.supports(model));
+        }
+    }
+}
+
+TEST(CollisionGeneratorTest, AllModelsConserveMassAndMomentum) {
+    const LatticeDescriptor lattice = makeLattice(3, 19);
+    CollisionGenerator generator(lattice);
+    std::mt19937 rng(7);
+    RelaxationRates rates{1.8f, 1.2f, 1.4f};
+
+    for (CollisionModel model : ALL_MODELS) {
+        for (int trial = 0; trial < 20; ++trial) {
+            std::vector<float> f = perturbed(lattice, rng);
+            const auto before = conserved(lattice, f);
+            const float rho = generator.collide(model, f.data(), rates);
+            const auto after = conserved(lattice, f);
+            EXPECT_NEAR(rho, before[0], 1e-6) << collisionModelName(model);
+            for (int m = 0; m < 4; ++m) {
+                EXPECT_NEAR(after[m], before[m], 1e-6) << collisionModelName(model) << " moment " << m;
+            }
+        }
+    }
+}
+
+TEST(CollisionGeneratorTest, RawMrtWithUniformRatesIsBgk) {
+    const LatticeDescriptor lattice = makeLattice(3, 27);
+    CollisionGenerator generator(lattice);
+    std::mt19937 rng(11);
+    RelaxationRates rates{1.6f, 1.6f, 1.6f};
+
+    std::vector<float> bgk = perturbed(lattice, rng);
+    std::vector<float> mrt = bgk;
+    generator.collide(CollisionModel::BGK, bgk.data(), rates);
+    generator.collide(CollisionModel::MRT_RAW, mrt.data(), rates);
+    for (size_t i = 0; i < bgk.size(); ++i) {
+        EXPECT_NEAR(mrt[i], bgk[i], 1e-6) << "population " << i;
+    }
+}
+
+TEST(CollisionGeneratorTest, RestEquilibriumIsFixedPoint) {
+    const int lattices[3][2] = {{2, 9}, {3, 19}, {3, 27}};
+    RelaxationRates rates{1.9f, 0.8f, 1.3f};
+    for (const auto& spec : lattices) {
+        const LatticeDescriptor lattice = makeLattice(spec[0], spec[1]);
+        CollisionGenerator generator(lattice);
+        for (CollisionModel model : ALL_MODELS) {
+            std::vector<float> f(lattice.weights.begin(), lattice.weights.end());
+            generator.collide(model, f.data(), rates);
+            for (size_t i = 0; i < f.size(); ++i) {
+                EXPECT_NEAR(f[i], lattice.weights[i], 1e-7) << lattice.name << " " << collisionModelName(model);
+            }
+        }
+    }
+}
+
+TEST(CollisionGeneratorTest, CumulantMatchesCentralMomentsAtFullRelaxation) {
+    // Relaxing every cumulant fully lands on the Maxwellian central moments
+    const LatticeDescriptor lattice = makeLattice(3, 27);
+    CollisionGenerator generator(lattice);
+    std::mt19937 rng(5);
+    RelaxationRates rates{1.0f, 1.0f, 1.0f};
+
+    std::vector<float> central = perturbed(lattice, rng);
+    std::vector<float> cumulant = central;
+    generator.collide(CollisionModel::MRT_CENTRAL, central.data(), rates);
+    generator.collide(CollisionModel::CUMULANT, cumulant.data(), rates);
+    for (size_t i = 0; i < central.size(); ++i) {
+        EXPECT_NEAR(cumulant[i], central[i], 1e-6) << "population " << i;
+    }
+
+    // Below full relaxation the operators differ in the fourth order
+    std::vector<float> a = perturbed(lattice, rng);
+    std::vector<float> b = a;
+    rates.omega = 1.7f;
+    generator.collide(CollisionModel::MRT_CENTRAL, a.data(), rates);
+    generator.collide(CollisionModel::CUMULANT, b.data(), rates);
+    double difference = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) difference += std::fabs(a[i] - b[i]);
+    EXPECT_GT(difference, 1e-6);
+}
+
+TEST(CollisionGeneratorTest, GeneratedSourceIsConstantFolded) {
+    CollisionGenerator generator(makeLattice(3, 19));
+    const std::string source = generator.generate(CollisionModel::CUMULANT);
+
+    EXPECT_NE(source.find("#ifndef FL_COLLIDE_D3Q19_cumulant"), std::string::npos);
+    EXPECT_NE(source.find("float D3Q19_collide_cumulant(float* f, float omega, float omega_bulk, float omega_high)"),
+              std::string::npos);
+    EXPECT_EQ(source.find("0.0f*"), std::string::npos);
+    EXPECT_EQ(source.find("1.0f*"), std::string::npos);
+    EXPECT_EQ(source.find("M["), std::string::npos);  // No matrices at run time
+    EXPECT_EQ(CollisionGenerator::functionName("D3Q19", CollisionModel::MRT_CENTRAL), "D3Q19_collide_mrt_central");
+
+    EXPECT_EQ(parseCollisionModel("mrt_raw"), CollisionModel::MRT_RAW);
+    EXPECT_THROW(parseCollisionModel("entropic"), std::invalid_argument);
+}
+
+TEST(CollisionGeneratorTest, KernelSelectsOperatorInDsl) {
+    auto& registry = LatticeRegistry::getInstance();
+    registry.clear();
+    registry.add(makeLattice(2, 9));
+
+    ast::KernelAST kernel("collide_step");
+    kernel.setCollision("cumulant", "D2Q9");
+    std::vector<std::shared_ptr<ast::Expression>> args = {
+        std::make_shared<ast::VariableExpression>("f"),
+        std::make_shared<ast::VariableExpression>("omega")};
+    kernel.setStatements({std::make_shared<ast::AssignmentStatement>(
+        std::make_shared<ast::VariableExpression>("rho"),
+        std::make_shared<ast::CallExpression>("collide", std::move(args)))});
+
+    semantic::SemanticAnalyzer analyzer;
+    EXPECT_TRUE(analyzer.analyzeKernel(kernel));
+
+    OpenCLGenerator generator;
+    const std::string source = generator.generateKernel(kernel);
+    const size_t function = source.find("float D2Q9_collide_cumulant(");
+    const size_t body = source.find("__kernel void collide_step(");
+    ASSERT_NE(function, std::string::npos);
+    ASSERT_NE(body, std::string::npos);
+    EXPECT_LT(function, body);
+    EXPECT_NE(source.find("rho = D2Q9_collide_cumulant(f, omega, omega, 1.0f)"), std::string::npos);
+
+    kernel.setCollision("mrt", "D2Q9");
+    EXPECT_FALSE(analyzer.analyzeKernel(kernel));
+    kernel.setCollision("bgk", "D3Q7");
+    EXPECT_FALSE(analyzer.analyzeKernel(kernel));
+    EXPECT_THROW(generator.generateKernel(kernel), std::invalid_argument);
+
+    registry.clear();
+}
+
+TEST(CollisionGeneratorTest, KernelFileCollisionClauseReachesGeneratedSource) {
+    auto& registry = LatticeRegistry::getInstance();
+    registry.clear();
+    registry.add(makeLattice(2, 9));
+
+    KernelVisitor visitor;
+    visitor.parseString(R"(
+        kernel collide_step: {
+            reads: f, omega
+            writes: f
+            halo: 1
+            collision: cumulant(D2Q9)
+            script: |
+                rho = collide(f, omega)
+            |
+        }
+    )");
+    ASSERT_EQ(visitor.getKernels().size(), 1u);
+    const ast::KernelAST& kernel = *visitor.getKernels().front();
+    EXPECT_EQ(kernel.getName(), "collide_step");
+    EXPECT_EQ(kernel.getCollisionModel(), "cumulant");
+    EXPECT_EQ(kernel.getCollisionLattice(), "D2Q9");
+    EXPECT_EQ(kernel.getReadFields(), (std::vector<std::string>{"f", "omega"}));
+    EXPECT_EQ(kernel.getHaloDepth(), 1);
+    ASSERT_EQ(kernel.getStatements().size(), 1u);
+    EXPECT_GE(kernel.arena.bytesUsed(), 3 * sizeof(ast::VariableExpression));  // Body nodes live in the arena
+
+    semantic::SemanticAnalyzer analyzer;
+    EXPECT_TRUE(analyzer.analyzeKernel(kernel));
+
+    OpenCLGenerator generator;
+    const std::string source = generator.generateKernel(kernel);
+    const size_t function = source.find("float D2Q9_collide_cumulant(");
+    const size_t body = source.find("__kernel void collide_step(");
+    ASSERT_NE(function, std::string::npos);
+    ASSERT_NE(body, std::string::npos);
+    EXPECT_LT(function, body);
+    EXPECT_NE(source.find("rho = D2Q9_collide_cumulant(f, omega, omega, 1.0f)"), std::string::npos);
+
+    // No clause leaves the operator unset; a clause without a lattice is a syntax error
+    visitor.parseString("kernel plain: { reads: f writes: f script: | rho = collide(f, omega) | }");
+    ASSERT_EQ(visitor.getKernels().size(), 1u);
+    EXPECT_TRUE(visitor.getKernels().front()->getCollisionModel().empty());
+    EXPECT_THROW(visitor.parseString("kernel broken: { collision: cumulant script: | | }"), std::runtime_error);
+
+    registry.clear();
+}
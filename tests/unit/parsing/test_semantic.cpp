@@ -1,6 +1,9 @@
 #include "fluidloom/parsing/symbol_table/SymbolTable.h"
 #include "fluidloom/parsing/semantic/SemanticAnalyzer.h"
 #include "fluidloom/parsing/ast/KernelAST.h"
+#include "fluidloom/parsing/ast/AstArena.h"
+#include "fluidloom/parsing/registry/ConstantRegistry.h"
+#include "fluidloom/common/StringInterner.h"
 #include <gtest/gtest.h>
 
 using namespace fluidloom::parsing;
@@ -62,6 +65,71 @@ TEST_F(SymbolTableTest, AddField) {
     EXPECT_EQ(result->num_components, 1);
 }
 
+TEST(StringInternerTest, DenseStableIds) {
+    fluidloom::SymbolId a = fluidloom::intern("interner_test_a");
+    fluidloom::SymbolId b = fluidloom::intern("interner_test_b");
+    
+    EXPECT_NE(a, fluidloom::INVALID_SYMBOL);
+    EXPECT_EQ(b, a + 1);
+    EXPECT_EQ(fluidloom::intern("interner_test_a"), a);
+    EXPECT_EQ(fluidloom::StringInterner::instance().name(b), "interner_test_b");
+    EXPECT_EQ(fluidloom::StringInterner::instance().find("interner_test_never"), fluidloom::INVALID_SYMBOL);
+}
+
+TEST_F(SymbolTableTest, LookupByInternedId) {
+    table.addVariable("rho", symbol_table::SymbolType::FLOAT);
+    table.enterScope();
+    table.addVariable("tmp", symbol_table::SymbolType::INT);
+    
+    ast::VariableExpression ref("rho");
+    const symbol_table::Symbol* symbol = table.find(ref.symbol);
+    ASSERT_NE(symbol, nullptr);
+    EXPECT_EQ(symbol->name, "rho");
+    EXPECT_EQ(symbol->id, ref.symbol);
+    
+    table.exitScope();
+    EXPECT_EQ(table.find(fluidloom::intern("tmp")), nullptr);
+}
+
+TEST(ConstantRegistryTest, LookupByInternedId) {
+    auto& registry = ConstantRegistry::getInstance();
+    registry.clear();
+    
+    ConstantDescriptor cs2{"CS2_TEST", ConstantDescriptor::Type::FLOAT, {}};
+    cs2.value.f = 1.0f / 3.0f;
+    registry.add(cs2);
+    
+    const ConstantDescriptor* found = registry.get(fluidloom::intern("CS2_TEST"));
+    ASSERT_NE(found, nullptr);
+    EXPECT_FLOAT_EQ(found->value.f, 1.0f / 3.0f);
+    EXPECT_EQ(registry.get("CS2_TEST"), found);
+    EXPECT_THROW(registry.add(cs2), std::runtime_error);
+    registry.clear();
+    EXPECT_EQ(registry.get("CS2_TEST"), nullptr);
+}
+
+TEST(AstArenaTest, NodesShareBlocksAndOutliveArena) {
+    std::shared_ptr<ast::BinaryExpression> sum;
+    {
+        ast::AstArena arena(4096);
+        std::vector<std::shared_ptr<ast::Expression>> terms;
+        for (int i = 0; i < 200; ++i) {
+            terms.push_back(arena.make<ast::VariableExpression>("f" + std::to_string(i % 19)));
+        }
+        sum = arena.make<ast::BinaryExpression>(ast::BinaryExpression::Op::ADD, terms[0], terms[1]);
+        
+        EXPECT_GT(arena.blockCount(), 1u);
+        EXPECT_LT(arena.blockCount(), 200u);
+        EXPECT_GT(arena.bytesUsed(), 200 * sizeof(ast::VariableExpression));
+    }
+    
+    // Storage stays alive while any node does
+    auto* left = dynamic_cast<ast::VariableExpression*>(sum->left.get());
+    ASSERT_NE(left, nullptr);
+    EXPECT_EQ(left->name, "f0");
+    EXPECT_EQ(left->symbol, fluidloom::intern("f0"));
+}
+
 class SemanticAnalyzerTest : public ::testing::Test {
 protected:
     semantic::SemanticAnalyzer analyzer;
@@ -98,3 +166,16 @@ TEST_F(SemanticAnalyzerTest, SymbolTablePopulation) {
     EXPECT_TRUE(sym_table.exists("velocity"));
     EXPECT_TRUE(sym_table.exists("populations"));
 }
+
+TEST_F(SemanticAnalyzerTest, UnknownFieldIsNotInterned) {
+    auto& registry = fluidloom::registry::FieldRegistry::instance();
+    analyzer.setFieldRegistry(&registry);
+    
+    auto kernel = std::make_shared<ast::KernelAST>("TestKernel");
+    kernel->setReadFields({"semantic_never_registered"});
+    
+    const size_t interned = fluidloom::StringInterner::instance().size();
+    EXPECT_FALSE(analyzer.analyzeKernel(*kernel));
+    EXPECT_FALSE(analyzer.getErrors().empty());
+    EXPECT_EQ(fluidloom::StringInterner::instance().size(), interned);
+}
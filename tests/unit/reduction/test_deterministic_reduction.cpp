@@ -0,0 +1,303 @@
+#include <gtest/gtest.h>
+#include "fluidloom/core/backend/OpenCLBackend.h"
+#include "fluidloom/core/reduction/DeterministicReducer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace fluidloom;
+using namespace fluidloom::reduction;
+
+namespace {
+
+uint64_t bitsOf(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// Density plus a 3-component velocity (SOA, stride n) over mixed levels,
+// with magnitudes spread wide enough that naive float sums depend on order
+struct FlowState {
+    size_t n = 0;
+    std::vector<float> rho;
+    std::vector<float> u;
+    std::vector<uint8_t> levels;
+    std::vector<hilbert::HilbertIndex> keys;  // Ascending: cells are in Hilbert order
+};
+
+FlowState makeFlow(size_t n) {
+    FlowState flow;
+    flow.n = n;
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> rho_dist(0.9f, 1.1f);
+    std::normal_distribution<float> u_dist(0.0f, 0.05f);
+    std::uniform_int_distribution<int> level_dist(0, 3);
+    std::uniform_int_distribution<int> spike(0, 997);
+
+    for (size_t i = 0; i < n; ++i) {
+        flow.rho.push_back(spike(gen) == 0 ? 1.0e6f : rho_dist(gen));
+        flow.levels.push_back(static_cast<uint8_t>(level_dist(gen)));
+        flow.keys.push_back(i * 8);
+    }
+    flow.u.resize(3 * n);
+    for (auto& c : flow.u) {
+        c = u_dist(gen);
+    }
+    return flow;
+}
+
+std::vector<ReductionSpec> flowSpecs() {
+    std::vector<ReductionSpec> specs(4);
+    specs[0].name = "mass";
+    specs[0].field = 0;
+    specs[0].volume_weighted = true;
+
+    specs[1].name = "kinetic_energy";
+    specs[1].term = ReduceTerm::SQUARED_NORM;
+    specs[1].field = 1;
+    specs[1].num_components = 3;
+    specs[1].weight_field = 0;
+    specs[1].volume_weighted = true;
+    specs[1].scale = 0.5f;
+
+    specs[2].name = "max_speed";
+    specs[2].op = ReduceOp::MAX;
+    specs[2].term = ReduceTerm::NORM;
+    specs[2].field = 1;
+    specs[2].num_components = 3;
+
+    specs[3].name = "min_ux";
+    specs[3].op = ReduceOp::MIN;
+    specs[3].field = 1;
+    return specs;
+}
+
+// Partials of cells [begin, end) as one rank would compute them
+ReductionPartials rankPartials(DeterministicReducer& reducer, const FlowState& flow, size_t begin, size_t end) {
+    const size_t count = end - begin;
+    std::vector<float> rho(flow.rho.begin() + begin, flow.rho.begin() + end);
+    std::vector<float> u(3 * count);
+    for (size_t k = 0; k < 3; ++k) {
+        std::copy(flow.u.begin() + k * flow.n + begin, flow.u.begin() + k * flow.n + end, u.begin() + k * count);
+    }
+    std::vector<uint8_t> levels(flow.levels.begin() + begin, flow.levels.begin() + end);
+    return reducer.reduceLocal(flowSpecs(), {{rho.data(), count}, {u.data(), count}}, levels.data(), count);
+}
+
+// Splits the cells into num_ranks contiguous Hilbert ranges, lets the
+// "MPI" gather return the records in a scrambled rank order, and reduces
+std::vector<double> reduceAcrossRanks(const FlowState& flow, size_t num_ranks, unsigned shuffle_seed) {
+    DeterministicReducer reducer;
+
+    std::vector<std::vector<uint8_t>> records;
+    for (size_t rank = 0; rank < num_ranks; ++rank) {
+        const size_t begin = flow.n * rank / num_ranks;
+        const size_t end = flow.n * (rank + 1) / num_ranks;
+        ReductionPartials partials = rankPartials(reducer, flow, begin, end);
+        DeterministicReducer::allReduce(partials, flow.keys[begin], [&](const void* data, size_t size) {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            records.emplace_back(bytes, bytes + size);
+            return records.back();
+        });
+    }
+
+    std::shuffle(records.begin(), records.end(), std::mt19937(shuffle_seed));
+    std::vector<uint8_t> gathered;
+    for (const auto& record : records) {
+        gathered.insert(gathered.end(), record.begin(), record.end());
+    }
+
+    // Any rank's partials will do: allReduce only sends them
+    ReductionPartials local = rankPartials(reducer, flow, 0, flow.n / num_ranks);
+    return DeterministicReducer::allReduce(local, flow.keys[0], [&](const void*, size_t) { return gathered; });
+}
+
+} // namespace
+
+TEST(ExactAccumulatorTest, SumIsExactAndOrderIndependent) {
+    ExactAccumulator acc;
+    acc.add(1.0e30f);
+    acc.add(1.0f);
+    acc.add(-1.0e30f);
+    EXPECT_EQ(acc.toDouble(), 1.0);
+
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<float> exponent(-40.0f, 40.0f);
+    std::vector<float> values;
+    for (int i = 0; i < 10000; ++i) {
+        values.push_back((i % 2 ? -1.0f : 1.0f) * std::pow(2.0f, exponent(gen)));
+    }
+
+    ExactAccumulator forward, shuffled, halves, other_half;
+    for (float v : values) forward.add(v);
+    std::shuffle(values.begin(), values.end(), gen);
+    for (float v : values) shuffled.add(v);
+    for (size_t i = 0; i < values.size(); ++i) (i < 3333 ? halves : other_half).add(values[i]);
+    halves.merge(other_half);
+
+    EXPECT_EQ(forward, shuffled);
+    EXPECT_EQ(forward, halves);
+    EXPECT_EQ(bitsOf(forward.toDouble()), bitsOf(halves.toDouble()));
+}
+
+TEST(ExactAccumulatorTest, ConversionRoundsToNearestEven) {
+    const float two53 = 9007199254740992.0f;  // 2^53
+
+    ExactAccumulator tie;
+    tie.add(two53);
+    tie.add(1.0f);
+    EXPECT_EQ(tie.toDouble(), 9007199254740992.0);  // 2^53 + 1 ties to even
+
+    // Anything below the tie breaks it upward
+    tie.add(std::ldexp(1.0f, -100));
+    EXPECT_EQ(tie.toDouble(), 9007199254740994.0);
+
+    ExactAccumulator negative;
+    negative.add(-two53);
+    negative.add(-3.0f);
+    EXPECT_EQ(negative.toDouble(), -9007199254740996.0);  // -(2^53 + 3) ties to even
+
+    const float denorm = std::numeric_limits<float>::denorm_min();
+    ExactAccumulator tiny;
+    for (int i = 0; i < 3; ++i) tiny.add(denorm);
+    EXPECT_EQ(tiny.toDouble(), 3.0 * static_cast<double>(denorm));
+
+    ExactAccumulator huge;
+    for (int i = 0; i < 4; ++i) huge.add(std::numeric_limits<float>::max());
+    EXPECT_EQ(huge.toDouble(), 4.0 * static_cast<double>(std::numeric_limits<float>::max()));
+}
+
+TEST(ExactAccumulatorTest, SpecialValuesAndSerialization) {
+    ExactAccumulator acc;
+    acc.add(2.5f);
+    acc.add(-0.0f);
+    std::vector<int64_t> words(ExactAccumulator::WORDS);
+    acc.store(words.data());
+    EXPECT_EQ(ExactAccumulator::load(words.data()), acc);
+    EXPECT_EQ(ExactAccumulator::load(words.data()).toDouble(), 2.5);
+
+    acc.add(std::numeric_limits<float>::infinity());
+    EXPECT_EQ(acc.toDouble(), std::numeric_limits<double>::infinity());
+    acc.add(-std::numeric_limits<float>::infinity());
+    EXPECT_TRUE(std::isnan(acc.toDouble()));
+
+    ExactAccumulator nan;
+    nan.add(std::numeric_limits<float>::quiet_NaN());
+    EXPECT_TRUE(std::isnan(nan.toDouble()));
+    EXPECT_TRUE(ExactAccumulator().isZero());
+}
+
+TEST(DeterministicReducerTest, FusedGlobalQuantitiesMatchReference) {
+    FlowState flow = makeFlow(20000);
+    DeterministicReducer reducer;
+    auto values = reducer.reduce(flowSpecs(), {{flow.rho.data(), flow.n}, {flow.u.data(), flow.n}},
+                                 flow.levels.data(), flow.n, flow.keys[0], nullptr);
+    ASSERT_EQ(values.size(), 4u);
+
+    long double mass = 0, energy = 0;
+    float max_speed = 0.0f, min_ux = std::numeric_limits<float>::infinity();
+    for (size_t i = 0; i < flow.n; ++i) {
+        const long double volume = std::ldexp(1.0L, -3 * flow.levels[i]);
+        long double u2 = 0;
+        for (size_t k = 0; k < 3; ++k) {
+            u2 += static_cast<long double>(flow.u[k * flow.n + i]) * flow.u[k * flow.n + i];
+        }
+        mass += flow.rho[i] * volume;
+        energy += 0.5L * flow.rho[i] * u2 * volume;
+        max_speed = std::max(max_speed, static_cast<float>(std::sqrt(u2)));
+        min_ux = std::min(min_ux, flow.u[i]);
+    }
+
+    EXPECT_NEAR(values[0], static_cast<double>(mass), 1e-12 * static_cast<double>(mass));
+    EXPECT_NEAR(values[1], static_cast<double>(energy), 1e-5 * static_cast<double>(energy));
+    EXPECT_NEAR(values[2], max_speed, 1e-6);
+    EXPECT_EQ(values[3], min_ux);
+}
+
+TEST(DeterministicReducerTest, BitIdenticalAcrossRankCounts) {
+    FlowState flow = makeFlow(12345);
+    const auto reference = reduceAcrossRanks(flow, 1, 0);
+
+    for (size_t ranks : {2u, 3u, 7u, 64u}) {
+        for (unsigned seed : {1u, 2u}) {
+            const auto values = reduceAcrossRanks(flow, ranks, seed);
+            ASSERT_EQ(values.size(), reference.size());
+            for (size_t i = 0; i < values.size(); ++i) {
+                EXPECT_EQ(bitsOf(values[i]), bitsOf(reference[i]))
+                    << flowSpecs()[i].name << " with " << ranks << " ranks";
+            }
+        }
+    }
+}
+
+TEST(DeterministicReducerTest, ExtremaIgnoreSignOfZeroAndFlagNaN) {
+    std::vector<float> data = {0.0f, -0.0f, 3.0f};
+    ReductionSpec min_spec;
+    min_spec.op = ReduceOp::MIN;
+    DeterministicReducer reducer;
+
+    auto forward = reducer.reduceLocal({min_spec}, {{data.data(), 0}}, nullptr, data.size());
+    std::reverse(data.begin(), data.end());
+    auto backward = reducer.reduceLocal({min_spec}, {{data.data(), 0}}, nullptr, data.size());
+    EXPECT_EQ(bitsOf(forward.value(0)), bitsOf(0.0));
+    EXPECT_EQ(bitsOf(backward.value(0)), bitsOf(0.0));
+
+    data.push_back(std::numeric_limits<float>::quiet_NaN());
+    EXPECT_TRUE(std::isnan(reducer.reduceLocal({min_spec}, {{data.data(), 0}}, nullptr, data.size()).value(0)));
+}
+
+TEST(DeterministicReducerTest, RejectsInvalidSpecs) {
+    std::vector<float> data(16, 1.0f);
+    DeterministicReducer reducer;
+
+    std::vector<ReductionSpec> too_many(DeterministicReducer::MAX_FUSED + 1);
+    EXPECT_THROW(reducer.reduceLocal(too_many, {{data.data(), 0}}, nullptr, data.size()), std::invalid_argument);
+
+    ReductionSpec volume;
+    volume.volume_weighted = true;
+    EXPECT_THROW(reducer.reduceLocal({volume}, {{data.data(), 0}}, nullptr, data.size()), std::invalid_argument);
+
+    ReductionSpec missing;
+    missing.field = 1;
+    EXPECT_THROW(reducer.reduceLocal({missing}, {{data.data(), 0}}, nullptr, data.size()), std::invalid_argument);
+
+    ReductionSpec components;
+    components.num_components = 3;
+    EXPECT_THROW(reducer.reduceLocal({components}, {{data.data(), 0}}, nullptr, data.size()), std::invalid_argument);
+
+    EXPECT_THROW(DeterministicReducer::allReduce(ReductionPartials({ReduceOp::SUM}), 0,
+                                                 [](const void*, size_t) { return std::vector<uint8_t>(3); }),
+                 std::runtime_error);
+}
+
+TEST(DeterministicReducerDeviceTest, DeviceMatchesHostBitwise) {
+    OpenCLBackend backend;
+    try {
+        backend.initialize(0);
+    } catch (const std::exception& e) {
+        GTEST_SKIP() << "No OpenCL device: " << e.what();
+    }
+
+    FlowState flow = makeFlow(100000);
+    auto rho_buf = backend.allocateBuffer(flow.rho.size() * sizeof(float), flow.rho.data());
+    auto u_buf = backend.allocateBuffer(flow.u.size() * sizeof(float), flow.u.data());
+    auto levels_buf = backend.allocateBuffer(flow.levels.size(), flow.levels.data());
+
+    DeterministicReducer device(&backend);
+    const auto device_values = device.reduceLocal(
+        flowSpecs(), {{rho_buf->getDevicePointer(), flow.n}, {u_buf->getDevicePointer(), flow.n}},
+        levels_buf->getDevicePointer(), flow.n).values();
+
+    DeterministicReducer host;
+    const auto host_values = host.reduceLocal(
+        flowSpecs(), {{flow.rho.data(), flow.n}, {flow.u.data(), flow.n}}, flow.levels.data(), flow.n).values();
+
+    for (size_t i = 0; i < host_values.size(); ++i) {
+        EXPECT_EQ(bitsOf(device_values[i]), bitsOf(host_values[i])) << flowSpecs()[i].name;
+    }
+    backend.shutdown();
+}
@@ -0,0 +1,168 @@
+#include "fluidloom/runtime/timestep/AdaptiveTimeStepController.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+using namespace fluidloom::runtime::timestep;
+
+namespace {
+
+AdaptiveTimeStepConfig twoLevelConfig() {
+    AdaptiveTimeStepConfig config;
+    config.dx0 = 1.0;
+    config.max_level = 1;
+    config.subcycle_ratio = 2;
+    config.cfl_target = 0.1;
+    config.cfl_max = 0.3;
+    config.max_growth = 1.1;
+    return config;
+}
+
+// Two components per cell (SOA, stride n), cell levels alternating 0/1
+struct Velocity {
+    std::vector<float> u;
+    std::vector<uint8_t> levels;
+
+    Velocity(size_t n, float speed_l0, float speed_l1) : u(2 * n, 0.0f), levels(n) {
+        for (size_t i = 0; i < n; ++i) {
+            levels[i] = static_cast<uint8_t>(i % 2);
+            u[i] = (i % 2 ? speed_l1 : speed_l0) * 0.6f;
+            u[n + i] = (i % 2 ? speed_l1 : speed_l0) * 0.8f;
+        }
+    }
+
+    AdaptiveTimeStepController::VelocityInput input() const {
+        AdaptiveTimeStepController::VelocityInput in;
+        in.velocity = {u.data(), levels.size()};
+        in.num_components = 2;
+        in.levels = levels.data();
+        in.num_cells = levels.size();
+        return in;
+    }
+};
+
+} // namespace
+
+TEST(AdaptiveTimeStepTest, SpikeShrinksAtOnceCalmGrowsGradually) {
+    AdaptiveTimeStepController controller(twoLevelConfig(), 0.1);
+
+    // |u| = 5 on level 1: CFL of level 1 = 5 · dt/2 / (1/2) = 5 dt
+    TimeStepState spike = controller.propose({0.5f, 5.0f});
+    EXPECT_NEAR(spike.dt, 0.02, 1e-12);
+    EXPECT_EQ(spike.limit, TimeStepLimit::CFL);
+    EXPECT_TRUE(spike.cfl_violated);  // 5 · 0.1 = 0.5 > cfl_max
+    EXPECT_NEAR(spike.level_cfl[1], 0.1, 1e-12);
+
+    TimeStepState calm = controller.propose({0.01f, 0.01f});
+    EXPECT_NEAR(calm.dt, 0.11, 1e-12);
+    EXPECT_EQ(calm.limit, TimeStepLimit::GROWTH);
+    EXPECT_FALSE(calm.cfl_violated);
+}
+
+TEST(AdaptiveTimeStepTest, LevelTimeStepsFollowSubcycling) {
+    AdaptiveTimeStepConfig config = twoLevelConfig();
+    config.max_level = 3;
+    config.subcycle_ratio = 4;  // Fine levels take smaller steps than convection needs
+    AdaptiveTimeStepController controller(config, 1.0);
+
+    TimeStepState state = controller.propose({1.0f, 1.0f, 1.0f, 1.0f});
+    EXPECT_NEAR(state.dt, 0.1, 1e-12);  // Level 0 is the steepest
+    for (uint8_t level = 0; level <= 3; ++level) {
+        EXPECT_NEAR(state.level_dt[level], state.dt / std::pow(4.0, level), 1e-15);
+        EXPECT_NEAR(state.level_cfl[level], 0.1 / std::pow(2.0, level), 1e-12);
+    }
+    EXPECT_EQ(controller.getSubsteps(3), 64u);
+}
+
+TEST(AdaptiveTimeStepTest, RelaxationStaysWithinBounds) {
+    AdaptiveTimeStepConfig config = twoLevelConfig();
+    config.viscosity = 0.05;
+    config.tau_min = 0.51;
+    config.tau_max = 1.0;
+    AdaptiveTimeStepController controller(config, 1.0);
+
+    // tau_1 = 0.5 + 0.3 dt only reaches tau_max at dt = 5/3; growth binds first
+    TimeStepState state = controller.propose({0.001f, 0.001f});
+    EXPECT_EQ(state.limit, TimeStepLimit::GROWTH);
+    EXPECT_LE(state.level_tau[0], config.tau_max);
+
+    // Level 1 has the larger tau (dt_L / dx_L² doubles per level)
+    config.tau_max = 0.6;
+    AdaptiveTimeStepController capped(config, 1.0);
+    state = capped.propose({0.001f, 0.001f});
+    EXPECT_EQ(state.limit, TimeStepLimit::TAU_MAX);
+    EXPECT_NEAR(state.level_tau[1], 0.6, 1e-9);
+    EXPECT_FALSE(state.tau_clamped);
+    EXPECT_NEAR(state.level_omega[1], 1.0 / 0.6, 1e-9);
+
+    // tau_min wants dt >= 0.0667 while CFL wants 0.02: CFL wins, tau clamps
+    config.tau_max = 1.0;
+    AdaptiveTimeStepController conflicted(config, 1.0);
+    state = conflicted.propose({5.0f, 5.0f});
+    EXPECT_NEAR(state.dt, 0.06, 1e-12);  // Raised only up to cfl_max
+    EXPECT_EQ(state.limit, TimeStepLimit::TAU_MIN);
+    EXPECT_TRUE(state.tau_clamped);
+    EXPECT_NEAR(state.level_tau[0], 0.51, 1e-12);
+}
+
+TEST(AdaptiveTimeStepTest, StepAppliesReductionOneStepLater) {
+    Velocity velocity(1000, 0.5f, 2.0f);
+    AdaptiveTimeStepController controller(twoLevelConfig(), 0.1);
+
+    int callbacks = 0;
+    controller.setUpdateCallback([&](const TimeStepState& state) {
+        ++callbacks;
+        EXPECT_FLOAT_EQ(state.level_max_speed[0], 0.5f);
+        EXPECT_FLOAT_EQ(state.level_max_speed[1], 2.0f);
+    });
+
+    EXPECT_FALSE(controller.step(velocity.input()));  // Posts the reduction
+    EXPECT_TRUE(controller.isPending());
+    EXPECT_DOUBLE_EQ(controller.getDt(), 0.1);
+
+    EXPECT_TRUE(controller.step(velocity.input()));   // Applies it
+    EXPECT_NEAR(controller.getDt(), 0.05, 1e-9);
+    EXPECT_NEAR(controller.getLevelDt(1), 0.025, 1e-9);
+    EXPECT_EQ(callbacks, 1);
+}
+
+TEST(AdaptiveTimeStepTest, UpdateIntervalAndHostTaskNode) {
+    AdaptiveTimeStepConfig config = twoLevelConfig();
+    config.update_interval = 3;
+    AdaptiveTimeStepController controller(config, 0.1);
+    Velocity velocity(64, 1.0f, 1.0f);
+
+    auto node = controller.createUpdateNode("u", [&]() { return velocity.input(); });
+    EXPECT_TRUE(node->readsField("u"));
+
+    for (int s = 0; s < 7; ++s) {
+        node->execute(nullptr);
+    }
+    // Posted at steps 0, 3, 6; the first two are applied
+    EXPECT_EQ(controller.getState().updates, 2u);
+    EXPECT_TRUE(controller.isPending());
+}
+
+TEST(AdaptiveTimeStepTest, NaNKeepsDtAndReportsViolation) {
+    AdaptiveTimeStepController controller(twoLevelConfig(), 0.1);
+    TimeStepState state = controller.propose({0.1f, std::numeric_limits<float>::quiet_NaN()});
+    EXPECT_DOUBLE_EQ(state.dt, 0.1);
+    EXPECT_TRUE(state.cfl_violated);
+
+    // Levels without cells reduce to -inf and do not constrain dt
+    state = controller.propose({1.0f, -std::numeric_limits<float>::infinity()});
+    EXPECT_NEAR(state.dt, 0.1, 1e-12);
+}
+
+TEST(AdaptiveTimeStepTest, RejectsInvalidConfig) {
+    AdaptiveTimeStepConfig config = twoLevelConfig();
+    config.cfl_target = 0.5;  // Above cfl_max
+    EXPECT_THROW(AdaptiveTimeStepController(config, 0.1), std::invalid_argument);
+
+    config = twoLevelConfig();
+    config.tau_min = 0.5;
+    EXPECT_THROW(AdaptiveTimeStepController(config, 0.1), std::invalid_argument);
+
+    EXPECT_THROW(AdaptiveTimeStepController(twoLevelConfig(), 0.0), std::invalid_argument);
+}
@@ -0,0 +1,102 @@
+#include "fluidloom/runtime/nodes/BarrierNode.h"
+#include "fluidloom/runtime/scheduler/ScopedEventTable.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+
+using namespace fluidloom::runtime;
+using BarrierKind = nodes::BarrierNode::BarrierKind;
+
+namespace {
+
+// Opaque handles only; collectWaitList never dereferences them
+cl_event fakeEvent(uintptr_t id) {
+    return reinterpret_cast<cl_event>(id);
+}
+
+bool contains(const std::vector<cl_event>& events, cl_event e) {
+    return std::find(events.begin(), events.end(), e) != events.end();
+}
+
+} // namespace
+
+class BarrierNodeTest : public ::testing::Test {
+protected:
+    scheduler::ScopedEventTable table;
+    
+    void SetUp() override {
+        table.record({}, {"rho"}, 0, fakeEvent(0x10));
+        table.record({}, {"u"}, 0, fakeEvent(0x20));
+        table.record({}, {"cell_state"}, 1, fakeEvent(0x30));
+        table.record({}, {"f"}, 1, fakeEvent(0x40));
+    }
+};
+
+TEST_F(BarrierNodeTest, AdaptationBarrierWaitsOnDeclaredFieldsOnly) {
+    nodes::BarrierNode barrier("pre_adapt", BarrierKind::ADAPTATION_PRE);
+    barrier.setReadFields({"cell_state"});
+    barrier.setWriteFields({"rho"});
+    barrier.bindEventTable(&table);
+    
+    auto events = barrier.collectWaitList(nullptr);
+    EXPECT_EQ(events.size(), 2u);
+    EXPECT_TRUE(contains(events, fakeEvent(0x10)));
+    EXPECT_TRUE(contains(events, fakeEvent(0x30)));
+    EXPECT_FALSE(contains(events, fakeEvent(0x20)));
+}
+
+// Adaptation rewrites cell_state, so it must also wait for the kernels
+// that read it after its last write (WAR), not only for that writer
+TEST_F(BarrierNodeTest, AdaptationBarrierWaitsOnReadersOfFieldsItWrites) {
+    table.record({"cell_state", "rho"}, {"u"}, 0, fakeEvent(0x50));
+    table.record({"cell_state"}, {}, 1, fakeEvent(0x60));
+    
+    nodes::BarrierNode barrier("pre_adapt", BarrierKind::ADAPTATION_PRE);
+    barrier.setWriteFields({"cell_state"});
+    barrier.bindEventTable(&table);
+    
+    auto events = barrier.collectWaitList(nullptr);
+    EXPECT_EQ(events.size(), 3u);
+    EXPECT_TRUE(contains(events, fakeEvent(0x30)));
+    EXPECT_TRUE(contains(events, fakeEvent(0x50)));
+    EXPECT_TRUE(contains(events, fakeEvent(0x60)));
+    
+    // A later write supersedes the readers it was ordered after
+    table.record({}, {"cell_state"}, 1, fakeEvent(0x70));
+    events = barrier.collectWaitList(nullptr);
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_EQ(events[0], fakeEvent(0x70));
+}
+
+TEST_F(BarrierNodeTest, LevelTransitionWaitsOnItsLevelOnly) {
+    nodes::BarrierNode barrier("level_0_to_1", BarrierKind::LEVEL_TRANSITION);
+    barrier.setLevel(0);
+    barrier.bindEventTable(&table);
+    
+    auto events = barrier.collectWaitList(nullptr);
+    EXPECT_EQ(events.size(), 2u);
+    EXPECT_TRUE(contains(events, fakeEvent(0x10)));
+    EXPECT_TRUE(contains(events, fakeEvent(0x20)));
+}
+
+TEST_F(BarrierNodeTest, LoadBalanceWaitsOnEverything) {
+    nodes::BarrierNode barrier("rebalance", BarrierKind::LOAD_BALANCE);
+    barrier.bindEventTable(&table);
+    
+    EXPECT_EQ(barrier.collectWaitList(fakeEvent(0x10)).size(), 4u);
+}
+
+TEST_F(BarrierNodeTest, OnlyLoadBalanceIsGlobal) {
+    EXPECT_TRUE(nodes::BarrierNode("lb", BarrierKind::LOAD_BALANCE).isGlobal());
+    EXPECT_FALSE(nodes::BarrierNode("pre", BarrierKind::ADAPTATION_PRE, true).isGlobal());
+    EXPECT_FALSE(nodes::BarrierNode("lvl", BarrierKind::LEVEL_TRANSITION, true).isGlobal());
+}
+
+TEST_F(BarrierNodeTest, EmptyScopeDoesNotBlock) {
+    nodes::BarrierNode barrier("post_adapt", BarrierKind::ADAPTATION_POST);
+    barrier.setWriteFields({"not_written_this_pass"});
+    barrier.bindEventTable(&table);
+    
+    EXPECT_TRUE(barrier.collectWaitList(nullptr).empty());
+    EXPECT_EQ(barrier.execute(nullptr), nullptr);
+}
@@ -0,0 +1,178 @@
+#include "fluidloom/runtime/dependency/FieldLivenessAnalyzer.h"
+#include "fluidloom/runtime/nodes/HostTaskNode.h"
+#include "fluidloom/core/backend/BackendFactory.h"
+#include <gtest/gtest.h>
+#include <map>
+
+using namespace fluidloom;
+using namespace fluidloom::runtime;
+using fluidloom::fields::FieldDescriptor;
+using fluidloom::fields::FieldType;
+
+namespace {
+
+void link(const std::shared_ptr<nodes::ExecutionNode>& from, const std::shared_ptr<nodes::ExecutionNode>& to) {
+    from->addSuccessor(to);
+    to->addPredecessor(from);
+}
+
+FieldDescriptor transientField(const std::string& name, size_t components = 1) {
+    FieldDescriptor desc(name, FieldType::FLOAT32, components);
+    desc.halo_depth = 0;
+    desc.is_transient = true;
+    return desc;
+}
+
+} // namespace
+
+class FieldLivenessTest : public ::testing::Test {
+protected:
+    std::shared_ptr<nodes::ExecutionNode> makeNode(const std::string& name,
+                                                   std::vector<std::string> reads,
+                                                   std::vector<std::string> writes) {
+        auto node = std::make_shared<nodes::HostTaskNode>(name, [] {});
+        node->setId(static_cast<int64_t>(nodes_.size()));
+        node->setReadFields(std::move(reads));
+        node->setWriteFields(std::move(writes));
+        nodes_.push_back(node);
+        return node;
+    }
+
+    std::unique_ptr<dependency::DependencyGraph> buildGraph() {
+        auto graph = std::make_unique<dependency::DependencyGraph>(nodes_);
+        EXPECT_TRUE(graph->validate());
+        return graph;
+    }
+
+    std::vector<std::shared_ptr<nodes::ExecutionNode>> nodes_;
+};
+
+TEST_F(FieldLivenessTest, SequentialScratchFieldsShareABuffer) {
+    // rho -> tmp_a -> tmp_b -> rho; tmp_a is dead once tmp_b is written
+    auto n0 = makeNode("k0", {"rho"}, {"tmp_a"});
+    auto n1 = makeNode("k1", {"tmp_a"}, {"tmp_b"});
+    auto n2 = makeNode("k2", {"tmp_b"}, {"tmp_c"});
+    auto n3 = makeNode("k3", {"tmp_c"}, {"rho"});
+    link(n0, n1);
+    link(n1, n2);
+    link(n2, n3);
+    auto graph = buildGraph();
+
+    FieldDescriptor rho("rho", FieldType::FLOAT32, 1);
+    std::vector<FieldDescriptor> fields = {rho, transientField("tmp_a"), transientField("tmp_b"),
+                                           transientField("tmp_c")};
+
+    dependency::FieldLivenessAnalyzer analyzer;
+    auto plan = analyzer.analyze(*graph, fields);
+
+    // tmp_a and tmp_b overlap at k1; tmp_a and tmp_c do not
+    EXPECT_FALSE(plan.sharesBuffer("tmp_a", "tmp_b"));
+    EXPECT_FALSE(plan.sharesBuffer("tmp_b", "tmp_c"));
+    EXPECT_TRUE(plan.sharesBuffer("tmp_a", "tmp_c"));
+    EXPECT_EQ(plan.slots.size(), 2u);
+    ASSERT_EQ(plan.dedicated.size(), 1u);
+    EXPECT_EQ(plan.dedicated[0], "rho");
+    EXPECT_LT(plan.bytes_per_cell_after, plan.bytes_per_cell_before);
+}
+
+TEST_F(FieldLivenessTest, UnorderedFieldsDoNotShare) {
+    // Two independent branches may run concurrently
+    auto a = makeNode("a", {"rho"}, {"tmp_a"});
+    auto a2 = makeNode("a2", {"tmp_a"}, {"out_a"});
+    auto b = makeNode("b", {"rho"}, {"tmp_b"});
+    auto b2 = makeNode("b2", {"tmp_b"}, {"out_b"});
+    link(a, a2);
+    link(b, b2);
+    auto graph = buildGraph();
+
+    std::vector<FieldDescriptor> fields = {transientField("tmp_a"), transientField("tmp_b")};
+
+    dependency::FieldLivenessAnalyzer analyzer;
+    auto plan = analyzer.analyze(*graph, fields);
+
+    EXPECT_FALSE(plan.sharesBuffer("tmp_a", "tmp_b"));
+    EXPECT_EQ(plan.slots.size(), 2u);
+}
+
+TEST_F(FieldLivenessTest, ExcludesLiveInHaloAndPinnedFields) {
+    auto n0 = makeNode("k0", {"carry"}, {"carry", "tmp"});
+    auto n1 = makeNode("k1", {"tmp"}, {"halo", "pinned"});
+    auto n2 = makeNode("k2", {"halo", "pinned"}, {"late"});
+    link(n0, n1);
+    link(n1, n2);
+    auto graph = buildGraph();
+
+    FieldDescriptor halo = transientField("halo");
+    halo.halo_depth = 1;
+    std::vector<FieldDescriptor> fields = {transientField("carry"), transientField("tmp"), halo,
+                                           transientField("pinned"), transientField("late"),
+                                           transientField("unused")};
+
+    dependency::FieldLivenessAnalyzer analyzer;
+    analyzer.pinField("pinned");
+    auto plan = analyzer.analyze(*graph, fields);
+
+    std::map<std::string, std::string> reasons;
+    for (const auto& lifetime : analyzer.getLifetimes()) {
+        reasons[lifetime.field_name] = lifetime.transient ? "" : lifetime.exclusion_reason;
+    }
+    EXPECT_EQ(reasons["carry"], "read before written");
+    EXPECT_EQ(reasons["tmp"], "");
+    EXPECT_EQ(reasons["halo"], "halo exchange");
+    EXPECT_EQ(reasons["pinned"], "pinned");
+    EXPECT_EQ(reasons["late"], "");
+    EXPECT_EQ(reasons["unused"], "not accessed");
+
+    EXPECT_TRUE(plan.sharesBuffer("tmp", "late"));
+    EXPECT_EQ(plan.dedicated.size(), 4u);
+}
+
+TEST_F(FieldLivenessTest, InferenceIsOptIn) {
+    auto n0 = makeNode("k0", {}, {"tmp_a"});
+    auto n1 = makeNode("k1", {"tmp_a"}, {"tmp_b"});
+    auto n2 = makeNode("k2", {"tmp_b"}, {"tmp_c"});
+    link(n0, n1);
+    link(n1, n2);
+    auto graph = buildGraph();
+
+    FieldDescriptor unmarked("tmp_c", FieldType::FLOAT32, 1);
+    unmarked.halo_depth = 0;
+    std::vector<FieldDescriptor> fields = {transientField("tmp_a"), transientField("tmp_b"), unmarked};
+
+    // Off by default: unmarked fields may have host readers
+    dependency::FieldLivenessAnalyzer analyzer;
+    auto plan = analyzer.analyze(*graph, fields);
+    EXPECT_FALSE(plan.sharesBuffer("tmp_a", "tmp_c"));
+
+    analyzer.setInferTransient(true);
+    plan = analyzer.analyze(*graph, fields);
+    EXPECT_TRUE(plan.sharesBuffer("tmp_a", "tmp_c"));
+}
+
+TEST_F(FieldLivenessTest, AllocateFollowsPlan) {
+    auto n0 = makeNode("k0", {}, {"tmp_a"});
+    auto n1 = makeNode("k1", {"tmp_a"}, {"tmp_b"});
+    auto n2 = makeNode("k2", {"tmp_b"}, {"tmp_c"});
+    link(n0, n1);
+    link(n1, n2);
+    auto graph = buildGraph();
+
+    std::vector<FieldDescriptor> fields = {transientField("tmp_a"), transientField("tmp_b", 3),
+                                           transientField("tmp_c", 2)};
+
+    dependency::FieldLivenessAnalyzer analyzer;
+    auto plan = analyzer.analyze(*graph, fields);
+    ASSERT_TRUE(plan.sharesBuffer("tmp_a", "tmp_c"));
+
+    auto backend = BackendFactory::createBackend(BackendChoice::MOCK);
+    backend->initialize();
+    {
+        fields::SOAFieldManager manager(backend.get());
+        auto handles = dependency::FieldLivenessAnalyzer::allocate(manager, plan, fields, 1000);
+        ASSERT_EQ(handles.size(), 3u);
+        EXPECT_TRUE(manager.sharesStorage(handles.at("tmp_a"), handles.at("tmp_c")));
+        EXPECT_FALSE(manager.sharesStorage(handles.at("tmp_a"), handles.at("tmp_b")));
+        EXPECT_EQ(manager.getAllocationSize(handles.at("tmp_c")), 1000u);
+    }
+    backend->shutdown();
+}
@@ -0,0 +1,191 @@
+#include "fluidloom/runtime/plan/SimulationPlan.h"
+#include "fluidloom/runtime/ExecutionGraph.h"
+#include "fluidloom/runtime/dependency/DependencyGraph.h"
+#include "fluidloom/runtime/nodes/HostTaskNode.h"
+#include "fluidloom/common/Hash.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+
+using namespace fluidloom;
+using namespace fluidloom::runtime;
+using fluidloom::runtime::plan::PlanNode;
+using fluidloom::runtime::plan::SimulationPlan;
+
+namespace {
+
+const char* SCRIPT = "field rho : float32;\nkernel collide { }\n";
+
+SimulationPlan makePlan() {
+    SimulationPlan plan;
+    plan.script_hash = hash::fnv1a_64(std::string(SCRIPT));
+    plan.num_cells = 4096;
+    plan.capacity = 8192;
+
+    fields::FieldDescriptor rho("rho", fields::FieldType::FLOAT32, 1);
+    rho.default_value = {1.0};
+    fields::FieldDescriptor f("f", fields::FieldType::FLOAT32, 19, 2);
+    f.is_visualization_field = false;
+    f.is_transient = true;
+    plan.fields = {rho, f};
+
+    PlanNode collide;
+    collide.name = "collide";
+    collide.level = 1;
+    collide.read_fields = {"f"};
+    collide.write_fields = {"f", "rho"};
+    collide.execution_mask = "fluid";
+    collide.kernel_source = "__kernel void collide(__global float* f) {}";
+    collide.params = {"f", "rho"};
+    collide.global_work_size = 4096;
+    collide.local_work_size = 64;
+    collide.device_signature = "Test GPU|1.0";
+    collide.binary = {0x7f, 'E', 'L', 'F', 0x00, 0xff};
+
+    PlanNode halo;
+    halo.type = nodes::ExecutionNode::NodeType::HALO_EXCHANGE;
+    halo.name = "halo_f";
+    halo.halo_depth = 2;
+    halo.read_fields = {"f"};
+    halo.halo_fields = {"f"};
+
+    PlanNode barrier;
+    barrier.type = nodes::ExecutionNode::NodeType::BARRIER;
+    barrier.name = "sync";
+    barrier.barrier_kind = 3;
+    barrier.global_barrier = true;
+
+    plan.nodes = {collide, halo, barrier};
+    plan.edges = {{0, 1}, {1, 2}};
+    return plan;
+}
+
+std::shared_ptr<nodes::ExecutionNode> hostNode(const std::string& name,
+                                               std::vector<std::string> reads,
+                                               std::vector<std::string> writes) {
+    auto node = std::make_shared<nodes::HostTaskNode>(name, [] {});
+    node->setReadFields(std::move(reads));
+    node->setWriteFields(std::move(writes));
+    return node;
+}
+
+} // namespace
+
+TEST(SimulationPlanTest, RoundTripPreservesEverything) {
+    SimulationPlan plan = makePlan();
+    SimulationPlan loaded = SimulationPlan::deserialize(plan.serialize());
+
+    EXPECT_EQ(loaded.script_hash, plan.script_hash);
+    EXPECT_EQ(loaded.num_cells, 4096u);
+    EXPECT_EQ(loaded.capacity, 8192u);
+
+    ASSERT_EQ(loaded.fields.size(), 2u);
+    EXPECT_EQ(loaded.fields[0].name, "rho");
+    EXPECT_EQ(loaded.fields[0].default_value, std::vector<double>{1.0});
+    EXPECT_EQ(loaded.fields[1].num_components, 19);
+    EXPECT_EQ(loaded.fields[1].halo_depth, 2);
+    EXPECT_TRUE(loaded.fields[1].is_transient);
+    EXPECT_FALSE(loaded.fields[1].is_visualization_field);
+
+    ASSERT_EQ(loaded.nodes.size(), 3u);
+    const PlanNode& collide = loaded.nodes[0];
+    EXPECT_EQ(collide.type, nodes::ExecutionNode::NodeType::KERNEL);
+    EXPECT_EQ(collide.level, 1);
+    EXPECT_EQ(collide.write_fields, (std::vector<std::string>{"f", "rho"}));
+    EXPECT_EQ(collide.execution_mask, "fluid");
+    EXPECT_EQ(collide.kernel_source, plan.nodes[0].kernel_source);
+    EXPECT_EQ(collide.params, plan.nodes[0].params);
+    EXPECT_EQ(collide.local_work_size, 64u);
+    EXPECT_EQ(collide.device_signature, "Test GPU|1.0");
+    EXPECT_EQ(collide.binary, plan.nodes[0].binary);
+
+    EXPECT_EQ(loaded.nodes[1].type, nodes::ExecutionNode::NodeType::HALO_EXCHANGE);
+    EXPECT_EQ(loaded.nodes[1].halo_depth, 2);
+    EXPECT_EQ(loaded.nodes[1].halo_fields, std::vector<std::string>{"f"});
+    EXPECT_EQ(loaded.nodes[2].barrier_kind, 3);
+    EXPECT_TRUE(loaded.nodes[2].global_barrier);
+
+    EXPECT_EQ(loaded.edges, plan.edges);
+}
+
+TEST(SimulationPlanTest, SaveAndLoadFile) {
+    std::string path = ::testing::TempDir() + "test.flplan";
+    makePlan().save(path);
+
+    SimulationPlan loaded = SimulationPlan::load(path);
+    EXPECT_TRUE(loaded.matchesScript(SCRIPT));
+    EXPECT_FALSE(loaded.matchesScript(std::string(SCRIPT) + "\n"));
+    EXPECT_NE(loaded.describe().find("kernel collide"), std::string::npos);
+    std::remove(path.c_str());
+
+    EXPECT_THROW(SimulationPlan::load(path), std::runtime_error);
+}
+
+TEST(SimulationPlanTest, RejectsForeignAndStaleFiles) {
+    std::string bytes = makePlan().serialize();
+
+    std::string foreign = bytes;
+    foreign[0] = 'X';
+    EXPECT_THROW(SimulationPlan::deserialize(foreign), std::runtime_error);
+
+    std::string stale = bytes;
+    stale[4] = static_cast<char>(SimulationPlan::FORMAT_VERSION + 1);
+    try {
+        SimulationPlan::deserialize(stale);
+        FAIL() << "version mismatch accepted";
+    } catch (const std::runtime_error& e) {
+        EXPECT_NE(std::string(e.what()).find("--aot"), std::string::npos);
+    }
+}
+
+TEST(SimulationPlanTest, RejectsCorruptAndTruncatedFiles) {
+    std::string bytes = makePlan().serialize();
+
+    std::string corrupt = bytes;
+    corrupt[bytes.size() / 2] ^= 0x01;
+    EXPECT_THROW(SimulationPlan::deserialize(corrupt), std::runtime_error);
+
+    for (size_t size : {size_t(0), size_t(8), bytes.size() - 1}) {
+        EXPECT_THROW(SimulationPlan::deserialize(bytes.substr(0, size)), std::runtime_error) << size;
+    }
+    EXPECT_THROW(SimulationPlan::deserialize(bytes + '\0'), std::runtime_error);
+}
+
+TEST(SimulationPlanTest, RejectsDanglingEdges) {
+    SimulationPlan plan = makePlan();
+    plan.edges.emplace_back(2, 7);
+    EXPECT_FALSE(plan.validate());
+    EXPECT_THROW(SimulationPlan::deserialize(plan.serialize()), std::runtime_error);
+}
+
+TEST(SimulationPlanTest, PrecomputedEdgesReproduceHazardAnalysis) {
+    // a writes rho, b and c read it, d overwrites rho after both reads
+    ExecutionGraph analyzed;
+    analyzed.addNode(hostNode("a", {}, {"rho"}));
+    analyzed.addNode(hostNode("b", {"rho"}, {"u"}));
+    analyzed.addNode(hostNode("c", {"rho"}, {"v"}));
+    analyzed.addNode(hostNode("d", {"u", "v"}, {"rho"}));
+    auto edges = analyzed.getDependencyEdges();
+    EXPECT_FALSE(edges.empty());
+    EXPECT_TRUE(std::is_sorted(edges.begin(), edges.end()));
+
+    ExecutionGraph restored;
+    for (const char* name : {"a", "b", "c", "d"}) {
+        restored.addNode(hostNode(name, {}, {}));
+    }
+    restored.setDependencyEdges(edges);
+    EXPECT_EQ(restored.getDependencyEdges(), edges);
+}
+
+TEST(SimulationPlanTest, SetDependencyEdgesRejectsInvalidEdges) {
+    ExecutionGraph graph;
+    graph.addNode(hostNode("a", {}, {}));
+    graph.addNode(hostNode("b", {}, {}));
+    EXPECT_THROW(graph.setDependencyEdges({{0, 2}}), std::invalid_argument);
+    EXPECT_THROW(graph.setDependencyEdges({{1, 1}}), std::invalid_argument);
+
+    ExecutionGraph cyclic;
+    cyclic.addNode(hostNode("a", {}, {}));
+    cyclic.addNode(hostNode("b", {}, {}));
+    EXPECT_THROW(cyclic.setDependencyEdges({{0, 1}, {1, 0}}), std::invalid_argument);
+}
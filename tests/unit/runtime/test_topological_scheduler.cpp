@@ -1,8 +1,11 @@
 #include "fluidloom/runtime/dependency/DependencyGraph.h"
 #include "fluidloom/runtime/scheduler/TopologicalScheduler.h"
 #include "fluidloom/runtime/nodes/KernelNode.h"
+#include "fluidloom/runtime/nodes/HostTaskNode.h"
 #include <gtest/gtest.h>
 #include <chrono>
+#include <functional>
+#include <map>
 
 using namespace fluidloom::runtime;
 
@@ -48,6 +51,26 @@ protected:
         
         return nodes;
     }
+    
+    // Node that counts its runs, with the given read/write sets
+    std::shared_ptr<nodes::ExecutionNode> createCountingNode(const std::string& name,
+                                                             std::vector<std::string> reads,
+                                                             std::vector<std::string> writes) {
+        auto node = std::make_shared<nodes::HostTaskNode>(name, [this, name] { runs[name]++; });
+        node->setId(static_cast<int64_t>(runs.size()));
+        node->setReadFields(std::move(reads));
+        node->setWriteFields(std::move(writes));
+        runs[name] = 0;
+        return node;
+    }
+    
+    static void link(const std::shared_ptr<nodes::ExecutionNode>& from,
+                     const std::shared_ptr<nodes::ExecutionNode>& to) {
+        from->addSuccessor(to);
+        to->addPredecessor(from);
+    }
+    
+    std::map<std::string, int> runs;
 };
 
 TEST_F(TopologicalSchedulerTest, SimpleDAG) {
@@ -131,3 +154,148 @@ TEST_F(TopologicalSchedulerTest, Execute) {
     scheduler::TopologicalScheduler scheduler(graph);
     EXPECT_TRUE(scheduler.execute());
 }
+
+TEST_F(TopologicalSchedulerTest, IncrementalRunsOnlyDownstreamOfChangedField) {
+    auto collide = createCountingNode("collide", {"omega"}, {"f"});
+    auto macro = createCountingNode("macro", {"f"}, {"rho"});
+    auto analysis = createCountingNode("analysis", {"rho"}, {"stats"});
+    auto geometry = createCountingNode("geometry", {"solid"}, {"mask"});
+    link(collide, macro);
+    link(macro, analysis);
+    
+    auto graph = std::make_shared<dependency::DependencyGraph>(
+        std::vector<std::shared_ptr<nodes::ExecutionNode>>{collide, macro, analysis, geometry});
+    scheduler::TopologicalScheduler scheduler(graph);
+    ASSERT_TRUE(scheduler.execute());
+    EXPECT_EQ(scheduler.getLastExecutedCount(), 4u);
+    
+    scheduler::DirtySet dirty;
+    dirty.fields = {"omega"};
+    EXPECT_EQ(scheduler.computeDirtyNodes(dirty).size(), 3u);
+    ASSERT_TRUE(scheduler.executeIncremental(dirty));
+    
+    EXPECT_EQ(scheduler.getLastExecutedCount(), 3u);
+    EXPECT_EQ(runs["collide"], 2);
+    EXPECT_EQ(runs["macro"], 2);
+    EXPECT_EQ(runs["analysis"], 2);
+    EXPECT_EQ(runs["geometry"], 1);
+}
+
+TEST_F(TopologicalSchedulerTest, IncrementalFromChangedNode) {
+    auto coarse = createCountingNode("coarse", {"f0"}, {"f0"});
+    auto fine = createCountingNode("fine", {"f1"}, {"f1"});
+    auto fence = createCountingNode("fence", {}, {});
+    auto output = createCountingNode("output", {"f0"}, {"out"});
+    link(coarse, fence);
+    link(fine, fence);
+    link(fence, output);
+    
+    auto graph = std::make_shared<dependency::DependencyGraph>(
+        std::vector<std::shared_ptr<nodes::ExecutionNode>>{coarse, fine, fence, output});
+    scheduler::TopologicalScheduler scheduler(graph);
+    ASSERT_TRUE(scheduler.execute());
+    
+    // Subcycle the fine level: the fence follows it, the coarse-only output does not
+    scheduler::DirtySet dirty;
+    dirty.node_ids = {fine->getId()};
+    ASSERT_TRUE(scheduler.executeIncremental(dirty));
+    
+    EXPECT_EQ(runs["coarse"], 1);
+    EXPECT_EQ(runs["fine"], 2);
+    EXPECT_EQ(runs["fence"], 2);
+    EXPECT_EQ(runs["output"], 1);
+}
+
+TEST_F(TopologicalSchedulerTest, IncrementalRestoresInputsOverwrittenLater) {
+    // "overwrite" follows "reader" only because it overwrites what reader
+    // reads; re-running reader needs f as init left it
+    std::map<std::string, int> values;
+    auto task = [this, &values](const std::string& name, std::vector<std::string> reads,
+                                std::vector<std::string> writes, std::function<void()> body) {
+        auto node = std::make_shared<nodes::HostTaskNode>(name, [this, name, body] { runs[name]++; body(); });
+        node->setId(static_cast<int64_t>(runs.size()));
+        node->setReadFields(std::move(reads));
+        node->setWriteFields(std::move(writes));
+        runs[name] = 0;
+        return node;
+    };
+    auto init = task("init", {"seed"}, {"f"}, [&values] { values["f"] = values["seed"]; });
+    auto reader = task("reader", {"f"}, {"g"}, [&values] { values["g"] = values["f"] * 10; });
+    auto overwrite = task("overwrite", {"h"}, {"f"}, [&values] { values["f"] = values["h"]; });
+    auto consumer = task("consumer", {"g"}, {"out"}, [&values] { values["out"] = values["g"] + 1; });
+    link(init, reader);
+    link(init, overwrite);
+    link(reader, overwrite);
+    link(reader, consumer);
+    
+    auto graph = std::make_shared<dependency::DependencyGraph>(
+        std::vector<std::shared_ptr<nodes::ExecutionNode>>{init, reader, overwrite, consumer});
+    scheduler::TopologicalScheduler scheduler(graph);
+    values = {{"seed", 1}, {"h", 5}};
+    ASSERT_TRUE(scheduler.execute());
+    EXPECT_EQ(values["out"], 11);
+    
+    scheduler::DirtySet dirty;
+    dirty.node_ids = {reader->getId()};
+    ASSERT_TRUE(scheduler.executeIncremental(dirty));
+    
+    EXPECT_EQ(scheduler.getLastExecutedCount(), 4u);
+    EXPECT_EQ(runs["init"], 2);
+    EXPECT_EQ(runs["overwrite"], 2);
+    EXPECT_EQ(values["g"], 10);
+    EXPECT_EQ(values["f"], 5);
+    EXPECT_EQ(values["out"], 11);
+}
+
+TEST_F(TopologicalSchedulerTest, IncrementalRejectsUnrecoverableOverwrittenInput) {
+    auto reader = createCountingNode("reader", {"f"}, {"g"});
+    auto overwrite = createCountingNode("overwrite", {"h"}, {"f"});
+    link(reader, overwrite);
+    
+    auto graph = std::make_shared<dependency::DependencyGraph>(
+        std::vector<std::shared_ptr<nodes::ExecutionNode>>{reader, overwrite});
+    scheduler::TopologicalScheduler scheduler(graph);
+    ASSERT_TRUE(scheduler.execute());
+    
+    scheduler::DirtySet dirty;
+    dirty.node_ids = {reader->getId()};
+    EXPECT_THROW(scheduler.computeDirtyNodes(dirty), std::runtime_error);
+}
+
+TEST_F(TopologicalSchedulerTest, IncrementalKeepsExternallyDirtiedFields) {
+    // The user changed omega after the run; its initializer must not reset it
+    auto set_omega = createCountingNode("set_omega", {}, {"omega"});
+    auto collide = createCountingNode("collide", {"omega"}, {"f"});
+    link(set_omega, collide);
+    
+    auto graph = std::make_shared<dependency::DependencyGraph>(
+        std::vector<std::shared_ptr<nodes::ExecutionNode>>{set_omega, collide});
+    scheduler::TopologicalScheduler scheduler(graph);
+    ASSERT_TRUE(scheduler.execute());
+    
+    scheduler::DirtySet dirty;
+    dirty.fields = {"omega"};
+    ASSERT_TRUE(scheduler.executeIncremental(dirty));
+    
+    EXPECT_EQ(runs["set_omega"], 1);
+    EXPECT_EQ(runs["collide"], 2);
+}
+
+TEST_F(TopologicalSchedulerTest, IncrementalBeforeFirstRunExecutesEverything) {
+    auto a = createCountingNode("a", {}, {"x"});
+    auto b = createCountingNode("b", {"x"}, {"y"});
+    link(a, b);
+    
+    auto graph = std::make_shared<dependency::DependencyGraph>(
+        std::vector<std::shared_ptr<nodes::ExecutionNode>>{a, b});
+    scheduler::TopologicalScheduler scheduler(graph);
+    
+    ASSERT_TRUE(scheduler.executeIncremental(scheduler::DirtySet{}));
+    EXPECT_EQ(runs["a"], 1);
+    EXPECT_EQ(runs["b"], 1);
+    
+    // Nothing changed: nothing runs
+    ASSERT_TRUE(scheduler.executeIncremental(scheduler::DirtySet{}));
+    EXPECT_EQ(scheduler.getLastExecutedCount(), 0u);
+    EXPECT_EQ(runs["a"], 1);
+}
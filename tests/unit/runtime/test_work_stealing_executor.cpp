@@ -0,0 +1,253 @@
+#include "fluidloom/runtime/executor/WorkStealingExecutor.h"
+#include "fluidloom/runtime/dependency/DependencyGraph.h"
+#include "fluidloom/runtime/nodes/HostTaskNode.h"
+#include "fluidloom/runtime/ExecutionGraph.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+using namespace fluidloom::runtime;
+
+namespace {
+
+// Device-affine node that completes without producing an event
+class ImmediateDeviceNode : public nodes::ExecutionNode {
+public:
+    ImmediateDeviceNode(std::string name, std::function<void()> work)
+        : ExecutionNode(NodeType::KERNEL, std::move(name)), work(std::move(work)) {}
+
+    cl_event execute(cl_event wait_event) override {
+        (void)wait_event;
+        work();
+        return nullptr;
+    }
+
+    void accept(Visitor& visitor) override { (void)visitor; }
+
+private:
+    std::function<void()> work;
+};
+
+void link(const std::shared_ptr<nodes::ExecutionNode>& from, const std::shared_ptr<nodes::ExecutionNode>& to) {
+    from->addSuccessor(to);
+    to->addPredecessor(from);
+}
+
+} // namespace
+
+class WorkStealingExecutorTest : public ::testing::Test {
+protected:
+    std::shared_ptr<nodes::ExecutionNode> makeTask(const std::string& name, int64_t id) {
+        auto node = std::make_shared<nodes::HostTaskNode>(name, [this, name] {
+            std::lock_guard<std::mutex> lock(order_mutex);
+            order.push_back(name);
+        });
+        node->setId(id);
+        return node;
+    }
+
+    size_t position(const std::string& name) const {
+        return std::find(order.begin(), order.end(), name) - order.begin();
+    }
+
+    std::mutex order_mutex;
+    std::vector<std::string> order;
+};
+
+TEST_F(WorkStealingExecutorTest, DiamondRespectsEdges) {
+    auto a = makeTask("A", 0);
+    auto b = makeTask("B", 1);
+    auto c = makeTask("C", 2);
+    auto d = makeTask("D", 3);
+    link(a, b);
+    link(a, c);
+    link(b, d);
+    link(c, d);
+
+    dependency::DependencyGraph graph({a, b, c, d});
+    executor::WorkStealingExecutor executor(4);
+    ASSERT_TRUE(executor.execute(graph));
+
+    ASSERT_EQ(order.size(), 4u);
+    EXPECT_LT(position("A"), position("B"));
+    EXPECT_LT(position("A"), position("C"));
+    EXPECT_LT(position("B"), position("D"));
+    EXPECT_LT(position("C"), position("D"));
+}
+
+TEST_F(WorkStealingExecutorTest, IndependentHostTasksOverlap) {
+    // Each task waits until the other has started; serial execution would time out
+    std::atomic<int> started{0};
+    std::atomic<bool> overlapped{true};
+    auto rendezvous = [&] {
+        started++;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (started.load() < 2) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                overlapped = false;
+                return;
+            }
+            std::this_thread::yield();
+        }
+    };
+
+    auto x = std::make_shared<nodes::HostTaskNode>("X", rendezvous);
+    auto y = std::make_shared<nodes::HostTaskNode>("Y", rendezvous);
+    x->setId(0);
+    y->setId(1);
+
+    dependency::DependencyGraph graph({x, y});
+    executor::WorkStealingExecutor executor(2);
+    ASSERT_TRUE(executor.execute(graph));
+    EXPECT_TRUE(overlapped.load());
+}
+
+TEST_F(WorkStealingExecutorTest, WideGraphRunsEveryNodeOnceAndIsReusable) {
+    // Layers of 16 independent nodes, each layer depending on the whole previous one
+    const size_t layers = 8;
+    const size_t width = 16;
+    std::vector<std::atomic<int>> runs(layers * width);
+    std::vector<std::atomic<int>> layer_done(layers);
+
+    std::vector<std::shared_ptr<nodes::ExecutionNode>> nodes;
+    for (size_t l = 0; l < layers; ++l) {
+        for (size_t w = 0; w < width; ++w) {
+            size_t idx = l * width + w;
+            auto work = [&, l, idx] {
+                if (l > 0 && layer_done[l - 1].load() != static_cast<int>(width)) {
+                    runs[idx] += 1000;  // Ran before its predecessors finished
+                }
+                runs[idx]++;
+                layer_done[l]++;
+            };
+            std::shared_ptr<nodes::ExecutionNode> node;
+            if (w % 2 == 0) {
+                node = std::make_shared<nodes::HostTaskNode>("H" + std::to_string(idx), work);
+            } else {
+                node = std::make_shared<ImmediateDeviceNode>("D" + std::to_string(idx), work);
+            }
+            node->setId(static_cast<int64_t>(idx));
+            nodes.push_back(node);
+        }
+    }
+    for (size_t l = 1; l < layers; ++l) {
+        for (size_t p = 0; p < width; ++p) {
+            for (size_t s = 0; s < width; ++s) {
+                link(nodes[(l - 1) * width + p], nodes[l * width + s]);
+            }
+        }
+    }
+
+    dependency::DependencyGraph graph(nodes);
+    executor::WorkStealingExecutor executor(4);
+
+    for (int pass = 1; pass <= 2; ++pass) {
+        for (auto& done : layer_done) done = 0;
+        ASSERT_TRUE(executor.execute(graph));
+        for (size_t i = 0; i < runs.size(); ++i) {
+            EXPECT_EQ(runs[i].load(), pass) << "Node " << i;
+        }
+    }
+}
+
+TEST_F(WorkStealingExecutorTest, ExceptionSkipsDependentsAndPropagates) {
+    auto a = makeTask("A", 0);
+    auto boom = std::make_shared<nodes::HostTaskNode>("Boom", [] {
+        throw std::runtime_error("host task failed");
+    });
+    boom->setId(1);
+    auto c = makeTask("C", 2);
+    link(a, boom);
+    link(boom, c);
+
+    dependency::DependencyGraph graph({a, boom, c});
+    executor::WorkStealingExecutor executor(2);
+    EXPECT_THROW(executor.execute(graph), std::runtime_error);
+
+    ASSERT_EQ(order.size(), 1u);
+    EXPECT_EQ(order[0], "A");
+
+    // The executor stays usable after a failed run
+    order.clear();
+    auto d = makeTask("D", 0);
+    dependency::DependencyGraph next({d});
+    EXPECT_TRUE(executor.execute(next));
+    EXPECT_EQ(order.size(), 1u);
+}
+
+TEST_F(WorkStealingExecutorTest, ExecutionGraphDerivesHazardEdges) {
+    auto writer = makeTask("write_rho", -1);
+    writer->setWriteFields({"rho"});
+    auto other = makeTask("write_u", -1);
+    other->setWriteFields({"u"});
+    auto reader = makeTask("read_rho", -1);
+    reader->setReadFields({"rho"});
+    auto fence = makeTask("fence", -1);
+    auto after = makeTask("read_u", -1);
+    after->setReadFields({"u"});
+
+    ExecutionGraph graph;
+    graph.addNode(writer);
+    graph.addNode(other);
+    graph.addNode(reader);
+    graph.addNode(fence);
+    graph.addNode(after);
+
+    executor::WorkStealingExecutor executor(4);
+    ASSERT_TRUE(graph.execute(executor));
+
+    ASSERT_EQ(order.size(), 5u);
+    EXPECT_LT(position("write_rho"), position("read_rho"));
+    EXPECT_LT(position("write_u"), position("read_u"));
+    EXPECT_LT(position("write_rho"), position("fence"));
+    EXPECT_LT(position("write_u"), position("fence"));
+    EXPECT_LT(position("read_rho"), position("fence"));
+    EXPECT_LT(position("fence"), position("read_u"));
+}
+
+TEST_F(WorkStealingExecutorTest, RebuildReplacesNodeEdges) {
+    auto writer = makeTask("write_rho", -1);
+    writer->setWriteFields({"rho"});
+    auto reader = makeTask("read_rho", -1);
+    reader->setReadFields({"rho"});
+
+    ExecutionGraph graph;
+    graph.addNode(writer);
+    graph.addNode(reader);
+    EXPECT_EQ(graph.getDependencyEdges().size(), 1u);
+
+    // addNode() invalidates the DAG; the rebuild must not keep the old edges
+    auto other = makeTask("write_u", -1);
+    other->setWriteFields({"u"});
+    graph.addNode(other);
+    EXPECT_EQ(graph.getDependencyEdges().size(), 1u);
+    EXPECT_EQ(writer->getSuccessors().size(), 1u);
+    EXPECT_EQ(reader->getPredecessors().size(), 1u);
+
+    // Precomputed edges replace the derived ones
+    graph.setDependencyEdges({{1, 2}});
+    EXPECT_TRUE(writer->getSuccessors().empty());
+    EXPECT_TRUE(reader->getPredecessors().empty());
+    EXPECT_EQ(reader->getSuccessors().size(), 1u);
+    EXPECT_EQ(other->getPredecessors().size(), 1u);
+}
+
+TEST_F(WorkStealingExecutorTest, RecordsHostExecutionTime) {
+    auto node = std::make_shared<nodes::HostTaskNode>("sleep", [] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    });
+    node->setId(0);
+    node->enableProfiling();
+
+    dependency::DependencyGraph graph({node});
+    executor::WorkStealingExecutor executor(1);
+    ASSERT_TRUE(executor.execute(graph));
+
+    EXPECT_GE(node->getEstimatedTime(), 4.0);
+    EXPECT_GE(executor.getLastExecutionTime(), 4.0);
+}
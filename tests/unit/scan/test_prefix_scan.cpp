@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+#include "fluidloom/core/backend/OpenCLBackend.h"
+#include "fluidloom/core/scan/PrefixScan.h"
+#include <random>
+#include <vector>
+
+using namespace fluidloom;
+using namespace fluidloom::scan;
+
+namespace {
+
+std::vector<uint32_t> randomCounts(size_t n, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<uint32_t> dist(0, 9);
+    std::vector<uint32_t> values(n);
+    for (auto& v : values) v = dist(gen);
+    return values;
+}
+
+// Sizes around every multiple of tile up to `tiles` tiles
+std::vector<size_t> boundarySizes(size_t tile, size_t tiles) {
+    std::vector<size_t> sizes = {0, 1};
+    for (size_t t = 1; t <= tiles; ++t) {
+        sizes.push_back(t * tile - 1);
+        sizes.push_back(t * tile);
+        sizes.push_back(t * tile + 1);
+    }
+    return sizes;
+}
+
+} // namespace
+
+TEST(PrefixScanTest, HostReferenceIsExclusiveAndInPlace) {
+    std::vector<uint32_t> values = {3, 0, 8, 8, 1, 0, 8};
+    std::vector<uint32_t> out(values.size());
+    EXPECT_EQ(PrefixScan::exclusiveScanHost(values.data(), out.data(), values.size()), 28u);
+    EXPECT_EQ(out, (std::vector<uint32_t>{0, 3, 3, 11, 19, 20, 20}));
+
+    EXPECT_EQ(PrefixScan::exclusiveScanHost(values.data(), values.data(), values.size()), 28u);
+    EXPECT_EQ(values, out);
+
+    EXPECT_EQ(PrefixScan::exclusiveScanHost(nullptr, nullptr, 0), 0u);
+}
+
+TEST(PrefixScanTest, TiledPassesMatchReferenceAtEveryBoundary) {
+    // Every size up to several tiles, and past tile*tile where the tile-sum
+    // scan needs more than one chunk
+    for (size_t tile : {1u, 2u, 3u, 4u, 8u}) {
+        const size_t max_n = tile * tile * 3 + tile + 2;
+        const auto values = randomCounts(max_n, static_cast<unsigned>(tile));
+        for (size_t n = 0; n <= max_n; ++n) {
+            std::vector<uint32_t> expected(n), actual(n);
+            const uint32_t expected_total = PrefixScan::exclusiveScanHost(values.data(), expected.data(), n);
+            ASSERT_EQ(PrefixScan::exclusiveScanTiled(values.data(), actual.data(), n, tile), expected_total)
+                << "tile " << tile << ", n " << n;
+            ASSERT_EQ(actual, expected) << "tile " << tile << ", n " << n;
+        }
+    }
+    EXPECT_THROW(PrefixScan::exclusiveScanTiled(nullptr, nullptr, 0, 0), std::invalid_argument);
+}
+
+TEST(PrefixScanTest, TiledPassesAtDeviceTileSize) {
+    const size_t tile = PrefixScan::TILE_SIZE;
+    for (size_t n : boundarySizes(tile, 4)) {
+        auto values = randomCounts(n, 7);
+        std::vector<uint32_t> expected(n);
+        const uint32_t total = PrefixScan::exclusiveScanHost(values.data(), expected.data(), n);
+        // In place, like MergeEngine's group numbering
+        EXPECT_EQ(PrefixScan::exclusiveScanTiled(values.data(), values.data(), n, tile), total);
+        EXPECT_EQ(values, expected) << "n " << n;
+    }
+    EXPECT_EQ(PrefixScan::numTiles(0), 0u);
+    EXPECT_EQ(PrefixScan::numTiles(tile), 1u);
+    EXPECT_EQ(PrefixScan::numTiles(tile + 1), 2u);
+}
+
+TEST(PrefixScanTest, SumsWrapModulo32Bits) {
+    std::vector<uint32_t> values = {0xFFFFFFF0u, 0x20u, 1u};
+    std::vector<uint32_t> out(values.size());
+    EXPECT_EQ(PrefixScan::exclusiveScanTiled(values.data(), out.data(), values.size(), 2), 0x11u);
+    EXPECT_EQ(out, (std::vector<uint32_t>{0u, 0xFFFFFFF0u, 0x10u}));
+}
+
+TEST(PrefixScanDeviceTest, MatchesReferenceAtWorkGroupBoundaries) {
+    OpenCLBackend backend;
+    try {
+        backend.initialize(0);
+    } catch (const std::exception& e) {
+        GTEST_SKIP() << "No OpenCL device: " << e.what();
+    }
+    PrefixScan scan(backend.getContext(), backend.getQueue());
+    cl_command_queue queue = backend.getQueue();
+
+    // Tile boundaries, plus sizes whose tile count crosses a chunk of the tile-sum scan
+    const size_t tile = PrefixScan::TILE_SIZE;
+    auto sizes = boundarySizes(tile, 3);
+    for (size_t n : {tile * tile - 1, tile * tile, tile * tile + 1, tile * tile + tile + 1}) {
+        sizes.push_back(n);
+    }
+
+    for (size_t n : sizes) {
+        if (n == 0) continue;
+        const auto values = randomCounts(n, static_cast<unsigned>(n));
+        std::vector<uint32_t> expected(n);
+        const uint32_t expected_total = PrefixScan::exclusiveScanHost(values.data(), expected.data(), n);
+
+        cl_int err;
+        cl_mem input = clCreateBuffer(backend.getContext(), CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+                                      n * sizeof(uint32_t), const_cast<uint32_t*>(values.data()), &err);
+        ASSERT_EQ(err, CL_SUCCESS);
+        cl_mem output = clCreateBuffer(backend.getContext(), CL_MEM_READ_WRITE, n * sizeof(uint32_t), nullptr, &err);
+        ASSERT_EQ(err, CL_SUCCESS);
+
+        uint32_t total = 0;
+        scan.exclusiveScan(input, output, n, &total);
+        std::vector<uint32_t> actual(n);
+        clEnqueueReadBuffer(queue, output, CL_TRUE, 0, n * sizeof(uint32_t), actual.data(), 0, nullptr, nullptr);
+        EXPECT_EQ(total, expected_total) << "n " << n;
+        EXPECT_EQ(actual, expected) << "n " << n;
+
+        // In place
+        scan.exclusiveScan(input, input, n, &total);
+        clEnqueueReadBuffer(queue, input, CL_TRUE, 0, n * sizeof(uint32_t), actual.data(), 0, nullptr, nullptr);
+        EXPECT_EQ(total, expected_total) << "n " << n;
+        EXPECT_EQ(actual, expected) << "n " << n;
+
+        clReleaseMemObject(input);
+        clReleaseMemObject(output);
+    }
+}
+
+TEST(PrefixScanDeviceTest, TotalStaysOnDevice) {
+    OpenCLBackend backend;
+    try {
+        backend.initialize(0);
+    } catch (const std::exception& e) {
+        GTEST_SKIP() << "No OpenCL device: " << e.what();
+    }
+    PrefixScan scan(backend.getContext(), backend.getQueue());
+    cl_command_queue queue = backend.getQueue();
+
+    const size_t n = PrefixScan::TILE_SIZE * 2 + 5;
+    const auto values = randomCounts(n, 11);
+    std::vector<uint32_t> expected(n);
+    const uint32_t expected_total = PrefixScan::exclusiveScanHost(values.data(), expected.data(), n);
+
+    cl_int err;
+    cl_mem input = clCreateBuffer(backend.getContext(), CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+                                  n * sizeof(uint32_t), const_cast<uint32_t*>(values.data()), &err);
+    ASSERT_EQ(err, CL_SUCCESS);
+    std::vector<uint32_t> counters = {7u, 7u, 7u};
+    cl_mem totals = clCreateBuffer(backend.getContext(), CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+                                   counters.size() * sizeof(uint32_t), counters.data(), &err);
+    ASSERT_EQ(err, CL_SUCCESS);
+
+    // Totals land in their slots and leave the neighbours alone
+    scan.exclusiveScan(input, input, n, totals, 1);
+    scan.exclusiveScan(input, input, 0, totals, 2);
+    clEnqueueReadBuffer(queue, totals, CL_TRUE, 0, counters.size() * sizeof(uint32_t), counters.data(), 0, nullptr, nullptr);
+    EXPECT_EQ(counters, (std::vector<uint32_t>{7u, expected_total, 0u}));
+
+    std::vector<uint32_t> actual(n);
+    clEnqueueReadBuffer(queue, input, CL_TRUE, 0, n * sizeof(uint32_t), actual.data(), 0, nullptr, nullptr);
+    EXPECT_EQ(actual, expected);
+
+    clReleaseMemObject(input);
+    clReleaseMemObject(totals);
+}
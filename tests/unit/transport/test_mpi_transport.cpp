@@ -68,3 +68,23 @@ TEST_F(MPITransportTest, Stats) {
     EXPECT_EQ(stats.num_messages_sent, 1);
     EXPECT_EQ(stats.bytes_sent, 1024);
 }
+
+TEST_F(MPITransportTest, TransferMethodFollowsLinkMatrix) {
+    // Without a probed topology everything leaves through the host
+    EXPECT_EQ(transport->getTransferMethod(0, 4096), PeerAccessManager::CopyMethod::STAGING_HOST);
+
+    // Two ranks on one node joined by a low-latency, low-bandwidth peer link
+    std::vector<cl_device_id> devices = {reinterpret_cast<cl_device_id>(0x1000),
+                                         reinterpret_cast<cl_device_id>(0x1001)};
+    PeerAccessManager::LinkMatrix links(2, std::vector<PeerAccessManager::LinkProfile>(2));
+    links[0][1] = links[1][0] = {5.0, 4.0};
+    std::vector<PeerAccessManager::LinkProfile> host_links(2, {10.0, 12.0});
+    transport->setPeerAccessManager(std::make_unique<PeerAccessManager>(devices, links, host_links),
+                                    devices[0], devices);
+
+    EXPECT_EQ(transport->getTransferMethod(1, 4096), PeerAccessManager::CopyMethod::P2P);
+    EXPECT_EQ(transport->getTransferMethod(1, 64u << 20), PeerAccessManager::CopyMethod::STAGING_HOST);
+
+    // Ranks whose device is unknown (other nodes) go off-device
+    EXPECT_EQ(transport->getTransferMethod(7, 4096), PeerAccessManager::CopyMethod::STAGING_HOST);
+}
@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+#include "fluidloom/transport/PayloadCodec.h"
+#include "fluidloom/transport/CompressionPolicy.h"
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace fluidloom::transport;
+
+namespace {
+
+// Smooth density-like field (1 + 1% variation) on a 64^3 block, advanced by `time`
+std::vector<uint8_t> smoothPayload(float time) {
+    const int n = 64;
+    std::vector<float> values(n * n * n);
+    for (int z = 0; z < n; ++z) {
+        for (int y = 0; y < n; ++y) {
+            for (int x = 0; x < n; ++x) {
+                values[(z * n + y) * n + x] =
+                    1.0f + 0.01f * std::sin(0.1f * x + time) * std::cos(0.07f * y) * std::cos(0.05f * z + 0.3f);
+            }
+        }
+    }
+    std::vector<uint8_t> bytes(values.size() * sizeof(float));
+    std::memcpy(bytes.data(), values.data(), bytes.size());
+    return bytes;
+}
+
+std::vector<uint8_t> randomBytes(size_t size, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> bytes(size);
+    for (auto& b : bytes) b = static_cast<uint8_t>(rng());
+    return bytes;
+}
+
+double ratio(const std::vector<uint8_t>& raw, const std::vector<uint8_t>& frame) {
+    return static_cast<double>(raw.size()) / static_cast<double>(frame.size());
+}
+
+} // namespace
+
+TEST(PayloadCodecTest, ShuffleRoundTripsWithTail) {
+    auto bytes = randomBytes(4 * 1000 + 3, 1);
+    std::vector<uint8_t> shuffled(bytes.size());
+    std::vector<uint8_t> restored(bytes.size());
+    PayloadCodec::shuffle(bytes.data(), bytes.size(), shuffled.data());
+    EXPECT_EQ(shuffled[1], bytes[4]);       // Plane 0 holds byte 0 of every word
+    EXPECT_EQ(shuffled[1000], bytes[1]);
+    PayloadCodec::unshuffle(shuffled.data(), shuffled.size(), restored.data());
+    EXPECT_EQ(restored, bytes);
+}
+
+TEST(PayloadCodecTest, LzRoundTripsRunsAndRejectsMalformedInput) {
+    std::vector<uint8_t> runs;
+    for (int block = 0; block < 300; ++block) {
+        runs.insert(runs.end(), 40 + block % 7, static_cast<uint8_t>(block % 5));
+        runs.push_back(static_cast<uint8_t>(block));
+    }
+    std::vector<uint8_t> compressed(runs.size());
+    const size_t size = PayloadCodec::lzCompress(runs.data(), runs.size(), compressed.data(), compressed.size());
+    ASSERT_GT(size, 0u);
+    EXPECT_LT(size * 4, runs.size());
+
+    std::vector<uint8_t> restored(runs.size());
+    EXPECT_EQ(PayloadCodec::lzDecompress(compressed.data(), size, restored.data(), restored.size()), runs.size());
+    EXPECT_EQ(restored, runs);
+
+    // Truncated stream, or too little room for the output
+    EXPECT_THROW(PayloadCodec::lzDecompress(compressed.data(), size / 2, restored.data(), restored.size()),
+                 std::runtime_error);
+    EXPECT_THROW(PayloadCodec::lzDecompress(compressed.data(), size, restored.data(), runs.size() / 2),
+                 std::runtime_error);
+
+    // Random data does not fit in less than its own size
+    auto noise = randomBytes(4096, 2);
+    std::vector<uint8_t> out(noise.size() - 1);
+    EXPECT_EQ(PayloadCodec::lzCompress(noise.data(), noise.size(), out.data(), out.size()), 0u);
+}
+
+TEST(PayloadCodecTest, SmoothFieldsCompressLosslessly) {
+    const auto previous = smoothPayload(0.0f);
+    const auto current = smoothPayload(0.01f);
+
+    auto plain = PayloadCodec::encode(current.data(), current.size(), nullptr, 0);
+    auto delta = PayloadCodec::encode(current.data(), current.size(), previous.data(), 41);
+    EXPECT_GT(ratio(current, plain), 1.8);
+    EXPECT_GT(ratio(current, delta), ratio(current, plain));
+
+    EXPECT_EQ(PayloadCodec::decode(plain.data(), plain.size(), nullptr, 0, 0), current);
+    EXPECT_EQ(PayloadCodec::decode(delta.data(), delta.size(), previous.data(), previous.size(), 41), current);
+
+    // The decoder must hold the reference the encoder used
+    EXPECT_THROW(PayloadCodec::decode(delta.data(), delta.size(), previous.data(), previous.size(), 40),
+                 std::runtime_error);
+    EXPECT_THROW(PayloadCodec::decode(delta.data(), delta.size(), nullptr, 0, 41), std::runtime_error);
+}
+
+TEST(PayloadCodecTest, IncompressiblePayloadIsStored) {
+    auto noise = randomBytes(10000, 3);
+    auto frame = PayloadCodec::encode(noise.data(), noise.size(), nullptr, 0);
+    ASSERT_LE(frame.size(), PayloadCodec::maxFrameBytes(noise.size()));
+
+    CodecFrameHeader header;
+    std::memcpy(&header, frame.data(), sizeof(header));
+    EXPECT_EQ(header.flags, 0);
+    EXPECT_TRUE(PayloadCodec::isFrame(frame.data(), frame.size()));
+    EXPECT_EQ(PayloadCodec::decode(frame.data(), frame.size(), nullptr, 0, 0), noise);
+}
+
+TEST(PayloadCodecTest, CorruptionIsDetected) {
+    const auto payload = smoothPayload(0.5f);
+    auto frame = PayloadCodec::encode(payload.data(), payload.size(), nullptr, 0);
+
+    auto flipped = frame;
+    flipped[sizeof(CodecFrameHeader) + flipped.size() / 2] ^= 0x10;
+    EXPECT_THROW(PayloadCodec::decode(flipped.data(), flipped.size(), nullptr, 0, 0), std::runtime_error);
+
+    EXPECT_THROW(PayloadCodec::decode(frame.data(), frame.size() - 1, nullptr, 0, 0), std::runtime_error);
+
+    auto bad_magic = frame;
+    bad_magic[0] ^= 1;
+    EXPECT_FALSE(PayloadCodec::isFrame(bad_magic.data(), bad_magic.size()));
+    EXPECT_THROW(PayloadCodec::decode(bad_magic.data(), bad_magic.size(), nullptr, 0, 0), std::runtime_error);
+}
+
+TEST(CompressionPolicyTest, CompressesOnlyWhereTheLinkIsTheBottleneck) {
+    CompressionPolicy::Config config;
+    config.enabled = true;
+    config.probe_interval = 4;
+    CompressionPolicy policy(config);
+    const size_t bytes = 4u << 20;
+
+    // Unknown link: raw
+    EXPECT_FALSE(policy.shouldCompress(1, bytes));
+
+    // Cross-rack peer at 1 GB/s, intra-node peer at 50 GB/s
+    policy.setLinkProfile(1, {20.0, 1.0});
+    policy.setLinkProfile(2, {5.0, 50.0});
+
+    // First payloads are probes that measure ratio and codec speed
+    EXPECT_TRUE(policy.shouldCompress(1, bytes));
+    policy.recordEncode(1, bytes, bytes / 3, bytes / 4e9);
+    policy.recordDecode(bytes, bytes / 8e9);
+    EXPECT_TRUE(policy.shouldCompress(2, bytes));
+    policy.recordEncode(2, bytes, bytes / 3, bytes / 4e9);
+
+    EXPECT_LT(policy.compressedCostUs(1, bytes), policy.rawCostUs(1, bytes));
+    EXPECT_GT(policy.compressedCostUs(2, bytes), policy.rawCostUs(2, bytes));
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_TRUE(policy.shouldCompress(1, bytes));
+    }
+    EXPECT_TRUE(policy.getEstimate(1).compressing);
+
+    // The fast peer stays raw apart from periodic probes
+    int compressed = 0;
+    for (int i = 0; i < 8; ++i) {
+        compressed += policy.shouldCompress(2, bytes) ? 1 : 0;
+    }
+    EXPECT_EQ(compressed, 2);
+    EXPECT_FALSE(policy.getEstimate(2).compressing);
+
+    // Small payloads are latency-bound
+    EXPECT_FALSE(policy.shouldCompress(1, 1024));
+
+    // A measured slow-down of the fast link turns compression on
+    for (int i = 0; i < 30; ++i) {
+        policy.recordTransfer(2, bytes, 5e-6 + bytes / 0.5e9);
+    }
+    EXPECT_NEAR(policy.getEstimate(2).link.bandwidth_gbps, 0.5, 0.05);
+    EXPECT_TRUE(policy.shouldCompress(2, bytes));
+    EXPECT_TRUE(policy.getEstimate(2).compressing);
+
+    CompressionPolicy disabled;
+    EXPECT_FALSE(disabled.shouldCompress(1, bytes));
+}
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+#include "fluidloom/transport/PeerAccessManager.h"
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace fluidloom::transport;
+
+namespace {
+
+using CopyMethod = PeerAccessManager::CopyMethod;
+using LinkProfile = PeerAccessManager::LinkProfile;
+
+cl_device_id fakeDevice(uintptr_t i) {
+    return reinterpret_cast<cl_device_id>(0x1000 + i);
+}
+
+/**
+ * Two dual-GPU boards: 0<->1 and 2<->3 are fast bridged pairs, the cross-board
+ * link 0<->2 / 0<->3 goes through the PCIe root complex and is slow, while
+ * 1<->3 has a fast switch between them. Device 4 has no peer links at all.
+ */
+class PeerRoutingTest : public ::testing::Test {
+protected:
+    static constexpr size_t N = 5;
+    std::vector<cl_device_id> devices;
+    PeerAccessManager::LinkMatrix links;
+    std::vector<LinkProfile> host_links;
+
+    void SetUp() override {
+        for (size_t i = 0; i < N; ++i) devices.push_back(fakeDevice(i));
+        links.assign(N, std::vector<LinkProfile>(N));
+
+        auto link = [this](size_t a, size_t b, double latency_us, double bandwidth_gbps) {
+            links[a][b] = {latency_us, bandwidth_gbps};
+            links[b][a] = {latency_us, bandwidth_gbps};
+        };
+        link(0, 1, 5.0, 50.0);
+        link(2, 3, 5.0, 50.0);
+        link(1, 3, 10.0, 40.0);
+        link(0, 2, 8.0, 4.0);
+        link(0, 3, 8.0, 4.0);
+        link(1, 2, 8.0, 4.0);
+
+        host_links.assign(N, LinkProfile{10.0, 12.0});
+    }
+};
+
+TEST_F(PeerRoutingTest, SmallMessagesTakeLowestLatencyLink) {
+    PeerAccessManager manager(devices, links, host_links);
+
+    // 8 us over the slow peer link beats 15 us via device 1 and 20 us of staging
+    auto route = manager.getRoute(devices[0], devices[3], 4096);
+    EXPECT_TRUE(route.isDirect());
+    EXPECT_EQ(route.method(), CopyMethod::P2P);
+    EXPECT_DOUBLE_EQ(route.estimated_us, 8.0 + 4096 / 4e3);
+    EXPECT_EQ(manager.getOptimalMethod(devices[0], devices[3], 4096), CopyMethod::P2P);
+}
+
+TEST_F(PeerRoutingTest, BulkTransfersRelayThroughFastPeer) {
+    PeerAccessManager manager(devices, links, host_links);
+
+    // 0 -> 1 -> 3 over the bridge and the switch beats both the 4 GB/s
+    // cross-board link and staging through the host
+    const size_t bytes = 64u << 20;
+    auto route = manager.getRoute(devices[0], devices[3], bytes);
+    ASSERT_EQ(route.hops.size(), 3u);
+    EXPECT_EQ(route.hops[0], devices[0]);
+    EXPECT_EQ(route.hops[1], devices[1]);
+    EXPECT_EQ(route.hops[2], devices[3]);
+    EXPECT_EQ(route.legs, (std::vector<CopyMethod>{CopyMethod::P2P, CopyMethod::P2P}));
+    EXPECT_DOUBLE_EQ(route.estimated_us, links[0][1].costUs(bytes) + links[1][3].costUs(bytes));
+    EXPECT_LT(route.estimated_us, 2 * host_links[0].costUs(bytes));
+    EXPECT_EQ(manager.getOptimalMethod(devices[0], devices[3], bytes), CopyMethod::P2P);
+
+    // The bridged pair stays direct at any size
+    EXPECT_TRUE(manager.getRoute(devices[0], devices[1], bytes).isDirect());
+}
+
+TEST_F(PeerRoutingTest, MaxLegsLimitsRelays) {
+    PeerAccessManager manager(devices, links, host_links);
+    manager.setMaxLegs(1);
+    EXPECT_EQ(manager.getMaxLegs(), 1u);
+
+    // Without relays, host staging (2 x 12 GB/s) beats the 4 GB/s direct link
+    const size_t bytes = 64u << 20;
+    auto route = manager.getRoute(devices[0], devices[3], bytes);
+    EXPECT_TRUE(route.isDirect());
+    EXPECT_EQ(route.method(), CopyMethod::STAGING_HOST);
+    EXPECT_DOUBLE_EQ(route.estimated_us, 2 * host_links[0].costUs(bytes));
+
+    manager.setMaxLegs(0);
+    EXPECT_EQ(manager.getMaxLegs(), 1u);
+}
+
+TEST_F(PeerRoutingTest, DevicesWithoutPeerLinksStageThroughHost) {
+    PeerAccessManager manager(devices, links, host_links);
+
+    EXPECT_FALSE(manager.isPeerAccessible(devices[0], devices[4]));
+    EXPECT_EQ(manager.getOptimalMethod(devices[0], devices[4], 4096), CopyMethod::STAGING_HOST);
+    EXPECT_EQ(manager.getOptimalMethod(devices[4], devices[1], 64u << 20), CopyMethod::STAGING_HOST);
+
+    // No relay can help a device that has no peer links
+    EXPECT_TRUE(manager.getRoute(devices[4], devices[1], 64u << 20).isDirect());
+}
+
+TEST_F(PeerRoutingTest, LegacyQueriesFollowMatrix) {
+    PeerAccessManager manager(devices, links, host_links);
+
+    EXPECT_TRUE(manager.isPeerAccessible(devices[0], devices[1]));
+    EXPECT_FALSE(manager.isPeerAccessible(devices[0], devices[0]));
+    EXPECT_EQ(manager.getOptimalMethod(devices[0], devices[1]), CopyMethod::P2P);
+    EXPECT_EQ(manager.getOptimalMethod(devices[0], devices[4]), CopyMethod::STAGING_HOST);
+
+    // Unknown devices fall back on the capability check
+    auto unknown = manager.getRoute(fakeDevice(99), devices[0], 4096);
+    EXPECT_EQ(unknown.method(), CopyMethod::STAGING_HOST);
+    EXPECT_DOUBLE_EQ(unknown.estimated_us, 0.0);
+}
+
+TEST_F(PeerRoutingTest, LinkMatrixCacheRoundTrip) {
+    PeerAccessManager probed(devices, links, host_links);
+    std::string path = ::testing::TempDir() + "peer_links_roundtrip.txt";
+    ASSERT_TRUE(probed.saveLinkMatrix(path));
+
+    PeerAccessManager restored(devices, PeerAccessManager::LinkMatrix(N, std::vector<LinkProfile>(N)), {});
+    EXPECT_FALSE(restored.isPeerAccessible(devices[0], devices[1]));
+    ASSERT_TRUE(restored.loadLinkMatrix(path));
+
+    EXPECT_TRUE(restored.isPeerAccessible(devices[0], devices[1]));
+    EXPECT_DOUBLE_EQ(restored.getLinkProfile(devices[1], devices[3]).bandwidth_gbps, 40.0);
+    EXPECT_DOUBLE_EQ(restored.getHostLinkProfile(devices[2]).latency_us, 10.0);
+
+    EXPECT_EQ(restored.getRoute(devices[0], devices[3], 64u << 20).hops.size(), 3u);
+
+    // Saved by rename: no temporary file is left next to the cache
+    size_t entries = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(::testing::TempDir())) {
+        if (entry.path().filename().string().rfind("peer_links_roundtrip.txt", 0) == 0) ++entries;
+    }
+    EXPECT_EQ(entries, 1u);
+
+    // A cache written for another device set is rejected
+    std::vector<cl_device_id> fewer(devices.begin(), devices.begin() + 2);
+    PeerAccessManager other(fewer, PeerAccessManager::LinkMatrix(2, std::vector<LinkProfile>(2)), {});
+    EXPECT_FALSE(other.loadLinkMatrix(path));
+    std::remove(path.c_str());
+}
+
+TEST_F(PeerRoutingTest, RejectsMalformedMatrix) {
+    links.pop_back();
+    EXPECT_THROW(PeerAccessManager(devices, links, host_links), std::invalid_argument);
+}
+
+} // namespace
@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include "TraceAnalyzer.h"
+#include <cstdio>
+#include <fstream>
+
+using namespace fluidloom::profiling;
+
+/**
+ * @brief Trace analysis over hand-built Profiler traces
+ *
+ * Two steps of 100 us on one rank: a worker thread runs collide and stream
+ * kernels, the halo thread exchanges with two peers, and peer 3 is slow.
+ */
+namespace {
+
+const char* TWO_STEP_TRACE = R"([
+  {"name": "step", "cat": "step", "ph": "B", "ts": 0, "pid": 1, "tid": 10},
+  {"name": "collide", "cat": "kernel", "ph": "X", "ts": 0, "dur": 40, "pid": 1, "tid": 11},
+  {"name": "halo_f", "cat": "halo", "ph": "B", "ts": 10, "pid": 1, "tid": 12},
+  {"name": "halo_wait", "cat": "halo", "ph": "B", "ts": 30, "args": {"peer": "1"}, "pid": 1, "tid": 12},
+  {"name": "halo_wait", "cat": "halo", "ph": "E", "ts": 35, "pid": 1, "tid": 12},
+  {"name": "halo_wait", "cat": "halo", "ph": "B", "ts": 35, "args": {"peer": "3"}, "pid": 1, "tid": 12},
+  {"name": "halo_wait", "cat": "halo", "ph": "E", "ts": 60, "pid": 1, "tid": 12},
+  {"name": "halo_f", "cat": "halo", "ph": "E", "ts": 60, "pid": 1, "tid": 12},
+  {"name": "stream", "cat": "kernel", "ph": "X", "ts": 60, "dur": 40, "pid": 1, "tid": 11},
+  {"name": "step", "cat": "step", "ph": "E", "ts": 100, "pid": 1, "tid": 10},
+  {"name": "step", "cat": "step", "ph": "X", "ts": 100, "dur": 100, "pid": 1, "tid": 10},
+  {"name": "collide", "cat": "kernel", "ph": "X", "ts": 100, "dur": 90, "pid": 1, "tid": 11},
+  {"name": "halo_f", "cat": "halo", "ph": "X", "ts": 110, "dur": 20, "pid": 1, "tid": 12},
+  {"name": "halo_wait", "cat": "halo", "ph": "X", "ts": 110, "dur": 20, "args": {"peer": "3"}, "pid": 1, "tid": 12},
+  {"name": "stats", "cat": "host", "ph": "X", "ts": 190, "dur": 10, "pid": 1, "tid": 11}
+])";
+
+} // namespace
+
+TEST(TraceDataTest, MatchesBeginEndPairsPerThread) {
+    TraceData trace = TraceData::parse(TWO_STEP_TRACE);
+    EXPECT_EQ(trace.spans.size(), 11u);
+    EXPECT_EQ(trace.unmatched_events, 0u);
+
+    size_t waits = 0;
+    for (const auto& span : trace.spans) {
+        if (span.name != "halo_wait") continue;
+        ++waits;
+        EXPECT_EQ(span.args.count("peer"), 1u);
+        EXPECT_GT(span.duration(), 0.0);
+    }
+    EXPECT_EQ(waits, 3u);
+}
+
+TEST(TraceDataTest, AcceptsTraceEventsObjectAndCountsUnmatched) {
+    TraceData trace = TraceData::parse(R"({"traceEvents": [
+        {"name": "a", "cat": "kernel", "ph": "B", "ts": 0, "pid": 0, "tid": 18446744073709551615},
+        {"name": "b", "cat": "kernel", "ph": "E", "ts": 5, "pid": 0, "tid": 18446744073709551615},
+        {"name": "m", "ph": "M", "pid": 0, "tid": 0, "args": {"name": "main"}}
+    ], "displayTimeUnit": "ms"})");
+    EXPECT_TRUE(trace.spans.empty());
+    EXPECT_EQ(trace.unmatched_events, 2u);
+
+    EXPECT_THROW(TraceData::parse("[{\"name\": \"a\""), std::runtime_error);
+    EXPECT_THROW(TraceData::parse("{\"events\": []}"), std::runtime_error);
+    EXPECT_THROW(TraceData::load("/nonexistent/trace.json"), std::runtime_error);
+}
+
+TEST(TraceAnalyzerTest, OverlapAndCriticalPathPerStep) {
+    TraceSummary summary = TraceAnalyzer().analyze(TraceData::parse(TWO_STEP_TRACE));
+    ASSERT_EQ(summary.steps.size(), 2u);
+
+    // Step 0: compute [0,40)+[60,100), communication [10,60): 30 of 50 us hidden
+    const StepReport& first = summary.steps[0];
+    EXPECT_DOUBLE_EQ(first.duration_us, 100.0);
+    EXPECT_DOUBLE_EQ(first.compute_us, 80.0);
+    EXPECT_DOUBLE_EQ(first.communication_us, 50.0);
+    EXPECT_DOUBLE_EQ(first.overlap_us, 30.0);
+    EXPECT_DOUBLE_EQ(first.overlap_ratio, 0.6);
+
+    // stream waits for the halo, which outlasts collide
+    ASSERT_EQ(first.critical_path.size(), 2u);
+    EXPECT_EQ(first.critical_path[0].name, "halo_f");
+    EXPECT_EQ(first.critical_path[1].name, "stream");
+    EXPECT_DOUBLE_EQ(first.critical_path_us, 90.0);
+
+    // Step 1: the halo is fully hidden behind collide
+    const StepReport& second = summary.steps[1];
+    EXPECT_DOUBLE_EQ(second.overlap_ratio, 1.0);
+    ASSERT_EQ(second.critical_path.size(), 2u);
+    EXPECT_EQ(second.critical_path[0].name, "collide");
+    EXPECT_EQ(second.critical_path[1].name, "stats");
+
+    EXPECT_DOUBLE_EQ(summary.total_us, 200.0);
+    EXPECT_DOUBLE_EQ(summary.communication_us, 70.0);
+    EXPECT_DOUBLE_EQ(summary.overlap_us, 50.0);
+}
+
+TEST(TraceAnalyzerTest, IdleGapsAndHaloWaitPerPeer) {
+    TraceSummary summary = TraceAnalyzer().analyze(TraceData::parse(TWO_STEP_TRACE));
+
+    const LaneReport* worker = nullptr;
+    for (const auto& lane : summary.lanes) {
+        if (lane.lane == "1:11") worker = &lane;
+    }
+    ASSERT_NE(worker, nullptr);
+    EXPECT_DOUBLE_EQ(worker->busy_us, 180.0);
+    EXPECT_DOUBLE_EQ(worker->idle_us, 20.0);
+    EXPECT_EQ(worker->gaps, 1u);
+
+    // Slowest peer first
+    ASSERT_EQ(summary.halo_wait.size(), 2u);
+    EXPECT_EQ(summary.halo_wait[0].peer, 3);
+    EXPECT_DOUBLE_EQ(summary.halo_wait[0].wait_us, 45.0);
+    EXPECT_EQ(summary.halo_wait[0].count, 2u);
+    EXPECT_DOUBLE_EQ(summary.halo_wait[0].max_us, 25.0);
+    EXPECT_EQ(summary.halo_wait[1].peer, 1);
+
+    ASSERT_FALSE(summary.stalls.empty());
+    EXPECT_EQ(summary.stalls[0].kind, "wait");
+    EXPECT_EQ(summary.stalls[0].peer, 3);
+    EXPECT_DOUBLE_EQ(summary.stalls[0].duration_us, 25.0);
+}
+
+TEST(TraceAnalyzerTest, TopNAndUnmarkedTrace) {
+    AnalyzerConfig config;
+    config.top_n = 1;
+    TraceSummary summary = TraceAnalyzer(config).analyze(TraceData::parse(TWO_STEP_TRACE));
+    EXPECT_EQ(summary.stalls.size(), 1u);
+
+    // No step spans: the whole trace is a single step
+    TraceSummary flat = TraceAnalyzer().analyze(TraceData::parse(R"([
+        {"name": "k", "cat": "kernel", "ph": "X", "ts": 5, "dur": 10, "pid": 0, "tid": 1},
+        {"name": "k", "cat": "kernel", "ph": "X", "ts": 20, "dur": 10, "pid": 0, "tid": 1}
+    ])"));
+    ASSERT_EQ(flat.steps.size(), 1u);
+    EXPECT_DOUBLE_EQ(flat.steps[0].duration_us, 25.0);
+    EXPECT_DOUBLE_EQ(flat.steps[0].overlap_ratio, 1.0);
+    EXPECT_EQ(flat.steps[0].critical_path.size(), 2u);
+}
+
+TEST(TraceAnalyzerTest, JsonSummaryRoundTripsThroughReader) {
+    TraceSummary summary = TraceAnalyzer().analyze(TraceData::parse(TWO_STEP_TRACE));
+    std::string json = summary.toJSON();
+
+    // The summary is itself valid JSON (an object without traceEvents)
+    EXPECT_THROW(TraceData::parse(json), std::runtime_error);
+    EXPECT_NE(json.find("\"overlap_ratio\": 0.714"), std::string::npos);
+    EXPECT_NE(json.find("\"peer\": 3"), std::string::npos);
+
+    std::string path = ::testing::TempDir() + "trace_summary.json";
+    std::ofstream(path) << json;
+    std::ifstream in(path);
+    EXPECT_TRUE(in.good());
+    std::remove(path.c_str());
+
+    EXPECT_NE(summary.toText().find("peer 3"), std::string::npos);
+}
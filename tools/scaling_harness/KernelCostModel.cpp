@@ -0,0 +1,201 @@
+#include "KernelCostModel.h"
+#include "fluidloom/core/hilbert/HilbertCodec.h"
+#include "fluidloom/halo/interpolation/VolumeWeightedAverager.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+namespace fluidloom {
+namespace testing {
+
+namespace {
+
+constexpr int kQ = 19;
+
+// Keeps the optimizer from discarding calibration work
+volatile float g_sink = 0.0f;
+
+double timeOnce(const std::function<void(size_t)>& run, size_t n) {
+    auto start = std::chrono::steady_clock::now();
+    run(n);
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+} // namespace
+
+const KernelCostModel::Cost& KernelCostModel::getCost(const std::string& kernel) const {
+    auto it = costs.find(kernel);
+    if (it == costs.end()) {
+        throw std::out_of_range("KernelCostModel: no cost for kernel '" + kernel + "'");
+    }
+    return it->second;
+}
+
+double KernelCostModel::predict(const std::string& kernel, size_t cells) const {
+    if (cells == 0) return 0.0;
+    const Cost& cost = getCost(kernel);
+    return cost.launch_us + static_cast<double>(cells) * cost.ns_per_cell * 1e-3;
+}
+
+KernelCostModel::Cost KernelCostModel::calibrate(const std::string& kernel, const std::function<void(size_t)>& run,
+                                                 const std::vector<size_t>& sizes, int reps) {
+    if (sizes.size() < 2 || reps < 1) {
+        throw std::invalid_argument("KernelCostModel::calibrate needs two sizes and one repetition");
+    }
+
+    run(sizes.front());  // Warm caches and allocations
+
+    // Least-squares fit of t = a + b * n over the fastest run per size
+    double sum_n = 0.0, sum_t = 0.0, sum_nn = 0.0, sum_nt = 0.0;
+    for (size_t n : sizes) {
+        double best = std::numeric_limits<double>::max();
+        for (int r = 0; r < reps; ++r) {
+            best = std::min(best, timeOnce(run, n));
+        }
+        double x = static_cast<double>(n);
+        sum_n += x;
+        sum_t += best;
+        sum_nn += x * x;
+        sum_nt += x * best;
+    }
+
+    double count = static_cast<double>(sizes.size());
+    double denom = count * sum_nn - sum_n * sum_n;
+    if (denom == 0.0) {
+        throw std::invalid_argument("KernelCostModel::calibrate needs distinct sizes");
+    }
+    double slope = (count * sum_nt - sum_n * sum_t) / denom;
+    double intercept = (sum_t - slope * sum_n) / count;
+
+    // Timer noise can push either term slightly negative
+    Cost cost;
+    cost.launch_us = std::max(0.0, intercept);
+    cost.ns_per_cell = std::max(0.0, slope * 1e3);
+    costs[kernel] = cost;
+    return cost;
+}
+
+KernelCostModel KernelCostModel::scaledToDevice(double throughput_ratio, double launch_us) const {
+    if (throughput_ratio <= 0.0) {
+        throw std::invalid_argument("Throughput ratio must be positive");
+    }
+    KernelCostModel scaled;
+    for (const auto& [name, cost] : costs) {
+        scaled.costs[name] = Cost{launch_us, cost.ns_per_cell / throughput_ratio};
+    }
+    return scaled;
+}
+
+void KernelCostModel::save(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) {
+        throw std::runtime_error("Cannot write cost model: " + path);
+    }
+    for (const auto& [name, cost] : costs) {
+        out << name << " " << cost.launch_us << " " << cost.ns_per_cell << "\n";
+    }
+}
+
+KernelCostModel KernelCostModel::load(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Cannot read cost model: " + path);
+    }
+    KernelCostModel model;
+    std::string name;
+    Cost cost;
+    while (in >> name >> cost.launch_us >> cost.ns_per_cell) {
+        model.costs[name] = cost;
+    }
+    return model;
+}
+
+KernelCostModel KernelCostModel::defaults() {
+    // Orders of magnitude of a current data-center GPU
+    KernelCostModel model;
+    model.setCost(COLLIDE_STREAM, Cost{5.0, 1.0});
+    model.setCost(HALO_PACK, Cost{5.0, 0.15});
+    model.setCost(RESTRICT, Cost{5.0, 0.3});
+    model.setCost(HILBERT_ENCODE, Cost{5.0, 0.05});
+    return model;
+}
+
+KernelCostModel KernelCostModel::calibrateHost(const std::vector<size_t>& sizes) {
+    const size_t max_n = *std::max_element(sizes.begin(), sizes.end());
+    KernelCostModel model;
+
+    // D3Q19 BGK collide: read 19 populations, compute moments, relax, write
+    std::vector<float> f(max_n * kQ, 1.0f / kQ), f_out(max_n * kQ);
+    model.calibrate(COLLIDE_STREAM, [&](size_t n) {
+        const float omega = 1.0f / 0.6f;
+        for (size_t c = 0; c < n; ++c) {
+            float rho = 0.0f;
+            for (int q = 0; q < kQ; ++q) rho += f[q * max_n + c];
+            for (int q = 0; q < kQ; ++q) {
+                float fq = f[q * max_n + c];
+                f_out[q * max_n + c] = fq - omega * (fq - rho / kQ);
+            }
+        }
+        g_sink = g_sink + f_out[n - 1];
+    }, sizes);
+
+    // Halo pack: gather 19 planes through an index list
+    std::vector<uint32_t> idx(max_n);
+    for (size_t i = 0; i < max_n; ++i) idx[i] = static_cast<uint32_t>((i * 7919) % max_n);
+    model.calibrate(HALO_PACK, [&](size_t n) {
+        for (int q = 0; q < kQ; ++q) {
+            for (size_t i = 0; i < n; ++i) f_out[q * max_n + i] = f[q * max_n + idx[i]];
+        }
+        g_sink = g_sink + f_out[n - 1];
+    }, sizes);
+
+    // Restriction of one scalar field through the averager's host path;
+    // masks are built up front so only the restriction is timed
+    std::vector<float> fine(max_n * 8, 1.0f), coarse(max_n, 0.0f);
+    halo::PackBufferLayout layout;
+    layout.addField("density", 1, sizeof(float));
+    std::map<size_t, std::unique_ptr<halo::VolumeWeightedAverager>> averagers;
+    for (size_t n : sizes) {
+        halo::GhostRange range;
+        range.interpolation_type = halo::GhostRange::InterpolationType::VOLUME_WEIGHTED_AVERAGE;
+        range.cached.local_cell_indices.resize(n);
+        range.cached.neighbor_cell_indices.resize(n * 8);
+        for (size_t i = 0; i < n; ++i) {
+            range.cached.local_cell_indices[i] = static_cast<uint32_t>(i);
+            for (uint32_t k = 0; k < 8; ++k) {
+                range.cached.neighbor_cell_indices[8 * i + k] = static_cast<uint32_t>(8 * i + k);
+            }
+        }
+        range.cached.num_cells = n;
+        averagers[n] = std::make_unique<halo::VolumeWeightedAverager>();
+        averagers[n]->buildMasks({range});
+    }
+    model.calibrate(RESTRICT, [&](size_t n) {
+        Buffer fine_b{fine.data(), n * 8 * sizeof(float), nullptr};
+        Buffer coarse_b{coarse.data(), n * sizeof(float), nullptr};
+        averagers.at(n)->restrictFields(layout, fine_b, coarse_b);
+        g_sink = g_sink + coarse[n - 1];
+    }, sizes);
+
+    // Key generation for rebuild/rebalance
+    std::vector<int32_t> x(max_n), y(max_n), z(max_n);
+    for (size_t i = 0; i < max_n; ++i) {
+        x[i] = static_cast<int32_t>(i & 255);
+        y[i] = static_cast<int32_t>((i >> 8) & 255);
+        z[i] = static_cast<int32_t>((i >> 16) & 255);
+    }
+    std::vector<hilbert::HilbertIndex> keys(max_n);
+    model.calibrate(HILBERT_ENCODE, [&](size_t n) {
+        hilbert::encodeBatch(x.data(), y.data(), z.data(), nullptr, keys.data(), n);
+        g_sink = g_sink + static_cast<float>(keys[n - 1] & 1);
+    }, sizes);
+
+    return model;
+}
+
+} // namespace testing
+} // namespace fluidloom
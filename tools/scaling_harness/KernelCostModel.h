@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace fluidloom {
+namespace testing {
+
+/**
+ * @brief Per-kernel linear cost model: t(n) = launch_us + n * ns_per_cell
+ *
+ * Costs are fitted by least squares from timings at several problem sizes.
+ * Host-calibrated costs describe the CPU; scaledToDevice() maps them onto a
+ * target GPU by a throughput ratio and a fixed launch overhead, which is how
+ * predictions for cluster hardware are made without access to it.
+ */
+class KernelCostModel {
+public:
+    struct Cost {
+        double launch_us = 0.0;
+        double ns_per_cell = 0.0;
+    };
+
+    // Kernels every harness run charges per step
+    static constexpr const char* COLLIDE_STREAM = "collide_stream";
+    static constexpr const char* HALO_PACK = "halo_pack";
+    static constexpr const char* RESTRICT = "restrict";
+    static constexpr const char* HILBERT_ENCODE = "hilbert_encode";
+
+    void setCost(const std::string& kernel, const Cost& cost) { costs[kernel] = cost; }
+    bool hasCost(const std::string& kernel) const { return costs.count(kernel) != 0; }
+
+    // @throws std::out_of_range if the kernel has no cost
+    const Cost& getCost(const std::string& kernel) const;
+
+    // Predicted time in microseconds; zero cells cost nothing (no launch)
+    double predict(const std::string& kernel, size_t cells) const;
+
+    /**
+     * @brief Fit a kernel's cost from measured runs
+     * @param run Runs the kernel over n cells
+     * @param sizes Problem sizes to time (at least two distinct)
+     * @param reps Repetitions per size; the fastest is kept
+     */
+    Cost calibrate(const std::string& kernel, const std::function<void(size_t)>& run,
+                   const std::vector<size_t>& sizes, int reps = 3);
+
+    // Copy with per-cell costs divided by `throughput_ratio` and launch set to `launch_us`
+    KernelCostModel scaledToDevice(double throughput_ratio, double launch_us) const;
+
+    // Plain text, one "name launch_us ns_per_cell" line per kernel
+    void save(const std::string& path) const;
+    static KernelCostModel load(const std::string& path);
+
+    /**
+     * @brief Calibrate the harness kernels from host reference implementations
+     *
+     * collide_stream is a D3Q19 BGK update, halo_pack a gather of 19 planes,
+     * restrict runs VolumeWeightedAverager's host path and hilbert_encode
+     * hilbert::encodeBatch.
+     */
+    static KernelCostModel calibrateHost(const std::vector<size_t>& sizes = {1 << 12, 1 << 14, 1 << 16});
+
+    // Typical-order defaults when calibration is not wanted (e.g. in unit tests)
+    static KernelCostModel defaults();
+
+    const std::map<std::string, Cost>& getCosts() const { return costs; }
+
+private:
+    std::map<std::string, Cost> costs;
+};
+
+} // namespace testing
+} // namespace fluidloom
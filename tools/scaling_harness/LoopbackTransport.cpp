@@ -0,0 +1,104 @@
+#include "LoopbackTransport.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace fluidloom {
+namespace testing {
+
+namespace {
+// A simulated rank waiting this long has deadlocked (mismatched send/recv)
+constexpr auto kRecvTimeout = std::chrono::seconds(60);
+}
+
+LoopbackTransport::LoopbackTransport(int num_ranks, const LinkModel& link)
+    : link(link) {
+    if (num_ranks <= 0) {
+        throw std::invalid_argument("LoopbackTransport needs at least one rank");
+    }
+    if (link.ranks_per_node <= 0) {
+        throw std::invalid_argument("LinkModel::ranks_per_node must be positive");
+    }
+    mailboxes.reserve(num_ranks);
+    for (int r = 0; r < num_ranks; ++r) {
+        mailboxes.push_back(std::make_unique<Mailbox>());
+    }
+}
+
+double LoopbackTransport::send(int source, int dest, int tag, size_t bytes, double send_time_us, const void* data) {
+    if (source < 0 || source >= getSize() || dest < 0 || dest >= getSize()) {
+        throw std::out_of_range("LoopbackTransport: rank out of range");
+    }
+
+    Message message;
+    message.source = source;
+    message.tag = tag;
+    message.bytes = bytes;
+    if (data && bytes > 0) {
+        message.payload.resize(bytes);
+        std::memcpy(message.payload.data(), data, bytes);
+    }
+
+    // Sends from one rank share its injection link; latency overlaps
+    {
+        Mailbox& out = *mailboxes[source];
+        std::lock_guard<std::mutex> lock(out.mutex);
+        double start = std::max(send_time_us, out.link_free_us);
+        double wire = link.wireTime(source, dest, bytes);
+        out.link_free_us = start + wire;
+        message.arrival_us = start + wire + link.latency(source, dest);
+        out.stats.bytes_sent += bytes;
+        out.stats.messages_sent++;
+    }
+
+    double arrival = message.arrival_us;
+    {
+        Mailbox& in = *mailboxes[dest];
+        std::lock_guard<std::mutex> lock(in.mutex);
+        in.messages.push_back(std::move(message));
+    }
+    mailboxes[dest]->cv.notify_all();
+    return arrival;
+}
+
+LoopbackTransport::Message LoopbackTransport::recv(int dest, int source, int tag) {
+    Mailbox& in = *mailboxes.at(dest);
+    std::unique_lock<std::mutex> lock(in.mutex);
+
+    auto matches = [&](const Message& m) { return m.source == source && m.tag == tag; };
+    auto it = in.messages.end();
+    bool arrived = in.cv.wait_for(lock, kRecvTimeout, [&] {
+        it = std::find_if(in.messages.begin(), in.messages.end(), matches);
+        return it != in.messages.end();
+    });
+    if (!arrived) {
+        throw std::runtime_error("LoopbackTransport: rank " + std::to_string(dest) + " timed out waiting for rank " +
+                                 std::to_string(source) + " (tag " + std::to_string(tag) + ")");
+    }
+
+    Message message = std::move(*it);
+    in.messages.erase(it);
+    in.stats.bytes_received += message.bytes;
+    in.stats.messages_received++;
+    return message;
+}
+
+LoopbackTransport::RankStats LoopbackTransport::getStats(int rank) const {
+    const Mailbox& box = *mailboxes.at(rank);
+    std::lock_guard<std::mutex> lock(box.mutex);
+    return box.stats;
+}
+
+void LoopbackTransport::reset() {
+    for (auto& box : mailboxes) {
+        std::lock_guard<std::mutex> lock(box->mutex);
+        box->messages.clear();
+        box->stats = RankStats();
+        box->link_free_us = 0.0;
+    }
+}
+
+} // namespace testing
+} // namespace fluidloom
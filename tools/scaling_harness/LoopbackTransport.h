@@ -0,0 +1,101 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace fluidloom {
+namespace testing {
+
+/**
+ * @brief Latency/bandwidth model of the interconnect
+ *
+ * Ranks are packed onto nodes in order (ranks_per_node per node); messages
+ * between ranks of one node use the intra-node link.
+ */
+struct LinkModel {
+    double latency_us = 2.0;              // Inter-node (e.g. InfiniBand HDR)
+    double bandwidth_gb_per_s = 12.5;
+    double intra_latency_us = 1.0;        // Intra-node (e.g. PCIe/NVLink P2P)
+    double intra_bandwidth_gb_per_s = 50.0;
+    int ranks_per_node = 4;
+
+    bool sameNode(int a, int b) const { return a / ranks_per_node == b / ranks_per_node; }
+
+    double latency(int a, int b) const { return sameNode(a, b) ? intra_latency_us : latency_us; }
+
+    // Wire time of `bytes` in microseconds (GB/s = 1e3 bytes/us)
+    double wireTime(int a, int b, size_t bytes) const {
+        double bw = sameNode(a, b) ? intra_bandwidth_gb_per_s : bandwidth_gb_per_s;
+        return static_cast<double>(bytes) / (bw * 1e3);
+    }
+};
+
+/**
+ * @brief In-process transport between simulated ranks running as threads
+ *
+ * Messages carry a modeled size and optionally a payload. Each send is
+ * stamped with the sender's virtual time; the transport serializes a rank's
+ * sends on its injection link and returns the modeled arrival time, which
+ * the receiver merges into its own virtual clock. Real wall-clock time plays
+ * no role, so results are deterministic for a given configuration.
+ */
+class LoopbackTransport {
+public:
+    struct Message {
+        int source = -1;
+        int tag = 0;
+        size_t bytes = 0;
+        double arrival_us = 0.0;
+        std::vector<uint8_t> payload;
+    };
+
+    struct RankStats {
+        uint64_t bytes_sent = 0;
+        uint64_t bytes_received = 0;
+        uint32_t messages_sent = 0;
+        uint32_t messages_received = 0;
+    };
+
+    LoopbackTransport(int num_ranks, const LinkModel& link);
+
+    LoopbackTransport(const LoopbackTransport&) = delete;
+    LoopbackTransport& operator=(const LoopbackTransport&) = delete;
+
+    int getSize() const { return static_cast<int>(mailboxes.size()); }
+    const LinkModel& getLink() const { return link; }
+
+    /**
+     * @brief Post a message
+     * @param data Payload to copy, or nullptr for a size-only message
+     * @return Modeled arrival time at `dest`
+     */
+    double send(int source, int dest, int tag, size_t bytes, double send_time_us, const void* data = nullptr);
+
+    // Block until the oldest message from `source` with `tag` is delivered to `dest`
+    Message recv(int dest, int source, int tag);
+
+    RankStats getStats(int rank) const;
+
+    // Drop pending messages and reset link clocks and statistics
+    void reset();
+
+private:
+    struct Mailbox {
+        mutable std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<Message> messages;
+        RankStats stats;
+        double link_free_us = 0.0;  // When this rank's injection link is next idle
+    };
+
+    LinkModel link;
+    std::vector<std::unique_ptr<Mailbox>> mailboxes;
+};
+
+} // namespace testing
+} // namespace fluidloom
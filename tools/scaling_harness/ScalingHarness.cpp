@@ -0,0 +1,500 @@
+#include "ScalingHarness.h"
+#include "fluidloom/common/Logger.h"
+#include "fluidloom/core/hilbert/HilbertCodec.h"
+#include "fluidloom/load_balance/LoadBalancer.h"
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+
+namespace fluidloom {
+namespace testing {
+
+namespace {
+
+constexpr int kHaloTag = 1;
+constexpr int kMigrateTag = 2;
+constexpr int kReduceTag = 16;  // + dissemination round
+
+constexpr int kMaxExtent = 1 << hilbert::MAX_REFINEMENT_LEVEL;
+
+// Fine ghost cells a refined cell sends across one face
+constexpr size_t kFineGhostsPerFace = 4;
+
+ScalingPoint toPoint(const ScalingResult& result) {
+    ScalingPoint point;
+    point.ranks = result.num_ranks;
+    point.cells = result.total_load;
+    point.time_per_step_us = result.time_per_step_us;
+    point.compute_us = result.computePerStep();
+    point.comm_us = result.commPerStep();
+    point.reduce_us = result.reducePerStep();
+    point.imbalance = result.imbalance;
+    point.halo_bytes = result.halo_bytes_per_step;
+    return point;
+}
+
+} // namespace
+
+// ========== Partitioners ==========
+
+std::vector<uint64_t> loadBalancerPartitioner(const PartitionInput& input) {
+    if (input.sorted_keys.empty()) return {};
+    return load_balance::LoadBalancer::computeSplitPoints(
+        input.rank_loads, input.current_splits, input.sorted_keys.front(), input.sorted_keys.back() + 1);
+}
+
+std::vector<uint64_t> weightedPrefixPartitioner(const PartitionInput& input) {
+    std::vector<uint64_t> result;
+    if (input.num_ranks <= 1 || input.sorted_keys.empty()) return result;
+
+    uint64_t total = std::accumulate(input.sorted_weights.begin(), input.sorted_weights.end(), uint64_t(0));
+    result.reserve(input.num_ranks - 1);
+
+    // Split before the first cell whose prefix reaches the next rank's share
+    uint64_t prefix = 0;
+    int next = 1;
+    for (size_t i = 0; i < input.sorted_keys.size() && next < input.num_ranks; ++i) {
+        uint64_t target = total * next / input.num_ranks;
+        while (next < input.num_ranks && prefix >= target) {
+            result.push_back(input.sorted_keys[i]);
+            target = total * ++next / input.num_ranks;
+        }
+        prefix += input.sorted_weights[i];
+    }
+    while (static_cast<int>(result.size()) < input.num_ranks - 1) {
+        result.push_back(input.sorted_keys.back() + 1);
+    }
+    return result;
+}
+
+// ========== Configuration and results ==========
+
+halo::PackBufferLayout ScalingConfig::defaultLayout() {
+    halo::PackBufferLayout layout;
+    layout.addField("f", 19, sizeof(float));
+    return layout;
+}
+
+void ScalingConfig::validate() const {
+    if (num_ranks < 1) {
+        throw std::invalid_argument("ScalingConfig: need at least one rank");
+    }
+    if (nx < 1 || ny < 1 || nz < 1 || nx > kMaxExtent || ny > kMaxExtent || nz > kMaxExtent) {
+        throw std::invalid_argument("ScalingConfig: grid extents must be in [1, 256]");
+    }
+    if (static_cast<size_t>(num_ranks) > static_cast<size_t>(nx) * ny * nz) {
+        throw std::invalid_argument("ScalingConfig: more ranks than cells");
+    }
+    if (steps < 1 || reductions_per_step < 0 || refined_weight < 1) {
+        throw std::invalid_argument("ScalingConfig: steps and refined_weight must be positive");
+    }
+    if (halo_layout.cell_size_bytes == 0) {
+        throw std::invalid_argument("ScalingConfig: halo layout has no fields");
+    }
+    if (!partitioner) {
+        throw std::invalid_argument("ScalingConfig: no partitioner");
+    }
+    if (balance.enabled) {
+        balance.validate();
+    }
+}
+
+double ScalingResult::computePerStep() const {
+    double worst = 0.0;
+    for (const auto& rank : ranks) worst = std::max(worst, rank.compute_us);
+    return steps > 0 ? worst / steps : 0.0;
+}
+
+double ScalingResult::commPerStep() const {
+    if (ranks.empty() || steps == 0) return 0.0;
+    double sum = 0.0;
+    for (const auto& rank : ranks) sum += rank.comm_wait_us + rank.migrate_us;
+    return sum / ranks.size() / steps;
+}
+
+double ScalingResult::reducePerStep() const {
+    if (ranks.empty() || steps == 0) return 0.0;
+    double sum = 0.0;
+    for (const auto& rank : ranks) sum += rank.reduce_us;
+    return sum / ranks.size() / steps;
+}
+
+// ========== Harness ==========
+
+ScalingHarness::ScalingHarness(const ScalingConfig& config)
+    : config(config) {
+    this->config.validate();
+    buildMesh();
+}
+
+void ScalingHarness::buildMesh() {
+    const size_t n = static_cast<size_t>(config.nx) * config.ny * config.nz;
+    keys.resize(n);
+    weights.resize(n);
+    refined.resize(n);
+
+    const double r2 = config.refine_radius * config.refine_radius;
+    size_t i = 0;
+    for (int z = 0; z < config.nz; ++z) {
+        for (int y = 0; y < config.ny; ++y) {
+            for (int x = 0; x < config.nx; ++x, ++i) {
+                keys[i] = hilbert::encode(x, y, z);
+
+                double dx = x + 0.5 - config.refine_center[0];
+                double dy = y + 0.5 - config.refine_center[1];
+                double dz = z + 0.5 - config.refine_center[2];
+                refined[i] = (dx * dx + dy * dy + dz * dz) <= r2;
+                weights[i] = refined[i] ? config.refined_weight : 1;
+            }
+        }
+    }
+
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return keys[a] < keys[b]; });
+
+    sorted_keys.resize(n);
+    sorted_weights.resize(n);
+    for (size_t k = 0; k < n; ++k) {
+        sorted_keys[k] = keys[order[k]];
+        sorted_weights[k] = weights[order[k]];
+    }
+}
+
+int ScalingHarness::ownerOf(uint64_t key) const {
+    return static_cast<int>(std::upper_bound(splits.begin(), splits.end(), key) - splits.begin());
+}
+
+std::vector<size_t> ScalingHarness::rankLoads(const std::vector<uint64_t>& at_splits) const {
+    std::vector<size_t> loads(config.num_ranks, 0);
+    size_t rank = 0;
+    for (size_t k = 0; k < sorted_keys.size(); ++k) {
+        while (rank < at_splits.size() && sorted_keys[k] >= at_splits[rank]) ++rank;
+        loads[rank] += sorted_weights[k];
+    }
+    return loads;
+}
+
+std::vector<uint64_t> ScalingHarness::partition(const std::vector<uint64_t>& from_splits) const {
+    std::vector<size_t> loads = rankLoads(from_splits);
+    PartitionInput input{sorted_keys, sorted_weights, loads, from_splits, config.num_ranks};
+    std::vector<uint64_t> result = config.partitioner(input);
+
+    if (result.size() != static_cast<size_t>(config.num_ranks - 1) || !std::is_sorted(result.begin(), result.end())) {
+        throw std::runtime_error("Partitioner must return num_ranks - 1 ascending split keys");
+    }
+    return result;
+}
+
+std::vector<ScalingHarness::RankPlan> ScalingHarness::buildPlans() {
+    const int num_ranks = config.num_ranks;
+    const size_t n = keys.size();
+
+    owners.resize(n);
+    for (size_t i = 0; i < n; ++i) owners[i] = ownerOf(keys[i]);
+
+    std::vector<RankPlan> plans(num_ranks);
+    // Dense [src][dst] and [dst][src] tables; rank counts stay in the hundreds
+    std::vector<size_t> send(static_cast<size_t>(num_ranks) * num_ranks, 0);
+    std::vector<size_t> restrict_cells(static_cast<size_t>(num_ranks) * num_ranks, 0);
+
+    const int dims[3] = {config.nx, config.ny, config.nz};
+    const long strides[3] = {1, config.nx, static_cast<long>(config.nx) * config.ny};
+
+    size_t i = 0;
+    for (int z = 0; z < config.nz; ++z) {
+        for (int y = 0; y < config.ny; ++y) {
+            for (int x = 0; x < config.nx; ++x, ++i) {
+                const int src = owners[i];
+                plans[src].load += weights[i];
+
+                // Distinct remote owners among the face neighbours; a cell is
+                // sent once per destination however many faces it shares
+                int dsts[6];
+                bool coarse_neighbor[6];
+                int num_dsts = 0;
+                const int coord[3] = {x, y, z};
+                for (int axis = 0; axis < 3; ++axis) {
+                    for (int dir = -1; dir <= 1; dir += 2) {
+                        int c = coord[axis] + dir;
+                        if (c < 0 || c >= dims[axis]) continue;
+                        size_t j = i + dir * strides[axis];
+                        int dst = owners[j];
+                        if (dst == src) continue;
+
+                        int slot = 0;
+                        while (slot < num_dsts && dsts[slot] != dst) ++slot;
+                        if (slot == num_dsts) {
+                            dsts[num_dsts] = dst;
+                            coarse_neighbor[num_dsts++] = false;
+                        }
+                        coarse_neighbor[slot] = coarse_neighbor[slot] || !refined[j];
+                    }
+                }
+
+                if (num_dsts > 0) plans[src].boundary_load += weights[i];
+                for (int d = 0; d < num_dsts; ++d) {
+                    send[static_cast<size_t>(src) * num_ranks + dsts[d]] += refined[i] ? kFineGhostsPerFace : 1;
+                    if (refined[i] && coarse_neighbor[d]) {
+                        restrict_cells[static_cast<size_t>(dsts[d]) * num_ranks + src]++;
+                    }
+                }
+            }
+        }
+    }
+
+    for (int r = 0; r < num_ranks; ++r) {
+        for (int p = 0; p < num_ranks; ++p) {
+            size_t out = send[static_cast<size_t>(r) * num_ranks + p];
+            size_t in = send[static_cast<size_t>(p) * num_ranks + r];
+            if (out == 0 && in == 0) continue;
+            Peer peer;
+            peer.rank = p;
+            peer.send_cells = out;
+            peer.recv_cells = in;
+            peer.restrict_cells = restrict_cells[static_cast<size_t>(r) * num_ranks + p];
+            plans[r].peers.push_back(peer);
+        }
+    }
+    return plans;
+}
+
+std::vector<std::vector<size_t>> ScalingHarness::migrationMatrix(const std::vector<int>& old_owners) const {
+    std::vector<std::vector<size_t>> matrix(config.num_ranks, std::vector<size_t>(config.num_ranks, 0));
+    for (size_t i = 0; i < owners.size(); ++i) {
+        if (old_owners[i] != owners[i]) {
+            matrix[old_owners[i]][owners[i]] += weights[i];
+        }
+    }
+    return matrix;
+}
+
+void ScalingHarness::runRank(int rank, LoopbackTransport& transport, const std::vector<RankPlan>& plans,
+                             const std::vector<std::vector<size_t>>* migration, int steps,
+                             RankState& state) const {
+    const RankPlan& plan = plans[rank];
+    const KernelCostModel& costs = config.costs;
+    const size_t cell_bytes = config.halo_layout.cell_size_bytes;
+    const int num_ranks = config.num_ranks;
+    double& clock = state.clock_us;
+    RankBreakdown& stats = state.breakdown;
+
+    // Cells moved by the last rebalance, then their keys are rebuilt
+    if (migration) {
+        const double start = clock;
+        size_t incoming = 0;
+        for (int dst = 0; dst < num_ranks; ++dst) {
+            size_t cells = (*migration)[rank][dst];
+            if (cells > 0) transport.send(rank, dst, kMigrateTag, cells * cell_bytes, clock);
+        }
+        for (int src = 0; src < num_ranks; ++src) {
+            size_t cells = (*migration)[src][rank];
+            if (cells == 0) continue;
+            clock = std::max(clock, transport.recv(rank, src, kMigrateTag).arrival_us);
+            incoming += cells;
+        }
+        clock += costs.predict(KernelCostModel::HILBERT_ENCODE, incoming);
+        stats.migrate_us += clock - start;
+    }
+
+    size_t send_cells = 0, recv_cells = 0, restrict_cells = 0;
+    for (const Peer& peer : plan.peers) {
+        send_cells += peer.send_cells;
+        recv_cells += peer.recv_cells;
+        restrict_cells += peer.restrict_cells;
+    }
+    const size_t interior_load = plan.load - plan.boundary_load;
+
+    for (int step = 0; step < steps; ++step) {
+        // Pack and post the halo
+        double kernel = costs.predict(KernelCostModel::HALO_PACK, send_cells);
+        clock += kernel;
+        stats.compute_us += kernel;
+        for (const Peer& peer : plan.peers) {
+            transport.send(rank, peer.rank, kHaloTag, peer.send_cells * cell_bytes, clock);
+        }
+
+        if (config.overlap_communication) {
+            kernel = costs.predict(KernelCostModel::COLLIDE_STREAM, interior_load);
+            clock += kernel;
+            stats.compute_us += kernel;
+        }
+
+        const double ready = clock;
+        for (const Peer& peer : plan.peers) {
+            clock = std::max(clock, transport.recv(rank, peer.rank, kHaloTag).arrival_us);
+        }
+        stats.comm_wait_us += clock - ready;
+
+        kernel = costs.predict(KernelCostModel::HALO_PACK, recv_cells) +
+                 costs.predict(KernelCostModel::RESTRICT, restrict_cells) +
+                 costs.predict(KernelCostModel::COLLIDE_STREAM,
+                               config.overlap_communication ? plan.boundary_load : plan.load);
+        clock += kernel;
+        stats.compute_us += kernel;
+
+        // Dissemination allreduce: log2(N) rounds of 8-byte messages
+        const double reduce_start = clock;
+        for (int r = 0; r < config.reductions_per_step; ++r) {
+            int round = 0;
+            for (int dist = 1; dist < num_ranks; dist *= 2, ++round) {
+                transport.send(rank, (rank + dist) % num_ranks, kReduceTag + round, sizeof(double), clock);
+                int src = (rank - dist + num_ranks) % num_ranks;
+                clock = std::max(clock, transport.recv(rank, src, kReduceTag + round).arrival_us);
+            }
+        }
+        stats.reduce_us += clock - reduce_start;
+    }
+}
+
+void ScalingHarness::runChunk(LoopbackTransport& transport, const std::vector<RankPlan>& plans,
+                              const std::vector<std::vector<size_t>>* migration, int steps,
+                              std::vector<RankState>& states) const {
+    std::vector<std::exception_ptr> errors(config.num_ranks);
+    std::vector<std::thread> threads;
+    threads.reserve(config.num_ranks);
+    for (int r = 0; r < config.num_ranks; ++r) {
+        threads.emplace_back([&, r]() {
+            try {
+                runRank(r, transport, plans, migration, steps, states[r]);
+            } catch (...) {
+                errors[r] = std::current_exception();
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    for (auto& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+}
+
+ScalingResult ScalingHarness::run() {
+    const int num_ranks = config.num_ranks;
+
+    // Start from an even split of the key range, as a fresh LoadBalancer would
+    splits.clear();
+    const uint64_t key_min = sorted_keys.front();
+    const uint64_t key_range = sorted_keys.back() + 1 - key_min;
+    for (int r = 1; r < num_ranks; ++r) {
+        splits.push_back(key_min + key_range / num_ranks * r);
+    }
+    if (num_ranks > 1 && config.balance_at_start) {
+        splits = partition(splits);
+    }
+    std::vector<RankPlan> plans = buildPlans();
+
+    LoopbackTransport transport(num_ranks, config.link);
+    std::vector<RankState> states(num_ranks);
+
+    ScalingResult result;
+    result.num_ranks = num_ranks;
+    result.steps = config.steps;
+
+    const bool balancing = config.balance.enabled && num_ranks > 1;
+    const int chunk = balancing ? static_cast<int>(config.balance.min_interval_timesteps) : config.steps;
+
+    std::vector<std::vector<size_t>> migration;
+    bool migrate = false;
+    uint32_t steps_since_balance = 0;
+    for (int done = 0; done < config.steps;) {
+        int steps = std::min(chunk, config.steps - done);
+        runChunk(transport, plans, migrate ? &migration : nullptr, steps, states);
+        migrate = false;
+        done += steps;
+        steps_since_balance += steps;
+
+        if (!balancing || done >= config.steps) continue;
+        if (!config.balance.shouldRebalance(rankLoads(splits), steps_since_balance)) continue;
+
+        std::vector<int> old_owners = owners;
+        splits = partition(splits);
+        plans = buildPlans();
+        migration = migrationMatrix(old_owners);
+        migrate = true;
+        steps_since_balance = 0;
+        result.rebalances++;
+        FL_LOG(DEBUG) << "Scaling harness rebalanced after step " << done;
+    }
+
+    double end_us = 0.0;
+    for (int r = 0; r < num_ranks; ++r) {
+        RankBreakdown breakdown = states[r].breakdown;
+        breakdown.load = plans[r].load;
+        breakdown.bytes_sent = transport.getStats(r).bytes_sent;
+        result.ranks.push_back(breakdown);
+        result.total_load += plans[r].load;
+        end_us = std::max(end_us, states[r].clock_us);
+        for (const Peer& peer : plans[r].peers) {
+            result.halo_bytes_per_step += peer.send_cells * config.halo_layout.cell_size_bytes;
+        }
+    }
+    result.time_per_step_us = end_us / config.steps;
+    result.imbalance = load_balance::LoadBalanceConfig::calculateImbalance(rankLoads(splits));
+    return result;
+}
+
+// ========== Curves ==========
+
+std::vector<ScalingPoint> ScalingHarness::weakScaling(const ScalingConfig& base, const std::vector<int>& rank_counts) {
+    std::vector<ScalingPoint> points;
+    for (int ranks : rank_counts) {
+        ScalingConfig config = base;
+        config.num_ranks = ranks;
+
+        // Grow the mesh by `ranks`: double one axis at a time, odd factors go to z
+        int* extents[3] = {&config.nx, &config.ny, &config.nz};
+        double scale[3] = {1.0, 1.0, 1.0};
+        int factor = ranks;
+        for (int axis = 0; factor > 1 && factor % 2 == 0; axis = (axis + 1) % 3) {
+            *extents[axis] *= 2;
+            scale[axis] *= 2.0;
+            factor /= 2;
+        }
+        config.nz *= factor;
+        scale[2] *= factor;
+
+        for (int axis = 0; axis < 3; ++axis) config.refine_center[axis] *= scale[axis];
+        config.refine_radius *= std::cbrt(static_cast<double>(ranks));
+
+        ScalingPoint point = toPoint(ScalingHarness(config).run());
+        point.efficiency = points.empty() ? 1.0 : points.front().time_per_step_us / point.time_per_step_us;
+        points.push_back(point);
+    }
+    return points;
+}
+
+std::vector<ScalingPoint> ScalingHarness::strongScaling(const ScalingConfig& base, const std::vector<int>& rank_counts) {
+    std::vector<ScalingPoint> points;
+    for (int ranks : rank_counts) {
+        ScalingConfig config = base;
+        config.num_ranks = ranks;
+
+        ScalingPoint point = toPoint(ScalingHarness(config).run());
+        if (!points.empty()) {
+            const ScalingPoint& first = points.front();
+            point.efficiency = (first.time_per_step_us * first.ranks) / (point.time_per_step_us * point.ranks);
+        }
+        points.push_back(point);
+    }
+    return points;
+}
+
+void ScalingHarness::writeCSV(const std::string& path, const std::vector<ScalingPoint>& points) {
+    std::ofstream out(path);
+    if (!out) {
+        throw std::runtime_error("Cannot write scaling results: " + path);
+    }
+    out << "ranks,cells,time_per_step_us,compute_us,comm_us,reduce_us,imbalance,halo_bytes,efficiency\n";
+    for (const auto& p : points) {
+        out << p.ranks << "," << p.cells << "," << p.time_per_step_us << "," << p.compute_us << ","
+            << p.comm_us << "," << p.reduce_us << "," << p.imbalance << "," << p.halo_bytes << ","
+            << p.efficiency << "\n";
+    }
+}
+
+} // namespace testing
+} // namespace fluidloom
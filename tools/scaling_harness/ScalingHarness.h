@@ -0,0 +1,192 @@
+#pragma once
+
+#include "KernelCostModel.h"
+#include "LoopbackTransport.h"
+#include "fluidloom/halo/PackBufferLayout.h"
+#include "fluidloom/load_balance/LoadBalanceConfig.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace fluidloom {
+namespace testing {
+
+/**
+ * @brief What a partitioner sees: the mesh in Hilbert order and the current split
+ */
+struct PartitionInput {
+    const std::vector<uint64_t>& sorted_keys;     // Hilbert keys, ascending
+    const std::vector<uint32_t>& sorted_weights;  // Work per cell (fine cells it stands for)
+    const std::vector<size_t>& rank_loads;        // Weighted load per rank under current_splits
+    const std::vector<uint64_t>& current_splits;  // N-1 split keys
+    int num_ranks;
+};
+
+// Returns N-1 ascending split keys; rank i owns keys in [split[i-1], split[i])
+using Partitioner = std::function<std::vector<uint64_t>(const PartitionInput&)>;
+
+// LoadBalancer::computeSplitPoints, i.e. what the production balancer does today
+std::vector<uint64_t> loadBalancerPartitioner(const PartitionInput& input);
+
+// Exact weighted prefix split over the sorted keys
+std::vector<uint64_t> weightedPrefixPartitioner(const PartitionInput& input);
+
+/**
+ * @brief Simulated problem and machine
+ *
+ * The mesh is an nx*ny*nz block of cells keyed at the finest Hilbert level.
+ * Cells inside the refinement sphere stand for `refined_weight` fine cells
+ * (8 children, or 16 with time subcycling) and send 4 fine ghosts per face.
+ */
+struct ScalingConfig {
+    int num_ranks = 1;
+
+    int nx = 32, ny = 32, nz = 32;  // Each at most 256
+
+    // Refinement sphere in cell units; radius 0 keeps the mesh uniform
+    double refine_center[3] = {0.0, 0.0, 0.0};
+    double refine_radius = 0.0;
+    uint32_t refined_weight = 8;
+
+    int steps = 20;
+
+    // Fields exchanged per ghost cell; the same layout sizes migrated cell state
+    halo::PackBufferLayout halo_layout = defaultLayout();
+
+    LinkModel link;
+    KernelCostModel costs = KernelCostModel::defaults();
+
+    // Interior collide runs while the halo is in flight
+    bool overlap_communication = true;
+
+    // Global scalar reductions per step (dissemination allreduce)
+    int reductions_per_step = 1;
+
+    load_balance::LoadBalanceConfig balance;
+    bool balance_at_start = true;
+    Partitioner partitioner = loadBalancerPartitioner;
+
+    // D3Q19 distributions, one float per direction
+    static halo::PackBufferLayout defaultLayout();
+
+    // @throws std::invalid_argument on an unusable configuration
+    void validate() const;
+};
+
+struct RankBreakdown {
+    size_t load = 0;            // Weighted cells owned at the end of the run
+    double compute_us = 0.0;    // Kernel time (collide, pack/unpack, restrict)
+    double comm_wait_us = 0.0;  // Blocked on halo arrival
+    double reduce_us = 0.0;     // In global reductions
+    double migrate_us = 0.0;    // Moving cells after rebalancing
+    uint64_t bytes_sent = 0;
+};
+
+struct ScalingResult {
+    int num_ranks = 0;
+    size_t total_load = 0;
+    int steps = 0;
+    double time_per_step_us = 0.0;    // Slowest rank's virtual time / steps
+    float imbalance = 0.0f;           // Final partition, LoadBalanceConfig metric
+    uint64_t halo_bytes_per_step = 0;
+    int rebalances = 0;
+    std::vector<RankBreakdown> ranks;
+
+    // Per-step averages over ranks (compute is the slowest rank's)
+    double computePerStep() const;
+    double commPerStep() const;
+    double reducePerStep() const;
+};
+
+// One point of a scaling curve
+struct ScalingPoint {
+    int ranks = 0;
+    size_t cells = 0;
+    double time_per_step_us = 0.0;
+    double compute_us = 0.0;
+    double comm_us = 0.0;
+    double reduce_us = 0.0;
+    float imbalance = 0.0f;
+    uint64_t halo_bytes = 0;
+    double efficiency = 1.0;
+};
+
+/**
+ * @brief Runs N simulated ranks as threads in one process
+ *
+ * Each rank keeps a virtual clock advanced by the kernel cost model and by
+ * message arrival times from the LoopbackTransport, so a run predicts step
+ * time, its compute/communication breakdown and the effect of partitioning
+ * on a machine that is not available. Rebalancing goes through the
+ * configured partitioner every balance.min_interval_timesteps steps when
+ * LoadBalanceConfig::shouldRebalance says so.
+ */
+class ScalingHarness {
+public:
+    explicit ScalingHarness(const ScalingConfig& config);
+
+    ScalingResult run();
+
+    // Same problem per rank: the base mesh is doubled along x, y, z in turn
+    static std::vector<ScalingPoint> weakScaling(const ScalingConfig& base, const std::vector<int>& rank_counts);
+
+    // Same problem for every rank count
+    static std::vector<ScalingPoint> strongScaling(const ScalingConfig& base, const std::vector<int>& rank_counts);
+
+    static void writeCSV(const std::string& path, const std::vector<ScalingPoint>& points);
+
+private:
+    struct Peer {
+        int rank = -1;
+        size_t send_cells = 0;
+        size_t recv_cells = 0;
+        size_t restrict_cells = 0;  // Received fine ghosts restricted onto coarse cells
+    };
+
+    struct RankPlan {
+        size_t load = 0;
+        size_t boundary_load = 0;
+        std::vector<Peer> peers;
+    };
+
+    struct RankState {
+        double clock_us = 0.0;
+        RankBreakdown breakdown;
+    };
+
+    ScalingConfig config;
+
+    // Mesh, in cell-index order (x fastest)
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> weights;
+    std::vector<uint8_t> refined;
+
+    // Same mesh in Hilbert order
+    std::vector<uint64_t> sorted_keys;
+    std::vector<uint32_t> sorted_weights;
+
+    std::vector<uint64_t> splits;
+    std::vector<int> owners;
+
+    void buildMesh();
+    int ownerOf(uint64_t key) const;
+    std::vector<size_t> rankLoads(const std::vector<uint64_t>& at_splits) const;
+    std::vector<uint64_t> partition(const std::vector<uint64_t>& from_splits) const;
+
+    // Assigns owners for `splits` and derives each rank's halo peers
+    std::vector<RankPlan> buildPlans();
+
+    // [src][dst] weighted cells that moved from `old_owners` to the current owners
+    std::vector<std::vector<size_t>> migrationMatrix(const std::vector<int>& old_owners) const;
+
+    void runChunk(LoopbackTransport& transport, const std::vector<RankPlan>& plans,
+                  const std::vector<std::vector<size_t>>* migration, int steps,
+                  std::vector<RankState>& states) const;
+
+    void runRank(int rank, LoopbackTransport& transport, const std::vector<RankPlan>& plans,
+                 const std::vector<std::vector<size_t>>* migration, int steps, RankState& state) const;
+};
+
+} // namespace testing
+} // namespace fluidloom
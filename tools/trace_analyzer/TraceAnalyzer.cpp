@@ -0,0 +1,537 @@
+#include "TraceAnalyzer.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace fluidloom {
+namespace profiling {
+
+namespace {
+
+// Minimal JSON reader; numbers keep their source text so 64-bit tids survive
+struct JsonValue {
+    enum class Kind { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT } kind = Kind::NUL;
+    std::string text;  // STRING contents or NUMBER literal
+    bool boolean = false;
+    std::vector<JsonValue> items;
+    std::vector<std::pair<std::string, JsonValue>> members;
+
+    const JsonValue* get(const std::string& key) const {
+        for (const auto& [k, v] : members) {
+            if (k == key) return &v;
+        }
+        return nullptr;
+    }
+
+    double number() const { return kind == Kind::NUMBER ? std::strtod(text.c_str(), nullptr) : 0.0; }
+
+    std::string scalar() const {
+        if (kind == Kind::BOOL) return boolean ? "true" : "false";
+        return text;
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& s) : src(s) {}
+
+    JsonValue parseDocument() {
+        JsonValue value = parseValue();
+        skipSpace();
+        if (pos != src.size()) fail("trailing characters");
+        return value;
+    }
+
+private:
+    [[noreturn]] void fail(const std::string& what) const {
+        throw std::runtime_error("Trace JSON parse error at offset " + std::to_string(pos) + ": " + what);
+    }
+
+    void skipSpace() {
+        while (pos < src.size() && (src[pos] == ' ' || src[pos] == '\n' || src[pos] == '\r' || src[pos] == '\t')) ++pos;
+    }
+
+    bool consume(char c) {
+        skipSpace();
+        if (pos < src.size() && src[pos] == c) {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        if (!consume(c)) fail(std::string("expected '") + c + "'");
+    }
+
+    JsonValue parseValue() {
+        skipSpace();
+        if (pos >= src.size()) fail("unexpected end of input");
+
+        JsonValue value;
+        char c = src[pos];
+        if (c == '{') {
+            value.kind = JsonValue::Kind::OBJECT;
+            ++pos;
+            if (consume('}')) return value;
+            do {
+                skipSpace();
+                std::string key = parseString();
+                expect(':');
+                value.members.emplace_back(std::move(key), parseValue());
+            } while (consume(','));
+            expect('}');
+        } else if (c == '[') {
+            value.kind = JsonValue::Kind::ARRAY;
+            ++pos;
+            if (consume(']')) return value;
+            do {
+                value.items.push_back(parseValue());
+            } while (consume(','));
+            expect(']');
+        } else if (c == '"') {
+            value.kind = JsonValue::Kind::STRING;
+            value.text = parseString();
+        } else if (src.compare(pos, 4, "true") == 0 || src.compare(pos, 5, "false") == 0) {
+            value.kind = JsonValue::Kind::BOOL;
+            value.boolean = src[pos] == 't';
+            pos += value.boolean ? 4 : 5;
+        } else if (src.compare(pos, 4, "null") == 0) {
+            pos += 4;
+        } else if (c == '-' || (c >= '0' && c <= '9')) {
+            value.kind = JsonValue::Kind::NUMBER;
+            size_t begin = pos;
+            while (pos < src.size() && std::string("+-0123456789.eE").find(src[pos]) != std::string::npos) ++pos;
+            value.text = src.substr(begin, pos - begin);
+        } else {
+            fail(std::string("unexpected character '") + c + "'");
+        }
+        return value;
+    }
+
+    std::string parseString() {
+        if (pos >= src.size() || src[pos] != '"') fail("expected string");
+        ++pos;
+        std::string out;
+        while (pos < src.size() && src[pos] != '"') {
+            char c = src[pos++];
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos >= src.size()) break;
+            char esc = src[pos++];
+            switch (esc) {
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                case 'r': out += '\r'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u':
+                    // Names are ASCII in practice; keep the escape verbatim otherwise
+                    if (pos + 4 > src.size()) fail("truncated \\u escape");
+                    out += "\\u" + src.substr(pos, 4);
+                    pos += 4;
+                    break;
+                default: out += esc; break;
+            }
+        }
+        if (pos >= src.size()) fail("unterminated string");
+        ++pos;
+        return out;
+    }
+
+    const std::string& src;
+    size_t pos = 0;
+};
+
+using Interval = std::pair<double, double>;
+
+// Sorted, disjoint union of intervals
+std::vector<Interval> merge(std::vector<Interval> intervals) {
+    std::sort(intervals.begin(), intervals.end());
+    std::vector<Interval> merged;
+    for (const auto& iv : intervals) {
+        if (iv.second <= iv.first) continue;
+        if (!merged.empty() && iv.first <= merged.back().second) {
+            merged.back().second = std::max(merged.back().second, iv.second);
+        } else {
+            merged.push_back(iv);
+        }
+    }
+    return merged;
+}
+
+double length(const std::vector<Interval>& merged) {
+    double total = 0.0;
+    for (const auto& iv : merged) total += iv.second - iv.first;
+    return total;
+}
+
+double intersection(const std::vector<Interval>& a, const std::vector<Interval>& b) {
+    double total = 0.0;
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        double lo = std::max(a[i].first, b[j].first);
+        double hi = std::min(a[i].second, b[j].second);
+        if (hi > lo) total += hi - lo;
+        (a[i].second < b[j].second) ? ++i : ++j;
+    }
+    return total;
+}
+
+std::string escape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out += ' ';
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+TraceData TraceData::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Cannot read trace: " + path);
+    }
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    return parse(buffer.str());
+}
+
+TraceData TraceData::parse(const std::string& json) {
+    JsonValue root = JsonParser(json).parseDocument();
+    const JsonValue* events = &root;
+    if (root.kind == JsonValue::Kind::OBJECT) {
+        events = root.get("traceEvents");
+    }
+    if (!events || events->kind != JsonValue::Kind::ARRAY) {
+        throw std::runtime_error("Trace has no event array");
+    }
+
+    TraceData data;
+    std::map<std::string, std::vector<TraceSpan>> open;  // Per lane, innermost last
+
+    for (const auto& event : events->items) {
+        if (event.kind != JsonValue::Kind::OBJECT) continue;
+        const JsonValue* ph = event.get("ph");
+        if (!ph) continue;
+
+        TraceSpan span;
+        if (const auto* v = event.get("name")) span.name = v->scalar();
+        if (const auto* v = event.get("cat")) span.category = v->scalar();
+        if (const auto* v = event.get("pid")) span.pid = static_cast<int>(v->number());
+        if (const auto* v = event.get("tid")) span.tid = v->scalar();
+        if (const auto* v = event.get("ts")) span.start_us = v->number();
+        if (const auto* v = event.get("args")) {
+            for (const auto& [key, value] : v->members) span.args[key] = value.scalar();
+        }
+
+        if (ph->text == "X") {
+            const JsonValue* dur = event.get("dur");
+            span.end_us = span.start_us + (dur ? dur->number() : 0.0);
+            data.spans.push_back(std::move(span));
+        } else if (ph->text == "B") {
+            open[span.lane()].push_back(std::move(span));
+        } else if (ph->text == "E") {
+            auto& stack = open[span.lane()];
+            auto it = std::find_if(stack.rbegin(), stack.rend(),
+                                   [&](const TraceSpan& b) { return b.name == span.name; });
+            if (it == stack.rend()) {
+                ++data.unmatched_events;
+                continue;
+            }
+            TraceSpan closed = std::move(*it);
+            closed.end_us = span.start_us;
+            for (auto& [key, value] : span.args) closed.args.emplace(key, value);
+            stack.erase(std::next(it).base());
+            data.spans.push_back(std::move(closed));
+        }
+    }
+
+    for (const auto& [lane, stack] : open) {
+        data.unmatched_events += stack.size();
+    }
+    return data;
+}
+
+TraceAnalyzer::Kind TraceAnalyzer::classify(const TraceSpan& span) const {
+    if (span.name == m_config.step_name) return Kind::STEP;
+    if (m_config.wait_names.count(span.name) || span.category == "wait") return Kind::WAIT;
+    if (m_config.communication_categories.count(span.category)) return Kind::COMMUNICATION;
+    if (m_config.compute_categories.count(span.category)) return Kind::COMPUTE;
+    return Kind::OTHER;
+}
+
+TraceSummary TraceAnalyzer::analyze(const TraceData& trace) const {
+    TraceSummary summary;
+    summary.unmatched_events = trace.unmatched_events;
+
+    std::vector<const TraceSpan*> steps;
+    std::vector<const TraceSpan*> work;
+    for (const auto& span : trace.spans) {
+        (classify(span) == Kind::STEP ? steps : work).push_back(&span);
+    }
+
+    // Top-level spans per lane: nested events are covered by their parent
+    std::map<std::string, std::vector<const TraceSpan*>> lanes;
+    for (const TraceSpan* span : work) lanes[span->lane()].push_back(span);
+    std::vector<const TraceSpan*> top_level;
+    for (auto& [lane, spans] : lanes) {
+        std::sort(spans.begin(), spans.end(), [](const TraceSpan* a, const TraceSpan* b) {
+            return a->start_us != b->start_us ? a->start_us < b->start_us : a->end_us > b->end_us;
+        });
+        std::vector<const TraceSpan*> outer;
+        for (const TraceSpan* span : spans) {
+            if (outer.empty() || span->start_us >= outer.back()->end_us) {
+                outer.push_back(span);
+            } else if (span->end_us > outer.back()->end_us) {
+                outer.push_back(span);  // Overlaps without nesting; keep both
+            }
+        }
+        spans = outer;
+        top_level.insert(top_level.end(), outer.begin(), outer.end());
+    }
+
+    // Without step markers the whole trace is one step
+    std::vector<Interval> windows;
+    for (const TraceSpan* step : steps) windows.emplace_back(step->start_us, step->end_us);
+    std::sort(windows.begin(), windows.end());
+    if (windows.empty() && !work.empty()) {
+        double lo = work.front()->start_us, hi = work.front()->end_us;
+        for (const TraceSpan* span : work) {
+            lo = std::min(lo, span->start_us);
+            hi = std::max(hi, span->end_us);
+        }
+        windows.emplace_back(lo, hi);
+    }
+
+    std::map<std::string, LaneReport> lane_reports;
+    std::map<int, PeerWaitReport> peers;
+    std::vector<Stall> stalls;
+
+    for (size_t w = 0; w < windows.size(); ++w) {
+        const double lo = windows[w].first, hi = windows[w].second;
+        StepReport step;
+        step.index = w;
+        step.start_us = lo;
+        step.duration_us = hi - lo;
+
+        std::vector<Interval> compute, comm;
+        for (const TraceSpan* span : work) {
+            double s = std::max(span->start_us, lo), e = std::min(span->end_us, hi);
+            if (e <= s) continue;
+            Kind kind = classify(*span);
+            if (kind == Kind::COMPUTE) compute.emplace_back(s, e);
+            if (kind == Kind::COMMUNICATION || kind == Kind::WAIT) comm.emplace_back(s, e);
+        }
+        auto compute_union = merge(std::move(compute));
+        auto comm_union = merge(std::move(comm));
+        step.compute_us = length(compute_union);
+        step.communication_us = length(comm_union);
+        step.overlap_us = intersection(compute_union, comm_union);
+        step.overlap_ratio = step.communication_us > 0.0 ? step.overlap_us / step.communication_us : 1.0;
+
+        // Critical path by last arrival over the step's top-level spans
+        std::vector<const TraceSpan*> in_step;
+        for (const TraceSpan* span : top_level) {
+            if (span->end_us > lo && span->start_us < hi) in_step.push_back(span);
+        }
+        std::sort(in_step.begin(), in_step.end(), [](const TraceSpan* a, const TraceSpan* b) {
+            return a->end_us != b->end_us ? a->end_us < b->end_us : a->start_us > b->start_us;
+        });
+        std::vector<CriticalPathEntry> path;
+        size_t current = in_step.size();
+        while (current > 0) {
+            const TraceSpan* span = in_step[current - 1];
+            double s = std::max(span->start_us, lo), e = std::min(span->end_us, hi);
+            path.push_back({span->name, span->category, span->lane(), e - s});
+            step.critical_path_us += e - s;
+            // Latest-ending span that finished before this one started
+            auto it = std::upper_bound(in_step.begin(), in_step.begin() + (current - 1), span->start_us,
+                                       [](double t, const TraceSpan* other) { return t < other->end_us; });
+            current = static_cast<size_t>(it - in_step.begin());
+        }
+        std::reverse(path.begin(), path.end());
+        step.critical_path = std::move(path);
+
+        // Idle gaps between a lane's consecutive top-level spans within the step
+        for (const auto& [lane, spans] : lanes) {
+            LaneReport& report = lane_reports[lane];
+            report.lane = lane;
+            const TraceSpan* prev = nullptr;
+            for (const TraceSpan* span : spans) {
+                double s = std::max(span->start_us, lo), e = std::min(span->end_us, hi);
+                if (e <= s) continue;
+                report.busy_us += e - s;
+                if (prev) {
+                    double gap_start = std::min(std::max(prev->end_us, lo), hi);
+                    double gap = s - gap_start;
+                    if (gap >= m_config.min_gap_us) {
+                        report.idle_us += gap;
+                        report.gaps++;
+                        report.max_gap_us = std::max(report.max_gap_us, gap);
+                        stalls.push_back({"idle", prev->name + " -> " + span->name, lane, -1, gap_start, gap});
+                    }
+                }
+                if (!prev || span->end_us > prev->end_us) prev = span;
+            }
+        }
+
+        summary.compute_us += step.compute_us;
+        summary.communication_us += step.communication_us;
+        summary.overlap_us += step.overlap_us;
+        summary.total_us += step.duration_us;
+        summary.steps.push_back(std::move(step));
+    }
+    summary.overlap_ratio = summary.communication_us > 0.0 ? summary.overlap_us / summary.communication_us : 1.0;
+
+    for (const TraceSpan* span : work) {
+        if (classify(*span) != Kind::WAIT) continue;
+        int peer = -1;
+        auto it = span->args.find("peer");
+        if (it != span->args.end()) peer = std::atoi(it->second.c_str());
+
+        PeerWaitReport& report = peers[peer];
+        report.peer = peer;
+        report.wait_us += span->duration();
+        report.count++;
+        report.max_us = std::max(report.max_us, span->duration());
+        stalls.push_back({"wait", span->name, span->lane(), peer, span->start_us, span->duration()});
+    }
+
+    for (auto& [lane, report] : lane_reports) summary.lanes.push_back(report);
+    for (auto& [peer, report] : peers) summary.halo_wait.push_back(report);
+    std::sort(summary.halo_wait.begin(), summary.halo_wait.end(),
+              [](const PeerWaitReport& a, const PeerWaitReport& b) { return a.wait_us > b.wait_us; });
+
+    std::sort(stalls.begin(), stalls.end(), [](const Stall& a, const Stall& b) {
+        return a.duration_us != b.duration_us ? a.duration_us > b.duration_us : a.start_us < b.start_us;
+    });
+    if (stalls.size() > m_config.top_n) stalls.resize(m_config.top_n);
+    summary.stalls = std::move(stalls);
+    return summary;
+}
+
+std::string TraceSummary::toJSON() const {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    out << "{\n";
+    out << "  \"steps\": " << steps.size() << ",\n";
+    out << "  \"total_us\": " << total_us << ",\n";
+    out << "  \"compute_us\": " << compute_us << ",\n";
+    out << "  \"communication_us\": " << communication_us << ",\n";
+    out << "  \"overlap_us\": " << overlap_us << ",\n";
+    out << "  \"overlap_ratio\": " << overlap_ratio << ",\n";
+    out << "  \"unmatched_events\": " << unmatched_events << ",\n";
+
+    out << "  \"per_step\": [";
+    for (size_t i = 0; i < steps.size(); ++i) {
+        const StepReport& s = steps[i];
+        out << (i ? ",\n" : "\n") << "    {\"index\": " << s.index << ", \"start_us\": " << s.start_us
+            << ", \"duration_us\": " << s.duration_us << ", \"critical_path_us\": " << s.critical_path_us
+            << ", \"compute_us\": " << s.compute_us << ", \"communication_us\": " << s.communication_us
+            << ", \"overlap_us\": " << s.overlap_us << ", \"overlap_ratio\": " << s.overlap_ratio
+            << ", \"critical_path\": [";
+        for (size_t k = 0; k < s.critical_path.size(); ++k) {
+            const auto& e = s.critical_path[k];
+            out << (k ? ", " : "") << "{\"name\": \"" << escape(e.name) << "\", \"category\": \""
+                << escape(e.category) << "\", \"lane\": \"" << escape(e.lane) << "\", \"duration_us\": "
+                << e.duration_us << "}";
+        }
+        out << "]}";
+    }
+    out << (steps.empty() ? "],\n" : "\n  ],\n");
+
+    out << "  \"lanes\": [";
+    for (size_t i = 0; i < lanes.size(); ++i) {
+        const LaneReport& l = lanes[i];
+        out << (i ? ",\n" : "\n") << "    {\"lane\": \"" << escape(l.lane) << "\", \"busy_us\": " << l.busy_us
+            << ", \"idle_us\": " << l.idle_us << ", \"gaps\": " << l.gaps << ", \"max_gap_us\": " << l.max_gap_us
+            << "}";
+    }
+    out << (lanes.empty() ? "],\n" : "\n  ],\n");
+
+    out << "  \"halo_wait\": [";
+    for (size_t i = 0; i < halo_wait.size(); ++i) {
+        const PeerWaitReport& p = halo_wait[i];
+        out << (i ? ",\n" : "\n") << "    {\"peer\": " << p.peer << ", \"wait_us\": " << p.wait_us
+            << ", \"count\": " << p.count << ", \"max_us\": " << p.max_us << "}";
+    }
+    out << (halo_wait.empty() ? "],\n" : "\n  ],\n");
+
+    out << "  \"stalls\": [";
+    for (size_t i = 0; i < stalls.size(); ++i) {
+        const Stall& s = stalls[i];
+        out << (i ? ",\n" : "\n") << "    {\"kind\": \"" << s.kind << "\", \"name\": \"" << escape(s.name)
+            << "\", \"lane\": \"" << escape(s.lane) << "\", \"peer\": " << s.peer << ", \"start_us\": "
+            << s.start_us << ", \"duration_us\": " << s.duration_us << "}";
+    }
+    out << (stalls.empty() ? "]\n" : "\n  ]\n");
+    out << "}\n";
+    return out.str();
+}
+
+std::string TraceSummary::toText() const {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+
+    double path_us = 0.0;
+    for (const auto& s : steps) path_us += s.critical_path_us;
+    size_t n = steps.empty() ? 1 : steps.size();
+
+    out << "Steps: " << steps.size() << ", mean " << total_us / n << " us, mean critical path "
+        << path_us / n << " us\n";
+    out << "Compute " << compute_us << " us, communication " << communication_us << " us, overlapped "
+        << overlap_us << " us (" << std::setprecision(1) << 100.0 * overlap_ratio << "% of communication hidden)\n";
+    if (unmatched_events > 0) {
+        out << "Warning: " << unmatched_events << " unmatched begin/end events\n";
+    }
+
+    if (!steps.empty()) {
+        const StepReport& slowest = *std::max_element(steps.begin(), steps.end(),
+            [](const StepReport& a, const StepReport& b) { return a.duration_us < b.duration_us; });
+        out << "\nSlowest step " << slowest.index << " (" << slowest.duration_us << " us), critical path:\n";
+        for (const auto& e : slowest.critical_path) {
+            out << "  " << std::setw(10) << e.duration_us << " us  " << e.name << " [" << e.category << "] on "
+                << e.lane << "\n";
+        }
+    }
+
+    out << "\nLanes:\n";
+    for (const auto& l : lanes) {
+        out << "  " << l.lane << ": busy " << l.busy_us << " us, idle " << l.idle_us << " us in " << l.gaps
+            << " gaps (max " << l.max_gap_us << " us)\n";
+    }
+
+    if (!halo_wait.empty()) {
+        out << "\nHalo wait per peer:\n";
+        for (const auto& p : halo_wait) {
+            out << "  peer " << p.peer << ": " << p.wait_us << " us over " << p.count << " waits (max "
+                << p.max_us << " us)\n";
+        }
+    }
+
+    out << "\nTop stalls:\n";
+    for (const auto& s : stalls) {
+        out << "  " << std::setw(10) << s.duration_us << " us  " << s.kind << "  " << s.name;
+        if (s.peer >= 0) out << " (peer " << s.peer << ")";
+        out << " on " << s.lane << " at " << s.start_us << " us\n";
+    }
+    return out.str();
+}
+
+} // namespace profiling
+} // namespace fluidloom
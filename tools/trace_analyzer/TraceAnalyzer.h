@@ -0,0 +1,147 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace fluidloom {
+namespace profiling {
+
+/**
+ * @brief One timed interval from a Chrome trace ("X" event or matched "B"/"E" pair)
+ */
+struct TraceSpan {
+    std::string name;
+    std::string category;
+    int pid = 0;
+    std::string tid;  // Kept as text: Profiler writes 64-bit thread hashes
+    double start_us = 0.0;
+    double end_us = 0.0;
+    std::map<std::string, std::string> args;
+
+    double duration() const { return end_us - start_us; }
+    std::string lane() const { return std::to_string(pid) + ":" + tid; }
+};
+
+/**
+ * @brief Spans recovered from a trace written by Profiler::flush()
+ *
+ * Accepts the bare event array Profiler writes as well as the
+ * {"traceEvents": [...]} object form. Instant, counter and metadata events
+ * are ignored; "E" events close the innermost open "B" of the same name on
+ * their thread.
+ */
+struct TraceData {
+    std::vector<TraceSpan> spans;
+    size_t unmatched_events = 0;  // "E" without "B", or "B" never closed
+
+    /**
+     * @throws std::runtime_error if the file cannot be read or is not valid JSON
+     */
+    static TraceData load(const std::string& path);
+    static TraceData parse(const std::string& json);
+};
+
+/**
+ * @brief How spans are classified; defaults match the runtime's categories
+ */
+struct AnalyzerConfig {
+    std::string step_name = "step";  // One span per timestep (ExecutionGraph::execute)
+    std::set<std::string> compute_categories{"kernel", "OpenCL", "compute", "adapt", "rebalance"};
+    std::set<std::string> communication_categories{"halo", "comm", "mpi", "transport", "migration"};
+    std::set<std::string> wait_names{"halo_wait"};  // Blocking waits; "peer" arg names the peer
+    size_t top_n = 10;
+    double min_gap_us = 1.0;  // Shorter idle gaps are scheduling noise
+};
+
+struct CriticalPathEntry {
+    std::string name;
+    std::string category;
+    std::string lane;
+    double duration_us = 0.0;
+};
+
+struct StepReport {
+    size_t index = 0;
+    double start_us = 0.0;
+    double duration_us = 0.0;
+    double critical_path_us = 0.0;  // Busy time along the path; the rest of the step is slack
+    std::vector<CriticalPathEntry> critical_path;
+    double compute_us = 0.0;        // Wall time with any compute span active
+    double communication_us = 0.0;  // Wall time with any communication or wait span active
+    double overlap_us = 0.0;        // Wall time with both
+    double overlap_ratio = 1.0;     // overlap / communication; 1 when there is no communication
+};
+
+struct LaneReport {
+    std::string lane;  // "pid:tid": a host thread, or the OpenCL callback thread for device spans
+    double busy_us = 0.0;
+    double idle_us = 0.0;
+    size_t gaps = 0;
+    double max_gap_us = 0.0;
+};
+
+struct PeerWaitReport {
+    int peer = -1;  // -1 when the wait span carries no "peer" arg
+    double wait_us = 0.0;
+    size_t count = 0;
+    double max_us = 0.0;
+};
+
+struct Stall {
+    std::string kind;  // "wait" or "idle"
+    std::string name;  // Wait span name, or "<after> -> <before>" for idle gaps
+    std::string lane;
+    int peer = -1;
+    double start_us = 0.0;
+    double duration_us = 0.0;
+};
+
+/**
+ * @brief Machine-readable result of TraceAnalyzer::analyze()
+ */
+struct TraceSummary {
+    std::vector<StepReport> steps;
+    std::vector<LaneReport> lanes;
+    std::vector<PeerWaitReport> halo_wait;
+    std::vector<Stall> stalls;  // Longest first, at most AnalyzerConfig::top_n
+    size_t unmatched_events = 0;
+
+    double total_us = 0.0;
+    double compute_us = 0.0;
+    double communication_us = 0.0;
+    double overlap_us = 0.0;
+    double overlap_ratio = 1.0;
+
+    std::string toJSON() const;
+    std::string toText() const;
+};
+
+/**
+ * @brief Offline analysis of Profiler traces
+ *
+ * Per step: compute/communication overlap, and a critical path. Traces carry
+ * no dependency edges, so the path is reconstructed by last arrival: starting
+ * from the span that finishes the step, each predecessor is the span (on any
+ * lane) that ended latest before it started. Only top-level spans of each
+ * lane take part, so nested events are not counted twice.
+ *
+ * Across the trace: idle gaps per lane, halo wait time per peer, and the
+ * longest waits and gaps as stalls.
+ */
+class TraceAnalyzer {
+public:
+    explicit TraceAnalyzer(AnalyzerConfig config = {}) : m_config(std::move(config)) {}
+
+    TraceSummary analyze(const TraceData& trace) const;
+
+private:
+    enum class Kind { STEP, COMPUTE, COMMUNICATION, WAIT, OTHER };
+    Kind classify(const TraceSpan& span) const;
+
+    AnalyzerConfig m_config;
+};
+
+} // namespace profiling
+} // namespace fluidloom
@@ -0,0 +1,75 @@
+#include "TraceAnalyzer.h"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace fluidloom::profiling;
+
+void printUsage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " [options] <trace.json>\n";
+    std::cout << "\nSummarizes a Profiler trace: per-step critical path, compute/communication\n";
+    std::cout << "overlap, idle gaps per lane, halo wait per peer and the longest stalls.\n";
+    std::cout << "\nOptions:\n";
+    std::cout << "  --json <file>       Also write the summary as JSON\n";
+    std::cout << "  --top <n>           Number of stalls to report (default: 10)\n";
+    std::cout << "  --step <name>       Name of the per-timestep span (default: step)\n";
+    std::cout << "  --min-gap-us <us>   Ignore idle gaps shorter than this (default: 1)\n";
+    std::cout << "  -h, --help          Show this help message\n";
+    std::cout << "\nExample:\n";
+    std::cout << "  " << program_name << " --json summary.json trace.json\n";
+}
+
+int main(int argc, char** argv) {
+    AnalyzerConfig config;
+    std::string trace_file;
+    std::string json_file;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        }
+        if (arg == "--json" || arg == "--top" || arg == "--step" || arg == "--min-gap-us") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires an argument\n";
+                return 1;
+            }
+            std::string value = argv[++i];
+            if (arg == "--json") json_file = value;
+            else if (arg == "--top") config.top_n = std::strtoul(value.c_str(), nullptr, 10);
+            else if (arg == "--step") config.step_name = value;
+            else config.min_gap_us = std::strtod(value.c_str(), nullptr);
+        } else if (trace_file.empty()) {
+            trace_file = arg;
+        } else {
+            std::cerr << "Error: Unexpected argument: " << arg << "\n";
+            return 1;
+        }
+    }
+
+    if (trace_file.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    try {
+        TraceSummary summary = TraceAnalyzer(config).analyze(TraceData::load(trace_file));
+        std::cout << summary.toText();
+
+        if (!json_file.empty()) {
+            std::ofstream out(json_file);
+            if (!out) {
+                std::cerr << "Error: Cannot write " << json_file << "\n";
+                return 1;
+            }
+            out << summary.toJSON();
+            std::cout << "\nSummary written to " << json_file << "\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}